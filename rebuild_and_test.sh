@@ -25,6 +25,7 @@ echo "==================="
 tests=(
     "test_config"
     "test_core" 
+    "test_allocations"
     "test_market_data"
     "test_trading"
     "test_risk"
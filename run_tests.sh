@@ -8,6 +8,7 @@ tests=(
     "test_market_data"
     "test_config" 
     "test_core"
+    "test_allocations"
     "test_trading"
     "test_risk"
     "test_monitoring"
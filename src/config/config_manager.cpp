@@ -77,7 +77,7 @@ void ConfigManager::load_from_environment() {
             std::string key = var + 9; // Skip "GOLDEARN_" prefix
             std::transform(key.begin(), key.end(), key.begin(), ::tolower);
             env_section->set(key, ConfigValue(std::string(value)));
-            LOG_DEBUG("ConfigManager: Loaded from environment", var);
+            LOG_DEBUG("ConfigManager: Loaded {} from environment", var);
         }
     }
 }
@@ -179,9 +179,13 @@ public:
     }
     
     bool get_bool(const std::string& section, const std::string& key, 
-                 bool default_value = false) {
-        auto sec = get_section(section);
-        return sec->get(key, ConfigValue(default_value)).as_bool();
+                 bool default_value = false) const {
+        std::shared_lock<std::shared_mutex> lock(sections_mutex_);
+        auto it = sections_.find(section);
+        if (it != sections_.end()) {
+            return it->second->get(key, ConfigValue(default_value)).as_bool();
+        }
+        return default_value;
     }
     
     // Set values (dot notation support)
@@ -0,0 +1,396 @@
+#include "flight_recorder.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace goldearn::core {
+
+using namespace flight_recorder;
+
+namespace {
+
+int64_t wall_ns_now() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts); // Async-signal-safe
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t round_up_pow2(uint32_t value) {
+    uint32_t result = 64;
+    while (result < value && result < (1u << 24)) result <<= 1;
+    return result;
+}
+
+// Signal-safe string building (no allocation, no locale)
+size_t append(char* out, size_t pos, size_t size, const char* text) {
+    while (*text && pos + 1 < size) out[pos++] = *text++;
+    out[pos] = '\0';
+    return pos;
+}
+
+size_t append_number(char* out, size_t pos, size_t size, uint64_t value) {
+    char digits[24];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (count && pos + 1 < size) out[pos++] = digits[--count];
+    out[pos] = '\0';
+    return pos;
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+const int FATAL_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+void on_dump_signal(int) {
+    int saved_errno = errno;
+    FlightRecorder::instance().dump("SIGUSR1");
+    errno = saved_errno;
+}
+
+void on_fatal_signal(int signal) {
+    const char* reason = signal == SIGSEGV ? "SIGSEGV" : signal == SIGBUS ? "SIGBUS"
+                       : signal == SIGFPE ? "SIGFPE" : signal == SIGILL ? "SIGILL" : "SIGABRT";
+    FlightRecorder::instance().dump(reason);
+    // SA_RESETHAND restored the default action: die with the original signal
+    ::raise(signal);
+}
+
+} // namespace
+
+FlightRecorder::FlightRecorder()
+    : start_tsc_(utils::log_detail::read_tsc())
+    , start_wall_ns_(wall_ns_now()) {
+    append(dump_directory_, 0, sizeof(dump_directory_), ".");
+    last_dump_path_[0] = '\0';
+}
+
+void FlightRecorder::configure(const std::string& dump_directory, uint32_t ring_events) {
+    std::lock_guard<std::mutex> lock(attach_mutex_);
+    append(dump_directory_, 0, sizeof(dump_directory_), dump_directory.empty() ? "." : dump_directory.c_str());
+    ring_events_ = round_up_pow2(ring_events);
+}
+
+bool FlightRecorder::attach_thread(const std::string& name) {
+    if (tl_ring) {
+        return true;
+    }
+
+    ThreadRing* ring = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(attach_mutex_);
+        uint32_t count = ring_count_.load(std::memory_order_relaxed);
+
+        // A restarted thread continues its own history; otherwise take a new
+        // ring, and only when all are used the ring of another exited thread
+        ThreadRing* exited = nullptr;
+        for (uint32_t i = 0; i < count && !ring; ++i) {
+            ThreadRing* candidate = rings_[i].load(std::memory_order_relaxed);
+            if (candidate->live.load(std::memory_order_relaxed)) continue;
+            if (std::strncmp(candidate->name, name.c_str(), THREAD_NAME_SIZE - 1) == 0) {
+                ring = candidate;
+            } else if (!exited) {
+                exited = candidate;
+            }
+        }
+        if (!ring && count < MAX_THREADS) {
+            size_t bytes = sizeof(ThreadRing) + static_cast<size_t>(ring_events_) * sizeof(Event);
+            void* memory = std::aligned_alloc(alignof(ThreadRing), (bytes + 63) & ~size_t{63});
+            if (!memory) {
+                return false;
+            }
+            std::memset(memory, 0, bytes); // Fault the pages in now, not on the hot path
+            ring = new (memory) ThreadRing();
+            ring->capacity = ring_events_;
+            rings_[count].store(ring, std::memory_order_release);
+            ring_count_.store(count + 1, std::memory_order_release);
+        } else if (!ring && exited) {
+            ring = exited;
+            ring->head.store(0, std::memory_order_relaxed);
+        }
+        if (!ring) {
+            LOG_WARN("FlightRecorder: All {} rings are live; {} is not recorded", MAX_THREADS, name);
+            return false;
+        }
+        append(ring->name, 0, THREAD_NAME_SIZE, name.c_str());
+        ring->thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+        ring->live.store(1, std::memory_order_release);
+    }
+
+    tl_ring = ring;
+    // Release the ring when the thread exits without detaching
+    struct Release {
+        ~Release() { FlightRecorder::instance().detach_thread(); }
+    };
+    thread_local Release release;
+    (void)release;
+    return true;
+}
+
+void FlightRecorder::detach_thread() {
+    if (ThreadRing* ring = tl_ring) {
+        tl_ring = nullptr;
+        ring->live.store(0, std::memory_order_release);
+    }
+}
+
+void FlightRecorder::clear_exited_rings() {
+    std::lock_guard<std::mutex> lock(attach_mutex_);
+    uint32_t count = ring_count_.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        ThreadRing* ring = rings_[i].load(std::memory_order_relaxed);
+        if (ring->live.load(std::memory_order_acquire)) continue;
+        ring->head.store(0, std::memory_order_release);
+        ring->name[0] = '\0';
+        ring->thread_id = 0;
+    }
+}
+
+void FlightRecorder::install_signal_handlers() {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+
+    action.sa_handler = on_dump_signal;
+    action.sa_flags = SA_RESTART;
+    ::sigaction(SIGUSR1, &action, nullptr);
+
+    action.sa_handler = on_fatal_signal;
+    action.sa_flags = SA_RESETHAND | SA_NODEFER;
+    for (int signal : FATAL_SIGNALS) {
+        ::sigaction(signal, &action, nullptr);
+    }
+    LOG_INFO("FlightRecorder: Dumping to {} on SIGUSR1, circuit breaker and fatal signals", dump_directory_);
+}
+
+int FlightRecorder::open_dump_file(char* path, size_t path_size) {
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        size_t pos = append(path, 0, path_size, dump_directory_);
+        pos = append(path, pos, path_size, "/flight-");
+        pos = append_number(path, pos, path_size, static_cast<uint64_t>(::getpid()));
+        pos = append(path, pos, path_size, "-");
+        pos = append_number(path, pos, path_size, dumps_written_.load(std::memory_order_relaxed) + attempt);
+        append(path, pos, path_size, ".bin");
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd >= 0 || errno != EEXIST) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+bool FlightRecorder::dump(const char* reason) {
+    // One dump at a time; a fatal signal raised while dumping gives up on the dump
+    if (dumping_.test_and_set(std::memory_order_acquire)) {
+        return false;
+    }
+
+    char path[sizeof(last_dump_path_)];
+    int fd = open_dump_file(path, sizeof(path));
+    if (fd < 0) {
+        dumping_.clear(std::memory_order_release);
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.event_size = sizeof(Event);
+    header.ring_count = ring_count_.load(std::memory_order_acquire);
+    header.pid = static_cast<int32_t>(::getpid());
+    header.start_tsc = start_tsc_;
+    header.start_wall_ns = start_wall_ns_;
+    header.dump_tsc = utils::log_detail::read_tsc();
+    header.dump_wall_ns = wall_ns_now();
+    append(header.reason, 0, REASON_SIZE, reason);
+    bool ok = write_all(fd, &header, sizeof(header));
+
+    for (uint32_t i = 0; i < header.ring_count && ok; ++i) {
+        const ThreadRing* ring = rings_[i].load(std::memory_order_acquire);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        // A live thread keeps recording while we copy; leave it a margin so
+        // the oldest events written are not overwritten mid-copy
+        uint64_t keep = ring->capacity;
+        if (ring->live.load(std::memory_order_relaxed) && ring != tl_ring) {
+            keep -= ring->capacity / 8;
+        }
+        uint64_t count = std::min<uint64_t>(head, keep);
+
+        RingHeader ring_header;
+        std::memset(&ring_header, 0, sizeof(ring_header));
+        std::memcpy(ring_header.name, ring->name, THREAD_NAME_SIZE);
+        ring_header.thread_id = ring->thread_id;
+        ring_header.capacity = ring->capacity;
+        ring_header.count = count;
+        ring_header.first_index = head - count;
+        ok = write_all(fd, &ring_header, sizeof(ring_header));
+
+        // Oldest first: up to two contiguous spans of the ring
+        uint64_t mask = ring->capacity - 1;
+        uint64_t first = (head - count) & mask;
+        uint64_t first_span = std::min<uint64_t>(count, ring->capacity - first);
+        if (ok && first_span) ok = write_all(fd, ring->events() + first, first_span * sizeof(Event));
+        if (ok && count > first_span) ok = write_all(fd, ring->events(), (count - first_span) * sizeof(Event));
+    }
+    ::close(fd);
+
+    if (ok) {
+        std::memcpy(last_dump_path_, path, sizeof(path));
+        dumps_written_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        ::unlink(path);
+    }
+    dumping_.clear(std::memory_order_release);
+    return ok;
+}
+
+std::string FlightRecorder::last_dump_path() const {
+    return last_dump_path_;
+}
+
+namespace flight_recorder {
+
+DecodedDump decode_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a flight recorder dump (too small)");
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for " + path + ": " + std::strerror(errno));
+    }
+    const std::byte* base = static_cast<const std::byte*>(mapping);
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.event_size != sizeof(Event)) {
+        ::munmap(mapping, size);
+        throw std::runtime_error(path + " is not a flight recorder dump (bad header)");
+    }
+
+    DecodedDump dump;
+    dump.reason.assign(header.reason, strnlen(header.reason, REASON_SIZE));
+    dump.pid = header.pid;
+    dump.dump_wall_ns = header.dump_wall_ns;
+
+    // Events are placed relative to the dump instant, which is when the
+    // TSC/wall pair is most accurate
+    double ns_per_tick = 0.0;
+    if (header.dump_tsc > header.start_tsc && header.dump_wall_ns - header.start_wall_ns > 1000000) {
+        ns_per_tick = static_cast<double>(header.dump_wall_ns - header.start_wall_ns) /
+                      static_cast<double>(header.dump_tsc - header.start_tsc);
+    }
+
+    size_t offset = sizeof(FileHeader);
+    for (uint32_t i = 0; i < header.ring_count; ++i) {
+        if (offset + sizeof(RingHeader) > size) break;
+        RingHeader ring;
+        std::memcpy(&ring, base + offset, sizeof(ring));
+        offset += sizeof(RingHeader);
+        uint64_t available = (size - offset) / sizeof(Event);
+        uint64_t count = std::min<uint64_t>(ring.count, available);
+        std::string thread(ring.name, strnlen(ring.name, THREAD_NAME_SIZE));
+
+        for (uint64_t n = 0; n < count; ++n) {
+            DecodedEvent decoded;
+            std::memcpy(&decoded.event, base + offset + n * sizeof(Event), sizeof(Event));
+            if (decoded.event.type == EVENT_NONE || decoded.event.type > EVENT_MARKER) continue;
+            int64_t ticks_before_dump = static_cast<int64_t>(header.dump_tsc - decoded.event.tsc);
+            decoded.wall_ns = header.dump_wall_ns - static_cast<int64_t>(static_cast<double>(ticks_before_dump) * ns_per_tick);
+            decoded.thread = thread;
+            decoded.thread_id = ring.thread_id;
+            decoded.index = ring.first_index + n;
+            dump.events.push_back(std::move(decoded));
+        }
+        offset += ring.count * sizeof(Event);
+    }
+    ::munmap(mapping, size);
+
+    std::stable_sort(dump.events.begin(), dump.events.end(),
+                     [](const DecodedEvent& a, const DecodedEvent& b) { return a.event.tsc < b.event.tsc; });
+    return dump;
+}
+
+std::string describe(const Event& event) {
+    char buffer[192];
+    auto price = [](uint64_t bits) { return std::bit_cast<double>(bits); };
+    switch (event.type) {
+        case EVENT_TICK:
+            std::snprintf(buffer, sizeof(buffer), "TICK symbol=%llu price=%.4f qty=%llu",
+                          static_cast<unsigned long long>(event.id), price(event.a),
+                          static_cast<unsigned long long>(event.b));
+            break;
+        case EVENT_TOP_OF_BOOK:
+            std::snprintf(buffer, sizeof(buffer), "TOP symbol=%llu bid=%.4f ask=%.4f",
+                          static_cast<unsigned long long>(event.id), price(event.a), price(event.b));
+            break;
+        case EVENT_STRATEGY_DECISION:
+            std::snprintf(buffer, sizeof(buffer), "DECISION strategy=%u symbol=%llu decision=%u price=%.4f qty=%llu",
+                          event.aux, static_cast<unsigned long long>(event.id), event.code, price(event.a),
+                          static_cast<unsigned long long>(event.b));
+            break;
+        case EVENT_RISK_RESULT:
+            std::snprintf(buffer, sizeof(buffer), "RISK symbol=%llu result=%u latency=%lluns qty=%llu limits=v%u",
+                          static_cast<unsigned long long>(event.id), event.code,
+                          static_cast<unsigned long long>(event.a), static_cast<unsigned long long>(event.b),
+                          event.aux);
+            break;
+        case EVENT_ORDER_SEND:
+            std::snprintf(buffer, sizeof(buffer), "SEND order=%llu side=%u venue=%u price=%.4f qty=%llu",
+                          static_cast<unsigned long long>(event.id), event.code, event.aux, price(event.a),
+                          static_cast<unsigned long long>(event.b));
+            break;
+        case EVENT_ORDER_ACK:
+            std::snprintf(buffer, sizeof(buffer), "ACK order=%llu status=%u exchange_id=%llu",
+                          static_cast<unsigned long long>(event.id), event.code,
+                          static_cast<unsigned long long>(event.a));
+            break;
+        case EVENT_MARKER:
+            std::snprintf(buffer, sizeof(buffer), "MARKER code=%u id=%llu a=%llu b=%llu", event.code,
+                          static_cast<unsigned long long>(event.id), static_cast<unsigned long long>(event.a),
+                          static_cast<unsigned long long>(event.b));
+            break;
+        default:
+            std::snprintf(buffer, sizeof(buffer), "UNKNOWN type=%u", event.type);
+            break;
+    }
+    return buffer;
+}
+
+} // namespace flight_recorder
+
+} // namespace goldearn::core
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../utils/logger.hpp"
+
+namespace goldearn::core {
+
+// Always-on flight recorder: the last N compact binary events of every
+// attached thread (ticks, top-of-book changes, strategy decisions, risk
+// results, order sends and acknowledgements), each stamped with the TSC.
+// Recording is a handful of plain stores into the thread's own ring. On
+// SIGUSR1, a circuit breaker or a fatal signal all rings are written to one
+// file with async-signal-safe calls only; goldearn_flight_decode merges
+// them into a single timeline.
+namespace flight_recorder {
+
+constexpr uint64_t FILE_MAGIC = 0x31434552544c4647ULL; // "GFLTREC1"
+constexpr uint32_t FILE_VERSION = 1;
+constexpr uint32_t MAX_THREADS = 64;
+constexpr uint32_t DEFAULT_RING_EVENTS = 4096;
+constexpr size_t THREAD_NAME_SIZE = 32;
+constexpr size_t REASON_SIZE = 64;
+
+enum EventType : uint16_t {
+    EVENT_NONE = 0,
+    EVENT_TICK = 1,              // id = symbol, a = price bits, b = quantity
+    EVENT_TOP_OF_BOOK = 2,       // id = symbol, a = bid bits, b = ask bits
+    EVENT_STRATEGY_DECISION = 3, // id = symbol, code = decision, aux = strategy, a = price bits, b = quantity
+    EVENT_RISK_RESULT = 4,       // id = symbol, code = RiskCheckResult, aux = limits version, a = latency ns, b = quantity
+    EVENT_ORDER_SEND = 5,        // id = order, code = side, aux = venue, a = price bits, b = quantity
+    EVENT_ORDER_ACK = 6,         // id = order, code = status, a = exchange order id
+    EVENT_MARKER = 7             // code = caller-defined, a and b free-form
+};
+
+struct Event {
+    uint64_t tsc;
+    uint64_t id;
+    uint64_t a;
+    uint64_t b;
+    uint32_t aux;
+    uint16_t type;
+    uint16_t code;
+};
+static_assert(sizeof(Event) == 40, "event layout is shared with the decoder");
+
+// One per attached thread; allocated once and never freed, so the signal
+// handler can walk them. Events follow the header.
+struct alignas(64) ThreadRing {
+    char name[THREAD_NAME_SIZE];
+    uint32_t thread_id;
+    uint32_t capacity;               // Power of two
+    std::atomic<uint32_t> live;
+    alignas(64) std::atomic<uint64_t> head; // Events ever recorded (owner writes)
+
+    Event* events() { return reinterpret_cast<Event*>(this + 1); }
+    const Event* events() const { return reinterpret_cast<const Event*>(this + 1); }
+};
+
+// Dump file: FileHeader, then per ring a RingHeader followed by `count`
+// events oldest first
+struct FileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t event_size;
+    uint32_t ring_count;
+    int32_t pid;
+    uint64_t start_tsc;              // TSC/wall clock pairs for conversion
+    int64_t start_wall_ns;
+    uint64_t dump_tsc;
+    int64_t dump_wall_ns;
+    char reason[REASON_SIZE];
+};
+
+struct RingHeader {
+    char name[THREAD_NAME_SIZE];
+    uint32_t thread_id;
+    uint32_t capacity;
+    uint64_t count;
+    uint64_t first_index;            // Ring position of the first event written
+};
+
+struct DecodedEvent {
+    int64_t wall_ns;
+    std::string thread;
+    uint32_t thread_id;
+    uint64_t index;                  // Position in the thread's event stream
+    Event event;
+};
+
+struct DecodedDump {
+    std::string reason;
+    int32_t pid;
+    int64_t dump_wall_ns;
+    std::vector<DecodedEvent> events; // All threads, ordered by TSC
+};
+
+// Throws std::runtime_error if the file is not a flight recorder dump
+DecodedDump decode_file(const std::string& path);
+
+// Human-readable event (without the timestamp and thread)
+std::string describe(const Event& event);
+
+inline thread_local ThreadRing* tl_ring = nullptr;
+
+} // namespace flight_recorder
+
+class FlightRecorder {
+public:
+    static FlightRecorder& instance() {
+        static FlightRecorder instance;
+        return instance;
+    }
+
+    // Ring size for threads attached from now on (rounded up to a power of
+    // two) and the directory dumps go to
+    void configure(const std::string& dump_directory, uint32_t ring_events);
+
+    // Give the calling thread a ring (reusing the ring of an exited thread
+    // of the same name). Returns false once MAX_THREADS rings are live.
+    bool attach_thread(const std::string& name);
+    void detach_thread();
+    // Forget the history and names of threads that have exited, so a new
+    // thread of the same name starts an empty ring. Rings stay allocated for
+    // the signal path. For tests, which share the process-wide recorder.
+    void clear_exited_rings();
+
+    // SIGUSR1 dumps and continues; SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT dump
+    // and then die with the original signal
+    void install_signal_handlers();
+
+    // Write every ring to <dir>/flight-<pid>-<n>.bin. Async-signal-safe;
+    // concurrent dumps are skipped. Returns false if nothing was written.
+    bool dump(const char* reason);
+
+    // Path of the most recent dump (not for use in signal handlers)
+    std::string last_dump_path() const;
+    uint64_t dumps_written() const { return dumps_written_.load(std::memory_order_relaxed); }
+
+private:
+    FlightRecorder();
+
+    int open_dump_file(char* path, size_t path_size);
+
+    // Directory as a fixed buffer so the signal path never touches std::string
+    char dump_directory_[256];
+    char last_dump_path_[320];
+    uint32_t ring_events_ = flight_recorder::DEFAULT_RING_EVENTS;
+    uint64_t start_tsc_;
+    int64_t start_wall_ns_;
+
+    std::atomic<flight_recorder::ThreadRing*> rings_[flight_recorder::MAX_THREADS] = {};
+    std::atomic<uint32_t> ring_count_{0};
+    std::atomic_flag dumping_ = ATOMIC_FLAG_INIT;
+    std::atomic<uint64_t> dumps_written_{0};
+    std::mutex attach_mutex_;
+};
+
+// Hot-path recording on the calling thread (no-op until it attaches)
+namespace flight {
+
+inline void record(flight_recorder::EventType type, uint16_t code, uint64_t id, uint64_t a, uint64_t b,
+                   uint32_t aux = 0) {
+    using namespace flight_recorder;
+    ThreadRing* ring = tl_ring;
+    if (!ring) return;
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Event& event = ring->events()[head & (ring->capacity - 1)];
+    event.tsc = utils::log_detail::read_tsc();
+    event.id = id;
+    event.a = a;
+    event.b = b;
+    event.aux = aux;
+    event.type = type;
+    event.code = code;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+inline void tick(uint64_t symbol, double price, uint64_t quantity) {
+    record(flight_recorder::EVENT_TICK, 0, symbol, std::bit_cast<uint64_t>(price), quantity);
+}
+
+inline void top_of_book(uint64_t symbol, double bid, double ask) {
+    record(flight_recorder::EVENT_TOP_OF_BOOK, 0, symbol, std::bit_cast<uint64_t>(bid), std::bit_cast<uint64_t>(ask));
+}
+
+inline void strategy_decision(uint32_t strategy, uint64_t symbol, uint16_t decision, double price, uint64_t quantity) {
+    record(flight_recorder::EVENT_STRATEGY_DECISION, decision, symbol, std::bit_cast<uint64_t>(price), quantity,
+           strategy);
+}
+
+inline void risk_result(uint64_t symbol, uint16_t result, uint64_t latency_ns, uint64_t quantity,
+                        uint64_t limits_version = 0) {
+    record(flight_recorder::EVENT_RISK_RESULT, result, symbol, latency_ns, quantity,
+           static_cast<uint32_t>(limits_version));
+}
+
+inline void order_send(uint64_t order_id, uint16_t side, uint32_t venue, double price, uint64_t quantity) {
+    record(flight_recorder::EVENT_ORDER_SEND, side, order_id, std::bit_cast<uint64_t>(price), quantity, venue);
+}
+
+inline void order_ack(uint64_t order_id, uint16_t status, uint64_t exchange_order_id) {
+    record(flight_recorder::EVENT_ORDER_ACK, status, order_id, exchange_order_id, 0);
+}
+
+} // namespace flight
+
+} // namespace goldearn::core
@@ -0,0 +1,320 @@
+#include "jitter_monitor.hpp"
+#include "stats_segment.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace goldearn::core {
+
+namespace {
+
+const uint32_t STAT_HICCUPS =
+    StatsSegment::counter("goldearn_jitter_hiccups_total", "Loop gaps above the jitter threshold");
+const uint32_t STAT_MAX_HICCUP =
+    StatsSegment::gauge("goldearn_jitter_max_hiccup_ns", "Longest loop gap seen", stats_layout::MAX);
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// Voluntary + involuntary context switches of one of our threads
+uint64_t read_context_switches(int tid) {
+    std::ifstream status("/proc/self/task/" + std::to_string(tid) + "/status");
+    std::string line;
+    uint64_t total = 0;
+    while (std::getline(status, line)) {
+        if (line.rfind("voluntary_ctxt_switches:", 0) == 0 || line.rfind("nonvoluntary_ctxt_switches:", 0) == 0) {
+            total += std::stoull(line.substr(line.find(':') + 1));
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+// JitterProbe implementation
+JitterProbe::JitterProbe(const std::string& name, bool dedicated, uint64_t threshold_ticks, double ns_per_tick)
+    : name_(name)
+    , dedicated_(dedicated)
+    , threshold_ticks_(threshold_ticks)
+    , ns_per_tick_(ns_per_tick) {
+}
+
+void JitterProbe::start() {
+    thread_id_.store(static_cast<int>(::syscall(SYS_gettid)), std::memory_order_relaxed);
+    cpu_.store(::sched_getcpu(), std::memory_order_relaxed);
+    last_tsc_ = utils::log_detail::read_tsc();
+    if (start_tsc_.load(std::memory_order_relaxed) == 0) {
+        start_tsc_.store(last_tsc_, std::memory_order_relaxed);
+    }
+    active_.store(true, std::memory_order_release);
+}
+
+void JitterProbe::record_gap(uint64_t gap_ticks) {
+    uint64_t gap_ns = static_cast<uint64_t>(static_cast<double>(gap_ticks) * ns_per_tick_);
+    size_t bucket = gap_ns ? std::min<size_t>(std::bit_width(gap_ns) - 1, HISTOGRAM_BUCKETS - 1) : 0;
+
+    gaps_.store(gaps_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total_gap_ns_.store(total_gap_ns_.load(std::memory_order_relaxed) + gap_ns, std::memory_order_relaxed);
+    buckets_[bucket].store(buckets_[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (gap_ns > max_gap_ns_.load(std::memory_order_relaxed)) {
+        max_gap_ns_.store(gap_ns, std::memory_order_relaxed);
+    }
+    stats::add(STAT_HICCUPS);
+    stats::set_max(STAT_MAX_HICCUP, static_cast<double>(gap_ns));
+
+    // The bookkeeping above is itself time off the loop
+    last_tsc_ = utils::log_detail::read_tsc();
+}
+
+std::vector<InterruptCount> parse_proc_interrupts(const std::string& text, int cpu) {
+    std::vector<InterruptCount> result;
+    std::istringstream lines(text);
+    std::string line;
+
+    // Header: "CPU0 CPU1 ..." (online CPUs only, so map the column)
+    if (!std::getline(lines, line)) return result;
+    std::istringstream header(line);
+    std::string token;
+    int columns = 0;
+    int column = -1;
+    while (header >> token) {
+        if (token == "CPU" + std::to_string(cpu)) column = columns;
+        columns++;
+    }
+    if (column < 0) return result;
+
+    while (std::getline(lines, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string label = line.substr(line.find_first_not_of(' '), colon - line.find_first_not_of(' '));
+        std::istringstream fields(line.substr(colon + 1));
+        uint64_t value = 0;
+        bool found = false;
+        int index = 0;
+        for (; index < columns && fields >> token; ++index) {
+            if (token.find_first_not_of("0123456789") != std::string::npos) break;
+            if (index == column) {
+                value = std::stoull(token);
+                found = true;
+            }
+        }
+        if (!found) continue; // ERR/MIS lines carry a single total
+        if (index < columns) continue;
+
+        std::string description;
+        std::getline(fields, description);
+        size_t begin = description.find_first_not_of(' ');
+        description = begin == std::string::npos ? "" : description.substr(begin);
+        // Collapse runs of spaces from the column layout
+        description.erase(std::unique(description.begin(), description.end(),
+                                      [](char a, char b) { return a == ' ' && b == ' '; }),
+                          description.end());
+        result.push_back({description.empty() ? label : label + " (" + description + ")", value});
+    }
+    return result;
+}
+
+// JitterMonitor implementation
+JitterMonitor::~JitterMonitor() {
+    // The runtime (and its sampler task) may already be gone at exit
+    running_ = false;
+    for (auto& thread : dedicated_threads_) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void JitterMonitor::calibrate() {
+    if (ns_per_tick_ > 0.0) return;
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t tsc_start = utils::log_detail::read_tsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t tsc_end = utils::log_detail::read_tsc();
+    double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start).count();
+    ns_per_tick_ = tsc_end > tsc_start ? elapsed_ns / static_cast<double>(tsc_end - tsc_start) : 1.0;
+    threshold_ticks_ = static_cast<uint64_t>(static_cast<double>(config_.threshold_ns) / ns_per_tick_);
+}
+
+void JitterMonitor::start(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) return;
+    config_ = config;
+    calibrate();
+    threshold_ticks_ = static_cast<uint64_t>(static_cast<double>(config_.threshold_ns) / ns_per_tick_);
+    running_ = true;
+
+    for (int core : config_.cores) {
+        std::string name = "jitter_cpu" + std::to_string(core);
+        probes_.push_back(std::make_unique<JitterProbe>(name, true, threshold_ticks_, ns_per_tick_));
+        correlations_.emplace_back();
+        dedicated_threads_.emplace_back(&JitterMonitor::run_dedicated, this, probes_.back().get(), core);
+    }
+
+    sampler_task_id_ = Runtime::instance().background().schedule_periodic(
+        std::chrono::milliseconds(config_.sample_interval_ms), [this]() { sample_system(); }, "jitter_sampler");
+
+    LOG_INFO("JitterMonitor: Threshold {} ns ({:.3f} GHz TSC), {} dedicated cores",
+             config_.threshold_ns, 1.0 / ns_per_tick_, config_.cores.size());
+}
+
+void JitterMonitor::stop() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) return;
+        threads.swap(dedicated_threads_);
+    }
+    Runtime::instance().cancel(sampler_task_id_);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+JitterProbe* JitterMonitor::create_probe(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    calibrate();
+    // A restarted thread keeps its history
+    for (auto& probe : probes_) {
+        if (probe->name() == name && !probe->dedicated() && !probe->active()) {
+            return probe.get();
+        }
+    }
+    probes_.push_back(std::make_unique<JitterProbe>(name, false, threshold_ticks_, ns_per_tick_));
+    correlations_.emplace_back();
+    return probes_.back().get();
+}
+
+void JitterMonitor::run_dedicated(JitterProbe* probe, int core) {
+    set_current_thread_name(probe->name());
+    if (!pin_current_thread(core)) {
+        LOG_WARN("JitterMonitor: Could not pin {} to core {}; measuring unpinned", probe->name(), core);
+    }
+    StatsSegment::attach_thread(probe->name());
+    probe->start();
+
+    // Calibrated loop: nothing but the probe, checking the stop flag every 4k passes
+    while (running_.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 4096; ++i) {
+            probe->sample();
+        }
+    }
+    probe->stop();
+    StatsSegment::detach_thread();
+}
+
+void JitterMonitor::sample_system() {
+    std::string interrupts_text = read_file("/proc/interrupts");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < probes_.size(); ++i) {
+        JitterProbe& probe = *probes_[i];
+        Correlation& correlation = correlations_[i];
+        if (!probe.active()) {
+            correlation.primed = false;
+            continue;
+        }
+
+        uint64_t gaps = probe.gaps();
+        uint64_t context_switches = read_context_switches(probe.thread_id());
+        std::map<std::string, uint64_t> interrupts;
+        for (auto& line : parse_proc_interrupts(interrupts_text, probe.cpu())) {
+            interrupts.emplace(std::move(line.name), line.count);
+        }
+
+        if (correlation.primed) {
+            uint64_t gap_delta = gaps - correlation.gaps;
+            uint64_t switch_delta = context_switches - correlation.context_switches;
+            uint64_t interrupt_delta = 0;
+            std::vector<std::pair<const std::string*, uint64_t>> fired;
+            for (const auto& [name, count] : interrupts) {
+                auto previous = correlation.interrupts.find(name);
+                if (previous != correlation.interrupts.end() && count > previous->second) {
+                    fired.emplace_back(&name, count - previous->second);
+                    interrupt_delta += count - previous->second;
+                }
+            }
+            correlation.interrupts_total += interrupt_delta;
+            correlation.context_switches_total += switch_delta;
+
+            if (gap_delta > 0) {
+                correlation.gap_intervals++;
+                if (interrupt_delta > 0) correlation.gap_intervals_with_interrupts++;
+                if (switch_delta > 0) correlation.gap_intervals_with_context_switches++;
+                for (const auto& [name, delta] : fired) {
+                    correlation.gap_interrupts[*name] += delta;
+                }
+            }
+        }
+        correlation.primed = true;
+        correlation.gaps = gaps;
+        correlation.context_switches = context_switches;
+        correlation.interrupts = std::move(interrupts);
+    }
+}
+
+JitterMonitor::Report JitterMonitor::report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Report report;
+    report.threshold_ns = config_.threshold_ns;
+    report.tsc_ghz = ns_per_tick_ > 0.0 ? 1.0 / ns_per_tick_ : 0.0;
+
+    uint64_t now = utils::log_detail::read_tsc();
+    for (size_t i = 0; i < probes_.size(); ++i) {
+        const JitterProbe& probe = *probes_[i];
+        const Correlation& correlation = correlations_[i];
+        if (probe.start_tsc() == 0) continue; // Never ran
+
+        ProbeReport out;
+        out.name = probe.name();
+        out.dedicated = probe.dedicated();
+        out.cpu = probe.cpu();
+        uint64_t end = probe.active() ? now : probe.stop_tsc();
+        out.measured_seconds = static_cast<double>(end - probe.start_tsc()) * ns_per_tick_ / 1e9;
+        out.gaps = probe.gaps();
+        out.max_gap_us = static_cast<double>(probe.max_gap_ns()) / 1000.0;
+        out.total_gap_us = static_cast<double>(probe.total_gap_ns()) / 1000.0;
+        for (size_t bucket = 0; bucket < JitterProbe::HISTOGRAM_BUCKETS; ++bucket) {
+            if (uint64_t count = probe.bucket(bucket)) {
+                out.histogram.emplace_back(uint64_t{2} << bucket, count);
+            }
+        }
+        out.interrupts = correlation.interrupts_total;
+        out.context_switches = correlation.context_switches_total;
+        out.gap_intervals = correlation.gap_intervals;
+        out.gap_intervals_with_interrupts = correlation.gap_intervals_with_interrupts;
+        out.gap_intervals_with_context_switches = correlation.gap_intervals_with_context_switches;
+        out.gap_interrupts.assign(correlation.gap_interrupts.begin(), correlation.gap_interrupts.end());
+        std::sort(out.gap_interrupts.begin(), out.gap_interrupts.end(),
+                  [](const auto& a, const auto& b) { return a.second > b.second; });
+        report.probes.push_back(std::move(out));
+    }
+    return report;
+}
+
+void JitterMonitor::log_report() const {
+    auto report = this->report();
+    if (report.probes.empty()) return;
+    LOG_INFO("Jitter (gaps > {} ns):", report.threshold_ns);
+    for (const auto& probe : report.probes) {
+        LOG_INFO("  {} cpu {}: {} gaps in {:.1f}s, max {:.1f}us, lost {:.1f}us, {} IRQs, {} context switches",
+                 probe.name, probe.cpu, probe.gaps, probe.measured_seconds, probe.max_gap_us,
+                 probe.total_gap_us, probe.interrupts, probe.context_switches);
+        if (probe.gap_intervals > 0) {
+            LOG_INFO("    {} intervals with gaps: {} with IRQs, {} with context switches{}{}",
+                     probe.gap_intervals, probe.gap_intervals_with_interrupts,
+                     probe.gap_intervals_with_context_switches,
+                     probe.gap_interrupts.empty() ? "" : "; top IRQ ",
+                     probe.gap_interrupts.empty() ? "" : probe.gap_interrupts.front().first);
+        }
+    }
+}
+
+} // namespace goldearn::core
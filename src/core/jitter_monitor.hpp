@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "thread_pool.hpp"
+#include "../utils/logger.hpp"
+
+namespace goldearn::core {
+
+// OS jitter ("hiccup") detection for isolated cores.
+//
+// A probe reads the TSC on every pass of a tight loop; when two consecutive
+// passes are further apart than the threshold, the CPU was taken away (IRQ,
+// timer tick, SMI, preemption) and the gap goes into a log2 histogram. Probes
+// run either as dedicated spinners pinned to otherwise idle cores, or inside
+// the idle iterations of the critical SpinThreads. A housekeeping task
+// samples /proc/interrupts and each probe's context switches once per
+// interval, so intervals with gaps can be attributed to IRQ lines or to
+// scheduling.
+class JitterProbe {
+public:
+    static constexpr size_t HISTOGRAM_BUCKETS = 40; // Bucket i: gaps in [2^i, 2^(i+1)) ns
+
+    JitterProbe(const std::string& name, bool dedicated, uint64_t threshold_ticks, double ns_per_tick);
+
+    JitterProbe(const JitterProbe&) = delete;
+    JitterProbe& operator=(const JitterProbe&) = delete;
+
+    // Owning thread: bind the probe to the calling thread and start timing
+    void start();
+    void stop() {
+        stop_tsc_.store(utils::log_detail::read_tsc(), std::memory_order_relaxed);
+        active_.store(false, std::memory_order_release);
+    }
+
+    // One loop pass; only a gap above the threshold leaves the fast path
+    void sample() {
+        uint64_t now = utils::log_detail::read_tsc();
+        uint64_t gap = now - last_tsc_;
+        last_tsc_ = now;
+        if (gap > threshold_ticks_) [[unlikely]] {
+            record_gap(gap);
+        }
+    }
+
+    // After real work (a busy poll) the next gap is not jitter
+    void restart() { last_tsc_ = utils::log_detail::read_tsc(); }
+
+    const std::string& name() const { return name_; }
+    bool dedicated() const { return dedicated_; }
+    bool active() const { return active_.load(std::memory_order_acquire); }
+    int cpu() const { return cpu_.load(std::memory_order_relaxed); }
+    int thread_id() const { return thread_id_.load(std::memory_order_relaxed); }
+
+    uint64_t gaps() const { return gaps_.load(std::memory_order_relaxed); }
+    uint64_t max_gap_ns() const { return max_gap_ns_.load(std::memory_order_relaxed); }
+    uint64_t total_gap_ns() const { return total_gap_ns_.load(std::memory_order_relaxed); }
+    uint64_t bucket(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    uint64_t start_tsc() const { return start_tsc_.load(std::memory_order_relaxed); }
+    uint64_t stop_tsc() const { return stop_tsc_.load(std::memory_order_relaxed); }
+
+private:
+    void record_gap(uint64_t gap_ticks);
+
+    std::string name_;
+    bool dedicated_;
+    uint64_t threshold_ticks_;
+    double ns_per_tick_;
+    std::atomic<bool> active_{false};
+    std::atomic<int> cpu_{-1};
+    std::atomic<int> thread_id_{0};
+    std::atomic<uint64_t> start_tsc_{0};
+    std::atomic<uint64_t> stop_tsc_{0};
+
+    // Owning thread only
+    alignas(64) uint64_t last_tsc_ = 0;
+
+    // Single writer (the owning thread), read by reports
+    alignas(64) std::atomic<uint64_t> gaps_{0};
+    std::atomic<uint64_t> max_gap_ns_{0};
+    std::atomic<uint64_t> total_gap_ns_{0};
+    std::atomic<uint64_t> buckets_[HISTOGRAM_BUCKETS] = {};
+};
+
+// Per-CPU counts of every /proc/interrupts line
+struct InterruptCount {
+    std::string name;   // "LOC (Local timer interrupts)", "24 (eth0-TxRx-0)", ...
+    uint64_t count;
+};
+std::vector<InterruptCount> parse_proc_interrupts(const std::string& text, int cpu);
+
+class JitterMonitor {
+public:
+    static JitterMonitor& instance() {
+        static JitterMonitor instance;
+        return instance;
+    }
+
+    struct Config {
+        uint64_t threshold_ns = 2000;        // [runtime] jitter_threshold_ns
+        std::vector<int> cores;              // [runtime] jitter_cores (dedicated spinners)
+        uint32_t sample_interval_ms = 1000;  // /proc sampling for correlation
+    };
+
+    // Calibrates the TSC and starts the dedicated probes and the sampler.
+    // Start it before the critical threads are created: their probes take
+    // the threshold in effect when they are created.
+    void start(const Config& config);
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // Probe for an existing loop (SpinThread idle iterations). The probe
+    // lives as long as the monitor; its owner calls start()/sample().
+    JitterProbe* create_probe(const std::string& name);
+
+    // One correlation pass (normally run by the housekeeping task)
+    void sample_system();
+
+    struct ProbeReport {
+        std::string name;
+        bool dedicated;
+        int cpu;
+        double measured_seconds;
+        uint64_t gaps;
+        double max_gap_us;
+        double total_gap_us;
+        std::vector<std::pair<uint64_t, uint64_t>> histogram; // (bucket upper bound ns, count), non-empty only
+        uint64_t interrupts;                 // On the probe's CPU while sampled
+        uint64_t context_switches;           // Of the probe's thread while sampled
+        uint64_t gap_intervals;              // Sampling intervals that saw gaps
+        uint64_t gap_intervals_with_interrupts;
+        uint64_t gap_intervals_with_context_switches;
+        std::vector<std::pair<std::string, uint64_t>> gap_interrupts; // IRQ lines during gap intervals, busiest first
+    };
+    struct Report {
+        uint64_t threshold_ns;
+        double tsc_ghz;
+        std::vector<ProbeReport> probes;
+    };
+    Report report() const;
+    void log_report() const;
+
+private:
+    JitterMonitor() = default;
+    ~JitterMonitor();
+
+    void calibrate();
+    void run_dedicated(JitterProbe* probe, int core);
+
+    struct Correlation {
+        bool primed = false;
+        uint64_t gaps = 0;
+        uint64_t context_switches = 0;
+        std::map<std::string, uint64_t> interrupts;
+        uint64_t interrupts_total = 0;
+        uint64_t context_switches_total = 0;
+        uint64_t gap_intervals = 0;
+        uint64_t gap_intervals_with_interrupts = 0;
+        uint64_t gap_intervals_with_context_switches = 0;
+        std::map<std::string, uint64_t> gap_interrupts;
+    };
+
+    mutable std::mutex mutex_;
+    Config config_;
+    double ns_per_tick_ = 0.0;
+    uint64_t threshold_ticks_ = 0;
+    std::vector<std::unique_ptr<JitterProbe>> probes_;
+    std::vector<Correlation> correlations_;          // Parallel to probes_
+    std::vector<std::thread> dedicated_threads_;
+    std::atomic<bool> running_{false};
+    TaskId sampler_task_id_ = 0;
+};
+
+} // namespace goldearn::core
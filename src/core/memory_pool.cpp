@@ -0,0 +1,321 @@
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace goldearn::core {
+
+namespace {
+
+// Registry of thread cache ids; ids are returned when a thread exits so the
+// cached blocks in that slot are inherited by the next thread to take it.
+class ThreadSlotRegistry {
+public:
+    static ThreadSlotRegistry& instance() {
+        static ThreadSlotRegistry registry;
+        return registry;
+    }
+
+    size_t acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_ids_.empty()) {
+            size_t id = free_ids_.back();
+            free_ids_.pop_back();
+            return id;
+        }
+        return next_id_ < MAX_THREAD_CACHES ? next_id_++ : MAX_THREAD_CACHES;
+    }
+
+    void release(size_t id) {
+        if (id >= MAX_THREAD_CACHES) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_ids_.push_back(id);
+    }
+
+private:
+    ThreadSlotRegistry() { free_ids_.reserve(MAX_THREAD_CACHES); }
+
+    std::mutex mutex_;
+    std::vector<size_t> free_ids_;
+    size_t next_id_ = 0;
+};
+
+struct ThreadSlot {
+    size_t id;
+    ThreadSlot() : id(ThreadSlotRegistry::instance().acquire()) {}
+    ~ThreadSlot() { ThreadSlotRegistry::instance().release(id); }
+};
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+size_t this_thread_cache_slot() {
+    thread_local ThreadSlot slot;
+    return slot.id;
+}
+
+// FixedBlockPool implementation
+FixedBlockPool::FixedBlockPool(size_t block_size, size_t alignment, size_t initial_blocks,
+                               size_t blocks_per_slab, size_t thread_cache_limit)
+    : block_size_(round_up(std::max(block_size, sizeof(FreeNode)),
+                           std::max(alignment, alignof(FreeNode))))
+    , alignment_(std::max(alignment, alignof(FreeNode)))
+    , blocks_per_slab_(std::max<size_t>(blocks_per_slab, 1))
+    , thread_cache_limit_(std::max<size_t>(thread_cache_limit, 2))
+    , batch_size_(std::max<size_t>(thread_cache_limit / 2, 1))
+    , caches_(std::make_unique<ThreadCache[]>(MAX_THREAD_CACHES)) {
+    slabs_.reserve(64);
+    if (initial_blocks > 0) {
+        std::lock_guard<std::mutex> lock(central_mutex_);
+        add_slab_locked(initial_blocks);
+    }
+}
+
+FixedBlockPool::~FixedBlockPool() {
+    for (void* slab : slabs_) {
+        ::operator delete(slab, std::align_val_t(alignment_));
+    }
+}
+
+void* FixedBlockPool::allocate() {
+    size_t slot = this_thread_cache_slot();
+    if (slot >= MAX_THREAD_CACHES) {
+        return allocate_shared();
+    }
+
+    ThreadCache& cache = caches_[slot];
+    if (!cache.head) {
+        refill(cache);
+    }
+
+    FreeNode* node = cache.head;
+    cache.head = node->next;
+    cache.count--;
+    return node;
+}
+
+void FixedBlockPool::deallocate(void* block) noexcept {
+    if (!block) return;
+
+    FreeNode* node = static_cast<FreeNode*>(block);
+    size_t slot = this_thread_cache_slot();
+    if (slot >= MAX_THREAD_CACHES) {
+        std::lock_guard<std::mutex> lock(central_mutex_);
+        node->next = central_head_;
+        central_head_ = node;
+        central_count_++;
+        return;
+    }
+
+    ThreadCache& cache = caches_[slot];
+    node->next = cache.head;
+    cache.head = node;
+    cache.count++;
+
+    if (cache.count > thread_cache_limit_) {
+        spill(cache, thread_cache_limit_ / 2);
+    }
+}
+
+void FixedBlockPool::reserve(size_t blocks) {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    if (central_count_ < blocks) {
+        add_slab_locked(blocks - central_count_);
+    }
+}
+
+void* FixedBlockPool::allocate_shared() {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    if (!central_head_) {
+        if (!growth_enabled_.load(std::memory_order_relaxed)) {
+            throw std::bad_alloc();
+        }
+        add_slab_locked(blocks_per_slab_);
+    }
+
+    FreeNode* node = central_head_;
+    central_head_ = node->next;
+    central_count_--;
+    return node;
+}
+
+void FixedBlockPool::refill(ThreadCache& cache) {
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    if (central_count_ < batch_size_) {
+        if (!growth_enabled_.load(std::memory_order_relaxed)) {
+            if (!central_head_) throw std::bad_alloc();
+        } else {
+            add_slab_locked(std::max(blocks_per_slab_, batch_size_));
+        }
+    }
+
+    // Detach up to batch_size_ nodes from the shared list in one go
+    FreeNode* first = central_head_;
+    FreeNode* last = first;
+    size_t taken = 1;
+    while (taken < batch_size_ && last->next) {
+        last = last->next;
+        taken++;
+    }
+    central_head_ = last->next;
+    central_count_ -= taken;
+
+    last->next = cache.head;
+    cache.head = first;
+    cache.count += taken;
+}
+
+void FixedBlockPool::spill(ThreadCache& cache, size_t keep) {
+    // Walk to the last node we keep, hand the tail to the shared list
+    FreeNode* last_kept = cache.head;
+    for (size_t i = 1; i < keep; ++i) {
+        last_kept = last_kept->next;
+    }
+    FreeNode* first_spilled = last_kept->next;
+    FreeNode* last_spilled = first_spilled;
+    size_t spilled = 1;
+    while (last_spilled->next) {
+        last_spilled = last_spilled->next;
+        spilled++;
+    }
+    last_kept->next = nullptr;
+    cache.count = keep;
+
+    std::lock_guard<std::mutex> lock(central_mutex_);
+    last_spilled->next = central_head_;
+    central_head_ = first_spilled;
+    central_count_ += spilled;
+}
+
+void FixedBlockPool::add_slab_locked(size_t blocks) {
+    std::byte* slab = static_cast<std::byte*>(
+        ::operator new(blocks * block_size_, std::align_val_t(alignment_)));
+    slabs_.push_back(slab);
+
+    // Thread the new blocks onto the shared list in address order
+    for (size_t i = blocks; i-- > 0;) {
+        FreeNode* node = reinterpret_cast<FreeNode*>(slab + i * block_size_);
+        node->next = central_head_;
+        central_head_ = node;
+    }
+    central_count_ += blocks;
+    total_blocks_.fetch_add(blocks, std::memory_order_relaxed);
+    slab_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// MonotonicArena implementation
+MonotonicArena::MonotonicArena(size_t block_size, size_t initial_blocks)
+    : block_size_(block_size) {
+    blocks_.reserve(16);
+    for (size_t i = 0; i < std::max<size_t>(initial_blocks, 1); ++i) {
+        add_block(block_size_);
+    }
+}
+
+MonotonicArena::~MonotonicArena() {
+    for (const auto& block : blocks_) {
+        ::operator delete(block.data, std::align_val_t(CACHE_LINE_SIZE));
+    }
+}
+
+void* MonotonicArena::allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        Block& block = blocks_[current_block_];
+        // Align the address, not the offset: blocks are only 64-byte aligned
+        auto base = reinterpret_cast<uintptr_t>(block.data);
+        size_t aligned = round_up(base + offset_, alignment) - base;
+        if (aligned + bytes <= block.size) {
+            offset_ = aligned + bytes;
+            bytes_used_ += bytes;
+            return block.data + aligned;
+        }
+
+        // Move on to the next retained block, or grow
+        if (current_block_ + 1 == blocks_.size()) {
+            add_block(std::max(block_size_, bytes + alignment));
+        }
+        current_block_++;
+        offset_ = 0;
+    }
+}
+
+void MonotonicArena::reset() {
+    current_block_ = 0;
+    offset_ = 0;
+    bytes_used_ = 0;
+}
+
+void MonotonicArena::add_block(size_t min_size) {
+    std::byte* data = static_cast<std::byte*>(
+        ::operator new(min_size, std::align_val_t(CACHE_LINE_SIZE)));
+    blocks_.push_back(Block{data, min_size});
+    bytes_reserved_ += min_size;
+}
+
+// PoolMemoryResource implementation
+PoolMemoryResource::PoolMemoryResource(size_t initial_blocks_per_class,
+                                       std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        size_t block_size = MIN_BLOCK_SIZE << i;
+        // Smaller slabs for the large classes so an idle resource stays cheap
+        size_t per_slab = std::max<size_t>(16, 65536 / block_size);
+        classes_[i] = std::make_unique<FixedBlockPool>(
+            block_size, std::min(block_size, CACHE_LINE_SIZE), initial_blocks_per_class, per_slab);
+    }
+}
+
+PoolMemoryResource::~PoolMemoryResource() = default;
+
+void PoolMemoryResource::reserve(size_t block_size, size_t blocks) {
+    size_t index = size_class_index(block_size, 1);
+    if (index < NUM_SIZE_CLASSES) {
+        classes_[index]->reserve(blocks);
+    }
+}
+
+size_t PoolMemoryResource::reserved_bytes() const {
+    size_t total = 0;
+    for (const auto& pool : classes_) {
+        total += pool->capacity() * pool->block_size();
+    }
+    return total;
+}
+
+size_t PoolMemoryResource::slab_count() const {
+    size_t total = 0;
+    for (const auto& pool : classes_) {
+        total += pool->slab_count();
+    }
+    return total;
+}
+
+size_t PoolMemoryResource::size_class_index(size_t bytes, size_t alignment) {
+    size_t size = std::max({bytes, alignment, MIN_BLOCK_SIZE});
+    if (size > MAX_BLOCK_SIZE || alignment > CACHE_LINE_SIZE) {
+        return NUM_SIZE_CLASSES;
+    }
+    return std::bit_width(std::bit_ceil(size)) - std::bit_width(MIN_BLOCK_SIZE);
+}
+
+void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    size_t index = size_class_index(bytes, alignment);
+    if (index >= NUM_SIZE_CLASSES) {
+        upstream_allocations_.fetch_add(1, std::memory_order_relaxed);
+        return upstream_->allocate(bytes, alignment);
+    }
+    return classes_[index]->allocate();
+}
+
+void PoolMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    size_t index = size_class_index(bytes, alignment);
+    if (index >= NUM_SIZE_CLASSES) {
+        upstream_->deallocate(p, bytes, alignment);
+        return;
+    }
+    classes_[index]->deallocate(p);
+}
+
+} // namespace goldearn::core
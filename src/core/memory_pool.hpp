@@ -0,0 +1,283 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace goldearn::core {
+
+// Allocation primitives for the trading hot path.
+//
+// Steady-state trading must not touch malloc: every allocator here reserves
+// its memory up front (or grows in large slabs on the slow path) and then
+// recycles blocks without returning them to the system allocator.
+
+static constexpr size_t CACHE_LINE_SIZE = 64;
+static constexpr size_t MAX_THREAD_CACHES = 64; // Threads beyond this use the shared free list
+
+// Small dense id for the calling thread, recycled when the thread exits.
+// Returns MAX_THREAD_CACHES if all ids are taken.
+size_t this_thread_cache_slot();
+
+// Fixed-size block pool with per-thread free lists.
+//
+// Allocation pops from the calling thread's cache; when empty it refills a
+// batch from the shared free list (taking a mutex), and only grows by a new
+// slab when the shared list is empty too. Frees push to the caller's cache and
+// spill half of it back to the shared list once it exceeds the cache limit.
+class FixedBlockPool {
+public:
+    FixedBlockPool(size_t block_size, size_t alignment = alignof(std::max_align_t),
+                   size_t initial_blocks = 1024, size_t blocks_per_slab = 1024,
+                   size_t thread_cache_limit = 64);
+    ~FixedBlockPool();
+
+    FixedBlockPool(const FixedBlockPool&) = delete;
+    FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+
+    void* allocate();
+    void deallocate(void* block) noexcept;
+
+    // Pre-grow so that at least `blocks` are available without a new slab
+    void reserve(size_t blocks);
+
+    // Disallow growth: allocate() throws std::bad_alloc when exhausted
+    void set_growth_enabled(bool enabled) { growth_enabled_.store(enabled, std::memory_order_relaxed); }
+
+    size_t block_size() const { return block_size_; }
+    size_t capacity() const { return total_blocks_.load(std::memory_order_relaxed); }
+    size_t slab_count() const { return slab_count_.load(std::memory_order_relaxed); }
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) ThreadCache {
+        FreeNode* head = nullptr;
+        size_t count = 0;
+    };
+
+    const size_t block_size_;
+    const size_t alignment_;
+    const size_t blocks_per_slab_;
+    const size_t thread_cache_limit_;
+    const size_t batch_size_;
+
+    std::unique_ptr<ThreadCache[]> caches_;
+
+    std::mutex central_mutex_;
+    FreeNode* central_head_ = nullptr;
+    size_t central_count_ = 0;
+    std::vector<void*> slabs_;
+
+    std::atomic<bool> growth_enabled_{true};
+    std::atomic<size_t> total_blocks_{0};
+    std::atomic<size_t> slab_count_{0};
+
+    void* allocate_shared();
+    void refill(ThreadCache& cache);
+    void spill(ThreadCache& cache, size_t keep);
+    void add_slab_locked(size_t blocks);
+};
+
+// Typed object pool on top of FixedBlockPool
+template<typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t initial_capacity = 1024, size_t objects_per_slab = 1024,
+                        size_t thread_cache_limit = 64)
+        : pool_(sizeof(T), alignof(T), initial_capacity, objects_per_slab, thread_cache_limit) {}
+
+    template<typename... Args>
+    T* construct(Args&&... args) {
+        void* block = pool_.allocate();
+        try {
+            return ::new (block) T(std::forward<Args>(args)...);
+        } catch (...) {
+            pool_.deallocate(block);
+            throw;
+        }
+    }
+
+    void destroy(T* object) noexcept {
+        if (!object) return;
+        object->~T();
+        pool_.deallocate(object);
+    }
+
+    // unique_ptr-style ownership that returns the object to this pool
+    struct Deleter {
+        ObjectPool* pool = nullptr;
+        void operator()(T* object) const noexcept {
+            if (pool) pool->destroy(object);
+        }
+    };
+    using Ptr = std::unique_ptr<T, Deleter>;
+
+    template<typename... Args>
+    Ptr make(Args&&... args) {
+        return Ptr(construct(std::forward<Args>(args)...), Deleter{this});
+    }
+
+    void reserve(size_t objects) { pool_.reserve(objects); }
+    void set_growth_enabled(bool enabled) { pool_.set_growth_enabled(enabled); }
+    size_t capacity() const { return pool_.capacity(); }
+    size_t slab_count() const { return pool_.slab_count(); }
+
+private:
+    FixedBlockPool pool_;
+};
+
+template<typename T>
+using PoolPtr = typename ObjectPool<T>::Ptr;
+
+// Bump allocator for objects that live for a whole trading session
+// (symbol tables, strategy setup, per-session scratch). Individual frees are
+// no-ops; reset() rewinds every block but keeps the memory for the next session.
+// Not thread-safe: use one arena per owning thread.
+class MonotonicArena {
+public:
+    explicit MonotonicArena(size_t block_size = 1 << 20, size_t initial_blocks = 1);
+    ~MonotonicArena();
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // The address itself is aligned, so alignments above the 64-byte block
+    // alignment are honored too
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Rewind to the first block; retained blocks are reused in order
+    void reset();
+
+    size_t bytes_used() const { return bytes_used_; }
+    // Includes the blocks grown for oversized requests
+    size_t bytes_reserved() const { return bytes_reserved_; }
+
+private:
+    struct Block {
+        std::byte* data;
+        size_t size;
+    };
+
+    const size_t block_size_;
+    std::vector<Block> blocks_;
+    size_t current_block_ = 0;
+    size_t offset_ = 0;
+    size_t bytes_used_ = 0;
+    size_t bytes_reserved_ = 0;
+
+    void add_block(size_t min_size);
+};
+
+// pmr adaptor over a MonotonicArena (deallocate is a no-op)
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(MonotonicArena& arena) : arena_(arena) {}
+
+private:
+    MonotonicArena& arena_;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return arena_.allocate(bytes, alignment);
+    }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+namespace pool_detail {
+
+// Remembers the size of the first allocation after clear(), forwarding
+// everything to new/delete
+class FirstAllocationProbe : public std::pmr::memory_resource {
+public:
+    void clear() { first_bytes_ = 0; }
+    size_t first_bytes() const { return first_bytes_; }
+
+private:
+    size_t first_bytes_ = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (first_bytes_ == 0) first_bytes_ = bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+} // namespace pool_detail
+
+// Bytes one element of a node-based pmr map costs, as the standard library in
+// use lays out its nodes (the node is built before any rehash it triggers)
+template<typename Map>
+size_t pmr_node_size() {
+    pool_detail::FirstAllocationProbe probe;
+    Map map(&probe);
+    if constexpr (requires { map.reserve(1); }) {
+        map.reserve(1);
+    }
+    probe.clear();
+    map.try_emplace(typename Map::key_type{});
+    return probe.first_bytes();
+}
+
+// Thread-safe pmr resource with power-of-two size classes (16B..4KB), each
+// backed by a FixedBlockPool. Larger requests go to the upstream resource.
+// Use it for node-based containers and growing vectors on the order path.
+// Classes grow in slabs on first use; owners reserve() the classes their
+// containers are known to need, so an idle resource stays small.
+class PoolMemoryResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 16;
+    static constexpr size_t MAX_BLOCK_SIZE = 4096;
+    static constexpr size_t NUM_SIZE_CLASSES = 9; // 16, 32, ..., 4096
+
+    explicit PoolMemoryResource(size_t initial_blocks_per_class = 0,
+                                std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~PoolMemoryResource() override;
+
+    // Pre-grow the size class serving `block_size` bytes
+    void reserve(size_t block_size, size_t blocks);
+    // Pre-grow for `count` elements of a node-based pmr map
+    template<typename Map>
+    void reserve_nodes(size_t count) { reserve(pmr_node_size<Map>(), count); }
+
+    // Bytes held in slabs across all size classes
+    size_t reserved_bytes() const;
+
+    uint64_t upstream_allocations() const { return upstream_allocations_.load(std::memory_order_relaxed); }
+    size_t slab_count() const;
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::unique_ptr<FixedBlockPool> classes_[NUM_SIZE_CLASSES];
+    std::atomic<uint64_t> upstream_allocations_{0};
+
+    static size_t size_class_index(size_t bytes, size_t alignment);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+} // namespace goldearn::core
@@ -0,0 +1,340 @@
+#include "perf_counters.hpp"
+#include "../utils/simple_logger.hpp"
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace goldearn::core {
+
+namespace {
+
+struct EventSpec {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cache_config(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+const EventSpec EVENT_SPECS[PERF_EVENT_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                      PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int open_event(uint32_t type, uint64_t config, int group_fd, bool user_only, uint64_t read_format = 0) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = user_only ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.read_format = read_format;
+    // This thread, any CPU it migrates to
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+// One-time explanation in the log; hot threads all fail the same way
+std::atomic<bool> unavailable_logged{false};
+
+} // namespace
+
+PerfThreadCounters::PerfThreadCounters(const std::string& thread_name)
+    : thread_name_(thread_name) {
+    fds_.fill(-1);
+
+    // Context switches are a software event and work even without a PMU
+    context_switch_fd_ = open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, -1, false);
+    if (context_switch_fd_ < 0) {
+        context_switch_fd_ = open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, -1, true);
+    }
+
+    // Cycles lead the group: without them nothing else is meaningful
+    fds_[PERF_CYCLES] = open_event(EVENT_SPECS[PERF_CYCLES].type, EVENT_SPECS[PERF_CYCLES].config, -1, true,
+                                   PERF_FORMAT_GROUP);
+    if (fds_[PERF_CYCLES] < 0) {
+        unavailable_reason_ = std::string("perf_event_open: ") + std::strerror(errno);
+        return;
+    }
+    group_slot_[PERF_CYCLES] = group_size_++;
+    for (uint32_t event = PERF_INSTRUCTIONS; event < PERF_EVENT_COUNT; ++event) {
+        // Missing events (e.g. no LLC event on this PMU) are left out of the group
+        fds_[event] = open_event(EVENT_SPECS[event].type, EVENT_SPECS[event].config, fds_[PERF_CYCLES], true);
+        if (fds_[event] >= 0) {
+            group_slot_[event] = group_size_++;
+        }
+    }
+
+    mode_ = Mode::SYSCALL;
+#if defined(__x86_64__) || defined(__i386__)
+    // rdpmc needs every event's control page and the kernel's permission
+    long page_size = ::sysconf(_SC_PAGESIZE);
+    bool user_reads = true;
+    for (uint32_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+        if (fds_[event] < 0) continue;
+        void* page = ::mmap(nullptr, static_cast<size_t>(page_size), PROT_READ, MAP_SHARED, fds_[event], 0);
+        if (page == MAP_FAILED) {
+            user_reads = false;
+            break;
+        }
+        pages_[event] = static_cast<perf_event_mmap_page*>(page);
+        user_reads = user_reads && pages_[event]->cap_user_rdpmc;
+    }
+    if (user_reads) {
+        mode_ = Mode::RDPMC;
+    }
+#endif
+}
+
+PerfThreadCounters::~PerfThreadCounters() {
+    close_counters();
+}
+
+void PerfThreadCounters::close_counters() {
+    if (context_switch_fd_ >= 0) {
+        final_context_switches_ = context_switches();
+        ::close(context_switch_fd_);
+        context_switch_fd_ = -1;
+    }
+    long page_size = ::sysconf(_SC_PAGESIZE);
+    for (uint32_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+        if (pages_[event]) {
+            ::munmap(pages_[event], static_cast<size_t>(page_size));
+            pages_[event] = nullptr;
+        }
+    }
+    // Members before the leader
+    for (uint32_t event = PERF_EVENT_COUNT; event-- > 0;) {
+        if (fds_[event] >= 0) {
+            ::close(fds_[event]);
+            fds_[event] = -1;
+        }
+    }
+    mode_ = Mode::UNAVAILABLE;
+}
+
+uint64_t PerfThreadCounters::read_rdpmc(uint32_t event) const {
+#if defined(__x86_64__) || defined(__i386__)
+    // Seqlock protocol from linux/perf_event.h: offset + live PMC value
+    const perf_event_mmap_page* page = pages_[event];
+    uint32_t sequence;
+    uint64_t count;
+    do {
+        sequence = __atomic_load_n(&page->lock, __ATOMIC_ACQUIRE);
+        uint32_t index = __atomic_load_n(&page->index, __ATOMIC_RELAXED);
+        count = __atomic_load_n(&page->offset, __ATOMIC_RELAXED);
+        if (index != 0) {
+            uint32_t shift = 64 - page->pmc_width;
+            int64_t pmc = static_cast<int64_t>(static_cast<uint64_t>(__rdpmc(static_cast<int>(index - 1))) << shift);
+            count += static_cast<uint64_t>(pmc >> shift);
+        }
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&page->lock, __ATOMIC_ACQUIRE) != sequence);
+    return count;
+#else
+    (void)event;
+    return 0;
+#endif
+}
+
+void PerfThreadCounters::read_group(uint64_t (&values)[PERF_EVENT_COUNT]) const {
+    uint64_t buffer[1 + PERF_EVENT_COUNT] = {};
+    ssize_t bytes = ::read(fds_[PERF_CYCLES], buffer, sizeof(buffer));
+    for (uint32_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+        values[event] = bytes > 0 && fds_[event] >= 0 && group_slot_[event] < buffer[0]
+            ? buffer[1 + group_slot_[event]] : 0;
+    }
+}
+
+void PerfThreadCounters::read(uint64_t (&values)[PERF_EVENT_COUNT]) const {
+    if (mode_ == Mode::RDPMC) {
+        for (uint32_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+            values[event] = pages_[event] ? read_rdpmc(event) : 0;
+        }
+    } else if (mode_ == Mode::SYSCALL) {
+        read_group(values);
+    } else {
+        std::memset(values, 0, sizeof(values));
+    }
+}
+
+void PerfThreadCounters::accumulate(uint32_t region, const uint64_t (&start)[PERF_EVENT_COUNT],
+                                    const uint64_t (&end)[PERF_EVENT_COUNT]) {
+    Accumulator& totals = regions_[region < perf_region::MAX_REGIONS ? region : perf_region::MAX_REGIONS - 1];
+    totals.samples.store(totals.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    for (uint32_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+        totals.counts[event].store(totals.counts[event].load(std::memory_order_relaxed) + (end[event] - start[event]),
+                                   std::memory_order_relaxed);
+    }
+}
+
+PerfThreadCounters::RegionTotals PerfThreadCounters::region_totals(uint32_t region) const {
+    RegionTotals totals{};
+    const Accumulator& accumulator = regions_[region];
+    totals.samples = accumulator.samples.load(std::memory_order_relaxed);
+    for (uint32_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+        totals.counts[event] = accumulator.counts[event].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+uint64_t PerfThreadCounters::context_switches() const {
+    if (context_switch_fd_ < 0) {
+        return final_context_switches_;
+    }
+    uint64_t value = 0;
+    if (::read(context_switch_fd_, &value, sizeof(value)) != sizeof(value)) {
+        return final_context_switches_;
+    }
+    return value;
+}
+
+void PerfThreadCounters::reset() {
+    for (auto& totals : regions_) {
+        totals.samples.store(0, std::memory_order_relaxed);
+        for (auto& count : totals.counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// PerfCounters implementation
+PerfCounters::PerfCounters() {
+    region_names_[perf_region::BOOK_UPDATE] = "book_update";
+    region_names_[perf_region::RISK_CHECK] = "risk_check";
+    region_names_[perf_region::STRATEGY_CALLBACK] = "strategy_callback";
+    region_count_ = 3;
+}
+
+bool PerfCounters::register_thread(const std::string& name) {
+    if (registered_) {
+        return current_ != nullptr;
+    }
+
+    auto counters = std::make_unique<PerfThreadCounters>(name);
+    PerfThreadCounters* raw = counters.get();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::move(counters));
+    }
+    registered_ = raw;
+    current_ = raw->mode() != PerfThreadCounters::Mode::UNAVAILABLE ? raw : nullptr;
+
+    // Give the counters back if the thread exits without unregistering
+    struct Release {
+        ~Release() { PerfCounters::instance().unregister_thread(); }
+    };
+    thread_local Release release;
+    (void)release;
+
+    if (!current_) {
+        if (!unavailable_logged.exchange(true)) {
+            LOG_WARN("PerfCounters: hardware counters unavailable for {} ({}); regions will not be measured",
+                     name, raw->unavailable_reason());
+        }
+        return false;
+    }
+    LOG_INFO("PerfCounters: {} counting with {}", name,
+             raw->mode() == PerfThreadCounters::Mode::RDPMC ? "rdpmc" : "read(2)");
+    return true;
+}
+
+void PerfCounters::unregister_thread() {
+    if (!registered_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    registered_->close_counters();
+    registered_ = nullptr;
+    current_ = nullptr;
+}
+
+uint32_t PerfCounters::region_id(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t id = 0; id < region_count_; ++id) {
+        if (region_names_[id] == name) {
+            return id;
+        }
+    }
+    if (region_count_ == perf_region::MAX_REGIONS) {
+        return perf_region::MAX_REGIONS - 1;
+    }
+    region_names_[region_count_] = name;
+    return region_count_++;
+}
+
+PerfCounters::Report PerfCounters::report() const {
+    Report report;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& thread : threads_) {
+        report.threads.push_back({thread->thread_name(),
+                                  thread->unavailable_reason().empty(),
+                                  thread->mode() == PerfThreadCounters::Mode::RDPMC,
+                                  thread->unavailable_reason(),
+                                  thread->context_switches()});
+
+        for (uint32_t region = 0; region < region_count_; ++region) {
+            auto totals = thread->region_totals(region);
+            if (totals.samples == 0) continue;
+
+            double samples = static_cast<double>(totals.samples);
+            double cycles = static_cast<double>(totals.counts[PERF_CYCLES]);
+            double instructions = static_cast<double>(totals.counts[PERF_INSTRUCTIONS]);
+            double per_kinstr = instructions > 0 ? 1000.0 / instructions : 0.0;
+
+            RegionReport entry;
+            entry.thread = thread->thread_name();
+            entry.region = region_names_[region];
+            entry.samples = totals.samples;
+            entry.cycles_per_sample = cycles / samples;
+            entry.instructions_per_sample = instructions / samples;
+            entry.ipc = cycles > 0 ? instructions / cycles : 0.0;
+            entry.l1d_misses_per_kinstr = static_cast<double>(totals.counts[PERF_L1D_MISSES]) * per_kinstr;
+            entry.llc_misses_per_kinstr = static_cast<double>(totals.counts[PERF_LLC_MISSES]) * per_kinstr;
+            entry.branch_misses_per_kinstr = static_cast<double>(totals.counts[PERF_BRANCH_MISSES]) * per_kinstr;
+            report.regions.push_back(std::move(entry));
+        }
+    }
+    return report;
+}
+
+void PerfCounters::log_report() const {
+    auto snapshot = report();
+    for (const auto& thread : snapshot.threads) {
+        if (thread.available) {
+            LOG_INFO("PerfCounters: {} ({}) context switches {}", thread.thread,
+                     thread.user_space_reads ? "rdpmc" : "read(2)", thread.context_switches);
+        } else {
+            LOG_INFO("PerfCounters: {} unavailable ({}), context switches {}", thread.thread,
+                     thread.unavailable_reason, thread.context_switches);
+        }
+    }
+    for (const auto& region : snapshot.regions) {
+        LOG_INFO("PerfCounters: {}/{} n={} cycles={:.0f} instr={:.0f} IPC={:.2f} "
+                 "L1D/ki={:.2f} LLC/ki={:.2f} br-miss/ki={:.2f}",
+                 region.thread, region.region, region.samples, region.cycles_per_sample,
+                 region.instructions_per_sample, region.ipc, region.l1d_misses_per_kinstr,
+                 region.llc_misses_per_kinstr, region.branch_misses_per_kinstr);
+    }
+}
+
+void PerfCounters::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& thread : threads_) {
+        thread->reset();
+    }
+}
+
+} // namespace goldearn::core
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct perf_event_mmap_page;
+
+namespace goldearn::core {
+
+// Hardware performance counters for hot threads (perf_event_open).
+//
+// A registered thread gets one counter group (cycles, instructions, L1D read
+// misses, LLC misses, branch misses) plus a software context-switch counter.
+// PerfRegion reads the group with rdpmc from user space around an
+// instrumented region and accumulates the deltas per (thread, region), so a
+// region costs a few tens of cycles, not a syscall. Where rdpmc is not
+// offered the group is read with read(2); where perf events are not
+// permitted at all (perf_event_paranoid, containers, no PMU in the VM),
+// registration reports why and regions become a TLS load and a branch.
+
+enum PerfEvent : uint32_t {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+// Built-in regions; more can be added with PerfCounters::region_id()
+namespace perf_region {
+    constexpr uint32_t BOOK_UPDATE = 0;
+    constexpr uint32_t RISK_CHECK = 1;
+    constexpr uint32_t STRATEGY_CALLBACK = 2;
+    constexpr uint32_t MAX_REGIONS = 16;
+}
+
+class PerfThreadCounters {
+public:
+    enum class Mode {
+        UNAVAILABLE, // No hardware counters; regions are no-ops
+        SYSCALL,     // Group read with read(2)
+        RDPMC        // User-space reads
+    };
+
+    explicit PerfThreadCounters(const std::string& thread_name);
+    ~PerfThreadCounters();
+
+    PerfThreadCounters(const PerfThreadCounters&) = delete;
+    PerfThreadCounters& operator=(const PerfThreadCounters&) = delete;
+
+    Mode mode() const { return mode_; }
+    const std::string& thread_name() const { return thread_name_; }
+    const std::string& unavailable_reason() const { return unavailable_reason_; }
+    bool has_event(uint32_t event) const { return fds_[event] >= 0; }
+
+    // Current raw counts (owning thread only); absent events read as 0
+    void read(uint64_t (&values)[PERF_EVENT_COUNT]) const;
+
+    // Owning thread: fold one region execution into the totals
+    void accumulate(uint32_t region, const uint64_t (&start)[PERF_EVENT_COUNT],
+                    const uint64_t (&end)[PERF_EVENT_COUNT]);
+
+    struct RegionTotals {
+        uint64_t samples;
+        uint64_t counts[PERF_EVENT_COUNT];
+    };
+    RegionTotals region_totals(uint32_t region) const;
+    uint64_t context_switches() const;
+
+    // Release the kernel counters; totals stay readable
+    void close_counters();
+    void reset();
+
+private:
+    uint64_t read_rdpmc(uint32_t event) const;
+    void read_group(uint64_t (&values)[PERF_EVENT_COUNT]) const;
+
+    std::string thread_name_;
+    Mode mode_ = Mode::UNAVAILABLE;
+    std::string unavailable_reason_;
+    std::array<int, PERF_EVENT_COUNT> fds_;
+    std::array<perf_event_mmap_page*, PERF_EVENT_COUNT> pages_{};
+    std::array<uint32_t, PERF_EVENT_COUNT> group_slot_{}; // Position in a PERF_FORMAT_GROUP read
+    uint32_t group_size_ = 0;
+    int context_switch_fd_ = -1;
+    uint64_t final_context_switches_ = 0;
+
+    // Single writer (the owning thread): plain load/store, readable anytime
+    struct alignas(64) Accumulator {
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> counts[PERF_EVENT_COUNT] = {};
+    };
+    std::array<Accumulator, perf_region::MAX_REGIONS> regions_;
+};
+
+class PerfCounters {
+public:
+    static PerfCounters& instance() {
+        static PerfCounters instance;
+        return instance;
+    }
+
+    // Open counters for the calling thread. Returns false when hardware
+    // counters are unavailable; the thread is still listed in reports with
+    // the reason, and its regions cost nothing.
+    bool register_thread(const std::string& name);
+    void unregister_thread();
+
+    // Id for a named region (registered on first use); MAX_REGIONS - 1 is
+    // returned for every name once the table is full
+    uint32_t region_id(const std::string& name);
+
+    struct RegionReport {
+        std::string thread;
+        std::string region;
+        uint64_t samples;
+        double cycles_per_sample;
+        double instructions_per_sample;
+        double ipc;
+        double l1d_misses_per_kinstr;
+        double llc_misses_per_kinstr;
+        double branch_misses_per_kinstr;
+    };
+    struct ThreadReport {
+        std::string thread;
+        bool available;
+        bool user_space_reads;
+        std::string unavailable_reason;
+        uint64_t context_switches;
+    };
+    struct Report {
+        std::vector<ThreadReport> threads;
+        std::vector<RegionReport> regions; // Regions with at least one sample
+    };
+    Report report() const;
+    void log_report() const;
+    void reset();
+
+    // Calling thread's counters (nullptr if not registered or unavailable)
+    static PerfThreadCounters* current() { return current_; }
+
+private:
+    PerfCounters();
+
+    static inline thread_local PerfThreadCounters* current_ = nullptr;
+    static inline thread_local PerfThreadCounters* registered_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<PerfThreadCounters>> threads_;
+    std::array<std::string, perf_region::MAX_REGIONS> region_names_;
+    uint32_t region_count_ = 0;
+};
+
+// Scoped measurement of one region on the calling thread
+class PerfRegion {
+public:
+    explicit PerfRegion(uint32_t region) : counters_(PerfCounters::current()), region_(region) {
+        if (counters_) counters_->read(start_);
+    }
+    ~PerfRegion() {
+        if (counters_) {
+            uint64_t end[PERF_EVENT_COUNT];
+            counters_->read(end);
+            counters_->accumulate(region_, start_, end);
+        }
+    }
+
+    PerfRegion(const PerfRegion&) = delete;
+    PerfRegion& operator=(const PerfRegion&) = delete;
+
+private:
+    PerfThreadCounters* counters_;
+    uint32_t region_;
+    uint64_t start_[PERF_EVENT_COUNT];
+};
+
+#define PERF_REGION_CONCAT_INNER(a, b) a##b
+#define PERF_REGION_CONCAT(a, b) PERF_REGION_CONCAT_INNER(a, b)
+#define PERF_REGION(region) \
+    goldearn::core::PerfRegion PERF_REGION_CONCAT(perf_region_scope_, __LINE__)(region)
+
+} // namespace goldearn::core
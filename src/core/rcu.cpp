@@ -0,0 +1,108 @@
+#include "rcu.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <limits>
+#include <linux/membarrier.h>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace goldearn::core {
+
+namespace {
+long membarrier(int command) {
+    return ::syscall(__NR_membarrier, command, 0, 0);
+}
+}
+
+Rcu::Rcu() {
+    long supported = membarrier(MEMBARRIER_CMD_QUERY);
+    expedited_ = supported > 0 && (supported & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+                 membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED) == 0;
+    if (!expedited_) {
+        LOG_WARN("Rcu: membarrier unavailable, readers fall back to a full fence");
+    }
+}
+
+Rcu::~Rcu() {
+    // Process exit: nothing reads any more
+    for (auto& retired : retired_) {
+        retired.deleter(retired.object);
+    }
+}
+
+Rcu::ThreadState::~ThreadState() {
+    if (slot) {
+        slot->epoch.store(0, std::memory_order_release);
+        slot->in_use.store(false, std::memory_order_release);
+    }
+}
+
+Rcu::Slot* Rcu::attach() {
+    for (auto& slot : slots_) {
+        bool expected = false;
+        if (!slot.in_use.load(std::memory_order_relaxed) &&
+            slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            thread_state_.slot = &slot;
+            return &slot;
+        }
+    }
+    throw std::runtime_error("Rcu: more than MAX_READERS reader threads");
+}
+
+void Rcu::synchronize_readers() const {
+    // Every running reader executes a full barrier, so a slot store it made
+    // before its pointer load is visible to the scan that follows
+    if (expedited_) {
+        membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED);
+    } else {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void Rcu::retire(void* object, void (*deleter)(void*)) {
+    if (!object) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t epoch = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    retired_.push_back({object, deleter, epoch});
+    reclaim_locked();
+}
+
+size_t Rcu::reclaim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reclaim_locked();
+}
+
+size_t Rcu::reclaim_locked() {
+    if (retired_.empty()) {
+        return 0;
+    }
+    synchronize_readers();
+    uint64_t oldest_reader = std::numeric_limits<uint64_t>::max();
+    for (const auto& slot : slots_) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch != 0) {
+            oldest_reader = std::min(oldest_reader, epoch);
+        }
+    }
+
+    // Readers that entered at or after an object's epoch cannot hold it
+    size_t freed = 0;
+    auto keep = std::partition(retired_.begin(), retired_.end(),
+                               [&](const Retired& retired) { return retired.epoch > oldest_reader; });
+    for (auto it = keep; it != retired_.end(); ++it) {
+        it->deleter(it->object);
+        ++freed;
+    }
+    retired_.erase(keep, retired_.end());
+    return freed;
+}
+
+size_t Rcu::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retired_.size();
+}
+
+} // namespace goldearn::core
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace goldearn::core {
+
+// Read-copy-update for rarely changed, constantly read state (risk limits).
+//
+// Writers build a new immutable object and swap the pointer; the old one is
+// retired and freed once no reader can still hold it. Readers bracket their
+// use with an RcuReadGuard, which is two plain stores to the thread's own
+// slot: the ordering a fence would give is forced from the writer side with
+// membarrier(2), so the read side has no fence, lock or shared-line write.
+// Each retirement bumps the grace-period epoch; a retired object is freed
+// when every reader inside a guard entered it at or after its epoch.
+class Rcu {
+public:
+    static constexpr uint32_t MAX_READERS = 256;
+
+    static Rcu& instance() {
+        static Rcu instance;
+        return instance;
+    }
+
+    // Reader side (RcuReadGuard); nesting is allowed
+    void read_lock() {
+        ThreadState& state = thread_state_;
+        if (state.nesting++ == 0) {
+            Slot* slot = state.slot ? state.slot : attach();
+            slot->epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+            order_reader();
+        }
+    }
+    void read_unlock() {
+        ThreadState& state = thread_state_;
+        if (--state.nesting == 0) {
+            order_reader();
+            state.slot->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    // Writer side: `object` is already unreachable for new readers
+    void retire(void* object, void (*deleter)(void*));
+    // Frees what no reader can see; retire() and the owners' housekeeping call it
+    size_t reclaim();
+    size_t pending() const;
+    bool expedited() const { return expedited_; }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0}; // 0: not reading
+        std::atomic<bool> in_use{false};
+    };
+    struct ThreadState {
+        Slot* slot = nullptr;
+        uint32_t nesting = 0;
+        ~ThreadState();
+    };
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    Rcu();
+    ~Rcu();
+
+    Slot* attach();
+    void order_reader() const {
+        if (expedited_) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+    void synchronize_readers() const;
+    size_t reclaim_locked();
+
+    static thread_local ThreadState thread_state_;
+
+    bool expedited_ = false; // membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) available
+    std::atomic<uint64_t> epoch_{1};
+    Slot slots_[MAX_READERS];
+    mutable std::mutex mutex_;
+    std::vector<Retired> retired_;
+};
+
+inline thread_local Rcu::ThreadState Rcu::thread_state_;
+
+class RcuReadGuard {
+public:
+    RcuReadGuard() { Rcu::instance().read_lock(); }
+    ~RcuReadGuard() { Rcu::instance().read_unlock(); }
+    RcuReadGuard(const RcuReadGuard&) = delete;
+    RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+};
+
+// RCU-published pointer to an immutable T. load() is one acquire load and
+// is valid until the enclosing RcuReadGuard ends.
+template<typename T>
+class RcuPointer {
+public:
+    explicit RcuPointer(std::unique_ptr<T> initial) : pointer_(initial.release()) {}
+    ~RcuPointer() { delete pointer_.load(std::memory_order_relaxed); } // No readers left
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    const T* load() const { return pointer_.load(std::memory_order_acquire); }
+
+    // Writers serialize among themselves (the owner's update mutex)
+    void publish(std::unique_ptr<T> next) {
+        T* previous = pointer_.exchange(next.release(), std::memory_order_acq_rel);
+        Rcu::instance().retire(previous, [](void* object) { delete static_cast<T*>(object); });
+    }
+
+private:
+    std::atomic<T*> pointer_;
+};
+
+} // namespace goldearn::core
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::core {
+
+// Sequence lock for state that is read far more often than written and
+// whose readers must not wait on a lock or write a shared line: the
+// pre-trade check reading sums that fills keep current.
+//
+// Writers are serialized by the owner. A write makes the count odd,
+// rewrites the SeqlockCells it covers and makes it even again; a reader
+// copies the cells and retries when the count was odd or moved under it.
+// Cells are word-sized relaxed atomics, so a racing copy is well defined,
+// only discarded.
+class Seqlock {
+public:
+    class WriteGuard {
+    public:
+        explicit WriteGuard(Seqlock& lock) : lock_(lock) {
+            const uint64_t sequence = lock_.sequence_.load(std::memory_order_relaxed);
+            lock_.sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~WriteGuard() {
+            const uint64_t sequence = lock_.sequence_.load(std::memory_order_relaxed);
+            lock_.sequence_.store(sequence + 1, std::memory_order_release);
+        }
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator=(const WriteGuard&) = delete;
+
+    private:
+        Seqlock& lock_;
+    };
+
+    // Runs `read` (loads of the covered cells) until a run saw no write;
+    // returns what that run returned
+    template<typename Read>
+    auto read(Read&& read) const {
+        while (true) {
+            const uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+#ifdef __x86_64__
+                _mm_pause();
+#endif
+                continue;
+            }
+            auto result = read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return result;
+            }
+        }
+    }
+
+    // read() for a writer that may never finish, such as one in another
+    // process that died mid-write: gives up after `max_attempts` runs and
+    // yields instead of spinning after `spin_attempts`. `attempts` gets the
+    // runs made; false when none of them saw no write.
+    template<typename Read>
+    bool try_read(Read&& read, uint32_t max_attempts, uint32_t spin_attempts, uint32_t& attempts) const {
+        for (attempts = 0; attempts < max_attempts;) {
+            if (attempts++ >= spin_attempts) {
+                std::this_thread::yield();
+            }
+            const uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::atomic<uint64_t> sequence_{0};
+};
+
+// A trivially copyable value under a Seqlock, held as relaxed atomic words.
+// Starts as all-zero bits.
+template<typename T>
+class SeqlockCell {
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(uint64_t) == 0,
+                  "SeqlockCell holds trivially copyable values made of whole words");
+
+public:
+    // Inside a Seqlock::WriteGuard, or before the cell is published
+    void store(const T& value) {
+        uint64_t words[WORDS];
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    // Inside Seqlock::read(), or by the writer
+    T load() const {
+        uint64_t words[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t WORDS = sizeof(T) / sizeof(uint64_t);
+    std::atomic<uint64_t> words_[WORDS] = {};
+};
+
+} // namespace goldearn::core
@@ -0,0 +1,435 @@
+#include "stats_segment.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <signal.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace goldearn::core {
+
+using namespace stats_layout;
+
+namespace {
+
+constexpr size_t CACHE_LINE = 64;
+
+size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::string segment_path(const std::string& name) {
+    return name.find('/') != std::string::npos ? name : "/dev/shm/" + name;
+}
+
+void copy_text(char* out, size_t size, const std::string& text) {
+    size_t length = std::min(text.size(), size - 1);
+    std::memcpy(out, text.data(), length);
+    out[length] = '\0';
+}
+
+struct MetricDefinition {
+    std::string name;
+    std::string help;
+    Kind kind;
+    Aggregation aggregation;
+    uint64_t initial;
+};
+
+// Process-wide metric table and the current segment. Segments are retired,
+// never destroyed, while the process runs (attached threads keep pointers).
+struct Registry {
+    std::mutex mutex;
+    std::vector<MetricDefinition> definitions;
+    StatsSegment* segment = nullptr;
+    std::vector<std::unique_ptr<StatsSegment>> segments;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+thread_local StatsSegment* tl_segment = nullptr;
+thread_local BlockHeader* tl_block = nullptr;
+
+uint64_t initial_bits(Kind kind, Aggregation aggregation) {
+    if (kind == GAUGE && aggregation == MIN) return std::bit_cast<uint64_t>(std::numeric_limits<double>::infinity());
+    if (kind == GAUGE && aggregation == MAX) return std::bit_cast<uint64_t>(-std::numeric_limits<double>::infinity());
+    return kind == GAUGE ? std::bit_cast<uint64_t>(0.0) : 0;
+}
+
+void append_value(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+} // namespace
+
+StatsSegment::StatsSegment(const std::string& name) : path_(segment_path(name)) {
+    size_t descriptors_offset = round_up(sizeof(Header), CACHE_LINE);
+    size_t blocks_offset = round_up(descriptors_offset + MAX_METRICS * sizeof(Descriptor), 4096);
+    size_t block_size = sizeof(BlockHeader) + round_up(MAX_METRICS * sizeof(uint64_t), CACHE_LINE);
+    mapping_size_ = blocks_offset + MAX_THREADS * block_size;
+
+    // Replace, never reuse: readers must not see a half-initialised old layout
+    ::unlink(path_.c_str());
+    int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("StatsSegment: cannot create " + path_ + ": " + std::strerror(errno));
+    }
+    if (::ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+        int error = errno;
+        ::close(fd);
+        ::unlink(path_.c_str());
+        throw std::runtime_error("StatsSegment: cannot size " + path_ + ": " + std::strerror(error));
+    }
+    void* mapping = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::unlink(path_.c_str());
+        throw std::runtime_error("StatsSegment: mmap failed for " + path_ + ": " + std::strerror(errno));
+    }
+    mapping_ = static_cast<std::byte*>(mapping);
+
+    header_ = new (mapping_) Header{};
+    header_->version = VERSION;
+    header_->header_size = sizeof(Header);
+    header_->metric_capacity = MAX_METRICS;
+    header_->thread_capacity = MAX_THREADS;
+    header_->descriptors_offset = descriptors_offset;
+    header_->blocks_offset = blocks_offset;
+    header_->block_size = block_size;
+    header_->pid = ::getpid();
+    header_->created_wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Magic last: a reader that sees it sees a complete header
+    std::atomic_ref<uint64_t>(header_->magic).store(MAGIC, std::memory_order_release);
+}
+
+StatsSegment::~StatsSegment() {
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+    unlink();
+}
+
+// Only once: a later segment may have been created under the same name
+void StatsSegment::unlink() {
+    if (linked_) {
+        ::unlink(path_.c_str());
+        linked_ = false;
+    }
+}
+
+uint64_t* StatsSegment::values(uint32_t block) const {
+    return reinterpret_cast<uint64_t*>(mapping_ + header_->blocks_offset + block * header_->block_size +
+                                       sizeof(BlockHeader));
+}
+
+BlockHeader* StatsSegment::block_header(uint32_t block) const {
+    return reinterpret_cast<BlockHeader*>(mapping_ + header_->blocks_offset + block * header_->block_size);
+}
+
+void StatsSegment::publish(uint32_t id, const std::string& name, const std::string& help, Kind kind,
+                           Aggregation aggregation, uint64_t initial) {
+    auto* descriptor = reinterpret_cast<Descriptor*>(mapping_ + header_->descriptors_offset) + id;
+    copy_text(descriptor->name, NAME_SIZE, name);
+    copy_text(descriptor->help, HELP_SIZE, help);
+    descriptor->initial = initial;
+    descriptor->kind = kind;
+    descriptor->aggregation = aggregation;
+
+    // Blocks claimed before this metric existed start it at its initial value
+    uint32_t threads = header_->thread_count.load(std::memory_order_relaxed);
+    for (uint32_t block = 0; block < threads; ++block) {
+        std::atomic_ref<uint64_t>(values(block)[id]).store(initial, std::memory_order_relaxed);
+    }
+    header_->metric_count.store(id + 1, std::memory_order_release);
+}
+
+// Called with the registry lock held
+uint64_t* StatsSegment::claim_block(const std::string& name) {
+    uint32_t used = header_->thread_count.load(std::memory_order_relaxed);
+    std::string label = name.substr(0, sizeof(BlockHeader::name) - 1);
+
+    // Prefer the exited block of a thread with this name: its counters continue
+    uint32_t chosen = MAX_THREADS;
+    bool reset = true;
+    for (uint32_t block = 0; block < used; ++block) {
+        BlockHeader* header = block_header(block);
+        if (header->state.load(std::memory_order_relaxed) == BLOCK_EXITED && label == header->name) {
+            chosen = block;
+            reset = false;
+            break;
+        }
+    }
+    if (chosen == MAX_THREADS && used < MAX_THREADS) {
+        chosen = used;
+    }
+    if (chosen == MAX_THREADS) {
+        for (uint32_t block = 0; block < used; ++block) {
+            if (block_header(block)->state.load(std::memory_order_relaxed) == BLOCK_EXITED) {
+                chosen = block;
+                break;
+            }
+        }
+    }
+    if (chosen == MAX_THREADS) {
+        return nullptr;
+    }
+
+    BlockHeader* header = block_header(chosen);
+    if (reset) {
+        const auto& definitions = registry().definitions;
+        uint64_t* block_values = values(chosen);
+        for (size_t id = 0; id < definitions.size(); ++id) {
+            std::atomic_ref<uint64_t>(block_values[id]).store(definitions[id].initial, std::memory_order_relaxed);
+        }
+        copy_text(header->name, sizeof(header->name), label);
+    }
+    header->thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+    header->generation.fetch_add(1, std::memory_order_relaxed);
+    header->state.store(BLOCK_LIVE, std::memory_order_release);
+    if (chosen == used) {
+        header_->thread_count.store(used + 1, std::memory_order_release);
+    }
+    return values(chosen);
+}
+
+bool StatsSegment::open(const std::string& name) {
+    std::unique_ptr<StatsSegment> segment;
+    try {
+        segment = std::make_unique<StatsSegment>(name);
+    } catch (const std::exception& e) {
+        LOG_ERROR("StatsSegment: {}", e.what());
+        return false;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (reg.segment && reg.segment->path_ == segment->path_) {
+        reg.segment->linked_ = false; // Its file was just replaced
+    }
+    for (uint32_t id = 0; id < reg.definitions.size(); ++id) {
+        const auto& definition = reg.definitions[id];
+        segment->publish(id, definition.name, definition.help, definition.kind, definition.aggregation,
+                         definition.initial);
+    }
+    reg.segment = segment.get();
+    reg.segments.push_back(std::move(segment));
+    LOG_INFO("StatsSegment: Publishing statistics in {}", reg.segment->path());
+    return true;
+}
+
+void StatsSegment::close() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (reg.segment) {
+        reg.segment->unlink();
+        reg.segment = nullptr;
+    }
+}
+
+StatsSegment* StatsSegment::current() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.segment;
+}
+
+uint32_t StatsSegment::define(const std::string& name, const std::string& help, Kind kind, Aggregation aggregation) {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (uint32_t id = 0; id < reg.definitions.size(); ++id) {
+        if (reg.definitions[id].name == name) {
+            return id;
+        }
+    }
+    if (reg.definitions.size() == MAX_METRICS) {
+        throw std::length_error("StatsSegment: more than " + std::to_string(MAX_METRICS) + " metrics");
+    }
+    uint32_t id = static_cast<uint32_t>(reg.definitions.size());
+    reg.definitions.push_back({name, help, kind, aggregation, initial_bits(kind, aggregation)});
+    if (reg.segment) {
+        reg.segment->publish(id, name, help, kind, aggregation, reg.definitions.back().initial);
+    }
+    return id;
+}
+
+uint32_t StatsSegment::counter(const std::string& name, const std::string& help) {
+    return define(name, help, COUNTER, SUM);
+}
+
+uint32_t StatsSegment::gauge(const std::string& name, const std::string& help, Aggregation aggregation) {
+    return define(name, help, GAUGE, aggregation);
+}
+
+bool StatsSegment::attach_thread(const std::string& name) {
+    auto& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (!reg.segment) {
+            return false;
+        }
+        if (tl_segment == reg.segment) {
+            return true;
+        }
+        stats::tl_values = reg.segment->claim_block(name);
+        if (!stats::tl_values) {
+            LOG_WARN("StatsSegment: No free block for thread {}; its statistics are dropped", name);
+            return false;
+        }
+        tl_segment = reg.segment;
+        tl_block = reinterpret_cast<BlockHeader*>(reinterpret_cast<std::byte*>(stats::tl_values) -
+                                                  sizeof(BlockHeader));
+    }
+
+    // Hand the block back when the thread exits without detaching
+    struct Release {
+        ~Release() { StatsSegment::detach_thread(); }
+    };
+    thread_local Release release;
+    (void)release;
+    return true;
+}
+
+void StatsSegment::detach_thread() {
+    if (!tl_block) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    tl_block->state.store(BLOCK_EXITED, std::memory_order_release);
+    tl_block = nullptr;
+    tl_segment = nullptr;
+    stats::tl_values = nullptr;
+}
+
+// StatsReader implementation
+StatsReader::StatsReader(const std::string& name) : path_(segment_path(name)) {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path_ + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error(path_ + " is too small to be a stats segment");
+    }
+    mapping_size_ = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for " + path_ + ": " + std::strerror(errno));
+    }
+    mapping_ = static_cast<const std::byte*>(mapping);
+    header_ = reinterpret_cast<const Header*>(mapping_);
+
+    uint64_t magic = std::atomic_ref<const uint64_t>(header_->magic).load(std::memory_order_acquire);
+    bool valid = magic == MAGIC && header_->version == VERSION &&
+                 header_->metric_capacity <= MAX_METRICS &&
+                 header_->block_size >= sizeof(BlockHeader) + header_->metric_capacity * sizeof(uint64_t) &&
+                 header_->descriptors_offset + header_->metric_capacity * sizeof(Descriptor) <= mapping_size_ &&
+                 header_->blocks_offset + header_->thread_capacity * header_->block_size <= mapping_size_;
+    if (!valid) {
+        ::munmap(const_cast<std::byte*>(mapping_), mapping_size_);
+        throw std::runtime_error(path_ + " is not a stats segment (bad header)");
+    }
+}
+
+StatsReader::~StatsReader() {
+    ::munmap(const_cast<std::byte*>(mapping_), mapping_size_);
+}
+
+bool StatsReader::writer_alive() const {
+    return ::kill(writer_pid(), 0) == 0 || errno == EPERM;
+}
+
+std::vector<StatsReader::Metric> StatsReader::read() const {
+    uint32_t metric_count = std::min(header_->metric_count.load(std::memory_order_acquire), header_->metric_capacity);
+    uint32_t thread_count = std::min(header_->thread_count.load(std::memory_order_acquire), header_->thread_capacity);
+    const auto* descriptors = reinterpret_cast<const Descriptor*>(mapping_ + header_->descriptors_offset);
+
+    std::vector<Metric> metrics(metric_count);
+    for (uint32_t id = 0; id < metric_count; ++id) {
+        const Descriptor& descriptor = descriptors[id];
+        Metric& metric = metrics[id];
+        metric.name.assign(descriptor.name, strnlen(descriptor.name, NAME_SIZE));
+        metric.help.assign(descriptor.help, strnlen(descriptor.help, HELP_SIZE));
+        metric.kind = static_cast<Kind>(descriptor.kind);
+        metric.aggregation = static_cast<Aggregation>(descriptor.aggregation);
+        metric.total = metric.aggregation == MIN ? std::numeric_limits<double>::infinity()
+                     : metric.aggregation == MAX ? -std::numeric_limits<double>::infinity() : 0.0;
+    }
+
+    for (uint32_t block = 0; block < thread_count; ++block) {
+        const std::byte* base = mapping_ + header_->blocks_offset + block * header_->block_size;
+        const auto* block_header = reinterpret_cast<const BlockHeader*>(base);
+        if (block_header->state.load(std::memory_order_acquire) == BLOCK_FREE) continue;
+        std::string thread(block_header->name, strnlen(block_header->name, sizeof(block_header->name)));
+        const auto* block_values = reinterpret_cast<const uint64_t*>(base + sizeof(BlockHeader));
+
+        for (uint32_t id = 0; id < metric_count; ++id) {
+            Metric& metric = metrics[id];
+            uint64_t bits = std::atomic_ref<const uint64_t>(block_values[id]).load(std::memory_order_relaxed);
+            double value = metric.kind == COUNTER ? static_cast<double>(bits) : std::bit_cast<double>(bits);
+            if (std::isinf(value) && metric.kind == GAUGE) continue; // Never set by this thread
+            metric.threads.emplace_back(thread, value);
+            switch (metric.aggregation) {
+                case MAX: metric.total = std::max(metric.total, value); break;
+                case MIN: metric.total = std::min(metric.total, value); break;
+                default: metric.total += value; break;
+            }
+        }
+    }
+
+    for (auto& metric : metrics) {
+        if (std::isinf(metric.total)) metric.total = 0.0;
+    }
+    return metrics;
+}
+
+std::string StatsReader::to_prometheus(const std::vector<Metric>& metrics, bool per_thread) {
+    std::string out;
+    for (const auto& metric : metrics) {
+        const char* type = metric.kind == COUNTER ? "counter" : "gauge";
+        out += "# HELP ";
+        out += metric.name;
+        out += ' ';
+        out += metric.help;
+        out += "\n# TYPE ";
+        out += metric.name;
+        out += ' ';
+        out += type;
+        out += '\n';
+        if (per_thread) {
+            for (const auto& [thread, value] : metric.threads) {
+                out += metric.name;
+                out += "{thread=\"";
+                out += thread;
+                out += "\"} ";
+                append_value(out, value);
+                out += '\n';
+            }
+        } else {
+            out += metric.name;
+            out += ' ';
+            append_value(out, metric.total);
+            out += '\n';
+        }
+    }
+    return out;
+}
+
+} // namespace goldearn::core
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+namespace goldearn::core {
+
+// Shared-memory statistics segment (/dev/shm) for out-of-process monitors.
+//
+// Hot threads attach once and then write plain per-thread counters and
+// gauges into their own cache lines: no atomics with a lock prefix, no
+// shared lines, no collector thread. The segment describes itself (metric
+// names, help, kind, aggregation), so goldearn_stats or an exporter in
+// another process maps it read-only and does all aggregation and
+// formatting there. The trading process does no scraping work.
+namespace stats_layout {
+
+constexpr uint64_t MAGIC = 0x3153544154534547ULL; // "GESTATS1"
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t MAX_METRICS = 256;
+constexpr uint32_t MAX_THREADS = 64;
+constexpr size_t NAME_SIZE = 64;
+constexpr size_t HELP_SIZE = 112;
+
+enum Kind : uint8_t {
+    COUNTER = 0, // uint64, monotonic
+    GAUGE = 1    // double bits
+};
+
+// How the reader combines the per-thread values of one metric
+enum Aggregation : uint8_t {
+    SUM = 0,
+    MAX = 1,
+    MIN = 2
+};
+
+enum BlockState : uint32_t {
+    BLOCK_FREE = 0,
+    BLOCK_LIVE = 1,
+    BLOCK_EXITED = 2  // Values kept; reused by a thread of the same name
+};
+
+struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t metric_capacity;
+    uint32_t thread_capacity;
+    uint64_t descriptors_offset;
+    uint64_t blocks_offset;
+    uint64_t block_size;            // Bytes per thread block (cache-line multiple)
+    int64_t pid;                    // Writer process, for liveness checks
+    int64_t created_wall_ns;
+    std::atomic<uint32_t> metric_count; // Descriptors [0, metric_count) are complete
+    std::atomic<uint32_t> thread_count; // Blocks [0, thread_count) have been used
+};
+
+struct Descriptor {
+    char name[NAME_SIZE];
+    char help[HELP_SIZE];
+    uint64_t initial;               // Value a fresh block starts with (bits)
+    uint8_t kind;
+    uint8_t aggregation;
+    uint8_t reserved[6];
+};
+static_assert(sizeof(Descriptor) == 192, "descriptor layout is shared with readers");
+
+// Each thread block starts with this line; values[] follow on their own lines
+struct alignas(64) BlockHeader {
+    char name[48];
+    std::atomic<uint32_t> state;
+    uint32_t thread_id;
+    std::atomic<uint64_t> generation; // Bumped on every (re)attach
+};
+static_assert(sizeof(BlockHeader) == 64, "block header is one cache line");
+
+} // namespace stats_layout
+
+// Writer side: one per process, created early in main() before hot threads start
+class StatsSegment {
+public:
+    // Creates (replacing) the segment; `name` is a /dev/shm name or an
+    // absolute path. Throws std::runtime_error on failure.
+    explicit StatsSegment(const std::string& name);
+    ~StatsSegment(); // Unlinks the segment
+
+    StatsSegment(const StatsSegment&) = delete;
+    StatsSegment& operator=(const StatsSegment&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    // Process-wide segment used by stats::* (nullptr until open() succeeds).
+    // close() unlinks it but keeps the mapping until exit, so threads that
+    // are still attached never write into unmapped memory.
+    static bool open(const std::string& name);
+    static void close();
+    static StatsSegment* current();
+
+    // Registration: ids are process-wide, stable and valid with or without
+    // a segment. Registering an existing name returns its id. Throws
+    // std::length_error beyond MAX_METRICS.
+    static uint32_t counter(const std::string& name, const std::string& help);
+    static uint32_t gauge(const std::string& name, const std::string& help,
+                          stats_layout::Aggregation aggregation = stats_layout::SUM);
+
+    // Give the calling thread its own block; without a segment (or when
+    // every block is live) its writes are dropped
+    static bool attach_thread(const std::string& name);
+    static void detach_thread();
+
+private:
+    void publish(uint32_t id, const std::string& name, const std::string& help, stats_layout::Kind kind,
+                 stats_layout::Aggregation aggregation, uint64_t initial);
+    uint64_t* claim_block(const std::string& name);
+    uint64_t* values(uint32_t block) const;
+    stats_layout::BlockHeader* block_header(uint32_t block) const;
+    static uint32_t define(const std::string& name, const std::string& help,
+                           stats_layout::Kind kind, stats_layout::Aggregation aggregation);
+
+    void unlink();
+
+    std::string path_;
+    bool linked_ = true;
+    std::byte* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    stats_layout::Header* header_ = nullptr;
+};
+
+// Hot-path writes to the calling thread's block (single writer, so plain
+// load/store; a thread that never attached pays one TLS load and a branch)
+namespace stats {
+
+inline thread_local uint64_t* tl_values = nullptr;
+
+inline void add(uint32_t id, uint64_t n = 1) {
+    if (uint64_t* values = tl_values) {
+        std::atomic_ref<uint64_t> value(values[id]);
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+}
+
+inline void set(uint32_t id, double v) {
+    if (uint64_t* values = tl_values) {
+        std::atomic_ref<uint64_t>(values[id]).store(std::bit_cast<uint64_t>(v), std::memory_order_relaxed);
+    }
+}
+
+inline void set_max(uint32_t id, double v) {
+    if (uint64_t* values = tl_values) {
+        std::atomic_ref<uint64_t> value(values[id]);
+        if (v > std::bit_cast<double>(value.load(std::memory_order_relaxed))) {
+            value.store(std::bit_cast<uint64_t>(v), std::memory_order_relaxed);
+        }
+    }
+}
+
+inline void set_min(uint32_t id, double v) {
+    if (uint64_t* values = tl_values) {
+        std::atomic_ref<uint64_t> value(values[id]);
+        if (v < std::bit_cast<double>(value.load(std::memory_order_relaxed))) {
+            value.store(std::bit_cast<uint64_t>(v), std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace stats
+
+// Reader side: maps a segment read-only (another process, or tests)
+class StatsReader {
+public:
+    // Throws std::runtime_error if the file is missing or not a stats segment
+    explicit StatsReader(const std::string& name);
+    ~StatsReader();
+
+    StatsReader(const StatsReader&) = delete;
+    StatsReader& operator=(const StatsReader&) = delete;
+
+    struct Metric {
+        std::string name;
+        std::string help;
+        stats_layout::Kind kind;
+        stats_layout::Aggregation aggregation;
+        double total;                                          // Aggregated over threads
+        std::vector<std::pair<std::string, double>> threads;   // Per attached thread
+    };
+
+    std::vector<Metric> read() const;
+    pid_t writer_pid() const { return static_cast<pid_t>(header_->pid); }
+    bool writer_alive() const;
+
+    // Prometheus text exposition of read(); per-thread series carry a thread label
+    static std::string to_prometheus(const std::vector<Metric>& metrics, bool per_thread = false);
+
+private:
+    std::string path_;
+    const std::byte* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    const stats_layout::Header* header_ = nullptr;
+};
+
+} // namespace goldearn::core
@@ -0,0 +1,508 @@
+#include "thread_pool.hpp"
+#include "flight_recorder.hpp"
+#include "jitter_monitor.hpp"
+#include "perf_counters.hpp"
+#include "stats_segment.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace goldearn::core {
+
+namespace {
+
+// Pool the calling thread belongs to (for local pushes) and the periodic task
+// it is currently running (so cancel() from inside the task does not wait on itself)
+thread_local WorkStealingPool* tl_pool = nullptr;
+thread_local size_t tl_worker_index = 0;
+thread_local const void* tl_current_periodic = nullptr;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+// Affinity helpers
+std::vector<int> parse_core_list(const std::string& spec) {
+    std::vector<int> cores;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (item.empty()) continue;
+        try {
+            size_t dash = item.find('-');
+            if (dash == std::string::npos) {
+                cores.push_back(std::stoi(item));
+            } else {
+                int first = std::stoi(item.substr(0, dash));
+                int last = std::stoi(item.substr(dash + 1));
+                for (int core = first; core <= last; ++core) cores.push_back(core);
+            }
+        } catch (const std::exception&) {
+            LOG_WARN("Ignoring invalid core list entry '{}'", item);
+        }
+    }
+    std::sort(cores.begin(), cores.end());
+    cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+    return cores;
+}
+
+bool pin_current_thread(const std::vector<int>& cores) {
+    if (cores.empty()) return false;
+
+    long available = sysconf(_SC_NPROCESSORS_CONF);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    size_t valid = 0;
+    for (int core : cores) {
+        if (core >= 0 && core < available && core < CPU_SETSIZE) {
+            CPU_SET(core, &set);
+            valid++;
+        }
+    }
+    if (valid == 0) {
+        LOG_WARN("No configured core exists on this host ({} cores), running unpinned", available);
+        return false;
+    }
+
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        LOG_WARN("pthread_setaffinity_np failed with error {}, running unpinned", rc);
+        return false;
+    }
+    return true;
+}
+
+bool pin_current_thread(int core) {
+    return pin_current_thread(std::vector<int>{core});
+}
+
+void set_current_thread_name(const std::string& name) {
+    // Kernel limit is 15 characters plus terminator
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+}
+
+// WorkStealingPool implementation
+WorkStealingPool::WorkStealingPool(const Config& config) : config_(config) {
+    size_t count = std::max<size_t>(config_.num_workers, 1);
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    stop();
+}
+
+void WorkStealingPool::start() {
+    if (running_.exchange(true)) return;
+    accepting_.store(true, std::memory_order_release);
+
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&WorkStealingPool::worker_loop, this, i);
+    }
+    timer_thread_ = std::thread(&WorkStealingPool::timer_loop, this);
+}
+
+void WorkStealingPool::stop() {
+    // A worker cannot join itself; the pool keeps running
+    if (on_worker_thread()) {
+        LOG_ERROR("WorkStealingPool {}: stop() called from a pool task was ignored", config_.name);
+        return;
+    }
+    if (!accepting_.exchange(false)) return;
+
+    // submit() checks accepting_ under the queue lock: once each lock has been
+    // taken here, every accepted task is queued and the workers drain it
+    for (auto& worker : workers_) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+    }
+
+    // No new periodic runs; queued ones are skipped by run_periodic()
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+    }
+    timer_cv_.notify_all();
+    if (timer_thread_.joinable()) timer_thread_.join();
+
+    // Workers leave once their own deque is empty
+    running_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+    }
+    idle_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+bool WorkStealingPool::submit(Task task) {
+    size_t index = (tl_pool == this)
+        ? tl_worker_index
+        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    bool accepted;
+    {
+        // Checked under the lock stop() sweeps, so an accepted task is never left behind
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        accepted = accepting_.load(std::memory_order_acquire);
+        if (accepted) {
+            // Count first so a worker that pops the task never sees the counter underflow
+            pending_tasks_.fetch_add(1, std::memory_order_release);
+            workers_[index]->tasks.push_back(std::move(task));
+        }
+    }
+    if (!accepted) {
+        tasks_rejected_.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN("WorkStealingPool {}: task submitted after stop() was dropped", config_.name);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+    }
+    idle_cv_.notify_one();
+    return true;
+}
+
+TaskId WorkStealingPool::schedule_periodic(std::chrono::milliseconds interval, Task task,
+                                           const std::string& name) {
+    auto entry = std::make_shared<PeriodicEntry>();
+    entry->id = next_task_id_.fetch_add(1);
+    entry->name = name;
+    entry->interval = std::max(interval, std::chrono::milliseconds(1));
+    entry->next_run = std::chrono::steady_clock::now() + entry->interval;
+    entry->task = std::move(task);
+
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        periodic_[entry->id] = entry;
+    }
+    timer_cv_.notify_all();
+    return entry->id;
+}
+
+void WorkStealingPool::cancel(TaskId id) {
+    std::shared_ptr<PeriodicEntry> entry;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        auto it = periodic_.find(id);
+        if (it == periodic_.end()) return;
+        entry = it->second;
+        periodic_.erase(it);
+    }
+    entry->cancelled.store(true, std::memory_order_release);
+
+    if (tl_current_periodic == entry.get()) return;
+    while (entry->running.load(std::memory_order_acquire) && running_.load()) {
+        std::this_thread::yield();
+    }
+}
+
+bool WorkStealingPool::on_worker_thread() const {
+    return tl_pool == this;
+}
+
+WorkStealingPool::Stats WorkStealingPool::get_statistics() const {
+    return Stats{
+        tasks_executed_.load(std::memory_order_relaxed),
+        tasks_stolen_.load(std::memory_order_relaxed),
+        periodic_runs_.load(std::memory_order_relaxed),
+        periodic_skipped_.load(std::memory_order_relaxed),
+        tasks_rejected_.load(std::memory_order_relaxed),
+        workers_.size()
+    };
+}
+
+bool WorkStealingPool::try_pop_local(size_t index, Task& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::try_steal(size_t thief, Task& task) {
+    size_t count = workers_.size();
+    for (size_t offset = 1; offset < count; ++offset) {
+        Worker& victim = *workers_[(thief + offset) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        tasks_stolen_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::worker_loop(size_t index) {
+    tl_pool = this;
+    tl_worker_index = index;
+    set_current_thread_name(config_.name.substr(0, 11) + "-" + std::to_string(index));
+    if (!config_.cores.empty()) {
+        pin_current_thread(config_.cores);
+    }
+
+    Task task;
+    while (true) {
+        if (try_pop_local(index, task) || try_steal(index, task)) {
+            pending_tasks_.fetch_sub(1, std::memory_order_relaxed);
+            try {
+                task();
+            } catch (const std::exception& e) {
+                LOG_ERROR("Background task failed: {}", e.what());
+            }
+            task = nullptr;
+            tasks_executed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // Stopping: leave only with this worker's deque drained
+        if (!running_.load(std::memory_order_acquire)) break;
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_cv_.wait_for(lock, std::chrono::milliseconds(50), [this] {
+            return !running_.load(std::memory_order_acquire) ||
+                   pending_tasks_.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    tl_pool = nullptr;
+}
+
+void WorkStealingPool::timer_loop() {
+    set_current_thread_name(config_.name.substr(0, 9) + "-timer");
+    if (!config_.cores.empty()) {
+        pin_current_thread(config_.cores);
+    }
+
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+    while (accepting_.load(std::memory_order_acquire)) {
+        auto now = std::chrono::steady_clock::now();
+        auto next_wakeup = now + std::chrono::seconds(1);
+
+        for (auto& [id, entry] : periodic_) {
+            if (entry->next_run <= now) {
+                // Catch up by skipping missed slots rather than bursting
+                entry->next_run += entry->interval;
+                if (entry->next_run <= now) entry->next_run = now + entry->interval;
+
+                if (entry->running.exchange(true, std::memory_order_acq_rel)) {
+                    periodic_skipped_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    submit([this, entry]() { run_periodic(entry); });
+                }
+            }
+            next_wakeup = std::min(next_wakeup, entry->next_run);
+        }
+
+        timer_cv_.wait_until(lock, next_wakeup);
+    }
+}
+
+void WorkStealingPool::run_periodic(const std::shared_ptr<PeriodicEntry>& entry) {
+    if (!entry->cancelled.load(std::memory_order_acquire) && accepting_.load(std::memory_order_acquire)) {
+        tl_current_periodic = entry.get();
+        try {
+            entry->task();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Periodic task '{}' failed: {}", entry->name, e.what());
+        }
+        tl_current_periodic = nullptr;
+        periodic_runs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    entry->running.store(false, std::memory_order_release);
+}
+
+// SpinThread implementation
+SpinThread::SpinThread(const std::string& name, int core, PollFunction poll)
+    : name_(name), core_(core), poll_(std::move(poll)) {}
+
+SpinThread::~SpinThread() {
+    stop();
+}
+
+void SpinThread::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&SpinThread::run, this);
+}
+
+void SpinThread::stop() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+}
+
+void SpinThread::run() {
+    set_current_thread_name(name_);
+    if (core_ >= 0) {
+        pinned_.store(pin_current_thread(core_));
+    }
+    if (perf_counters_) {
+        PerfCounters::instance().register_thread(name_);
+    }
+    StatsSegment::attach_thread(name_);
+    FlightRecorder::instance().attach_thread(name_);
+    JitterProbe* probe = jitter_probe_;
+    if (probe) probe->start();
+
+    // Single writer: plain load/store keeps the counters off the lock prefix
+    uint64_t iterations = 0;
+    uint64_t busy = 0;
+    while (running_.load(std::memory_order_relaxed)) {
+        if (poll_()) {
+            busy++;
+            if (probe) probe->restart();
+        } else {
+            if (probe) probe->sample();
+            if (idle_hook_) idle_hook_();
+            cpu_relax();
+        }
+        iterations++;
+        if ((iterations & 1023) == 0) {
+            iterations_.store(iterations, std::memory_order_relaxed);
+            busy_iterations_.store(busy, std::memory_order_relaxed);
+        }
+    }
+    iterations_.store(iterations, std::memory_order_relaxed);
+    busy_iterations_.store(busy, std::memory_order_relaxed);
+    if (perf_counters_) {
+        PerfCounters::instance().unregister_thread();
+    }
+    if (probe) probe->stop();
+    StatsSegment::detach_thread();
+    FlightRecorder::instance().detach_thread();
+}
+
+// Runtime implementation
+std::unordered_map<std::string, int> Runtime::Config::parse_critical_cores(const std::string& spec) {
+    std::unordered_map<std::string, int> result;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = trim(item.substr(0, colon));
+        try {
+            result[name] = std::stoi(trim(item.substr(colon + 1)));
+        } catch (const std::exception&) {
+            LOG_WARN("Ignoring invalid critical core entry '{}'", item);
+        }
+    }
+    return result;
+}
+
+Runtime::~Runtime() {
+    shutdown();
+}
+
+void Runtime::configure(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (background_) {
+        config_.critical_cores = config.critical_cores;
+        config_.hot_thread_counters = config.hot_thread_counters;
+        config_.jitter_spin_threads = config.jitter_spin_threads;
+        return;
+    }
+    config_ = config;
+
+    // Critical cores are reserved: never let housekeeping run on them
+    for (const auto& [name, core] : config_.critical_cores) {
+        auto& hk = config_.housekeeping_cores;
+        hk.erase(std::remove(hk.begin(), hk.end(), core), hk.end());
+    }
+}
+
+WorkStealingPool& Runtime::background() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shut_down_) {
+        throw std::logic_error("Runtime: background() called after shutdown()");
+    }
+    if (!background_) {
+        WorkStealingPool::Config pool_config;
+        pool_config.name = "housekeeping";
+        pool_config.num_workers = config_.housekeeping_threads;
+        pool_config.cores = config_.housekeeping_cores;
+        background_ = std::make_unique<WorkStealingPool>(pool_config);
+        background_->start();
+    }
+    return *background_;
+}
+
+void Runtime::cancel(TaskId id) {
+    WorkStealingPool* pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool = background_.get();
+    }
+    if (pool) pool->cancel(id);
+}
+
+std::unique_ptr<SpinThread> Runtime::create_critical_thread(const std::string& name,
+                                                            SpinThread::PollFunction poll) {
+    int core = get_critical_core(name);
+    if (core < 0) {
+        LOG_WARN("No core assigned to critical thread '{}', running unpinned", name);
+    }
+    auto thread = std::make_unique<SpinThread>(name, core, std::move(poll));
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread->set_perf_counters(config_.hot_thread_counters);
+    if (config_.jitter_spin_threads) {
+        thread->set_jitter_probe(JitterMonitor::instance().create_probe(name));
+    }
+    return thread;
+}
+
+int Runtime::get_critical_core(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = config_.critical_cores.find(name);
+    return it != config_.critical_cores.end() ? it->second : -1;
+}
+
+bool Runtime::is_shut_down() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shut_down_;
+}
+
+void Runtime::shutdown() {
+    std::unique_ptr<WorkStealingPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (background_ && background_->on_worker_thread()) {
+            LOG_ERROR("Runtime: shutdown() called from a background task was ignored");
+            return;
+        }
+        shut_down_ = true;
+        pool = std::move(background_);
+    }
+    if (pool) {
+        pool->stop();
+        const auto stats = pool->get_statistics();
+        if (stats.tasks_rejected > 0) {
+            LOG_WARN("Runtime: {} background tasks were submitted during shutdown and dropped",
+                     stats.tasks_rejected);
+        }
+    }
+}
+
+} // namespace goldearn::core
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace goldearn::core {
+
+// Threading runtime with two tiers:
+//  - WorkStealingPool: a small pool confined to housekeeping cores that runs
+//    background and periodic jobs (monitoring, cleanup, metrics, HTTP).
+//  - SpinThread: one busy-polling thread per latency-critical loop, pinned
+//    to a dedicated core taken from config. Never sleeps.
+
+using Task = std::function<void()>;
+using TaskId = uint64_t;
+
+// CPU affinity helpers. Cores that do not exist on this host are ignored;
+// pinning failures are reported but never fatal.
+std::vector<int> parse_core_list(const std::string& spec); // "0-1,4,6"
+bool pin_current_thread(const std::vector<int>& cores);
+bool pin_current_thread(int core);
+void set_current_thread_name(const std::string& name);
+
+// Work-stealing pool for background tasks.
+//
+// Each worker owns a deque: it pushes and pops at the back (LIFO keeps caches
+// warm) and idle workers steal from the front of their peers. Tasks submitted
+// from outside the pool are distributed round-robin. Idle workers block, so
+// the pool costs nothing while there is no housekeeping to do.
+class WorkStealingPool {
+public:
+    struct Config {
+        std::string name = "housekeeping";
+        size_t num_workers = 2;
+        std::vector<int> cores; // Empty = no affinity
+    };
+
+    explicit WorkStealingPool(const Config& config);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void start();
+    // Stops accepting work and periodic runs, runs the one-shot tasks already
+    // queued, then joins. Whatever those tasks submit meanwhile is rejected.
+    // Ignored (with an error logged) when called from one of the pool's tasks.
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // False, with the task dropped, when the pool is not running or stopping
+    bool submit(Task task);
+
+    // Run `task` every `interval` on the pool. A run is skipped if the
+    // previous one is still executing, so slow jobs never pile up.
+    TaskId schedule_periodic(std::chrono::milliseconds interval, Task task,
+                             const std::string& name = "");
+    // Cancel a periodic task and wait for an in-flight run to finish
+    // (returns immediately when called from inside that task).
+    void cancel(TaskId id);
+
+    struct Stats {
+        uint64_t tasks_executed;
+        uint64_t tasks_stolen;
+        uint64_t periodic_runs;
+        uint64_t periodic_skipped;
+        uint64_t tasks_rejected;
+        size_t num_workers;
+    };
+    Stats get_statistics() const;
+
+    size_t num_workers() const { return workers_.size(); }
+    // True on the pool's own workers, i.e. inside one of its tasks
+    bool on_worker_thread() const;
+
+private:
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    struct PeriodicEntry {
+        TaskId id;
+        std::string name;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point next_run;
+        Task task;
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> running{false};
+    };
+
+    Config config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> accepting_{false};   // Cleared first on stop()
+    std::atomic<size_t> next_worker_{0};
+
+    // Idle workers park here
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<size_t> pending_tasks_{0};
+
+    // Periodic scheduling (timer thread only enqueues; work runs on workers)
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    std::unordered_map<TaskId, std::shared_ptr<PeriodicEntry>> periodic_;
+    std::atomic<TaskId> next_task_id_{1};
+    std::thread timer_thread_;
+
+    std::atomic<uint64_t> tasks_executed_{0};
+    std::atomic<uint64_t> tasks_stolen_{0};
+    std::atomic<uint64_t> periodic_runs_{0};
+    std::atomic<uint64_t> periodic_skipped_{0};
+    std::atomic<uint64_t> tasks_rejected_{0};
+
+    void worker_loop(size_t index);
+    void timer_loop();
+    bool try_pop_local(size_t index, Task& task);
+    bool try_steal(size_t thief, Task& task);
+    void run_periodic(const std::shared_ptr<PeriodicEntry>& entry);
+};
+
+class JitterProbe;
+
+// Dedicated busy-polling thread for a latency-critical loop.
+//
+// `poll` is called back-to-back and returns true when it did useful work.
+// When it returns false the optional idle hook runs and the jitter probe,
+// if any, times the idle iteration; the thread never yields or sleeps.
+class SpinThread {
+public:
+    using PollFunction = std::function<bool()>;
+    using IdleHook = std::function<void()>;
+
+    SpinThread(const std::string& name, int core, PollFunction poll);
+    ~SpinThread();
+
+    SpinThread(const SpinThread&) = delete;
+    SpinThread& operator=(const SpinThread&) = delete;
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(std::memory_order_relaxed); }
+
+    void set_idle_hook(IdleHook hook) { idle_hook_ = std::move(hook); } // Before start()
+    void set_perf_counters(bool enabled) { perf_counters_ = enabled; }   // Before start()
+    void set_jitter_probe(JitterProbe* probe) { jitter_probe_ = probe; } // Before start()
+
+    const std::string& name() const { return name_; }
+    int core() const { return core_; }
+    bool is_pinned() const { return pinned_.load(); }
+
+    uint64_t get_iterations() const { return iterations_.load(std::memory_order_relaxed); }
+    uint64_t get_busy_iterations() const { return busy_iterations_.load(std::memory_order_relaxed); }
+
+private:
+    std::string name_;
+    int core_;
+    PollFunction poll_;
+    IdleHook idle_hook_;
+    bool perf_counters_ = false;
+    JitterProbe* jitter_probe_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> pinned_{false};
+
+    alignas(64) std::atomic<uint64_t> iterations_{0};
+    std::atomic<uint64_t> busy_iterations_{0};
+
+    void run();
+};
+
+// Process-wide runtime owning the housekeeping pool and the critical threads
+class Runtime {
+public:
+    static Runtime& instance() {
+        static Runtime instance;
+        return instance;
+    }
+
+    // Separate instances are for tests; the process uses instance()
+    Runtime() = default;
+    ~Runtime();
+
+    Runtime(const Runtime&) = delete;
+    Runtime& operator=(const Runtime&) = delete;
+
+    struct Config {
+        std::vector<int> housekeeping_cores;           // [runtime] housekeeping_cores = 0-1
+        size_t housekeeping_threads = 2;               // [runtime] housekeeping_threads = 2
+        std::unordered_map<std::string, int> critical_cores; // [runtime] critical_cores = feed_handler:2,order_gateway:3
+        bool hot_thread_counters = false;              // [runtime] hot_thread_counters = true (perf_event_open)
+        bool jitter_spin_threads = false;              // [runtime] jitter_spin_threads = true (probe idle iterations)
+
+        // Parse "name:core,name:core"
+        static std::unordered_map<std::string, int> parse_critical_cores(const std::string& spec);
+    };
+
+    // Must be called before the first use of background(); later calls only
+    // update the critical thread settings.
+    void configure(const Config& config);
+    const Config& get_config() const { return config_; }
+
+    // Housekeeping pool, started on first use. Throws std::logic_error
+    // after shutdown(): the pool is never silently recreated.
+    WorkStealingPool& background();
+    bool is_shut_down() const;
+
+    // Cancel a periodic background task; no-op once the runtime is shut down
+    void cancel(TaskId id);
+
+    // Create a pinned spin thread for a named critical loop. The core comes
+    // from critical_cores; unknown names run unpinned (core -1).
+    std::unique_ptr<SpinThread> create_critical_thread(const std::string& name,
+                                                       SpinThread::PollFunction poll);
+    int get_critical_core(const std::string& name) const;
+
+    // Stops the housekeeping pool, running the tasks it already queued.
+    // Ignored (with an error logged) when called from a background task.
+    void shutdown();
+
+private:
+    mutable std::mutex mutex_;
+    Config config_;
+    std::unique_ptr<WorkStealingPool> background_;
+    bool shut_down_ = false;
+};
+
+} // namespace goldearn::core
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include "../utils/fast_log.hpp"
+
+using namespace goldearn;
+
+// Offline decoder for the memory-mapped log written by LOG_FAST. Prints the
+// records still in the (rolling) file as text, oldest first, in the same
+// line format as the regular log.
+
+namespace {
+
+const char* level_name(uint8_t level) {
+    static const char* names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "CRIT"};
+    return level < 6 ? names[level] : "UNKNOWN";
+}
+
+void print_record(const utils::fast_log::DecodedRecord& record) {
+    std::time_t seconds = static_cast<std::time_t>(record.wall_ns / 1000000000);
+    std::tm local;
+    localtime_r(&seconds, &local);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local);
+    std::printf("[%s.%06lld] [%s] [%u] %s\n", timestamp,
+                static_cast<long long>((record.wall_ns / 1000) % 1000000),
+                level_name(record.level), record.thread_id, record.message.c_str());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    size_t tail = 0;
+    long thread_filter = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tail" && i + 1 < argc) {
+            tail = std::stoul(argv[++i]);
+        } else if (arg == "--thread" && i + 1 < argc) {
+            thread_filter = std::stol(argv[++i]);
+        } else if (arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [options] <fast log file>\n";
+            std::cout << "Options:\n";
+            std::cout << "  --tail <n>        Only print the newest n records\n";
+            std::cout << "  --thread <tid>    Only print records from this thread\n";
+            std::cout << "  --help            Show this help message\n";
+            return 0;
+        } else {
+            path = arg;
+        }
+    }
+
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [options] <fast log file>\n";
+        return 1;
+    }
+
+    std::vector<utils::fast_log::DecodedRecord> records;
+    try {
+        records = utils::fast_log::decode_file(path);
+    } catch (const std::exception& e) {
+        std::cerr << "fast_log_decode: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (thread_filter >= 0) {
+        std::erase_if(records, [&](const auto& r) { return r.thread_id != static_cast<uint32_t>(thread_filter); });
+    }
+    size_t first = tail > 0 && tail < records.size() ? records.size() - tail : 0;
+    for (size_t i = first; i < records.size(); ++i) {
+        print_record(records[i]);
+    }
+    return 0;
+}
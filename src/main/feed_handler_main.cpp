@@ -7,6 +7,8 @@
 #include "../market_data/nse_protocol.hpp"
 #include "../market_data/order_book.hpp"
 #include "../core/latency_tracker.hpp"
+#include "../core/flight_recorder.hpp"
+#include "../core/perf_counters.hpp"
 
 using namespace goldearn;
 
@@ -188,7 +190,11 @@ private:
             quote.ask_quantity = quote_msg.ask_quantity;
             quote.quote_time = quote_msg.quote_time;
             
-            order_book->update_quote(quote);
+            {
+                PERF_REGION(core::perf_region::BOOK_UPDATE);
+                order_book->update_quote(quote);
+            }
+            core::flight::top_of_book(quote.symbol_id, quote.bid_price, quote.ask_price);
             quote_count_++;
             
         } catch (const std::exception& e) {
@@ -220,7 +226,10 @@ private:
             }
             
             // Add order to order book with timestamp
-            order_book->add_order(order_msg.order_id, order_msg.order_type, order_msg.price, order_msg.quantity, order_msg.order_time);
+            {
+                PERF_REGION(core::perf_region::BOOK_UPDATE);
+                order_book->add_order(order_msg.order_id, order_msg.order_type, order_msg.price, order_msg.quantity, order_msg.order_time);
+            }
             order_update_count_++;
             
         } catch (const std::exception& e) {
@@ -244,6 +253,7 @@ private:
         auto stats = latency_tracker_.get_stats();
         LOG_INFO("Processing latency - Avg: {:.2f}μs, P99: {:.2f}μs", 
                  stats.avg_latency_us, stats.p99_latency_us);
+        core::PerfCounters::instance().log_report();
         LOG_INFO("=============================");
     }
     
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include "../core/flight_recorder.hpp"
+
+using namespace goldearn;
+
+// Offline decoder for flight recorder dumps. Merges the per-thread rings
+// into one timeline ordered by TSC and prints one event per line with the
+// wall-clock time, the thread and the gap to the previous event.
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::string thread_filter;
+    size_t tail = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tail" && i + 1 < argc) {
+            tail = std::stoul(argv[++i]);
+        } else if (arg == "--thread" && i + 1 < argc) {
+            thread_filter = argv[++i];
+        } else if (arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [options] <flight recorder dump>\n";
+            std::cout << "Options:\n";
+            std::cout << "  --tail <n>        Only print the newest n events\n";
+            std::cout << "  --thread <name>   Only print events from this thread\n";
+            std::cout << "  --help            Show this help message\n";
+            return 0;
+        } else {
+            path = arg;
+        }
+    }
+
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [options] <flight recorder dump>\n";
+        return 1;
+    }
+
+    core::flight_recorder::DecodedDump dump;
+    try {
+        dump = core::flight_recorder::decode_file(path);
+    } catch (const std::exception& e) {
+        std::cerr << "flight_decode: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (!thread_filter.empty()) {
+        std::erase_if(dump.events, [&](const auto& e) { return e.thread != thread_filter; });
+    }
+
+    std::printf("# pid %d, reason %s, %zu events\n", dump.pid, dump.reason.c_str(), dump.events.size());
+    size_t first = tail > 0 && tail < dump.events.size() ? dump.events.size() - tail : 0;
+    int64_t previous_ns = first < dump.events.size() ? dump.events[first].wall_ns : 0;
+    for (size_t i = first; i < dump.events.size(); ++i) {
+        const auto& event = dump.events[i];
+        std::time_t seconds = static_cast<std::time_t>(event.wall_ns / 1000000000);
+        std::tm local;
+        localtime_r(&seconds, &local);
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local);
+        std::printf("[%s.%09lld] +%8lldns [%s/%u] %s\n", timestamp,
+                    static_cast<long long>(event.wall_ns % 1000000000),
+                    static_cast<long long>(event.wall_ns - previous_ns), event.thread.c_str(), event.thread_id,
+                    core::flight_recorder::describe(event.event).c_str());
+        previous_ns = event.wall_ns;
+    }
+    return 0;
+}
@@ -3,9 +3,21 @@
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "../utils/simple_logger.hpp"
-#include "../core/latency_tracker.hpp"
+#include "../config/config_manager.hpp"
+#include "../core/stats_segment.hpp"
+#include "../core/thread_pool.hpp"
+#include "../risk/incremental_var.hpp"
+#include "../trading/position_segment.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace goldearn;
 
@@ -21,290 +33,429 @@ void signal_handler(int signal) {
 
 struct RiskLimits {
     double max_position_value = 10000000.0;     // 10M INR per position
-    double max_portfolio_value = 50000000.0;    // 50M INR total
+    double max_portfolio_value = 50000000.0;    // 50M INR gross
     double max_daily_loss = 1000000.0;          // 1M INR daily loss limit
-    double max_order_value = 5000000.0;         // 5M INR per order
-    double position_concentration = 0.20;        // 20% max in single position
-    double sector_concentration = 0.40;          // 40% max in single sector
-    uint32_t max_order_rate = 1000;             // Max orders per second
-    uint32_t max_message_rate = 10000;          // Max messages per second
+    double max_var_1d = 5000000.0;              // 95% 1-day VaR
+    double position_concentration = 0.20;        // 20% max in single symbol
+    int64_t max_heartbeat_age_ms = 50;          // Writer silent this long: hung or gone
 };
 
-struct RiskMetrics {
-    std::atomic<double> current_portfolio_value{0.0};
-    std::atomic<double> daily_pnl{0.0};
-    std::atomic<double> daily_realized_pnl{0.0};
-    std::atomic<double> daily_unrealized_pnl{0.0};
-    std::atomic<uint64_t> daily_trades{0};
-    std::atomic<uint64_t> daily_orders{0};
-    std::atomic<uint64_t> rejected_orders{0};
-    std::atomic<uint32_t> current_order_rate{0};
-    std::atomic<uint32_t> current_message_rate{0};
-    std::atomic<uint32_t> active_positions{0};
-    std::atomic<bool> trading_enabled{true};
-    std::atomic<bool> emergency_stop{false};
+// Portfolio figures rebuilt from the position feed, change by change
+struct PortfolioState {
+    double gross_exposure = 0.0;
+    double realized_pnl = 0.0;
+    double unrealized_pnl = 0.0;
+    double var_1d = 0.0;
+    double largest_symbol_share = 0.0;
+    uint64_t trades = 0;
+    uint32_t active_positions = 0;
+    bool emergency_stop = false;
+
+    double daily_pnl() const { return realized_pnl + unrealized_pnl; }
 };
 
+// Risk monitor in its own process. It maps the trading engine's position
+// segment read-only, applies each poll's changed positions to running
+// totals and an incremental VaR, and checks them against the limits; the
+// trading threads only ever write their own records. How current the view
+// is (writer heartbeat, publish-to-observe age, journal lag) is published
+// in the monitor's own statistics segment for goldearn_stats.
 class RiskMonitor {
 public:
-    RiskMonitor() : latency_tracker_("RiskMonitor") {
+    RiskMonitor() {
         LOG_INFO("Initializing GoldEarn HFT Risk Monitor");
     }
-    
-    bool initialize(const std::string& config_file) {
+
+    bool initialize(const std::string& config_file, const std::string& segment_override, int64_t poll_us) {
         LOG_INFO("Loading risk monitor configuration from: {}", config_file);
-        
-        // Load risk limits from config
-        // TODO: Implement actual config loading
+
+        config::ConfigManager config;
+        if (!config.load_config(config_file)) {
+            LOG_WARN("Cannot load {}; using default limits", config_file);
+        }
+        segment_name_ = segment_override.empty()
+            ? config.get_string("system", "position_segment", "goldearn_positions") : segment_override;
+        poll_interval_us_ = poll_us >= 0 ? poll_us : config.get_int("risk_monitor", "poll_interval_us", DEFAULT_POLL_US);
+
+        // Spinning takes a whole core; only on one reserved for the monitor
+        std::vector<int> cores = core::parse_core_list(config.get_string("risk_monitor", "cpu_affinity", ""));
+        if (poll_interval_us_ <= 0 && cores.empty()) {
+            LOG_ERROR("poll_interval_us = 0 spins a core: set [risk_monitor] cpu_affinity or a poll interval");
+            return false;
+        }
+        if (!cores.empty() && !core::pin_current_thread(cores)) {
+            LOG_ERROR("Cannot pin the risk monitor to [risk_monitor] cpu_affinity");
+            return false;
+        }
+
+        limits_.max_daily_loss = config.get_double("risk_limits", "max_daily_loss", limits_.max_daily_loss);
+        limits_.max_portfolio_value = config.get_double("risk_limits", "max_portfolio_exposure", limits_.max_portfolio_value);
+        limits_.max_var_1d = config.get_double("risk_limits", "max_var_1d", limits_.max_var_1d);
+        limits_.max_position_value = config.get_double("risk_monitor", "max_position_value", limits_.max_position_value);
+        limits_.position_concentration = config.get_double("risk_monitor", "position_concentration", limits_.position_concentration);
+        limits_.max_heartbeat_age_ms = config.get_int("risk_monitor", "max_heartbeat_age_ms", limits_.max_heartbeat_age_ms);
+        daily_volatility_ = config.get_double("risk_monitor", "daily_volatility", 0.02);
+        correlation_ = config.get_double("risk_monitor", "correlation", 0.3);
+
         LOG_INFO("Risk limits initialized:");
         LOG_INFO("  Max position value: {:.2f} INR", limits_.max_position_value);
         LOG_INFO("  Max portfolio value: {:.2f} INR", limits_.max_portfolio_value);
         LOG_INFO("  Max daily loss: {:.2f} INR", limits_.max_daily_loss);
-        LOG_INFO("  Max order value: {:.2f} INR", limits_.max_order_value);
+        LOG_INFO("  Max 1-day VaR: {:.2f} INR", limits_.max_var_1d);
         LOG_INFO("  Position concentration: {:.2%}", limits_.position_concentration);
-        LOG_INFO("  Max order rate: {} orders/sec", limits_.max_order_rate);
-        
-        // Initialize monitoring threads
-        monitoring_thread_ = std::thread(&RiskMonitor::monitoring_loop, this);
-        
-        LOG_INFO("Risk monitor initialized successfully");
+        LOG_INFO("  VaR model: {:.2%} daily volatility, {:.2f} correlation", daily_volatility_, correlation_);
+
+        // Staleness and portfolio figures for goldearn_stats
+        std::string stats_name = config.get_string("risk_monitor", "stats_segment", "goldearn_risk_monitor");
+        if (!stats_name.empty() && core::StatsSegment::open(stats_name)) {
+            register_metrics();
+            core::StatsSegment::attach_thread("risk_monitor");
+            LOG_INFO("Staleness metrics: goldearn_stats {}", stats_name);
+        }
+
+        LOG_INFO("Risk monitor initialized successfully (segment {}, poll {})", segment_name_,
+                 poll_interval_us_ > 0 ? std::to_string(poll_interval_us_) + "us" : std::string("spinning"));
         return true;
     }
-    
+
     void run() {
         LOG_INFO("Risk monitor running");
-        
+
         auto last_report_time = std::chrono::steady_clock::now();
+        auto next_housekeeping = last_report_time;
         const auto report_interval = std::chrono::seconds(30);
-        
+        const auto housekeeping_interval = std::chrono::milliseconds(100);
+
         while (g_running) {
-            // Simulate risk checks
-            perform_risk_checks();
-            
-            // Generate periodic reports
+            // The engine may not be up yet, or may have restarted
+            if (!reader_ && !attach()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+
+            size_t changed = reader_->poll();
+            if (changed > 0) {
+                apply_changes(reader_->changed());
+                check_portfolio();
+                interval_record_age_ns_ = std::max(interval_record_age_ns_, reader_->staleness().last_record_age_ns);
+            }
+
             auto now = std::chrono::steady_clock::now();
+            if (now >= next_housekeeping) {
+                housekeeping();
+                next_housekeeping = now + housekeeping_interval;
+            }
             if (now - last_report_time >= report_interval) {
                 generate_risk_report();
                 last_report_time = now;
             }
-            
-            // Check for emergency conditions
-            check_emergency_conditions();
-            
-            // Sleep briefly
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            if (changed == 0) {
+                idle();
+            }
         }
-        
+
         LOG_INFO("Risk monitor stopped");
     }
-    
+
     void shutdown() {
         LOG_INFO("Shutting down risk monitor");
-        
+
         g_running = false;
-        
-        if (monitoring_thread_.joinable()) {
-            monitoring_thread_.join();
-        }
-        
         generate_final_report();
-        
+        core::StatsSegment::close();
+
         LOG_INFO("Risk monitor shutdown complete");
     }
-    
-    // Risk check methods (would be called by trading engine)
-    bool check_pre_trade_risk(const std::string& symbol, char side, 
-                             double price, uint64_t quantity) {
-        auto start = std::chrono::high_resolution_clock::now();
-        
-        bool approved = true;
-        std::string rejection_reason;
-        
-        // Check if trading is enabled
-        if (!metrics_.trading_enabled || metrics_.emergency_stop) {
-            approved = false;
-            rejection_reason = "Trading disabled";
-        }
-        
-        // Check order value
-        double order_value = price * quantity;
-        if (approved && order_value > limits_.max_order_value) {
-            approved = false;
-            rejection_reason = "Order value exceeds limit";
+
+private:
+    struct SymbolState {
+        double quantity = 0.0;      // Net over strategies
+        double exposure = 0.0;
+        double price = 0.0;
+    };
+
+    bool attach() {
+        try {
+            reader_ = std::make_unique<trading::PositionFeedReader>(segment_name_);
+        } catch (const std::exception& e) {
+            if (!attach_warned_) {
+                LOG_WARN("Waiting for position segment: {}", e.what());
+                attach_warned_ = true;
+            }
+            return false;
         }
-        
-        // Check daily loss limit
-        if (approved && metrics_.daily_pnl < -limits_.max_daily_loss) {
-            approved = false;
-            rejection_reason = "Daily loss limit breached";
-            metrics_.trading_enabled = false;
+        if (!reader_->writer_alive()) {
+            reader_.reset();
+            return false;
         }
-        
-        // Check order rate
-        if (approved && metrics_.current_order_rate >= limits_.max_order_rate) {
-            approved = false;
-            rejection_reason = "Order rate limit exceeded";
+        attach_warned_ = false;
+        LOG_INFO("Attached to position segment {} (engine pid {})", segment_name_, reader_->writer_pid());
+
+        // Everything already published counts as changed
+        std::vector<uint32_t> all(reader_->positions().size());
+        for (uint32_t slot = 0; slot < all.size(); ++slot) all[slot] = slot;
+        apply_changes(all);
+        check_portfolio();
+        return true;
+    }
+
+    void detach() {
+        LOG_WARN("Position segment writer (pid {}) has exited; waiting for the engine", reader_->writer_pid());
+        reader_.reset();
+        applied_.clear();
+        symbols_.clear();
+        model_symbols_.clear();
+        var_ = std::make_unique<risk::IncrementalVaR>();
+        state_ = PortfolioState{};
+    }
+
+    // Running totals move by each changed position's difference from what
+    // was applied before; only VaR touches more than the position itself
+    void apply_changes(const std::vector<uint32_t>& slots) {
+        const auto& positions = reader_->positions();
+        if (applied_.size() < positions.size()) {
+            applied_.resize(positions.size());
         }
-        
-        // Check portfolio value
-        double new_portfolio_value = metrics_.current_portfolio_value + 
-                                   (side == 'B' ? order_value : -order_value);
-        if (approved && new_portfolio_value > limits_.max_portfolio_value) {
-            approved = false;
-            rejection_reason = "Portfolio value limit exceeded";
+        bool new_symbols = false;
+        for (uint32_t slot : slots) {
+            const auto& position = positions[slot];
+            const auto& now = position.values;
+            auto& before = applied_[slot];
+
+            state_.gross_exposure += std::abs(now.exposure) - std::abs(before.exposure);
+            state_.realized_pnl += now.realized_pnl - before.realized_pnl;
+            state_.unrealized_pnl += now.unrealized_pnl - before.unrealized_pnl;
+            state_.trades += now.trades - before.trades;
+            state_.active_positions += (now.quantity != 0.0) - (before.quantity != 0.0);
+
+            auto [it, inserted] = symbols_.try_emplace(position.symbol_id);
+            new_symbols |= inserted;
+            SymbolState& symbol = it->second;
+            symbol.quantity += now.quantity - before.quantity;
+            symbol.exposure += now.exposure - before.exposure;
+            if (now.market_price > 0.0) symbol.price = now.market_price;
+            if (!new_symbols && symbol.price > 0.0) {
+                var_->set_position(position.symbol_id, symbol.quantity, symbol.price);
+            }
+
+            if (std::abs(now.exposure) > limits_.max_position_value &&
+                std::abs(before.exposure) <= limits_.max_position_value) {
+                LOG_WARN("Position limit breached - Strategy: {}, Symbol: {}, Value: {:.2f} INR",
+                         position.strategy_id, position.symbol_id, now.exposure);
+            }
+            before = now;
         }
-        
-        // Update metrics
-        if (!approved) {
-            metrics_.rejected_orders++;
-            LOG_WARN("Order rejected - Symbol: {}, Side: {}, Value: {:.2f}, Reason: {}",
-                    symbol, side, order_value, rejection_reason);
-        } else {
-            metrics_.daily_orders++;
+
+        // New symbols enter the VaR model with the default volatility and a
+        // uniform correlation; held positions are kept
+        if (new_symbols) {
+            rebuild_var_model();
         }
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
-        latency_tracker_.record_latency(duration);
-        
-        return approved;
+        state_.var_1d = var_->var(1);
     }
-    
-    void update_position(const std::string& symbol, double position_value) {
-        // Update position tracking
-        // TODO: Implement detailed position tracking
-        metrics_.current_portfolio_value = position_value;
+
+    void rebuild_var_model() {
+        model_symbols_.clear();
+        for (const auto& [symbol_id, symbol] : symbols_) model_symbols_.push_back(symbol_id);
+        const size_t n = model_symbols_.size();
+        std::vector<double> volatilities(n, daily_volatility_);
+        std::vector<double> correlation(n * n, correlation_);
+        for (size_t i = 0; i < n; ++i) correlation[i * n + i] = 1.0;
+        var_->set_model(model_symbols_, volatilities, correlation);
+        for (const auto& [symbol_id, symbol] : symbols_) {
+            if (symbol.price > 0.0) var_->set_position(symbol_id, symbol.quantity, symbol.price);
+        }
     }
-    
-    void update_pnl(double realized_pnl, double unrealized_pnl) {
-        metrics_.daily_realized_pnl = realized_pnl;
-        metrics_.daily_unrealized_pnl = unrealized_pnl;
-        metrics_.daily_pnl = realized_pnl + unrealized_pnl;
+
+    // O(1) limits, after every poll that changed something
+    void check_portfolio() {
+        if (state_.daily_pnl() < -limits_.max_daily_loss * 0.8 && !loss_warned_) {
+            LOG_WARN("Daily loss approaching limit: {:.2f} INR ({:.1f}% of limit)",
+                    state_.daily_pnl(), 100.0 * state_.daily_pnl() / -limits_.max_daily_loss);
+            loss_warned_ = true;
+        }
+        if (state_.daily_pnl() < -limits_.max_daily_loss && !state_.emergency_stop) {
+            LOG_ERROR("EMERGENCY STOP: Daily loss limit breached! P&L {:.2f} INR", state_.daily_pnl());
+            state_.emergency_stop = true;
+        }
+        alert(gross_breached_, state_.gross_exposure > limits_.max_portfolio_value,
+              "Portfolio exposure", state_.gross_exposure, limits_.max_portfolio_value);
+        alert(var_breached_, state_.var_1d > limits_.max_var_1d,
+              "1-day VaR", state_.var_1d, limits_.max_var_1d);
     }
-    
-private:
-    void monitoring_loop() {
-        LOG_INFO("Risk monitoring thread started");
-        
-        auto last_rate_reset = std::chrono::steady_clock::now();
-        
-        while (g_running) {
-            // Calculate message and order rates
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                now - last_rate_reset).count();
-            
-            if (elapsed >= 1) {
-                // Reset rate counters every second
-                metrics_.current_order_rate = 0;
-                metrics_.current_message_rate = 0;
-                last_rate_reset = now;
+
+    // Every 100ms: figures that scan every symbol, feed health
+    void housekeeping() {
+        double largest = 0.0;
+        for (const auto& [symbol_id, symbol] : symbols_) largest = std::max(largest, std::abs(symbol.exposure));
+        state_.largest_symbol_share = state_.gross_exposure > 0.0 ? largest / state_.gross_exposure : 0.0;
+        alert(concentration_breached_, state_.largest_symbol_share > limits_.position_concentration,
+              "Symbol concentration", state_.largest_symbol_share, limits_.position_concentration);
+
+        const auto staleness = reader_->staleness();
+        const bool silent = staleness.heartbeat_age_ns > limits_.max_heartbeat_age_ms * 1000000;
+        if (silent && !reader_->writer_alive()) {
+            detach();
+            return;
+        }
+        if (silent != heartbeat_warned_) {
+            if (silent) {
+                LOG_ERROR("Position feed stale: no heartbeat from the engine for {} ms",
+                          staleness.heartbeat_age_ns / 1000000);
+            } else {
+                LOG_INFO("Position feed heartbeat recovered");
             }
-            
-            // Monitor system resources
-            monitor_system_resources();
-            
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            heartbeat_warned_ = silent;
         }
-        
-        LOG_INFO("Risk monitoring thread stopped");
+        publish_metrics(staleness);
     }
-    
-    void perform_risk_checks() {
-        // Continuous risk monitoring
-        
-        // Check daily loss limit
-        if (metrics_.daily_pnl < -limits_.max_daily_loss * 0.8) {
-            LOG_WARN("Daily loss approaching limit: {:.2f} INR ({:.1f}% of limit)",
-                    metrics_.daily_pnl.load(), 
-                    100.0 * metrics_.daily_pnl / -limits_.max_daily_loss);
-        }
-        
-        // Check portfolio concentration
-        // TODO: Implement position concentration checks
-        
-        // Check rate limits
-        if (metrics_.current_order_rate > limits_.max_order_rate * 0.9) {
-            LOG_WARN("Order rate approaching limit: {} orders/sec",
-                    metrics_.current_order_rate.load());
+
+    void alert(bool& active, bool breached, const char* what, double value, double limit) {
+        if (breached && !active) {
+            LOG_ERROR("{} limit breached: {:.2f} (limit {:.2f})", what, value, limit);
+        } else if (!breached && active) {
+            LOG_INFO("{} back within limit: {:.2f} (limit {:.2f})", what, value, limit);
         }
+        active = breached;
     }
-    
-    void check_emergency_conditions() {
-        // Check for conditions requiring emergency stop
-        
-        // Extreme daily loss
-        if (metrics_.daily_pnl < -limits_.max_daily_loss) {
-            LOG_ERROR("EMERGENCY STOP: Daily loss limit breached!");
-            metrics_.emergency_stop = true;
-            metrics_.trading_enabled = false;
+
+    void idle() {
+        if (poll_interval_us_ > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(poll_interval_us_));
+        } else {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
         }
-        
-        // System resource issues
-        // TODO: Add CPU, memory, network checks
-        
-        // Market anomalies
-        // TODO: Add market anomaly detection
     }
-    
-    void monitor_system_resources() {
-        // Monitor CPU, memory, disk, network
-        // TODO: Implement actual resource monitoring
+
+    void register_metrics() {
+        using core::StatsSegment;
+        metric_heartbeat_age_ = StatsSegment::gauge("risk_monitor_heartbeat_age_us", "Since the engine's last position feed heartbeat");
+        metric_view_age_ = StatsSegment::gauge("risk_monitor_view_age_us", "Since a poll last applied the whole change journal");
+        metric_record_age_ = StatsSegment::gauge("risk_monitor_record_age_us", "Publish to observe, worst of the last interval's polls");
+        metric_record_age_max_ = StatsSegment::gauge("risk_monitor_record_age_max_us", "Publish to observe, worst since attach");
+        metric_record_age_mean_ = StatsSegment::gauge("risk_monitor_record_age_mean_us", "Publish to observe, mean since attach");
+        metric_journal_lag_ = StatsSegment::gauge("risk_monitor_journal_lag", "Journal entries published but not yet applied");
+        metric_records_ = StatsSegment::counter("risk_monitor_records_total", "Position records read");
+        metric_retries_ = StatsSegment::counter("risk_monitor_seqlock_retries_total", "Record reads that raced a write");
+        metric_overruns_ = StatsSegment::counter("risk_monitor_overruns_total", "Full rereads after falling a journal behind");
+        metric_gross_exposure_ = StatsSegment::gauge("risk_monitor_gross_exposure", "Gross exposure, INR");
+        metric_daily_pnl_ = StatsSegment::gauge("risk_monitor_daily_pnl", "Realized plus unrealized P&L, INR");
+        metric_var_ = StatsSegment::gauge("risk_monitor_var_1d", "Parametric 95% 1-day VaR, INR");
+        metric_positions_ = StatsSegment::gauge("risk_monitor_active_positions", "Open positions");
     }
-    
+
+    void publish_metrics(const trading::PositionFeedReader::Staleness& staleness) {
+        namespace stats = core::stats;
+        stats::set(metric_heartbeat_age_, staleness.heartbeat_age_ns / 1000.0);
+        stats::set(metric_view_age_, staleness.view_age_ns / 1000.0);
+        stats::set(metric_record_age_max_, staleness.max_record_age_ns / 1000.0);
+        stats::set(metric_record_age_mean_, staleness.mean_record_age_ns / 1000.0);
+        stats::set(metric_journal_lag_, static_cast<double>(staleness.journal_lag));
+        // The last poll's worst is usually an idle poll's zero; report the interval's
+        stats::set(metric_record_age_, interval_record_age_ns_ / 1000.0);
+        interval_record_age_ns_ = 0;
+        stats::add(metric_records_, staleness.records_read - last_staleness_.records_read);
+        stats::add(metric_retries_, staleness.seqlock_retries - last_staleness_.seqlock_retries);
+        stats::add(metric_overruns_, staleness.overruns - last_staleness_.overruns);
+        stats::set(metric_gross_exposure_, state_.gross_exposure);
+        stats::set(metric_daily_pnl_, state_.daily_pnl());
+        stats::set(metric_var_, state_.var_1d);
+        stats::set(metric_positions_, state_.active_positions);
+        last_staleness_ = staleness;
+    }
+
     void generate_risk_report() {
         std::cout << "\n=== Risk Monitor Report ===" << std::endl;
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
         std::cout << "Timestamp: " << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S") << std::endl;
         std::cout << "\nPortfolio Metrics:" << std::endl;
-        std::cout << "  Portfolio Value: " << std::fixed << std::setprecision(2) 
-                  << metrics_.current_portfolio_value.load() << " INR" << std::endl;
-        std::cout << "  Active Positions: " << metrics_.active_positions.load() << std::endl;
+        std::cout << "  Gross Exposure: " << std::fixed << std::setprecision(2)
+                  << state_.gross_exposure << " INR" << std::endl;
+        std::cout << "  Active Positions: " << state_.active_positions << std::endl;
+        std::cout << "  Largest Symbol: " << 100.0 * state_.largest_symbol_share << "%" << std::endl;
+        std::cout << "  1-day VaR (95%): " << state_.var_1d << " INR" << std::endl;
         std::cout << "\nDaily P&L:" << std::endl;
-        std::cout << "  Realized: " << metrics_.daily_realized_pnl.load() << " INR" << std::endl;
-        std::cout << "  Unrealized: " << metrics_.daily_unrealized_pnl.load() << " INR" << std::endl;
-        std::cout << "  Total: " << metrics_.daily_pnl.load() << " INR" << std::endl;
+        std::cout << "  Realized: " << state_.realized_pnl << " INR" << std::endl;
+        std::cout << "  Unrealized: " << state_.unrealized_pnl << " INR" << std::endl;
+        std::cout << "  Total: " << state_.daily_pnl() << " INR" << std::endl;
         std::cout << "\nTrading Activity:" << std::endl;
-        std::cout << "  Daily Trades: " << metrics_.daily_trades.load() << std::endl;
-        std::cout << "  Daily Orders: " << metrics_.daily_orders.load() << std::endl;
-        std::cout << "  Rejected Orders: " << metrics_.rejected_orders.load() << std::endl;
-        std::cout << "  Order Rate: " << metrics_.current_order_rate.load() << " orders/sec" << std::endl;
+        std::cout << "  Daily Trades: " << state_.trades << std::endl;
         std::cout << "\nRisk Status:" << std::endl;
-        std::cout << "  Trading Enabled: " << (metrics_.trading_enabled ? "YES" : "NO") << std::endl;
-        std::cout << "  Emergency Stop: " << (metrics_.emergency_stop ? "ACTIVE" : "Inactive") << std::endl;
-        
-        auto latency_stats = latency_tracker_.get_stats();
-        std::cout << "\nRisk Check Latency:" << std::endl;
-        std::cout << "  Average: " << latency_stats.avg_latency_us << " μs" << std::endl;
-        std::cout << "  P99: " << latency_stats.p99_latency_us << " μs" << std::endl;
+        std::cout << "  Emergency Stop: " << (state_.emergency_stop ? "ACTIVE" : "Inactive") << std::endl;
+
+        if (reader_) {
+            const auto staleness = reader_->staleness();
+            std::cout << "\nPosition Feed:" << std::endl;
+            std::cout << "  Heartbeat Age: " << staleness.heartbeat_age_ns / 1000.0 << " μs" << std::endl;
+            std::cout << "  Publish to Observe: " << staleness.mean_record_age_ns / 1000.0 << " μs mean, "
+                      << staleness.max_record_age_ns / 1000.0 << " μs max" << std::endl;
+            std::cout << "  Records Read: " << staleness.records_read << " (" << staleness.overruns
+                      << " overruns, " << staleness.seqlock_retries << " retries)" << std::endl;
+        } else {
+            std::cout << "\nPosition Feed: not attached (" << segment_name_ << ")" << std::endl;
+        }
         std::cout << "========================\n" << std::endl;
     }
-    
+
     void generate_final_report() {
         LOG_INFO("=== Final Risk Monitor Report ===");
-        LOG_INFO("Total Daily P&L: {:.2f} INR", metrics_.daily_pnl.load());
-        LOG_INFO("Total Orders: {} (Rejected: {})", 
-                metrics_.daily_orders.load(), metrics_.rejected_orders.load());
-        LOG_INFO("Rejection Rate: {:.2f}%", 
-                metrics_.daily_orders > 0 ? 
-                100.0 * metrics_.rejected_orders / metrics_.daily_orders : 0.0);
-        
-        auto stats = latency_tracker_.get_stats();
-        LOG_INFO("Risk Check Performance:");
-        LOG_INFO("  Total Checks: {}", stats.count);
-        LOG_INFO("  Average Latency: {:.2f} μs", stats.avg_latency_us);
-        LOG_INFO("  P95 Latency: {:.2f} μs", stats.p95_latency_us);
-        LOG_INFO("  P99 Latency: {:.2f} μs", stats.p99_latency_us);
-        LOG_INFO("  Max Latency: {:.2f} μs", stats.max_latency_us);
+        LOG_INFO("Total Daily P&L: {:.2f} INR", state_.daily_pnl());
+        LOG_INFO("Gross Exposure: {:.2f} INR, 1-day VaR: {:.2f} INR", state_.gross_exposure, state_.var_1d);
+        LOG_INFO("Trades: {}", state_.trades);
+        if (reader_) {
+            const auto staleness = reader_->staleness();
+            LOG_INFO("Position Feed:");
+            LOG_INFO("  Records Read: {}", staleness.records_read);
+            LOG_INFO("  Publish to Observe: {:.2f} μs mean, {:.2f} μs max",
+                     staleness.mean_record_age_ns / 1000.0, staleness.max_record_age_ns / 1000.0);
+            LOG_INFO("  Overruns: {}, Seqlock Retries: {}", staleness.overruns, staleness.seqlock_retries);
+        }
         LOG_INFO("==============================");
     }
-    
+
 private:
     RiskLimits limits_;
-    RiskMetrics metrics_;
-    core::LatencyTracker latency_tracker_;
-    std::thread monitoring_thread_;
+    PortfolioState state_;
+    std::string segment_name_;
+    static constexpr int64_t DEFAULT_POLL_US = 100;
+    int64_t poll_interval_us_ = DEFAULT_POLL_US;
+    double daily_volatility_ = 0.02;
+    double correlation_ = 0.3;
+
+    std::unique_ptr<trading::PositionFeedReader> reader_;
+    std::vector<trading::position_layout::PositionValues> applied_; // By slot, as last applied
+    std::unordered_map<uint64_t, SymbolState> symbols_;
+    std::vector<uint64_t> model_symbols_;
+    std::unique_ptr<risk::IncrementalVaR> var_ = std::make_unique<risk::IncrementalVaR>();
+
+    // Edge-triggered alerts
+    bool attach_warned_ = false;
+    bool loss_warned_ = false;
+    bool gross_breached_ = false;
+    bool var_breached_ = false;
+    bool concentration_breached_ = false;
+    bool heartbeat_warned_ = false;
+
+    trading::PositionFeedReader::Staleness last_staleness_;
+    int64_t interval_record_age_ns_ = 0;
+
+    uint32_t metric_heartbeat_age_ = 0;
+    uint32_t metric_view_age_ = 0;
+    uint32_t metric_record_age_ = 0;
+    uint32_t metric_record_age_max_ = 0;
+    uint32_t metric_record_age_mean_ = 0;
+    uint32_t metric_journal_lag_ = 0;
+    uint32_t metric_records_ = 0;
+    uint32_t metric_retries_ = 0;
+    uint32_t metric_overruns_ = 0;
+    uint32_t metric_gross_exposure_ = 0;
+    uint32_t metric_daily_pnl_ = 0;
+    uint32_t metric_var_ = 0;
+    uint32_t metric_positions_ = 0;
 };
 
 int main(int argc, char* argv[]) {
@@ -312,41 +463,50 @@ int main(int argc, char* argv[]) {
     // utils::Logger::init("goldearn_risk_monitor.log");
     LOG_INFO("Starting GoldEarn Risk Monitor...");
     LOG_INFO("GoldEarn HFT Risk Monitor starting");
-    
+
     // Parse command line arguments
-    std::string config_file = "config/risk_monitor.conf";
-    
+    std::string config_file = "config/production.conf";
+    std::string segment;
+    int64_t poll_us = -1;
+
     for (int i = 1; i < argc; ++i) {
         if (std::string(argv[i]) == "--config" && i + 1 < argc) {
             config_file = argv[++i];
+        } else if (std::string(argv[i]) == "--segment" && i + 1 < argc) {
+            segment = argv[++i];
+        } else if (std::string(argv[i]) == "--poll-us" && i + 1 < argc) {
+            poll_us = std::stoll(argv[++i]);
         } else if (std::string(argv[i]) == "--help") {
             std::cout << "Usage: " << argv[0] << " [options]\n";
             std::cout << "Options:\n";
-            std::cout << "  --config <file>   Configuration file (default: config/risk_monitor.conf)\n";
+            std::cout << "  --config <file>   Configuration file (default: config/production.conf)\n";
+            std::cout << "  --segment <name>  Position segment ([system] position_segment)\n";
+            std::cout << "  --poll-us <us>    Sleep between idle polls; 0 spins and needs [risk_monitor] cpu_affinity\n";
+            std::cout << "                    ([risk_monitor] poll_interval_us, default 100)\n";
             std::cout << "  --help            Show this help message\n";
             return 0;
         }
     }
-    
+
     // Set up signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
-    
+
     // Create and initialize risk monitor
     RiskMonitor monitor;
-    
-    if (!monitor.initialize(config_file)) {
+
+    if (!monitor.initialize(config_file, segment, poll_us)) {
         LOG_ERROR("Failed to initialize risk monitor");
         return 1;
     }
-    
+
     // Run the risk monitor
     LOG_INFO("Risk monitor running, press Ctrl+C to stop");
     monitor.run();
-    
+
     // Shutdown
     monitor.shutdown();
-    
+
     LOG_INFO("GoldEarn HFT Risk Monitor terminated");
     return 0;
-}
\ No newline at end of file
+}
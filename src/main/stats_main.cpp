@@ -0,0 +1,114 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include "../core/stats_segment.hpp"
+
+using namespace goldearn;
+
+// Live view of the shared-memory statistics segment published by a GoldEarn
+// process. Maps the segment read-only: the trading process does no work for
+// it. Shows aggregated totals, per-second rates for counters and, on
+// request, the per-thread breakdown; or prints Prometheus text once.
+
+namespace {
+
+volatile std::sig_atomic_t running = 1;
+
+void handle_signal(int) {
+    running = 0;
+}
+
+void print_view(const core::StatsReader& reader, const std::vector<core::StatsReader::Metric>& metrics,
+                const std::map<std::string, double>& previous, double elapsed_s, bool per_thread) {
+    std::printf("\033[H\033[2J");
+    std::printf("GoldEarn statistics  pid %d (%s)\n\n", static_cast<int>(reader.writer_pid()),
+                reader.writer_alive() ? "running" : "exited");
+    std::printf("%-44s %18s %14s\n", "METRIC", "VALUE", "RATE/s");
+    for (const auto& metric : metrics) {
+        if (metric.kind == core::stats_layout::COUNTER) {
+            auto it = previous.find(metric.name);
+            double rate = it != previous.end() && elapsed_s > 0 ? (metric.total - it->second) / elapsed_s : 0.0;
+            std::printf("%-44s %18.0f %14.1f\n", metric.name.c_str(), metric.total, rate);
+        } else {
+            std::printf("%-44s %18.3f %14s\n", metric.name.c_str(), metric.total, "");
+        }
+        if (per_thread) {
+            for (const auto& [thread, value] : metric.threads) {
+                std::printf("  %-42s %18.3f\n", thread.c_str(), value);
+            }
+        }
+    }
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string name = "goldearn_stats";
+    int interval_ms = 1000;
+    bool prometheus = false;
+    bool per_thread = false;
+    bool once = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--interval" && i + 1 < argc) {
+            interval_ms = std::max(50, std::stoi(argv[++i]));
+        } else if (arg == "--prometheus") {
+            prometheus = true;
+        } else if (arg == "--per-thread") {
+            per_thread = true;
+        } else if (arg == "--once") {
+            once = true;
+        } else if (arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [options] [segment]\n";
+            std::cout << "Options:\n";
+            std::cout << "  --interval <ms>   Refresh interval of the live view (default 1000)\n";
+            std::cout << "  --per-thread      Show per-thread values\n";
+            std::cout << "  --prometheus      Print Prometheus text once and exit\n";
+            std::cout << "  --once            Print one view and exit\n";
+            std::cout << "  --help            Show this help message\n";
+            std::cout << "The segment is a /dev/shm name or a path (default goldearn_stats)\n";
+            return 0;
+        } else {
+            name = arg;
+        }
+    }
+
+    std::unique_ptr<core::StatsReader> reader;
+    try {
+        reader = std::make_unique<core::StatsReader>(name);
+    } catch (const std::exception& e) {
+        std::cerr << "goldearn_stats: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (prometheus) {
+        std::cout << core::StatsReader::to_prometheus(reader->read(), per_thread);
+        return 0;
+    }
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    std::map<std::string, double> previous;
+    auto last = std::chrono::steady_clock::now();
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        auto metrics = reader->read();
+        print_view(*reader, metrics, previous, std::chrono::duration<double>(now - last).count(), per_thread);
+        if (once) break;
+
+        previous.clear();
+        for (const auto& metric : metrics) {
+            previous[metric.name] = metric.total;
+        }
+        last = now;
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+    return 0;
+}
@@ -7,7 +7,15 @@
 #include "../market_data/nse_protocol.hpp"
 #include "../market_data/order_book.hpp"
 #include "../core/latency_tracker.hpp"
+#include "../core/flight_recorder.hpp"
+#include "../core/jitter_monitor.hpp"
+#include "../core/perf_counters.hpp"
+#include "../core/stats_segment.hpp"
+#include "../core/thread_pool.hpp"
 #include "../config/config_manager.hpp"
+#include "../monitoring/health_check.hpp"
+#include "../risk/risk_engine.hpp"
+#include "../trading/position_segment.hpp"
 
 using namespace goldearn;
 
@@ -68,6 +76,21 @@ public:
                 }
             }
             
+            // Hot-path binary log must be mapped before the critical threads start
+            init_fast_log(*config);
+            
+            // Statistics segment for goldearn_stats; hot threads attach when they start
+            init_stats_segment(*config);
+            
+            // Flight recorder rings are sized before any hot thread attaches
+            init_flight_recorder(*config);
+            
+            // Core assignments must be known before any component starts threads
+            init_runtime(*config);
+            
+            // Position feed for goldearn_risk_monitor; its heartbeat runs on the housekeeping pool
+            init_position_segment(*config);
+            
             // Initialize market data
             if (!init_market_data(*config)) {
                 LOG_ERROR("Failed to initialize market data");
@@ -81,11 +104,14 @@ public:
             }
             
             // Initialize risk management
-            if (!init_risk_management()) {
+            if (!init_risk_management(*config)) {
                 LOG_ERROR("Failed to initialize risk management");
                 return false;
             }
             
+            // Health endpoints, and the loopback admin listener for limit changes
+            init_monitoring(*config);
+            
             // Initialize trading strategies
             if (!init_strategies()) {
                 LOG_ERROR("Failed to initialize trading strategies");
@@ -147,10 +173,83 @@ public:
         // Print final statistics
         print_statistics();
         
+        core::JitterMonitor::instance().stop();
+        health_server_.reset(); // Its refreshes run on the housekeeping pool
+        if (risk_engine_) {
+            risk_engine_->shutdown();
+        }
+        position_segment_.reset();
+        core::Runtime::instance().shutdown();
+        
+        core::StatsSegment::close();
         LOG_INFO("Trading engine shutdown complete");
     }
     
 private:
+    void init_fast_log(const config::ConfigManager& config) {
+        std::string path = config.get_string("system", "fast_log_file", "");
+        if (path.empty()) {
+            return; // LOG_FAST falls back to the regular log
+        }
+        size_t size_mb = static_cast<size_t>(config.get_int("system", "fast_log_size_mb", 64));
+        if (utils::Logger::instance().set_fast_log_file(path, size_mb * 1024 * 1024)) {
+            LOG_INFO("Fast log: {} ({} MB, decode with goldearn_fast_log_decode)", path, size_mb);
+        }
+    }
+    
+    void init_stats_segment(const config::ConfigManager& config) {
+        std::string name = config.get_string("system", "stats_segment", "");
+        if (!name.empty() && core::StatsSegment::open(name)) {
+            LOG_INFO("Statistics segment: {} (view with goldearn_stats {})", name, name);
+        }
+    }
+    
+    void init_position_segment(const config::ConfigManager& config) {
+        trading::PositionSegment::Config segment;
+        segment.name = config.get_string("system", "position_segment", "");
+        if (segment.name.empty()) {
+            return;
+        }
+        segment.capacity = static_cast<uint32_t>(config.get_int("system", "position_segment_capacity", segment.capacity));
+        try {
+            position_segment_ = std::make_shared<trading::PositionSegment>(segment);
+            LOG_INFO("Position segment: {} (read by goldearn_risk_monitor --segment {})", segment.name, segment.name);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Position segment: {}", e.what());
+        }
+    }
+    
+    void init_flight_recorder(const config::ConfigManager& config) {
+        auto& recorder = core::FlightRecorder::instance();
+        recorder.configure(config.get_string("system", "flight_recorder_dir", "."),
+                           static_cast<uint32_t>(config.get_int("system", "flight_recorder_events", 4096)));
+        recorder.install_signal_handlers();
+    }
+    
+    void init_runtime(const config::ConfigManager& config) {
+        core::Runtime::Config runtime_config;
+        runtime_config.housekeeping_cores =
+            core::parse_core_list(config.get_string("runtime", "housekeeping_cores", ""));
+        runtime_config.housekeeping_threads =
+            static_cast<size_t>(config.get_int("runtime", "housekeeping_threads", 2));
+        runtime_config.critical_cores = core::Runtime::Config::parse_critical_cores(
+            config.get_string("runtime", "critical_cores", ""));
+        runtime_config.hot_thread_counters = config.get_bool("runtime", "hot_thread_counters", false);
+        runtime_config.jitter_spin_threads = config.get_bool("runtime", "jitter_spin_threads", false);
+        core::Runtime::instance().configure(runtime_config);
+        
+        // Before any critical thread exists, so their probes use the configured threshold
+        core::JitterMonitor::Config jitter_config;
+        jitter_config.cores = core::parse_core_list(config.get_string("runtime", "jitter_cores", ""));
+        jitter_config.threshold_ns = static_cast<uint64_t>(config.get_int("runtime", "jitter_threshold_ns", 2000));
+        if (runtime_config.jitter_spin_threads || !jitter_config.cores.empty()) {
+            core::JitterMonitor::instance().start(jitter_config);
+        }
+        
+        LOG_INFO("Runtime: {} housekeeping threads, {} critical core assignments",
+                 runtime_config.housekeeping_threads, runtime_config.critical_cores.size());
+    }
+    
     bool init_market_data(const config::ConfigManager& config) {
         nse_parser_ = std::make_unique<market_data::nse::NSEProtocolParser>();
         
@@ -199,17 +298,49 @@ private:
         return true;
     }
     
-    bool init_risk_management() {
+    bool init_risk_management(config::ConfigManager& config) {
+        risk_engine_ = std::make_unique<risk::RiskEngine>();
+        if (!risk_engine_->initialize()) {
+            return false;
+        }
+        size_t applied = risk_engine_->load_risk_limits(config);
+        
         // Initialize risk parameters
         max_position_value_ = 10000000.0;  // 10M INR
         max_daily_loss_ = 500000.0;        // 500K INR
         current_daily_pnl_ = 0.0;
         
-        LOG_INFO("Risk management initialized - Max position: {}, Max daily loss: {}", 
-                 max_position_value_, max_daily_loss_);
+        LOG_INFO("Risk management initialized - Max position: {}, Max daily loss: {}, {} limits from config (version {})", 
+                 max_position_value_, max_daily_loss_, applied, risk_engine_->get_limits_version());
         return true;
     }
     
+    void init_monitoring(const config::ConfigManager& config) {
+        int port = config.get_int("monitoring", "health_check_port", 0);
+        if (port <= 0) {
+            return;
+        }
+        health_server_ = std::make_unique<monitoring::HealthCheckServer>(static_cast<uint16_t>(port));
+        
+        // Intraday limit changes: POST /admin/risk_limits, from this host only
+        int admin_port = config.get_int("monitoring", "admin_port", 0);
+        if (admin_port > 0) {
+            health_server_->set_limit_update_handler(
+                static_cast<uint16_t>(admin_port),
+                [this](const std::vector<std::pair<std::string, double>>& updates) {
+                    return risk_engine_->update_risk_limits(updates);
+                });
+        }
+        if (!health_server_->start()) {
+            LOG_ERROR("Health check server failed to start on port {}", port);
+            health_server_.reset();
+            return;
+        }
+        if (admin_port > 0) {
+            LOG_INFO("Risk limit admin: POST http://127.0.0.1:{}/admin/risk_limits?<name>=<value>", admin_port);
+        }
+    }
+    
     bool init_strategies() {
         // Initialize trading strategies
         // TODO: Load actual strategy implementations
@@ -274,10 +405,13 @@ private:
         LOG_INFO("  P95: {:.2f} μs", latency_stats.p95_latency_us);
         LOG_INFO("  P99: {:.2f} μs", latency_stats.p99_latency_us);
         LOG_INFO("  Max: {:.2f} μs", latency_stats.max_latency_us);
+        core::PerfCounters::instance().log_report();
+        core::JitterMonitor::instance().log_report();
         LOG_INFO("================================");
     }
     
     void handle_trade_message(const market_data::MessageHeader& header, const void* data) {
+        PERF_REGION(core::perf_region::STRATEGY_CALLBACK);
         auto start = std::chrono::high_resolution_clock::now();
         
         // Process trade message
@@ -289,6 +423,7 @@ private:
     }
     
     void handle_quote_message(const market_data::MessageHeader& header, const void* data) {
+        PERF_REGION(core::perf_region::STRATEGY_CALLBACK);
         auto start = std::chrono::high_resolution_clock::now();
         
         // Process quote message
@@ -304,13 +439,20 @@ private:
     std::unique_ptr<market_data::nse::NSEProtocolParser> nse_parser_;
     std::unordered_map<std::string, std::unique_ptr<market_data::OrderBook>> order_books_;
     
+    // Live positions for the out-of-process risk monitor
+    std::shared_ptr<trading::PositionSegment> position_segment_;
+    
     // Risk management
+    std::unique_ptr<risk::RiskEngine> risk_engine_;
     double max_position_value_;
     double max_daily_loss_;
     std::atomic<double> current_daily_pnl_;
     
     // Performance tracking
     core::LatencyTracker latency_tracker_;
+    
+    // Declared last: its admin handler calls into the risk engine
+    std::unique_ptr<monitoring::HealthCheckServer> health_server_;
 };
 
 int main(int argc, char* argv[]) {
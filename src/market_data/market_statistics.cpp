@@ -0,0 +1,297 @@
+#include "market_statistics.hpp"
+#include "../utils/vector_math.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::market_data {
+
+MarketStatistics::MarketStatistics(const Config& config)
+    : config_(config)
+    , n_(config.universe.size())
+    , tiles_per_side_((config.universe.size() + TILE - 1) / TILE)
+    , prices_(std::make_unique<std::atomic<double>[]>(config.universe.size())) {
+    if (!(config.lambda > 0.0 && config.lambda < 1.0)) {
+        throw std::invalid_argument("MarketStatistics: lambda must be in (0, 1)");
+    }
+    if (config.sample_interval.count() <= 0) {
+        throw std::invalid_argument("MarketStatistics: sample interval must be positive");
+    }
+    for (size_t i = 0; i < n_; ++i) {
+        if (!index_.emplace(config.universe[i], static_cast<uint32_t>(i)).second) {
+            throw std::invalid_argument("MarketStatistics: symbol listed twice in the universe");
+        }
+        prices_[i].store(0.0, std::memory_order_relaxed);
+    }
+
+    const size_t padded = tiles_per_side_ * TILE;
+    for (Buffer& buffer : buffers_) {
+        buffer.tiles.assign(tile_offset(tiles_per_side_, 0), 0.0);
+        buffer.volatility.assign(n_, 0.0);
+    }
+    previous_.assign(n_, 0.0);
+    returns_.assign(padded, 0.0);
+    scaled_.assign(padded, 0.0);
+    LOG_INFO("MarketStatistics: {} symbols, {}ms samples, lambda {}", n_, config.sample_interval.count(),
+             config.lambda);
+}
+
+MarketStatistics::~MarketStatistics() {
+    stop();
+}
+
+uint32_t MarketStatistics::index(uint64_t symbol_id) const {
+    auto it = index_.find(symbol_id);
+    return it != index_.end() ? it->second : INVALID_INDEX;
+}
+
+void MarketStatistics::on_price(uint64_t symbol_id, double price) {
+    auto it = index_.find(symbol_id);
+    if (it != index_.end() && price > 0.0) {
+        prices_[it->second].store(price, std::memory_order_relaxed);
+    }
+}
+
+void MarketStatistics::on_trade(const TradeMessage& trade) {
+    on_price(trade.symbol_id, trade.price);
+}
+
+void MarketStatistics::on_quote(const QuoteMessage& quote) {
+    const double bid = quote.bid_price;
+    const double ask = quote.ask_price;
+    if (bid > 0.0 && ask > 0.0) {
+        on_price(quote.symbol_id, 0.5 * (bid + ask));
+    } else {
+        on_price(quote.symbol_id, std::max(bid, ask));
+    }
+}
+
+void MarketStatistics::start() {
+    if (sample_task_id_ != 0) {
+        return;
+    }
+    sample_task_id_ = core::Runtime::instance().background().schedule_periodic(
+        config_.sample_interval, [this]() { sample(); }, "market_statistics");
+    LOG_INFO("MarketStatistics: Sampling started");
+}
+
+void MarketStatistics::stop() {
+    if (sample_task_id_ == 0) {
+        return;
+    }
+    core::Runtime::instance().cancel(sample_task_id_);
+    sample_task_id_ = 0;
+    LOG_INFO("MarketStatistics: Sampling stopped");
+}
+
+void MarketStatistics::sample() {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+
+    // Price ratios since the last sample; 1 (no return) where either end is missing
+    size_t moved = 0;
+    for (size_t i = 0; i < n_; ++i) {
+        const double price = prices_[i].load(std::memory_order_relaxed);
+        if (price > 0.0 && previous_[i] > 0.0) {
+            returns_[i] = price / previous_[i];
+            ++moved;
+        } else {
+            returns_[i] = 1.0;
+        }
+        if (price > 0.0) {
+            previous_[i] = price;
+        }
+    }
+    if (moved == 0) {
+        return; // First prices only; nothing to learn from yet
+    }
+    std::fill(returns_.begin() + n_, returns_.end(), 1.0);
+
+    const double weight_new = 1.0 - config_.lambda;
+    size_t i = 0;
+#ifdef __AVX2__
+    for (; i < returns_.size(); i += 4) {
+        __m256d r = utils::vmath::log(_mm256_loadu_pd(&returns_[i]));
+        _mm256_storeu_pd(&returns_[i], r);
+        _mm256_storeu_pd(&scaled_[i], _mm256_mul_pd(r, _mm256_set1_pd(weight_new)));
+    }
+#endif
+    for (; i < returns_.size(); ++i) {
+        returns_[i] = std::log(returns_[i]);
+        scaled_[i] = weight_new * returns_[i];
+    }
+
+    // Write the unpublished copy from the published one, then flip
+    const uint32_t published = published_.load();
+    const Buffer& from = buffers_[published];
+    Buffer& to = buffers_[published ^ 1];
+    while (to.readers.load() != 0) {
+        std::this_thread::yield();
+    }
+    rank_one_update(from, to);
+    to.samples = from.samples + 1;
+    to.weight = 1.0 - (1.0 - from.weight) * config_.lambda;
+    for (uint32_t k = 0; k < n_; ++k) {
+        to.volatility[k] = std::sqrt(std::max(element(to, k, k), 0.0) / to.weight);
+    }
+    published_.store(published ^ 1);
+
+    const uint64_t elapsed = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    ++stats_.samples;
+    stats_.last_update_ns = elapsed;
+    stats_.max_update_ns = std::max(stats_.max_update_ns, elapsed);
+}
+
+// to = lambda from + (1 - lambda) r r', tile by tile in storage order. Diagonal
+// tiles are updated whole; their upper halves are never read.
+void MarketStatistics::rank_one_update(const Buffer& from, Buffer& to) const {
+    const double lambda = config_.lambda;
+    const double* source = from.tiles.data();
+    double* target = to.tiles.data();
+    for (size_t tile_row = 0; tile_row < tiles_per_side_; ++tile_row) {
+        const double* scaled = scaled_.data() + tile_row * TILE;
+        for (size_t tile_col = 0; tile_col <= tile_row; ++tile_col) {
+            const double* columns = returns_.data() + tile_col * TILE;
+#ifdef __AVX2__
+            const __m256d decay = _mm256_set1_pd(lambda);
+            for (size_t row = 0; row < TILE; ++row, source += TILE, target += TILE) {
+                const __m256d a = _mm256_set1_pd(scaled[row]);
+                for (size_t c = 0; c < TILE; c += 4) {
+                    __m256d decayed = _mm256_mul_pd(decay, _mm256_loadu_pd(source + c));
+                    _mm256_storeu_pd(target + c, utils::vmath::fmadd(a, _mm256_loadu_pd(columns + c), decayed));
+                }
+            }
+#else
+            for (size_t row = 0; row < TILE; ++row, source += TILE, target += TILE) {
+                const double a = scaled[row];
+                for (size_t c = 0; c < TILE; ++c) {
+                    target[c] = lambda * source[c] + a * columns[c];
+                }
+            }
+#endif
+        }
+    }
+}
+
+double MarketStatistics::element(const Buffer& buffer, uint32_t i, uint32_t j) {
+    if (i < j) {
+        std::swap(i, j);
+    }
+    return buffer.tiles[tile_offset(i / TILE, j / TILE) + (i % TILE) * TILE + j % TILE];
+}
+
+MarketStatistics::Snapshot MarketStatistics::snapshot() const {
+    for (;;) {
+        const uint32_t published = published_.load();
+        Buffer& buffer = buffers_[published];
+        buffer.readers.fetch_add(1);
+        // sample() may have flipped and started overwriting this copy meanwhile
+        if (published_.load() == published) {
+            return Snapshot(this, &buffer);
+        }
+        buffer.readers.fetch_sub(1);
+    }
+}
+
+MarketStatistics::Stats MarketStatistics::get_stats() const {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    return stats_;
+}
+
+MarketStatistics::Snapshot::Snapshot(Snapshot&& other) noexcept : owner_(other.owner_), buffer_(other.buffer_) {
+    other.buffer_ = nullptr;
+}
+
+MarketStatistics::Snapshot& MarketStatistics::Snapshot::operator=(Snapshot&& other) noexcept {
+    if (this != &other) {
+        if (buffer_) {
+            buffer_->readers.fetch_sub(1);
+        }
+        owner_ = other.owner_;
+        buffer_ = other.buffer_;
+        other.buffer_ = nullptr;
+    }
+    return *this;
+}
+
+MarketStatistics::Snapshot::~Snapshot() {
+    if (buffer_) {
+        buffer_->readers.fetch_sub(1);
+    }
+}
+
+uint64_t MarketStatistics::Snapshot::samples() const {
+    return buffer_->samples;
+}
+
+double MarketStatistics::Snapshot::covariance(uint32_t i, uint32_t j) const {
+    return buffer_->samples == 0 ? 0.0 : element(*buffer_, i, j) / buffer_->weight;
+}
+
+double MarketStatistics::Snapshot::volatility(uint32_t i) const {
+    return buffer_->volatility[i];
+}
+
+double MarketStatistics::Snapshot::correlation(uint32_t i, uint32_t j) const {
+    const double scale = buffer_->volatility[i] * buffer_->volatility[j];
+    if (scale <= 0.0) {
+        return 0.0;
+    }
+    if (i == j) {
+        return 1.0;
+    }
+    return std::clamp(covariance(i, j) / scale, -1.0, 1.0);
+}
+
+double MarketStatistics::Snapshot::correlation(uint64_t symbol1, uint64_t symbol2) const {
+    const uint32_t i = owner_->index(symbol1);
+    const uint32_t j = owner_->index(symbol2);
+    if (i == INVALID_INDEX || j == INVALID_INDEX) {
+        return 0.0;
+    }
+    return correlation(i, j);
+}
+
+CorrelationMap MarketStatistics::Snapshot::correlations(const std::vector<uint64_t>& symbols) const {
+    std::vector<std::pair<uint64_t, uint32_t>> known;
+    for (uint64_t symbol_id : symbols) {
+        const uint32_t i = owner_->index(symbol_id);
+        if (i != INVALID_INDEX) {
+            known.emplace_back(symbol_id, i);
+        }
+    }
+    CorrelationMap result;
+    result.reserve(known.size() * (known.size() - (known.empty() ? 0 : 1)) / 2);
+    for (size_t a = 0; a < known.size(); ++a) {
+        for (size_t b = a + 1; b < known.size(); ++b) {
+            if (known[a].first != known[b].first) {
+                result[{known[a].first, known[b].first}] = correlation(known[a].second, known[b].second);
+            }
+        }
+    }
+    return result;
+}
+
+void MarketStatistics::Snapshot::covariance_matrix(std::vector<double>& out, double scale) const {
+    const size_t n = owner_->n_;
+    out.assign(n * n, 0.0);
+    if (buffer_->samples == 0) {
+        return;
+    }
+    const double factor = scale / buffer_->weight;
+    for (uint32_t i = 0; i < n; ++i) {
+        for (uint32_t j = 0; j <= i; ++j) {
+            const double value = element(*buffer_, i, j) * factor;
+            out[i * n + j] = value;
+            out[j * n + i] = value;
+        }
+    }
+}
+
+} // namespace goldearn::market_data
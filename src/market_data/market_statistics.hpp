@@ -0,0 +1,157 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "../core/thread_pool.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace goldearn::market_data {
+
+// Symbol pair -> correlation. Either order of a pair may be stored; pairs
+// that are missing are taken as uncorrelated.
+struct SymbolPairHash {
+    size_t operator()(const std::pair<uint64_t, uint64_t>& pair) const {
+        uint64_t hash = pair.first * 0x9E3779B97F4A7C15ULL ^ pair.second;
+        hash ^= hash >> 31;
+        hash *= 0xBF58476D1CE4E5B9ULL;
+        return hash ^ (hash >> 29);
+    }
+};
+using CorrelationMap = std::unordered_map<std::pair<uint64_t, uint64_t>, double, SymbolPairHash>;
+
+// EWMA volatilities and covariances over a fixed universe, shared by the
+// strategies and the risk engine instead of each keeping price histories.
+//
+// Ticks only store the last price per symbol (lock-free, O(1)). Every
+// sample_interval, sample() takes log returns r against the previous sample
+// and applies S = lambda S + (1 - lambda) r r'. The lower triangle of S is
+// kept in TILE x TILE blocks, each contiguous, so the rank-1 update streams
+// through memory once with r's two tiles in L1.
+//
+// There are two copies of S: sample() reads the published one and writes
+// the other, then flips. A Snapshot pins the published copy, so readers
+// always see one whole sample and never block sample() beyond their own
+// lifetime. Keep snapshots short; copy out anything needed for longer.
+//
+// S starts at zero, so its figures are divided by 1 - lambda^samples.
+// Volatilities and covariances are per sample interval; symbols that have
+// not ticked count as unchanged.
+class MarketStatistics {
+    struct Buffer;
+
+public:
+    static constexpr size_t TILE = 32;
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    struct Config {
+        std::vector<uint64_t> universe;
+        std::chrono::milliseconds sample_interval{100};
+        double lambda = 0.94; // Decay per sample
+    };
+
+    struct Stats {
+        uint64_t samples = 0;
+        uint64_t last_update_ns = 0; // Returns, rank-1 update and publish
+        uint64_t max_update_ns = 0;
+    };
+
+    // Read-only view of one sample's matrix; indices are universe positions
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&& other) noexcept;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot();
+
+        uint64_t samples() const;
+        size_t dimension() const { return owner_->n_; }
+        uint32_t index(uint64_t symbol_id) const { return owner_->index(symbol_id); }
+
+        double covariance(uint32_t i, uint32_t j) const;
+        double volatility(uint32_t i) const;
+        double correlation(uint32_t i, uint32_t j) const;
+        // By symbol: 0 when either is outside the universe or has no variance yet
+        double correlation(uint64_t symbol1, uint64_t symbol2) const;
+        // Every pair of `symbols` inside the universe, each pair stored once
+        CorrelationMap correlations(const std::vector<uint64_t>& symbols) const;
+        // Dense row-major n x n, times `scale` (e.g. samples per day)
+        void covariance_matrix(std::vector<double>& out, double scale = 1.0) const;
+
+    private:
+        friend class MarketStatistics;
+        Snapshot(const MarketStatistics* owner, Buffer* buffer) : owner_(owner), buffer_(buffer) {}
+
+        const MarketStatistics* owner_;
+        Buffer* buffer_;
+    };
+
+    explicit MarketStatistics(const Config& config);
+    ~MarketStatistics();
+
+    MarketStatistics(const MarketStatistics&) = delete;
+    MarketStatistics& operator=(const MarketStatistics&) = delete;
+
+    // Tick side, any thread
+    void on_trade(const TradeMessage& trade);
+    void on_quote(const QuoteMessage& quote);
+    void on_price(uint64_t symbol_id, double price);
+
+    // Runs sample() every sample_interval on the background pool
+    void start();
+    void stop();
+    // One interval: returns since the last call, rank-1 update, publish
+    void sample();
+
+    Snapshot snapshot() const;
+    double correlation(uint64_t symbol1, uint64_t symbol2) const { return snapshot().correlation(symbol1, symbol2); }
+
+    size_t dimension() const { return n_; }
+    uint32_t index(uint64_t symbol_id) const;
+    const std::vector<uint64_t>& universe() const { return config_.universe; }
+    std::chrono::milliseconds sample_interval() const { return config_.sample_interval; }
+    Stats get_stats() const;
+
+private:
+    struct Buffer {
+        std::vector<double> tiles;      // Lower-triangle tiles, tile row by tile row
+        std::vector<double> volatility; // Debiased, per universe position
+        uint64_t samples = 0;
+        double weight = 0.0;            // 1 - lambda^samples
+        std::atomic<uint32_t> readers{0};
+    };
+
+    Config config_;
+    size_t n_;
+    size_t tiles_per_side_;
+    std::unordered_map<uint64_t, uint32_t> index_; // Fixed after construction
+
+    std::unique_ptr<std::atomic<double>[]> prices_; // Last tick
+
+    mutable std::array<Buffer, 2> buffers_;
+    std::atomic<uint32_t> published_{0};
+
+    // Sampler side
+    mutable std::mutex sample_mutex_;
+    std::vector<double> previous_; // Prices at the last sample
+    std::vector<double> returns_;  // Padded to whole tiles
+    std::vector<double> scaled_;   // (1 - lambda) r
+    Stats stats_;
+    core::TaskId sample_task_id_ = 0;
+
+    static size_t tile_offset(size_t tile_row, size_t tile_col) {
+        return (tile_row * (tile_row + 1) / 2 + tile_col) * TILE * TILE;
+    }
+    static double element(const Buffer& buffer, uint32_t i, uint32_t j);
+    void rank_one_update(const Buffer& from, Buffer& to) const;
+};
+
+} // namespace goldearn::market_data
@@ -1,4 +1,8 @@
 #include "nse_protocol.hpp"
+#include "../core/flight_recorder.hpp"
+#include "../core/perf_counters.hpp"
+#include "../core/stats_segment.hpp"
+#include "../core/thread_pool.hpp"
 #include "../utils/simple_logger.hpp"
 #include <cstring>
 #include <algorithm>
@@ -38,6 +42,10 @@ constexpr size_t MAX_SYMBOL_LENGTH = 32;
 constexpr double MAX_PRICE = 999999.99;
 constexpr uint64_t MAX_QUANTITY = 99999999999ULL;
 
+// Shared-memory statistics (written only by the receiver thread)
+const uint32_t STAT_MESSAGES = core::StatsSegment::counter("goldearn_feed_messages_total", "NSE messages dispatched");
+const uint32_t STAT_BYTES = core::StatsSegment::counter("goldearn_feed_bytes_total", "NSE feed bytes received");
+
 NSEProtocolParser::NSEProtocolParser() 
     : state_(ParserState::WAITING_HEADER), buffer_(nullptr), buffer_pos_(0), 
       expected_message_size_(0), messages_processed_(0), parse_errors_(0) {
@@ -158,6 +166,7 @@ size_t NSEProtocolParser::parse_buffer(const uint8_t* data, size_t length) {
                 // Dispatch message
                 dispatch_message(header, buffer_ + sizeof(MessageHeader));
                 messages_processed_++;
+                core::stats::add(STAT_MESSAGES);
                 
                 reset_parser_state();
                 break;
@@ -299,6 +308,13 @@ bool NSEProtocolParser::validate_message(const MessageHeader& header, const uint
 void NSEProtocolParser::dispatch_message(const MessageHeader& header, const uint8_t* payload) {
     switch (header.msg_type) {
         case MessageType::TRADE: {
+            // Symbol, price and quantity straight from the wire layout
+            uint64_t symbol_id, quantity;
+            double price;
+            std::memcpy(&symbol_id, payload, sizeof(symbol_id));
+            std::memcpy(&price, payload + 16, sizeof(price));
+            std::memcpy(&quantity, payload + 24, sizeof(quantity));
+            core::flight::tick(be64toh(symbol_id), price, be64toh(quantity));
             if (trade_callback_) {
                 trade_callback_(header, payload);
             }
@@ -617,6 +633,11 @@ void NSEProtocolParser::reset_parser_state() {
 
 void NSEProtocolParser::receive_thread_func() {
     LOG_INFO("NSEProtocolParser: Receiver thread started");
+    if (core::Runtime::instance().get_config().hot_thread_counters) {
+        core::PerfCounters::instance().register_thread("feed_handler");
+    }
+    core::StatsSegment::attach_thread("feed_handler");
+    core::FlightRecorder::instance().attach_thread("feed_handler");
     
     uint8_t recv_buffer[4096];
     
@@ -665,6 +686,8 @@ void NSEProtocolParser::receive_thread_func() {
         //     continue;
         // }
         
+        core::stats::add(STAT_BYTES, static_cast<uint64_t>(bytes_received));
+        
         // Parse received data
         size_t parsed = parse_buffer(recv_buffer, bytes_received);
         if (parsed < static_cast<size_t>(bytes_received)) {
@@ -0,0 +1,589 @@
+#include "volatility_surface.hpp"
+#include "../utils/vector_math.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::market_data {
+
+namespace {
+
+constexpr double NS_PER_DAY = 86400e9;
+constexpr size_t MAX_NEWTON_ITERATIONS = 40;
+constexpr double MAX_STDDEV = 10.0;      // vol sqrt(T) bracket: 1000% over a year
+constexpr double STEP_TOLERANCE = 1e-13; // Relative change in vol sqrt(T)
+constexpr double TINY = 1e-300;
+
+// Normalized out-of-the-money price theta (e^(x/2) N(theta d1) - e^(-x/2) N(theta d2))
+double normalized_price(double x, double s, double theta, double half, double inv_half) {
+    const double d1 = x / s + 0.5 * s;
+    const double d2 = d1 - s;
+    return theta * (half * utils::vmath::norm_cdf(theta * d1) - inv_half * utils::vmath::norm_cdf(theta * d2));
+}
+
+// One option; same steps as the AVX2 lanes
+double solve_one(double forward, double strike, double tau, double sign, double price, double guess, double& vega,
+                 size_t& iterations) {
+    vega = 0.0;
+    if (!(forward > 0.0 && strike > 0.0 && tau > 0.0 && price > 0.0)) {
+        return 0.0;
+    }
+    const double x = std::log(forward / strike);
+    const double half = std::exp(0.5 * x);
+    const double inv_half = 1.0 / half;
+    double theta = sign;
+    double beta = price / std::sqrt(forward * strike);
+    if (theta * x > 0.0) {
+        beta -= theta * (half - inv_half); // In the money: the out-of-the-money side by parity
+        theta = -theta;
+    }
+    if (!(beta > 0.0 && beta < (theta > 0.0 ? half : inv_half))) {
+        return 0.0;
+    }
+
+    const double ln_beta = std::log(beta);
+    const double sqrt_t = std::sqrt(tau);
+    double s = guess > 0.0 ? guess * sqrt_t : std::max(std::sqrt(2.0 * std::abs(x)), 2.5066282746310002 * beta);
+    double lo = 0.0, hi = MAX_STDDEV;
+    s = std::min(s, 0.5 * MAX_STDDEV);
+    for (size_t i = 0; i < MAX_NEWTON_ITERATIONS; ++i) {
+        ++iterations;
+        const double b = std::max(normalized_price(x, s, theta, half, inv_half), TINY);
+        const double f = std::log(b) - ln_beta;
+        const double d1 = x / s + 0.5 * s;
+        vega = std::max(half * std::exp(-0.5 * d1 * d1) * utils::vmath::INV_SQRT_2PI, TINY);
+        if (f > 0.0) hi = s; else lo = s;
+        double next = s - f * b / vega;
+        if (next <= lo || next >= hi) next = 0.5 * (lo + hi);
+        const bool done = std::abs(next - s) <= STEP_TOLERANCE * s;
+        s = next;
+        if (done) break;
+    }
+    return s / sqrt_t;
+}
+
+#ifdef __AVX2__
+// Four options; lanes that converge keep stepping in place until all have
+size_t solve_four(const double* forward, const double* strike, const double* tau, const double* sign,
+                  const double* price, const double* guess, double* volatility, double* vega) {
+    namespace vm = utils::vmath;
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half_pd = _mm256_set1_pd(0.5);
+    const __m256d tiny = _mm256_set1_pd(TINY);
+    const __m256d sign_bit = _mm256_set1_pd(-0.0);
+
+    __m256d F = _mm256_loadu_pd(forward);
+    __m256d K = _mm256_loadu_pd(strike);
+    __m256d T = _mm256_loadu_pd(tau);
+    __m256d p = _mm256_loadu_pd(price);
+    __m256d valid = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(F, zero, _CMP_GT_OQ), _mm256_cmp_pd(K, zero, _CMP_GT_OQ)),
+                                  _mm256_and_pd(_mm256_cmp_pd(T, zero, _CMP_GT_OQ), _mm256_cmp_pd(p, zero, _CMP_GT_OQ)));
+    // Stand-ins for invalid lanes keep the arithmetic finite
+    F = _mm256_blendv_pd(one, F, valid);
+    K = _mm256_blendv_pd(one, K, valid);
+    T = _mm256_blendv_pd(one, T, valid);
+
+    const __m256d x = vm::log(_mm256_div_pd(F, K));
+    const __m256d half = vm::exp(_mm256_mul_pd(x, half_pd));
+    const __m256d inv_half = _mm256_div_pd(one, half);
+    __m256d theta = _mm256_loadu_pd(sign);
+    __m256d beta = _mm256_div_pd(p, _mm256_sqrt_pd(_mm256_mul_pd(F, K)));
+    const __m256d itm = _mm256_cmp_pd(_mm256_mul_pd(theta, x), zero, _CMP_GT_OQ);
+    beta = _mm256_blendv_pd(beta, _mm256_sub_pd(beta, _mm256_mul_pd(theta, _mm256_sub_pd(half, inv_half))), itm);
+    theta = _mm256_blendv_pd(theta, _mm256_xor_pd(theta, sign_bit), itm);
+    const __m256d bound = _mm256_blendv_pd(inv_half, half, _mm256_cmp_pd(theta, zero, _CMP_GT_OQ));
+    valid = _mm256_and_pd(valid, _mm256_and_pd(_mm256_cmp_pd(beta, zero, _CMP_GT_OQ),
+                                               _mm256_cmp_pd(beta, bound, _CMP_LT_OQ)));
+    beta = _mm256_blendv_pd(_mm256_mul_pd(bound, _mm256_set1_pd(0.1)), beta, valid);
+
+    const __m256d ln_beta = vm::log(beta);
+    const __m256d sqrt_t = _mm256_sqrt_pd(T);
+    const __m256d g = guess ? _mm256_loadu_pd(guess) : zero;
+    const __m256d heuristic = _mm256_max_pd(_mm256_sqrt_pd(_mm256_andnot_pd(sign_bit, _mm256_add_pd(x, x))),
+                                            _mm256_mul_pd(beta, _mm256_set1_pd(2.5066282746310002)));
+    __m256d s = _mm256_blendv_pd(heuristic, _mm256_mul_pd(g, sqrt_t), _mm256_cmp_pd(g, zero, _CMP_GT_OQ));
+    s = _mm256_min_pd(s, _mm256_set1_pd(0.5 * MAX_STDDEV));
+    __m256d lo = zero;
+    __m256d hi = _mm256_set1_pd(MAX_STDDEV);
+    __m256d v = tiny;
+    __m256d done = _mm256_andnot_pd(valid, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+
+    size_t iterations = 0;
+    while (iterations < MAX_NEWTON_ITERATIONS) {
+        ++iterations;
+        const __m256d d1 = vm::fmadd(s, half_pd, _mm256_div_pd(x, s));
+        const __m256d d2 = _mm256_sub_pd(d1, s);
+        __m256d b = _mm256_sub_pd(_mm256_mul_pd(half, vm::norm_cdf(_mm256_mul_pd(theta, d1))),
+                                  _mm256_mul_pd(inv_half, vm::norm_cdf(_mm256_mul_pd(theta, d2))));
+        b = _mm256_max_pd(_mm256_mul_pd(theta, b), tiny);
+        const __m256d f = _mm256_sub_pd(vm::log(b), ln_beta);
+        v = _mm256_mul_pd(half, vm::exp(_mm256_mul_pd(_mm256_mul_pd(d1, d1), _mm256_set1_pd(-0.5))));
+        v = _mm256_max_pd(_mm256_mul_pd(v, _mm256_set1_pd(vm::INV_SQRT_2PI)), tiny);
+
+        const __m256d above = _mm256_cmp_pd(f, zero, _CMP_GT_OQ);
+        hi = _mm256_blendv_pd(hi, s, above);
+        lo = _mm256_blendv_pd(s, lo, above);
+        __m256d next = _mm256_sub_pd(s, _mm256_div_pd(_mm256_mul_pd(f, b), v));
+        const __m256d outside = _mm256_or_pd(_mm256_cmp_pd(next, lo, _CMP_LE_OQ), _mm256_cmp_pd(next, hi, _CMP_GE_OQ));
+        next = _mm256_blendv_pd(next, _mm256_mul_pd(_mm256_add_pd(lo, hi), half_pd), outside);
+        const __m256d step = _mm256_andnot_pd(sign_bit, _mm256_sub_pd(next, s));
+        // Finished lanes hold their value
+        s = _mm256_blendv_pd(next, s, done);
+        done = _mm256_or_pd(done, _mm256_cmp_pd(step, _mm256_mul_pd(s, _mm256_set1_pd(STEP_TOLERANCE)), _CMP_LE_OQ));
+        if (_mm256_movemask_pd(done) == 0xF) {
+            break;
+        }
+    }
+    _mm256_storeu_pd(volatility, _mm256_and_pd(_mm256_div_pd(s, sqrt_t), valid));
+    if (vega) {
+        _mm256_storeu_pd(vega, _mm256_and_pd(v, valid));
+    }
+    return iterations;
+}
+#endif
+
+// Levenberg-Marquardt on the five SVI parameters, weighted least squares in
+// total variance. Returns the weighted sum of squared residuals.
+struct SviFit {
+    const double* k;
+    const double* w;
+    const double* weight;
+    size_t n;
+
+    static void constrain(SviSmile& p) {
+        p.b = std::max(p.b, 0.0);
+        p.rho = std::clamp(p.rho, -0.999, 0.999);
+        p.m = std::clamp(p.m, -2.0, 2.0);
+        p.sigma = std::max(p.sigma, 1e-4);
+        // Minimum variance a + b sigma sqrt(1 - rho^2) not below zero
+        p.a = std::max(p.a, -p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho));
+    }
+
+    double cost(const SviSmile& p) const {
+        double sse = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            const double r = p.total_variance(k[i]) - w[i];
+            sse += weight[i] * r * r;
+        }
+        return sse;
+    }
+
+    double run(SviSmile& p, size_t iterations) const {
+        constrain(p);
+        double sse = cost(p);
+        double lambda = 1e-3;
+        for (size_t it = 0; it < iterations; ++it) {
+            double jtj[5][5] = {};
+            double jtr[5] = {};
+            for (size_t i = 0; i < n; ++i) {
+                const double u = k[i] - p.m;
+                const double root = std::sqrt(u * u + p.sigma * p.sigma);
+                const double r = p.a + p.b * (p.rho * u + root) - w[i];
+                const double j[5] = {1.0, p.rho * u + root, p.b * u, -p.b * (p.rho + u / root), p.b * p.sigma / root};
+                for (int a = 0; a < 5; ++a) {
+                    jtr[a] += weight[i] * j[a] * r;
+                    for (int b = 0; b <= a; ++b) {
+                        jtj[a][b] += weight[i] * j[a] * j[b];
+                    }
+                }
+            }
+            bool accepted = false;
+            for (int attempt = 0; attempt < 8 && !accepted; ++attempt) {
+                double m[5][6];
+                for (int a = 0; a < 5; ++a) {
+                    for (int b = 0; b < 5; ++b) {
+                        m[a][b] = a >= b ? jtj[a][b] : jtj[b][a];
+                    }
+                    m[a][a] += lambda * jtj[a][a] + 1e-18;
+                    m[a][5] = -jtr[a];
+                }
+                double delta[5];
+                if (!solve(m, delta)) {
+                    lambda *= 10.0;
+                    continue;
+                }
+                SviSmile candidate{p.a + delta[0], p.b + delta[1], p.rho + delta[2], p.m + delta[3],
+                                   p.sigma + delta[4]};
+                constrain(candidate);
+                const double candidate_sse = cost(candidate);
+                if (candidate_sse < sse) {
+                    const double improvement = sse - candidate_sse;
+                    p = candidate;
+                    sse = candidate_sse;
+                    lambda = std::max(lambda * 0.1, 1e-12);
+                    accepted = true;
+                    if (improvement <= 1e-14 * sse) {
+                        return sse;
+                    }
+                } else {
+                    lambda *= 10.0;
+                }
+            }
+            if (!accepted) {
+                break;
+            }
+        }
+        return sse;
+    }
+
+    // Gaussian elimination with partial pivoting on [A | b]
+    static bool solve(double m[5][6], double* x) {
+        for (int c = 0; c < 5; ++c) {
+            int pivot = c;
+            for (int r = c + 1; r < 5; ++r) {
+                if (std::abs(m[r][c]) > std::abs(m[pivot][c])) pivot = r;
+            }
+            if (std::abs(m[pivot][c]) < 1e-300) return false;
+            if (pivot != c) {
+                for (int j = 0; j < 6; ++j) std::swap(m[c][j], m[pivot][j]);
+            }
+            for (int r = c + 1; r < 5; ++r) {
+                const double factor = m[r][c] / m[c][c];
+                for (int j = c; j < 6; ++j) m[r][j] -= factor * m[c][j];
+            }
+        }
+        for (int r = 4; r >= 0; --r) {
+            double sum = m[r][5];
+            for (int j = r + 1; j < 5; ++j) sum -= m[r][j] * x[j];
+            x[r] = sum / m[r][r];
+        }
+        return true;
+    }
+};
+
+// Starting point when an expiry has no smile yet
+SviSmile initial_smile(const std::vector<double>& k, const std::vector<double>& w) {
+    size_t atm = 0;
+    double w_min = w[0], w_max = w[0], k_min = k[0], k_max = k[0];
+    for (size_t i = 0; i < k.size(); ++i) {
+        if (std::abs(k[i]) < std::abs(k[atm])) atm = i;
+        w_min = std::min(w_min, w[i]);
+        w_max = std::max(w_max, w[i]);
+        k_min = std::min(k_min, k[i]);
+        k_max = std::max(k_max, k[i]);
+    }
+    SviSmile p;
+    p.sigma = std::max(0.25 * (k_max - k_min), 1e-3);
+    p.rho = -0.3;
+    p.m = 0.0;
+    p.b = std::max((w_max - w_min) / std::max(k_max - k_min, 1e-6), 1e-6);
+    p.a = w[atm] - p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho);
+    return p;
+}
+
+} // namespace
+
+size_t implied_volatilities(const double* forward, const double* strike, const double* tau, const double* sign,
+                            const double* price, const double* guess, double* volatility, double* vega, size_t n) {
+    size_t iterations = 0;
+    size_t i = 0;
+#ifdef __AVX2__
+    for (; i + 4 <= n; i += 4) {
+        iterations += solve_four(forward + i, strike + i, tau + i, sign + i, price + i, guess ? guess + i : nullptr,
+                                 volatility + i, vega ? vega + i : nullptr);
+    }
+#endif
+    for (; i < n; ++i) {
+        double option_vega;
+        volatility[i] = solve_one(forward[i], strike[i], tau[i], sign[i], price[i], guess ? guess[i] : 0.0,
+                                  option_vega, iterations);
+        if (vega) vega[i] = volatility[i] > 0.0 ? option_vega : 0.0;
+    }
+    return iterations;
+}
+
+double SviSmile::total_variance(double k) const {
+    const double u = k - m;
+    return a + b * (rho * u + std::sqrt(u * u + sigma * sigma));
+}
+
+double Smile::volatility(double strike) const {
+    if (!valid || tau <= 0.0 || strike <= 0.0) return 0.0;
+    const double w = svi.total_variance(std::log(strike / forward));
+    return w > 0.0 ? std::sqrt(w / tau) : 0.0;
+}
+
+const Smile* VolatilitySurface::smile(uint64_t underlying_id, int64_t expiry_ns) const {
+    for (const auto& smile : smiles) {
+        if (smile.underlying_id == underlying_id && smile.expiry_ns == expiry_ns) return &smile;
+    }
+    return nullptr;
+}
+
+double VolatilitySurface::volatility(uint64_t underlying_id, int64_t expiry_ns, double strike) const {
+    const Smile* before = nullptr;
+    const Smile* after = nullptr;
+    for (const auto& smile : smiles) {
+        if (smile.underlying_id != underlying_id || !smile.valid) continue;
+        if (smile.expiry_ns == expiry_ns) return smile.volatility(strike);
+        if (smile.expiry_ns < expiry_ns) {
+            before = &smile;
+        } else if (!after) {
+            after = &smile;
+        }
+    }
+    if (!before || !after) {
+        const Smile* nearest = before ? before : after;
+        return nearest ? nearest->volatility(strike) : 0.0;
+    }
+    // Time to the requested expiry on the same clock as the two smiles
+    const double fraction = static_cast<double>(expiry_ns - before->expiry_ns) /
+                            static_cast<double>(after->expiry_ns - before->expiry_ns);
+    const double tau = before->tau + fraction * (after->tau - before->tau);
+    const double w_before = before->svi.total_variance(std::log(strike / before->forward));
+    const double w_after = after->svi.total_variance(std::log(strike / after->forward));
+    const double w = w_before + fraction * (w_after - w_before);
+    return w > 0.0 && tau > 0.0 ? std::sqrt(w / tau) : 0.0;
+}
+
+VolatilitySurfaceService::VolatilitySurfaceService(const Config& config)
+    : config_(config)
+    , options_(config.options)
+    , surface_(std::make_unique<VolatilitySurface>()) {
+    if (config_.days_per_year <= 0.0 || config_.refresh_interval.count() <= 0) {
+        throw std::invalid_argument("VolatilitySurfaceService: days per year and refresh interval must be positive");
+    }
+    config_.min_fit_points = std::max<size_t>(config_.min_fit_points, 5); // Five parameters
+    for (const auto& option : options_) {
+        if (option.contract_id == 0 || !(option.strike > 0.0)) {
+            throw std::invalid_argument("VolatilitySurfaceService: option needs an id and a positive strike");
+        }
+    }
+    config_.options.clear(); // Kept sorted in options_
+    std::sort(options_.begin(), options_.end(), [](const OptionContract& a, const OptionContract& b) {
+        return std::tie(a.underlying_id, a.expiry_ns, a.strike, a.put) <
+               std::tie(b.underlying_id, b.expiry_ns, b.strike, b.put);
+    });
+
+    const size_t n = options_.size();
+    strikes_.resize(n);
+    option_expiry_.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        const OptionContract& option = options_[i];
+        if (!option_index_.emplace(option.contract_id, i).second) {
+            throw std::invalid_argument("VolatilitySurfaceService: option listed twice");
+        }
+        strikes_[i] = option.strike;
+        if (underlyings_.empty() || underlyings_.back() != option.underlying_id) {
+            underlying_index_.emplace(option.underlying_id, static_cast<uint32_t>(underlyings_.size()));
+            underlyings_.push_back(option.underlying_id);
+            auto yield = config_.dividend_yields.find(option.underlying_id);
+            underlying_yield_.push_back(yield != config_.dividend_yields.end() ? yield->second : 0.0);
+            underlying_first_expiry_.push_back(static_cast<uint32_t>(expiries_.size()));
+            underlying_end_expiry_.push_back(static_cast<uint32_t>(expiries_.size()));
+        }
+        const auto underlying = static_cast<uint32_t>(underlyings_.size() - 1);
+        if (expiries_.empty() || expiries_.back().underlying != underlying ||
+            expiries_.back().expiry_ns != option.expiry_ns) {
+            expiries_.push_back(Expiry{underlying, option.expiry_ns, i, i, option.on_future});
+            underlying_end_expiry_[underlying] = static_cast<uint32_t>(expiries_.size());
+        }
+        expiries_.back().end = i + 1;
+        option_expiry_[i] = static_cast<uint32_t>(expiries_.size() - 1);
+    }
+
+    mids_ = std::make_unique<std::atomic<double>[]>(n);
+    solved_ = std::make_unique<std::atomic<double>[]>(n);
+    for (size_t i = 0; i < n; ++i) {
+        mids_[i].store(0.0, std::memory_order_relaxed);
+        solved_[i].store(0.0, std::memory_order_relaxed);
+    }
+    underlying_prices_ = std::make_unique<std::atomic<double>[]>(underlyings_.size());
+    underlying_dirty_ = std::make_unique<std::atomic<uint8_t>[]>(underlyings_.size());
+    for (size_t u = 0; u < underlyings_.size(); ++u) {
+        underlying_prices_[u].store(0.0, std::memory_order_relaxed);
+        underlying_dirty_[u].store(0, std::memory_order_relaxed);
+    }
+    expiry_dirty_ = std::make_unique<std::atomic<uint8_t>[]>(expiries_.size());
+    smiles_.resize(expiries_.size());
+    for (size_t e = 0; e < expiries_.size(); ++e) {
+        expiry_dirty_[e].store(0, std::memory_order_relaxed);
+        smiles_[e].underlying_id = underlyings_[expiries_[e].underlying];
+        smiles_[e].expiry_ns = expiries_[e].expiry_ns;
+    }
+    volatility_.assign(n, 0.0);
+    LOG_INFO("VolatilitySurfaceService: {} options, {} expiries on {} underlyings", n, expiries_.size(),
+             underlyings_.size());
+}
+
+VolatilitySurfaceService::~VolatilitySurfaceService() {
+    stop();
+}
+
+void VolatilitySurfaceService::on_quote(const QuoteMessage& quote) {
+    const double bid = quote.bid_price;
+    const double ask = quote.ask_price;
+    auto it = option_index_.find(quote.symbol_id);
+    if (it == option_index_.end()) {
+        on_price(quote.symbol_id, bid > 0.0 && ask > 0.0 ? 0.5 * (bid + ask) : std::max(bid, ask));
+        return;
+    }
+    // One-sided option quotes say little about value
+    if (bid > 0.0 && ask >= bid) {
+        mids_[it->second].store(0.5 * (bid + ask), std::memory_order_relaxed);
+        expiry_dirty_[option_expiry_[it->second]].store(1, std::memory_order_release);
+    }
+}
+
+void VolatilitySurfaceService::on_price(uint64_t symbol_id, double price) {
+    auto it = underlying_index_.find(symbol_id);
+    if (it != underlying_index_.end() && price > 0.0) {
+        underlying_prices_[it->second].store(price, std::memory_order_relaxed);
+        underlying_dirty_[it->second].store(1, std::memory_order_release);
+    }
+}
+
+void VolatilitySurfaceService::start() {
+    if (refresh_task_id_ != 0) {
+        return;
+    }
+    refresh_task_id_ = core::Runtime::instance().background().schedule_periodic(
+        config_.refresh_interval, [this]() { refresh(); }, "volatility_surface");
+    LOG_INFO("VolatilitySurfaceService: Refresh started");
+}
+
+void VolatilitySurfaceService::stop() {
+    if (refresh_task_id_ == 0) {
+        return;
+    }
+    core::Runtime::instance().cancel(refresh_task_id_);
+    refresh_task_id_ = 0;
+    LOG_INFO("VolatilitySurfaceService: Refresh stopped");
+}
+
+size_t VolatilitySurfaceService::refresh(int64_t now_ns) {
+    if (now_ns == 0) {
+        now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    marked_.assign(expiries_.size(), 0);
+    for (size_t u = 0; u < underlyings_.size(); ++u) {
+        if (underlying_dirty_[u].exchange(0, std::memory_order_acq_rel)) {
+            std::fill(marked_.begin() + underlying_first_expiry_[u], marked_.begin() + underlying_end_expiry_[u], 1);
+        }
+    }
+    size_t refreshed = 0;
+    for (uint32_t e = 0; e < expiries_.size(); ++e) {
+        const bool quoted = expiry_dirty_[e].exchange(0, std::memory_order_acq_rel);
+        if ((quoted || marked_[e]) && refresh_expiry(e, now_ns)) {
+            ++refreshed;
+        }
+    }
+    stats_.refreshes++;
+    if (refreshed == 0) {
+        return 0;
+    }
+
+    auto next = std::make_unique<VolatilitySurface>();
+    next->version = ++version_;
+    next->time_ns = now_ns;
+    next->smiles = smiles_;
+    surface_.publish(std::move(next));
+    return refreshed;
+}
+
+bool VolatilitySurfaceService::refresh_expiry(uint32_t e, int64_t now_ns) {
+    const Expiry& expiry = expiries_[e];
+    const double spot = underlying_prices_[expiry.underlying].load(std::memory_order_relaxed);
+    if (!(spot > 0.0)) {
+        return false; // Its first tick marks this expiry again
+    }
+    Smile& smile = smiles_[e];
+    const double tau = static_cast<double>(expiry.expiry_ns - now_ns) / (NS_PER_DAY * config_.days_per_year);
+    if (tau <= 0.0) {
+        smile.valid = false;
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const double carry = expiry.on_future ? 0.0 : config_.rate - underlying_yield_[expiry.underlying];
+    const double forward = spot * std::exp(carry * tau);
+    const double undiscount = std::exp(config_.rate * tau);
+    const size_t n = expiry.end - expiry.begin;
+    forward_.assign(n, forward);
+    tau_.assign(n, tau);
+    sign_.resize(n);
+    price_.resize(n);
+    vega_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t slot = expiry.begin + static_cast<uint32_t>(i);
+        sign_[i] = options_[slot].put ? -1.0 : 1.0;
+        price_[i] = mids_[slot].load(std::memory_order_relaxed) * undiscount;
+    }
+    double* volatility = &volatility_[expiry.begin];
+    stats_.newton_iterations += implied_volatilities(forward_.data(), &strikes_[expiry.begin], tau_.data(),
+                                                     sign_.data(), price_.data(), volatility, volatility,
+                                                     vega_.data(), n);
+
+    // Out-of-the-money quotes for the fit
+    fit_k_.clear();
+    fit_w_.clear();
+    fit_weight_.clear();
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t slot = expiry.begin + static_cast<uint32_t>(i);
+        solved_[slot].store(volatility[i], std::memory_order_relaxed);
+        if (price_[i] <= 0.0) continue;
+        if (volatility[i] <= 0.0) {
+            stats_.failed_solves++;
+            continue;
+        }
+        stats_.solves++;
+        if (options_[slot].put == (strikes_[slot] < forward)) {
+            fit_k_.push_back(std::log(strikes_[slot] / forward));
+            fit_w_.push_back(volatility[i] * volatility[i] * tau);
+            fit_weight_.push_back(vega_[i]);
+        }
+    }
+    auto solved = std::chrono::steady_clock::now();
+
+    smile.tau = tau;
+    smile.forward = forward;
+    if (fit_k_.size() >= config_.min_fit_points) {
+        SviSmile svi = smile.valid ? smile.svi : initial_smile(fit_k_, fit_w_);
+        const size_t iterations = smile.valid ? config_.warm_fit_iterations : config_.cold_fit_iterations;
+        SviFit{fit_k_.data(), fit_w_.data(), fit_weight_.data(), fit_k_.size()}.run(svi, iterations);
+        double squared = 0.0;
+        for (size_t i = 0; i < fit_k_.size(); ++i) {
+            const double fitted = std::sqrt(std::max(svi.total_variance(fit_k_[i]), 0.0) / tau);
+            const double quoted = std::sqrt(fit_w_[i] / tau);
+            squared += (fitted - quoted) * (fitted - quoted);
+        }
+        smile.svi = svi;
+        smile.rms_error = std::sqrt(squared / fit_k_.size()) * 100.0;
+        smile.points = static_cast<uint32_t>(fit_k_.size());
+        smile.valid = true;
+        stats_.refits++;
+    }
+    auto finished = std::chrono::steady_clock::now();
+
+    const auto solve_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(solved - start).count();
+    const auto refit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(finished - solved).count();
+    stats_.solve_ns += solve_ns;
+    stats_.refit_ns += refit_ns;
+    stats_.max_expiry_ns = std::max<uint64_t>(stats_.max_expiry_ns, solve_ns + refit_ns);
+    return true;
+}
+
+double VolatilitySurfaceService::volatility(uint64_t underlying_id, int64_t expiry_ns, double strike) const {
+    core::RcuReadGuard guard;
+    return surface_.load()->volatility(underlying_id, expiry_ns, strike);
+}
+
+double VolatilitySurfaceService::implied_volatility(uint64_t contract_id) const {
+    auto it = option_index_.find(contract_id);
+    return it == option_index_.end() ? 0.0 : solved_[it->second].load(std::memory_order_relaxed);
+}
+
+VolatilitySurfaceService::Stats VolatilitySurfaceService::get_stats() const {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    return stats_;
+}
+
+} // namespace goldearn::market_data
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "message_types.hpp"
+#include "../core/rcu.hpp"
+#include "../core/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace goldearn::market_data {
+
+// Implied volatilities of n option prices, each undiscounted (premium / e^(-rT)).
+// sign is +1 for calls and -1 for puts. guess holds a previous solution per
+// option, or 0 for none; it may be null or the output array. Writes 0 where no volatility
+// reproduces the price (at or below intrinsic, at or above the forward
+// bound, or no quote). vega, when not null, gets the normalized vega at the
+// solution: d(price / sqrt(FK)) / d(vol sqrt(T)).
+//
+// In Jaeckel's normalized form the price depends only on x = ln(F/K) and
+// s = vol sqrt(T); in-the-money prices are turned into out-of-the-money
+// ones by parity. Newton runs on ln(price), kept inside a bracket that every
+// step narrows, bisecting whenever a step would leave it; four options go
+// through each AVX2 iteration. Returns the Newton iterations taken.
+size_t implied_volatilities(const double* forward, const double* strike, const double* tau, const double* sign,
+                            const double* price, const double* guess, double* volatility, double* vega, size_t n);
+
+// Raw SVI smile in total implied variance over log-moneyness k = ln(K/F):
+//   w(k) = a + b (rho (k - m) + sqrt((k - m)^2 + sigma^2))
+struct SviSmile {
+    double a = 0.0;
+    double b = 0.0;
+    double rho = 0.0;
+    double m = 0.0;
+    double sigma = 0.1;
+
+    double total_variance(double k) const;
+};
+
+// One expiry's fitted smile
+struct Smile {
+    uint64_t underlying_id = 0;
+    int64_t expiry_ns = 0;
+    double tau = 0.0;       // Years to expiry when fitted
+    double forward = 0.0;
+    SviSmile svi;
+    double rms_error = 0.0; // Of the fit, in vol points (0.01)
+    uint32_t points = 0;    // Quotes the fit used
+    bool valid = false;     // False until enough quotes to fit
+
+    double volatility(double strike) const;
+};
+
+// Immutable set of smiles, published whole
+struct VolatilitySurface {
+    uint64_t version = 0;
+    int64_t time_ns = 0;
+    std::vector<Smile> smiles; // By underlying, then expiry
+
+    const Smile* smile(uint64_t underlying_id, int64_t expiry_ns) const;
+    // Between fitted expiries, linear in total variance at the strike's
+    // moneyness against each; flat in volatility beyond them. 0 when the
+    // underlying has no fitted smile.
+    double volatility(uint64_t underlying_id, int64_t expiry_ns, double strike) const;
+};
+
+struct OptionContract {
+    uint64_t contract_id = 0;
+    uint64_t underlying_id = 0;
+    int64_t expiry_ns = 0;
+    double strike = 0.0;
+    bool put = false;
+    bool on_future = false; // Black-76: the underlying price is the forward
+};
+
+// Implied volatility surface kept current from option quotes.
+//
+// Quotes only store the mid and mark their expiry (lock-free, O(1)); an
+// underlying tick marks every expiry on it. refresh() then works expiry by
+// expiry: one batched solve over all of its strikes, each starting from the
+// previous solution, and an SVI refit warm-started from the previous smile
+// (a few Levenberg-Marquardt steps on out-of-the-money quotes, vega
+// weighted). Expiries that nothing touched cost nothing. Changed smiles are
+// published together as a new VolatilitySurface through an RcuPointer, so
+// readers never block and always see one whole refresh.
+//
+// Contracts are fixed at construction (the day's contract master). Index
+// underlyings have no quotes; their values come in through on_price().
+class VolatilitySurfaceService {
+public:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    struct Config {
+        std::vector<OptionContract> options;
+        std::unordered_map<uint64_t, double> dividend_yields; // Per underlying, continuous
+        double rate = 0.065;
+        double days_per_year = 365.0;
+        std::chrono::milliseconds refresh_interval{250};
+        size_t min_fit_points = 5;
+        size_t warm_fit_iterations = 4;  // Per refresh when a smile is already fitted
+        size_t cold_fit_iterations = 60;
+    };
+
+    struct Stats {
+        uint64_t refreshes = 0;
+        uint64_t solves = 0;           // Options whose volatility was solved
+        uint64_t failed_solves = 0;    // No volatility for the quote
+        uint64_t newton_iterations = 0;
+        uint64_t refits = 0;
+        uint64_t solve_ns = 0;         // Totals, for the per-solve and per-refit means
+        uint64_t refit_ns = 0;
+        uint64_t max_expiry_ns = 0;    // Slowest single expiry, solve plus refit
+    };
+
+    explicit VolatilitySurfaceService(const Config& config);
+    ~VolatilitySurfaceService();
+
+    VolatilitySurfaceService(const VolatilitySurfaceService&) = delete;
+    VolatilitySurfaceService& operator=(const VolatilitySurfaceService&) = delete;
+
+    // Feed side, any thread: options and quoted underlyings (futures, stocks)
+    void on_quote(const QuoteMessage& quote);
+    void on_price(uint64_t symbol_id, double price);
+
+    // Runs refresh() every refresh_interval on the background pool
+    void start();
+    void stop();
+    // Solves and refits what was marked since the last call; returns the
+    // expiries refreshed. now_ns = 0 takes the system clock.
+    size_t refresh(int64_t now_ns = 0);
+
+    // Valid inside an RcuReadGuard
+    const VolatilitySurface* surface() const { return surface_.load(); }
+    // Smile volatility, under its own guard
+    double volatility(uint64_t underlying_id, int64_t expiry_ns, double strike) const;
+    // Last solved from the contract's own quote; 0 if none
+    double implied_volatility(uint64_t contract_id) const;
+
+    size_t num_options() const { return options_.size(); }
+    size_t num_expiries() const { return expiries_.size(); }
+    Stats get_stats() const;
+
+private:
+    struct Expiry {
+        uint32_t underlying;
+        int64_t expiry_ns;
+        uint32_t begin; // Slots [begin, end)
+        uint32_t end;
+        bool on_future;
+    };
+
+    Config config_;
+    std::vector<OptionContract> options_;           // By underlying, expiry, strike
+    std::vector<double> strikes_;
+    std::unordered_map<uint64_t, uint32_t> option_index_;
+    std::vector<uint32_t> option_expiry_;
+    std::vector<uint64_t> underlyings_;
+    std::unordered_map<uint64_t, uint32_t> underlying_index_;
+    std::vector<double> underlying_yield_;
+    std::vector<Expiry> expiries_;
+    std::vector<uint32_t> underlying_first_expiry_; // Expiries of an underlying are contiguous
+    std::vector<uint32_t> underlying_end_expiry_;
+
+    // Feed side
+    std::unique_ptr<std::atomic<double>[]> mids_;
+    std::unique_ptr<std::atomic<double>[]> underlying_prices_;
+    std::unique_ptr<std::atomic<uint8_t>[]> expiry_dirty_;
+    std::unique_ptr<std::atomic<uint8_t>[]> underlying_dirty_;
+    std::unique_ptr<std::atomic<double>[]> solved_; // Per option, for implied_volatility()
+
+    // Refresh side, under refresh_mutex_
+    mutable std::mutex refresh_mutex_;
+    std::vector<double> volatility_;                // Last solution per option: the next guess
+    std::vector<Smile> smiles_;                     // Per expiry
+    std::vector<uint8_t> marked_;
+    uint64_t version_ = 0;
+    // Scratch per expiry
+    std::vector<double> forward_, tau_, sign_, price_, vega_;
+    std::vector<double> fit_k_, fit_w_, fit_weight_;
+    Stats stats_;
+    core::TaskId refresh_task_id_ = 0;
+
+    core::RcuPointer<VolatilitySurface> surface_;
+
+    // False when the underlying has no price yet
+    bool refresh_expiry(uint32_t e, int64_t now_ns);
+};
+
+} // namespace goldearn::market_data
@@ -1,20 +1,128 @@
 #include "health_check.hpp"
+#include "prometheus_metrics.hpp"
 #include "../utils/simple_logger.hpp"
 #include "../market_data/nse_protocol.hpp"
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
 #include <algorithm>
+#include <charconv>
 
 namespace goldearn::monitoring {
 
+namespace {
+
+constexpr uint32_t LISTEN_TAG = UINT32_MAX;
+constexpr uint32_t WAKE_TAG = UINT32_MAX - 1;
+constexpr uint32_t ADMIN_LISTEN_TAG = UINT32_MAX - 2;
+constexpr int MAX_EVENTS = 64;
+constexpr int EPOLL_TIMEOUT_MS = 100;
+
+// Fixed responses live in static storage and are written straight from here
+constexpr std::string_view LIVE_RESPONSE =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 5\r\n\r\nAlive";
+constexpr std::string_view NOT_FOUND_RESPONSE =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 9\r\n\r\nNot Found";
+constexpr std::string_view METHOD_NOT_ALLOWED_RESPONSE =
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 18\r\n\r\nMethod not allowed";
+constexpr std::string_view LIMITS_UPDATED_RESPONSE =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 7\r\n\r\nUpdated";
+constexpr std::string_view LIMITS_REJECTED_RESPONSE =
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\nContent-Length: 8\r\n\r\nRejected";
+constexpr std::string_view BAD_REQUEST_RESPONSE =
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\nContent-Length: 11\r\n"
+    "Connection: close\r\n\r\nBad Request";
+
+std::shared_ptr<const std::string> make_response(std::string_view status, std::string_view content_type,
+                                                 std::string_view body) {
+    auto response = std::make_shared<std::string>();
+    response->reserve(body.size() + 128);
+    *response += "HTTP/1.1 ";
+    *response += status;
+    *response += "\r\nContent-Type: ";
+    *response += content_type;
+    *response += "\r\nContent-Length: ";
+    *response += std::to_string(body.size());
+    *response += "\r\n\r\n";
+    *response += body;
+    return response;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return (x | 0x20) == (y | 0x20);
+           });
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Non-blocking listening socket on host:port; port 0 picks one and is
+// updated to the bound port. -1 on failure (logged).
+int open_listener(in_addr_t host, uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("HealthCheckServer: Failed to create socket: {}", strerror(errno));
+        return -1;
+    }
+    
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        LOG_WARN("HealthCheckServer: Failed to set SO_REUSEADDR: {}", strerror(errno));
+    }
+    
+    struct sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(host);
+    address.sin_port = htons(port);
+    
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        LOG_ERROR("HealthCheckServer: Failed to bind to port {}: {}", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    socklen_t address_len = sizeof(address);
+    if (getsockname(fd, (struct sockaddr*)&address, &address_len) == 0) {
+        port = ntohs(address.sin_port);
+    }
+    
+    // Listen for connections; scrape storms arrive in bursts
+    if (listen(fd, 128) < 0) {
+        LOG_ERROR("HealthCheckServer: Failed to listen: {}", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void set_events(int epoll_fd, int fd, uint32_t slot, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u32 = slot;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+} // namespace
+
 HealthCheckServer::HealthCheckServer(uint16_t port) : port_(port) {
+    last_health_check_.overall_status = HealthStatus::UNKNOWN;
+    last_health_check_.timestamp = std::chrono::system_clock::now();
     LOG_INFO("HealthCheckServer: Initializing on port {}", port_);
 }
 
@@ -28,47 +136,77 @@ bool HealthCheckServer::start() {
         return true;
     }
     
-    // Create server socket
-    server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    server_socket_ = open_listener(INADDR_ANY, port_);
     if (server_socket_ < 0) {
-        LOG_ERROR("HealthCheckServer: Failed to create socket: {}", strerror(errno));
         return false;
     }
-    
-    // Set socket options
-    int opt = 1;
-    if (setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        LOG_WARN("HealthCheckServer: Failed to set SO_REUSEADDR: {}", strerror(errno));
+    // Admin routes get their own listener, reachable from this host only
+    if (limit_update_handler_) {
+        admin_socket_ = open_listener(INADDR_LOOPBACK, admin_port_);
+        if (admin_socket_ < 0) {
+            close(server_socket_);
+            server_socket_ = -1;
+            return false;
+        }
     }
     
-    // Bind to port
-    struct sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port_);
-    
-    if (bind(server_socket_, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        LOG_ERROR("HealthCheckServer: Failed to bind to port {}: {}", port_, strerror(errno));
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        LOG_ERROR("HealthCheckServer: Failed to create epoll/eventfd: {}", strerror(errno));
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+        if (admin_socket_ >= 0) close(admin_socket_);
         close(server_socket_);
-        server_socket_ = -1;
+        server_socket_ = admin_socket_ = epoll_fd_ = wake_fd_ = -1;
         return false;
     }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = LISTEN_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_socket_, &event);
+    event.data.u32 = WAKE_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    if (admin_socket_ >= 0) {
+        event.data.u32 = ADMIN_LISTEN_TAG;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, admin_socket_, &event);
+    }
     
-    // Listen for connections
-    if (listen(server_socket_, 10) < 0) {
-        LOG_ERROR("HealthCheckServer: Failed to listen: {}", strerror(errno));
-        close(server_socket_);
-        server_socket_ = -1;
-        return false;
+    // All connection state is allocated here, never per request
+    connections_ = std::vector<Connection>(max_connections_);
+    free_slots_.clear();
+    for (size_t slot = max_connections_; slot > 0; --slot) {
+        free_slots_.push_back(static_cast<uint32_t>(slot - 1));
     }
+    next_idle_sweep_ = std::chrono::steady_clock::now() + timeout_;
+    
+    // Serve the last known state until the first check pass completes
+    publish_health_responses(get_system_health());
+    refresh_metrics_response();
     
     running_ = true;
     
-    // Start threads
+    // Event loop keeps its own thread; checks and snapshot refreshes run on the housekeeping pool
     server_thread_ = std::thread(&HealthCheckServer::server_thread_func, this);
-    health_check_thread_ = std::thread(&HealthCheckServer::health_check_thread_func, this);
+
+    auto& pool = core::Runtime::instance().background();
+    pending_jobs_++;
+    if (!pool.submit([this]() {
+            run_health_checks();
+            pending_jobs_--;
+        })) {
+        pending_jobs_--;
+    }
+    health_check_task_id_ = pool.schedule_periodic(
+        std::chrono::duration_cast<std::chrono::milliseconds>(check_interval_),
+        [this]() { run_health_checks(); }, "health_check");
+    metrics_task_id_ = pool.schedule_periodic(
+        metrics_refresh_interval_, [this]() { refresh_metrics_response(); }, "metrics_snapshot");
     
     LOG_INFO("HealthCheckServer: Started successfully on port {}", port_);
+    if (admin_socket_ >= 0) {
+        LOG_INFO("HealthCheckServer: Admin routes on 127.0.0.1:{}", admin_port_);
+    }
     return true;
 }
 
@@ -79,19 +217,28 @@ void HealthCheckServer::stop() {
     
     running_ = false;
     
-    // Close server socket to wake up accept()
-    if (server_socket_ >= 0) {
-        close(server_socket_);
-        server_socket_ = -1;
+    // Wake the event loop; it closes every open connection on the way out
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0) {
+        LOG_WARN("HealthCheckServer: Failed to wake event loop: {}", strerror(errno));
     }
-    
-    // Wait for threads to finish
     if (server_thread_.joinable()) {
         server_thread_.join();
     }
     
-    if (health_check_thread_.joinable()) {
-        health_check_thread_.join();
+    close(server_socket_);
+    if (admin_socket_ >= 0) close(admin_socket_);
+    close(epoll_fd_);
+    close(wake_fd_);
+    server_socket_ = admin_socket_ = epoll_fd_ = wake_fd_ = -1;
+    
+    // Wait for the periodic refreshes and any queued check
+    core::Runtime::instance().cancel(health_check_task_id_);
+    core::Runtime::instance().cancel(metrics_task_id_);
+    health_check_task_id_ = 0;
+    metrics_task_id_ = 0;
+    while (pending_jobs_.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     
     LOG_INFO("HealthCheckServer: Stopped");
@@ -140,198 +287,414 @@ ComponentHealth HealthCheckServer::get_component_health(const std::string& compo
 }
 
 void HealthCheckServer::server_thread_func() {
-    LOG_INFO("HealthCheckServer: Server thread started");
+    LOG_INFO("HealthCheckServer: Event loop started");
     
+    epoll_event events[MAX_EVENTS];
     while (running_) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, EPOLL_TIMEOUT_MS);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("HealthCheckServer: epoll_wait failed: {}", strerror(errno));
+            break;
+        }
         
-        int client_socket = accept(server_socket_, (struct sockaddr*)&client_addr, &client_len);
-        if (client_socket < 0) {
-            if (running_) {
-                LOG_ERROR("HealthCheckServer: Accept failed: {}", strerror(errno));
+        for (int i = 0; i < count; ++i) {
+            uint32_t tag = events[i].data.u32;
+            if (tag == LISTEN_TAG) {
+                accept_connections(server_socket_, false);
+            } else if (tag == ADMIN_LISTEN_TAG) {
+                accept_connections(admin_socket_, true);
+            } else if (tag == WAKE_TAG) {
+                uint64_t value;
+                while (read(wake_fd_, &value, sizeof(value)) > 0) {}
+            } else if (connections_[tag].fd >= 0) {
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    close_connection(tag);
+                } else if (events[i].events & EPOLLOUT) {
+                    // Finish the pending response, then any pipelined requests
+                    if (flush_response(tag)) {
+                        process_requests(tag);
+                    }
+                } else if (events[i].events & EPOLLIN) {
+                    on_readable(tag);
+                }
             }
-            continue;
         }
         
-        // Handle request in separate thread to avoid blocking
-        std::thread([this, client_socket]() {
-            char buffer[4096];
-            ssize_t bytes_read = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-            
-            if (bytes_read > 0) {
-                buffer[bytes_read] = '\0';
-                std::string request(buffer);
-                
-                // Parse HTTP request
-                std::string method, path, version;
-                std::istringstream request_stream(request);
-                request_stream >> method >> path >> version;
-                
-                // Handle request
-                std::string response = handle_request(path, method);
-                
-                // Send response
-                send(client_socket, response.c_str(), response.length(), 0);
-            }
-            
-            close(client_socket);
-        }).detach();
+        close_idle_connections();
     }
     
-    LOG_INFO("HealthCheckServer: Server thread stopped");
+    for (uint32_t slot = 0; slot < connections_.size(); ++slot) {
+        if (connections_[slot].fd >= 0) {
+            close_connection(slot);
+        }
+    }
+    
+    LOG_INFO("HealthCheckServer: Event loop stopped");
 }
 
-void HealthCheckServer::health_check_thread_func() {
-    LOG_INFO("HealthCheckServer: Health check thread started");
-    
-    while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
-        
-        SystemHealth health;
-        health.timestamp = std::chrono::system_clock::now();
-        health.components.clear();
-        
-        // Run all health checks
-        {
-            std::lock_guard<std::mutex> lock(checkers_mutex_);
-            for (const auto& checker : checkers_) {
-                try {
-                    auto component_start = std::chrono::high_resolution_clock::now();
-                    ComponentHealth component_health = checker->check_health();
-                    auto component_end = std::chrono::high_resolution_clock::now();
-                    
-                    component_health.response_time_ms = 
-                        std::chrono::duration<double, std::milli>(component_end - component_start).count();
-                    
-                    health.components.push_back(component_health);
-                } catch (const std::exception& e) {
-                    ComponentHealth error_health;
-                    error_health.component_name = checker->get_component_name();
-                    error_health.status = HealthStatus::CRITICAL;
-                    error_health.message = std::string("Health check failed: ") + e.what();
-                    error_health.last_check = std::chrono::system_clock::now();
-                    error_health.response_time_ms = 0.0;
-                    
-                    health.components.push_back(error_health);
-                    LOG_ERROR("HealthCheckServer: Health check failed for {}: {}", 
-                             checker->get_component_name(), e.what());
-                }
+void HealthCheckServer::accept_connections(int listen_socket, bool admin) {
+    while (true) {
+        int client_socket = accept4(listen_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("HealthCheckServer: Accept failed: {}", strerror(errno));
             }
+            return;
+        }
+        if (free_slots_.empty()) {
+            // At the connection limit: shed the newcomer rather than grow
+            close(client_socket);
+            continue;
         }
         
-        // Determine overall status
-        health.overall_status = determine_overall_status(health.components);
+        // Responses go out in one write; don't let Nagle hold the tail
+        int opt = 1;
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
         
-        // Generate summary message
-        int healthy_count = 0;
-        int warning_count = 0;
-        int critical_count = 0;
+        uint32_t slot = free_slots_.back();
+        free_slots_.pop_back();
+        Connection& connection = connections_[slot];
+        connection.fd = client_socket;
+        connection.admin = admin;
+        connection.keep_alive = true;
+        connection.waiting_writable = false;
+        connection.read_length = 0;
+        connection.pending = {};
+        connection.last_active = std::chrono::steady_clock::now();
         
-        for (const auto& component : health.components) {
-            switch (component.status) {
-                case HealthStatus::HEALTHY: healthy_count++; break;
-                case HealthStatus::WARNING: warning_count++; break;
-                case HealthStatus::CRITICAL: critical_count++; break;
-                default: break;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = slot;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_socket, &event) < 0) {
+            LOG_ERROR("HealthCheckServer: epoll_ctl failed: {}", strerror(errno));
+            close_connection(slot);
+            continue;
+        }
+        connections_accepted_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void HealthCheckServer::on_readable(uint32_t slot) {
+    Connection& connection = connections_[slot];
+    ssize_t bytes_read = recv(connection.fd, connection.buffer + connection.read_length,
+                              REQUEST_BUFFER_SIZE - connection.read_length, 0);
+    if (bytes_read == 0) {
+        close_connection(slot);
+        return;
+    }
+    if (bytes_read < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            close_connection(slot);
+        }
+        return;
+    }
+    connection.read_length += static_cast<size_t>(bytes_read);
+    connection.last_active = std::chrono::steady_clock::now();
+    process_requests(slot);
+}
+
+// Answer every complete request in the buffer, in order, until a response
+// cannot be written in full (the rest waits for EPOLLOUT)
+void HealthCheckServer::process_requests(uint32_t slot) {
+    Connection& connection = connections_[slot];
+    while (connection.fd >= 0 && connection.pending.empty()) {
+        std::string_view buffered(connection.buffer, connection.read_length);
+        size_t header_end = buffered.find("\r\n\r\n");
+        if (header_end == std::string_view::npos) {
+            if (connection.read_length == REQUEST_BUFFER_SIZE) {
+                connection.keep_alive = false;
+                connection.pending = BAD_REQUEST_RESPONSE;
+                flush_response(slot);
             }
+            return;
         }
+        std::string_view head = buffered.substr(0, header_end);
+        size_t consumed = header_end + 4;
         
-        std::ostringstream summary;
-        summary << "System Health: " << health_utils::status_to_string(health.overall_status);
-        summary << " (" << healthy_count << " healthy, " << warning_count << " warning, " 
-                << critical_count << " critical)";
-        health.summary_message = summary.str();
+        // Request line: METHOD SP PATH SP VERSION
+        size_t line_end = std::min(head.find("\r\n"), head.size());
+        std::string_view request_line = head.substr(0, line_end);
+        size_t method_end = request_line.find(' ');
+        size_t path_end = method_end == std::string_view::npos
+            ? std::string_view::npos : request_line.find(' ', method_end + 1);
+        if (path_end == std::string_view::npos) {
+            connection.keep_alive = false;
+            connection.pending = BAD_REQUEST_RESPONSE;
+            flush_response(slot);
+            return;
+        }
+        std::string_view method = request_line.substr(0, method_end);
+        std::string_view path = request_line.substr(method_end + 1, path_end - method_end - 1);
+        std::string_view version = request_line.substr(path_end + 1);
+        size_t query_start = std::min(path.find('?'), path.size());
+        std::string_view query = path.substr(std::min(query_start + 1, path.size()));
+        path = path.substr(0, query_start);
         
-        // Add system metrics
-        health.metrics["total_components"] = health.components.size();
-        health.metrics["healthy_components"] = healthy_count;
-        health.metrics["warning_components"] = warning_count;
-        health.metrics["critical_components"] = critical_count;
+        // HTTP/1.1 keeps the connection unless asked not to; 1.0 always closes
+        connection.keep_alive = version == "HTTP/1.1";
+        for (size_t pos = line_end; pos < head.size();) {
+            size_t next = std::min(head.find("\r\n", pos + 2), head.size());
+            std::string_view line = head.substr(pos + 2, next - pos - 2);
+            size_t colon = line.find(':');
+            if (colon != std::string_view::npos && iequals(trim(line.substr(0, colon)), "connection")) {
+                connection.keep_alive = !iequals(trim(line.substr(colon + 1)), "close");
+            }
+            pos = next;
+        }
         
-        auto check_end = std::chrono::steady_clock::now();
-        health.metrics["health_check_duration_ms"] = 
-            std::chrono::duration<double, std::milli>(check_end - start_time).count();
+        route_request(connection, method, path, query);
         
-        // Update last health check
-        {
-            std::lock_guard<std::mutex> lock(health_mutex_);
-            last_health_check_ = health;
-        }
+        // Requests carry no body here, so the next one starts right after the headers
+        std::memmove(connection.buffer, connection.buffer + consumed, connection.read_length - consumed);
+        connection.read_length -= consumed;
+        requests_served_.fetch_add(1, std::memory_order_relaxed);
         
-        // Sleep until next check
-        std::this_thread::sleep_for(check_interval_);
+        if (!flush_response(slot)) {
+            return;
+        }
     }
-    
-    LOG_INFO("HealthCheckServer: Health check thread stopped");
 }
 
-std::string HealthCheckServer::handle_request(const std::string& path, const std::string& method) {
-    std::ostringstream response;
+// Returns false once the connection has been closed
+bool HealthCheckServer::flush_response(uint32_t slot) {
+    Connection& connection = connections_[slot];
+    while (!connection.pending.empty()) {
+        ssize_t sent = send(connection.fd, connection.pending.data(), connection.pending.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.pending.remove_prefix(static_cast<size_t>(sent));
+            connection.last_active = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Wait for room; stop reading until this response is out
+            if (!connection.waiting_writable) {
+                connection.waiting_writable = true;
+                set_events(epoll_fd_, connection.fd, slot, EPOLLOUT);
+            }
+            return true;
+        }
+        close_connection(slot);
+        return false;
+    }
     
+    // Response complete: drop the snapshot reference
+    connection.response.reset();
+    if (!connection.keep_alive) {
+        close_connection(slot);
+        return false;
+    }
+    if (connection.waiting_writable) {
+        connection.waiting_writable = false;
+        set_events(epoll_fd_, connection.fd, slot, EPOLLIN);
+    }
+    return true;
+}
+
+void HealthCheckServer::route_request(Connection& connection, std::string_view method, std::string_view path,
+                                      std::string_view query) {
+    if (connection.admin && method == "POST" && path == "/admin/risk_limits") {
+        update_limits(connection, query);
+        return;
+    }
     if (method != "GET") {
-        response << "HTTP/1.1 405 Method Not Allowed\r\n";
-        response << "Content-Type: text/plain\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << "Method not allowed";
-        return response.str();
+        connection.pending = METHOD_NOT_ALLOWED_RESPONSE;
+        return;
     }
     
+    const std::shared_ptr<const std::string>* cached = nullptr;
     if (path == "/health" || path == "/") {
-        // Full health check
-        SystemHealth health = get_system_health();
-        std::string body = format_health_response(health, "json");
-        
-        std::string status_code = (health.overall_status == HealthStatus::HEALTHY) ? "200 OK" : "503 Service Unavailable";
-        
-        response << "HTTP/1.1 " << status_code << "\r\n";
-        response << "Content-Type: application/json\r\n";
-        response << "Content-Length: " << body.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << body;
+        cached = &health_response_;
     } else if (path == "/health/ready") {
-        // Readiness check (simplified)
-        SystemHealth health = get_system_health();
-        bool ready = (health.overall_status == HealthStatus::HEALTHY || health.overall_status == HealthStatus::WARNING);
-        
-        std::string status_code = ready ? "200 OK" : "503 Service Unavailable";
-        std::string body = ready ? "Ready" : "Not Ready";
-        
-        response << "HTTP/1.1 " << status_code << "\r\n";
-        response << "Content-Type: text/plain\r\n";
-        response << "Content-Length: " << body.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << body;
-    } else if (path == "/health/live") {
-        // Liveness check (server is running)
-        std::string body = "Alive";
-        
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: text/plain\r\n";
-        response << "Content-Length: " << body.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << body;
+        cached = &ready_response_;
     } else if (path == "/metrics") {
-        // Prometheus metrics
-        std::string body = format_metrics_response();
-        
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
-        response << "Content-Length: " << body.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << body;
+        cached = &metrics_response_;
+    } else if (path == "/health/live") {
+        connection.pending = LIVE_RESPONSE;
+        return;
     } else {
-        // 404 Not Found
-        std::string body = "Not Found";
+        connection.pending = NOT_FOUND_RESPONSE;
+        return;
+    }
+    
+    // Pin the current snapshot; a refresh swaps in a new one without waiting for us
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        connection.response = *cached;
+    }
+    connection.pending = *connection.response;
+}
+
+// Operator path: parsing and the handler may allocate
+void HealthCheckServer::update_limits(Connection& connection, std::string_view query) {
+    std::vector<std::pair<std::string, double>> updates;
+    while (!query.empty()) {
+        size_t end = std::min(query.find('&'), query.size());
+        std::string_view pair = query.substr(0, end);
+        query.remove_prefix(std::min(end + 1, query.size()));
         
-        response << "HTTP/1.1 404 Not Found\r\n";
-        response << "Content-Type: text/plain\r\n";
-        response << "Content-Length: " << body.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << body;
+        size_t equals = pair.find('=');
+        double value = 0.0;
+        if (equals == std::string_view::npos || equals == 0) {
+            connection.pending = LIMITS_REJECTED_RESPONSE;
+            return;
+        }
+        std::string_view text = pair.substr(equals + 1);
+        auto [parsed_end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || parsed_end != text.data() + text.size()) {
+            connection.pending = LIMITS_REJECTED_RESPONSE;
+            return;
+        }
+        updates.emplace_back(std::string(pair.substr(0, equals)), value);
+    }
+    
+    bool accepted = !updates.empty() && limit_update_handler_(updates);
+    LOG_INFO("HealthCheckServer: Limit update with {} values {}", updates.size(),
+             accepted ? "applied" : "rejected");
+    connection.pending = accepted ? LIMITS_UPDATED_RESPONSE : LIMITS_REJECTED_RESPONSE;
+}
+
+void HealthCheckServer::close_connection(uint32_t slot) {
+    Connection& connection = connections_[slot];
+    close(connection.fd); // Also removes it from the epoll set
+    connection.fd = -1;
+    connection.waiting_writable = false;
+    connection.read_length = 0;
+    connection.pending = {};
+    connection.response.reset();
+    free_slots_.push_back(slot);
+}
+
+void HealthCheckServer::close_idle_connections() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_idle_sweep_) {
+        return;
+    }
+    next_idle_sweep_ = now + std::min<std::chrono::milliseconds>(timeout_, std::chrono::seconds(1));
+    
+    for (uint32_t slot = 0; slot < connections_.size(); ++slot) {
+        if (connections_[slot].fd >= 0 && now - connections_[slot].last_active > timeout_) {
+            close_connection(slot);
+        }
+    }
+}
+
+// One pass over all registered checkers; scheduled every check_interval_
+void HealthCheckServer::run_health_checks() {
+    auto start_time = std::chrono::steady_clock::now();
+    
+    SystemHealth health;
+    health.timestamp = std::chrono::system_clock::now();
+    health.components.clear();
+    
+    // Run all health checks
+    {
+        std::lock_guard<std::mutex> lock(checkers_mutex_);
+        for (const auto& checker : checkers_) {
+            try {
+                auto component_start = std::chrono::high_resolution_clock::now();
+                ComponentHealth component_health = checker->check_health();
+                auto component_end = std::chrono::high_resolution_clock::now();
+                
+                component_health.response_time_ms = 
+                    std::chrono::duration<double, std::milli>(component_end - component_start).count();
+                
+                health.components.push_back(component_health);
+            } catch (const std::exception& e) {
+                ComponentHealth error_health;
+                error_health.component_name = checker->get_component_name();
+                error_health.status = HealthStatus::CRITICAL;
+                error_health.message = std::string("Health check failed: ") + e.what();
+                error_health.last_check = std::chrono::system_clock::now();
+                error_health.response_time_ms = 0.0;
+                
+                health.components.push_back(error_health);
+                LOG_ERROR("HealthCheckServer: Health check failed for {}: {}", 
+                         checker->get_component_name(), e.what());
+            }
+        }
+    }
+    
+    // Determine overall status
+    health.overall_status = determine_overall_status(health.components);
+    
+    // Generate summary message
+    int healthy_count = 0;
+    int warning_count = 0;
+    int critical_count = 0;
+    
+    for (const auto& component : health.components) {
+        switch (component.status) {
+            case HealthStatus::HEALTHY: healthy_count++; break;
+            case HealthStatus::WARNING: warning_count++; break;
+            case HealthStatus::CRITICAL: critical_count++; break;
+            default: break;
+        }
     }
     
-    return response.str();
+    std::ostringstream summary;
+    summary << "System Health: " << health_utils::status_to_string(health.overall_status);
+    summary << " (" << healthy_count << " healthy, " << warning_count << " warning, " 
+            << critical_count << " critical)";
+    health.summary_message = summary.str();
+    
+    // Add system metrics
+    health.metrics["total_components"] = health.components.size();
+    health.metrics["healthy_components"] = healthy_count;
+    health.metrics["warning_components"] = warning_count;
+    health.metrics["critical_components"] = critical_count;
+    
+    auto check_end = std::chrono::steady_clock::now();
+    health.metrics["health_check_duration_ms"] = 
+        std::chrono::duration<double, std::milli>(check_end - start_time).count();
+    
+    // Update last health check
+    {
+        std::lock_guard<std::mutex> lock(health_mutex_);
+        last_health_check_ = health;
+    }
+    
+    publish_health_responses(health);
+    refresh_metrics_response();
+}
+
+// Pre-render the health endpoints so the event loop only copies bytes
+void HealthCheckServer::publish_health_responses(const SystemHealth& health) {
+    bool ready = health.overall_status == HealthStatus::HEALTHY || health.overall_status == HealthStatus::WARNING;
+    auto health_response = make_response(
+        health.overall_status == HealthStatus::HEALTHY ? "200 OK" : "503 Service Unavailable",
+        "application/json", format_health_response(health, "json"));
+    auto ready_response = make_response(ready ? "200 OK" : "503 Service Unavailable",
+                                        "text/plain", ready ? "Ready" : "Not Ready");
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        health_response_ = std::move(health_response);
+        ready_response_ = std::move(ready_response);
+    }
+    
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    health_prometheus_ = format_health_response(health, "prometheus");
+}
+
+// /metrics: last health pass plus the registry, rebuilt every metrics_refresh_interval_
+void HealthCheckServer::refresh_metrics_response() {
+    std::shared_ptr<const std::string> metrics_response;
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex_);
+        MetricsRegistry::instance().serialize_all(registry_text_);
+        std::string body;
+        body.reserve(health_prometheus_.size() + registry_text_.size());
+        body += health_prometheus_;
+        body += registry_text_;
+        metrics_response = make_response("200 OK", "text/plain; version=0.0.4; charset=utf-8", body);
+    }
+    
+    std::lock_guard<std::mutex> lock(response_mutex_);
+    metrics_response_ = std::move(metrics_response);
 }
 
 std::string HealthCheckServer::format_health_response(const SystemHealth& health, const std::string& format) {
@@ -342,11 +705,6 @@ std::string HealthCheckServer::format_health_response(const SystemHealth& health
     }
 }
 
-std::string HealthCheckServer::format_metrics_response() {
-    SystemHealth health = get_system_health();
-    return health_utils::health_to_prometheus(health);
-}
-
 HealthStatus HealthCheckServer::determine_overall_status(const std::vector<ComponentHealth>& components) {
     if (components.empty()) {
         return HealthStatus::UNKNOWN;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <chrono>
 #include <unordered_map>
@@ -9,6 +10,7 @@
 #include <vector>
 #include <functional>
 #include <mutex>
+#include "../core/thread_pool.hpp"
 
 // Forward declarations
 namespace goldearn::market_data::nse {
@@ -52,7 +54,10 @@ public:
     virtual std::string get_component_name() const = 0;
 };
 
-// HTTP health check server
+// HTTP health check server. A single thread runs a non-blocking epoll loop
+// over keep-alive connections; responses are pre-rendered by the health check
+// and metrics refresh tasks, so serving a request never runs a checker and
+// never allocates.
 class HealthCheckServer {
 public:
     HealthCheckServer(uint16_t port = 8080);
@@ -62,6 +67,7 @@ public:
     bool start();
     void stop();
     bool is_running() const { return running_; }
+    uint16_t port() const { return port_; } // Bound port once started (port 0 picks one)
     
     // Register health checkers
     void register_checker(std::shared_ptr<HealthChecker> checker);
@@ -71,16 +77,59 @@ public:
     SystemHealth get_system_health();
     ComponentHealth get_component_health(const std::string& component_name);
     
-    // Configuration
+    // Configuration (before start)
     void set_check_interval(std::chrono::seconds interval) { check_interval_ = interval; }
-    void set_timeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+    void set_metrics_refresh_interval(std::chrono::milliseconds interval) { metrics_refresh_interval_ = interval; }
+    void set_timeout(std::chrono::milliseconds timeout) { timeout_ = timeout; } // Idle keep-alive limit
+    void set_max_connections(size_t max_connections) { max_connections_ = max_connections; }
+    
+    // Admin: POST /admin/risk_limits?<name>=<value>[&<name>=<value>...] hands
+    // every pair to the handler at once (e.g. RiskEngine::update_risk_limits);
+    // 200 when it accepts them, 400 otherwise. Served only on a second
+    // listener bound to 127.0.0.1:admin_port (0 picks one), never on the
+    // public port; operators reach it from the host itself.
+    using LimitUpdateHandler = std::function<bool(const std::vector<std::pair<std::string, double>>&)>;
+    void set_limit_update_handler(uint16_t admin_port, LimitUpdateHandler handler) {
+        admin_port_ = admin_port;
+        limit_update_handler_ = std::move(handler);
+    }
+    uint16_t admin_port() const { return admin_port_; } // Bound admin port once started
+    
+    // Server statistics
+    uint64_t get_connections_accepted() const { return connections_accepted_.load(std::memory_order_relaxed); }
+    uint64_t get_requests_served() const { return requests_served_.load(std::memory_order_relaxed); }
     
 private:
+    static constexpr size_t REQUEST_BUFFER_SIZE = 4096;
+    
+    // Preallocated per-connection state, reused across requests and clients
+    struct Connection {
+        int fd = -1;
+        bool admin = false;                          // Accepted on the loopback admin listener
+        bool keep_alive = true;
+        bool waiting_writable = false;               // Registered for EPOLLOUT
+        size_t read_length = 0;
+        std::shared_ptr<const std::string> response; // Keeps the snapshot being written alive
+        std::string_view pending;                    // Unsent tail of the response
+        std::chrono::steady_clock::time_point last_active;
+        char buffer[REQUEST_BUFFER_SIZE];
+    };
+    
     void server_thread_func();
-    void health_check_thread_func();
-    std::string handle_request(const std::string& path, const std::string& method);
+    void accept_connections(int listen_socket, bool admin);
+    void on_readable(uint32_t slot);
+    void process_requests(uint32_t slot);
+    bool flush_response(uint32_t slot);
+    void route_request(Connection& connection, std::string_view method, std::string_view path,
+                       std::string_view query);
+    void update_limits(Connection& connection, std::string_view query);
+    void close_connection(uint32_t slot);
+    void close_idle_connections();
+    
+    void run_health_checks();
+    void publish_health_responses(const SystemHealth& health);
+    void refresh_metrics_response();
     std::string format_health_response(const SystemHealth& health, const std::string& format = "json");
-    std::string format_metrics_response();
     HealthStatus determine_overall_status(const std::vector<ComponentHealth>& components);
     
 protected:
@@ -89,7 +138,9 @@ private:
     uint16_t port_;
     std::atomic<bool> running_{false};
     std::thread server_thread_;
-    std::thread health_check_thread_;
+    core::TaskId health_check_task_id_ = 0;
+    core::TaskId metrics_task_id_ = 0;
+    std::atomic<int> pending_jobs_{0}; // Checks queued on the housekeeping pool
     
     std::vector<std::shared_ptr<HealthChecker>> checkers_;
     mutable std::mutex checkers_mutex_;
@@ -97,10 +148,34 @@ private:
     SystemHealth last_health_check_;
     mutable std::mutex health_mutex_;
     
+    // Pre-rendered HTTP responses, swapped in whole by the refresh tasks
+    std::shared_ptr<const std::string> health_response_;
+    std::shared_ptr<const std::string> ready_response_;
+    std::shared_ptr<const std::string> metrics_response_;
+    mutable std::mutex response_mutex_;
+    
+    // Refresh-side scratch state (housekeeping pool)
+    std::string health_prometheus_;
+    std::string registry_text_;
+    std::mutex refresh_mutex_;
+    
     std::chrono::seconds check_interval_{30};
+    std::chrono::milliseconds metrics_refresh_interval_{1000};
     std::chrono::milliseconds timeout_{5000};
+    size_t max_connections_ = 256;
+    LimitUpdateHandler limit_update_handler_;
+    uint16_t admin_port_ = 0;
     
     int server_socket_ = -1;
+    int admin_socket_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::vector<Connection> connections_;
+    std::vector<uint32_t> free_slots_;
+    std::chrono::steady_clock::time_point next_idle_sweep_;
+    
+    std::atomic<uint64_t> connections_accepted_{0};
+    std::atomic<uint64_t> requests_served_{0};
 };
 
 // Built-in health checkers
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "../core/jitter_monitor.hpp"
 #include "../core/latency_tracker.hpp"
+#include "../core/thread_pool.hpp"
 #include <atomic>
 #include <memory>
 #include <unordered_map>
@@ -139,6 +141,9 @@ public:
                                  std::shared_ptr<core::LatencyTracker> tracker);
     void unregister_latency_tracker(const std::string& name);
     
+    // OS jitter on isolated cores and in spin-thread idle time
+    core::JitterMonitor::Report get_jitter_report() const { return core::JitterMonitor::instance().report(); }
+    
     // Alert management
     using AlertCallback = std::function<void(const PerformanceAlert&)>;
     void set_alert_callback(AlertCallback callback) { alert_callback_ = callback; }
@@ -155,6 +160,7 @@ public:
         TradingMetrics trading_snapshot;
         std::vector<std::pair<std::string, double>> custom_metrics;
         std::vector<PerformanceAlert> active_alerts;
+        core::JitterMonitor::Report jitter;
         
         // Analysis
         double overall_system_health_score; // 0.0 to 100.0
@@ -238,9 +244,9 @@ private:
     std::unordered_map<std::string, std::pair<double, AlertLevel>> thresholds_;
     AlertCallback alert_callback_;
     
-    // Threading
-    std::unique_ptr<std::thread> monitoring_thread_;
-    std::unique_ptr<std::thread> cleanup_thread_;
+    // Periodic tasks on the housekeeping pool
+    core::TaskId monitoring_task_id_ = 0;
+    core::TaskId cleanup_task_id_ = 0;
     
     // System monitoring implementation
     void update_system_metrics();
@@ -248,8 +254,9 @@ private:
     void check_thresholds();
     void cleanup_old_alerts();
     
-    void monitoring_loop();
-    void cleanup_loop();
+    // One pass each, scheduled by start_monitoring()
+    void run_monitoring_cycle();
+    void run_cleanup_cycle();
     
     // System-specific implementations
     bool read_cpu_stats();
@@ -1,127 +1,678 @@
 #include "prometheus_metrics.hpp"
+#include "../core/rcu.hpp"
 #include "../utils/simple_logger.hpp"
 #include <sstream>
 #include <algorithm>
 #include <fstream>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
 
 namespace goldearn::monitoring {
 
-// MetricsRegistry implementation
-std::shared_ptr<Counter> MetricsRegistry::create_counter(const std::string& name, const std::string& help) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto counter = std::make_shared<Counter>(name, help);
-    metrics_[name] = counter;
-    
-    LOG_DEBUG("MetricsRegistry: Created counter '{}'", name);
-    return counter;
+namespace metrics_detail {
+
+namespace {
+
+std::mutex shard_mutex;
+
+std::vector<int32_t>& free_shards() {
+    static std::vector<int32_t> shards = [] {
+        std::vector<int32_t> all;
+        for (int32_t shard = SHARDS - 1; shard >= 0; --shard) all.push_back(shard);
+        return all;
+    }();
+    return shards;
 }
 
-std::shared_ptr<Gauge> MetricsRegistry::create_gauge(const std::string& name, const std::string& help) {
-    std::lock_guard<std::mutex> lock(mutex_);
+// Hands the shard back when its thread exits; the mutex orders the last
+// writes of this thread before the first writes of the next owner
+struct ShardRelease {
+    int32_t shard = -1;
+    ~ShardRelease() {
+        if (shard >= 0 && static_cast<size_t>(shard) != SHARED_SHARD) {
+            std::lock_guard<std::mutex> lock(shard_mutex);
+            free_shards().push_back(shard);
+        }
+    }
+};
+
+} // namespace
+
+size_t assign_shard() {
+    static thread_local ShardRelease release;
+    int32_t shard = static_cast<int32_t>(SHARED_SHARD);
+    {
+        std::lock_guard<std::mutex> lock(shard_mutex);
+        auto& shards = free_shards();
+        if (!shards.empty()) {
+            shard = shards.back();
+            shards.pop_back();
+        }
+    }
+    release.shard = shard;
+    tl_shard = shard;
+    return static_cast<size_t>(shard);
+}
+
+const std::string* intern_label_set(const std::vector<std::string>& names,
+                                    const std::vector<std::string>& values) {
+    std::string rendered;
+    for (size_t i = 0; i < names.size() && i < values.size(); ++i) {
+        if (i > 0) rendered += ',';
+        rendered += names[i];
+        rendered += "=\"";
+        for (char c : values[i]) {
+            switch (c) {
+                case '\\': rendered += "\\\\"; break;
+                case '"':  rendered += "\\\""; break;
+                case '\n': rendered += "\\n"; break;
+                default:   rendered += c; break;
+            }
+        }
+        rendered += '"';
+    }
     
-    auto gauge = std::make_shared<Gauge>(name, help);
-    metrics_[name] = gauge;
+    // Node-based set: element addresses stay valid for the process lifetime
+    static std::mutex intern_mutex;
+    static std::unordered_set<std::string> interned;
+    std::lock_guard<std::mutex> lock(intern_mutex);
+    return &*interned.insert(std::move(rendered)).first;
+}
+
+namespace {
+
+void append_number(std::string& out, double value) {
+    if (std::isnan(value)) {
+        out += "NaN";
+    } else if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+    } else {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+}
+
+void append_number(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+// name<suffix>{labels,extra} followed by a space
+void append_series(std::string& out, const std::string& name, std::string_view suffix,
+                   std::string_view labels, std::string_view extra = {}) {
+    out += name;
+    out += suffix;
+    if (!labels.empty() || !extra.empty()) {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra.empty()) out += ',';
+        out += extra;
+        out += '}';
+    }
+    out += ' ';
+}
+
+uint64_t bits_of(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+} // namespace metrics_detail
+
+// Metric implementation
+std::string Metric::serialize() const {
+    std::string out;
+    render(out, {});
+    if (!out.empty() && out.back() == '\n') {
+        out.pop_back();
+    }
+    return out;
+}
+
+void Counter::render(std::string& out, std::string_view labels) const {
+    metrics_detail::append_series(out, name_, {}, labels);
+    metrics_detail::append_number(out, value());
+    out += '\n';
+}
+
+uint64_t Counter::change_token() const {
+    return metrics_detail::bits_of(value());
+}
+
+void Gauge::render(std::string& out, std::string_view labels) const {
+    metrics_detail::append_series(out, name_, {}, labels);
+    metrics_detail::append_number(out, value());
+    out += '\n';
+}
+
+uint64_t Gauge::change_token() const {
+    return metrics_detail::bits_of(value());
+}
+
+// Histogram implementation
+Histogram::Histogram(const std::string& name, const std::string& help, const std::vector<double>& buckets)
+    : Metric(name, help, MetricType::HISTOGRAM) {
+    // Bounds must be finite and strictly increasing for the binary search
+    for (double bound : buckets) {
+        if (std::isfinite(bound)) bounds_.push_back(bound);
+    }
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
     
-    LOG_DEBUG("MetricsRegistry: Created gauge '{}'", name);
-    return gauge;
+    lines_per_shard_ = (bounds_.size() + 1 + 7) / 8;
+    counts_ = std::make_unique<metrics_detail::CacheLine[]>(metrics_detail::SHARD_SLOTS * lines_per_shard_);
+    totals_ = std::make_unique<metrics_detail::ShardTotals[]>(metrics_detail::SHARD_SLOTS);
 }
 
-std::shared_ptr<Histogram> MetricsRegistry::create_histogram(const std::string& name, const std::string& help,
-                                                           const std::vector<double>& buckets) {
-    std::lock_guard<std::mutex> lock(mutex_);
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot result;
+    result.cumulative_counts.assign(bounds_.size() + 1, 0);
     
-    auto histogram = buckets.empty() ? 
-        std::make_shared<Histogram>(name, help) :
-        std::make_shared<Histogram>(name, help, buckets);
-    metrics_[name] = histogram;
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        const metrics_detail::CacheLine* lines = &counts_[shard * lines_per_shard_];
+        for (size_t bucket = 0; bucket <= bounds_.size(); ++bucket) {
+            result.cumulative_counts[bucket] += lines[bucket / 8].values[bucket % 8].load(std::memory_order_relaxed);
+        }
+        result.sum += totals_[shard].sum.load(std::memory_order_relaxed);
+    }
     
-    LOG_DEBUG("MetricsRegistry: Created histogram '{}'", name);
-    return histogram;
+    for (size_t bucket = 1; bucket < result.cumulative_counts.size(); ++bucket) {
+        result.cumulative_counts[bucket] += result.cumulative_counts[bucket - 1];
+    }
+    result.count = result.cumulative_counts.back();
+    return result;
 }
 
-std::shared_ptr<Summary> MetricsRegistry::create_summary(const std::string& name, const std::string& help) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void Histogram::render(std::string& out, std::string_view labels) const {
+    Snapshot snap = snapshot();
+    char le[48];
     
-    auto summary = std::make_shared<Summary>(name, help);
-    metrics_[name] = summary;
+    // Bucket counts
+    for (size_t i = 0; i < bounds_.size(); ++i) {
+        std::memcpy(le, "le=\"", 4);
+        auto result = std::to_chars(le + 4, le + sizeof(le) - 1, bounds_[i]);
+        *result.ptr = '"';
+        metrics_detail::append_series(out, name_, "_bucket", labels, std::string_view(le, result.ptr + 1 - le));
+        metrics_detail::append_number(out, snap.cumulative_counts[i]);
+        out += '\n';
+    }
     
-    LOG_DEBUG("MetricsRegistry: Created summary '{}'", name);
-    return summary;
+    // +Inf bucket
+    metrics_detail::append_series(out, name_, "_bucket", labels, "le=\"+Inf\"");
+    metrics_detail::append_number(out, snap.count);
+    out += '\n';
+    
+    // Count and sum
+    metrics_detail::append_series(out, name_, "_count", labels);
+    metrics_detail::append_number(out, snap.count);
+    out += '\n';
+    metrics_detail::append_series(out, name_, "_sum", labels);
+    metrics_detail::append_number(out, snap.sum);
+    out += '\n';
+}
+
+uint64_t Histogram::change_token() const {
+    uint64_t count = 0;
+    double sum = 0.0;
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        const metrics_detail::CacheLine* lines = &counts_[shard * lines_per_shard_];
+        for (size_t line = 0; line < lines_per_shard_; ++line) {
+            for (const auto& value : lines[line].values) {
+                count += value.load(std::memory_order_relaxed);
+            }
+        }
+        sum += totals_[shard].sum.load(std::memory_order_relaxed);
+    }
+    return count * 0x9e3779b97f4a7c15ULL ^ metrics_detail::bits_of(sum);
 }
 
-std::shared_ptr<Metric> MetricsRegistry::get_metric(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = metrics_.find(name);
-    return (it != metrics_.end()) ? it->second : nullptr;
+void Histogram::reset() {
+    for (size_t line = 0; line < metrics_detail::SHARD_SLOTS * lines_per_shard_; ++line) {
+        for (auto& value : counts_[line].values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        totals_[shard].sum.store(0.0, std::memory_order_relaxed);
+    }
 }
 
-std::vector<std::shared_ptr<Metric>> MetricsRegistry::get_all_metrics() {
-    std::lock_guard<std::mutex> lock(mutex_);
+// Summary implementation
+Summary::Summary(const std::string& name, const std::string& help, std::chrono::seconds max_age)
+    : Metric(name, help, MetricType::SUMMARY)
+    , max_age_(max_age)
+    , last_rotation_(std::chrono::steady_clock::now())
+    , totals_(std::make_unique<metrics_detail::ShardTotals[]>(metrics_detail::SHARD_SLOTS)) {}
+
+Summary::~Summary() {
+    for (auto& sketch : sketches_) {
+        delete[] sketch.load(std::memory_order_relaxed);
+    }
+}
+
+// First observation on a shard. Only the shard's owner gets here, except on
+// the shared shard, where racing observers keep whichever sketch won.
+metrics_detail::CacheLine* Summary::allocate_sketch(size_t shard) {
+    auto* fresh = new metrics_detail::CacheLine[SKETCH_LINES]();
+    metrics_detail::CacheLine* expected = nullptr;
+    if (!sketches_[shard].compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+        delete[] fresh;
+        return expected;
+    }
+    return fresh;
+}
+
+double Summary::sketch_value(size_t bucket) {
+    int exponent = static_cast<int>(bucket >> SUB_BUCKET_BITS) + MIN_EXPONENT;
+    double sub = static_cast<double>(bucket & ((1u << SUB_BUCKET_BITS) - 1));
+    double width = static_cast<double>(1u << SUB_BUCKET_BITS);
+    return std::ldexp(1.0 + (sub + 0.5) / width, exponent);
+}
+
+void Summary::rotate_if_due() const {
+    // Called with scrape_mutex_ held; only the scrape side's snapshots change
+    auto now = std::chrono::steady_clock::now();
+    if ((now - last_rotation_) * 2 >= max_age_) {
+        snapshots_[oldest_snapshot_] = merged_sketch();
+        oldest_snapshot_ = 1 - oldest_snapshot_;
+        last_rotation_ = now;
+    }
+}
+
+std::vector<uint64_t> Summary::merged_sketch() const {
+    std::vector<uint64_t> merged(SKETCH_BUCKETS, 0);
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        const metrics_detail::CacheLine* sketch = sketches_[shard].load(std::memory_order_acquire);
+        if (!sketch) continue;
+        for (size_t bucket = 0; bucket < SKETCH_BUCKETS; ++bucket) {
+            merged[bucket] += sketch[bucket / 8].values[bucket % 8].load(std::memory_order_relaxed);
+        }
+    }
+    return merged;
+}
+
+std::vector<uint64_t> Summary::window_sketch() const {
+    std::vector<uint64_t> window = merged_sketch();
+    const std::vector<uint64_t>& since = snapshots_[oldest_snapshot_];
+    if (since.empty()) {
+        return window;
+    }
+    for (size_t bucket = 0; bucket < SKETCH_BUCKETS; ++bucket) {
+        window[bucket] = window[bucket] > since[bucket] ? window[bucket] - since[bucket] : 0;
+    }
+    return window;
+}
+
+double Summary::quantile_of(const std::vector<uint64_t>& sketch, double q) {
+    uint64_t total = 0;
+    for (uint64_t count : sketch) total += count;
+    if (total == 0) {
+        return 0.0;
+    }
     
-    std::vector<std::shared_ptr<Metric>> result;
-    result.reserve(metrics_.size());
+    // Same rank convention as sorting the samples: index q * (n - 1)
+    uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < sketch.size(); ++bucket) {
+        seen += sketch[bucket];
+        if (seen > rank) {
+            return sketch_value(bucket);
+        }
+    }
+    return sketch_value(sketch.size() - 1);
+}
+
+double Summary::quantile(double q) const {
+    std::lock_guard<std::mutex> lock(scrape_mutex_);
+    rotate_if_due();
+    return quantile_of(window_sketch(), q);
+}
+
+uint64_t Summary::count() const {
+    uint64_t total = 0;
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        total += totals_[shard].count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double Summary::sum() const {
+    double total = 0.0;
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        total += totals_[shard].sum.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Summary::render(std::string& out, std::string_view labels) const {
+    std::vector<uint64_t> sketch;
+    {
+        std::lock_guard<std::mutex> lock(scrape_mutex_);
+        rotate_if_due();
+        sketch = window_sketch();
+    }
     
-    for (const auto& pair : metrics_) {
-        result.push_back(pair.second);
+    // Common quantiles
+    static constexpr std::pair<std::string_view, double> quantiles[] = {
+        {"quantile=\"0.5\"", 0.5}, {"quantile=\"0.9\"", 0.9},
+        {"quantile=\"0.95\"", 0.95}, {"quantile=\"0.99\"", 0.99}};
+    for (const auto& [label, q] : quantiles) {
+        metrics_detail::append_series(out, name_, {}, labels, label);
+        metrics_detail::append_number(out, quantile_of(sketch, q));
+        out += '\n';
     }
     
-    return result;
+    metrics_detail::append_series(out, name_, "_count", labels);
+    metrics_detail::append_number(out, count());
+    out += '\n';
+    metrics_detail::append_series(out, name_, "_sum", labels);
+    metrics_detail::append_number(out, sum());
+    out += '\n';
+}
+
+uint64_t Summary::change_token() const {
+    // Quantiles also move when a window rotates out
+    auto half_windows = (std::chrono::steady_clock::now().time_since_epoch() * 2) / max_age_;
+    return count() * 0x9e3779b97f4a7c15ULL ^ metrics_detail::bits_of(sum()) ^
+           static_cast<uint64_t>(half_windows);
+}
+
+void Summary::reset() {
+    std::lock_guard<std::mutex> lock(scrape_mutex_);
+    // Forget earlier observations by moving both snapshots up to now
+    snapshots_[0] = merged_sketch();
+    snapshots_[1] = snapshots_[0];
+    last_rotation_ = std::chrono::steady_clock::now();
+    for (size_t shard = 0; shard < metrics_detail::SHARD_SLOTS; ++shard) {
+        totals_[shard].count.store(0, std::memory_order_relaxed);
+        totals_[shard].sum.store(0.0, std::memory_order_relaxed);
+    }
 }
 
-std::string MetricsRegistry::serialize_all() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+// MetricFamilyBase implementation
+MetricFamilyBase::MetricFamilyBase(const std::string& name, const std::string& help, MetricType type,
+                                   std::vector<std::string> label_names)
+    : name_(name), help_(help), type_(type), label_names_(std::move(label_names)) {
+}
+
+MetricFamilyBase::~MetricFamilyBase() {
+    Child* child = head_.load();
+    while (child) {
+        Child* next = child->next.load();
+        delete child;
+        child = next;
+    }
+}
+
+std::shared_ptr<Metric> MetricFamilyBase::get_or_create(const std::vector<std::string>& values) {
+    if (values.size() != label_names_.size()) {
+        throw std::invalid_argument("metric family '" + name_ + "' expects " +
+                                    std::to_string(label_names_.size()) + " label values");
+    }
+    const std::string* labels = metrics_detail::intern_label_set(label_names_, values);
     
-    std::ostringstream output;
+    std::lock_guard<std::mutex> lock(children_mutex_);
+    auto it = by_labels_.find(labels);
+    if (it != by_labels_.end()) {
+        return it->second;
+    }
     
-    for (const auto& pair : metrics_) {
-        const auto& metric = pair.second;
-        
-        // Add HELP and TYPE comments
-        output << "# HELP " << metric->name() << " " << metric->help() << "\n";
-        output << "# TYPE " << metric->name() << " ";
-        
-        switch (metric->type()) {
-            case MetricType::COUNTER:
-                output << "counter";
-                break;
-            case MetricType::GAUGE:
-                output << "gauge";
-                break;
-            case MetricType::HISTOGRAM:
-                output << "histogram";
-                break;
-            case MetricType::SUMMARY:
-                output << "summary";
-                break;
+    auto* child = new Child{make_child(), labels};
+    by_labels_.emplace(labels, child->metric);
+    // Publish fully built child; scrapes follow the list with acquire loads
+    if (tail_) {
+        tail_->next.store(child, std::memory_order_release);
+    } else {
+        head_.store(child, std::memory_order_release);
+    }
+    tail_ = child;
+    child_count_.fetch_add(1, std::memory_order_release);
+    return child->metric;
+}
+
+const std::string& MetricFamilyBase::render() const {
+    size_t children = child_count_.load(std::memory_order_acquire);
+    bool dirty = children != rendered_children_;
+    
+    size_t seen = 0;
+    for (Child* child = head_.load(std::memory_order_acquire); child && seen < children;
+         child = child->next.load(std::memory_order_acquire), ++seen) {
+        uint64_t token = child->metric->change_token();
+        if (token != child->rendered_token) {
+            child->rendered_token = token;
+            dirty = true;
         }
-        output << "\n";
-        
-        // Add metric data
-        output << metric->serialize() << "\n\n";
     }
+    if (!dirty) {
+        return cache_;
+    }
+    
+    cache_.clear();
+    rendered_children_ = children;
+    if (children == 0) {
+        return cache_;
+    }
+    
+    static constexpr const char* type_names[] = {"counter", "gauge", "histogram", "summary"};
+    cache_ += "# HELP ";
+    cache_ += name_;
+    cache_ += ' ';
+    cache_ += help_;
+    cache_ += "\n# TYPE ";
+    cache_ += name_;
+    cache_ += ' ';
+    cache_ += type_names[static_cast<size_t>(type_)];
+    cache_ += '\n';
+    
+    seen = 0;
+    for (Child* child = head_.load(std::memory_order_acquire); child && seen < children;
+         child = child->next.load(std::memory_order_acquire), ++seen) {
+        child->metric->render(cache_, *child->labels);
+    }
+    cache_ += '\n';
+    return cache_;
+}
+
+// MetricsRegistry implementation
+MetricsRegistry::~MetricsRegistry() {
+    FamilyNode* node = head_.load();
+    while (node) {
+        FamilyNode* next = node->next.load();
+        delete node;
+        node = next;
+    }
+}
+
+void MetricsRegistry::register_family(std::shared_ptr<MetricFamilyBase> family) {
+    auto* node = new FamilyNode{std::move(family)};
+    
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+    auto it = by_name_.find(node->family->name());
+    if (it != by_name_.end()) {
+        unlink_locked(it->second);
+        it->second = node;
+    } else {
+        by_name_.emplace(node->family->name(), node);
+    }
+    if (tail_) {
+        tail_->next.store(node, std::memory_order_release);
+    } else {
+        head_.store(node, std::memory_order_release);
+    }
+    tail_ = node;
+}
+
+void MetricsRegistry::unlink_locked(FamilyNode* node) {
+    node->removed.store(true, std::memory_order_release);
+    FamilyNode* previous = nullptr;
+    for (FamilyNode* current = head_.load(std::memory_order_relaxed); current != node;
+         current = current->next.load(std::memory_order_relaxed)) {
+        previous = current;
+    }
+    // A scrape already on the node still finds the rest of the list through it
+    FamilyNode* next = node->next.load(std::memory_order_relaxed);
+    if (previous) {
+        previous->next.store(next, std::memory_order_release);
+    } else {
+        head_.store(next, std::memory_order_release);
+    }
+    if (tail_ == node) {
+        tail_ = previous;
+    }
+    core::Rcu::instance().retire(node, [](void* object) { delete static_cast<FamilyNode*>(object); });
+}
+
+std::shared_ptr<MetricFamily<Counter>> MetricsRegistry::create_counter_family(
+    const std::string& name, const std::string& help, const std::vector<std::string>& label_names) {
+    auto family = std::make_shared<MetricFamily<Counter>>(name, help, MetricType::COUNTER, label_names,
+        [name, help]() { return std::make_shared<Counter>(name, help); });
+    register_family(family);
+    LOG_DEBUG("MetricsRegistry: Created counter family '{}' ({} labels)", name, label_names.size());
+    return family;
+}
+
+std::shared_ptr<MetricFamily<Gauge>> MetricsRegistry::create_gauge_family(
+    const std::string& name, const std::string& help, const std::vector<std::string>& label_names) {
+    auto family = std::make_shared<MetricFamily<Gauge>>(name, help, MetricType::GAUGE, label_names,
+        [name, help]() { return std::make_shared<Gauge>(name, help); });
+    register_family(family);
+    LOG_DEBUG("MetricsRegistry: Created gauge family '{}' ({} labels)", name, label_names.size());
+    return family;
+}
+
+std::shared_ptr<MetricFamily<Histogram>> MetricsRegistry::create_histogram_family(
+    const std::string& name, const std::string& help, const std::vector<std::string>& label_names,
+    const std::vector<double>& buckets) {
+    auto family = std::make_shared<MetricFamily<Histogram>>(name, help, MetricType::HISTOGRAM, label_names,
+        [name, help, buckets]() {
+            return buckets.empty() ? std::make_shared<Histogram>(name, help)
+                                   : std::make_shared<Histogram>(name, help, buckets);
+        });
+    register_family(family);
+    LOG_DEBUG("MetricsRegistry: Created histogram family '{}' ({} labels)", name, label_names.size());
+    return family;
+}
+
+std::shared_ptr<MetricFamily<Summary>> MetricsRegistry::create_summary_family(
+    const std::string& name, const std::string& help, const std::vector<std::string>& label_names) {
+    auto family = std::make_shared<MetricFamily<Summary>>(name, help, MetricType::SUMMARY, label_names,
+        [name, help]() { return std::make_shared<Summary>(name, help); });
+    register_family(family);
+    LOG_DEBUG("MetricsRegistry: Created summary family '{}' ({} labels)", name, label_names.size());
+    return family;
+}
+
+std::shared_ptr<Counter> MetricsRegistry::create_counter(const std::string& name, const std::string& help) {
+    return create_counter_family(name, help, {})->with_labels({});
+}
+
+std::shared_ptr<Gauge> MetricsRegistry::create_gauge(const std::string& name, const std::string& help) {
+    return create_gauge_family(name, help, {})->with_labels({});
+}
+
+std::shared_ptr<Histogram> MetricsRegistry::create_histogram(const std::string& name, const std::string& help,
+                                                           const std::vector<double>& buckets) {
+    return create_histogram_family(name, help, {}, buckets)->with_labels({});
+}
+
+std::shared_ptr<Summary> MetricsRegistry::create_summary(const std::string& name, const std::string& help) {
+    return create_summary_family(name, help, {})->with_labels({});
+}
+
+std::shared_ptr<MetricFamilyBase> MetricsRegistry::get_family(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registration_mutex_);
     
-    return output.str();
+    auto it = by_name_.find(name);
+    return (it != by_name_.end()) ? it->second->family : nullptr;
+}
+
+std::shared_ptr<Metric> MetricsRegistry::get_metric(const std::string& name) {
+    auto family = get_family(name);
+    std::shared_ptr<Metric> first;
+    if (family) {
+        family->for_each([&](const std::shared_ptr<Metric>& metric, const std::string&) {
+            if (!first) first = metric;
+        });
+    }
+    return first;
+}
+
+std::vector<std::shared_ptr<Metric>> MetricsRegistry::get_all_metrics() {
+    std::vector<std::shared_ptr<Metric>> result;
+    core::RcuReadGuard guard;
+    for (FamilyNode* node = head_.load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (node->removed.load(std::memory_order_acquire)) continue;
+        node->family->for_each([&](const std::shared_ptr<Metric>& metric, const std::string&) {
+            result.push_back(metric);
+        });
+    }
+    return result;
+}
+
+std::string MetricsRegistry::serialize_all() const {
+    std::lock_guard<std::mutex> lock(scrape_mutex_);
+    exposition_.clear();
+    core::RcuReadGuard guard;
+    for (FamilyNode* node = head_.load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (node->removed.load(std::memory_order_acquire)) continue;
+        exposition_ += node->family->render();
+    }
+    return exposition_;
+}
+
+void MetricsRegistry::serialize_all(std::string& out) const {
+    // Same walk, straight into the caller's (reused) buffer
+    std::lock_guard<std::mutex> lock(scrape_mutex_);
+    out.clear();
+    core::RcuReadGuard guard;
+    for (FamilyNode* node = head_.load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (node->removed.load(std::memory_order_acquire)) continue;
+        out += node->family->render();
+    }
 }
 
 void MetricsRegistry::remove_metric(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(registration_mutex_);
     
-    auto it = metrics_.find(name);
-    if (it != metrics_.end()) {
-        metrics_.erase(it);
+    auto it = by_name_.find(name);
+    if (it != by_name_.end()) {
+        unlink_locked(it->second);
+        by_name_.erase(it);
         LOG_DEBUG("MetricsRegistry: Removed metric '{}'", name);
     }
 }
 
 void MetricsRegistry::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(registration_mutex_);
     
-    metrics_.clear();
+    for (auto& [name, node] : by_name_) {
+        unlink_locked(node);
+    }
+    by_name_.clear();
     LOG_INFO("MetricsRegistry: Cleared all metrics");
 }
 
+size_t MetricsRegistry::family_count() const {
+    core::RcuReadGuard guard;
+    size_t count = 0;
+    for (FamilyNode* node = head_.load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+        ++count;
+    }
+    return count;
+}
+
 // HFTMetricsCollector implementation
 HFTMetricsCollector::HFTMetricsCollector() {
     auto& registry = MetricsRegistry::instance();
@@ -238,7 +789,8 @@ void HFTMetricsCollector::start() {
     }
     
     running_ = true;
-    collection_thread_ = std::thread(&HFTMetricsCollector::collection_thread_func, this);
+    collection_task_id_ = core::Runtime::instance().background().schedule_periodic(
+        collection_interval_, [this]() { collect_once(); }, "metrics_collection");
     
     LOG_INFO("HFTMetricsCollector: Started metrics collection");
 }
@@ -249,10 +801,8 @@ void HFTMetricsCollector::stop() {
     }
     
     running_ = false;
-    
-    if (collection_thread_.joinable()) {
-        collection_thread_.join();
-    }
+    core::Runtime::instance().cancel(collection_task_id_);
+    collection_task_id_ = 0;
     
     LOG_INFO("HFTMetricsCollector: Stopped metrics collection");
 }
@@ -362,20 +912,12 @@ std::string HFTMetricsCollector::get_metrics_snapshot() const {
     return MetricsRegistry::instance().serialize_all();
 }
 
-void HFTMetricsCollector::collection_thread_func() {
-    LOG_INFO("HFTMetricsCollector: Collection thread started");
-    
-    while (running_) {
-        try {
-            update_system_metrics();
-        } catch (const std::exception& e) {
-            LOG_ERROR("HFTMetricsCollector: Error updating system metrics: {}", e.what());
-        }
-        
-        std::this_thread::sleep_for(collection_interval_);
+void HFTMetricsCollector::collect_once() {
+    try {
+        update_system_metrics();
+    } catch (const std::exception& e) {
+        LOG_ERROR("HFTMetricsCollector: Error updating system metrics: {}", e.what());
     }
-    
-    LOG_INFO("HFTMetricsCollector: Collection thread stopped");
 }
 
 void HFTMetricsCollector::update_system_metrics() {
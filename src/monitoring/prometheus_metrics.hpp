@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <memory>
@@ -11,6 +12,9 @@
 #include <sstream>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include "../core/thread_pool.hpp"
 
 namespace goldearn::monitoring {
 
@@ -30,9 +34,16 @@ public:
     
     virtual ~Metric() = default;
     
-    virtual std::string serialize() const = 0;
+    // Append this metric's exposition lines; `labels` is a pre-escaped label
+    // list (name="value",...) shared by every metric with that label set
+    virtual void render(std::string& out, std::string_view labels) const = 0;
+    // Changes whenever render() output would; scrapes skip unchanged families
+    virtual uint64_t change_token() const = 0;
     virtual void reset() = 0;
     
+    // Unlabeled exposition lines (no trailing newline)
+    std::string serialize() const;
+    
     const std::string& name() const { return name_; }
     const std::string& help() const { return help_; }
     MetricType type() const { return type_; }
@@ -60,9 +71,8 @@ public:
         return value_.load(std::memory_order_relaxed);
     }
     
-    std::string serialize() const override {
-        return name_ + " " + std::to_string(value());
-    }
+    void render(std::string& out, std::string_view labels) const override;
+    uint64_t change_token() const override;
     
     void reset() override {
         value_.store(0, std::memory_order_relaxed);
@@ -97,9 +107,8 @@ public:
         return value_.load(std::memory_order_relaxed);
     }
     
-    std::string serialize() const override {
-        return name_ + " " + std::to_string(value());
-    }
+    void render(std::string& out, std::string_view labels) const override;
+    uint64_t change_token() const override;
     
     void reset() override {
         value_.store(0, std::memory_order_relaxed);
@@ -109,128 +118,270 @@ private:
     std::atomic<double> value_;
 };
 
+// Observations from the hot threads go to per-thread shards merged at scrape
+// time. A thread owns its shard exclusively while it lives, so increments are
+// plain relaxed load + store on cache lines no other thread writes; threads
+// beyond SHARDS share one overflow shard that uses atomic read-modify-write.
+namespace metrics_detail {
+
+constexpr size_t SHARDS = 16;
+constexpr size_t SHARED_SHARD = SHARDS;
+constexpr size_t SHARD_SLOTS = SHARDS + 1;
+
+struct alignas(64) CacheLine {
+    std::atomic<uint64_t> values[8];
+};
+
+struct alignas(64) ShardTotals {
+    std::atomic<uint64_t> count{0};
+    std::atomic<double> sum{0.0};
+};
+
+// Claims a free shard for the calling thread (released at thread exit)
+inline thread_local int32_t tl_shard = -1;
+size_t assign_shard();
+
+inline size_t current_shard() {
+    int32_t shard = tl_shard;
+    return shard >= 0 ? static_cast<size_t>(shard) : assign_shard();
+}
+
+inline void increment(std::atomic<uint64_t>& target, size_t shard) {
+    if (shard != SHARED_SHARD) {
+        target.store(target.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        target.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+inline void add(std::atomic<double>& target, double value, size_t shard) {
+    double current = target.load(std::memory_order_relaxed);
+    if (shard != SHARED_SHARD) {
+        target.store(current + value, std::memory_order_relaxed);
+        return;
+    }
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace metrics_detail
+
 // Histogram metric (for latency measurements)
 class Histogram : public Metric {
 public:
     Histogram(const std::string& name, const std::string& help, 
-              const std::vector<double>& buckets = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 10.0})
-        : Metric(name, help, MetricType::HISTOGRAM), buckets_(buckets), count_(0), sum_(0) {
-        bucket_counts_.resize(buckets_.size(), 0);
-    }
+              const std::vector<double>& buckets = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 10.0});
     
     void observe(double value) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        count_++;
-        sum_ += value;
-        
-        // Update bucket counts
-        for (size_t i = 0; i < buckets_.size(); ++i) {
-            if (value <= buckets_[i]) {
-                bucket_counts_[i]++;
-            }
-        }
+        size_t shard = metrics_detail::current_shard();
+        size_t bucket = bucket_index(value);
+        metrics_detail::increment(counts_[shard * lines_per_shard_ + bucket / 8].values[bucket % 8], shard);
+        metrics_detail::add(totals_[shard].sum, value, shard);
     }
     
-    std::string serialize() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        std::ostringstream ss;
-        
-        // Bucket counts
-        for (size_t i = 0; i < buckets_.size(); ++i) {
-            ss << name_ << "_bucket{le=\"" << buckets_[i] << "\"} " << bucket_counts_[i] << "\n";
+    // First bucket whose upper bound is >= value (bounds_.size() is +Inf);
+    // branch-free binary search
+    size_t bucket_index(double value) const {
+        const double* base = bounds_.data();
+        size_t length = bounds_.size();
+        if (length == 0) return 0;
+        while (length > 1) {
+            size_t half = length / 2;
+            base += (base[half - 1] < value) ? half : 0;
+            length -= half;
         }
-        
-        // +Inf bucket
-        ss << name_ << "_bucket{le=\"+Inf\"} " << count_ << "\n";
-        
-        // Count and sum
-        ss << name_ << "_count " << count_ << "\n";
-        ss << name_ << "_sum " << sum_;
-        
-        return ss.str();
+        size_t index = static_cast<size_t>(base - bounds_.data()) + (*base < value);
+        return value == value ? index : bounds_.size(); // NaN only counts towards +Inf
     }
     
-    void reset() override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        count_ = 0;
-        sum_ = 0;
-        std::fill(bucket_counts_.begin(), bucket_counts_.end(), 0);
-    }
+    struct Snapshot {
+        std::vector<uint64_t> cumulative_counts; // One per bound, then +Inf
+        uint64_t count = 0;
+        double sum = 0.0;
+    };
+    
+    // Merge all shards (scrape side)
+    Snapshot snapshot() const;
+    const std::vector<double>& buckets() const { return bounds_; }
+    
+    void render(std::string& out, std::string_view labels) const override;
+    uint64_t change_token() const override;
+    void reset() override;
     
 private:
-    mutable std::mutex mutex_;
-    std::vector<double> buckets_;
-    std::vector<uint64_t> bucket_counts_;
-    uint64_t count_;
-    double sum_;
+    std::vector<double> bounds_;
+    size_t lines_per_shard_;
+    std::unique_ptr<metrics_detail::CacheLine[]> counts_;
+    std::unique_ptr<metrics_detail::ShardTotals[]> totals_;
 };
 
-// Summary metric (quantiles)
+// Summary metric (quantiles). Streaming: each observation increments one
+// bucket of a log-linear sketch (32 sub-buckets per power of two, so
+// quantiles are within ~1.6% relative error) instead of storing samples.
+// Quantiles cover roughly the last max_age: the sketches only count up, each
+// scrape at least max_age / 2 after the last snapshots their merged counts,
+// and quantiles are taken over the counts since the older of the last two
+// snapshots. Observers never see a reset. A shard's sketch is allocated on
+// the first observation from that shard, after which observe() never
+// allocates: a summary (or labeled child) costs 16KB per observing shard.
+// Count and sum are cumulative.
 class Summary : public Metric {
 public:
-    Summary(const std::string& name, const std::string& help, size_t max_samples = 1000)
-        : Metric(name, help, MetricType::SUMMARY), max_samples_(max_samples), count_(0), sum_(0) {}
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int MIN_EXPONENT = -20;  // ~1e-6; smaller values clamp here
+    static constexpr int MAX_EXPONENT = 43;   // ~1.7e13
+    static constexpr size_t SKETCH_BUCKETS =
+        static_cast<size_t>(MAX_EXPONENT - MIN_EXPONENT + 1) << SUB_BUCKET_BITS;
+    static constexpr size_t SKETCH_LINES = SKETCH_BUCKETS / 8;
+    
+    Summary(const std::string& name, const std::string& help,
+            std::chrono::seconds max_age = std::chrono::seconds(60));
+    ~Summary() override;
     
     void observe(double value) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        count_++;
-        sum_ += value;
-        
-        samples_.push_back(value);
-        
-        // Keep only the most recent samples
-        if (samples_.size() > max_samples_) {
-            samples_.erase(samples_.begin());
-        }
+        size_t shard = metrics_detail::current_shard();
+        size_t bucket = sketch_index(value);
+        metrics_detail::CacheLine* sketch = sketches_[shard].load(std::memory_order_acquire);
+        if (!sketch) sketch = allocate_sketch(shard);
+        metrics_detail::increment(sketch[bucket / 8].values[bucket % 8], shard);
+        metrics_detail::increment(totals_[shard].count, shard);
+        metrics_detail::add(totals_[shard].sum, value, shard);
     }
     
-    double quantile(double q) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (samples_.empty()) {
-            return 0.0;
-        }
-        
-        std::vector<double> sorted_samples = samples_;
-        std::sort(sorted_samples.begin(), sorted_samples.end());
-        
-        size_t index = static_cast<size_t>(q * (sorted_samples.size() - 1));
-        return sorted_samples[index];
+    // Log-indexed bucket: exponent and top mantissa bits of the double
+    static size_t sketch_index(double value) {
+        if (!(value > 0.0)) return 0;
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        int exponent = static_cast<int>((bits >> 52) & 0x7ff) - 1023;
+        if (exponent < MIN_EXPONENT) return 0;
+        if (exponent > MAX_EXPONENT) return SKETCH_BUCKETS - 1;
+        size_t sub = static_cast<size_t>((bits >> (52 - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1));
+        return (static_cast<size_t>(exponent - MIN_EXPONENT) << SUB_BUCKET_BITS) + sub;
     }
     
-    std::string serialize() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        std::ostringstream ss;
-        
-        // Common quantiles
-        std::vector<double> quantiles = {0.5, 0.9, 0.95, 0.99};
-        for (double q : quantiles) {
-            ss << name_ << "{quantile=\"" << q << "\"} " << quantile(q) << "\n";
+    // Midpoint of a sketch bucket
+    static double sketch_value(size_t bucket);
+    
+    double quantile(double q) const;
+    uint64_t count() const;
+    double sum() const;
+    
+    void render(std::string& out, std::string_view labels) const override;
+    uint64_t change_token() const override;
+    void reset() override;
+    
+private:
+    metrics_detail::CacheLine* allocate_sketch(size_t shard);
+    void rotate_if_due() const;
+    // All shards' counts since construction
+    std::vector<uint64_t> merged_sketch() const;
+    // Counts since the older snapshot
+    std::vector<uint64_t> window_sketch() const;
+    static double quantile_of(const std::vector<uint64_t>& sketch, double q);
+    
+    std::chrono::seconds max_age_;
+    // Scrape side, under scrape_mutex_: the last two snapshots of the merged
+    // counts (empty until the first rotation: all zero); a rotation
+    // overwrites the older one and makes the other oldest
+    mutable std::vector<uint64_t> snapshots_[2];
+    mutable uint32_t oldest_snapshot_ = 0;
+    mutable std::chrono::steady_clock::time_point last_rotation_;
+    mutable std::mutex scrape_mutex_;
+    std::atomic<metrics_detail::CacheLine*> sketches_[metrics_detail::SHARD_SLOTS] = {}; // Null until observed
+    std::unique_ptr<metrics_detail::ShardTotals[]> totals_;
+};
+
+namespace metrics_detail {
+
+// Label sets are rendered and escaped once (name="value",...) and interned;
+// every metric with the same label set shares the text
+const std::string* intern_label_set(const std::vector<std::string>& names,
+                                    const std::vector<std::string>& values);
+
+} // namespace metrics_detail
+
+// Labeled metric family: one child metric per distinct label-value set.
+// Children are appended to a list that scrapes walk without locking;
+// creating a child only locks the family's lookup table, never observers,
+// who keep the child pointer.
+class MetricFamilyBase {
+public:
+    MetricFamilyBase(const std::string& name, const std::string& help, MetricType type,
+                     std::vector<std::string> label_names);
+    virtual ~MetricFamilyBase();
+    
+    MetricFamilyBase(const MetricFamilyBase&) = delete;
+    MetricFamilyBase& operator=(const MetricFamilyBase&) = delete;
+    
+    const std::string& name() const { return name_; }
+    const std::string& help() const { return help_; }
+    MetricType type() const { return type_; }
+    const std::vector<std::string>& label_names() const { return label_names_; }
+    size_t size() const { return child_count_.load(std::memory_order_acquire); }
+    
+    // Exposition text for the whole family. Re-rendered only when a child
+    // was added or changed since the previous call (scrape side, serialized
+    // by the registry).
+    const std::string& render() const;
+    
+    // Children in creation order
+    template<typename F>
+    void for_each(F&& fn) const {
+        for (Child* child = head_.load(std::memory_order_acquire); child;
+             child = child->next.load(std::memory_order_acquire)) {
+            fn(child->metric, *child->labels);
         }
-        
-        ss << name_ << "_count " << count_ << "\n";
-        ss << name_ << "_sum " << sum_;
-        
-        return ss.str();
     }
     
-    void reset() override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        count_ = 0;
-        sum_ = 0;
-        samples_.clear();
+protected:
+    // Throws std::invalid_argument if the number of values does not match
+    std::shared_ptr<Metric> get_or_create(const std::vector<std::string>& values);
+    virtual std::shared_ptr<Metric> make_child() const = 0;
+    
+private:
+    struct Child {
+        std::shared_ptr<Metric> metric;
+        const std::string* labels;
+        mutable uint64_t rendered_token = 0;
+        std::atomic<Child*> next{nullptr};
+    };
+    
+    std::string name_;
+    std::string help_;
+    MetricType type_;
+    std::vector<std::string> label_names_;
+    
+    std::atomic<Child*> head_{nullptr};
+    std::atomic<size_t> child_count_{0};
+    std::mutex children_mutex_;
+    Child* tail_ = nullptr;
+    std::unordered_map<const std::string*, std::shared_ptr<Metric>> by_labels_;
+    
+    // Scrape-side cache
+    mutable std::string cache_;
+    mutable size_t rendered_children_ = SIZE_MAX;
+};
+
+template<typename M>
+class MetricFamily : public MetricFamilyBase {
+public:
+    using Factory = std::function<std::shared_ptr<M>()>;
+    
+    MetricFamily(const std::string& name, const std::string& help, MetricType type,
+                 std::vector<std::string> label_names, Factory factory)
+        : MetricFamilyBase(name, help, type, std::move(label_names)), factory_(std::move(factory)) {}
+    
+    // Child for `values` (in label_names() order), created on first use.
+    // Resolve once and keep the pointer on hot paths.
+    std::shared_ptr<M> with_labels(const std::vector<std::string>& values) {
+        return std::static_pointer_cast<M>(get_or_create(values));
     }
     
 private:
-    mutable std::mutex mutex_;
-    size_t max_samples_;
-    std::vector<double> samples_;
-    uint64_t count_;
-    double sum_;
+    std::shared_ptr<Metric> make_child() const override { return factory_(); }
+    
+    Factory factory_;
 };
 
 // Metrics registry
@@ -241,19 +392,33 @@ public:
         return instance;
     }
     
-    // Register metrics
+    // Register metrics (an existing family with the same name is replaced)
     std::shared_ptr<Counter> create_counter(const std::string& name, const std::string& help);
     std::shared_ptr<Gauge> create_gauge(const std::string& name, const std::string& help);
     std::shared_ptr<Histogram> create_histogram(const std::string& name, const std::string& help,
                                                const std::vector<double>& buckets = {});
     std::shared_ptr<Summary> create_summary(const std::string& name, const std::string& help);
     
-    // Get metrics
+    // Register labeled families
+    std::shared_ptr<MetricFamily<Counter>> create_counter_family(
+        const std::string& name, const std::string& help, const std::vector<std::string>& label_names);
+    std::shared_ptr<MetricFamily<Gauge>> create_gauge_family(
+        const std::string& name, const std::string& help, const std::vector<std::string>& label_names);
+    std::shared_ptr<MetricFamily<Histogram>> create_histogram_family(
+        const std::string& name, const std::string& help, const std::vector<std::string>& label_names,
+        const std::vector<double>& buckets = {});
+    std::shared_ptr<MetricFamily<Summary>> create_summary_family(
+        const std::string& name, const std::string& help, const std::vector<std::string>& label_names);
+    
+    // Get metrics (get_metric returns the first child of the family)
     std::shared_ptr<Metric> get_metric(const std::string& name);
+    std::shared_ptr<MetricFamilyBase> get_family(const std::string& name);
     std::vector<std::shared_ptr<Metric>> get_all_metrics();
     
-    // Serialize all metrics
+    // Serialize all metrics. Clean families come from their cached text; the
+    // exposition buffer is reused between scrapes.
     std::string serialize_all() const;
+    void serialize_all(std::string& out) const;
     
     // Remove metric
     void remove_metric(const std::string& name);
@@ -261,11 +426,34 @@ public:
     // Clear all metrics
     void clear();
     
+    // Families on the scrape list; removed ones are unlinked at once
+    size_t family_count() const;
+    
 private:
     MetricsRegistry() = default;
-    
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, std::shared_ptr<Metric>> metrics_;
+    ~MetricsRegistry();
+    
+    // Families are published on a list that scrapes walk inside an RCU read
+    // section, so they never wait on registration. Removal marks the node,
+    // unlinks it and retires it through core::Rcu, which frees it once no
+    // scrape can still be on it.
+    struct FamilyNode {
+        std::shared_ptr<MetricFamilyBase> family;
+        std::atomic<bool> removed{false};
+        std::atomic<FamilyNode*> next{nullptr};
+    };
+    
+    void register_family(std::shared_ptr<MetricFamilyBase> family);
+    // Under registration_mutex_
+    void unlink_locked(FamilyNode* node);
+    
+    std::mutex registration_mutex_;
+    std::unordered_map<std::string, FamilyNode*> by_name_;
+    std::atomic<FamilyNode*> head_{nullptr};
+    FamilyNode* tail_ = nullptr;
+    
+    mutable std::mutex scrape_mutex_;
+    mutable std::string exposition_;
 };
 
 // HFT-specific metrics collector
@@ -309,7 +497,7 @@ public:
     double get_current_memory_usage();
     
 private:
-    void collection_thread_func();
+    void collect_once();
     void update_system_metrics();
     
 private:
@@ -339,9 +527,9 @@ private:
     std::shared_ptr<Counter> network_bytes_sent_counter_;
     std::shared_ptr<Counter> network_bytes_received_counter_;
     
-    // Collection thread
+    // Periodic collection task on the housekeeping pool
     std::atomic<bool> running_{false};
-    std::thread collection_thread_;
+    core::TaskId collection_task_id_ = 0;
     std::chrono::seconds collection_interval_{5};
 };
 
@@ -0,0 +1,302 @@
+#include "risk_engine.hpp"
+#include "limit_snapshot.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::risk {
+
+namespace {
+uint64_t batch_slot(uint64_t symbol_id, uint64_t mask) {
+    return ((symbol_id + 1) * 0x9E3779B97F4A7C15ULL >> 17) & mask;
+}
+}
+
+void OrderBatch::clear() {
+    symbol_ids_.clear();
+    prices_.clear();
+    quantities_.clear();
+    positions_.clear();
+    previous_.clear();
+    first_repeat_ = SIZE_MAX;
+    std::fill(seen_keys_.begin(), seen_keys_.end(), 0);
+}
+
+void OrderBatch::add(uint64_t symbol_id, trading::OrderSide side, double price, double quantity,
+                     double current_position) {
+    size_t index = symbol_ids_.size();
+    if ((index + 1) * 2 > seen_keys_.size()) {
+        rehash(std::max<size_t>(64, seen_keys_.size() * 2));
+    }
+
+    uint64_t mask = seen_keys_.size() - 1;
+    uint64_t slot = batch_slot(symbol_id, mask);
+    while (seen_keys_[slot] != 0 && seen_keys_[slot] != symbol_id + 1) {
+        slot = (slot + 1) & mask;
+    }
+    int32_t previous = -1;
+    if (seen_keys_[slot] != 0) {
+        previous = static_cast<int32_t>(seen_last_[slot]);
+        first_repeat_ = std::min(first_repeat_, index);
+    }
+    seen_keys_[slot] = symbol_id + 1;
+    seen_last_[slot] = static_cast<uint32_t>(index);
+
+    symbol_ids_.push_back(symbol_id);
+    prices_.push_back(price);
+    quantities_.push_back(side == trading::OrderSide::BUY ? quantity : -quantity);
+    positions_.push_back(current_position);
+    previous_.push_back(previous);
+}
+
+void OrderBatch::rehash(size_t slots) {
+    seen_keys_.assign(slots, 0);
+    seen_last_.assign(slots, 0);
+    uint64_t mask = slots - 1;
+    for (size_t i = 0; i < symbol_ids_.size(); ++i) {
+        uint64_t slot = batch_slot(symbol_ids_[i], mask);
+        while (seen_keys_[slot] != 0 && seen_keys_[slot] != symbol_ids_[i] + 1) {
+            slot = (slot + 1) & mask;
+        }
+        seen_keys_[slot] = symbol_ids_[i] + 1;
+        seen_last_[slot] = static_cast<uint32_t>(i);
+    }
+}
+
+FastPreTradeChecker::FastPreTradeChecker(const RiskLimits& limits)
+    : limits_(nullptr) {
+    publish_limits(limits, 1);
+}
+
+void FastPreTradeChecker::update_limits(const RiskLimits& limits) {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    publish_limits(limits, limits_.load()->version + 1);
+}
+
+void FastPreTradeChecker::update_limits(const LimitSnapshot& limits) {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    publish_limits(limits.global(), limits.version());
+}
+
+uint64_t FastPreTradeChecker::limits_version() const {
+    core::RcuReadGuard guard;
+    return limits_.load()->version;
+}
+
+void FastPreTradeChecker::publish_limits(const RiskLimits& limits, uint64_t version) {
+    limits_.publish(std::make_unique<CheckLimits>(CheckLimits{version, limits.max_position_size,
+                                                              limits.max_order_size, limits.max_order_value,
+                                                              limits.max_portfolio_exposure}));
+}
+
+bool FastPreTradeChecker::quick_position_check(uint64_t symbol_id, double quantity, double current_position) const {
+    double current = std::fabs(current_position);
+    double projected = std::fabs(current_position + quantity);
+    core::RcuReadGuard guard;
+    return projected <= limits_.load()->max_position_size || projected <= current;
+}
+
+bool FastPreTradeChecker::quick_order_size_check(double order_value) const {
+    core::RcuReadGuard guard;
+    return order_value <= limits_.load()->max_order_value;
+}
+
+bool FastPreTradeChecker::quick_exposure_check(double order_value, double current_exposure) const {
+    core::RcuReadGuard guard;
+    return current_exposure + order_value <= limits_.load()->max_portfolio_exposure;
+}
+
+bool FastPreTradeChecker::quick_blacklist_check(uint64_t symbol_id, const std::string& strategy_id) const {
+    std::shared_lock<std::shared_mutex> lock(blacklist_mutex_);
+    return blacklisted_symbols_.find(symbol_id) == blacklisted_symbols_.end() &&
+           blacklisted_strategies_.find(strategy_id) == blacklisted_strategies_.end();
+}
+
+void FastPreTradeChecker::set_position(uint64_t symbol_id, double position) {
+    std::unique_lock<std::shared_mutex> lock(positions_mutex_);
+    positions_[symbol_id] = position;
+}
+
+void FastPreTradeChecker::add_symbol_to_blacklist(uint64_t symbol_id) {
+    std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+    blacklisted_symbols_.insert(symbol_id);
+    blacklisted_symbol_count_.store(blacklisted_symbols_.size(), std::memory_order_relaxed);
+}
+
+void FastPreTradeChecker::remove_symbol_from_blacklist(uint64_t symbol_id) {
+    std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+    blacklisted_symbols_.erase(symbol_id);
+    blacklisted_symbol_count_.store(blacklisted_symbols_.size(), std::memory_order_relaxed);
+}
+
+void FastPreTradeChecker::add_strategy_to_blacklist(const std::string& strategy_id) {
+    std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+    blacklisted_strategies_.insert(strategy_id);
+}
+
+void FastPreTradeChecker::remove_strategy_from_blacklist(const std::string& strategy_id) {
+    std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+    blacklisted_strategies_.erase(strategy_id);
+}
+
+void FastPreTradeChecker::mark_blacklisted(const OrderBatch& batch, uint8_t* approved) const {
+    size_t n = batch.size();
+    std::fill(approved, approved + n, 1);
+    if (blacklisted_symbol_count_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    std::shared_lock<std::shared_mutex> lock(blacklist_mutex_);
+    for (size_t i = 0; i < n; ++i) {
+        approved[i] = blacklisted_symbols_.find(batch.symbol_ids_[i]) == blacklisted_symbols_.end();
+    }
+}
+
+size_t FastPreTradeChecker::check_batch(const OrderBatch& batch, double current_exposure, uint8_t* approved,
+                                        uint64_t* limits_version) const {
+    core::RcuReadGuard guard;
+    const CheckLimits& limits = *limits_.load();
+    if (limits_version) {
+        *limits_version = limits.version;
+    }
+    size_t n = batch.size();
+    mark_blacklisted(batch, approved);
+
+    double exposure = current_exposure;
+    size_t count = 0;
+    size_t i = 0;
+
+#ifdef __AVX2__
+    // Until the first repeated symbol every order sees its pre-batch position,
+    // so four orders are checked at once. Exposure is a running prefix sum of
+    // the approved orders' additions; the first order that would breach it
+    // (and everything after) goes to the sequential path, because a rejected
+    // order must not consume headroom.
+    size_t vector_end = std::min(n, batch.first_repeat_);
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d max_position = _mm256_set1_pd(limits.max_position_size);
+    const __m256d max_order_size = _mm256_set1_pd(limits.max_order_size);
+    const __m256d max_order_value = _mm256_set1_pd(limits.max_order_value);
+    const __m256d max_exposure = _mm256_set1_pd(limits.max_portfolio_exposure);
+    __m256d running = _mm256_set1_pd(exposure);
+
+    for (; i + 4 <= vector_end; i += 4) {
+        __m256d quantity = _mm256_loadu_pd(&batch.quantities_[i]);
+        __m256d price = _mm256_loadu_pd(&batch.prices_[i]);
+        __m256d position = _mm256_loadu_pd(&batch.positions_[i]);
+
+        __m256d size = _mm256_andnot_pd(sign_mask, quantity);
+        __m256d current = _mm256_andnot_pd(sign_mask, position);
+        __m256d projected = _mm256_andnot_pd(sign_mask, _mm256_add_pd(position, quantity));
+
+        __m256d ok = _mm256_and_pd(_mm256_cmp_pd(size, max_order_size, _CMP_LE_OQ),
+                                   _mm256_cmp_pd(_mm256_mul_pd(size, price), max_order_value, _CMP_LE_OQ));
+        ok = _mm256_and_pd(ok, _mm256_or_pd(_mm256_cmp_pd(projected, max_position, _CMP_LE_OQ),
+                                            _mm256_cmp_pd(projected, current, _CMP_LE_OQ)));
+        // Blacklist marks from the pre-pass
+        uint32_t allowed = 0;
+        std::memcpy(&allowed, approved + i, sizeof(allowed));
+        __m256i allowed_lanes = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(allowed)));
+        ok = _mm256_and_pd(ok, _mm256_castsi256_pd(_mm256_cmpgt_epi64(allowed_lanes, _mm256_setzero_si256())));
+
+        // Inclusive prefix sum of the additions of orders that passed
+        __m256d added = _mm256_and_pd(ok, _mm256_mul_pd(_mm256_max_pd(_mm256_sub_pd(projected, current), zero), price));
+        __m256d prefix = _mm256_add_pd(added, _mm256_blend_pd(zero, _mm256_permute4x64_pd(added, 0x90), 0xE));
+        prefix = _mm256_add_pd(prefix, _mm256_blend_pd(zero, _mm256_permute4x64_pd(prefix, 0x40), 0xC));
+        prefix = _mm256_add_pd(prefix, running);
+
+        int passed = _mm256_movemask_pd(ok);
+        int breach = _mm256_movemask_pd(_mm256_cmp_pd(prefix, max_exposure, _CMP_GT_OQ)) & passed;
+        if (breach != 0) [[unlikely]] {
+            // Lanes before the breach stand; the sequential path resumes at it
+            int lane = __builtin_ctz(static_cast<unsigned>(breach));
+            alignas(32) double sums[4];
+            _mm256_store_pd(sums, prefix);
+            for (int k = 0; k < lane; ++k) {
+                approved[i + k] = (passed >> k) & 1;
+                count += approved[i + k];
+            }
+            exposure = lane > 0 ? sums[lane - 1] : exposure;
+            i += static_cast<size_t>(lane);
+            return count + check_sequential(batch, limits, i, exposure, approved);
+        }
+        for (int k = 0; k < 4; ++k) {
+            approved[i + k] = (passed >> k) & 1;
+        }
+        count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(passed)));
+        running = _mm256_permute4x64_pd(prefix, 0xFF);
+        exposure = _mm256_cvtsd_f64(running);
+    }
+#endif
+
+    return count + check_sequential(batch, limits, i, exposure, approved);
+}
+
+// Scalar tail: one order at a time from `begin`, with the position of a
+// repeated symbol moved by the approved orders before it
+size_t FastPreTradeChecker::check_sequential(const OrderBatch& batch, const CheckLimits& limits, size_t begin,
+                                             double& exposure, uint8_t* approved) const {
+    double max_position = limits.max_position_size;
+    double max_order_size = limits.max_order_size;
+    double max_order_value = limits.max_order_value;
+    double max_exposure = limits.max_portfolio_exposure;
+
+    size_t count = 0;
+    for (size_t i = begin; i < batch.size(); ++i) {
+        double position = batch.positions_[i];
+        for (int32_t j = batch.previous_[i]; j >= 0; j = batch.previous_[j]) {
+            position += approved[j] ? batch.quantities_[j] : 0.0;
+        }
+        double quantity = batch.quantities_[i];
+        double price = batch.prices_[i];
+        double size = std::fabs(quantity);
+        double current = std::fabs(position);
+        double projected = std::fabs(position + quantity);
+        double added = std::max(projected - current, 0.0) * price;
+
+        bool ok = approved[i] && size <= max_order_size && size * price <= max_order_value &&
+                  (projected <= max_position || projected <= current) && exposure + added <= max_exposure;
+        approved[i] = ok;
+        exposure += ok ? added : 0.0;
+        count += ok;
+    }
+    return count;
+}
+
+std::vector<bool> FastPreTradeChecker::batch_check_orders(const std::vector<trading::Order>& orders) const {
+    thread_local OrderBatch batch;
+    thread_local std::vector<uint32_t> batch_index;
+    thread_local std::vector<uint8_t> approved;
+
+    std::vector<bool> result(orders.size(), false);
+    batch.clear();
+    batch_index.clear();
+    {
+        // Blacklisted strategies are rejected outright and take no headroom
+        std::shared_lock<std::shared_mutex> blacklist_lock(blacklist_mutex_);
+        std::shared_lock<std::shared_mutex> positions_lock(positions_mutex_);
+        for (uint32_t i = 0; i < orders.size(); ++i) {
+            const auto& order = orders[i];
+            if (!blacklisted_strategies_.empty() &&
+                blacklisted_strategies_.find(order.strategy_id) != blacklisted_strategies_.end()) {
+                continue;
+            }
+            auto it = positions_.find(order.symbol_id);
+            batch.add(order.symbol_id, order.side, order.price, static_cast<double>(order.quantity),
+                      it != positions_.end() ? it->second : 0.0);
+            batch_index.push_back(i);
+        }
+    }
+
+    approved.resize(batch.size());
+    check_batch(batch, current_exposure_.load(std::memory_order_relaxed), approved.data());
+    for (size_t k = 0; k < batch_index.size(); ++k) {
+        result[batch_index[k]] = approved[k] != 0;
+    }
+    return result;
+}
+
+} // namespace goldearn::risk
@@ -0,0 +1,526 @@
+#include "greeks_engine.hpp"
+#include "../utils/simple_logger.hpp"
+#include "../utils/vector_math.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::risk {
+
+namespace {
+
+constexpr size_t BLOCK = 4;
+constexpr double NS_PER_DAY = 86400e9;
+// Floors that keep d1 finite: at expiry the price is intrinsic value
+constexpr double MIN_TAU = 1e-6;
+constexpr double MIN_VOLATILITY = 1e-4;
+
+// Filler for padding slots: finite Greeks, never weighted by a position
+const GreeksEngine::Contract PADDING{0, 0, GreeksEngine::OptionType::CALL, GreeksEngine::Model::BLACK_SCHOLES, 1.0, 0,
+                                     1.0};
+
+struct Kernel {
+    double spot;
+    double carry; // b: r - q for Black-Scholes, 0 for Black-76
+    double rate;
+    double day_fraction;
+};
+
+// price = w D (F N(w d1) - K N(w d2)) with D = e^(-rT), F = U e^(bT)
+void price_block(const double* strike, const double* tau, const double* volatility, const double* sign,
+                 const double* spot_model, double* price, double* delta, double* gamma, double* vega, double* theta,
+                 const Kernel& k) {
+#ifdef __AVX2__
+    namespace vm = utils::vmath;
+    const __m256d spot = _mm256_set1_pd(k.spot);
+    const __m256d rate = _mm256_set1_pd(k.rate);
+    const __m256d K = _mm256_loadu_pd(strike);
+    const __m256d T = _mm256_loadu_pd(tau);
+    const __m256d vol = _mm256_loadu_pd(volatility);
+    const __m256d w = _mm256_loadu_pd(sign);
+    const __m256d b = _mm256_mul_pd(_mm256_loadu_pd(spot_model), _mm256_set1_pd(k.carry));
+
+    const __m256d sqrt_t = _mm256_sqrt_pd(T);
+    const __m256d sd = _mm256_mul_pd(vol, sqrt_t);
+    const __m256d discount = vm::exp(_mm256_mul_pd(_mm256_sub_pd(_mm256_setzero_pd(), rate), T));
+    const __m256d growth = vm::exp(_mm256_mul_pd(b, T));
+    const __m256d forward = _mm256_mul_pd(spot, growth);
+    const __m256d half_var = _mm256_mul_pd(_mm256_mul_pd(sd, sd), _mm256_set1_pd(0.5));
+    const __m256d d1 = _mm256_div_pd(_mm256_add_pd(vm::log(_mm256_div_pd(forward, K)), half_var), sd);
+    const __m256d d2 = _mm256_sub_pd(d1, sd);
+    const __m256d n1 = vm::norm_cdf(_mm256_mul_pd(w, d1));
+    const __m256d n2 = vm::norm_cdf(_mm256_mul_pd(w, d2));
+    const __m256d pdf = _mm256_mul_pd(vm::exp(_mm256_mul_pd(_mm256_mul_pd(d1, d1), _mm256_set1_pd(-0.5))),
+                                      _mm256_set1_pd(vm::INV_SQRT_2PI));
+
+    const __m256d df = _mm256_mul_pd(discount, forward);   // D F
+    const __m256d dk = _mm256_mul_pd(discount, K);         // D K
+    const __m256d dfn1 = _mm256_mul_pd(w, _mm256_mul_pd(df, n1));
+    const __m256d dkn2 = _mm256_mul_pd(w, _mm256_mul_pd(dk, n2));
+    const __m256d df_pdf = _mm256_mul_pd(df, pdf);
+    _mm256_storeu_pd(price, _mm256_sub_pd(dfn1, dkn2));
+    _mm256_storeu_pd(delta, _mm256_mul_pd(w, _mm256_mul_pd(_mm256_mul_pd(discount, growth), n1)));
+    _mm256_storeu_pd(gamma, _mm256_div_pd(df_pdf, _mm256_mul_pd(_mm256_mul_pd(spot, spot), sd)));
+    _mm256_storeu_pd(vega, _mm256_mul_pd(_mm256_mul_pd(df_pdf, sqrt_t), _mm256_set1_pd(0.01)));
+    // dV/dt = -D F pdf vol / (2 sqrt T) - (b - r) w D F N1 - r w D K N2
+    __m256d decay = _mm256_div_pd(_mm256_mul_pd(df_pdf, vol), _mm256_add_pd(sqrt_t, sqrt_t));
+    decay = vm::fmadd(_mm256_sub_pd(b, rate), dfn1, decay);
+    decay = vm::fmadd(rate, dkn2, decay);
+    _mm256_storeu_pd(theta, _mm256_mul_pd(decay, _mm256_set1_pd(-k.day_fraction)));
+#else
+    for (size_t i = 0; i < BLOCK; ++i) {
+        const double b = spot_model[i] * k.carry;
+        const double w = sign[i];
+        const double sqrt_t = std::sqrt(tau[i]);
+        const double sd = volatility[i] * sqrt_t;
+        const double discount = std::exp(-k.rate * tau[i]);
+        const double growth = std::exp(b * tau[i]);
+        const double forward = k.spot * growth;
+        const double d1 = (std::log(forward / strike[i]) + 0.5 * sd * sd) / sd;
+        const double d2 = d1 - sd;
+        const double n1 = utils::vmath::norm_cdf(w * d1);
+        const double n2 = utils::vmath::norm_cdf(w * d2);
+        const double pdf = std::exp(-0.5 * d1 * d1) * utils::vmath::INV_SQRT_2PI;
+        const double df = discount * forward;
+        const double dfn1 = w * df * n1;
+        const double dkn2 = w * discount * strike[i] * n2;
+        price[i] = dfn1 - dkn2;
+        delta[i] = w * discount * growth * n1;
+        gamma[i] = df * pdf / (k.spot * k.spot * sd);
+        vega[i] = df * pdf * sqrt_t * 0.01;
+        theta[i] = -(df * pdf * volatility[i] / (2.0 * sqrt_t) + (b - k.rate) * dfn1 + k.rate * dkn2) * k.day_fraction;
+    }
+#endif
+}
+
+} // namespace
+
+void GreeksEngine::Inputs::resize(size_t n) {
+    strike.resize(n);
+    tau.resize(n);
+    volatility.resize(n);
+    sign.resize(n);
+    spot_model.resize(n);
+}
+
+void GreeksEngine::Outputs::resize(size_t n) {
+    price.assign(n, 0.0);
+    delta.assign(n, 0.0);
+    gamma.assign(n, 0.0);
+    vega.assign(n, 0.0);
+    theta.assign(n, 0.0);
+}
+
+GreeksEngine::GreeksEngine() : GreeksEngine(Config{}) {}
+
+GreeksEngine::GreeksEngine(const Config& config)
+    : config_(config)
+    , view_(std::make_unique<ImpactView>())
+    , valuation_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count()) {
+    if (config_.days_per_year <= 0.0 || config_.default_volatility <= 0.0) {
+        throw std::invalid_argument("GreeksEngine: days per year and default volatility must be positive");
+    }
+}
+
+void GreeksEngine::add_contracts(const std::vector<Contract>& contracts) {
+    for (const auto& contract : contracts) {
+        if (contract.contract_id == 0 || !(contract.strike > 0.0) || !(contract.multiplier > 0.0)) {
+            throw std::invalid_argument("GreeksEngine: contract needs an id, a positive strike and multiplier");
+        }
+    }
+
+    std::lock_guard<std::mutex> recompute_lock(recompute_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Everything known, with what it carries over, then the additions
+    struct Entry {
+        Contract contract;
+        double volatility;
+        double quantity;
+        Greeks greeks;
+    };
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, size_t> entry_index;
+    entries.reserve(slot_index_.size() + contracts.size());
+    for (uint32_t s = 0; s < contracts_.size(); ++s) {
+        if (contracts_[s].contract_id == 0) continue;
+        entry_index.emplace(contracts_[s].contract_id, entries.size());
+        entries.push_back({contracts_[s], volatility_[s], position_[s] / contracts_[s].multiplier,
+                           {published_.price[s], published_.delta[s], published_.gamma[s], published_.vega[s],
+                            published_.theta[s]}});
+    }
+    for (const auto& contract : contracts) {
+        auto [it, added] = entry_index.emplace(contract.contract_id, entries.size());
+        if (added) {
+            entries.push_back({contract, config_.default_volatility, 0.0, {}});
+        } else {
+            entries[it->second].contract = contract;
+            entries[it->second].greeks = {}; // Until repriced
+        }
+    }
+    // Chains in expiry, strike order
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return std::tie(a.contract.underlying_id, a.contract.expiry_ns, a.contract.strike, a.contract.type) <
+               std::tie(b.contract.underlying_id, b.contract.expiry_ns, b.contract.strike, b.contract.type);
+    });
+
+    std::unordered_map<uint64_t, Underlying> previous;
+    for (const auto& underlying : underlyings_) {
+        previous.emplace(underlying.id, underlying);
+    }
+    contracts_.clear();
+    slot_underlying_.clear();
+    slot_index_.clear();
+    underlyings_.clear();
+    underlying_index_.clear();
+    volatility_.clear();
+    position_.clear();
+    std::vector<Greeks> greeks;
+    for (size_t e = 0; e < entries.size();) {
+        Underlying underlying;
+        underlying.id = entries[e].contract.underlying_id;
+        if (auto it = previous.find(underlying.id); it != previous.end()) {
+            underlying.price = it->second.price;
+            underlying.dividend_yield = it->second.dividend_yield;
+            underlying.sums.underlying_price = it->second.sums.underlying_price;
+        }
+        underlying.begin = static_cast<uint32_t>(contracts_.size());
+        const auto index = static_cast<uint32_t>(underlyings_.size());
+        for (; e < entries.size() && entries[e].contract.underlying_id == underlying.id; ++e) {
+            slot_index_.emplace(entries[e].contract.contract_id, static_cast<uint32_t>(contracts_.size()));
+            contracts_.push_back(entries[e].contract);
+            volatility_.push_back(entries[e].volatility);
+            position_.push_back(entries[e].quantity * entries[e].contract.multiplier);
+            greeks.push_back(entries[e].greeks);
+        }
+        while (contracts_.size() % BLOCK != 0) {
+            contracts_.push_back(PADDING);
+            volatility_.push_back(config_.default_volatility);
+            position_.push_back(0.0);
+            greeks.push_back({});
+        }
+        underlying.end = static_cast<uint32_t>(contracts_.size());
+        slot_underlying_.resize(contracts_.size(), index);
+        underlying_index_.emplace(underlying.id, index);
+        underlyings_.push_back(underlying);
+    }
+
+    const size_t n = contracts_.size();
+    block_dirty_.assign(n / BLOCK, 0);
+    inputs_.resize(n);
+    outputs_.resize(n);
+    published_.resize(n);
+    for (size_t s = 0; s < n; ++s) {
+        inputs_.strike[s] = contracts_[s].strike;
+        inputs_.sign[s] = contracts_[s].type == OptionType::PUT ? -1.0 : 1.0;
+        inputs_.spot_model[s] = contracts_[s].model == Model::BLACK_SCHOLES ? 1.0 : 0.0;
+        published_.price[s] = greeks[s].price;
+        published_.delta[s] = greeks[s].delta;
+        published_.gamma[s] = greeks[s].gamma;
+        published_.vega[s] = greeks[s].vega;
+        published_.theta[s] = greeks[s].theta;
+    }
+    for (auto& underlying : underlyings_) {
+        resum(underlying, underlying.sums.underlying_price);
+    }
+    publish_view();
+    // New slots need their time to expiry: the next recompute() is a full one
+    valuation_dirty_ = true;
+    stats_.contracts = slot_index_.size();
+    stats_.underlyings = underlyings_.size();
+    LOG_INFO("GreeksEngine: {} contracts on {} underlyings", stats_.contracts, stats_.underlyings);
+}
+
+size_t GreeksEngine::num_contracts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slot_index_.size();
+}
+
+bool GreeksEngine::is_option(uint64_t contract_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slot(contract_id) != INVALID_INDEX;
+}
+
+uint32_t GreeksEngine::slot(uint64_t contract_id) const {
+    auto it = slot_index_.find(contract_id);
+    return it == slot_index_.end() ? INVALID_INDEX : it->second;
+}
+
+double GreeksEngine::year_fraction(int64_t expiry_ns) const {
+    const double days = static_cast<double>(expiry_ns - valuation_ns_) / NS_PER_DAY;
+    return std::max(days / config_.days_per_year, MIN_TAU);
+}
+
+void GreeksEngine::set_underlying_price(uint64_t underlying_id, double price) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = underlying_index_.find(underlying_id);
+    if (it == underlying_index_.end() || !(price > 0.0)) return;
+    Underlying& underlying = underlyings_[it->second];
+    if (underlying.price != price) {
+        underlying.price = price;
+        underlying.dirty = true;
+    }
+}
+
+void GreeksEngine::set_dividend_yield(uint64_t underlying_id, double yield) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = underlying_index_.find(underlying_id);
+    if (it == underlying_index_.end()) return;
+    Underlying& underlying = underlyings_[it->second];
+    if (underlying.dividend_yield != yield) {
+        underlying.dividend_yield = yield;
+        underlying.dirty = true;
+    }
+}
+
+void GreeksEngine::set_volatility(uint64_t contract_id, double volatility) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    if (s == INVALID_INDEX) return;
+    volatility = std::max(volatility, MIN_VOLATILITY);
+    if (volatility_[s] != volatility) {
+        volatility_[s] = volatility;
+        block_dirty_[s / BLOCK] = 1;
+    }
+}
+
+void GreeksEngine::set_underlying_volatility(uint64_t underlying_id, double volatility) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = underlying_index_.find(underlying_id);
+    if (it == underlying_index_.end()) return;
+    Underlying& underlying = underlyings_[it->second];
+    std::fill(volatility_.begin() + underlying.begin, volatility_.begin() + underlying.end,
+              std::max(volatility, MIN_VOLATILITY));
+    underlying.dirty = true;
+}
+
+void GreeksEngine::set_valuation_time(int64_t now_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    valuation_ns_ = now_ns;
+    valuation_dirty_ = true;
+}
+
+bool GreeksEngine::on_fill(uint64_t contract_id, double signed_quantity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    if (s == INVALID_INDEX) return false;
+    move_position(s, signed_quantity * contracts_[s].multiplier);
+    return true;
+}
+
+bool GreeksEngine::set_position(uint64_t contract_id, double quantity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    if (s == INVALID_INDEX) return false;
+    move_position(s, quantity * contracts_[s].multiplier - position_[s]);
+    return true;
+}
+
+double GreeksEngine::position(uint64_t contract_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    return s == INVALID_INDEX ? 0.0 : position_[s] / contracts_[s].multiplier;
+}
+
+// The sums move by change x the contract's current Greeks, O(1)
+void GreeksEngine::move_position(uint32_t s, double delta) {
+    position_[s] += delta;
+    Sensitivities& sums = underlyings_[slot_underlying_[s]].sums;
+    sums.value += delta * published_.price[s];
+    sums.delta += delta * published_.delta[s];
+    sums.gamma += delta * published_.gamma[s];
+    sums.vega += delta * published_.vega[s];
+    sums.theta += delta * published_.theta[s];
+    publish_sums(slot_underlying_[s]);
+}
+
+// Fresh sums over the chain, so fills cannot leave rounding behind
+void GreeksEngine::resum(Underlying& underlying, double spot) {
+    Sensitivities sums;
+    sums.underlying_price = spot;
+    for (uint32_t s = underlying.begin; s < underlying.end; ++s) {
+        const double quantity = position_[s];
+        sums.value += quantity * published_.price[s];
+        sums.delta += quantity * published_.delta[s];
+        sums.gamma += quantity * published_.gamma[s];
+        sums.vega += quantity * published_.vega[s];
+        sums.theta += quantity * published_.theta[s];
+    }
+    underlying.sums = sums;
+}
+
+void GreeksEngine::publish_view() {
+    auto view = std::make_unique<ImpactView>();
+    const size_t n = contracts_.size();
+    view->slot_index = slot_index_;
+    view->slot_underlying = slot_underlying_;
+    view->multiplier.resize(n);
+    view->greeks = std::make_unique<core::SeqlockCell<Greeks>[]>(n);
+    for (size_t s = 0; s < n; ++s) {
+        view->multiplier[s] = contracts_[s].multiplier;
+        view->greeks[s].store(
+            {published_.price[s], published_.delta[s], published_.gamma[s], published_.vega[s], published_.theta[s]});
+    }
+    view->underlyings = std::make_unique<UnderlyingView[]>(underlyings_.size());
+    for (size_t u = 0; u < underlyings_.size(); ++u) {
+        view->underlyings[u].id = underlyings_[u].id;
+        view->underlyings[u].sums.store(underlyings_[u].sums);
+    }
+    view_.publish(std::move(view));
+}
+
+void GreeksEngine::publish_sums(uint32_t u) {
+    UnderlyingView& underlying = view_.load()->underlyings[u];
+    core::Seqlock::WriteGuard write(underlying.sequence);
+    underlying.sums.store(underlyings_[u].sums);
+}
+
+void GreeksEngine::publish_chain(uint32_t u) {
+    const ImpactView& view = *view_.load();
+    UnderlyingView& underlying = view.underlyings[u];
+    core::Seqlock::WriteGuard write(underlying.sequence);
+    for (uint32_t s = underlyings_[u].begin; s < underlyings_[u].end; ++s) {
+        view.greeks[s].store(
+            {published_.price[s], published_.delta[s], published_.gamma[s], published_.vega[s], published_.theta[s]});
+    }
+    underlying.sums.store(underlyings_[u].sums);
+}
+
+size_t GreeksEngine::recompute() {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> recompute_lock(recompute_mutex_);
+
+    // Take the marked blocks and their inputs
+    blocks_.clear();
+    touched_.clear();
+    block_spot_.clear();
+    block_carry_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (valuation_dirty_) {
+            for (size_t s = 0; s < contracts_.size(); ++s) {
+                inputs_.tau[s] = contracts_[s].contract_id == 0 ? 1.0 : year_fraction(contracts_[s].expiry_ns);
+            }
+            for (auto& underlying : underlyings_) {
+                underlying.dirty = true;
+            }
+            valuation_dirty_ = false;
+        }
+        for (uint32_t u = 0; u < underlyings_.size(); ++u) {
+            Underlying& underlying = underlyings_[u];
+            if (underlying.price <= 0.0) {
+                continue; // Stays marked until it has a price
+            }
+            const size_t marked = blocks_.size();
+            for (uint32_t block = underlying.begin / BLOCK; block < underlying.end / BLOCK; ++block) {
+                if (!underlying.dirty && !block_dirty_[block]) continue;
+                block_dirty_[block] = 0;
+                blocks_.push_back(block);
+                block_spot_.push_back(underlying.price);
+                block_carry_.push_back(config_.rate - underlying.dividend_yield);
+                std::copy_n(volatility_.begin() + block * BLOCK, BLOCK, inputs_.volatility.begin() + block * BLOCK);
+            }
+            underlying.dirty = false;
+            if (blocks_.size() > marked) {
+                touched_.push_back(u);
+            }
+        }
+    }
+    if (blocks_.empty()) {
+        return 0;
+    }
+
+    // The kernels, unlocked
+    const double day_fraction = 1.0 / config_.days_per_year;
+    for (size_t k = 0; k < blocks_.size(); ++k) {
+        const size_t base = blocks_[k] * BLOCK;
+        price_block(&inputs_.strike[base], &inputs_.tau[base], &inputs_.volatility[base], &inputs_.sign[base],
+                    &inputs_.spot_model[base], &outputs_.price[base], &outputs_.delta[base], &outputs_.gamma[base],
+                    &outputs_.vega[base], &outputs_.theta[base],
+                    Kernel{block_spot_[k], block_carry_[k], config_.rate, day_fraction});
+    }
+
+    // Publish and re-sum what moved
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t block : blocks_) {
+        const size_t base = block * BLOCK;
+        std::copy_n(outputs_.price.begin() + base, BLOCK, published_.price.begin() + base);
+        std::copy_n(outputs_.delta.begin() + base, BLOCK, published_.delta.begin() + base);
+        std::copy_n(outputs_.gamma.begin() + base, BLOCK, published_.gamma.begin() + base);
+        std::copy_n(outputs_.vega.begin() + base, BLOCK, published_.vega.begin() + base);
+        std::copy_n(outputs_.theta.begin() + base, BLOCK, published_.theta.begin() + base);
+    }
+    size_t k = 0;
+    for (uint32_t u : touched_) {
+        // Spot of the first block taken from this underlying
+        while (blocks_[k] * BLOCK < underlyings_[u].begin) ++k;
+        resum(underlyings_[u], block_spot_[k]);
+        publish_chain(u);
+    }
+    stats_.recomputes++;
+    stats_.repriced += blocks_.size() * BLOCK;
+    stats_.last_elapsed_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return blocks_.size() * BLOCK;
+}
+
+GreeksEngine::Greeks GreeksEngine::greeks(uint64_t contract_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    if (s == INVALID_INDEX) return {};
+    return {published_.price[s], published_.delta[s], published_.gamma[s], published_.vega[s], published_.theta[s]};
+}
+
+GreeksEngine::Sensitivities GreeksEngine::sensitivities(uint64_t underlying_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = underlying_index_.find(underlying_id);
+    return it == underlying_index_.end() ? Sensitivities{} : underlyings_[it->second].sums;
+}
+
+std::vector<std::pair<uint64_t, GreeksEngine::Sensitivities>> GreeksEngine::all_sensitivities() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<uint64_t, Sensitivities>> result;
+    result.reserve(underlyings_.size());
+    for (const auto& underlying : underlyings_) {
+        result.emplace_back(underlying.id, underlying.sums);
+    }
+    return result;
+}
+
+GreeksEngine::Impact GreeksEngine::order_impact(uint64_t contract_id, double signed_quantity) const {
+    core::RcuReadGuard guard;
+    const ImpactView& view = *view_.load();
+    Impact impact;
+    auto it = view.slot_index.find(contract_id);
+    if (it == view.slot_index.end()) return impact;
+    const uint32_t s = it->second;
+    const UnderlyingView& underlying = view.underlyings[view.slot_underlying[s]];
+    Greeks greeks;
+    impact.current = underlying.sequence.read([&]() {
+        greeks = view.greeks[s].load();
+        return underlying.sums.load();
+    });
+    const double quantity = signed_quantity * view.multiplier[s];
+    impact.option = true;
+    impact.underlying_id = underlying.id;
+    impact.projected = impact.current;
+    impact.projected.value += quantity * greeks.price;
+    impact.projected.delta += quantity * greeks.delta;
+    impact.projected.gamma += quantity * greeks.gamma;
+    impact.projected.vega += quantity * greeks.vega;
+    impact.projected.theta += quantity * greeks.theta;
+    return impact;
+}
+
+GreeksEngine::Stats GreeksEngine::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace goldearn::risk
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "../core/rcu.hpp"
+#include "../core/seqlock.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace goldearn::risk {
+
+// Prices, Greeks and per-underlying sensitivities of an options book.
+//
+// Contracts are stored structure-of-arrays, grouped by underlying, each
+// chain padded to a multiple of four so one AVX2 kernel call prices four
+// contracts on the same underlying. Black-Scholes contracts (on the index or
+// a stock, with a continuous dividend yield) and Black-76 contracts (on a
+// future) share the kernel: both price off the forward F = U e^(bT), with
+// carry b = r - q for Black-Scholes and b = 0 for Black-76.
+//
+// Only what moved is repriced. An underlying price or the valuation time
+// marks whole chains, a volatility its block of four; recompute() reprices
+// the marked blocks, then re-sums the touched underlyings. Fills move the
+// sums by quantity x Greeks, O(1), so the pre-trade check reads current
+// sensitivities without waiting for a recompute.
+//
+// Inputs, fills and reads are thread-safe. recompute() runs the kernels
+// outside the lock and publishes under it; concurrent calls serialize.
+// order_impact() takes no lock: it reads an RCU-published layout and, per
+// underlying, the sums and chain Greeks under a sequence lock.
+class GreeksEngine {
+public:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    enum class OptionType : uint8_t { CALL, PUT };
+    enum class Model : uint8_t { BLACK_SCHOLES, BLACK_76 };
+
+    struct Contract {
+        uint64_t contract_id = 0;   // Symbol id the option trades under
+        uint64_t underlying_id = 0; // Index, stock or future it is written on
+        OptionType type = OptionType::CALL;
+        Model model = Model::BLACK_SCHOLES;
+        double strike = 0.0;
+        int64_t expiry_ns = 0;      // Since the epoch
+        double multiplier = 1.0;    // Currency per point per unit of quantity
+    };
+
+    struct Config {
+        double rate = 0.065;              // Continuously compounded, annual
+        double default_volatility = 0.15; // Until a contract gets its own
+        double days_per_year = 365.0;
+    };
+
+    // One contract, per unit of quantity
+    struct Greeks {
+        double price = 0.0;
+        double delta = 0.0; // d price / d underlying
+        double gamma = 0.0;
+        double vega = 0.0;  // Per vol point (0.01)
+        double theta = 0.0; // Per calendar day
+    };
+
+    // Quantity x multiplier weighted sums over one underlying's contracts
+    struct Sensitivities {
+        double underlying_price = 0.0;
+        double value = 0.0;
+        double delta = 0.0; // Units of the underlying
+        double gamma = 0.0;
+        double vega = 0.0;  // Currency per vol point
+        double theta = 0.0; // Currency per day
+
+        double delta_notional() const { return delta * underlying_price; }
+        // Change in delta notional for a 1% move in the underlying
+        double gamma_notional() const { return gamma * underlying_price * underlying_price * 0.01; }
+    };
+
+    struct Impact {
+        bool option = false;        // False: not a known contract, nothing below is set
+        uint64_t underlying_id = 0;
+        Sensitivities current;
+        Sensitivities projected;    // With the order filled at today's Greeks
+    };
+
+    struct Stats {
+        size_t contracts = 0;
+        size_t underlyings = 0;
+        uint64_t recomputes = 0;
+        uint64_t repriced = 0;      // Contract slots, padding included
+        double last_elapsed_us = 0.0;
+    };
+
+    GreeksEngine();
+    explicit GreeksEngine(const Config& config);
+
+    GreeksEngine(const GreeksEngine&) = delete;
+    GreeksEngine& operator=(const GreeksEngine&) = delete;
+
+    // Adds or redefines contracts; positions and volatilities of known ones
+    // are kept. O(n log n), for the daily contract master rather than the
+    // tick path. Throws std::invalid_argument on a bad strike or multiplier.
+    void add_contracts(const std::vector<Contract>& contracts);
+    void add_contract(const Contract& contract) { add_contracts({contract}); }
+    size_t num_contracts() const;
+    bool is_option(uint64_t contract_id) const;
+
+    // Market inputs, for underlyings with contracts (others are ignored);
+    // each marks what it moves for the next recompute()
+    void set_underlying_price(uint64_t underlying_id, double price);
+    void set_dividend_yield(uint64_t underlying_id, double yield);
+    void set_volatility(uint64_t contract_id, double volatility);
+    void set_underlying_volatility(uint64_t underlying_id, double volatility); // Flat across the chain
+    void set_valuation_time(int64_t now_ns);
+
+    // False for a symbol that is not a known contract
+    bool on_fill(uint64_t contract_id, double signed_quantity);
+    bool set_position(uint64_t contract_id, double quantity);
+    double position(uint64_t contract_id) const;
+
+    // Reprices what the inputs marked; returns the contract slots repriced
+    size_t recompute();
+
+    Greeks greeks(uint64_t contract_id) const;
+    Sensitivities sensitivities(uint64_t underlying_id) const;
+    std::vector<std::pair<uint64_t, Sensitivities>> all_sensitivities() const;
+    Impact order_impact(uint64_t contract_id, double signed_quantity) const; // Lock-free
+    Stats get_stats() const;
+
+private:
+    struct Underlying {
+        uint64_t id = 0;
+        double price = 0.0;          // 0 until set; its chain is not priced before
+        double dividend_yield = 0.0;
+        uint32_t begin = 0;          // Slots [begin, end), end a multiple of 4
+        uint32_t end = 0;
+        bool dirty = true;           // Whole chain
+        Sensitivities sums;
+    };
+
+    // Kernel inputs and outputs, one array per field
+    struct Inputs {
+        std::vector<double> strike;
+        std::vector<double> tau;        // Years to expiry, floored
+        std::vector<double> volatility;
+        std::vector<double> sign;       // +1 call, -1 put
+        std::vector<double> spot_model; // 1 Black-Scholes, 0 Black-76
+
+        void resize(size_t n);
+    };
+    struct Outputs {
+        std::vector<double> price;
+        std::vector<double> delta;
+        std::vector<double> gamma;
+        std::vector<double> vega;
+        std::vector<double> theta;
+
+        void resize(size_t n);
+    };
+
+    // One underlying as order_impact() reads it
+    struct UnderlyingView {
+        uint64_t id = 0;
+        core::Seqlock sequence;                 // Covers sums and the chain's Greeks
+        core::SeqlockCell<Sensitivities> sums;
+    };
+    // Replaced whole by add_contracts(); fills and recompute() rewrite the
+    // cells in place under mutex_
+    struct ImpactView {
+        std::unordered_map<uint64_t, uint32_t> slot_index;
+        std::vector<uint32_t> slot_underlying;
+        std::vector<double> multiplier;
+        std::unique_ptr<core::SeqlockCell<Greeks>[]> greeks; // Per slot
+        std::unique_ptr<UnderlyingView[]> underlyings;
+    };
+
+    Config config_;
+    core::RcuPointer<ImpactView> view_;
+
+    // Serializes recompute() and layout changes; taken before mutex_
+    std::mutex recompute_mutex_;
+    mutable std::mutex mutex_;
+
+    // Under mutex_: layout, inputs and what readers see
+    std::vector<Contract> contracts_;                // Per slot; padding has contract_id 0
+    std::vector<uint32_t> slot_underlying_;
+    std::unordered_map<uint64_t, uint32_t> slot_index_;
+    std::vector<Underlying> underlyings_;
+    std::unordered_map<uint64_t, uint32_t> underlying_index_;
+    std::vector<double> volatility_;                 // Latest per slot
+    std::vector<double> position_;                   // Quantity x multiplier
+    std::vector<uint8_t> block_dirty_;               // Per block of four slots
+    Outputs published_;                              // Greeks of the last recompute()
+    int64_t valuation_ns_;
+    bool valuation_dirty_ = true;
+    Stats stats_;
+
+    // Under recompute_mutex_ only: the kernels' working copy
+    Inputs inputs_;
+    Outputs outputs_;
+    std::vector<uint32_t> blocks_;                   // Repriced this round
+    std::vector<uint32_t> touched_;                  // Underlyings with a repriced block
+    std::vector<double> block_spot_;                 // Per repriced block
+    std::vector<double> block_carry_;
+
+    // Under mutex_
+    uint32_t slot(uint64_t contract_id) const;
+    double year_fraction(int64_t expiry_ns) const;
+    void move_position(uint32_t slot, double delta);
+    void resum(Underlying& underlying, double spot);
+    void publish_view();
+    // The view's copy of one underlying: its sums, or its sums and Greeks
+    void publish_sums(uint32_t underlying);
+    void publish_chain(uint32_t underlying);
+};
+
+} // namespace goldearn::risk
@@ -0,0 +1,270 @@
+#include "incremental_var.hpp"
+#include "risk_engine.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace goldearn::risk {
+
+IncrementalVaR::IncrementalVaR() : IncrementalVaR(Config{}) {}
+
+IncrementalVaR::IncrementalVaR(const Config& config)
+    : config_(config)
+    , z_(-VaRCalculator::inverse_normal_cdf(config.tail_probability))
+    , model_(std::make_unique<Model>()) {}
+
+void IncrementalVaR::set_covariance(const std::vector<uint64_t>& symbols, const std::vector<double>& covariance) {
+    const size_t n = symbols.size();
+    if (covariance.size() != n * n) {
+        throw std::invalid_argument("IncrementalVaR: covariance is not symbols x symbols");
+    }
+    auto next = std::make_unique<Model>();
+    next->n = n;
+    for (size_t i = 0; i < n; ++i) {
+        next->index[symbols[i]] = static_cast<uint32_t>(i);
+    }
+    next->covariance = std::make_shared<const std::vector<double>>(covariance);
+    next->weighted = std::make_unique<core::SeqlockCell<double>[]>(n);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    symbols_ = symbols;
+    exposures_.assign(n, 0.0);
+    for (const auto& [symbol_id, holding] : holdings_) {
+        auto it = next->index.find(symbol_id);
+        if (it != next->index.end()) {
+            exposures_[it->second] = holding.quantity * holding.price;
+        }
+    }
+    ++model_version_;
+    // Readers move to the new model with its sums already in place
+    rebuild_locked(*next);
+    model_.publish(std::move(next));
+}
+
+void IncrementalVaR::set_model(const std::vector<uint64_t>& symbols, const std::vector<double>& volatilities,
+                               const std::vector<double>& correlation) {
+    const size_t n = symbols.size();
+    if (volatilities.size() != n || correlation.size() != n * n) {
+        throw std::invalid_argument("IncrementalVaR: volatilities or correlation do not match the symbols");
+    }
+    std::vector<double> covariance(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            covariance[i * n + j] = volatilities[i] * correlation[i * n + j] * volatilities[j];
+        }
+    }
+    set_covariance(symbols, covariance);
+}
+
+size_t IncrementalVaR::dimension() const {
+    core::RcuReadGuard guard;
+    return model_.load()->n;
+}
+
+uint32_t IncrementalVaR::index(uint64_t symbol_id) const {
+    core::RcuReadGuard guard;
+    const Model& current = *model_.load();
+    auto it = current.index.find(symbol_id);
+    return it != current.index.end() ? it->second : INVALID_INDEX;
+}
+
+uint32_t IncrementalVaR::index_locked(uint64_t symbol_id) const {
+    const Model& current = model();
+    auto it = current.index.find(symbol_id);
+    return it != current.index.end() ? it->second : INVALID_INDEX;
+}
+
+void IncrementalVaR::on_fill(uint64_t symbol_id, double signed_quantity, double price) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Holding& holding = holdings_[symbol_id];
+    holding.quantity += signed_quantity;
+    holding.price = price;
+    const uint32_t i = index_locked(symbol_id);
+    if (i != INVALID_INDEX) {
+        move_exposure(i, holding.quantity * price - exposures_[i]);
+    }
+}
+
+void IncrementalVaR::set_position(uint64_t symbol_id, double quantity, double price) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    holdings_[symbol_id] = Holding{quantity, price};
+    const uint32_t i = index_locked(symbol_id);
+    if (i != INVALID_INDEX) {
+        move_exposure(i, quantity * price - exposures_[i]);
+    }
+}
+
+void IncrementalVaR::mark_price(uint64_t symbol_id, double price) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto holding = holdings_.find(symbol_id);
+    if (holding == holdings_.end()) {
+        return;
+    }
+    holding->second.price = price;
+    const uint32_t i = index_locked(symbol_id);
+    if (i != INVALID_INDEX) {
+        move_exposure(i, holding->second.quantity * price - exposures_[i]);
+    }
+}
+
+// u += d S[:, i] (S is symmetric, so row i), q += 2 d u[i] + d^2 S[i][i]
+void IncrementalVaR::move_exposure(uint32_t i, double delta) {
+    if (delta == 0.0) {
+        return;
+    }
+    const Model& current = model();
+    const size_t n = current.n;
+    const double* row = current.covariance->data() + static_cast<size_t>(i) * n;
+    variance_ += delta * (2.0 * weighted_[i] + delta * row[i]);
+    double* weighted = weighted_.data();
+    for (size_t j = 0; j < n; ++j) {
+        weighted[j] += delta * row[j];
+    }
+    exposures_[i] += delta;
+    ++stats_.updates;
+    publish_sums_locked(current);
+}
+
+void IncrementalVaR::rebuild_locked(const Model& target) {
+    const size_t n = target.n;
+    const double* covariance = target.covariance->data();
+    weighted_.assign(n, 0.0);
+    variance_ = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = covariance + i * n;
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            sum += row[j] * exposures_[j];
+        }
+        weighted_[i] = sum;
+        variance_ += exposures_[i] * sum;
+    }
+    publish_sums_locked(target);
+}
+
+// The readers' copy of u and q; O(n) like the update that preceded it
+void IncrementalVaR::publish_sums_locked(const Model& target) {
+    core::Seqlock::WriteGuard write(target.sequence);
+    target.variance.store(variance_);
+    for (size_t i = 0; i < target.n; ++i) {
+        target.weighted[i].store(weighted_[i]);
+    }
+}
+
+double IncrementalVaR::var_of(double variance, uint32_t days) const {
+    return z_ * std::sqrt(std::max(variance, 0.0) * days);
+}
+
+double IncrementalVaR::var(uint32_t days) const {
+    core::RcuReadGuard guard;
+    return var_of(model_.load()->variance.load(), days);
+}
+
+IncrementalVaR::Impact IncrementalVaR::order_impact(uint64_t symbol_id, double signed_quantity, double price) const {
+    core::RcuReadGuard guard;
+    const Model& current = *model_.load();
+    Impact impact;
+    auto it = current.index.find(symbol_id);
+    if (it == current.index.end()) {
+        impact.current = var_of(current.variance.load(), 1);
+        impact.projected = impact.current;
+        return impact;
+    }
+    const uint32_t i = it->second;
+    double weighted = 0.0;
+    const double variance = current.sequence.read([&]() {
+        weighted = current.weighted[i].load();
+        return current.variance.load();
+    });
+    const double delta = signed_quantity * price;
+    impact.current = var_of(variance, 1);
+    impact.projected = var_of(variance + delta * (2.0 * weighted + delta * (*current.covariance)[i * current.n + i]), 1);
+    return impact;
+}
+
+double IncrementalVaR::marginal_var(uint64_t symbol_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t i = index_locked(symbol_id);
+    if (i == INVALID_INDEX || variance_ <= 0.0) {
+        return 0.0;
+    }
+    return z_ * weighted_[i] / std::sqrt(variance_);
+}
+
+double IncrementalVaR::exposure(uint64_t symbol_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t i = index_locked(symbol_id);
+    return i != INVALID_INDEX ? exposures_[i] : 0.0;
+}
+
+std::unordered_map<uint64_t, double> IncrementalVaR::component_var() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<uint64_t, double> components;
+    if (variance_ <= 0.0) {
+        return components;
+    }
+    const double scale = z_ / std::sqrt(variance_);
+    for (size_t i = 0; i < exposures_.size(); ++i) {
+        if (exposures_[i] != 0.0) {
+            components[symbols_[i]] = exposures_[i] * weighted_[i] * scale;
+        }
+    }
+    return components;
+}
+
+double IncrementalVaR::recompute() {
+    std::shared_ptr<const std::vector<double>> covariance;
+    std::vector<double> exposures, snapshot;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        covariance = model().covariance;
+        exposures = exposures_;
+        snapshot = weighted_;
+        version = model_version_;
+    }
+
+    // The O(n^2) part, unlocked
+    const size_t n = exposures.size();
+    std::vector<double> fresh(n);
+    double scale = 0.0;
+    double drift = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = covariance->data() + i * n;
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            sum += row[j] * exposures[j];
+        }
+        fresh[i] = sum;
+        scale = std::max(scale, std::fabs(sum));
+        drift = std::max(drift, std::fabs(snapshot[i] - sum));
+    }
+    drift = scale > 0.0 ? drift / scale : 0.0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (model_version_ != version) {
+        return 0.0; // set_covariance() rebuilt everything meanwhile
+    }
+    // Fills since the snapshot moved u by (u - snapshot); keep that on top of the fresh base
+    variance_ = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        weighted_[i] = fresh[i] + (weighted_[i] - snapshot[i]);
+        variance_ += exposures_[i] * weighted_[i];
+    }
+    publish_sums_locked(model());
+    ++stats_.recomputes;
+    stats_.last_drift = drift;
+    stats_.max_drift = std::max(stats_.max_drift, drift);
+    if (drift > config_.drift_warning) {
+        LOG_WARN("IncrementalVaR: incremental state drifted by {} (relative) over {} instruments", drift, n);
+    }
+    return drift;
+}
+
+IncrementalVaR::Stats IncrementalVaR::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace goldearn::risk
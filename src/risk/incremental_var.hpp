@@ -0,0 +1,129 @@
+#pragma once
+
+#include "../core/rcu.hpp"
+#include "../core/seqlock.hpp"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace goldearn::risk {
+
+// Parametric portfolio VaR kept current fill by fill.
+//
+// With w the currency exposures and S the daily covariance matrix, the
+// engine keeps u = S w and the variance q = w'S w. A fill that moves w[i]
+// by d costs one column of S: u += d S[:, i] and q += 2 d u[i] + d^2 S[i][i],
+// O(n) instead of the O(n^2) recompute. From u every per-position figure
+// is O(1): marginal VaR z u[i] / sqrt(q), component VaR w[i] times that,
+// and the VaR after a proposed order, which is what the pre-trade check uses.
+//
+// Rounding accumulates in u over many updates, so recompute() rebuilds it
+// from scratch (periodically, off the trading threads) and reports the drift.
+// Only the O(n) merge of the fresh u runs under the lock.
+//
+// var() and order_impact() take no lock: the model is published through RCU
+// and the sums they read sit under a sequence lock, so the pre-trade check
+// never waits on a fill or a recompute.
+//
+// Exposures are position x last price, marked on fills and on mark_price().
+// Symbols outside the covariance model are remembered but carry no risk
+// until a model with them is set.
+class IncrementalVaR {
+public:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    struct Config {
+        double tail_probability = 0.05; // 95% VaR, as VaRCalculator
+        double drift_warning = 1e-9;    // Relative drift in u that recompute() logs
+    };
+
+    struct Impact {
+        double current = 0.0;   // 1-day VaR now
+        double projected = 0.0; // 1-day VaR with the order filled
+    };
+
+    struct Stats {
+        uint64_t updates = 0;
+        uint64_t recomputes = 0;
+        double last_drift = 0.0; // max |u_incremental - u_fresh| / max |u_fresh|
+        double max_drift = 0.0;
+    };
+
+    IncrementalVaR();
+    explicit IncrementalVaR(const Config& config);
+
+    IncrementalVaR(const IncrementalVaR&) = delete;
+    IncrementalVaR& operator=(const IncrementalVaR&) = delete;
+
+    // Row-major daily covariance over `symbols`; positions already held are kept
+    void set_covariance(const std::vector<uint64_t>& symbols, const std::vector<double>& covariance);
+    // Daily volatilities and a row-major correlation matrix
+    void set_model(const std::vector<uint64_t>& symbols, const std::vector<double>& volatilities,
+                   const std::vector<double>& correlation);
+    size_t dimension() const;
+    uint32_t index(uint64_t symbol_id) const;
+
+    // O(n) each
+    void on_fill(uint64_t symbol_id, double signed_quantity, double price);
+    void set_position(uint64_t symbol_id, double quantity, double price);
+    void mark_price(uint64_t symbol_id, double price);
+
+    // O(1), lock-free
+    double var(uint32_t days = 1) const;
+    Impact order_impact(uint64_t symbol_id, double signed_quantity, double price) const;
+    // O(1)
+    double marginal_var(uint64_t symbol_id) const; // d VaR / d exposure
+    double exposure(uint64_t symbol_id) const;
+    // O(n): per position w[i] * marginal, summing to var()
+    std::unordered_map<uint64_t, double> component_var() const;
+
+    // Rebuilds u and q from the exposures; returns the relative drift found
+    double recompute();
+    Stats get_stats() const;
+    double z_score() const { return z_; }
+
+private:
+    struct Holding {
+        double quantity = 0.0;
+        double price = 0.0;
+    };
+
+    // What the lock-free reads see: the model, replaced whole by
+    // set_covariance(), and a copy of the sums every change rewrites in
+    // place under the sequence lock
+    struct Model {
+        size_t n = 0;
+        std::unordered_map<uint64_t, uint32_t> index;
+        // n x n; recompute() reads it unlocked
+        std::shared_ptr<const std::vector<double>> covariance = std::make_shared<const std::vector<double>>();
+        mutable core::Seqlock sequence;
+        mutable core::SeqlockCell<double> variance;             // q
+        std::unique_ptr<core::SeqlockCell<double>[]> weighted;  // u
+    };
+
+    Config config_;
+    double z_; // -quantile of the tail probability
+    core::RcuPointer<Model> model_; // Published under mutex_
+
+    mutable std::mutex mutex_;
+    std::vector<uint64_t> symbols_;
+    std::unordered_map<uint64_t, Holding> holdings_;
+    uint64_t model_version_ = 0;
+    std::vector<double> exposures_;  // w
+    std::vector<double> weighted_;   // u = S w
+    double variance_ = 0.0;          // q = w' S w
+    Stats stats_;
+
+    // Under mutex_
+    const Model& model() const { return *model_.load(); }
+    uint32_t index_locked(uint64_t symbol_id) const;
+    void move_exposure(uint32_t i, double delta);
+    void rebuild_locked(const Model& target);
+    void publish_sums_locked(const Model& target);
+    double var_of(double variance, uint32_t days) const;
+};
+
+} // namespace goldearn::risk
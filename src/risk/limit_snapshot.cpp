@@ -0,0 +1,220 @@
+#include "limit_snapshot.hpp"
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace goldearn::risk {
+
+namespace {
+
+struct FieldAccess {
+    std::string_view name;
+    bool (*accepts)(double);
+    void (*set)(RiskLimits&, double);
+    double (*get)(const RiskLimits&);
+};
+
+// A limit of type T can hold `value`: finite and non-negative, and for an
+// integer field a whole number within the type's range
+template<typename T>
+bool accepts_value(double value) {
+    // Written so a NaN fails it as well
+    if (!(value >= 0.0 && value <= std::numeric_limits<double>::max())) {
+        return false;
+    }
+    if constexpr (std::is_integral_v<T>) {
+        // 2^digits is exact as a double where the type's max() may not be
+        return value == std::trunc(value) && value < std::ldexp(1.0, std::numeric_limits<T>::digits);
+    }
+    return true;
+}
+
+#define LIMIT_FIELD(member)                                                                    \
+    FieldAccess {                                                                              \
+        #member,                                                                               \
+        &accepts_value<decltype(RiskLimits::member)>,                                          \
+        [](RiskLimits& limits, double value) {                                                 \
+            limits.member = static_cast<decltype(RiskLimits::member)>(value);                  \
+        },                                                                                     \
+        [](const RiskLimits& limits) { return static_cast<double>(limits.member); }           \
+    }
+
+// Indexed by LimitField
+const FieldAccess FIELDS[] = {
+    LIMIT_FIELD(max_position_size),
+    LIMIT_FIELD(max_portfolio_exposure),
+    LIMIT_FIELD(max_strategy_exposure),
+    LIMIT_FIELD(max_sector_concentration),
+    LIMIT_FIELD(max_order_size),
+    LIMIT_FIELD(max_order_value),
+    LIMIT_FIELD(max_orders_per_second),
+    LIMIT_FIELD(max_orders_per_minute),
+    LIMIT_FIELD(max_price_deviation),
+    LIMIT_FIELD(min_spread_bps),
+    LIMIT_FIELD(max_market_impact),
+    LIMIT_FIELD(max_var_1d),
+    LIMIT_FIELD(max_var_10d),
+    LIMIT_FIELD(max_portfolio_volatility),
+    LIMIT_FIELD(max_correlation_exposure),
+    LIMIT_FIELD(max_underlying_delta),
+    LIMIT_FIELD(max_underlying_gamma),
+    LIMIT_FIELD(max_underlying_vega),
+    LIMIT_FIELD(max_portfolio_margin),
+    LIMIT_FIELD(max_daily_loss),
+    LIMIT_FIELD(max_drawdown),
+    LIMIT_FIELD(max_consecutive_losses),
+    LIMIT_FIELD(position_hold_time_limit_ms),
+    LIMIT_FIELD(order_lifetime_limit_ms),
+};
+static_assert(std::size(FIELDS) == static_cast<size_t>(LimitField::COUNT));
+
+#undef LIMIT_FIELD
+
+// "strategy.<id>.<field>" / "symbol.<id>.<field>" / "<field>"
+struct LimitName {
+    enum Scope { GLOBAL, STRATEGY, SYMBOL } scope = GLOBAL;
+    std::string_view key;
+    uint64_t symbol_id = 0;
+    LimitField field = LimitField::COUNT;
+};
+
+std::optional<LimitName> parse_name(std::string_view name) {
+    LimitName parsed;
+    size_t field_start = name.rfind('.');
+    std::string_view field_name = field_start == std::string_view::npos ? name : name.substr(field_start + 1);
+    auto field = limit_field(field_name);
+    if (!field) {
+        return std::nullopt;
+    }
+    parsed.field = *field;
+    if (field_start == std::string_view::npos) {
+        return parsed;
+    }
+
+    std::string_view scope = name.substr(0, field_start);
+    if (scope.starts_with("strategy.") && scope.size() > 9) {
+        parsed.scope = LimitName::STRATEGY;
+        parsed.key = scope.substr(9);
+        return parsed;
+    }
+    if (scope.starts_with("symbol.")) {
+        parsed.scope = LimitName::SYMBOL;
+        parsed.key = scope.substr(7);
+        auto [end, error] = std::from_chars(parsed.key.data(), parsed.key.data() + parsed.key.size(),
+                                            parsed.symbol_id);
+        if (error == std::errc() && end == parsed.key.data() + parsed.key.size()) {
+            return parsed;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+std::optional<LimitField> limit_field(std::string_view name) {
+    for (size_t i = 0; i < std::size(FIELDS); ++i) {
+        if (FIELDS[i].name == name) {
+            return static_cast<LimitField>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view limit_field_name(LimitField field) {
+    return FIELDS[static_cast<size_t>(field)].name;
+}
+
+bool limit_field_accepts(LimitField field, double value) {
+    return FIELDS[static_cast<size_t>(field)].accepts(value);
+}
+
+void set_limit_field(RiskLimits& limits, LimitField field, double value) {
+    FIELDS[static_cast<size_t>(field)].set(limits, value);
+}
+
+double get_limit_field(const RiskLimits& limits, LimitField field) {
+    return FIELDS[static_cast<size_t>(field)].get(limits);
+}
+
+void LimitOverrides::set(LimitField field, double value) {
+    fields |= 1u << static_cast<uint32_t>(field);
+    set_limit_field(values, field, value);
+}
+
+void LimitOverrides::apply_to(RiskLimits& limits) const {
+    for (uint32_t bits = fields; bits != 0; bits &= bits - 1) {
+        auto field = static_cast<LimitField>(__builtin_ctz(bits));
+        set_limit_field(limits, field, get_limit_field(values, field));
+    }
+}
+
+RiskLimits LimitSnapshot::resolve(const std::string& strategy_id, uint64_t symbol_id) const {
+    RiskLimits limits = strategy_limits(strategy_id);
+    if (const LimitOverrides* overrides = symbol_overrides(symbol_id)) {
+        overrides->apply_to(limits);
+    }
+    return limits;
+}
+
+RiskLimits LimitSnapshot::strategy_limits(const std::string& strategy_id) const {
+    RiskLimits limits = global_;
+    if (const LimitOverrides* overrides = strategy_overrides(strategy_id)) {
+        overrides->apply_to(limits);
+    }
+    return limits;
+}
+
+const LimitOverrides* LimitSnapshot::strategy_overrides(const std::string& strategy_id) const {
+    auto it = strategies_.find(strategy_id);
+    return it != strategies_.end() ? &it->second : nullptr;
+}
+
+const LimitOverrides* LimitSnapshot::symbol_overrides(uint64_t symbol_id) const {
+    auto it = symbols_.find(symbol_id);
+    return it != symbols_.end() ? &it->second : nullptr;
+}
+
+std::optional<double> LimitSnapshot::get(std::string_view name) const {
+    auto parsed = parse_name(name);
+    if (!parsed) {
+        return std::nullopt;
+    }
+    const LimitOverrides* overrides = nullptr;
+    if (parsed->scope == LimitName::STRATEGY) {
+        overrides = strategy_overrides(std::string(parsed->key));
+    } else if (parsed->scope == LimitName::SYMBOL) {
+        overrides = symbol_overrides(parsed->symbol_id);
+    }
+    if (parsed->scope != LimitName::GLOBAL && !(overrides && overrides->has(parsed->field))) {
+        return std::nullopt; // Not overridden
+    }
+    return get_limit_field(overrides ? overrides->values : global_, parsed->field);
+}
+
+std::unique_ptr<LimitSnapshot> LimitSnapshot::next_version() const {
+    auto next = std::make_unique<LimitSnapshot>(*this);
+    next->version_ = version_ + 1;
+    return next;
+}
+
+bool LimitSnapshot::set(std::string_view name, double value) {
+    auto parsed = parse_name(name);
+    if (!parsed || !limit_field_accepts(parsed->field, value)) {
+        return false;
+    }
+    switch (parsed->scope) {
+        case LimitName::GLOBAL:
+            set_limit_field(global_, parsed->field, value);
+            break;
+        case LimitName::STRATEGY:
+            strategies_[std::string(parsed->key)].set(parsed->field, value);
+            break;
+        case LimitName::SYMBOL:
+            symbols_[parsed->symbol_id].set(parsed->field, value);
+            break;
+    }
+    return true;
+}
+
+} // namespace goldearn::risk
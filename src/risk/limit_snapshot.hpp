@@ -0,0 +1,103 @@
+#pragma once
+
+#include "risk_engine.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace goldearn::risk {
+
+// RiskLimits fields addressable by name, in declaration order
+enum class LimitField : uint32_t {
+    MAX_POSITION_SIZE = 0,
+    MAX_PORTFOLIO_EXPOSURE,
+    MAX_STRATEGY_EXPOSURE,
+    MAX_SECTOR_CONCENTRATION,
+    MAX_ORDER_SIZE,
+    MAX_ORDER_VALUE,
+    MAX_ORDERS_PER_SECOND,
+    MAX_ORDERS_PER_MINUTE,
+    MAX_PRICE_DEVIATION,
+    MIN_SPREAD_BPS,
+    MAX_MARKET_IMPACT,
+    MAX_VAR_1D,
+    MAX_VAR_10D,
+    MAX_PORTFOLIO_VOLATILITY,
+    MAX_CORRELATION_EXPOSURE,
+    MAX_UNDERLYING_DELTA,
+    MAX_UNDERLYING_GAMMA,
+    MAX_UNDERLYING_VEGA,
+    MAX_PORTFOLIO_MARGIN,
+    MAX_DAILY_LOSS,
+    MAX_DRAWDOWN,
+    MAX_CONSECUTIVE_LOSSES,
+    POSITION_HOLD_TIME_LIMIT_MS,
+    ORDER_LIFETIME_LIMIT_MS,
+    COUNT
+};
+
+// Field by its RiskLimits member name ("max_order_value")
+std::optional<LimitField> limit_field(std::string_view name);
+std::string_view limit_field_name(LimitField field);
+// Finite and non-negative; whole and within range for the integer fields
+bool limit_field_accepts(LimitField field, double value);
+// `value` must be accepted by limit_field_accepts()
+void set_limit_field(RiskLimits& limits, LimitField field, double value);
+double get_limit_field(const RiskLimits& limits, LimitField field);
+
+// Fields a strategy or a symbol sets for itself; the rest come from above
+struct LimitOverrides {
+    uint32_t fields = 0; // Bit per LimitField
+    RiskLimits values;
+
+    bool has(LimitField field) const { return fields >> static_cast<uint32_t>(field) & 1; }
+    void set(LimitField field, double value);
+    void apply_to(RiskLimits& limits) const;
+};
+
+// One version of the risk limits: the global limits plus per-strategy and
+// per-symbol overrides. A limit for an order resolves symbol override, then
+// strategy override, then global.
+//
+// Limits are changed by name:
+//   max_order_value                    global
+//   strategy.<strategy_id>.<field>     one strategy
+//   symbol.<symbol_id>.<field>         one symbol
+//
+// A snapshot is built (next_version() then set()) and published through an
+// RcuPointer; once published it is never modified, so any reader holding it
+// sees one consistent version.
+class LimitSnapshot {
+public:
+    LimitSnapshot() = default;
+    explicit LimitSnapshot(const RiskLimits& global, uint64_t version = 1)
+        : version_(version), global_(global) {}
+
+    uint64_t version() const { return version_; }
+    const RiskLimits& global() const { return global_; }
+    RiskLimits resolve(const std::string& strategy_id, uint64_t symbol_id) const;
+    RiskLimits strategy_limits(const std::string& strategy_id) const;
+    const LimitOverrides* strategy_overrides(const std::string& strategy_id) const;
+    const LimitOverrides* symbol_overrides(uint64_t symbol_id) const;
+    const std::unordered_map<std::string, LimitOverrides>& all_strategy_overrides() const { return strategies_; }
+    const std::unordered_map<uint64_t, LimitOverrides>& all_symbol_overrides() const { return symbols_; }
+    std::optional<double> get(std::string_view name) const;
+
+    // Building a new version (before it is published)
+    std::unique_ptr<LimitSnapshot> next_version() const;
+    // False for an unknown name or a value the field cannot hold (see
+    // limit_field_accepts); nothing is changed then
+    bool set(std::string_view name, double value);
+    void set_global(const RiskLimits& limits) { global_ = limits; }
+
+private:
+    uint64_t version_ = 1;
+    RiskLimits global_;
+    std::unordered_map<std::string, LimitOverrides> strategies_;
+    std::unordered_map<uint64_t, LimitOverrides> symbols_;
+};
+
+} // namespace goldearn::risk
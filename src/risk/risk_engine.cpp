@@ -1,20 +1,86 @@
 #include "risk_engine.hpp"
+#include "greeks_engine.hpp"
+#include "incremental_var.hpp"
+#include "limit_snapshot.hpp"
+#include "risk_state_table.hpp"
+#include "span_margin.hpp"
+#include "violation_store.hpp"
+#include "../config/config_manager.hpp"
+#include "../core/flight_recorder.hpp"
+#include "../core/perf_counters.hpp"
+#include "../core/stats_segment.hpp"
+#include "../trading/kill_switch.hpp"
 #include "../utils/simple_logger.hpp"
 
 namespace goldearn::risk {
 
+namespace {
+const uint32_t STAT_CHECKS = core::StatsSegment::counter("goldearn_risk_checks_total", "Pre-trade risk checks");
+const uint32_t STAT_APPROVED =
+    core::StatsSegment::counter("goldearn_risk_checks_approved_total", "Pre-trade risk checks approved");
+const uint32_t STAT_MAX_LATENCY = core::StatsSegment::gauge(
+    "goldearn_risk_check_max_latency_ns", "Slowest approved pre-trade check", core::stats_layout::MAX);
+
+// Unfilled quantity, positive for buys
+double signed_order_quantity(const trading::Order& order) {
+    double quantity = static_cast<double>(order.leaves_quantity());
+    return order.side == trading::OrderSide::BUY ? quantity : -quantity;
+}
+
+// Limit price, else the expected fill (market orders)
+double order_reference_price(const trading::Order& order, double market_price) {
+    return order.price > 0.0 ? order.price : market_price;
+}
+
+double order_reference_price(const PreTradeContext& context) {
+    return order_reference_price(*context.order, context.estimated_fill_price > 0.0
+                                                     ? context.estimated_fill_price : context.current_market_price);
+}
+
+// Orders that lower a figure pass even when it is above a tightened limit
+bool raises_above(double projected, double current, double limit) {
+    return projected > limit && projected > current;
+}
+
+bool breaches_sensitivities(const GreeksEngine::Impact& impact, double max_delta, double max_gamma,
+                            double max_vega) {
+    auto breaches = [](double projected, double current, double limit) {
+        return raises_above(std::abs(projected), std::abs(current), limit);
+    };
+    return breaches(impact.projected.delta_notional(), impact.current.delta_notional(), max_delta) ||
+           breaches(impact.projected.gamma_notional(), impact.current.gamma_notional(), max_gamma) ||
+           breaches(impact.projected.vega, impact.current.vega, max_vega);
+}
+
+// NSE cash session, 09:15-15:30: scales per-sample covariances to daily ones
+constexpr double TRADING_SECONDS_PER_DAY = 22500.0;
+}
+
 RiskEngine::RiskEngine() 
-    : initialized_(false)
+    : limits_(std::make_unique<LimitSnapshot>(RiskLimits()))
+    , initialized_(false)
     , monitoring_active_(false)
     , circuit_breaker_active_(false)
     , shutdown_requested_(false) {
     LOG_INFO("RiskEngine: Initializing risk engine");
     
-    // Initialize default risk limits
-    limits_ = RiskLimits();
-    
     // Initialize latency tracker
     check_latency_tracker_ = std::make_unique<core::LatencyTracker>("risk_engine");
+    risk_state_ = std::make_unique<RiskStateTable>();
+    portfolio_var_ = std::make_unique<IncrementalVaR>();
+    greeks_ = std::make_unique<GreeksEngine>();
+    span_ = std::make_unique<SpanMargin>();
+    margin_portfolios_ = std::make_unique<std::atomic<uint32_t>[]>(risk_state_->max_strategies());
+    for (uint32_t i = 0; i < risk_state_->max_strategies(); ++i) {
+        margin_portfolios_[i].store(SpanMargin::INVALID_INDEX, std::memory_order_relaxed);
+    }
+    violations_ = std::make_unique<ViolationStore>();
+    daily_loss_reason_ = violations_->intern("Daily loss limit exceeded");
+    var_limit_reason_ = violations_->intern("Portfolio VaR limit exceeded");
+    greeks_limit_reason_ = violations_->intern("Option sensitivity limit exceeded");
+    greeks_cleared_reason_ = violations_->intern("Option sensitivity back within limit");
+    margin_limit_reason_ = violations_->intern("Strategy margin limit exceeded");
+    margin_cleared_reason_ = violations_->intern("Strategy margin back within limit");
     
     // Initialize statistics
     stats_ = RiskEngineStats{};
@@ -54,10 +120,11 @@ void RiskEngine::shutdown() {
     
     LOG_INFO("RiskEngine: Shutting down");
     
-    // Stop monitoring thread
+    // Stop monitoring task
     shutdown_requested_ = true;
-    if (monitoring_thread_.joinable()) {
-        monitoring_thread_.join();
+    if (monitoring_task_id_ != 0) {
+        core::Runtime::instance().cancel(monitoring_task_id_);
+        monitoring_task_id_ = 0;
     }
     
     initialized_ = false;
@@ -68,14 +135,76 @@ void RiskEngine::shutdown() {
 }
 
 void RiskEngine::set_risk_limits(const RiskLimits& limits) {
-    limits_ = limits;
-    LOG_INFO("RiskEngine: Risk limits updated");
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    auto next = limits_.load()->next_version();
+    next->set_global(limits);
+    publish_limits(std::move(next));
+}
+
+RiskLimits RiskEngine::get_risk_limits() const {
+    core::RcuReadGuard guard;
+    return limits_.load()->global();
+}
+
+LimitSnapshot RiskEngine::get_limit_snapshot() const {
+    core::RcuReadGuard guard;
+    return *limits_.load();
+}
+
+uint64_t RiskEngine::get_limits_version() const {
+    core::RcuReadGuard guard;
+    return limits_.load()->version();
+}
+
+bool RiskEngine::update_risk_limit(const std::string& limit_name, double value) {
+    return update_risk_limits({{limit_name, value}});
+}
+
+bool RiskEngine::update_risk_limits(const std::vector<std::pair<std::string, double>>& updates) {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    auto next = limits_.load()->next_version();
+    for (const auto& [name, value] : updates) {
+        if (!next->set(name, value)) {
+            LOG_WARN("RiskEngine: Rejected limit update {} = {}", name, value);
+            return false;
+        }
+    }
+    uint64_t version = next->version();
+    if (!publish_limits(std::move(next))) {
+        return false;
+    }
+    for (const auto& [name, value] : updates) {
+        LOG_INFO("RiskEngine: Limit {} set to {} (version {})", name, value, version);
+    }
+    return true;
+}
+
+size_t RiskEngine::load_risk_limits(config::ConfigManager& config) {
+    if (!config.has_section("risk_limits")) {
+        return 0;
+    }
+    auto section = config.get_section("risk_limits");
+    std::vector<std::pair<std::string, double>> updates;
+    for (const auto& key : section->get_keys()) {
+        try {
+            updates.emplace_back(key, section->get(key).as_double());
+        } catch (const std::exception&) {
+            LOG_ERROR("RiskEngine: risk_limits.{} is not a number; section ignored", key);
+            return 0;
+        }
+    }
+    return update_risk_limits(updates) ? updates.size() : 0;
 }
 
-void RiskEngine::update_risk_limit(const std::string& limit_name, double value) {
-    // This is a simplified implementation
-    // In a real system, you'd have a more sophisticated way to update specific limits
-    LOG_INFO("RiskEngine: Updated limit {} to {}", limit_name, value);
+bool RiskEngine::publish_limits(std::unique_ptr<LimitSnapshot> limits) {
+    // The table carries the same version, so a decision from either path names its snapshot
+    if (!risk_state_->apply_limits(*limits)) {
+        return false;
+    }
+    uint64_t version = limits->version();
+    limits_.publish(std::move(limits));
+    LOG_INFO("RiskEngine: Risk limits version {} published", version);
+    return true;
 }
 
 RiskCheckResult RiskEngine::check_pre_trade_risk(const PreTradeContext& context) {
@@ -83,50 +212,97 @@ RiskCheckResult RiskEngine::check_pre_trade_risk(const PreTradeContext& context)
         return RiskCheckResult::REJECTED_SYSTEM_ERROR;
     }
     
+    PERF_REGION(core::perf_region::RISK_CHECK);
+    core::stats::add(STAT_CHECKS);
     auto start_time = std::chrono::high_resolution_clock::now();
+    uint64_t limits_version = 0;
+    auto record = [&](RiskCheckResult result) {
+        if (context.order) {
+            auto elapsed = std::chrono::high_resolution_clock::now() - start_time;
+            core::flight::risk_result(context.order->symbol_id, static_cast<uint16_t>(result),
+                                      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                      context.order->quantity, limits_version);
+        }
+        return result;
+    };
     
-    // Perform all risk checks
-    auto result = check_position_limits(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_order_size_limits(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_price_limits(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_exposure_limits(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_var_limits(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_rate_limits(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_blacklists(context);
-    if (result != RiskCheckResult::APPROVED) return result;
-    
-    result = check_circuit_breakers(context);
-    if (result != RiskCheckResult::APPROVED) return result;
+    // Registered strategy and symbol: one combined check, then VaR, Greeks and margin
+    RiskCheckResult result;
+    if (context.order && check_registered_order(context, result, limits_version)) {
+        if (result != RiskCheckResult::APPROVED) return record(result);
+    } else {
+        // One limits version for the whole sequence
+        core::RcuReadGuard guard;
+        const LimitSnapshot& snapshot = *limits_.load();
+        limits_version = snapshot.version();
+        RiskLimits limits = context.order
+            ? snapshot.resolve(context.order->strategy_id, context.order->symbol_id) : snapshot.global();
+        
+        // Perform all risk checks
+        result = check_position_limits(context);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_order_size_limits(context, limits);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_price_limits(context);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_exposure_limits(context);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_var_limits(context, snapshot);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_greeks_limits(context, snapshot);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_margin_limits(context, snapshot);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_rate_limits(context);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_blacklists(context);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+        
+        result = check_circuit_breakers(context);
+        if (result != RiskCheckResult::APPROVED) return record(result);
+    }
     
     // Record latency
     auto end_time = std::chrono::high_resolution_clock::now();
     auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
     record_check_latency(latency.count());
+    core::stats::add(STAT_APPROVED);
+    core::stats::set_max(STAT_MAX_LATENCY, static_cast<double>(latency.count()));
     
     update_statistics(RiskCheckResult::APPROVED);
-    return RiskCheckResult::APPROVED;
+    return record(RiskCheckResult::APPROVED);
 }
 
-RiskCheckResult RiskEngine::quick_pre_trade_check(const trading::Order& order) {
+RiskCheckResult RiskEngine::quick_pre_trade_check(const trading::Order& order, double market_price) {
     if (!initialized_.load()) {
         return RiskCheckResult::REJECTED_SYSTEM_ERROR;
     }
     
+    const double price = order_reference_price(order, market_price);
+    if (price <= 0.0) {
+        return RiskCheckResult::REJECTED_PRICE_LIMIT;
+    }
+    RiskCheckResult result;
+    uint64_t limits_version;
+    if (check_risk_state(order, price, result, limits_version)) {
+        return result;
+    }
+    
     // Quick checks for ultra-low latency
-    if (order.price * order.quantity > limits_.max_order_value) {
-        return RiskCheckResult::REJECTED_ORDER_SIZE;
+    {
+        core::RcuReadGuard guard;
+        if (price * static_cast<double>(order.leaves_quantity()) >
+            limits_.load()->resolve(order.strategy_id, order.symbol_id).max_order_value) {
+            return RiskCheckResult::REJECTED_ORDER_SIZE;
+        }
     }
     
     if (is_symbol_blacklisted(order.symbol_id)) {
@@ -140,6 +316,122 @@ RiskCheckResult RiskEngine::quick_pre_trade_check(const trading::Order& order) {
     return RiskCheckResult::APPROVED;
 }
 
+bool RiskEngine::check_risk_state(const trading::Order& order, double price, RiskCheckResult& result,
+                                  uint64_t& limits_version) {
+    uint32_t strategy = risk_state_->strategy_index(order.strategy_id);
+    uint32_t symbol = risk_state_->symbol_index(order.symbol_id);
+    if (strategy == RiskStateTable::INVALID_INDEX || symbol == RiskStateTable::INVALID_INDEX) {
+        return false;
+    }
+    uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    result = risk_state_->check_order(strategy, symbol, order.side, price,
+                                      static_cast<double>(order.leaves_quantity()), now_ns, limits_version);
+    return true;
+}
+
+// Every limit from one table version, found through the strategy's index;
+// the VaR, Greeks and margin impacts are lock-free reads of the engines
+bool RiskEngine::check_registered_order(const PreTradeContext& context, RiskCheckResult& result,
+                                        uint64_t& limits_version) {
+    const trading::Order& order = *context.order;
+    const uint32_t strategy = risk_state_->strategy_index(order.strategy_id);
+    const uint32_t symbol = risk_state_->symbol_index(order.symbol_id);
+    if (strategy == RiskStateTable::INVALID_INDEX || symbol == RiskStateTable::INVALID_INDEX) {
+        return false;
+    }
+    const uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    core::RcuReadGuard guard;
+    const RiskStateTable::TableLimits& limits = risk_state_->limits();
+    limits_version = limits.version;
+    // A market order with no market price cannot be valued against the limits
+    const double price = order_reference_price(context);
+    if (price <= 0.0) {
+        result = RiskCheckResult::REJECTED_PRICE_LIMIT;
+        return true;
+    }
+    const double quantity = signed_order_quantity(order);
+    // The rate window counts the order only once the add-on checks pass too:
+    // an order rejected by them is never sent
+    result = risk_state_->evaluate_order(limits, strategy, symbol, order.side, price, std::fabs(quantity), now_ns);
+    if (result != RiskCheckResult::APPROVED) {
+        return true;
+    }
+
+    auto var = portfolio_var_->order_impact(order.symbol_id, quantity, price);
+    if (raises_above(var.projected, var.current, limits.max_var_1d)) {
+        result = RiskCheckResult::REJECTED_VAR_LIMIT;
+        return true;
+    }
+
+    auto greeks = greeks_->order_impact(order.symbol_id, quantity);
+    if (greeks.option) {
+        auto own = RiskStateTable::underlying_limits(limits, strategy, greeks.underlying_id);
+        if (breaches_sensitivities(greeks, own.max_delta, own.max_gamma, own.max_vega)) {
+            result = RiskCheckResult::REJECTED_GREEKS_LIMIT;
+            return true;
+        }
+    }
+
+    // By name only if registration has not stored the portfolio yet
+    const uint32_t portfolio = margin_portfolios_[strategy].load(std::memory_order_acquire);
+    auto margin = portfolio != SpanMargin::INVALID_INDEX
+        ? span_->order_impact(portfolio, order.symbol_id, quantity)
+        : span_->order_impact(order.strategy_id, order.symbol_id, quantity);
+    if (margin.derivative &&
+        raises_above(margin.projected, margin.current, limits.strategies[strategy].max_portfolio_margin)) {
+        result = RiskCheckResult::REJECTED_MARGIN_LIMIT;
+        return true;
+    }
+    risk_state_->commit_order(strategy, now_ns);
+    return true;
+}
+
+// Registration holds the blacklist lock, so a concurrent blacklist change
+// either finds the new index or is seen here; the entry is published with
+// its block flag already set. The strategy's margin portfolio is created
+// with it, so the check reaches it by index.
+uint32_t RiskEngine::register_strategy(const std::string& strategy_id) {
+    uint32_t strategy;
+    {
+        std::shared_lock<std::shared_mutex> lock(blacklist_mutex_);
+        strategy = risk_state_->add_strategy(strategy_id, blacklisted_strategies_.count(strategy_id) != 0);
+    }
+    if (strategy != RiskStateTable::INVALID_INDEX &&
+        margin_portfolios_[strategy].load(std::memory_order_relaxed) == SpanMargin::INVALID_INDEX) {
+        margin_portfolios_[strategy].store(span_->add_portfolio(strategy_id), std::memory_order_release);
+    }
+    return strategy;
+}
+
+uint32_t RiskEngine::register_symbol(uint64_t symbol_id) {
+    std::shared_lock<std::shared_mutex> lock(blacklist_mutex_);
+    return risk_state_->add_symbol(symbol_id, blacklisted_symbols_.count(symbol_id) != 0);
+}
+
+void RiskEngine::on_symbol_update(const market_data::SymbolUpdateMessage& message) {
+    uint32_t symbol = register_symbol(message.symbol_id);
+    if (symbol != RiskStateTable::INVALID_INDEX) {
+        risk_state_->set_price_band(symbol, message.lower_circuit, message.upper_circuit);
+    }
+}
+
+void RiskEngine::on_fill(const std::string& strategy_id, const trading::ExecutionReport& execution) {
+    uint32_t strategy = risk_state_->strategy_index(strategy_id);
+    uint32_t symbol = risk_state_->symbol_index(execution.symbol_id);
+    if (strategy != RiskStateTable::INVALID_INDEX && symbol != RiskStateTable::INVALID_INDEX) {
+        risk_state_->on_fill(strategy, symbol, execution.side, execution.executed_price,
+                             static_cast<double>(execution.executed_quantity));
+    }
+    double quantity = static_cast<double>(execution.executed_quantity);
+    double signed_quantity = execution.side == trading::OrderSide::BUY ? quantity : -quantity;
+    portfolio_var_->on_fill(execution.symbol_id, signed_quantity, execution.executed_price);
+    greeks_->on_fill(execution.symbol_id, signed_quantity); // No-op unless an option contract
+    span_->on_fill(strategy_id, execution.symbol_id, signed_quantity); // No-op unless a derivative
+}
+
 void RiskEngine::monitor_post_trade(const PostTradeContext& context) {
     if (!initialized_.load()) {
         return;
@@ -149,11 +441,18 @@ void RiskEngine::monitor_post_trade(const PostTradeContext& context) {
     update_portfolio_risk_metrics();
     
     // Check for violations
-    if (context.portfolio_pnl < -limits_.max_daily_loss) {
-        RiskViolation violation(RiskCheckResult::REJECTED_VAR_LIMIT, 
-                              ViolationSeverity::CRITICAL,
-                              "Daily loss limit exceeded");
-        record_violation(violation);
+    RiskLimits limits = get_risk_limits();
+    uint64_t symbol_id = context.execution ? context.execution->symbol_id : 0;
+    if (context.portfolio_pnl < -limits.max_daily_loss) {
+        record_violation(RiskCheckResult::REJECTED_VAR_LIMIT, ViolationSeverity::CRITICAL, daily_loss_reason_,
+                         symbol_id, context.portfolio_pnl, -limits.max_daily_loss);
+    }
+    
+    // The fill already moved the incremental VaR (on_fill); reading it is O(1)
+    double var_1d = portfolio_var_->var(1);
+    if (var_1d > limits.max_var_1d) {
+        record_violation(RiskCheckResult::REJECTED_VAR_LIMIT, ViolationSeverity::WARNING, var_limit_reason_,
+                         symbol_id, var_1d, limits.max_var_1d);
     }
 }
 
@@ -170,7 +469,11 @@ void RiskEngine::start_risk_monitoring() {
     }
     
     shutdown_requested_ = false;
-    monitoring_thread_ = std::thread(&RiskEngine::risk_monitoring_worker, this);
+    if (!market_statistics_ && portfolio_var_->dimension() == 0) {
+        LOG_WARN("RiskEngine: No market statistics or VaR model; VaR limits are not enforced");
+    }
+    monitoring_task_id_ = core::Runtime::instance().background().schedule_periodic(
+        std::chrono::seconds(1), [this]() { risk_monitoring_worker(); }, "risk_monitoring");
     monitoring_active_ = true;
     LOG_INFO("RiskEngine: Risk monitoring started");
 }
@@ -181,67 +484,60 @@ void RiskEngine::stop_risk_monitoring() {
     }
     
     shutdown_requested_ = true;
-    if (monitoring_thread_.joinable()) {
-        monitoring_thread_.join();
-    }
+    core::Runtime::instance().cancel(monitoring_task_id_);
+    monitoring_task_id_ = 0;
     monitoring_active_ = false;
     LOG_INFO("RiskEngine: Risk monitoring stopped");
 }
 
 void RiskEngine::trigger_circuit_breaker(const std::string& reason) {
     circuit_breaker_active_ = true;
+    risk_state_->set_halted(true);
+    if (kill_switch_) {
+        kill_switch_->trip(reason);
+    }
     LOG_ERROR("RiskEngine: Circuit breaker triggered: {}", reason);
     
     RiskViolation violation(RiskCheckResult::REJECTED_CIRCUIT_BREAKER,
                           ViolationSeverity::EMERGENCY,
                           "Circuit breaker: " + reason);
     record_violation(violation);
+    
+    // Preserve the events that led up to the breach
+    core::FlightRecorder::instance().dump("circuit_breaker");
 }
 
 void RiskEngine::reset_circuit_breaker() {
     circuit_breaker_active_ = false;
+    risk_state_->set_halted(false);
+    if (kill_switch_) {
+        kill_switch_->reset();
+    }
     LOG_INFO("RiskEngine: Circuit breaker reset");
 }
 
+void RiskEngine::set_kill_switch(std::shared_ptr<trading::KillSwitch> kill_switch) {
+    kill_switch_ = std::move(kill_switch);
+}
+
 void RiskEngine::set_violation_callback(std::function<void(const RiskViolation&)> callback) {
     violation_callback_ = callback;
 }
 
 std::vector<RiskViolation> RiskEngine::get_recent_violations(uint32_t hours) const {
-    std::shared_lock<std::shared_mutex> lock(violations_mutex_);
-    
-    auto now = std::chrono::high_resolution_clock::now();
-    auto cutoff_time = now - std::chrono::hours(hours);
-    
-    std::vector<RiskViolation> recent_violations;
-    for (const auto& violation : violations_) {
-        // Convert violation timestamp to time_point for comparison
-        auto violation_time = std::chrono::high_resolution_clock::time_point(violation.timestamp);
-        if (violation_time >= cutoff_time) {
-            recent_violations.push_back(violation);
-        }
-    }
-    
-    return recent_violations;
+    auto cutoff = std::chrono::high_resolution_clock::now().time_since_epoch() - std::chrono::hours(hours);
+    return violations_->since(std::chrono::duration_cast<std::chrono::nanoseconds>(cutoff).count());
 }
 
 uint32_t RiskEngine::get_violation_count(ViolationSeverity min_severity) const {
-    std::shared_lock<std::shared_mutex> lock(violations_mutex_);
-    
-    uint32_t count = 0;
-    for (const auto& violation : violations_) {
-        if (violation.severity >= min_severity) {
-            count++;
-        }
-    }
-    
-    return count;
+    return static_cast<uint32_t>(violations_->count(min_severity));
 }
 
 void RiskEngine::add_symbol_to_blacklist(uint64_t symbol_id, const std::string& reason) {
     std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
     blacklisted_symbols_.insert(symbol_id);
     symbol_blacklist_reasons_[symbol_id] = reason;
+    risk_state_->set_symbol_blocked(risk_state_->symbol_index(symbol_id), true);
     LOG_WARN("RiskEngine: Symbol {} blacklisted: {}", symbol_id, reason);
 }
 
@@ -249,6 +545,7 @@ void RiskEngine::remove_symbol_from_blacklist(uint64_t symbol_id) {
     std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
     blacklisted_symbols_.erase(symbol_id);
     symbol_blacklist_reasons_.erase(symbol_id);
+    risk_state_->set_symbol_blocked(risk_state_->symbol_index(symbol_id), false);
     LOG_INFO("RiskEngine: Symbol {} removed from blacklist", symbol_id);
 }
 
@@ -261,6 +558,7 @@ void RiskEngine::add_strategy_to_blacklist(const std::string& strategy_id, const
     std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
     blacklisted_strategies_.insert(strategy_id);
     strategy_blacklist_reasons_[strategy_id] = reason;
+    risk_state_->set_strategy_blocked(risk_state_->strategy_index(strategy_id), true);
     LOG_WARN("RiskEngine: Strategy {} blacklisted: {}", strategy_id, reason);
 }
 
@@ -268,6 +566,7 @@ void RiskEngine::remove_strategy_from_blacklist(const std::string& strategy_id)
     std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
     blacklisted_strategies_.erase(strategy_id);
     strategy_blacklist_reasons_.erase(strategy_id);
+    risk_state_->set_strategy_blocked(risk_state_->strategy_index(strategy_id), false);
     LOG_INFO("RiskEngine: Strategy {} removed from blacklist", strategy_id);
 }
 
@@ -277,9 +576,7 @@ bool RiskEngine::is_strategy_blacklisted(const std::string& strategy_id) const {
 }
 
 double RiskEngine::calculate_portfolio_var(uint32_t days) const {
-    // Simplified VaR calculation
-    // In a real system, this would use historical data and proper statistical methods
-    return 100000.0; // Placeholder
+    return portfolio_var_->var(days);
 }
 
 double RiskEngine::calculate_strategy_var(const std::string& strategy_id, uint32_t days) const {
@@ -287,6 +584,29 @@ double RiskEngine::calculate_strategy_var(const std::string& strategy_id, uint32
     return 50000.0; // Placeholder
 }
 
+double RiskEngine::calculate_order_impact_on_var(const trading::Order& order) const {
+    auto impact = portfolio_var_->order_impact(order.symbol_id, signed_order_quantity(order), order.price);
+    return impact.projected - impact.current;
+}
+
+double RiskEngine::calculate_position_correlation(uint64_t symbol_id,
+                                                  const std::unordered_map<uint64_t, double>& positions) const {
+    if (!market_statistics_) {
+        return 0.0;
+    }
+    auto snapshot = market_statistics_->snapshot();
+    double weighted = 0.0;
+    double total = 0.0;
+    for (const auto& [other, exposure] : positions) {
+        if (other == symbol_id) {
+            continue;
+        }
+        weighted += std::fabs(exposure) * snapshot.correlation(symbol_id, other);
+        total += std::fabs(exposure);
+    }
+    return total > 0.0 ? weighted / total : 0.0;
+}
+
 double RiskEngine::calculate_correlation_risk() const {
     // Simplified correlation risk calculation
     return 0.1; // Placeholder
@@ -301,19 +621,39 @@ void RiskEngine::set_position_manager(std::shared_ptr<trading::PositionManager>
     position_manager_ = pos_mgr;
 }
 
+void RiskEngine::set_market_statistics(std::shared_ptr<const market_data::MarketStatistics> statistics) {
+    {
+        std::lock_guard<std::mutex> lock(var_model_mutex_);
+        market_statistics_ = std::move(statistics);
+        var_model_samples_ = 0; // A new source builds its model at once
+    }
+    refresh_var_model();
+}
+
 double RiskEngine::get_current_exposure() const {
     // Simplified exposure calculation
     return 5000000.0; // Placeholder
 }
 
 double RiskEngine::get_available_buying_power() const {
-    // Simplified buying power calculation
-    return 10000000.0; // Placeholder
+    double capital;
+    {
+        core::RcuReadGuard guard;
+        capital = limits_.load()->global().max_portfolio_margin;
+    }
+    return capital - span_->total_margin();
 }
 
 RiskEngine::RiskEngineStats RiskEngine::get_statistics() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    return stats_;
+    RiskEngineStats stats;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats = stats_;
+    }
+    // Retained violations cover the last 24 hours
+    stats.violations_today = static_cast<uint32_t>(violations_->count(ViolationSeverity::INFO));
+    stats.last_violation_time = market_data::Timestamp(violations_->last_timestamp_ns());
+    return stats;
 }
 
 void RiskEngine::reset_statistics() {
@@ -330,6 +670,7 @@ RiskEngine::RiskReport RiskEngine::generate_risk_report() const {
     report.concentration_risk = calculate_concentration_risk();
     report.correlation_risk = calculate_correlation_risk();
     report.circuit_breaker_status = circuit_breaker_active_.load();
+    report.recent_violations = get_recent_violations(24);
     report.report_time = std::chrono::duration_cast<market_data::Timestamp>(
         std::chrono::high_resolution_clock::now().time_since_epoch()
     );
@@ -343,11 +684,11 @@ RiskCheckResult RiskEngine::check_position_limits(const PreTradeContext& context
     return RiskCheckResult::APPROVED;
 }
 
-RiskCheckResult RiskEngine::check_order_size_limits(const PreTradeContext& context) {
+RiskCheckResult RiskEngine::check_order_size_limits(const PreTradeContext& context, const RiskLimits& limits) {
     if (!context.order) return RiskCheckResult::APPROVED;
     
     double order_value = context.order->price * context.order->quantity;
-    if (order_value > limits_.max_order_value) {
+    if (order_value > limits.max_order_value) {
         return RiskCheckResult::REJECTED_ORDER_SIZE;
     }
     
@@ -364,8 +705,51 @@ RiskCheckResult RiskEngine::check_exposure_limits(const PreTradeContext& context
     return RiskCheckResult::APPROVED;
 }
 
-RiskCheckResult RiskEngine::check_var_limits(const PreTradeContext& context) {
-    // Simplified VaR limit check
+// VaR with the order filled, from the incremental state: O(1). Orders that
+// lower VaR pass even when it is above a tightened limit.
+RiskCheckResult RiskEngine::check_var_limits(const PreTradeContext& context, const LimitSnapshot& limits) {
+    if (!context.order) return RiskCheckResult::APPROVED;
+    
+    const RiskLimits& global = limits.global();
+    double var_limit = std::min(global.max_var_1d, global.max_var_10d / std::sqrt(10.0));
+    auto impact = portfolio_var_->order_impact(context.order->symbol_id, signed_order_quantity(*context.order),
+                                               order_reference_price(context));
+    if (raises_above(impact.projected, impact.current, var_limit)) {
+        return RiskCheckResult::REJECTED_VAR_LIMIT;
+    }
+    return RiskCheckResult::APPROVED;
+}
+
+// Sensitivities of the order's underlying with the order filled at the
+// contract's current Greeks: O(1). As with VaR, orders that reduce a
+// breached figure pass.
+RiskCheckResult RiskEngine::check_greeks_limits(const PreTradeContext& context, const LimitSnapshot& limits) {
+    if (!context.order) return RiskCheckResult::APPROVED;
+    
+    auto impact = greeks_->order_impact(context.order->symbol_id, signed_order_quantity(*context.order));
+    if (!impact.option) return RiskCheckResult::APPROVED;
+    
+    RiskLimits resolved = limits.resolve(context.order->strategy_id, impact.underlying_id);
+    if (breaches_sensitivities(impact, resolved.max_underlying_delta, resolved.max_underlying_gamma,
+                               resolved.max_underlying_vega)) {
+        return RiskCheckResult::REJECTED_GREEKS_LIMIT;
+    }
+    return RiskCheckResult::APPROVED;
+}
+
+// Strategy margin with the order filled: one scenario vector add and a max.
+// Orders that release margin pass even above a tightened limit.
+RiskCheckResult RiskEngine::check_margin_limits(const PreTradeContext& context, const LimitSnapshot& limits) {
+    if (!context.order) return RiskCheckResult::APPROVED;
+    
+    auto impact = span_->order_impact(context.order->strategy_id, context.order->symbol_id,
+                                      signed_order_quantity(*context.order));
+    if (!impact.derivative) return RiskCheckResult::APPROVED;
+    
+    double limit = limits.strategy_limits(context.order->strategy_id).max_portfolio_margin;
+    if (raises_above(impact.projected, impact.current, limit)) {
+        return RiskCheckResult::REJECTED_MARGIN_LIMIT;
+    }
     return RiskCheckResult::APPROVED;
 }
 
@@ -393,8 +777,7 @@ RiskCheckResult RiskEngine::check_circuit_breakers(const PreTradeContext& contex
 }
 
 void RiskEngine::record_violation(const RiskViolation& violation) {
-    std::unique_lock<std::shared_mutex> lock(violations_mutex_);
-    violations_.push_back(violation);
+    violations_->record(violation);
     
     if (violation_callback_) {
         violation_callback_(violation);
@@ -403,35 +786,173 @@ void RiskEngine::record_violation(const RiskViolation& violation) {
     LOG_WARN("RiskEngine: Risk violation recorded: {}", violation.description);
 }
 
+void RiskEngine::record_violation(RiskCheckResult type, ViolationSeverity severity, uint16_t reason,
+                                  uint64_t symbol_id, double current_value, double limit_value, uint16_t strategy) {
+    auto now = std::chrono::duration_cast<market_data::Timestamp>(
+        std::chrono::high_resolution_clock::now().time_since_epoch());
+    violations_->record(type, severity, reason, strategy, symbol_id, current_value, limit_value, now.count());
+    
+    if (violation_callback_) {
+        RiskViolation violation(type, severity, std::string(violations_->text(reason)));
+        violation.strategy_id = std::string(violations_->text(strategy));
+        violation.symbol_id = symbol_id;
+        violation.current_value = current_value;
+        violation.limit_value = limit_value;
+        violation.timestamp = now;
+        violation_callback_(violation);
+    }
+    
+    LOG_WARN("RiskEngine: Risk violation recorded: {}", violations_->text(reason));
+}
+
+// Expiry walks the ring from the oldest record, so it only touches what it drops
 void RiskEngine::cleanup_old_violations() {
-    std::unique_lock<std::shared_mutex> lock(violations_mutex_);
-    
-    auto now = std::chrono::high_resolution_clock::now();
-    auto cutoff_time = now - std::chrono::hours(24);
-    
-    violations_.erase(
-        std::remove_if(violations_.begin(), violations_.end(),
-                      [cutoff_time](const RiskViolation& v) {
-                          auto violation_time = std::chrono::high_resolution_clock::time_point(v.timestamp);
-                          return violation_time < cutoff_time;
-                      }),
-        violations_.end()
-    );
+    auto cutoff = std::chrono::high_resolution_clock::now().time_since_epoch() - std::chrono::hours(24);
+    violations_->expire_before(std::chrono::duration_cast<std::chrono::nanoseconds>(cutoff).count());
+}
+
+void RiskEngine::run_monitoring_pass() {
+    risk_monitoring_worker();
 }
 
+// One monitoring pass; scheduled every second on the housekeeping pool
 void RiskEngine::risk_monitoring_worker() {
-    while (!shutdown_requested_.load()) {
-        check_portfolio_risk_limits();
-        check_strategy_risk_limits();
-        check_correlation_limits();
-        cleanup_old_violations();
-        
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (shutdown_requested_.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(monitoring_mutex_);
+    check_portfolio_risk_limits();
+    check_option_sensitivities();
+    check_strategy_margins();
+    check_strategy_risk_limits();
+    check_correlation_limits();
+    cleanup_old_violations();
+    // Limit versions retired while a check was still reading them
+    core::Rcu::instance().reclaim();
+}
+
+// Daily covariances over the statistics universe, once the EWMA has warmed
+// up and at most every VAR_MODEL_REFRESH: a new model is an O(n^2) rebuild
+// that fills wait for
+void RiskEngine::refresh_var_model() {
+    std::lock_guard<std::mutex> lock(var_model_mutex_);
+    if (!market_statistics_) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (var_model_samples_ != 0 && now - var_model_time_ < VAR_MODEL_REFRESH) {
+        return;
+    }
+    std::vector<double> covariance;
+    uint64_t samples;
+    {
+        auto snapshot = market_statistics_->snapshot();
+        samples = snapshot.samples();
+        if (samples < MIN_VAR_MODEL_SAMPLES || samples == var_model_samples_) {
+            return;
+        }
+        const double interval_s = std::chrono::duration<double>(market_statistics_->sample_interval()).count();
+        snapshot.covariance_matrix(covariance, TRADING_SECONDS_PER_DAY / interval_s);
     }
+    portfolio_var_->set_covariance(market_statistics_->universe(), covariance);
+    if (var_model_samples_ == 0) {
+        LOG_INFO("RiskEngine: VaR model over {} symbols from {} samples; VaR limits enforced",
+                 market_statistics_->universe().size(), samples);
+    }
+    var_model_samples_ = samples;
+    var_model_time_ = now;
 }
 
+// Follows the market statistics with the VaR model, then rebuilds the
+// incremental VaR state from scratch so rounding cannot build up across
+// fills; the fills themselves never pay for this
 void RiskEngine::check_portfolio_risk_limits() {
-    // Simplified portfolio risk limit checks
+    refresh_var_model();
+    portfolio_var_->recompute();
+}
+
+// Reprices whatever the market moved since the last pass and flags
+// underlyings that went over a limit (markets move them there without
+// orders) or came back under one. The sums are portfolio-wide, so a breach
+// belongs to its underlying and Greek.
+void RiskEngine::check_option_sensitivities() {
+    greeks_->recompute();
+    core::RcuReadGuard guard;
+    const LimitSnapshot& snapshot = *limits_.load();
+    auto transition = [this](uint64_t underlying_id, uint32_t was, uint32_t now, const double (&current)[3],
+                             const double (&limit)[3]) {
+        for (uint32_t i = 0; i < 3; ++i) {
+            const uint32_t bit = 1u << i;
+            if ((now & bit) && !(was & bit)) {
+                record_violation(RiskCheckResult::REJECTED_GREEKS_LIMIT, ViolationSeverity::WARNING,
+                                 greeks_limit_reason_, underlying_id, current[i], limit[i]);
+            } else if ((was & bit) && !(now & bit)) {
+                record_violation(RiskCheckResult::REJECTED_GREEKS_LIMIT, ViolationSeverity::INFO,
+                                 greeks_cleared_reason_, underlying_id, current[i], limit[i]);
+            }
+        }
+    };
+
+    std::unordered_map<uint64_t, uint32_t> breaches;
+    for (const auto& [underlying_id, sums] : greeks_->all_sensitivities()) {
+        RiskLimits limits = snapshot.resolve({}, underlying_id);
+        const double current[3] = {std::abs(sums.delta_notional()), std::abs(sums.gamma_notional()),
+                                   std::abs(sums.vega)};
+        const double limit[3] = {limits.max_underlying_delta, limits.max_underlying_gamma,
+                                 limits.max_underlying_vega};
+        uint32_t now = 0;
+        for (uint32_t i = 0; i < 3; ++i) {
+            now |= static_cast<uint32_t>(current[i] > limit[i]) << i;
+        }
+        uint32_t was = 0;
+        auto previous = greeks_breaches_.find(underlying_id);
+        if (previous != greeks_breaches_.end()) {
+            was = previous->second;
+            greeks_breaches_.erase(previous);
+        }
+        transition(underlying_id, was, now, current, limit);
+        if (now) {
+            breaches.emplace(underlying_id, now);
+        }
+    }
+    // What is left is no longer held: no sensitivity, so nothing breached
+    for (const auto& [underlying_id, was] : greeks_breaches_) {
+        RiskLimits limits = snapshot.resolve({}, underlying_id);
+        const double current[3] = {0.0, 0.0, 0.0};
+        const double limit[3] = {limits.max_underlying_delta, limits.max_underlying_gamma,
+                                 limits.max_underlying_vega};
+        transition(underlying_id, was, 0, current, limit);
+    }
+    greeks_breaches_ = std::move(breaches);
+}
+
+// A new risk-parameter file can lift margins past a limit without any
+// order; a strategy's breach is recorded when it starts and when it clears
+void RiskEngine::check_strategy_margins() {
+    core::RcuReadGuard guard;
+    const LimitSnapshot& snapshot = *limits_.load();
+    std::unordered_set<std::string> breaches;
+    for (const auto& [strategy_id, margin] : span_->all_margins()) {
+        const double limit = snapshot.strategy_limits(strategy_id).max_portfolio_margin;
+        const bool was = margin_breaches_.erase(strategy_id) > 0;
+        if (margin.total > limit) {
+            if (!was) {
+                record_violation(RiskCheckResult::REJECTED_MARGIN_LIMIT, ViolationSeverity::WARNING,
+                                 margin_limit_reason_, 0, margin.total, limit, violations_->intern(strategy_id));
+            }
+            breaches.insert(strategy_id);
+        } else if (was) {
+            record_violation(RiskCheckResult::REJECTED_MARGIN_LIMIT, ViolationSeverity::INFO,
+                             margin_cleared_reason_, 0, margin.total, limit, violations_->intern(strategy_id));
+        }
+    }
+    // What is left blocks no margin any more
+    for (const auto& strategy_id : margin_breaches_) {
+        record_violation(RiskCheckResult::REJECTED_MARGIN_LIMIT, ViolationSeverity::INFO, margin_cleared_reason_, 0,
+                         0.0, snapshot.strategy_limits(strategy_id).max_portfolio_margin,
+                         violations_->intern(strategy_id));
+    }
+    margin_breaches_ = std::move(breaches);
 }
 
 void RiskEngine::check_strategy_risk_limits() {
@@ -2,21 +2,40 @@
 
 #include "../trading/trading_engine.hpp"
 #include "../trading/position_manager.hpp"
+#include "../market_data/market_statistics.hpp"
 #include "../core/latency_tracker.hpp"
+#include "../core/rcu.hpp"
+#include "../core/thread_pool.hpp"
+#include "var_engine.hpp"
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
-#include <deque>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <string>
 #include <vector>
 #include <mutex>
 #include <shared_mutex>
 
+namespace goldearn::config {
+class ConfigManager;
+}
+
+namespace goldearn::trading {
+class KillSwitch;
+}
+
 namespace goldearn::risk {
 
+class IncrementalVaR;
+class GreeksEngine;
+class SpanMargin;
+class ViolationStore;
+class LimitSnapshot;
+class RiskStateTable;
+
 // Risk check result
 enum class RiskCheckResult {
     APPROVED = 0,
@@ -29,7 +48,10 @@ enum class RiskCheckResult {
     REJECTED_CORRELATION = 7,
     REJECTED_CIRCUIT_BREAKER = 8,
     REJECTED_BLACKLIST = 9,
-    REJECTED_SYSTEM_ERROR = 10
+    REJECTED_SYSTEM_ERROR = 10,
+    REJECTED_RATE_LIMIT = 11,
+    REJECTED_GREEKS_LIMIT = 12,
+    REJECTED_MARGIN_LIMIT = 13
 };
 
 // Risk violation severity
@@ -65,6 +87,14 @@ struct RiskLimits {
     double max_portfolio_volatility = 0.25;      // Annual volatility limit
     double max_correlation_exposure = 0.7;       // Max exposure to correlated assets
     
+    // Options sensitivities per underlying (see greeks_engine.hpp)
+    double max_underlying_delta = 50000000.0;    // |delta| x underlying price
+    double max_underlying_gamma = 5000000.0;     // Delta notional change for a 1% move
+    double max_underlying_vega = 500000.0;       // Currency per vol point
+    
+    // F&O margin (see span_margin.hpp)
+    double max_portfolio_margin = 10000000.0;    // SPAN margin a strategy may block
+    
     // Circuit breakers
     double max_daily_loss = 1000000.0;           // Maximum daily loss
     double max_drawdown = 2000000.0;             // Maximum drawdown
@@ -134,14 +164,52 @@ public:
     bool initialize();
     void shutdown();
     
-    // Configuration
-    void set_risk_limits(const RiskLimits& limits);
-    const RiskLimits& get_risk_limits() const { return limits_; }
-    void update_risk_limit(const std::string& limit_name, double value);
-    
-    // Pre-trade risk checks (must complete in <10μs)
+    // Configuration. Every change publishes a new limits version (see
+    // limit_snapshot.hpp); checks already running finish on the old one.
+    // Rate limits above RiskStateTable::RATE_WINDOW are refused and logged.
+    void set_risk_limits(const RiskLimits& limits); // Keeps strategy and symbol overrides
+    RiskLimits get_risk_limits() const;
+    LimitSnapshot get_limit_snapshot() const;
+    uint64_t get_limits_version() const;
+    // By name: "max_order_value", "strategy.<id>.<field>", "symbol.<id>.<field>".
+    // False (and nothing published) for an unknown name or a bad value.
+    bool update_risk_limit(const std::string& limit_name, double value);
+    bool update_risk_limits(const std::vector<std::pair<std::string, double>>& updates); // One version
+    // Every key of the [risk_limits] section; returns the number applied
+    size_t load_risk_limits(config::ConfigManager& config);
+    
+    // Pre-trade risk checks (must complete in <10μs). Orders of registered
+    // strategies and symbols go through the flat risk-state table, then the
+    // VaR, Greeks and margin impacts: one limits version, resolved through
+    // the strategy's index, and no locks.
     RiskCheckResult check_pre_trade_risk(const PreTradeContext& context);
-    RiskCheckResult quick_pre_trade_check(const trading::Order& order);
+    // Market orders are valued at market_price; one with no price to value
+    // it at is rejected (REJECTED_PRICE_LIMIT), as registered orders are above
+    RiskCheckResult quick_pre_trade_check(const trading::Order& order, double market_price = 0.0);
+    
+    // Flat per-strategy/per-symbol state (see risk_state_table.hpp)
+    uint32_t register_strategy(const std::string& strategy_id);
+    uint32_t register_symbol(uint64_t symbol_id);
+    void on_symbol_update(const market_data::SymbolUpdateMessage& message);
+    // Fill of a strategy's order, on the strategy's thread
+    void on_fill(const std::string& strategy_id, const trading::ExecutionReport& execution);
+    RiskStateTable& risk_state() { return *risk_state_; }
+    // Portfolio VaR kept current by on_fill(). Its covariance model comes
+    // from the market statistics (set_market_statistics), rebuilt by the
+    // monitoring pass at most every VAR_MODEL_REFRESH once the statistics
+    // have MIN_VAR_MODEL_SAMPLES samples; an owner may also set one directly.
+    // Until a model is set VaR reads zero and the VaR limits are not enforced.
+    IncrementalVaR& portfolio_var() { return *portfolio_var_; }
+    static constexpr uint64_t MIN_VAR_MODEL_SAMPLES = 100;
+    static constexpr std::chrono::seconds VAR_MODEL_REFRESH{60};
+    // Options book: contracts and market inputs are set by the owner, fills
+    // come through on_fill(). Orders on a contract are checked against the
+    // per-underlying delta, gamma and vega limits (resolved by underlying id).
+    GreeksEngine& greeks() { return *greeks_; }
+    // F&O margin per strategy: contracts and risk parameters are loaded by
+    // the owner, fills come through on_fill(). Orders on a contract are
+    // checked against max_portfolio_margin (resolved by strategy).
+    SpanMargin& margin() { return *span_; }
     
     // Post-trade monitoring
     void monitor_post_trade(const PostTradeContext& context);
@@ -151,10 +219,16 @@ public:
     void start_risk_monitoring();
     void stop_risk_monitoring();
     bool is_monitoring_active() const { return monitoring_active_.load(); }
+    // One pass of what the monitor runs every second. Limit breaches it finds
+    // are recorded when they start and when they clear, not on every pass.
+    void run_monitoring_pass();
     
-    // Circuit breakers
+    // Circuit breakers. A trip also trips the kill switch, if one is set:
+    // the gateway closes and every live order is cancelled before anything
+    // is logged; a reset reopens the gateway.
     void trigger_circuit_breaker(const std::string& reason);
     void reset_circuit_breaker();
+    void set_kill_switch(std::shared_ptr<trading::KillSwitch> kill_switch);
     bool is_circuit_breaker_active() const { return circuit_breaker_active_.load(); }
     
     // Risk limit violations
@@ -179,7 +253,10 @@ public:
     
     // Position and exposure monitoring
     void set_position_manager(std::shared_ptr<trading::PositionManager> pos_mgr);
+    // Source of correlations and of the VaR model; set before trading starts
+    void set_market_statistics(std::shared_ptr<const market_data::MarketStatistics> statistics);
     double get_current_exposure() const;
+    // Global max_portfolio_margin less the margin all strategies block
     double get_available_buying_power() const;
     
     // Performance and statistics
@@ -214,20 +291,26 @@ public:
     RiskReport generate_risk_report() const;
     
 private:
-    RiskLimits limits_;
+    // Published limits; writers serialize on limits_mutex_
+    core::RcuPointer<LimitSnapshot> limits_;
+    std::mutex limits_mutex_;
     std::shared_ptr<trading::PositionManager> position_manager_;
+    std::shared_ptr<const market_data::MarketStatistics> market_statistics_;
     
     // Risk state
     std::atomic<bool> initialized_;
     std::atomic<bool> monitoring_active_;
     std::atomic<bool> circuit_breaker_active_;
+    std::shared_ptr<trading::KillSwitch> kill_switch_;
     
     // Performance tracking
     std::unique_ptr<core::LatencyTracker> check_latency_tracker_;
     
     // Violation tracking
-    std::vector<RiskViolation> violations_;
-    mutable std::shared_mutex violations_mutex_;
+    // Bounded ring with a time index; expired by cleanup_old_violations()
+    std::unique_ptr<ViolationStore> violations_;
+    uint16_t daily_loss_reason_ = 0;
+    uint16_t var_limit_reason_ = 0;
     std::function<void(const RiskViolation&)> violation_callback_;
     
     // Blacklists
@@ -237,44 +320,76 @@ private:
     std::unordered_map<std::string, std::string> strategy_blacklist_reasons_;
     mutable std::shared_mutex blacklist_mutex_;
     
-    // Rate limiting
-    std::unordered_map<std::string, std::deque<market_data::Timestamp>> strategy_order_times_;
-    mutable std::mutex rate_limit_mutex_;
+    // Positions, headroom, price bands and rate windows for the check path
+    std::unique_ptr<RiskStateTable> risk_state_;
+    std::unique_ptr<IncrementalVaR> portfolio_var_;
+    std::unique_ptr<GreeksEngine> greeks_;
+    uint16_t greeks_limit_reason_ = 0;
+    uint16_t greeks_cleared_reason_ = 0;
+    std::unique_ptr<SpanMargin> span_;
+    uint16_t margin_limit_reason_ = 0;
+    uint16_t margin_cleared_reason_ = 0;
+    // SPAN portfolio by strategy index, set by register_strategy()
+    std::unique_ptr<std::atomic<uint32_t>[]> margin_portfolios_;
+    
+    // Monitoring passes, one at a time; breaches already recorded
+    std::mutex monitoring_mutex_;
+    std::unordered_map<uint64_t, uint32_t> greeks_breaches_; // Underlying -> bit per delta, gamma, vega
+    std::unordered_set<std::string> margin_breaches_;        // Strategies over max_portfolio_margin
+    
+    // VaR model built from market_statistics_
+    std::mutex var_model_mutex_;
+    uint64_t var_model_samples_ = 0;
+    std::chrono::steady_clock::time_point var_model_time_;
     
     // Statistics
     mutable std::mutex stats_mutex_;
     RiskEngineStats stats_;
     
-    // Monitoring thread
-    std::thread monitoring_thread_;
+    // Periodic monitoring task on the housekeeping pool
+    core::TaskId monitoring_task_id_ = 0;
     std::atomic<bool> shutdown_requested_;
     
     // Individual risk check methods
     RiskCheckResult check_position_limits(const PreTradeContext& context);
-    RiskCheckResult check_order_size_limits(const PreTradeContext& context);
+    RiskCheckResult check_order_size_limits(const PreTradeContext& context, const RiskLimits& limits);
     RiskCheckResult check_price_limits(const PreTradeContext& context);
     RiskCheckResult check_exposure_limits(const PreTradeContext& context);
-    RiskCheckResult check_var_limits(const PreTradeContext& context);
+    RiskCheckResult check_var_limits(const PreTradeContext& context, const LimitSnapshot& limits);
+    RiskCheckResult check_greeks_limits(const PreTradeContext& context, const LimitSnapshot& limits);
+    RiskCheckResult check_margin_limits(const PreTradeContext& context, const LimitSnapshot& limits);
     RiskCheckResult check_rate_limits(const PreTradeContext& context);
     RiskCheckResult check_blacklists(const PreTradeContext& context);
     RiskCheckResult check_circuit_breakers(const PreTradeContext& context);
     
     // Risk calculation helpers
     double calculate_order_impact_on_var(const trading::Order& order) const;
+    // Exposure-weighted mean correlation of symbol_id with the other positions
     double calculate_position_correlation(uint64_t symbol_id, const std::unordered_map<uint64_t, double>& positions) const;
     double estimate_market_impact(const trading::Order& order, double current_price) const;
     
     // Violation handling
     void record_violation(const RiskViolation& violation);
+    // Hot-path form with an interned reason (and strategy, 0 for none);
+    // allocates only to feed a callback
+    void record_violation(RiskCheckResult type, ViolationSeverity severity, uint16_t reason, uint64_t symbol_id,
+                          double current_value, double limit_value, uint16_t strategy = 0);
     void cleanup_old_violations();
     
-    // Rate limiting helpers
-    bool check_strategy_rate_limit(const std::string& strategy_id);
-    void update_strategy_order_count(const std::string& strategy_id);
+    // Combined table check; false when the strategy or symbol is not registered
+    bool check_risk_state(const trading::Order& order, double price, RiskCheckResult& result,
+                          uint64_t& limits_version);
+    // The table check plus VaR, Greeks and margin; false as above
+    bool check_registered_order(const PreTradeContext& context, RiskCheckResult& result, uint64_t& limits_version);
+    // Under limits_mutex_; false when the table refuses the limits
+    bool publish_limits(std::unique_ptr<LimitSnapshot> limits);
     
     // Monitoring worker
     void risk_monitoring_worker();
+    void refresh_var_model();
     void check_portfolio_risk_limits();
+    void check_option_sensitivities();
+    void check_strategy_margins();
     void check_strategy_risk_limits();
     void check_correlation_limits();
     
@@ -283,6 +398,32 @@ private:
     void update_statistics(RiskCheckResult result);
 };
 
+// One batch of orders (a basket or rebalance) in structure-of-arrays form.
+// Buffers are reused across batches, so a warmed-up batch never allocates.
+class OrderBatch {
+public:
+    void clear();
+    // current_position: the symbol's position before the batch
+    void add(uint64_t symbol_id, trading::OrderSide side, double price, double quantity, double current_position);
+    size_t size() const { return symbol_ids_.size(); }
+    bool has_repeated_symbols() const { return first_repeat_ < symbol_ids_.size(); }
+    
+private:
+    friend class FastPreTradeChecker;
+    
+    std::vector<uint64_t> symbol_ids_;
+    std::vector<double> prices_;
+    std::vector<double> quantities_;     // Signed: positive buys
+    std::vector<double> positions_;
+    std::vector<int32_t> previous_;      // Earlier order on the same symbol, or -1
+    size_t first_repeat_ = SIZE_MAX;
+    
+    // Open-addressed symbol -> last order index, for repeat detection
+    std::vector<uint64_t> seen_keys_;    // symbol_id + 1; 0 is empty
+    std::vector<uint32_t> seen_last_;
+    void rehash(size_t slots);
+};
+
 // Specialized pre-trade checks for ultra-low latency
 class FastPreTradeChecker {
 public:
@@ -294,29 +435,72 @@ public:
     bool quick_exposure_check(double order_value, double current_exposure) const;
     bool quick_blacklist_check(uint64_t symbol_id, const std::string& strategy_id) const;
     
-    // Batch checks for multiple orders
+    // Batch checks: approved[i] is what checking the orders one by one in
+    // batch order would give, each approved order consuming exposure (and,
+    // for a repeated symbol, position) headroom of the ones after it.
+    // Returns the number approved; the whole batch uses one limits version.
+    size_t check_batch(const OrderBatch& batch, double current_exposure, uint8_t* approved,
+                       uint64_t* limits_version = nullptr) const;
     std::vector<bool> batch_check_orders(const std::vector<trading::Order>& orders) const;
     
-    // Update limits (thread-safe)
+    // Positions and exposure batch_check_orders checks against
+    void set_position(uint64_t symbol_id, double position);
+    void set_current_exposure(double exposure) { current_exposure_.store(exposure, std::memory_order_relaxed); }
+    
+    void add_symbol_to_blacklist(uint64_t symbol_id);
+    void remove_symbol_from_blacklist(uint64_t symbol_id);
+    void add_strategy_to_blacklist(const std::string& strategy_id);
+    void remove_strategy_from_blacklist(const std::string& strategy_id);
+    
+    // Update limits (thread-safe): publishes a new version. A snapshot's
+    // global limits keep its version; plain RiskLimits take the next one.
     void update_limits(const RiskLimits& limits);
+    void update_limits(const LimitSnapshot& limits);
+    uint64_t limits_version() const;
     
 private:
-    std::atomic<RiskLimits> limits_; // Atomic for lock-free reads
+    // The limits these checks use, published whole through RCU
+    struct CheckLimits {
+        uint64_t version;
+        double max_position_size;
+        double max_order_size;
+        double max_order_value;
+        double max_portfolio_exposure;
+    };
+    core::RcuPointer<CheckLimits> limits_;
+    std::mutex limits_mutex_;
+    std::atomic<double> current_exposure_{0.0};
+    
+    void publish_limits(const RiskLimits& limits, uint64_t version);
+    size_t check_sequential(const OrderBatch& batch, const CheckLimits& limits, size_t begin, double& exposure,
+                            uint8_t* approved) const;
+    void mark_blacklisted(const OrderBatch& batch, uint8_t* approved) const;
+    
+    std::unordered_map<uint64_t, double> positions_;
+    mutable std::shared_mutex positions_mutex_;
     std::unordered_set<uint64_t> blacklisted_symbols_;
     std::unordered_set<std::string> blacklisted_strategies_;
+    std::atomic<size_t> blacklisted_symbol_count_{0};
     mutable std::shared_mutex blacklist_mutex_;
 };
 
-// VaR (Value at Risk) calculator
+// Symbol pair -> correlation, shared with the market statistics service
+using market_data::SymbolPairHash;
+using market_data::CorrelationMap;
+
+// VaR (Value at Risk) calculator. Positions are currency values, returns and
+// volatilities are daily; confidence_level is the tail probability (0.05
+// gives 95% VaR). VaR is returned as a positive loss.
 class VaRCalculator {
 public:
     VaRCalculator();
+    explicit VaRCalculator(const MonteCarloVaREngine::Config& monte_carlo_config);
     ~VaRCalculator();
     
     // VaR calculation methods
     double calculate_parametric_var(const std::unordered_map<uint64_t, double>& positions,
                                    const std::unordered_map<uint64_t, double>& volatilities,
-                                   const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations,
+                                   const CorrelationMap& correlations,
                                    double confidence_level = 0.05,
                                    uint32_t time_horizon_days = 1) const;
     
@@ -325,33 +509,40 @@ public:
                                    double confidence_level = 0.05,
                                    uint32_t lookback_days = 252) const;
     
+    // Runs on the cached dense engine: the correlation factor is reused as
+    // long as the symbols and correlations are unchanged
     double calculate_monte_carlo_var(const std::unordered_map<uint64_t, double>& positions,
                                     const std::unordered_map<uint64_t, double>& expected_returns,
                                     const std::unordered_map<uint64_t, double>& volatilities,
-                                    const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations,
+                                    const CorrelationMap& correlations,
                                     double confidence_level = 0.05,
                                     uint32_t time_horizon_days = 1,
                                     uint32_t num_simulations = 10000) const;
+    // Expected shortfall, mean and timing of the last Monte Carlo run
+    MonteCarloVaREngine::Result get_last_monte_carlo_result() const;
+    
+    // Component, marginal and incremental VaR are parametric, one O(n^2)
+    // pass each. IncrementalVaR keeps the same figures current fill by fill.
     
     // Component VaR (contribution of each position to total VaR)
     std::unordered_map<uint64_t, double> calculate_component_var(
         const std::unordered_map<uint64_t, double>& positions,
         const std::unordered_map<uint64_t, double>& volatilities,
-        const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations,
+        const CorrelationMap& correlations,
         double confidence_level = 0.05) const;
     
     // Marginal VaR (change in VaR from small position change)
     double calculate_marginal_var(uint64_t symbol_id,
                                  const std::unordered_map<uint64_t, double>& positions,
                                  const std::unordered_map<uint64_t, double>& volatilities,
-                                 const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations,
+                                 const CorrelationMap& correlations,
                                  double confidence_level = 0.05) const;
     
     // Incremental VaR (VaR change from adding new position)
     double calculate_incremental_var(uint64_t symbol_id, double new_position,
                                     const std::unordered_map<uint64_t, double>& existing_positions,
                                     const std::unordered_map<uint64_t, double>& volatilities,
-                                    const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations,
+                                    const CorrelationMap& correlations,
                                     double confidence_level = 0.05) const;
     
     // Risk decomposition
@@ -365,9 +556,18 @@ public:
     std::unordered_map<uint64_t, RiskDecomposition> decompose_portfolio_risk(
         const std::unordered_map<uint64_t, double>& positions,
         const std::unordered_map<uint64_t, double>& volatilities,
-        const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations) const;
+        const CorrelationMap& correlations) const;
+    
+    // Standard normal quantile
+    static double inverse_normal_cdf(double probability);
     
 private:
+    // Monte Carlo engine, built on first use; runs are serialized
+    MonteCarloVaREngine::Config monte_carlo_config_;
+    mutable std::mutex engine_mutex_;
+    mutable std::unique_ptr<MonteCarloVaREngine> engine_;
+    mutable MonteCarloVaREngine::Result last_monte_carlo_;
+    
     // Helper methods
     std::vector<double> generate_portfolio_returns(
         const std::unordered_map<uint64_t, double>& positions,
@@ -376,14 +576,24 @@ private:
     double calculate_portfolio_volatility(
         const std::unordered_map<uint64_t, double>& weights,
         const std::unordered_map<uint64_t, double>& volatilities,
-        const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations) const;
-    
-    std::vector<double> simulate_portfolio_returns(
-        const std::unordered_map<uint64_t, double>& positions,
-        const std::unordered_map<uint64_t, double>& expected_returns,
-        const std::unordered_map<uint64_t, double>& volatilities,
-        const std::unordered_map<std::pair<uint64_t, uint64_t>, double>& correlations,
-        uint32_t num_simulations) const;
+        const CorrelationMap& correlations) const;
+    
+    // u = S w over the held symbols (ascending), S the covariance from the
+    // volatilities and correlations, and the variance w' S w
+    struct WeightedExposure {
+        std::vector<uint64_t> symbols;
+        std::vector<double> exposures;
+        std::vector<double> weighted;
+        double variance = 0.0;
+    };
+    static WeightedExposure weighted_exposure(const std::unordered_map<uint64_t, double>& positions,
+                                              const std::unordered_map<uint64_t, double>& volatilities,
+                                              const CorrelationMap& correlations);
+    
+    // Held symbols in ascending order and their dense row-major correlation matrix
+    static std::vector<uint64_t> sorted_symbols(const std::unordered_map<uint64_t, double>& positions);
+    static std::vector<double> correlation_matrix(const std::vector<uint64_t>& symbols,
+                                                  const CorrelationMap& correlations);
     
     double quantile(std::vector<double> values, double percentile) const;
 };
@@ -0,0 +1,290 @@
+#include "risk_state_table.hpp"
+#include "../utils/simple_logger.hpp"
+#include <stdexcept>
+
+namespace goldearn::risk {
+
+namespace {
+uint64_t symbol_hash(uint64_t symbol_id) {
+    return (symbol_id + 1) * 0x9E3779B97F4A7C15ULL;
+}
+}
+
+RiskStateTable::RiskStateTable(uint32_t max_strategies, uint32_t max_symbols)
+    : max_strategies_(max_strategies)
+    , max_symbols_(max_symbols)
+    , limits_(nullptr) {
+    if (max_strategies == 0 || max_symbols == 0) {
+        throw std::invalid_argument("RiskStateTable: capacity must be non-zero");
+    }
+    entries_ = std::make_unique<Entry[]>(static_cast<size_t>(max_strategies) * max_symbols);
+    strategies_ = std::make_unique<StrategyState[]>(max_strategies);
+    strategy_names_ = std::make_unique<std::string[]>(max_strategies);
+
+    // Open addressing at most half full
+    uint64_t slots = std::bit_ceil(static_cast<uint64_t>(max_symbols) * 2);
+    symbol_keys_ = std::make_unique<std::atomic<uint64_t>[]>(slots);
+    symbol_slots_ = std::make_unique<uint32_t[]>(slots);
+    symbol_mask_ = slots - 1;
+
+    symbol_blocked_.assign(max_symbols, 0);
+    symbol_lower_band_.assign(max_symbols, 0.0);
+    symbol_upper_band_.assign(max_symbols, std::numeric_limits<double>::max());
+    publish_limits();
+}
+
+uint32_t RiskStateTable::add_strategy(const std::string& strategy_id, bool blocked) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    uint32_t index = strategy_index(strategy_id);
+    if (index != INVALID_INDEX) {
+        return index;
+    }
+    index = strategy_count_.load(std::memory_order_relaxed);
+    if (index == max_strategies_) {
+        LOG_WARN("RiskStateTable: No room for strategy {} ({} registered)", strategy_id, max_strategies_);
+        return INVALID_INDEX;
+    }
+
+    // Rows not registered yet already hold the global limits
+    strategy_names_[index] = strategy_id;
+    if (limit_source_.strategy_overrides(strategy_id)) {
+        publish_limits();
+    }
+    uint32_t symbols = symbol_count_.load(std::memory_order_relaxed);
+    for (uint32_t symbol = 0; symbol < symbols; ++symbol) {
+        Entry& entry = entry_at(index, symbol);
+        entry.lower_band.store(symbol_lower_band_[symbol], std::memory_order_relaxed);
+        entry.upper_band.store(symbol_upper_band_[symbol], std::memory_order_relaxed);
+        entry.blocked.store(symbol_blocked_[symbol], std::memory_order_relaxed);
+    }
+    strategies_[index].blocked.store(blocked, std::memory_order_relaxed);
+    strategy_count_.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+uint32_t RiskStateTable::add_symbol(uint64_t symbol_id, bool blocked) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    uint32_t index = symbol_index(symbol_id);
+    if (index != INVALID_INDEX) {
+        return index;
+    }
+    index = symbol_count_.load(std::memory_order_relaxed);
+    if (index == max_symbols_) {
+        LOG_WARN("RiskStateTable: No room for symbol {} ({} registered)", symbol_id, max_symbols_);
+        return INVALID_INDEX;
+    }
+
+    symbol_ids_.push_back(symbol_id);
+    if (limit_source_.symbol_overrides(symbol_id)) {
+        publish_limits();
+    }
+    symbol_blocked_[index] = blocked;
+    uint32_t strategies = strategy_count_.load(std::memory_order_relaxed);
+    for (uint32_t strategy = 0; strategy < strategies; ++strategy) {
+        entry_at(strategy, index).blocked.store(blocked, std::memory_order_relaxed);
+    }
+
+    uint64_t slot = symbol_hash(symbol_id) & symbol_mask_;
+    while (symbol_keys_[slot].load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) & symbol_mask_;
+    }
+    symbol_slots_[slot] = index;
+    symbol_keys_[slot].store(symbol_id + 1, std::memory_order_release);
+    symbol_count_.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+uint32_t RiskStateTable::strategy_index(const std::string& strategy_id) const {
+    uint32_t count = strategy_count_.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (strategy_names_[i] == strategy_id) {
+            return i;
+        }
+    }
+    return INVALID_INDEX;
+}
+
+uint32_t RiskStateTable::symbol_index(uint64_t symbol_id) const {
+    uint64_t slot = symbol_hash(symbol_id) & symbol_mask_;
+    while (true) {
+        uint64_t key = symbol_keys_[slot].load(std::memory_order_acquire);
+        if (key == symbol_id + 1) {
+            return symbol_slots_[slot];
+        }
+        if (key == 0) {
+            return INVALID_INDEX;
+        }
+        slot = (slot + 1) & symbol_mask_;
+    }
+}
+
+bool RiskStateTable::apply_limits(const LimitSnapshot& limits) {
+    if (!fits_rate_window(limits)) {
+        LOG_ERROR("RiskStateTable: Limits version {} rejected: rate limits above {} orders", limits.version(),
+                  RATE_WINDOW);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    limit_source_ = limits;
+    publish_limits();
+    return true;
+}
+
+bool RiskStateTable::apply_limits(const RiskLimits& limits) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    LimitSnapshot next(limits, limit_source_.version() + 1);
+    if (!fits_rate_window(next)) {
+        LOG_ERROR("RiskStateTable: Limits version {} rejected: rate limits above {} orders", next.version(),
+                  RATE_WINDOW);
+        return false;
+    }
+    limit_source_ = std::move(next);
+    publish_limits();
+    return true;
+}
+
+// The rate ring holds RATE_WINDOW send times, so a larger limit could not be enforced
+bool RiskStateTable::fits_rate_window(const LimitSnapshot& limits) {
+    auto fits = [](const RiskLimits& resolved) {
+        return resolved.max_orders_per_second <= RATE_WINDOW && resolved.max_orders_per_minute <= RATE_WINDOW;
+    };
+    if (!fits(limits.global())) {
+        return false;
+    }
+    for (const auto& [strategy_id, overrides] : limits.all_strategy_overrides()) {
+        if (!fits(limits.strategy_limits(strategy_id))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t RiskStateTable::limits_version() const {
+    core::RcuReadGuard guard;
+    return limits_.load()->version;
+}
+
+void RiskStateTable::publish_limits() {
+    auto limits = std::make_unique<TableLimits>();
+    limits->version = limit_source_.version();
+    limits->max_portfolio_exposure = limit_source_.global().max_portfolio_exposure;
+    limits->max_var_1d =
+        std::min(limit_source_.global().max_var_1d, limit_source_.global().max_var_10d / std::sqrt(10.0));
+    limits->strategies = std::make_unique<StrategyLimits[]>(max_strategies_);
+    limits->symbols = std::make_unique<SymbolLimits[]>(max_symbols_);
+
+    auto strategy_limits = [](const RiskLimits& resolved) {
+        return StrategyLimits{resolved.max_position_size,
+                              resolved.max_order_size,
+                              resolved.max_order_value,
+                              resolved.max_strategy_exposure,
+                              std::max<uint32_t>(resolved.max_orders_per_second, 1),
+                              std::max<uint32_t>(resolved.max_orders_per_minute, 1),
+                              resolved.max_portfolio_margin,
+                              resolved.max_underlying_delta,
+                              resolved.max_underlying_gamma,
+                              resolved.max_underlying_vega};
+    };
+    // Includes a strategy being added: its name is written before this runs
+    StrategyLimits global = strategy_limits(limit_source_.global());
+    for (uint32_t strategy = 0; strategy < max_strategies_; ++strategy) {
+        const std::string& name = strategy_names_[strategy];
+        limits->strategies[strategy] =
+            name.empty() ? global : strategy_limits(limit_source_.strategy_limits(name));
+    }
+
+    for (uint32_t symbol = 0; symbol < max_symbols_; ++symbol) {
+        SymbolLimits& row = limits->symbols[symbol];
+        row = SymbolLimits{};
+        const LimitOverrides* overrides =
+            symbol < symbol_ids_.size() ? limit_source_.symbol_overrides(symbol_ids_[symbol]) : nullptr;
+        if (!overrides) {
+            continue;
+        }
+        row.max_position = overrides->values.max_position_size;
+        row.max_order_quantity = overrides->values.max_order_size;
+        row.max_order_value = overrides->values.max_order_value;
+        row.overridden = (overrides->has(LimitField::MAX_POSITION_SIZE) ? OVERRIDE_POSITION : 0) |
+                         (overrides->has(LimitField::MAX_ORDER_SIZE) ? OVERRIDE_ORDER_QUANTITY : 0) |
+                         (overrides->has(LimitField::MAX_ORDER_VALUE) ? OVERRIDE_ORDER_VALUE : 0);
+    }
+
+    // Option underlyings are often not registered symbols, so these go by id
+    for (const auto& [symbol_id, overrides] : limit_source_.all_symbol_overrides()) {
+        uint32_t overridden = (overrides.has(LimitField::MAX_UNDERLYING_DELTA) ? OVERRIDE_DELTA : 0) |
+                              (overrides.has(LimitField::MAX_UNDERLYING_GAMMA) ? OVERRIDE_GAMMA : 0) |
+                              (overrides.has(LimitField::MAX_UNDERLYING_VEGA) ? OVERRIDE_VEGA : 0);
+        if (overridden) {
+            limits->underlyings.emplace(symbol_id, UnderlyingLimits{overrides.values.max_underlying_delta,
+                                                                    overrides.values.max_underlying_gamma,
+                                                                    overrides.values.max_underlying_vega,
+                                                                    overridden});
+        }
+    }
+    limits_.publish(std::move(limits));
+}
+
+void RiskStateTable::set_price_band(uint32_t symbol, double lower, double upper) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    if (symbol >= symbol_count_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    symbol_lower_band_[symbol] = lower > 0.0 ? lower : 0.0;
+    symbol_upper_band_[symbol] = upper > 0.0 ? upper : std::numeric_limits<double>::max();
+    uint32_t strategies = strategy_count_.load(std::memory_order_relaxed);
+    for (uint32_t strategy = 0; strategy < strategies; ++strategy) {
+        Entry& entry = entry_at(strategy, symbol);
+        entry.lower_band.store(symbol_lower_band_[symbol], std::memory_order_relaxed);
+        entry.upper_band.store(symbol_upper_band_[symbol], std::memory_order_relaxed);
+    }
+}
+
+void RiskStateTable::on_symbol_update(const market_data::SymbolUpdateMessage& message) {
+    uint32_t symbol = add_symbol(message.symbol_id);
+    if (symbol != INVALID_INDEX) {
+        set_price_band(symbol, message.lower_circuit, message.upper_circuit);
+    }
+}
+
+void RiskStateTable::set_symbol_blocked(uint32_t symbol, bool blocked) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    if (symbol >= symbol_count_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    symbol_blocked_[symbol] = blocked;
+    uint32_t strategies = strategy_count_.load(std::memory_order_relaxed);
+    for (uint32_t strategy = 0; strategy < strategies; ++strategy) {
+        entry_at(strategy, symbol).blocked.store(blocked, std::memory_order_relaxed);
+    }
+}
+
+void RiskStateTable::set_strategy_blocked(uint32_t strategy, bool blocked) {
+    if (strategy < strategy_count()) {
+        strategies_[strategy].blocked.store(blocked, std::memory_order_relaxed);
+    }
+}
+
+void RiskStateTable::on_fill(uint32_t strategy, uint32_t symbol, trading::OrderSide side, double price,
+                             double quantity) {
+    Entry& entry = entry_at(strategy, symbol);
+    double sign = side == trading::OrderSide::BUY ? 1.0 : -1.0;
+    update_exposure(strategy, entry, entry.position + sign * quantity, price);
+}
+
+void RiskStateTable::set_position(uint32_t strategy, uint32_t symbol, double position, double price) {
+    update_exposure(strategy, entry_at(strategy, symbol), position, price);
+}
+
+void RiskStateTable::update_exposure(uint32_t strategy, Entry& entry, double position, double price) {
+    double exposure = std::fabs(position) * price;
+    double delta = exposure - entry.exposure;
+    entry.position = position;
+    entry.exposure = exposure;
+
+    // The row has one writer; the portfolio total is shared by all strategies
+    StrategyState& row = strategies_[strategy];
+    row.exposure.store(row.exposure.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    global_.exposure.fetch_add(delta, std::memory_order_relaxed);
+}
+
+} // namespace goldearn::risk
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "risk_engine.hpp"
+#include "limit_snapshot.hpp"
+#include "../core/rcu.hpp"
+#include "../market_data/message_types.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace goldearn::risk {
+
+// Flat pre-trade risk state indexed by (strategy index, symbol index).
+//
+// Strategies and symbols are registered once (off the hot path) and get
+// dense indices. Each (strategy, symbol) entry is one cache line holding the
+// position and the symbol's circuit price band; each strategy row has its
+// exposure and a fixed ring of recent order times; one line holds the
+// portfolio totals and the halt flag. The limits are a dense copy of a
+// LimitSnapshot (per strategy, per symbol, global) published through RCU.
+// check_order() reads those places, evaluates every limit into a bitmask
+// and maps the first set bit to a result: no locks, no allocation, no hashing.
+//
+// The same published limits carry what the engine's add-on checks (VaR,
+// option sensitivities, margin) need, so one order resolves every limit
+// from one version through its strategy index.
+//
+// Threading: a strategy row (its entries' positions and its rate ring) is
+// owned by the thread that runs the strategy; check_order(), commit_order()
+// and on_fill() for that strategy must run there. Limits are replaced whole
+// from any thread; bands and block flags are relaxed atomics.
+class RiskStateTable {
+public:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t DEFAULT_MAX_STRATEGIES = 32;
+    static constexpr uint32_t DEFAULT_MAX_SYMBOLS = 2048;
+    static constexpr uint32_t RATE_WINDOW = 1024; // Orders remembered per strategy; bounds both rate limits
+
+    // The limits check_order() reads, resolved from a LimitSnapshot for every
+    // index up to capacity (unregistered ones get the strategy or global values)
+    static constexpr uint32_t OVERRIDE_POSITION = 1;
+    static constexpr uint32_t OVERRIDE_ORDER_QUANTITY = 2;
+    static constexpr uint32_t OVERRIDE_ORDER_VALUE = 4;
+    static constexpr uint32_t OVERRIDE_DELTA = 8;
+    static constexpr uint32_t OVERRIDE_GAMMA = 16;
+    static constexpr uint32_t OVERRIDE_VEGA = 32;
+    struct StrategyLimits {
+        double max_position;
+        double max_order_quantity;
+        double max_order_value;
+        double max_exposure;
+        uint32_t max_orders_per_second; // 1..RATE_WINDOW
+        uint32_t max_orders_per_minute;
+        double max_portfolio_margin;
+        double max_underlying_delta;
+        double max_underlying_gamma;
+        double max_underlying_vega;
+    };
+    struct SymbolLimits {
+        double max_position;
+        double max_order_quantity;
+        double max_order_value;
+        uint32_t overridden; // OVERRIDE_* bits: which of the above replace the strategy's
+    };
+    // Sensitivity limits of one underlying (registered or not)
+    struct UnderlyingLimits {
+        double max_delta;
+        double max_gamma;
+        double max_vega;
+        uint32_t overridden; // OVERRIDE_DELTA/GAMMA/VEGA
+    };
+    struct TableLimits {
+        uint64_t version;
+        double max_portfolio_exposure;
+        double max_var_1d; // The tighter of max_var_1d and max_var_10d / sqrt(10)
+        std::unique_ptr<StrategyLimits[]> strategies;
+        std::unique_ptr<SymbolLimits[]> symbols;
+        std::unordered_map<uint64_t, UnderlyingLimits> underlyings; // Symbols overriding a sensitivity limit
+    };
+
+    RiskStateTable(uint32_t max_strategies = DEFAULT_MAX_STRATEGIES,
+                   uint32_t max_symbols = DEFAULT_MAX_SYMBOLS);
+
+    RiskStateTable(const RiskStateTable&) = delete;
+    RiskStateTable& operator=(const RiskStateTable&) = delete;
+
+    // Registration: returns the existing index for a known key, INVALID_INDEX
+    // when full. Lookups take no lock and may run concurrently with it. A new
+    // key is visible only with its block flag already set to `blocked`; a
+    // known key keeps its flag.
+    uint32_t add_strategy(const std::string& strategy_id, bool blocked = false);
+    uint32_t add_symbol(uint64_t symbol_id, bool blocked = false);
+    uint32_t strategy_index(const std::string& strategy_id) const;
+    uint32_t symbol_index(uint64_t symbol_id) const;
+    uint32_t strategy_count() const { return strategy_count_.load(std::memory_order_acquire); }
+    uint32_t symbol_count() const { return symbol_count_.load(std::memory_order_acquire); }
+    uint32_t max_strategies() const { return max_strategies_; }
+
+    // Limits for every entry, including strategies and symbols registered
+    // later. The RiskLimits form keeps no overrides and takes the next version.
+    // Limits with a rate limit above RATE_WINDOW are refused (false) and the
+    // current ones stay.
+    bool apply_limits(const LimitSnapshot& limits);
+    bool apply_limits(const RiskLimits& limits);
+    static bool fits_rate_window(const LimitSnapshot& limits);
+    uint64_t limits_version() const;
+    // Current limits; valid until the caller's RcuReadGuard ends
+    const TableLimits& limits() const { return *limits_.load(); }
+    // A strategy's sensitivity limits for one underlying: the underlying's
+    // own limit wins over the strategy's
+    static UnderlyingLimits underlying_limits(const TableLimits& limits, uint32_t strategy, uint64_t underlying_id) {
+        const StrategyLimits& row = limits.strategies[strategy];
+        UnderlyingLimits resolved{row.max_underlying_delta, row.max_underlying_gamma, row.max_underlying_vega, 0};
+        if (limits.underlyings.empty()) {
+            return resolved;
+        }
+        auto it = limits.underlyings.find(underlying_id);
+        if (it != limits.underlyings.end()) {
+            const UnderlyingLimits& own = it->second;
+            resolved.max_delta = own.overridden & OVERRIDE_DELTA ? own.max_delta : resolved.max_delta;
+            resolved.max_gamma = own.overridden & OVERRIDE_GAMMA ? own.max_gamma : resolved.max_gamma;
+            resolved.max_vega = own.overridden & OVERRIDE_VEGA ? own.max_vega : resolved.max_vega;
+            resolved.overridden = own.overridden;
+        }
+        return resolved;
+    }
+
+    // Circuit band from the symbol master; a non-positive bound means none
+    // (stored as the largest double: release builds use -ffast-math)
+    void set_price_band(uint32_t symbol, double lower, double upper);
+    void on_symbol_update(const market_data::SymbolUpdateMessage& message);
+
+    void set_symbol_blocked(uint32_t symbol, bool blocked);
+    void set_strategy_blocked(uint32_t strategy, bool blocked);
+    void set_halted(bool halted) { global_.halted.store(halted, std::memory_order_relaxed); }
+
+    // Combined pre-trade check. price is the limit price (the reference price
+    // for market orders). An approved order is counted in the rate window.
+    // limits_version is the version of the limits the decision used.
+    RiskCheckResult check_order(uint32_t strategy, uint32_t symbol, trading::OrderSide side,
+                                double price, double quantity, uint64_t now_ns, uint64_t& limits_version) {
+        core::RcuReadGuard guard;
+        const TableLimits& current = limits();
+        limits_version = current.version;
+        return check_order(current, strategy, symbol, side, price, quantity, now_ns);
+    }
+    RiskCheckResult check_order(uint32_t strategy, uint32_t symbol, trading::OrderSide side,
+                                double price, double quantity, uint64_t now_ns) {
+        uint64_t limits_version;
+        return check_order(strategy, symbol, side, price, quantity, now_ns, limits_version);
+    }
+    // Against limits the caller loaded under its own RcuReadGuard
+    RiskCheckResult check_order(const TableLimits& limits, uint32_t strategy, uint32_t symbol,
+                                trading::OrderSide side, double price, double quantity, uint64_t now_ns) {
+        RiskCheckResult result = evaluate_order(limits, strategy, symbol, side, price, quantity, now_ns);
+        StrategyState& row = strategies_[strategy];
+        uint64_t approved = result == RiskCheckResult::APPROVED;
+        uint64_t slot = row.orders & (RATE_WINDOW - 1);
+        row.order_times[slot] = approved ? now_ns : row.order_times[slot];
+        row.orders += approved;
+        return result;
+    }
+
+    // check_order() without counting the order in the rate window, for a
+    // caller with checks of its own still to run; commit_order() counts it
+    // once every check has passed
+    RiskCheckResult evaluate_order(const TableLimits& limits, uint32_t strategy, uint32_t symbol,
+                                   trading::OrderSide side, double price, double quantity, uint64_t now_ns) {
+        const StrategyLimits& row_limits = limits.strategies[strategy];
+        const SymbolLimits& symbol_limits = limits.symbols[symbol];
+        Entry& entry = entry_at(strategy, symbol);
+        StrategyState& row = strategies_[strategy];
+
+        // A symbol's own limit wins over its strategy's
+        double max_position = symbol_limits.overridden & OVERRIDE_POSITION
+            ? symbol_limits.max_position : row_limits.max_position;
+        double max_order_quantity = symbol_limits.overridden & OVERRIDE_ORDER_QUANTITY
+            ? symbol_limits.max_order_quantity : row_limits.max_order_quantity;
+        double max_order_value = symbol_limits.overridden & OVERRIDE_ORDER_VALUE
+            ? symbol_limits.max_order_value : row_limits.max_order_value;
+
+        double sign = 3.0 - 2.0 * static_cast<double>(side); // BUY = 1 -> +1, SELL = 2 -> -1
+        double current = std::fabs(entry.position);
+        double projected = std::fabs(entry.position + sign * quantity);
+        double added_exposure = std::max(projected - current, 0.0) * price;
+        double order_value = price * quantity;
+
+        uint64_t per_second = row_limits.max_orders_per_second;
+        uint64_t per_minute = row_limits.max_orders_per_minute;
+        uint64_t second_ago = row.order_times[(row.orders - per_second) & (RATE_WINDOW - 1)];
+        uint64_t minute_ago = row.order_times[(row.orders - per_minute) & (RATE_WINDOW - 1)];
+
+        // Reducing a position is allowed even when it is above a tightened limit
+        uint32_t fail =
+            static_cast<uint32_t>((projected > max_position) & (projected > current)) << BIT_POSITION |
+            static_cast<uint32_t>((quantity > max_order_quantity) | (order_value > max_order_value)) << BIT_ORDER_SIZE |
+            static_cast<uint32_t>((price < entry.lower_band.load(std::memory_order_relaxed)) |
+                                  (price > entry.upper_band.load(std::memory_order_relaxed))) << BIT_PRICE |
+            static_cast<uint32_t>((row.exposure.load(std::memory_order_relaxed) + added_exposure >
+                                   row_limits.max_exposure) |
+                                  (global_.exposure.load(std::memory_order_relaxed) + added_exposure >
+                                   limits.max_portfolio_exposure)) << BIT_EXPOSURE |
+            static_cast<uint32_t>((now_ns - second_ago < 1000000000ULL) |
+                                  (now_ns - minute_ago < 60000000000ULL)) << BIT_RATE |
+            static_cast<uint32_t>(entry.blocked.load(std::memory_order_relaxed) |
+                                  row.blocked.load(std::memory_order_relaxed)) << BIT_BLACKLIST |
+            static_cast<uint32_t>(global_.halted.load(std::memory_order_relaxed)) << BIT_CIRCUIT_BREAKER;
+
+        return RESULTS[std::countr_zero(fail | (1u << BIT_APPROVED))];
+    }
+    // Records an approved order's send time in its strategy's rate window
+    void commit_order(uint32_t strategy, uint64_t now_ns) {
+        StrategyState& row = strategies_[strategy];
+        row.order_times[row.orders & (RATE_WINDOW - 1)] = now_ns;
+        ++row.orders;
+    }
+
+    // Fill on the owning strategy's thread: moves the position and the
+    // exposure totals (|position| x fill price)
+    void on_fill(uint32_t strategy, uint32_t symbol, trading::OrderSide side, double price, double quantity);
+    // Start-of-day or reconciled position
+    void set_position(uint32_t strategy, uint32_t symbol, double position, double price);
+
+    double position(uint32_t strategy, uint32_t symbol) const { return entry_at(strategy, symbol).position; }
+    double strategy_exposure(uint32_t strategy) const {
+        return strategies_[strategy].exposure.load(std::memory_order_relaxed);
+    }
+    double portfolio_exposure() const { return global_.exposure.load(std::memory_order_relaxed); }
+
+private:
+    // Failure bits, lowest first: same precedence as the sequential checks
+    enum : uint32_t {
+        BIT_POSITION = 0,
+        BIT_ORDER_SIZE,
+        BIT_PRICE,
+        BIT_EXPOSURE,
+        BIT_RATE,
+        BIT_BLACKLIST,
+        BIT_CIRCUIT_BREAKER,
+        BIT_APPROVED
+    };
+    static constexpr RiskCheckResult RESULTS[BIT_APPROVED + 1] = {
+        RiskCheckResult::REJECTED_POSITION_LIMIT,
+        RiskCheckResult::REJECTED_ORDER_SIZE,
+        RiskCheckResult::REJECTED_PRICE_LIMIT,
+        RiskCheckResult::REJECTED_EXPOSURE_LIMIT,
+        RiskCheckResult::REJECTED_RATE_LIMIT,
+        RiskCheckResult::REJECTED_BLACKLIST,
+        RiskCheckResult::REJECTED_CIRCUIT_BREAKER,
+        RiskCheckResult::APPROVED
+    };
+
+    struct alignas(64) Entry {
+        // Owning strategy thread
+        double position = 0.0;
+        double exposure = 0.0; // This entry's share of the strategy and portfolio totals
+        // Any thread
+        std::atomic<double> lower_band{0.0};
+        std::atomic<double> upper_band{std::numeric_limits<double>::max()};
+        std::atomic<uint32_t> blocked{0};
+    };
+    static_assert(sizeof(Entry) == 64);
+
+    struct alignas(64) StrategyState {
+        std::atomic<double> exposure{0.0}; // Written by the owner only
+        std::atomic<uint32_t> blocked{0};
+        // Owning strategy thread: send times of the last RATE_WINDOW approvals
+        uint64_t orders = 0;
+        alignas(64) uint64_t order_times[RATE_WINDOW] = {};
+    };
+
+    struct alignas(64) GlobalState {
+        std::atomic<double> exposure{0.0}; // Sum over strategies
+        std::atomic<uint32_t> halted{0};
+    };
+
+    Entry& entry_at(uint32_t strategy, uint32_t symbol) {
+        return entries_[static_cast<size_t>(strategy) * max_symbols_ + symbol];
+    }
+    const Entry& entry_at(uint32_t strategy, uint32_t symbol) const {
+        return entries_[static_cast<size_t>(strategy) * max_symbols_ + symbol];
+    }
+    // Under config_mutex_
+    void publish_limits();
+    void update_exposure(uint32_t strategy, Entry& entry, double position, double price);
+
+    const uint32_t max_strategies_;
+    const uint32_t max_symbols_;
+    std::unique_ptr<Entry[]> entries_;
+    std::unique_ptr<StrategyState[]> strategies_;
+    GlobalState global_;
+    core::RcuPointer<TableLimits> limits_;
+
+    // Registration and limits (setup path). Names and the symbol hash are
+    // written before the count or the slot key is published with release.
+    std::mutex config_mutex_;
+    LimitSnapshot limit_source_;
+    std::unique_ptr<std::string[]> strategy_names_;
+    std::vector<uint64_t> symbol_ids_; // By index
+    std::unique_ptr<std::atomic<uint64_t>[]> symbol_keys_; // symbol_id + 1; 0 is an empty slot
+    std::unique_ptr<uint32_t[]> symbol_slots_;
+    uint64_t symbol_mask_;
+    std::vector<uint32_t> symbol_blocked_; // Per symbol index, copied into new strategy rows
+    std::vector<double> symbol_lower_band_;
+    std::vector<double> symbol_upper_band_;
+    std::atomic<uint32_t> strategy_count_{0};
+    std::atomic<uint32_t> symbol_count_{0};
+};
+
+} // namespace goldearn::risk
@@ -0,0 +1,501 @@
+#include "span_margin.hpp"
+#include "../utils/simple_logger.hpp"
+#include "../utils/vector_math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::risk {
+
+namespace {
+
+constexpr size_t N = SpanMargin::SCENARIOS;
+constexpr double NS_PER_DAY = 86400e9;
+constexpr double MIN_TAU = 1e-6;
+constexpr double MIN_VOLATILITY = 1e-4;
+
+// Scenarios 1-14: price move in scan ranges, volatility move in scan ranges.
+// 15 and 16 are the extreme moves, at Config::extreme_move_multiple.
+constexpr double PRICE_MOVE[N] = {0.0, 0.0, 1.0 / 3, 1.0 / 3, -1.0 / 3, -1.0 / 3, 2.0 / 3, 2.0 / 3,
+                                  -2.0 / 3, -2.0 / 3, 1.0, 1.0, -1.0, -1.0, 1.0, -1.0};
+constexpr double VOLATILITY_MOVE[N] = {1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 0, 0};
+
+// losses += quantity x array
+void add_scaled(double* losses, const double* array, double quantity) {
+#ifdef __AVX2__
+    const __m256d q = _mm256_set1_pd(quantity);
+    for (size_t i = 0; i < N; i += 4) {
+        _mm256_storeu_pd(losses + i,
+                         utils::vmath::fmadd(q, _mm256_loadu_pd(array + i), _mm256_loadu_pd(losses + i)));
+    }
+#else
+    for (size_t i = 0; i < N; ++i) {
+        losses[i] += quantity * array[i];
+    }
+#endif
+}
+
+// max over scenarios of losses + quantity x array, nothing written
+double worst_scaled(const double* losses, const double* array, double quantity) {
+#ifdef __AVX2__
+    namespace vm = utils::vmath;
+    const __m256d q = _mm256_set1_pd(quantity);
+    const __m256d a = vm::fmadd(q, _mm256_loadu_pd(array), _mm256_loadu_pd(losses));
+    const __m256d b = vm::fmadd(q, _mm256_loadu_pd(array + 4), _mm256_loadu_pd(losses + 4));
+    const __m256d c = vm::fmadd(q, _mm256_loadu_pd(array + 8), _mm256_loadu_pd(losses + 8));
+    const __m256d d = vm::fmadd(q, _mm256_loadu_pd(array + 12), _mm256_loadu_pd(losses + 12));
+    __m256d m = _mm256_max_pd(_mm256_max_pd(a, b), _mm256_max_pd(c, d));
+    __m128d h = _mm_max_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+#else
+    double worst = losses[0] + quantity * array[0];
+    for (size_t i = 1; i < N; ++i) {
+        worst = std::max(worst, losses[i] + quantity * array[i]);
+    }
+    return worst;
+#endif
+}
+
+double short_units(double quantity) {
+    return std::max(-quantity, 0.0);
+}
+
+// Value per unit of underlying quantity: the futures price, or the option premium
+double value(SpanMargin::Kind kind, double spot, double strike, double tau, double volatility, double rate,
+             double yield) {
+    const double forward = spot * std::exp((rate - yield) * tau);
+    if (kind == SpanMargin::Kind::FUTURE) {
+        return forward;
+    }
+    const double w = kind == SpanMargin::Kind::CALL ? 1.0 : -1.0;
+    const double sd = std::max(volatility, MIN_VOLATILITY) * std::sqrt(tau);
+    const double d1 = (std::log(forward / strike) + 0.5 * sd * sd) / sd;
+    const double d2 = d1 - sd;
+    return w * std::exp(-rate * tau) *
+           (forward * utils::vmath::norm_cdf(w * d1) - strike * utils::vmath::norm_cdf(w * d2));
+}
+
+} // namespace
+
+SpanMargin::SpanMargin() : SpanMargin(Config{}) {}
+
+SpanMargin::SpanMargin(const Config& config) : config_(config), view_(std::make_unique<View>()) {
+    if (config_.days_per_year <= 0.0 || config_.extreme_move_weight < 0.0) {
+        throw std::invalid_argument("SpanMargin: days per year must be positive, extreme weight non-negative");
+    }
+}
+
+void SpanMargin::add_contracts(const std::vector<Contract>& contracts) {
+    for (const auto& c : contracts) {
+        const bool option = c.kind != Kind::FUTURE;
+        if (c.contract_id == 0 || !(c.multiplier > 0.0) || (option && !(c.strike > 0.0))) {
+            throw std::invalid_argument("SpanMargin: contract needs an id, a positive multiplier and, for an "
+                                        "option, a positive strike");
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint8_t> marked(underlyings_.size(), 0);
+    for (const auto& c : contracts) {
+        auto [u, added] = underlying_index_.emplace(c.underlying_id, static_cast<uint32_t>(underlyings_.size()));
+        if (added) {
+            underlyings_.push_back(Underlying{c.underlying_id, 0.0});
+            marked.push_back(0);
+        }
+        auto [it, fresh] = slot_index_.emplace(c.contract_id, static_cast<uint32_t>(slots_.size()));
+        if (fresh) {
+            slots_.push_back(Slot{c, u->second});
+            arrays_.resize(arrays_.size() + N, 0.0); // Nothing at risk until its parameters load
+        } else {
+            // Redefined: its old underlying loses the holding, the new one gains it
+            Slot& slot = slots_[it->second];
+            marked[slot.underlying] = 1;
+            slot = Slot{c, u->second};
+            std::fill_n(arrays_.begin() + static_cast<ptrdiff_t>(it->second) * N, N, 0.0);
+        }
+        marked[u->second] = 1;
+    }
+    for (auto& portfolio : portfolios_) {
+        std::lock_guard<std::mutex> portfolio_lock(portfolio->mutex);
+        portfolio->losses.resize(underlyings_.size() * N, 0.0);
+        portfolio->short_units.resize(underlyings_.size(), 0.0);
+        portfolio->scan.resize(underlyings_.size(), 0.0);
+        portfolio->charge.resize(underlyings_.size(), 0.0);
+        rebuild(*portfolio, marked);
+    }
+    publish_view();
+    LOG_INFO("SpanMargin: {} contracts on {} underlyings", slots_.size(), underlyings_.size());
+}
+
+bool SpanMargin::is_derivative(uint64_t contract_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return slot(contract_id) != INVALID_INDEX;
+}
+
+uint32_t SpanMargin::slot(uint64_t contract_id) const {
+    auto it = slot_index_.find(contract_id);
+    return it != slot_index_.end() ? it->second : INVALID_INDEX;
+}
+
+SpanMargin::Portfolio* SpanMargin::portfolio(const std::string& portfolio_id) const {
+    auto it = portfolio_index_.find(portfolio_id);
+    return it != portfolio_index_.end() ? portfolios_[it->second].get() : nullptr;
+}
+
+void SpanMargin::value_contract(uint32_t s, const RiskParameters& p, int64_t now_ns) {
+    const Contract& c = slots_[s].contract;
+    const double tau = std::max(static_cast<double>(c.expiry_ns - now_ns) / (NS_PER_DAY * config_.days_per_year),
+                                MIN_TAU);
+    const double base = value(c.kind, p.price, c.strike, tau, p.volatility, config_.rate, p.dividend_yield);
+    double* array = &arrays_[static_cast<size_t>(s) * N];
+    for (size_t i = 0; i < N; ++i) {
+        const bool extreme = i >= N - 2;
+        const double move = PRICE_MOVE[i] * p.price_scan_range * (extreme ? config_.extreme_move_multiple : 1.0);
+        const double scenario = value(c.kind, p.price * (1.0 + move), c.strike, tau,
+                                      p.volatility + VOLATILITY_MOVE[i] * p.volatility_scan_range, config_.rate,
+                                      p.dividend_yield);
+        // Loss of a long unit; a short holding multiplies it by a negative quantity
+        array[i] = (base - scenario) * c.multiplier * (extreme ? config_.extreme_move_weight : 1.0);
+    }
+}
+
+size_t SpanMargin::load_risk_parameters(const std::vector<RiskParameters>& parameters, int64_t now_ns) {
+    for (const auto& p : parameters) {
+        if (!(p.price > 0.0) || p.price_scan_range < 0.0 || p.volatility_scan_range < 0.0 || p.volatility < 0.0 ||
+            p.short_option_minimum < 0.0) {
+            throw std::invalid_argument("SpanMargin: risk parameters need a positive price and non-negative ranges");
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::vector<const RiskParameters*> by_underlying(underlyings_.size(), nullptr);
+    std::vector<uint8_t> marked(underlyings_.size(), 0);
+    for (const auto& p : parameters) {
+        auto it = underlying_index_.find(p.underlying_id);
+        if (it == underlying_index_.end()) {
+            continue; // No contracts on it here
+        }
+        by_underlying[it->second] = &p;
+        marked[it->second] = 1;
+        underlyings_[it->second].short_option_minimum = p.short_option_minimum;
+    }
+    size_t valued = 0;
+    for (uint32_t s = 0; s < slots_.size(); ++s) {
+        if (const RiskParameters* p = by_underlying[slots_[s].underlying]) {
+            value_contract(s, *p, now_ns);
+            ++valued;
+        }
+    }
+    for (auto& portfolio : portfolios_) {
+        std::lock_guard<std::mutex> portfolio_lock(portfolio->mutex);
+        rebuild(*portfolio, marked);
+    }
+    publish_view();
+    ++loads_;
+    LOG_INFO("SpanMargin: Risk parameters for {} underlyings loaded, {} contracts revalued", parameters.size(),
+             valued);
+    return valued;
+}
+
+bool SpanMargin::load_risk_array(uint64_t contract_id, const RiskArray& losses) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    if (s == INVALID_INDEX) {
+        return false;
+    }
+    std::copy(losses.begin(), losses.end(), arrays_.begin() + static_cast<ptrdiff_t>(s) * N);
+    std::vector<uint8_t> marked(underlyings_.size(), 0);
+    marked[slots_[s].underlying] = 1;
+    for (auto& portfolio : portfolios_) {
+        std::lock_guard<std::mutex> portfolio_lock(portfolio->mutex);
+        rebuild(*portfolio, marked);
+    }
+    publish_view();
+    return true;
+}
+
+SpanMargin::RiskArray SpanMargin::risk_array(uint64_t contract_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    RiskArray array{};
+    const uint32_t s = slot(contract_id);
+    if (s != INVALID_INDEX) {
+        std::copy_n(arrays_.begin() + static_cast<ptrdiff_t>(s) * N, N, array.begin());
+    }
+    return array;
+}
+
+uint32_t SpanMargin::add_portfolio(const std::string& portfolio_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return create_portfolio(portfolio_id);
+}
+
+uint32_t SpanMargin::create_portfolio(const std::string& portfolio_id) {
+    auto [it, added] = portfolio_index_.emplace(portfolio_id, static_cast<uint32_t>(portfolios_.size()));
+    if (added) {
+        auto portfolio = std::make_unique<Portfolio>();
+        portfolio->id = portfolio_id;
+        portfolio->index = it->second;
+        portfolio->losses.assign(underlyings_.size() * N, 0.0);
+        portfolio->short_units.assign(underlyings_.size(), 0.0);
+        portfolio->scan.assign(underlyings_.size(), 0.0);
+        portfolio->charge.assign(underlyings_.size(), 0.0);
+        portfolios_.push_back(std::move(portfolio));
+        publish_view();
+    }
+    return it->second;
+}
+
+void SpanMargin::publish_view() {
+    auto view = std::make_unique<View>();
+    view->slot_index = slot_index_;
+    view->slots = slots_;
+    view->arrays = arrays_;
+    view->short_option_minimum.reserve(underlyings_.size());
+    for (const auto& underlying : underlyings_) {
+        view->short_option_minimum.push_back(underlying.short_option_minimum);
+    }
+    view->portfolio_index = portfolio_index_;
+    // No fill runs meanwhile: fills hold the shared lock
+    for (const auto& p : portfolios_) {
+        auto portfolio = std::make_unique<PortfolioView>();
+        portfolio->total.store(p->total);
+        portfolio->underlyings = std::make_unique<core::SeqlockCell<Exposure>[]>(underlyings_.size());
+        for (size_t u = 0; u < underlyings_.size(); ++u) {
+            Exposure exposure;
+            std::copy_n(p->losses.begin() + static_cast<ptrdiff_t>(u) * N, N, exposure.losses.begin());
+            exposure.short_units = p->short_units[u];
+            exposure.charge = p->charge[u];
+            portfolio->underlyings[u].store(exposure);
+        }
+        portfolio->quantity = std::make_unique<core::SeqlockCell<double>[]>(slots_.size());
+        for (const auto& [s, held] : p->quantity) {
+            portfolio->quantity[s].store(held);
+        }
+        view->portfolios.push_back(std::move(portfolio));
+    }
+    view_.publish(std::move(view));
+}
+
+uint32_t SpanMargin::portfolio_index(const std::string& portfolio_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = portfolio_index_.find(portfolio_id);
+    return it != portfolio_index_.end() ? it->second : INVALID_INDEX;
+}
+
+bool SpanMargin::on_fill(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity) {
+    return apply(portfolio_id, contract_id, signed_quantity, true);
+}
+
+bool SpanMargin::add_order(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity) {
+    return apply(portfolio_id, contract_id, signed_quantity, true);
+}
+
+bool SpanMargin::remove_order(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity) {
+    return apply(portfolio_id, contract_id, -signed_quantity, false);
+}
+
+bool SpanMargin::apply(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity, bool create) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const uint32_t s = slot(contract_id);
+        if (s == INVALID_INDEX) {
+            return false;
+        }
+        if (Portfolio* p = portfolio(portfolio_id)) {
+            std::lock_guard<std::mutex> portfolio_lock(p->mutex);
+            move(*p, s, signed_quantity);
+            updates_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (!create) {
+            return false;
+        }
+    }
+    // First fill or order of the portfolio: once, under the exclusive lock
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    if (s == INVALID_INDEX) {
+        return false;
+    }
+    Portfolio& p = *portfolios_[create_portfolio(portfolio_id)];
+    std::lock_guard<std::mutex> portfolio_lock(p.mutex);
+    move(p, s, signed_quantity);
+    updates_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SpanMargin::move(Portfolio& p, uint32_t s, double signed_quantity) const {
+    const Slot& slot = slots_[s];
+    double& held = p.quantity[s];
+    const double before = held;
+    held += signed_quantity;
+    add_scaled(&p.losses[static_cast<size_t>(slot.underlying) * N], &arrays_[static_cast<size_t>(s) * N],
+               signed_quantity);
+    if (slot.contract.kind != Kind::FUTURE) {
+        p.short_units[slot.underlying] += (short_units(held) - short_units(before)) * slot.contract.multiplier;
+    }
+    if (held == 0.0) {
+        p.quantity.erase(s);
+    }
+    recharge(p, slot.underlying);
+    publish(p, s, slot.underlying);
+}
+
+void SpanMargin::recharge(Portfolio& p, uint32_t u) const {
+    const double* losses = &p.losses[static_cast<size_t>(u) * N];
+    const double scan = std::max(*std::max_element(losses, losses + N), 0.0);
+    const double charge = std::max(scan, p.short_units[u] * underlyings_[u].short_option_minimum);
+    p.scanning_risk += scan - p.scan[u];
+    p.total += charge - p.charge[u];
+    p.scan[u] = scan;
+    p.charge[u] = charge;
+}
+
+// The view's copy of what one move changed
+void SpanMargin::publish(const Portfolio& p, uint32_t s, uint32_t u) const {
+    PortfolioView& portfolio = *view_.load()->portfolios[p.index];
+    Exposure exposure;
+    std::copy_n(p.losses.begin() + static_cast<ptrdiff_t>(u) * N, N, exposure.losses.begin());
+    exposure.short_units = p.short_units[u];
+    exposure.charge = p.charge[u];
+    auto it = p.quantity.find(s);
+
+    core::Seqlock::WriteGuard write(portfolio.sequence);
+    portfolio.total.store(p.total);
+    portfolio.underlyings[u].store(exposure);
+    portfolio.quantity[s].store(it != p.quantity.end() ? it->second : 0.0);
+}
+
+void SpanMargin::rebuild(Portfolio& p, const std::vector<uint8_t>& underlyings) const {
+    for (uint32_t u = 0; u < underlyings.size(); ++u) {
+        if (underlyings[u]) {
+            std::fill_n(p.losses.begin() + static_cast<ptrdiff_t>(u) * N, N, 0.0);
+            p.short_units[u] = 0.0;
+        }
+    }
+    for (const auto& [s, held] : p.quantity) {
+        const Slot& slot = slots_[s];
+        if (!underlyings[slot.underlying]) continue;
+        add_scaled(&p.losses[static_cast<size_t>(slot.underlying) * N], &arrays_[static_cast<size_t>(s) * N], held);
+        if (slot.contract.kind != Kind::FUTURE) {
+            p.short_units[slot.underlying] += short_units(held) * slot.contract.multiplier;
+        }
+    }
+    for (uint32_t u = 0; u < underlyings.size(); ++u) {
+        if (underlyings[u]) {
+            recharge(p, u);
+        }
+    }
+    // Fresh sums, so incremental rounding does not outlive a load
+    p.scanning_risk = 0.0;
+    p.total = 0.0;
+    for (size_t u = 0; u < p.charge.size(); ++u) {
+        p.scanning_risk += p.scan[u];
+        p.total += p.charge[u];
+    }
+}
+
+double SpanMargin::quantity(const std::string& portfolio_id, uint64_t contract_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const uint32_t s = slot(contract_id);
+    const Portfolio* p = portfolio(portfolio_id);
+    if (s == INVALID_INDEX || !p) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> portfolio_lock(p->mutex);
+    auto it = p->quantity.find(s);
+    return it != p->quantity.end() ? it->second : 0.0;
+}
+
+SpanMargin::Margin SpanMargin::margin(const std::string& portfolio_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    Margin margin;
+    if (const Portfolio* p = portfolio(portfolio_id)) {
+        std::lock_guard<std::mutex> portfolio_lock(p->mutex);
+        margin.scanning_risk = p->scanning_risk;
+        margin.total = p->total;
+        margin.short_option_minimum = p->total - p->scanning_risk;
+    }
+    return margin;
+}
+
+std::vector<std::pair<std::string, SpanMargin::Margin>> SpanMargin::all_margins() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<std::pair<std::string, Margin>> margins;
+    margins.reserve(portfolios_.size());
+    for (const auto& p : portfolios_) {
+        std::lock_guard<std::mutex> portfolio_lock(p->mutex);
+        margins.emplace_back(p->id, Margin{p->scanning_risk, p->total - p->scanning_risk, p->total});
+    }
+    return margins;
+}
+
+double SpanMargin::total_margin() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    double total = 0.0;
+    for (const auto& p : portfolios_) {
+        std::lock_guard<std::mutex> portfolio_lock(p->mutex);
+        total += p->total;
+    }
+    return total;
+}
+
+SpanMargin::Impact SpanMargin::order_impact(const std::string& portfolio_id, uint64_t contract_id,
+                                            double signed_quantity) const {
+    core::RcuReadGuard guard;
+    const View& view = *view_.load();
+    auto it = view.portfolio_index.find(portfolio_id);
+    return order_impact(it != view.portfolio_index.end() ? it->second : INVALID_INDEX, contract_id,
+                        signed_quantity);
+}
+
+SpanMargin::Impact SpanMargin::order_impact(uint32_t portfolio, uint64_t contract_id, double signed_quantity) const {
+    core::RcuReadGuard guard;
+    const View& view = *view_.load();
+    Impact impact;
+    auto it = view.slot_index.find(contract_id);
+    if (it == view.slot_index.end()) {
+        return impact;
+    }
+    impact.derivative = true;
+    const uint32_t s = it->second;
+    const Slot& slot = view.slots[s];
+    const uint32_t u = slot.underlying;
+    const double* array = &view.arrays[static_cast<size_t>(s) * N];
+    const double minimum = view.short_option_minimum[u];
+
+    // An empty portfolio holds nothing and is charged nothing
+    Exposure exposure{};
+    double held = 0.0;
+    if (portfolio < view.portfolios.size()) {
+        const PortfolioView& p = *view.portfolios[portfolio];
+        impact.current = p.sequence.read([&]() {
+            exposure = p.underlyings[u].load();
+            held = p.quantity[s].load();
+            return p.total.load();
+        });
+    }
+    const double scan = std::max(worst_scaled(exposure.losses.data(), array, signed_quantity), 0.0);
+    double units = exposure.short_units;
+    if (slot.contract.kind != Kind::FUTURE) {
+        units += (short_units(held + signed_quantity) - short_units(held)) * slot.contract.multiplier;
+    }
+    impact.projected = impact.current - exposure.charge + std::max(scan, units * minimum);
+    return impact;
+}
+
+SpanMargin::Stats SpanMargin::get_stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    Stats stats;
+    stats.contracts = slots_.size();
+    stats.underlyings = underlyings_.size();
+    stats.portfolios = portfolios_.size();
+    stats.updates = updates_.load(std::memory_order_relaxed);
+    stats.loads = loads_;
+    return stats;
+}
+
+} // namespace goldearn::risk
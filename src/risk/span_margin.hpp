@@ -0,0 +1,222 @@
+#pragma once
+
+#include "../core/rcu.hpp"
+#include "../core/seqlock.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace goldearn::risk {
+
+// SPAN-style initial margin for futures and options portfolios.
+//
+// Each contract has a risk array: its loss per unit of quantity under the
+// exchange's 16 scenarios (underlying up or down by 0, 1/3, 2/3 and 3/3 of
+// the price scan range with volatility up and down, plus two extreme moves
+// covering a fraction of their loss). Arrays come from the exchange's
+// risk-parameter file, either as published (load_risk_array) or rebuilt from
+// the per-underlying scan ranges (load_risk_parameters).
+//
+// Every portfolio keeps, per underlying, the scenario loss vector of all it
+// holds. A fill or a working order adds quantity x array to one vector and
+// refreshes that underlying's charge, max(worst scenario loss, short option
+// minimum); the portfolio margin is the sum of the charges. The margin an
+// order would need is therefore one 16-wide add and a max, whatever the size
+// of the portfolio.
+//
+// Intra-commodity spread charges, inter-commodity credits and net option
+// value are left out: the figure is the scanning risk the exchange blocks,
+// which is what decides whether an order can be placed.
+//
+// Thread-safe. Loads and the contract master take an exclusive lock; fills,
+// orders and reads a shared one plus the portfolio's own mutex, so
+// portfolios on different threads do not contend. order_impact() takes
+// neither: it reads an RCU-published copy of the contract master and of
+// each portfolio, whose figures fills rewrite in place under a sequence lock.
+class SpanMargin {
+public:
+    static constexpr size_t SCENARIOS = 16;
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    using RiskArray = std::array<double, SCENARIOS>;
+
+    enum class Kind : uint8_t { FUTURE, CALL, PUT };
+
+    struct Contract {
+        uint64_t contract_id = 0;
+        uint64_t underlying_id = 0;
+        Kind kind = Kind::FUTURE;
+        double strike = 0.0;        // Options
+        int64_t expiry_ns = 0;
+        double multiplier = 1.0;    // Currency per point per unit of quantity
+    };
+
+    // One underlying's line of the exchange's risk-parameter file
+    struct RiskParameters {
+        uint64_t underlying_id = 0;
+        double price = 0.0;                  // Underlying price the file was built on
+        double price_scan_range = 0.0;       // Fraction of price, e.g. 0.09
+        double volatility_scan_range = 0.0;  // Absolute, e.g. 0.04 for 4 vol points
+        double volatility = 0.0;             // Base volatility for option scenarios
+        double dividend_yield = 0.0;
+        double short_option_minimum = 0.0;   // Currency per unit short, x multiplier
+    };
+
+    struct Config {
+        double rate = 0.065;
+        double days_per_year = 365.0;
+        double extreme_move_multiple = 2.0;  // Of the price scan range
+        double extreme_move_weight = 0.35;   // Share of the extreme loss counted
+    };
+
+    struct Margin {
+        double scanning_risk = 0.0;          // Sum over underlyings of the worst scenario
+        double short_option_minimum = 0.0;   // Added where it exceeds the scanning risk
+        double total = 0.0;
+    };
+
+    struct Impact {
+        bool derivative = false;             // False: not a known contract, nothing below is set
+        double current = 0.0;
+        double projected = 0.0;              // With the order filled
+    };
+
+    struct Stats {
+        size_t contracts = 0;
+        size_t underlyings = 0;
+        size_t portfolios = 0;
+        uint64_t updates = 0;                // Fills and order changes applied
+        uint64_t loads = 0;
+    };
+
+    SpanMargin();
+    explicit SpanMargin(const Config& config);
+
+    SpanMargin(const SpanMargin&) = delete;
+    SpanMargin& operator=(const SpanMargin&) = delete;
+
+    // Adds or redefines contracts; holdings are kept and revalued. Throws
+    // std::invalid_argument on a bad strike or multiplier.
+    void add_contracts(const std::vector<Contract>& contracts);
+    void add_contract(const Contract& contract) { add_contracts({contract}); }
+    bool is_derivative(uint64_t contract_id) const;
+
+    // Exchange risk-parameter file: rebuilds the arrays of every contract on
+    // the listed underlyings at valuation time now_ns, then every portfolio's
+    // vectors for them. Returns the contracts revalued.
+    size_t load_risk_parameters(const std::vector<RiskParameters>& parameters, int64_t now_ns);
+    // One contract's array as the exchange published it (loss positive)
+    bool load_risk_array(uint64_t contract_id, const RiskArray& losses);
+    RiskArray risk_array(uint64_t contract_id) const;
+
+    // Portfolios: one per strategy or account, created by add_portfolio or
+    // on the first fill or order; add_portfolio returns the existing index
+    uint32_t add_portfolio(const std::string& portfolio_id);
+    uint32_t portfolio_index(const std::string& portfolio_id) const;
+
+    // False for a contract that is not known (or, for remove_order, an
+    // unknown portfolio). Working orders count as if filled until removed:
+    // on a cancel, or just before their fill is added.
+    bool on_fill(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity);
+    bool add_order(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity);
+    bool remove_order(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity);
+    // Filled plus working
+    double quantity(const std::string& portfolio_id, uint64_t contract_id) const;
+
+    Margin margin(const std::string& portfolio_id) const;
+    std::vector<std::pair<std::string, Margin>> all_margins() const;
+    double total_margin() const; // Over all portfolios
+    // Margin with the order filled; O(1) and lock-free. An unknown portfolio
+    // (or INVALID_INDEX) counts as empty.
+    Impact order_impact(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity) const;
+    Impact order_impact(uint32_t portfolio, uint64_t contract_id, double signed_quantity) const;
+    Stats get_stats() const;
+
+private:
+    struct Underlying {
+        uint64_t id = 0;
+        double short_option_minimum = 0.0;
+    };
+
+    struct Slot {
+        Contract contract;
+        uint32_t underlying = 0;
+    };
+
+    struct Portfolio {
+        std::string id;
+        uint32_t index = 0;
+        mutable std::mutex mutex;
+        std::vector<double> losses;            // SCENARIOS per underlying
+        std::vector<double> short_units;       // Per underlying: short option quantity x multiplier
+        std::vector<double> scan;              // Per underlying: worst scenario loss, floored at 0
+        std::vector<double> charge;            // Per underlying: max(scan, short option minimum)
+        std::unordered_map<uint32_t, double> quantity; // Per slot, working orders included
+        double scanning_risk = 0.0;
+        double total = 0.0;
+    };
+
+    // One underlying of a portfolio as order_impact() reads it
+    struct Exposure {
+        RiskArray losses;
+        double short_units;
+        double charge;
+    };
+    struct PortfolioView {
+        core::Seqlock sequence;                                // Covers every cell below
+        core::SeqlockCell<double> total;
+        std::unique_ptr<core::SeqlockCell<Exposure>[]> underlyings;
+        std::unique_ptr<core::SeqlockCell<double>[]> quantity; // Per slot, working orders included
+    };
+    // Rebuilt whole under the exclusive lock; fills rewrite their
+    // portfolio's cells in place under the portfolio's mutex
+    struct View {
+        std::unordered_map<uint64_t, uint32_t> slot_index;
+        std::vector<Slot> slots;
+        std::vector<double> arrays;
+        std::vector<double> short_option_minimum;              // Per underlying
+        std::unordered_map<std::string, uint32_t> portfolio_index;
+        std::vector<std::unique_ptr<PortfolioView>> portfolios;
+    };
+
+    Config config_;
+    core::RcuPointer<View> view_;
+
+    // Exclusive for the contract master, loads and new portfolios
+    mutable std::shared_mutex mutex_;
+    std::vector<Slot> slots_;
+    std::unordered_map<uint64_t, uint32_t> slot_index_;
+    std::vector<double> arrays_;               // SCENARIOS per slot
+    std::vector<Underlying> underlyings_;
+    std::unordered_map<uint64_t, uint32_t> underlying_index_;
+    std::vector<std::unique_ptr<Portfolio>> portfolios_;
+    std::unordered_map<std::string, uint32_t> portfolio_index_;
+    uint64_t loads_ = 0;
+    std::atomic<uint64_t> updates_{0};
+
+    // Under a shared lock of mutex_
+    uint32_t slot(uint64_t contract_id) const;
+    Portfolio* portfolio(const std::string& portfolio_id) const;
+    bool apply(const std::string& portfolio_id, uint64_t contract_id, double signed_quantity, bool create);
+    // Under the portfolio's mutex
+    void move(Portfolio& portfolio, uint32_t slot, double signed_quantity) const;
+    void recharge(Portfolio& portfolio, uint32_t underlying) const;
+    void publish(const Portfolio& portfolio, uint32_t slot, uint32_t underlying) const;
+    // Under the exclusive lock
+    void publish_view();
+    uint32_t create_portfolio(const std::string& portfolio_id);
+    // Vectors of the marked underlyings from the held quantities
+    void rebuild(Portfolio& portfolio, const std::vector<uint8_t>& underlyings) const;
+    void value_contract(uint32_t slot, const RiskParameters& parameters, int64_t now_ns);
+};
+
+} // namespace goldearn::risk
@@ -0,0 +1,322 @@
+#include "stress_engine.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <stdexcept>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::risk {
+
+namespace {
+
+constexpr double NO_LOSS = std::numeric_limits<double>::max();
+// Worst position of a scenario must be found again from all columns
+constexpr uint32_t RESCAN = StressEngine::NO_POSITION - 1;
+constexpr size_t TRANSPOSE_TILE = 64;
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+struct StressEngine::Job {
+    bool incremental = false;
+    std::vector<uint32_t> columns; // Held positions (full) or changed ones (incremental)
+    size_t block_size = 0;
+    size_t num_blocks = 0;
+    std::atomic<size_t> next_block{0};
+    std::vector<uint64_t> rescanned; // Per thread
+};
+
+StressEngine::StressEngine(const Config& config) : config_(config) {
+    config_.num_threads = std::max<size_t>(config_.num_threads, 1);
+    config_.scenario_block = round_up(std::max<size_t>(config_.scenario_block, 4), 4);
+    if (config_.num_threads > 1) {
+        pool_ = std::make_unique<core::WorkStealingPool>(
+            core::WorkStealingPool::Config{"stress", config_.num_threads - 1, config_.cores});
+        pool_->start();
+    }
+    scratch_.resize(config_.num_threads, std::vector<double>(config_.scenario_block));
+}
+
+StressEngine::~StressEngine() {
+    if (pool_) {
+        pool_->stop();
+    }
+}
+
+void StressEngine::set_scenarios(const std::vector<uint64_t>& symbols, const std::vector<std::string>& names,
+                                 const std::vector<double>& shocks) {
+    const size_t n = symbols.size();
+    const size_t scenarios = names.size();
+    if (shocks.size() != scenarios * n) {
+        throw std::invalid_argument("StressEngine: shocks are not scenarios x symbols");
+    }
+    std::unordered_map<uint64_t, uint32_t> index;
+    for (size_t i = 0; i < n; ++i) {
+        if (!index.emplace(symbols[i], static_cast<uint32_t>(i)).second) {
+            throw std::invalid_argument("StressEngine: symbol listed twice");
+        }
+    }
+
+    // Positions follow their symbols into the new universe
+    std::vector<double> exposures(n, 0.0);
+    for (size_t i = 0; i < symbols_.size(); ++i) {
+        auto it = index.find(symbols_[i]);
+        if (it != index.end()) {
+            exposures[it->second] = exposures_[i];
+        }
+    }
+
+    stride_ = round_up(scenarios, 4);
+    shocks_.assign(n * stride_, 0.0);
+    // Tiled transpose so neither side strides through the whole matrix
+    for (size_t s0 = 0; s0 < scenarios; s0 += TRANSPOSE_TILE) {
+        const size_t s1 = std::min(s0 + TRANSPOSE_TILE, scenarios);
+        for (size_t j0 = 0; j0 < n; j0 += TRANSPOSE_TILE) {
+            const size_t j1 = std::min(j0 + TRANSPOSE_TILE, n);
+            for (size_t j = j0; j < j1; ++j) {
+                for (size_t s = s0; s < s1; ++s) {
+                    shocks_[j * stride_ + s] = shocks[s * n + j];
+                }
+            }
+        }
+    }
+
+    symbols_ = symbols;
+    index_ = std::move(index);
+    names_ = names;
+    exposures_ = std::move(exposures);
+    evaluated_.assign(n, 0.0);
+    is_changed_.assign(n, 0);
+    changed_.clear();
+    result_valid_ = false;
+    LOG_INFO("StressEngine: {} scenarios over {} symbols", scenarios, n);
+}
+
+uint32_t StressEngine::index(uint64_t symbol_id) const {
+    auto it = index_.find(symbol_id);
+    return it != index_.end() ? it->second : NO_POSITION;
+}
+
+void StressEngine::mark_changed(uint32_t index) {
+    if (!is_changed_[index]) {
+        is_changed_[index] = 1;
+        changed_.push_back(index);
+    }
+}
+
+void StressEngine::set_exposure(uint64_t symbol_id, double exposure) {
+    auto it = index_.find(symbol_id);
+    if (it == index_.end() || exposures_[it->second] == exposure) {
+        return;
+    }
+    exposures_[it->second] = exposure;
+    mark_changed(it->second);
+}
+
+void StressEngine::set_exposures(const std::unordered_map<uint64_t, double>& exposures) {
+    for (uint32_t i = 0; i < exposures_.size(); ++i) {
+        auto it = exposures.find(symbols_[i]);
+        const double exposure = it != exposures.end() ? it->second : 0.0;
+        if (exposures_[i] != exposure) {
+            exposures_[i] = exposure;
+            mark_changed(i);
+        }
+    }
+}
+
+double StressEngine::exposure(uint64_t symbol_id) const {
+    auto it = index_.find(symbol_id);
+    return it != index_.end() ? exposures_[it->second] : 0.0;
+}
+
+const StressEngine::Result& StressEngine::evaluate() {
+    auto start = std::chrono::steady_clock::now();
+    Job job;
+    job.incremental = result_valid_ &&
+        static_cast<double>(changed_.size()) <= config_.full_rerun_fraction * static_cast<double>(symbols_.size());
+    if (job.incremental) {
+        job.columns = changed_;
+    } else {
+        pnl_.assign(stride_, 0.0);
+        worst_.assign(stride_, NO_LOSS);
+        worst_position_.assign(stride_, NO_POSITION);
+        for (uint32_t j = 0; j < exposures_.size(); ++j) {
+            if (exposures_[j] != 0.0) {
+                job.columns.push_back(j);
+            }
+        }
+    }
+    if (!job.incremental || !job.columns.empty()) {
+        run(job);
+    }
+    for (uint32_t j : changed_) {
+        evaluated_[j] = exposures_[j];
+        is_changed_[j] = 0;
+    }
+    changed_.clear();
+    result_valid_ = true;
+
+    const size_t scenarios = names_.size();
+    result_.pnl.assign(pnl_.begin(), pnl_.begin() + scenarios);
+    result_.worst_position.assign(worst_position_.begin(), worst_position_.begin() + scenarios);
+    result_.worst_position_pnl.resize(scenarios);
+    for (size_t s = 0; s < scenarios; ++s) {
+        result_.worst_position_pnl[s] = worst_position_[s] == NO_POSITION ? 0.0 : worst_[s];
+    }
+    if (job.incremental) {
+        ++stats_.incremental_runs;
+        for (uint64_t count : job.rescanned) {
+            stats_.rescanned_scenarios += count;
+        }
+    } else {
+        ++stats_.full_runs;
+    }
+    result_.incremental = job.incremental;
+    result_.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result_;
+}
+
+void StressEngine::run(Job& job) {
+    job.block_size = config_.scenario_block;
+    job.num_blocks = (stride_ + job.block_size - 1) / job.block_size;
+    job.rescanned.assign(config_.num_threads, 0);
+    const size_t threads = std::min(config_.num_threads, std::max<size_t>(job.num_blocks, 1));
+
+    std::latch done(static_cast<ptrdiff_t>(threads));
+    for (size_t worker = 1; worker < threads; ++worker) {
+        pool_->submit([this, &job, &done, worker]() {
+            run_worker(job, worker);
+            done.count_down();
+        });
+    }
+    run_worker(job, 0);
+    done.arrive_and_wait();
+}
+
+void StressEngine::run_worker(Job& job, size_t worker) {
+    for (;;) {
+        const size_t block = job.next_block.fetch_add(1, std::memory_order_relaxed);
+        if (block >= job.num_blocks) {
+            return;
+        }
+        const size_t first = block * job.block_size;
+        const size_t last = std::min(first + job.block_size, stride_);
+        if (job.incremental) {
+            update_block(job, first, last, job.rescanned[worker]);
+        } else {
+            evaluate_block(job, first, last, scratch_[worker].data());
+        }
+    }
+}
+
+// pnl = sum e[j] shock[:, j] over the held columns, tracking the lowest
+// e[j] shock[s, j] and its column. The block's accumulators stay in L1.
+void StressEngine::evaluate_block(const Job& job, size_t first, size_t last, double* worst_index) {
+    double* pnl = pnl_.data() + first;
+    double* worst = worst_.data() + first;
+    const size_t count = last - first;
+    std::fill(worst_index, worst_index + count, -1.0);
+
+    for (uint32_t j : job.columns) {
+        const double e = exposures_[j];
+        const double* column = shocks_.data() + j * stride_ + first;
+        size_t s = 0;
+#ifdef __AVX2__
+        const __m256d ev = _mm256_set1_pd(e);
+        const __m256d jv = _mm256_set1_pd(static_cast<double>(j));
+        for (; s < count; s += 4) {
+            __m256d c = _mm256_mul_pd(ev, _mm256_loadu_pd(column + s));
+            _mm256_storeu_pd(pnl + s, _mm256_add_pd(_mm256_loadu_pd(pnl + s), c));
+            __m256d w = _mm256_loadu_pd(worst + s);
+            __m256d lower = _mm256_cmp_pd(c, w, _CMP_LT_OQ);
+            _mm256_storeu_pd(worst + s, _mm256_blendv_pd(w, c, lower));
+            _mm256_storeu_pd(worst_index + s, _mm256_blendv_pd(_mm256_loadu_pd(worst_index + s), jv, lower));
+        }
+#endif
+        for (; s < count; ++s) {
+            const double c = e * column[s];
+            pnl[s] += c;
+            if (c < worst[s]) {
+                worst[s] = c;
+                worst_index[s] = static_cast<double>(j);
+            }
+        }
+    }
+
+    uint32_t* position = worst_position_.data() + first;
+    for (size_t s = 0; s < count; ++s) {
+        position[s] = worst_index[s] < 0.0 ? NO_POSITION : static_cast<uint32_t>(worst_index[s]);
+    }
+}
+
+// pnl += (e_new - e_old) shock[:, j] for each changed column. The worst
+// position only needs a full rescan where it was a changed column that got better.
+void StressEngine::update_block(const Job& job, size_t first, size_t last, uint64_t& rescanned) {
+    double* pnl = pnl_.data();
+    double* worst = worst_.data();
+    uint32_t* position = worst_position_.data();
+
+    for (uint32_t j : job.columns) {
+        const double e = exposures_[j];
+        const double delta = e - evaluated_[j];
+        const double* column = shocks_.data() + j * stride_;
+        for (size_t s = first; s < last; ++s) {
+            pnl[s] += delta * column[s];
+            const double c = e != 0.0 ? e * column[s] : NO_LOSS;
+            if (position[s] == j) {
+                if (c <= worst[s]) {
+                    worst[s] = c;
+                } else {
+                    position[s] = RESCAN;
+                }
+            } else if (c < worst[s]) {
+                worst[s] = c;
+                position[s] = j;
+            }
+        }
+    }
+
+    for (size_t s = first; s < last; ++s) {
+        if (position[s] == RESCAN) {
+            rescan(s);
+            ++rescanned;
+        }
+    }
+}
+
+void StressEngine::rescan(size_t scenario) {
+    double worst = NO_LOSS;
+    uint32_t position = NO_POSITION;
+    for (uint32_t j = 0; j < exposures_.size(); ++j) {
+        if (exposures_[j] == 0.0) {
+            continue;
+        }
+        const double c = exposures_[j] * shocks_[j * stride_ + scenario];
+        if (c < worst) {
+            worst = c;
+            position = j;
+        }
+    }
+    worst_[scenario] = worst;
+    worst_position_[scenario] = position;
+}
+
+std::vector<std::pair<uint64_t, double>> StressEngine::position_impacts(size_t scenario) const {
+    std::vector<std::pair<uint64_t, double>> impacts;
+    for (uint32_t j = 0; j < exposures_.size(); ++j) {
+        if (exposures_[j] != 0.0) {
+            impacts.emplace_back(symbols_[j], exposures_[j] * shocks_[j * stride_ + scenario]);
+        }
+    }
+    std::sort(impacts.begin(), impacts.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+    return impacts;
+}
+
+} // namespace goldearn::risk
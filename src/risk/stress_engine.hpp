@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../core/thread_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace goldearn::risk {
+
+// Scenario P&L for a whole grid of stress scenarios against live positions.
+//
+// Each scenario is a relative price change per symbol (-0.1 = down 10%), so
+// scenario P&L is the matrix-vector product shocks x exposures. Shocks are
+// stored column by column (one symbol's shocks across all scenarios
+// contiguous) and positions as flat arrays over the same universe.
+// evaluate() walks scenario blocks small enough that their P&L and worst
+// position stay in L1 while the non-zero columns stream past, blocks handed
+// out to the workers.
+//
+// When only positions changed since the last result, evaluate() adds
+// change x column for each changed symbol instead: O(scenarios) per changed
+// position. Too many changes (or new scenarios) fall back to the full product.
+//
+// Not thread-safe; one owner drives it, as with MonteCarloVaREngine.
+class StressEngine {
+public:
+    static constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+
+    struct Config {
+        size_t num_threads = 1;            // Including the calling thread
+        std::vector<int> cores;            // Worker affinity; empty = none
+        size_t scenario_block = 512;       // Scenarios per work item, a multiple of 4
+        double full_rerun_fraction = 0.125; // Changed positions beyond this share -> full product
+    };
+
+    struct Result {
+        std::vector<double> pnl;                // Per scenario
+        std::vector<double> worst_position_pnl; // Lowest single-position P&L; 0 when flat
+        std::vector<uint32_t> worst_position;   // Universe index of it; NO_POSITION when flat
+        bool incremental = false;
+        double elapsed_ms = 0.0;
+    };
+
+    struct Stats {
+        uint64_t full_runs = 0;
+        uint64_t incremental_runs = 0;
+        uint64_t rescanned_scenarios = 0; // Worst position moved off a changed one
+    };
+
+    explicit StressEngine(const Config& config);
+    ~StressEngine();
+
+    StressEngine(const StressEngine&) = delete;
+    StressEngine& operator=(const StressEngine&) = delete;
+
+    // Row-major scenarios x symbols. Exposures of symbols still in the
+    // universe are kept. Throws std::invalid_argument on mismatched sizes.
+    void set_scenarios(const std::vector<uint64_t>& symbols, const std::vector<std::string>& names,
+                       const std::vector<double>& shocks);
+    size_t num_scenarios() const { return names_.size(); }
+    size_t num_symbols() const { return symbols_.size(); }
+    const std::string& scenario_name(size_t scenario) const { return names_[scenario]; }
+    uint64_t symbol(uint32_t index) const { return symbols_[index]; }
+    uint32_t index(uint64_t symbol_id) const;
+    double shock(size_t scenario, uint32_t index) const { return shocks_[index * stride_ + scenario]; }
+
+    // Currency value of the position; symbols outside the universe carry no stress risk
+    void set_exposure(uint64_t symbol_id, double exposure);
+    // Replaces every position; symbols not listed are flat
+    void set_exposures(const std::unordered_map<uint64_t, double>& exposures);
+    double exposure(uint64_t symbol_id) const;
+
+    const Result& evaluate();
+    // One scenario's P&L per held position, worst first
+    std::vector<std::pair<uint64_t, double>> position_impacts(size_t scenario) const;
+
+    Stats get_stats() const { return stats_; }
+    size_t num_threads() const { return config_.num_threads; }
+
+private:
+    struct Job;
+
+    Config config_;
+    std::unique_ptr<core::WorkStealingPool> pool_;
+
+    std::vector<uint64_t> symbols_;
+    std::unordered_map<uint64_t, uint32_t> index_;
+    std::vector<std::string> names_;
+    size_t stride_ = 0;           // Column length: scenarios rounded up to 4
+    std::vector<double> shocks_;  // Column-major, stride_ per symbol
+
+    std::vector<double> exposures_;  // Current
+    std::vector<double> evaluated_;  // As of result_
+    std::vector<uint32_t> changed_;  // Indices where they may differ
+    std::vector<uint8_t> is_changed_;
+    bool result_valid_ = false;
+
+    // Over stride_ scenarios; flat scenarios hold NO_LOSS / NO_POSITION
+    std::vector<double> pnl_;
+    std::vector<double> worst_;
+    std::vector<uint32_t> worst_position_;
+    Result result_;
+    std::vector<std::vector<double>> scratch_; // Per thread, one block of worst-position indices
+    Stats stats_;
+
+    void mark_changed(uint32_t index);
+    void run(Job& job);
+    void run_worker(Job& job, size_t worker);
+    void evaluate_block(const Job& job, size_t first, size_t last, double* worst_index);
+    void update_block(const Job& job, size_t first, size_t last, uint64_t& rescanned);
+    void rescan(size_t scenario);
+};
+
+} // namespace goldearn::risk
@@ -0,0 +1,290 @@
+#include "risk_engine.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace goldearn::risk {
+
+namespace {
+
+void check_confidence_level(double confidence_level) {
+    if (!(confidence_level > 0.0 && confidence_level < 1.0)) {
+        throw std::invalid_argument("VaRCalculator: confidence_level is the tail probability, in (0, 1)");
+    }
+}
+
+double lookup(const std::unordered_map<uint64_t, double>& values, uint64_t symbol_id) {
+    auto it = values.find(symbol_id);
+    return it != values.end() ? it->second : 0.0;
+}
+
+} // namespace
+
+VaRCalculator::VaRCalculator() : VaRCalculator(MonteCarloVaREngine::Config{}) {}
+
+VaRCalculator::VaRCalculator(const MonteCarloVaREngine::Config& monte_carlo_config)
+    : monte_carlo_config_(monte_carlo_config) {}
+
+VaRCalculator::~VaRCalculator() = default;
+
+double VaRCalculator::calculate_parametric_var(const std::unordered_map<uint64_t, double>& positions,
+                                               const std::unordered_map<uint64_t, double>& volatilities,
+                                               const CorrelationMap& correlations, double confidence_level,
+                                               uint32_t time_horizon_days) const {
+    check_confidence_level(confidence_level);
+    double volatility = calculate_portfolio_volatility(positions, volatilities, correlations);
+    return -inverse_normal_cdf(confidence_level) * std::sqrt(static_cast<double>(time_horizon_days)) * volatility;
+}
+
+double VaRCalculator::calculate_historical_var(
+    const std::unordered_map<uint64_t, double>& positions,
+    const std::unordered_map<uint64_t, std::vector<double>>& historical_returns, double confidence_level,
+    uint32_t lookback_days) const {
+    check_confidence_level(confidence_level);
+    std::vector<double> pnl = generate_portfolio_returns(positions, historical_returns);
+    if (pnl.size() > lookback_days) {
+        pnl.erase(pnl.begin(), pnl.end() - lookback_days); // Most recent days are at the back
+    }
+    if (pnl.empty()) {
+        return 0.0;
+    }
+    return -quantile(std::move(pnl), confidence_level);
+}
+
+double VaRCalculator::calculate_monte_carlo_var(const std::unordered_map<uint64_t, double>& positions,
+                                                const std::unordered_map<uint64_t, double>& expected_returns,
+                                                const std::unordered_map<uint64_t, double>& volatilities,
+                                                const CorrelationMap& correlations, double confidence_level,
+                                                uint32_t time_horizon_days, uint32_t num_simulations) const {
+    check_confidence_level(confidence_level);
+    std::vector<uint64_t> symbols = sorted_symbols(positions);
+    if (symbols.empty() || num_simulations == 0) {
+        return 0.0;
+    }
+
+    MonteCarloVaREngine::Exposures exposures;
+    exposures.delta.reserve(symbols.size());
+    exposures.drift.reserve(symbols.size());
+    exposures.volatility.reserve(symbols.size());
+    for (uint64_t symbol_id : symbols) {
+        exposures.delta.push_back(positions.at(symbol_id));
+        exposures.drift.push_back(lookup(expected_returns, symbol_id));
+        exposures.volatility.push_back(lookup(volatilities, symbol_id));
+    }
+    std::vector<double> matrix = correlation_matrix(symbols, correlations);
+
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+    if (!engine_) {
+        engine_ = std::make_unique<MonteCarloVaREngine>(monte_carlo_config_);
+    }
+    engine_->set_correlation(matrix.data(), symbols.size());
+    last_monte_carlo_ = engine_->run(exposures, time_horizon_days, confidence_level, num_simulations);
+    return last_monte_carlo_.var;
+}
+
+// Euler decomposition of parametric VaR: the component of position i is
+// w[i] * dVaR/dw[i] = z * w[i] * (S w)[i] / sqrt(w' S w); components sum to VaR
+std::unordered_map<uint64_t, double> VaRCalculator::calculate_component_var(
+    const std::unordered_map<uint64_t, double>& positions, const std::unordered_map<uint64_t, double>& volatilities,
+    const CorrelationMap& correlations, double confidence_level) const {
+    check_confidence_level(confidence_level);
+    std::unordered_map<uint64_t, double> components;
+    auto exposure = weighted_exposure(positions, volatilities, correlations);
+    if (exposure.variance <= 0.0) {
+        return components;
+    }
+    const double scale = -inverse_normal_cdf(confidence_level) / std::sqrt(exposure.variance);
+    for (size_t i = 0; i < exposure.symbols.size(); ++i) {
+        components[exposure.symbols[i]] = exposure.exposures[i] * exposure.weighted[i] * scale;
+    }
+    return components;
+}
+
+double VaRCalculator::calculate_marginal_var(uint64_t symbol_id, const std::unordered_map<uint64_t, double>& positions,
+                                             const std::unordered_map<uint64_t, double>& volatilities,
+                                             const CorrelationMap& correlations, double confidence_level) const {
+    check_confidence_level(confidence_level);
+    // Zero exposure to a symbol not held still has a marginal
+    auto with_symbol = positions;
+    with_symbol.try_emplace(symbol_id, 0.0);
+    auto exposure = weighted_exposure(with_symbol, volatilities, correlations);
+    if (exposure.variance <= 0.0) {
+        return 0.0;
+    }
+    size_t i = std::lower_bound(exposure.symbols.begin(), exposure.symbols.end(), symbol_id) - exposure.symbols.begin();
+    return -inverse_normal_cdf(confidence_level) * exposure.weighted[i] / std::sqrt(exposure.variance);
+}
+
+double VaRCalculator::calculate_incremental_var(uint64_t symbol_id, double new_position,
+                                                const std::unordered_map<uint64_t, double>& existing_positions,
+                                                const std::unordered_map<uint64_t, double>& volatilities,
+                                                const CorrelationMap& correlations, double confidence_level) const {
+    auto with_order = existing_positions;
+    with_order[symbol_id] += new_position;
+    return calculate_parametric_var(with_order, volatilities, correlations, confidence_level) -
+           calculate_parametric_var(existing_positions, volatilities, correlations, confidence_level);
+}
+
+// Stand-alone VaR of each position against its share of the portfolio VaR
+std::unordered_map<uint64_t, VaRCalculator::RiskDecomposition> VaRCalculator::decompose_portfolio_risk(
+    const std::unordered_map<uint64_t, double>& positions, const std::unordered_map<uint64_t, double>& volatilities,
+    const CorrelationMap& correlations) const {
+    constexpr double CONFIDENCE_LEVEL = 0.05;
+    const double z = -inverse_normal_cdf(CONFIDENCE_LEVEL);
+    auto components = calculate_component_var(positions, volatilities, correlations, CONFIDENCE_LEVEL);
+    std::unordered_map<uint64_t, RiskDecomposition> decomposition;
+    for (const auto& [symbol_id, position] : positions) {
+        RiskDecomposition risk;
+        risk.individual_var = z * std::fabs(position) * lookup(volatilities, symbol_id);
+        risk.total_contribution = lookup(components, symbol_id);
+        risk.diversification_benefit = std::max(risk.individual_var - risk.total_contribution, 0.0);
+        risk.correlation_penalty = std::max(risk.total_contribution - risk.individual_var, 0.0);
+        decomposition[symbol_id] = risk;
+    }
+    return decomposition;
+}
+
+MonteCarloVaREngine::Result VaRCalculator::get_last_monte_carlo_result() const {
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+    return last_monte_carlo_;
+}
+
+// Acklam's rational approximation, polished with one Halley step
+double VaRCalculator::inverse_normal_cdf(double probability) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    constexpr double LOW = 0.02425;
+
+    double x;
+    if (probability < LOW) {
+        double q = std::sqrt(-2.0 * std::log(probability));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    } else if (probability <= 1.0 - LOW) {
+        double q = probability - 0.5;
+        double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    } else {
+        double q = std::sqrt(-2.0 * std::log(1.0 - probability));
+        x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+
+    double error = 0.5 * std::erfc(-x / std::sqrt(2.0)) - probability;
+    double u = error * std::sqrt(2.0 * M_PI) * std::exp(0.5 * x * x);
+    return x - u / (1.0 + 0.5 * x * u);
+}
+
+// Daily portfolio P&L over the days every held symbol has a return for,
+// aligned on the most recent day (the back of each series)
+std::vector<double> VaRCalculator::generate_portfolio_returns(
+    const std::unordered_map<uint64_t, double>& positions,
+    const std::unordered_map<uint64_t, std::vector<double>>& asset_returns) const {
+    size_t days = std::numeric_limits<size_t>::max();
+    for (const auto& [symbol_id, position] : positions) {
+        auto it = asset_returns.find(symbol_id);
+        if (it == asset_returns.end()) {
+            LOG_WARN("VaRCalculator: no return history for symbol {}, left out of historical VaR", symbol_id);
+            continue;
+        }
+        days = std::min(days, it->second.size());
+    }
+    if (days == std::numeric_limits<size_t>::max()) {
+        return {};
+    }
+
+    std::vector<double> pnl(days, 0.0);
+    for (uint64_t symbol_id : sorted_symbols(positions)) {
+        auto it = asset_returns.find(symbol_id);
+        if (it == asset_returns.end()) {
+            continue;
+        }
+        const double position = positions.at(symbol_id);
+        const double* returns = it->second.data() + (it->second.size() - days);
+        for (size_t day = 0; day < days; ++day) {
+            pnl[day] += position * returns[day];
+        }
+    }
+    return pnl;
+}
+
+double VaRCalculator::calculate_portfolio_volatility(const std::unordered_map<uint64_t, double>& weights,
+                                                     const std::unordered_map<uint64_t, double>& volatilities,
+                                                     const CorrelationMap& correlations) const {
+    return std::sqrt(std::max(weighted_exposure(weights, volatilities, correlations).variance, 0.0));
+}
+
+VaRCalculator::WeightedExposure VaRCalculator::weighted_exposure(
+    const std::unordered_map<uint64_t, double>& positions, const std::unordered_map<uint64_t, double>& volatilities,
+    const CorrelationMap& correlations) {
+    WeightedExposure result;
+    result.symbols = sorted_symbols(positions);
+    std::vector<double> matrix = correlation_matrix(result.symbols, correlations);
+    const size_t n = result.symbols.size();
+    std::vector<double> scaled(n);
+    result.exposures.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        result.exposures[i] = positions.at(result.symbols[i]);
+        scaled[i] = result.exposures[i] * lookup(volatilities, result.symbols[i]);
+    }
+    // (S w)[i] = sigma[i] * (C (sigma . w))[i]
+    result.weighted.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = &matrix[i * n];
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            sum += row[j] * scaled[j];
+        }
+        result.weighted[i] = lookup(volatilities, result.symbols[i]) * sum;
+        result.variance += scaled[i] * sum;
+    }
+    return result;
+}
+
+std::vector<uint64_t> VaRCalculator::sorted_symbols(const std::unordered_map<uint64_t, double>& positions) {
+    std::vector<uint64_t> symbols;
+    symbols.reserve(positions.size());
+    for (const auto& [symbol_id, position] : positions) {
+        symbols.push_back(symbol_id);
+    }
+    std::sort(symbols.begin(), symbols.end());
+    return symbols;
+}
+
+std::vector<double> VaRCalculator::correlation_matrix(const std::vector<uint64_t>& symbols,
+                                                      const CorrelationMap& correlations) {
+    const size_t n = symbols.size();
+    std::vector<double> matrix(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        matrix[i * n + i] = 1.0;
+        for (size_t j = 0; j < i; ++j) {
+            auto it = correlations.find({symbols[i], symbols[j]});
+            if (it == correlations.end()) {
+                it = correlations.find({symbols[j], symbols[i]});
+            }
+            double rho = it != correlations.end() ? std::clamp(it->second, -1.0, 1.0) : 0.0;
+            matrix[i * n + j] = rho;
+            matrix[j * n + i] = rho;
+        }
+    }
+    return matrix;
+}
+
+// Value at `percentile` of the sorted sample: its ceil(percentile * n)-th smallest
+double VaRCalculator::quantile(std::vector<double> values, double percentile) const {
+    auto rank = static_cast<size_t>(std::ceil(percentile * static_cast<double>(values.size())));
+    rank = std::clamp<size_t>(rank, 1, values.size());
+    std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+    return values[rank - 1];
+}
+
+} // namespace goldearn::risk
@@ -0,0 +1,428 @@
+#include "var_engine.hpp"
+#include "../utils/philox.hpp"
+#include "../utils/vector_math.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <latch>
+#include <stdexcept>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::risk {
+
+namespace {
+
+constexpr double PIVOT_EPSILON = 1e-10;
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// 32 normals: Philox counters (8 * block + lane, path), both Box-Muller
+// pairs of each. Normal 8 * pair + lane, pairs (w0, w1) cos, sin, (w2, w3) cos, sin.
+inline void normal_block(uint32_t key0, uint32_t key1, uint32_t path, uint32_t block, double* out) {
+#ifdef __AVX2__
+    __m256i words[4];
+    words[0] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(block * 8)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    words[1] = _mm256_set1_epi32(static_cast<int>(path));
+    words[2] = _mm256_setzero_si256();
+    words[3] = _mm256_setzero_si256();
+    utils::philox::generate_x8(words, key0, key1);
+
+    __m256d z0, z1;
+    utils::vmath::box_muller(_mm256_castsi256_si128(words[0]), _mm256_castsi256_si128(words[1]), z0, z1);
+    _mm256_storeu_pd(out, z0);
+    _mm256_storeu_pd(out + 8, z1);
+    utils::vmath::box_muller(_mm256_extracti128_si256(words[0], 1), _mm256_extracti128_si256(words[1], 1), z0, z1);
+    _mm256_storeu_pd(out + 4, z0);
+    _mm256_storeu_pd(out + 12, z1);
+    utils::vmath::box_muller(_mm256_castsi256_si128(words[2]), _mm256_castsi256_si128(words[3]), z0, z1);
+    _mm256_storeu_pd(out + 16, z0);
+    _mm256_storeu_pd(out + 24, z1);
+    utils::vmath::box_muller(_mm256_extracti128_si256(words[2], 1), _mm256_extracti128_si256(words[3], 1), z0, z1);
+    _mm256_storeu_pd(out + 20, z0);
+    _mm256_storeu_pd(out + 28, z1);
+#else
+    for (uint32_t lane = 0; lane < 8; ++lane) {
+        auto words = utils::philox::generate({{block * 8 + lane, path, 0, 0}}, key0, key1);
+        utils::vmath::box_muller(words.v[0], words.v[1], out[lane], out[8 + lane]);
+        utils::vmath::box_muller(words.v[2], words.v[3], out[16 + lane], out[24 + lane]);
+    }
+#endif
+}
+
+// Sum of a[k] * b[k] for k < count, count a multiple of 4
+inline double dot(const double* a, const double* b, size_t count) {
+#ifdef __AVX2__
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        sum0 = utils::vmath::fmadd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k), sum0);
+        sum1 = utils::vmath::fmadd(_mm256_loadu_pd(a + k + 4), _mm256_loadu_pd(b + k + 4), sum1);
+    }
+    if (k < count) {
+        sum0 = utils::vmath::fmadd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k), sum0);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(sum0, sum1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    double sum = 0.0;
+    for (size_t k = 0; k < count; ++k) {
+        sum += a[k] * b[k];
+    }
+    return sum;
+#endif
+}
+
+// Four dots sharing a: out[r] = a . b[r] over count (a multiple of 4)
+inline void dot4(const double* a, const double* const b[4], size_t count, double out[4]) {
+#ifdef __AVX2__
+    __m256d sum[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+    for (size_t k = 0; k < count; k += 4) {
+        __m256d x = _mm256_loadu_pd(a + k);
+        for (int r = 0; r < 4; ++r) {
+            sum[r] = utils::vmath::fmadd(x, _mm256_loadu_pd(b[r] + k), sum[r]);
+        }
+    }
+    __m256d low = _mm256_hadd_pd(sum[0], sum[1]);
+    __m256d high = _mm256_hadd_pd(sum[2], sum[3]);
+    _mm256_storeu_pd(out, _mm256_add_pd(_mm256_permute2f128_pd(low, high, 0x20),
+                                        _mm256_permute2f128_pd(low, high, 0x31)));
+#else
+    for (int r = 0; r < 4; ++r) {
+        out[r] = dot(a, b[r], count);
+    }
+#endif
+}
+
+} // namespace
+
+void generate_normals(uint64_t seed, uint32_t path, size_t count, double* out) {
+    auto key0 = static_cast<uint32_t>(seed);
+    auto key1 = static_cast<uint32_t>(seed >> 32);
+    for (size_t block = 0; block < count / NORMALS_PER_BLOCK; ++block) {
+        normal_block(key0, key1, path, static_cast<uint32_t>(block), out + block * NORMALS_PER_BLOCK);
+    }
+}
+
+struct MonteCarloVaREngine::Job {
+    uint32_t num_paths = 0;
+    uint32_t chunk_size = 0;
+    uint32_t num_chunks = 0;
+    std::atomic<uint32_t> next_chunk{0};
+    std::vector<double> chunk_sums;
+    uint32_t key0 = 0;
+    uint32_t key1 = 0;
+
+    // P&L = constant + sum linear[i] * y[i] + quadratic[i] * y[i]^2, y = L e.
+    // For a linear book `linear` is already projected through L.
+    double constant = 0.0;
+    std::vector<double> linear;
+    std::vector<double> quadratic;
+    bool has_gamma = false;
+};
+
+void MonteCarloVaREngine::Tail::push(double pnl) {
+    if (worst.size() < capacity) {
+        worst.push_back(pnl);
+        std::push_heap(worst.begin(), worst.end());
+    } else if (pnl < worst.front()) {
+        std::pop_heap(worst.begin(), worst.end());
+        worst.back() = pnl;
+        std::push_heap(worst.begin(), worst.end());
+    }
+}
+
+MonteCarloVaREngine::MonteCarloVaREngine(const Config& config) : config_(config) {
+    config_.num_threads = std::max<size_t>(config_.num_threads, 1);
+    config_.paths_per_chunk = static_cast<uint32_t>(round_up(std::max<uint32_t>(config_.paths_per_chunk, 4), 4));
+    if (config_.num_threads > 1) {
+        pool_ = std::make_unique<core::WorkStealingPool>(
+            core::WorkStealingPool::Config{"var-mc", config_.num_threads - 1, config_.cores});
+        pool_->start();
+    }
+    tails_.resize(config_.num_threads);
+}
+
+MonteCarloVaREngine::~MonteCarloVaREngine() {
+    if (pool_) {
+        pool_->stop();
+    }
+}
+
+bool MonteCarloVaREngine::set_correlation(const double* matrix, size_t n) {
+    if (n == dimension_ && std::equal(matrix, matrix + n * n, correlation_.begin())) {
+        return factor_exact_;
+    }
+    dimension_ = n;
+    correlation_.assign(matrix, matrix + n * n);
+    factorize();
+    return factor_exact_;
+}
+
+// Row-oriented Cholesky on the zero-padded factor: L[i][j] needs the dot of
+// rows i and j up to j, and the padding lets every dot run in whole vectors.
+// Four j at a time share the loads of row i.
+void MonteCarloVaREngine::factorize() {
+    auto start = std::chrono::steady_clock::now();
+    const size_t n = dimension_;
+    stride_ = round_up(std::max<size_t>(n, 1), NORMALS_PER_BLOCK);
+    factor_.assign((n + 1) * stride_, 0.0); // Spare zero row pairs up an odd last row
+    factor_exact_ = true;
+
+    auto finish = [&](double* row_i, size_t i, size_t j, double partial) {
+        const double pivot = factor_[j * stride_ + j];
+        row_i[j] = pivot > 0.0 ? (correlation_[i * n + j] - partial) / pivot : 0.0;
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        double* row_i = &factor_[i * stride_];
+        size_t j = 0;
+        for (; j + 4 <= i; j += 4) {
+            const double* rows[4] = {&factor_[j * stride_], &factor_[(j + 1) * stride_],
+                                     &factor_[(j + 2) * stride_], &factor_[(j + 3) * stride_]};
+            double partial[4];
+            dot4(row_i, rows, j, partial);
+            // Columns j + 1.. also need the entries of row i just computed
+            for (size_t r = 0; r < 4; ++r) {
+                for (size_t k = j; k < j + r; ++k) {
+                    partial[r] += row_i[k] * rows[r][k];
+                }
+                finish(row_i, i, j + r, partial[r]);
+            }
+        }
+        for (; j < i; ++j) {
+            finish(row_i, i, j, dot(row_i, &factor_[j * stride_], round_up(j, 4)));
+        }
+        double pivot = correlation_[i * n + i] - dot(row_i, row_i, round_up(i, 4));
+        if (pivot > PIVOT_EPSILON) {
+            row_i[i] = std::sqrt(pivot);
+        } else {
+            row_i[i] = 0.0;
+            factor_exact_ = false;
+        }
+    }
+
+    ++factorizations_;
+    factorization_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!factor_exact_) {
+        LOG_WARN("MonteCarloVaREngine: correlation matrix ({} instruments) is not positive definite, "
+                 "non-positive pivots clamped to zero", n);
+    }
+}
+
+MonteCarloVaREngine::Result MonteCarloVaREngine::run(const Exposures& exposures, uint32_t horizon_days,
+                                                     double tail_probability, uint32_t num_paths) {
+    const size_t n = dimension_;
+    if (exposures.delta.size() != n || exposures.volatility.size() != n ||
+        (!exposures.gamma.empty() && exposures.gamma.size() != n) ||
+        (!exposures.drift.empty() && exposures.drift.size() != n)) {
+        throw std::invalid_argument("MonteCarloVaREngine: exposures do not match the correlation matrix");
+    }
+    if (!(tail_probability > 0.0 && tail_probability < 1.0) || num_paths == 0) {
+        throw std::invalid_argument("MonteCarloVaREngine: tail probability must be in (0, 1) with at least one path");
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    Job job;
+    job.num_paths = num_paths;
+    job.chunk_size = config_.paths_per_chunk;
+    job.num_chunks = (num_paths + job.chunk_size - 1) / job.chunk_size;
+    job.chunk_sums.assign(job.num_chunks, 0.0);
+    job.key0 = static_cast<uint32_t>(config_.seed);
+    job.key1 = static_cast<uint32_t>(config_.seed >> 32);
+    job.has_gamma = !exposures.gamma.empty();
+
+    // r = m + s y with m = mu h, s = sigma sqrt(h):
+    // delta r + gamma/2 r^2 = (delta m + gamma/2 m^2) + s (delta + gamma m) y + gamma/2 s^2 y^2
+    const double horizon = horizon_days;
+    const double sqrt_horizon = std::sqrt(horizon);
+    std::vector<double> linear(stride_ + 1, 0.0);
+    job.quadratic.assign(stride_ + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        double gamma = job.has_gamma ? exposures.gamma[i] : 0.0;
+        double m = exposures.drift.empty() ? 0.0 : exposures.drift[i] * horizon;
+        double s = exposures.volatility[i] * sqrt_horizon;
+        job.constant += exposures.delta[i] * m + 0.5 * gamma * m * m;
+        linear[i] = s * (exposures.delta[i] + gamma * m);
+        job.quadratic[i] = 0.5 * gamma * s * s;
+    }
+    if (job.has_gamma) {
+        job.linear = std::move(linear);
+    } else {
+        // a . (L e) = (L' a) . e
+        job.linear.assign(stride_, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            const double* row = &factor_[i * stride_];
+            for (size_t j = 0; j <= i; ++j) {
+                job.linear[j] += row[j] * linear[i];
+            }
+        }
+    }
+
+    const auto tail_size = static_cast<size_t>(std::ceil(tail_probability * num_paths));
+    const size_t capacity = std::clamp<size_t>(tail_size, 1, num_paths);
+    for (auto& tail : tails_) {
+        tail.worst.clear();
+        tail.worst.reserve(capacity);
+        tail.capacity = capacity;
+    }
+
+    std::latch done(static_cast<ptrdiff_t>(config_.num_threads));
+    for (size_t worker = 1; worker < config_.num_threads; ++worker) {
+        pool_->submit([this, &job, &done, worker]() {
+            run_worker(job, worker);
+            done.count_down();
+        });
+    }
+    run_worker(job, 0);
+    done.arrive_and_wait();
+
+    // The k smallest overall are among each worker's k smallest
+    std::vector<double> worst;
+    worst.reserve(capacity * tails_.size());
+    for (const auto& tail : tails_) {
+        worst.insert(worst.end(), tail.worst.begin(), tail.worst.end());
+    }
+    std::sort(worst.begin(), worst.end());
+    worst.resize(capacity);
+
+    Result result;
+    result.paths = num_paths;
+    result.var = -worst.back();
+    double tail_sum = 0.0;
+    for (double pnl : worst) {
+        tail_sum += pnl;
+    }
+    result.expected_shortfall = -tail_sum / static_cast<double>(capacity);
+    double total = 0.0;
+    for (double sum : job.chunk_sums) {
+        total += sum; // Chunk order, so the mean does not depend on scheduling
+    }
+    result.mean_pnl = total / num_paths;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void MonteCarloVaREngine::run_worker(Job& job, size_t worker) {
+    Tail& tail = tails_[worker];
+    for (;;) {
+        uint32_t chunk = job.next_chunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job.num_chunks) {
+            return;
+        }
+        uint32_t first = chunk * job.chunk_size;
+        uint32_t last = std::min(first + job.chunk_size, job.num_paths);
+        double sum = 0.0;
+        if (job.has_gamma) {
+            simulate_quadratic(job, first, last, tail, sum);
+        } else {
+            simulate_linear(job, first, last, tail, sum);
+        }
+        job.chunk_sums[chunk] = sum;
+    }
+}
+
+// One dot product per path, fused with generating its normals block by block
+void MonteCarloVaREngine::simulate_linear(Job& job, uint32_t first, uint32_t last, Tail& tail, double& sum) const {
+    alignas(32) double normals[NORMALS_PER_BLOCK];
+    const uint32_t blocks = static_cast<uint32_t>(stride_ / NORMALS_PER_BLOCK);
+    const double* weights = job.linear.data();
+    for (uint32_t path = first; path < last; ++path) {
+        double pnl = job.constant;
+#ifdef __AVX2__
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        for (uint32_t block = 0; block < blocks; ++block) {
+            normal_block(job.key0, job.key1, path, block, normals);
+            const double* w = weights + block * NORMALS_PER_BLOCK;
+            for (size_t k = 0; k < NORMALS_PER_BLOCK; k += 8) {
+                acc0 = utils::vmath::fmadd(_mm256_loadu_pd(w + k), _mm256_load_pd(normals + k), acc0);
+                acc1 = utils::vmath::fmadd(_mm256_loadu_pd(w + k + 4), _mm256_load_pd(normals + k + 4), acc1);
+            }
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+        pnl += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+        for (uint32_t block = 0; block < blocks; ++block) {
+            normal_block(job.key0, job.key1, path, block, normals);
+            pnl += dot(weights + block * NORMALS_PER_BLOCK, normals, NORMALS_PER_BLOCK);
+        }
+#endif
+        tail.push(pnl);
+        sum += pnl;
+    }
+}
+
+// Four paths at a time: y = L e for all four, two rows of L per pass so each
+// load of L feeds four paths and each load of e feeds two rows.
+void MonteCarloVaREngine::simulate_quadratic(Job& job, uint32_t first, uint32_t last, Tail& tail,
+                                             double& sum) const {
+    constexpr uint32_t PATHS = 4;
+    const size_t n = dimension_;
+    std::vector<double> buffer(PATHS * stride_);
+    double* normals = buffer.data();
+    const double* linear = job.linear.data();
+    const double* quadratic = job.quadratic.data();
+
+    for (uint32_t path = first; path < last; path += PATHS) {
+        for (uint32_t p = 0; p < PATHS; ++p) {
+            for (uint32_t block = 0; block < stride_ / NORMALS_PER_BLOCK; ++block) {
+                normal_block(job.key0, job.key1, path + p, block, normals + p * stride_ + block * NORMALS_PER_BLOCK);
+            }
+        }
+        double pnl[PATHS];
+#ifdef __AVX2__
+        __m256d total = _mm256_set1_pd(job.constant); // Lane p: path + p
+        for (size_t i = 0; i < n; i += 2) {
+            const double* row0 = &factor_[i * stride_];
+            const double* row1 = row0 + stride_;
+            __m256d acc[2][PATHS];
+            for (auto& row : acc) {
+                for (auto& a : row) {
+                    a = _mm256_setzero_pd();
+                }
+            }
+            const size_t end = round_up(i + 2, 4);
+            for (size_t k = 0; k < end; k += 4) {
+                __m256d l0 = _mm256_loadu_pd(row0 + k);
+                __m256d l1 = _mm256_loadu_pd(row1 + k);
+                for (uint32_t p = 0; p < PATHS; ++p) {
+                    __m256d e = _mm256_loadu_pd(normals + p * stride_ + k);
+                    acc[0][p] = utils::vmath::fmadd(l0, e, acc[0][p]);
+                    acc[1][p] = utils::vmath::fmadd(l1, e, acc[1][p]);
+                }
+            }
+            for (size_t r = 0; r < 2; ++r) {
+                __m256d low = _mm256_hadd_pd(acc[r][0], acc[r][1]);
+                __m256d high = _mm256_hadd_pd(acc[r][2], acc[r][3]);
+                __m256d y = _mm256_add_pd(_mm256_permute2f128_pd(low, high, 0x20),
+                                          _mm256_permute2f128_pd(low, high, 0x31));
+                __m256d term = utils::vmath::fmadd(_mm256_set1_pd(quadratic[i + r]), y, _mm256_set1_pd(linear[i + r]));
+                total = utils::vmath::fmadd(term, y, total);
+            }
+        }
+        _mm256_storeu_pd(pnl, total);
+#else
+        for (uint32_t p = 0; p < PATHS; ++p) {
+            pnl[p] = job.constant;
+            for (size_t i = 0; i < n; ++i) {
+                double y = dot(&factor_[i * stride_], normals + p * stride_, round_up(i + 1, 4));
+                pnl[p] += (linear[i] + quadratic[i] * y) * y;
+            }
+        }
+#endif
+        for (uint32_t p = 0; p < PATHS && path + p < last; ++p) {
+            tail.push(pnl[p]);
+            sum += pnl[p];
+        }
+    }
+}
+
+} // namespace goldearn::risk
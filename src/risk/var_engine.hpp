@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../core/thread_pool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace goldearn::risk {
+
+// Standard normals for one Monte Carlo path: normal k of path p comes from
+// Philox counter (k / 32 * 8 + k % 8, p) under the seed, so every path is
+// reproducible on its own regardless of which thread draws it. `count` is a
+// multiple of NORMALS_PER_BLOCK.
+constexpr size_t NORMALS_PER_BLOCK = 32;
+void generate_normals(uint64_t seed, uint32_t path, size_t count, double* out);
+
+// Dense Monte Carlo VaR over n correlated instruments.
+//
+// Returns per instrument are r = mu*h + sigma*sqrt(h)*(L*e) with L the
+// Cholesky factor of the correlation matrix, and P&L = delta*r + gamma/2*r^2.
+// The factor is cached and only recomputed when set_correlation() is given
+// a different matrix. A purely linear book collapses to one dot product per
+// path (projection L'a), so 2000 instruments x 100k paths is mostly normal
+// generation; with gamma every path needs the full triangular L*e.
+//
+// Paths are split into fixed chunks handed out to the workers, each keeping
+// only its k worst P&Ls (k = tail * paths) in a bounded heap. Results depend
+// on the seed alone, not on the thread count or scheduling.
+class MonteCarloVaREngine {
+public:
+    struct Config {
+        size_t num_threads = 1;       // Including the calling thread
+        std::vector<int> cores;       // Worker affinity; empty = none
+        uint64_t seed = 0x5EEDC0FFEEULL;
+        uint32_t paths_per_chunk = 1024;
+    };
+
+    struct Exposures {
+        std::vector<double> delta;      // Currency P&L per unit return
+        std::vector<double> gamma;      // Currency P&L per unit return squared; empty = linear
+        std::vector<double> drift;      // Expected daily return; empty = zero
+        std::vector<double> volatility; // Daily return volatility
+    };
+
+    struct Result {
+        double var = 0.0;                // Loss at the tail quantile, positive
+        double expected_shortfall = 0.0; // Mean loss beyond it
+        double mean_pnl = 0.0;
+        uint32_t paths = 0;
+        double elapsed_ms = 0.0;
+    };
+
+    explicit MonteCarloVaREngine(const Config& config);
+    ~MonteCarloVaREngine();
+
+    MonteCarloVaREngine(const MonteCarloVaREngine&) = delete;
+    MonteCarloVaREngine& operator=(const MonteCarloVaREngine&) = delete;
+
+    // Row-major n x n correlation matrix. Returns false if it was not
+    // positive definite: non-positive pivots are clamped to zero, which
+    // drops the dependent directions, and factor_is_exact() turns false.
+    bool set_correlation(const double* matrix, size_t n);
+    size_t dimension() const { return dimension_; }
+    bool factor_is_exact() const { return factor_exact_; }
+    uint64_t factorizations() const { return factorizations_; }
+    double last_factorization_ms() const { return factorization_ms_; }
+    // Row i of L, dimension() entries
+    const double* factor_row(size_t i) const { return &factor_[i * stride_]; }
+
+    // Throws std::invalid_argument when the exposures do not match dimension()
+    Result run(const Exposures& exposures, uint32_t horizon_days, double tail_probability, uint32_t num_paths);
+
+    size_t num_threads() const { return config_.num_threads; }
+
+private:
+    // Paths with the smallest P&L seen by one worker, as a max-heap
+    struct alignas(64) Tail {
+        std::vector<double> worst;
+        size_t capacity = 0;
+        void push(double pnl);
+    };
+
+    struct Job;
+
+    Config config_;
+    std::unique_ptr<core::WorkStealingPool> pool_;
+
+    size_t dimension_ = 0;
+    size_t stride_ = 0;                 // Row length of factor_, a multiple of NORMALS_PER_BLOCK
+    std::vector<double> correlation_;   // Matrix the factor was computed from
+    std::vector<double> factor_;        // Lower triangular, zero padded
+    bool factor_exact_ = true;
+    uint64_t factorizations_ = 0;
+    double factorization_ms_ = 0.0;
+
+    std::vector<Tail> tails_;           // One per thread
+
+    void factorize();
+    void run_worker(Job& job, size_t worker);
+    void simulate_linear(Job& job, uint32_t first, uint32_t last, Tail& tail, double& sum) const;
+    void simulate_quadratic(Job& job, uint32_t first, uint32_t last, Tail& tail, double& sum) const;
+};
+
+} // namespace goldearn::risk
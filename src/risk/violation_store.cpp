@@ -0,0 +1,196 @@
+#include "violation_store.hpp"
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <stdexcept>
+
+namespace goldearn::risk {
+
+ViolationStore::ViolationStore() : ViolationStore(Config{}) {}
+
+ViolationStore::ViolationStore(const Config& config)
+    : config_(config)
+    , bucket_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(config.bucket_width).count()) {
+    if (config.capacity == 0 || config.max_buckets == 0 || bucket_ns_ <= 0) {
+        throw std::invalid_argument("ViolationStore: capacity, buckets and bucket width must be positive");
+    }
+    if (config.max_texts < 2 || config.max_texts > std::numeric_limits<uint16_t>::max() + 1u) {
+        throw std::invalid_argument("ViolationStore: text table must hold 2 to 65536 entries");
+    }
+    records_.resize(std::bit_ceil(config.capacity));
+    mask_ = records_.size() - 1;
+    buckets_.resize(config.max_buckets);
+    text_codes_.reserve(config.max_texts);
+    intern_locked("");
+    intern_locked("(violation text table full)");
+}
+
+uint16_t ViolationStore::intern(std::string_view text) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return intern_locked(text);
+}
+
+uint16_t ViolationStore::intern_locked(std::string_view text) {
+    auto it = text_codes_.find(text);
+    if (it != text_codes_.end()) {
+        return it->second;
+    }
+    if (texts_.size() >= config_.max_texts) {
+        return TEXT_OVERFLOW;
+    }
+    const auto code = static_cast<uint16_t>(texts_.size());
+    texts_.emplace_back(text);
+    text_codes_.emplace(texts_.back(), code);
+    stats_.texts = texts_.size();
+    return code;
+}
+
+std::string_view ViolationStore::text(uint16_t code) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return code < texts_.size() ? std::string_view(texts_[code]) : std::string_view();
+}
+
+void ViolationStore::record(RiskCheckResult type, ViolationSeverity severity, uint16_t reason, uint16_t strategy,
+                            uint64_t symbol_id, double current_value, double limit_value, int64_t timestamp_ns) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    const int64_t timestamp = std::max(timestamp_ns, last_timestamp_ns_);
+    last_timestamp_ns_ = timestamp;
+
+    if (head_ - tail_ == records_.size()) {
+        drop_oldest();
+        ++stats_.overwritten;
+    }
+    const int64_t id = timestamp / bucket_ns_;
+    if (bucket_head_ == bucket_tail_ || bucket(bucket_head_ - 1).id != id) {
+        if (bucket_head_ - bucket_tail_ == buckets_.size()) {
+            // Out of index slots: the oldest bucket's records go with it
+            const uint64_t end = bucket_tail_ + 1 < bucket_head_ ? bucket(bucket_tail_ + 1).first : head_;
+            while (tail_ < end) {
+                drop_oldest();
+                ++stats_.overwritten;
+            }
+        }
+        buckets_[bucket_head_ % buckets_.size()] = Bucket{id, head_};
+        ++bucket_head_;
+    }
+
+    const auto level = std::min<size_t>(static_cast<size_t>(severity), NUM_SEVERITIES - 1);
+    records_[head_ & mask_] = ViolationRecord{timestamp, symbol_id, current_value, limit_value, reason, strategy,
+                                              static_cast<uint8_t>(type), static_cast<uint8_t>(level)};
+    ++head_;
+    ++counts_[level];
+    ++stats_.recorded;
+}
+
+void ViolationStore::record(const RiskViolation& violation) {
+    uint16_t reason, strategy;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        reason = intern_locked(violation.description);
+        strategy = violation.strategy_id.empty() ? NO_TEXT : intern_locked(violation.strategy_id);
+    }
+    record(violation.violation_type, violation.severity, reason, strategy, violation.symbol_id,
+           violation.current_value, violation.limit_value, violation.timestamp.count());
+}
+
+void ViolationStore::drop_oldest() {
+    --counts_[at(tail_).severity];
+    ++tail_;
+    // Unindex buckets with nothing left in them
+    while (bucket_tail_ < bucket_head_ &&
+           (bucket_tail_ + 1 < bucket_head_ ? bucket(bucket_tail_ + 1).first <= tail_ : tail_ == head_)) {
+        ++bucket_tail_;
+    }
+}
+
+uint64_t ViolationStore::count(ViolationSeverity min_severity) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    uint64_t total = 0;
+    for (size_t level = static_cast<size_t>(min_severity); level < NUM_SEVERITIES; ++level) {
+        total += counts_[level];
+    }
+    return total;
+}
+
+void ViolationStore::for_each_since(int64_t since_ns, const std::function<void(const ViolationRecord&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (tail_ == head_) {
+        return;
+    }
+    // First bucket that can hold a match; every earlier one ends before since_ns
+    const int64_t since_id = since_ns >= 0 ? since_ns / bucket_ns_ : -1;
+    size_t low = bucket_tail_, high = bucket_head_;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (bucket(mid).id < since_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == bucket_head_) {
+        return;
+    }
+
+    // Then the first match inside it
+    uint64_t first = std::max(bucket(low).first, tail_);
+    uint64_t last = low + 1 < bucket_head_ ? bucket(low + 1).first : head_;
+    while (first < last) {
+        const uint64_t mid = first + (last - first) / 2;
+        if (at(mid).timestamp_ns < since_ns) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    for (uint64_t sequence = first; sequence < head_; ++sequence) {
+        visit(at(sequence));
+    }
+}
+
+std::vector<RiskViolation> ViolationStore::since(int64_t since_ns) const {
+    std::vector<ViolationRecord> records;
+    for_each_since(since_ns, [&records](const ViolationRecord& record) { records.push_back(record); });
+    std::vector<RiskViolation> violations;
+    violations.reserve(records.size());
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& record : records) {
+        violations.push_back(to_violation(record));
+    }
+    return violations;
+}
+
+RiskViolation ViolationStore::to_violation(const ViolationRecord& record) const {
+    RiskViolation violation(record.check_result(), record.violation_severity(), texts_[record.reason]);
+    violation.strategy_id = texts_[record.strategy];
+    violation.symbol_id = record.symbol_id;
+    violation.current_value = record.current_value;
+    violation.limit_value = record.limit_value;
+    violation.timestamp = market_data::Timestamp(record.timestamp_ns);
+    return violation;
+}
+
+void ViolationStore::expire_before(int64_t cutoff_ns) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    while (tail_ < head_ && at(tail_).timestamp_ns < cutoff_ns) {
+        drop_oldest();
+        ++stats_.expired;
+    }
+}
+
+size_t ViolationStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return head_ - tail_;
+}
+
+int64_t ViolationStore::last_timestamp_ns() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return head_ == 0 ? 0 : last_timestamp_ns_;
+}
+
+ViolationStore::Stats ViolationStore::get_stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace goldearn::risk
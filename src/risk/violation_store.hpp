@@ -0,0 +1,126 @@
+#pragma once
+
+#include "risk_engine.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace goldearn::risk {
+
+// One recorded violation, 40 bytes; strings are interned codes
+struct ViolationRecord {
+    int64_t timestamp_ns;
+    uint64_t symbol_id;
+    double current_value;
+    double limit_value;
+    uint16_t reason;   // ViolationStore::text()
+    uint16_t strategy; // ViolationStore::text(); NO_TEXT when none
+    uint8_t type;      // RiskCheckResult
+    uint8_t severity;  // ViolationSeverity
+
+    RiskCheckResult check_result() const { return static_cast<RiskCheckResult>(type); }
+    ViolationSeverity violation_severity() const { return static_cast<ViolationSeverity>(severity); }
+};
+
+// Fixed-capacity, time-indexed store of risk violations.
+//
+// Records go into a ring in arrival order (timestamps are clamped to be
+// non-decreasing), overwriting the oldest once it is full. A second ring
+// indexes fixed time buckets by the sequence of their first record, so a
+// window query is a binary search over buckets, another inside the first
+// bucket, then a walk over the k matches. Counts of retained records per
+// severity are kept as they go in and out, so counting is O(1).
+//
+// Descriptions and strategy ids are interned once into a bounded table;
+// recording with codes that are already interned never allocates.
+class ViolationStore {
+public:
+    static constexpr uint16_t NO_TEXT = 0;
+    static constexpr uint16_t TEXT_OVERFLOW = 1; // Table full; the text was dropped
+    static constexpr size_t NUM_SEVERITIES = 4;
+
+    struct Config {
+        size_t capacity = 65536;                       // Records, rounded up to a power of two
+        std::chrono::milliseconds bucket_width{60000}; // Time index granularity
+        size_t max_buckets = 2048;                     // 34 hours of one-minute buckets
+        size_t max_texts = 4096;
+    };
+
+    struct Stats {
+        uint64_t recorded = 0;
+        uint64_t overwritten = 0; // Dropped by the ring before they expired
+        uint64_t expired = 0;
+        size_t texts = 0;
+    };
+
+    ViolationStore();
+    explicit ViolationStore(const Config& config);
+
+    ViolationStore(const ViolationStore&) = delete;
+    ViolationStore& operator=(const ViolationStore&) = delete;
+
+    // Code for `text`; allocates only the first time a text is seen
+    uint16_t intern(std::string_view text);
+    std::string_view text(uint16_t code) const;
+
+    void record(RiskCheckResult type, ViolationSeverity severity, uint16_t reason, uint16_t strategy,
+                uint64_t symbol_id, double current_value, double limit_value, int64_t timestamp_ns);
+    // Interns the strings; no allocation once they are known
+    void record(const RiskViolation& violation);
+
+    // Retained records of at least `min_severity`, O(1)
+    uint64_t count(ViolationSeverity min_severity) const;
+    // Records at or after `since_ns`, oldest first: O(log n + k)
+    void for_each_since(int64_t since_ns, const std::function<void(const ViolationRecord&)>& visit) const;
+    std::vector<RiskViolation> since(int64_t since_ns) const;
+
+    // Drops records older than `cutoff_ns`; amortized O(1) per record dropped
+    void expire_before(int64_t cutoff_ns);
+
+    size_t size() const;
+    size_t capacity() const { return records_.size(); }
+    int64_t last_timestamp_ns() const;
+    Stats get_stats() const;
+
+private:
+    struct Bucket {
+        int64_t id;          // timestamp / bucket width
+        uint64_t first;      // Sequence of its first record
+    };
+
+    Config config_;
+    int64_t bucket_ns_;
+    uint64_t mask_;
+
+    mutable std::shared_mutex mutex_;
+    std::vector<ViolationRecord> records_;
+    uint64_t head_ = 0;               // Next sequence
+    uint64_t tail_ = 0;               // Oldest retained
+    int64_t last_timestamp_ns_ = std::numeric_limits<int64_t>::min();
+
+    std::vector<Bucket> buckets_;     // Ring of max_buckets
+    size_t bucket_head_ = 0;          // Buckets ever opened
+    size_t bucket_tail_ = 0;          // Oldest still indexed
+    std::array<uint64_t, NUM_SEVERITIES> counts_{};
+
+    std::deque<std::string> texts_;   // Stable addresses, so the map can key on views of them
+    std::unordered_map<std::string_view, uint16_t> text_codes_;
+    Stats stats_;
+
+    const ViolationRecord& at(uint64_t sequence) const { return records_[sequence & mask_]; }
+    const Bucket& bucket(size_t index) const { return buckets_[index % buckets_.size()]; }
+    // Under mutex_
+    void drop_oldest();
+    uint16_t intern_locked(std::string_view text);
+    RiskViolation to_violation(const ViolationRecord& record) const;
+};
+
+} // namespace goldearn::risk
@@ -0,0 +1,277 @@
+#include "kill_switch.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace goldearn::trading {
+
+namespace {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Submissions the calling thread has open. A trip from inside one (a risk
+// check on the gateway thread tripping the breaker) must not wait on itself.
+thread_local uint32_t tl_open_submits = 0;
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+void KillSwitch::SpinLock::lock() {
+    while (locked.exchange(true, std::memory_order_acquire)) {
+        while (locked.load(std::memory_order_relaxed)) {
+            cpu_relax();
+        }
+    }
+}
+
+KillSwitch::KillSwitch() : KillSwitch(Config{}) {}
+
+KillSwitch::KillSwitch(const Config& config) : config_(config) {
+    if (config_.max_live_orders == 0 || config_.max_live_orders >= std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("KillSwitch: max_live_orders out of range");
+    }
+    if (config_.burst_bytes < sizeof(CancelMessage)) {
+        throw std::invalid_argument("KillSwitch: burst_bytes below one cancel");
+    }
+    config_.burst_bytes -= config_.burst_bytes % sizeof(CancelMessage);
+
+    nodes_ = std::make_unique<Node[]>(config_.max_live_orders);
+    node_count_ = config_.max_live_orders;
+    free_.reserve(config_.max_live_orders);
+    for (size_t i = config_.max_live_orders; i > 0; --i) {
+        free_.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+KillSwitch::~KillSwitch() = default;
+
+uint32_t KillSwitch::add_venue(Venue venue) {
+    if (venue.name.empty() || !venue.write) {
+        throw std::invalid_argument("KillSwitch: venue needs a name and a write()");
+    }
+    if (venue_index(venue.name) != INVALID_VENUE) {
+        throw std::invalid_argument("KillSwitch: duplicate venue " + venue.name);
+    }
+    auto state = std::make_unique<VenueState>();
+    state->venue = std::move(venue);
+    state->cancels.resize(config_.max_live_orders);
+    state->owners.resize(config_.max_live_orders);
+    venues_.push_back(std::move(state));
+    LOG_INFO("KillSwitch: venue {} added ({})", venues_.back()->venue.name,
+             venues_.back()->venue.mass_cancel ? "mass cancel" : "per-order cancels");
+    return static_cast<uint32_t>(venues_.size() - 1);
+}
+
+uint32_t KillSwitch::venue_index(const std::string& name) const {
+    for (size_t i = 0; i < venues_.size(); ++i) {
+        if (venues_[i]->venue.name == name) return static_cast<uint32_t>(i);
+    }
+    return INVALID_VENUE;
+}
+
+bool KillSwitch::begin_submit() {
+    const uint32_t state = gateway_.fetch_add(1, std::memory_order_acq_rel);
+    if (state & BLOCKED) {
+        gateway_.fetch_sub(1, std::memory_order_release);
+        rejected_submissions_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ++tl_open_submits;
+    return true;
+}
+
+void KillSwitch::end_submit() {
+    --tl_open_submits;
+    gateway_.fetch_sub(1, std::memory_order_release);
+}
+
+KillSwitch::Handle KillSwitch::on_order_live(uint32_t venue, const Order& order) {
+    if (venue >= venues_.size()) return INVALID_HANDLE;
+
+    free_lock_.lock();
+    if (free_.empty()) {
+        free_lock_.unlock();
+        pool_exhausted_.fetch_add(1, std::memory_order_relaxed);
+        return INVALID_HANDLE;
+    }
+    const uint32_t slot = free_.back();
+    free_.pop_back();
+    free_lock_.unlock();
+
+    CancelMessage message{};
+    message.length = sizeof(CancelMessage);
+    message.message_type = CancelMessage::TYPE;
+    message.side = static_cast<uint8_t>(order.side);
+    message.client_order_id = order.client_order_id;
+    message.symbol_id = order.symbol_id;
+
+    VenueState& state = *venues_[venue];
+    state.lock.lock();
+    const size_t position = state.live++;
+    state.cancels[position] = message;
+    state.owners[position] = slot;
+    Node& node = nodes_[slot];
+    node.position = static_cast<uint32_t>(position);
+    node.venue.store(venue, std::memory_order_release);
+    const Handle handle = static_cast<Handle>(node.generation) << 32 | slot;
+    state.lock.unlock();
+    return handle;
+}
+
+KillSwitch::VenueState* KillSwitch::lock_live(Handle handle) const {
+    const uint64_t slot = handle & 0xffffffffu;
+    if (slot >= node_count_) return nullptr;
+    const Node& node = nodes_[slot];
+    const uint32_t venue = node.venue.load(std::memory_order_acquire);
+    if (venue == INVALID_VENUE) return nullptr;
+
+    // The order may have completed, and the slot gone to another order on
+    // another venue, between the read above and taking the lock
+    VenueState& state = *venues_[venue];
+    state.lock.lock();
+    if (node.venue.load(std::memory_order_relaxed) != venue || node.generation != handle >> 32) {
+        state.lock.unlock();
+        return nullptr;
+    }
+    return &state;
+}
+
+void KillSwitch::on_order_acknowledged(Handle handle, uint64_t venue_order_id) {
+    VenueState* state = lock_live(handle);
+    if (!state) return;
+    state->cancels[nodes_[handle & 0xffffffffu].position].venue_order_id = venue_order_id;
+    state->lock.unlock();
+}
+
+bool KillSwitch::on_order_done(Handle handle) {
+    VenueState* state = lock_live(handle);
+    if (!state) return false;
+    const uint32_t slot = static_cast<uint32_t>(handle & 0xffffffffu);
+    Node& node = nodes_[slot];
+
+    // The last entry moves into the hole
+    const size_t last = --state->live;
+    if (node.position != last) {
+        state->cancels[node.position] = state->cancels[last];
+        state->owners[node.position] = state->owners[last];
+        nodes_[state->owners[last]].position = node.position;
+    }
+    ++node.generation;
+    node.venue.store(INVALID_VENUE, std::memory_order_release);
+    state->lock.unlock();
+
+    free_lock_.lock();
+    free_.push_back(slot);
+    free_lock_.unlock();
+    return true;
+}
+
+size_t KillSwitch::live_orders(uint32_t venue) const {
+    if (venue >= venues_.size()) return 0;
+    const VenueState& state = *venues_[venue];
+    state.lock.lock();
+    const size_t live = state.live;
+    state.lock.unlock();
+    return live;
+}
+
+const CancelMessage* KillSwitch::cancel_message(Handle handle) const {
+    VenueState* state = lock_live(handle);
+    if (!state) return nullptr;
+    const CancelMessage* message = &state->cancels[nodes_[handle & 0xffffffffu].position];
+    state->lock.unlock();
+    return message;
+}
+
+size_t KillSwitch::burst_cancels(VenueState& state, TripResult& result) const {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(state.cancels.data());
+    const size_t total = state.live * sizeof(CancelMessage);
+    size_t sent = 0;
+    while (sent < total) {
+        const size_t length = std::min(config_.burst_bytes, total - sent);
+        const size_t written = state.venue.write(data + sent, length);
+        ++result.writes;
+        sent += written - written % sizeof(CancelMessage);
+        if (written != length) {
+            ++result.failed_venues;
+            break;
+        }
+    }
+    return sent / sizeof(CancelMessage);
+}
+
+KillSwitch::TripResult KillSwitch::trip(const std::string& reason) {
+    const uint64_t start = now_ns();
+    TripResult result;
+
+    trip_lock_.lock();
+    // Close the gateway, then let submissions already past it register
+    gateway_.fetch_or(BLOCKED, std::memory_order_acq_rel);
+    while ((gateway_.load(std::memory_order_acquire) & ~BLOCKED) > tl_open_submits) {
+        cpu_relax();
+    }
+
+    for (auto& venue : venues_) {
+        VenueState& state = *venue;
+        state.lock.lock();
+        ++result.venues;
+        if (config_.use_mass_cancel && state.venue.mass_cancel && state.venue.mass_cancel()) {
+            ++result.mass_cancels;
+        } else if (state.live > 0) {
+            result.cancels_sent += burst_cancels(state, result);
+        }
+        state.lock.unlock();
+    }
+    result.trigger_to_last_cancel_ns = now_ns() - start;
+
+    trips_.fetch_add(1, std::memory_order_relaxed);
+    cancels_sent_.fetch_add(result.cancels_sent, std::memory_order_relaxed);
+    last_trip_ns_.store(result.trigger_to_last_cancel_ns, std::memory_order_relaxed);
+    if (result.trigger_to_last_cancel_ns > max_trip_ns_.load(std::memory_order_relaxed)) {
+        max_trip_ns_.store(result.trigger_to_last_cancel_ns, std::memory_order_relaxed);
+    }
+    trip_lock_.unlock();
+
+    LOG_ERROR("KillSwitch: tripped ({}): {} venues, {} mass cancels, {} cancels in {} writes, {} failed, {}ns",
+              reason, result.venues, result.mass_cancels, result.cancels_sent, result.writes,
+              result.failed_venues, result.trigger_to_last_cancel_ns);
+    return result;
+}
+
+void KillSwitch::reset() {
+    gateway_.fetch_and(~BLOCKED, std::memory_order_acq_rel);
+    LOG_INFO("KillSwitch: gateway reopened");
+}
+
+KillSwitch::Stats KillSwitch::get_stats() const {
+    Stats stats;
+    for (const auto& venue : venues_) {
+        venue->lock.lock();
+        stats.live_orders += venue->live;
+        venue->lock.unlock();
+    }
+    stats.capacity = node_count_;
+    stats.blocked = is_blocked();
+    stats.trips = trips_.load(std::memory_order_relaxed);
+    stats.rejected_submissions = rejected_submissions_.load(std::memory_order_relaxed);
+    stats.pool_exhausted = pool_exhausted_.load(std::memory_order_relaxed);
+    stats.cancels_sent = cancels_sent_.load(std::memory_order_relaxed);
+    stats.last_trigger_to_last_cancel_ns = last_trip_ns_.load(std::memory_order_relaxed);
+    stats.max_trigger_to_last_cancel_ns = max_trip_ns_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace goldearn::trading
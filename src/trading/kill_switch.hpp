@@ -0,0 +1,184 @@
+#pragma once
+
+#include "trading_engine.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace goldearn::trading {
+
+// One order's cancel as it goes on the wire. Encoded when the order goes
+// live and patched with the venue's id on the acknowledgement, so a burst is
+// written as it sits; the session adds its own framing and sequence numbers.
+struct CancelMessage {
+    static constexpr uint16_t TYPE = 0x4358; // "CX"
+
+    uint16_t length;
+    uint16_t message_type;
+    uint8_t side;
+    uint8_t reserved[3];
+    uint64_t client_order_id;
+    uint64_t venue_order_id;     // 0 until acknowledged
+    uint64_t symbol_id;
+};
+static_assert(sizeof(CancelMessage) == 32, "cancels are packed two per cache line");
+
+// Kill switch: pulls every live order off every venue as fast as the
+// sessions can write.
+//
+// Each venue keeps its live orders' pre-encoded cancels packed in one
+// array, preallocated for the whole pool; an order that completes is swapped
+// out with the last one, and its handle maps to its position. trip() closes
+// the gateway, waits out submissions already past it, then per venue sends
+// a single mass cancel where the venue supports one, or hands the array to
+// the session straight from memory in writes of up to burst_bytes. Nothing
+// on the way allocates, copies, chases pointers, looks up an order or takes
+// the order manager's locks.
+//
+// The gateway is one atomic word: a blocked bit and a count of submissions
+// in flight. Every submission is bracketed by begin_submit()/end_submit()
+// and registers its order before end_submit(), so once trip() has seen the
+// count drain no order can reach a venue without being in its array.
+//
+// A handle is a node slot plus the slot's generation, which moves on each
+// time the order is done; a handle that outlived its order (an ack racing
+// the fill that completed it) is recognised under the venue's lock and
+// ignored rather than landing on whichever order reuses the slot.
+//
+// Thread-safe. Venues are added at start-up, before orders flow.
+class KillSwitch {
+public:
+    using Handle = uint64_t;             // Generation << 32 | slot
+    static constexpr Handle INVALID_HANDLE = std::numeric_limits<Handle>::max();
+    static constexpr uint32_t INVALID_VENUE = std::numeric_limits<uint32_t>::max();
+
+    // A venue's order-entry session. write() sends a buffer of messages in
+    // one call and returns the bytes it accepted. mass_cancel, where the
+    // venue has one, cancels everything the session has open and returns
+    // false if it could not be sent.
+    struct Venue {
+        std::string name;
+        std::function<size_t(const uint8_t* data, size_t length)> write;
+        std::function<bool()> mass_cancel;
+    };
+
+    struct Config {
+        size_t max_live_orders = 65536;  // Across venues
+        size_t burst_bytes = 64 * 1024;  // Per write
+        bool use_mass_cancel = true;     // Where the venue supports it
+    };
+
+    struct TripResult {
+        size_t venues = 0;
+        size_t mass_cancels = 0;
+        size_t cancels_sent = 0;
+        size_t writes = 0;
+        size_t failed_venues = 0;        // Sessions that took less than a full write
+        uint64_t trigger_to_last_cancel_ns = 0;
+    };
+
+    struct Stats {
+        size_t live_orders = 0;
+        size_t capacity = 0;
+        bool blocked = false;
+        uint64_t trips = 0;
+        uint64_t rejected_submissions = 0;
+        uint64_t pool_exhausted = 0;     // Orders that went live untracked
+        uint64_t cancels_sent = 0;
+        uint64_t last_trigger_to_last_cancel_ns = 0;
+        uint64_t max_trigger_to_last_cancel_ns = 0;
+    };
+
+    KillSwitch();
+    explicit KillSwitch(const Config& config);
+    ~KillSwitch();
+
+    KillSwitch(const KillSwitch&) = delete;
+    KillSwitch& operator=(const KillSwitch&) = delete;
+
+    // Throws std::invalid_argument without a name or write(), or on a
+    // duplicate name. Returns the venue's index.
+    uint32_t add_venue(Venue venue);
+    uint32_t venue_index(const std::string& name) const;
+
+    // Gateway: false once tripped, and the order must not be sent
+    bool begin_submit();
+    void end_submit();
+    bool is_blocked() const { return (gateway_.load(std::memory_order_acquire) & BLOCKED) != 0; }
+
+    // Live orders. on_order_live returns INVALID_HANDLE (and counts it) when
+    // the pool is full; the handle is what the order manager keeps with the
+    // order. on_order_done is false for a handle that is not live, and
+    // neither call touches another order that has since reused its slot.
+    Handle on_order_live(uint32_t venue, const Order& order);
+    void on_order_acknowledged(Handle handle, uint64_t venue_order_id);
+    bool on_order_done(Handle handle);
+    size_t live_orders(uint32_t venue) const;
+    const CancelMessage* cancel_message(Handle handle) const;
+
+    // Blocks the gateway and cancels everything live; the orders stay
+    // tracked until their cancel acknowledgements come through on_order_done.
+    // A second trip sends the cancels again.
+    TripResult trip(const std::string& reason);
+    // Reopens the gateway
+    void reset();
+
+    Stats get_stats() const;
+
+private:
+    static constexpr uint32_t BLOCKED = 1u << 31;
+
+    // venue is read before its lock is taken and checked again under it;
+    // position and generation only change under the venue's lock
+    struct Node {
+        std::atomic<uint32_t> venue{INVALID_VENUE}; // INVALID_VENUE while free
+        uint32_t position = 0;           // In the venue's arrays
+        uint32_t generation = 0;         // Moves on when the order is done
+    };
+
+    struct SpinLock {
+        std::atomic<bool> locked{false};
+        void lock();
+        void unlock() { locked.store(false, std::memory_order_release); }
+    };
+
+    struct VenueState {
+        Venue venue;
+        mutable SpinLock lock;
+        // The first live entries are in use; sized to the pool up front
+        std::vector<CancelMessage> cancels;
+        std::vector<uint32_t> owners;    // Slots
+        size_t live = 0;
+    };
+
+    Config config_;
+    alignas(64) std::atomic<uint32_t> gateway_{0};
+
+    std::unique_ptr<Node[]> nodes_;      // By slot
+    size_t node_count_ = 0;
+    SpinLock free_lock_;
+    std::vector<uint32_t> free_;         // Stack of free slots
+    std::vector<std::unique_ptr<VenueState>> venues_;
+
+    // Serializes trips
+    SpinLock trip_lock_;
+    std::atomic<uint64_t> trips_{0};
+    std::atomic<uint64_t> rejected_submissions_{0};
+    std::atomic<uint64_t> pool_exhausted_{0};
+    std::atomic<uint64_t> cancels_sent_{0};
+    std::atomic<uint64_t> last_trip_ns_{0};
+    std::atomic<uint64_t> max_trip_ns_{0};
+
+    // Under the venue's lock
+    size_t burst_cancels(VenueState& venue, TripResult& result) const;
+    // Locks and returns the venue the handle's order is live on, or nullptr
+    // (nothing locked) if the handle is not live
+    VenueState* lock_live(Handle handle) const;
+};
+
+} // namespace goldearn::trading
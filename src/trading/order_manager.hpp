@@ -1,65 +1,20 @@
 #pragma once
 
 #include "trading_engine.hpp"
+#include "kill_switch.hpp"
+#include "order_store.hpp"
 #include "../core/latency_tracker.hpp"
+#include "../core/thread_pool.hpp"
 #include <unordered_map>
 #include <queue>
 #include <memory>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <shared_mutex>
 
 namespace goldearn::trading {
 
-// Order state tracking
-enum class OrderState {
-    CREATED,          // Order object created but not submitted
-    PRE_TRADE_CHECK,  // Undergoing risk checks
-    PENDING_SUBMIT,   // Queued for submission
-    SUBMITTED,        // Sent to venue
-    ACKNOWLEDGED,     // Confirmed by venue
-    PARTIALLY_FILLED, // Partial execution
-    FILLED,          // Fully executed
-    PENDING_CANCEL,  // Cancel request sent
-    CANCELLED,       // Successfully cancelled
-    REJECTED,        // Rejected by venue or risk system
-    EXPIRED,         // Order expired
-    ERROR            // Error state
-};
-
-// Enhanced order structure with full lifecycle tracking
-struct ManagedOrder : public Order {
-    OrderState state;
-    std::string venue_name;
-    uint64_t venue_order_id;
-    std::vector<ExecutionReport> executions;
-    std::string rejection_reason;
-    market_data::Timestamp last_state_change;
-    uint32_t retry_count;
-    
-    // Performance metrics
-    market_data::Timestamp pre_trade_check_start;
-    market_data::Timestamp submission_start;
-    market_data::Timestamp acknowledgment_time;
-    market_data::Timestamp first_fill_time;
-    
-    // Risk attributes
-    double max_slippage_bps;
-    uint64_t max_execution_time_ms;
-    bool allow_partial_fills;
-    
-    ManagedOrder(const Order& base_order) : Order(base_order) {
-        state = OrderState::CREATED;
-        venue_order_id = 0;
-        retry_count = 0;
-        max_slippage_bps = 10.0; // Default 10 bps max slippage
-        max_execution_time_ms = 5000; // Default 5 second timeout
-        allow_partial_fills = true;
-        last_state_change = std::chrono::duration_cast<market_data::Timestamp>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()
-        );
-    }
-};
-
 // Order manager handles the complete order lifecycle
 class OrderManager {
 public:
@@ -91,6 +46,9 @@ public:
     void register_venue(std::shared_ptr<ExecutionVenue> venue);
     void unregister_venue(const std::string& venue_name);
     ExecutionVenue* get_venue(const std::string& venue_name);
+    // Submissions go through the kill switch's gateway, and orders are
+    // registered with it from submission until filled, cancelled or rejected
+    void set_kill_switch(std::shared_ptr<KillSwitch> kill_switch);
     
     // Risk integration
     void set_pre_trade_check_callback(std::function<bool(const ManagedOrder&)> callback);
@@ -126,15 +84,15 @@ public:
     void set_routing_strategy_for_symbol(uint64_t symbol_id, RoutingStrategy strategy);
     
 private:
-    // Order storage and indexing
-    std::unordered_map<uint64_t, std::unique_ptr<ManagedOrder>> orders_;
-    std::unordered_map<std::string, std::vector<uint64_t>> strategy_orders_;
-    std::unordered_map<uint64_t, std::vector<uint64_t>> symbol_orders_;
+    // Order storage and indexing, pooled so that steady-state submission
+    // and fills never reach malloc
+    OrderStore orders_;
     mutable std::shared_mutex orders_mutex_;
     
     // Venue management
     std::unordered_map<std::string, std::shared_ptr<ExecutionVenue>> venues_;
     std::shared_mutex venues_mutex_;
+    std::shared_ptr<KillSwitch> kill_switch_;
     
     // Order processing queues
     std::queue<uint64_t> pre_trade_check_queue_;
@@ -142,10 +100,10 @@ private:
     std::queue<uint64_t> cancel_queue_;
     std::queue<uint64_t> modify_queue_;
     
-    // Threading and async processing
-    std::vector<std::thread> worker_threads_;
+    // Async processing: queues are drained by a pinned spin thread
+    // ("order_gateway" in [runtime] critical_cores), never by sleeping workers
+    std::unique_ptr<core::SpinThread> order_gateway_thread_;
     std::atomic<bool> shutdown_requested_;
-    std::condition_variable queue_condition_;
     std::mutex queue_mutex_;
     
     // Callbacks
@@ -165,10 +123,12 @@ private:
     RoutingStrategy default_routing_strategy_;
     std::unordered_map<uint64_t, RoutingStrategy> symbol_routing_strategies_;
     
-    // Worker thread functions
-    void pre_trade_check_worker();
-    void order_submission_worker();
-    void order_management_worker();
+    // Spin thread poll function and the stages it drains; each returns true
+    // if it processed anything
+    bool poll_order_queues();
+    bool pre_trade_check_worker();
+    bool order_submission_worker();
+    bool order_management_worker();
     
     // Internal order processing
     bool process_pre_trade_checks(ManagedOrder& order);
@@ -192,10 +152,11 @@ private:
     bool validate_order_parameters(const Order& order) const;
     bool validate_modification_parameters(const ManagedOrder& order, double new_price, uint64_t new_quantity) const;
     
-    // Timeout and cleanup
+    // Timeout and cleanup (periodic tasks on the housekeeping pool)
     void monitor_order_timeouts();
     void cleanup_completed_orders();
-    std::thread timeout_monitor_thread_;
+    core::TaskId timeout_monitor_task_id_ = 0;
+    core::TaskId cleanup_task_id_ = 0;
     std::atomic<std::chrono::seconds> order_cleanup_interval_{std::chrono::seconds(300)}; // 5 minutes
 };
 
@@ -284,11 +245,11 @@ private:
     std::unordered_map<uint64_t, std::unique_ptr<ActiveExecution>> active_executions_;
     std::shared_mutex executions_mutex_;
     
-    // Execution worker threads
-    std::vector<std::thread> execution_workers_;
+    // One periodic housekeeping task per active execution, keyed by execution id
+    std::unordered_map<uint64_t, core::TaskId> execution_tasks_;
     std::atomic<bool> shutdown_requested_;
     
-    // Individual execution implementations
+    // Individual execution implementations, invoked once per slice
     void execute_twap_worker(uint64_t execution_id, const TWAPParams& params);
     void execute_vwap_worker(uint64_t execution_id, const VWAPParams& params);
     void execute_iceberg_worker(uint64_t execution_id, const IcebergParams& params);
@@ -0,0 +1,102 @@
+#include "order_store.hpp"
+
+namespace goldearn::trading {
+
+namespace {
+
+// Swap-remove `id` at `position`; returns the id moved into its place, or
+// `id` itself when it was last
+uint64_t erase_at(std::pmr::vector<uint64_t>& ids, uint32_t position) {
+    const uint64_t moved = ids.back();
+    ids[position] = moved;
+    ids.pop_back();
+    return moved;
+}
+
+} // namespace
+
+OrderStore::OrderStore(size_t initial_capacity) : pool_(initial_capacity) {
+    // Per order: an index node and the executions reserve. The bucket array
+    // is past the largest class and comes from upstream once; strategy and
+    // symbol lists grow their classes on demand.
+    memory_.reserve_nodes<decltype(orders_)>(initial_capacity);
+    memory_.reserve(EXECUTIONS_RESERVED * sizeof(ExecutionReport), initial_capacity);
+    orders_.reserve(initial_capacity);
+}
+
+ManagedOrder* OrderStore::add(const Order& order) {
+    auto [it, inserted] = orders_.try_emplace(order.order_id);
+    if (!inserted) {
+        return nullptr;
+    }
+    Entry& entry = it->second;
+    entry.order = pool_.make(order, &memory_);
+    entry.order->executions.reserve(EXECUTIONS_RESERVED);
+
+    auto strategy = strategy_orders_.find(order.strategy_id);
+    if (strategy == strategy_orders_.end()) {
+        strategy = strategy_orders_.try_emplace(order.strategy_id).first;
+    }
+    entry.strategy_position = static_cast<uint32_t>(strategy->second.size());
+    strategy->second.push_back(order.order_id);
+
+    auto& symbol = symbol_orders_[order.symbol_id];
+    entry.symbol_position = static_cast<uint32_t>(symbol.size());
+    symbol.push_back(order.order_id);
+    return entry.order.get();
+}
+
+ManagedOrder* OrderStore::find(uint64_t order_id) {
+    auto it = orders_.find(order_id);
+    return it != orders_.end() ? it->second.order.get() : nullptr;
+}
+
+const ManagedOrder* OrderStore::find(uint64_t order_id) const {
+    auto it = orders_.find(order_id);
+    return it != orders_.end() ? it->second.order.get() : nullptr;
+}
+
+bool OrderStore::add_execution(const ExecutionReport& execution) {
+    ManagedOrder* order = find(execution.order_id);
+    if (!order) {
+        return false;
+    }
+    order->executions.push_back(execution);
+    return true;
+}
+
+bool OrderStore::remove(uint64_t order_id) {
+    auto it = orders_.find(order_id);
+    if (it == orders_.end()) {
+        return false;
+    }
+    const Entry& entry = it->second;
+
+    // Emptied lists stay, so a strategy or symbol that trades again reuses
+    // their capacity
+    auto& strategy = strategy_orders_.find(entry.order->strategy_id)->second;
+    const uint64_t moved_in_strategy = erase_at(strategy, entry.strategy_position);
+    if (moved_in_strategy != order_id) {
+        orders_.find(moved_in_strategy)->second.strategy_position = entry.strategy_position;
+    }
+    auto& symbol = symbol_orders_.find(entry.order->symbol_id)->second;
+    const uint64_t moved_in_symbol = erase_at(symbol, entry.symbol_position);
+    if (moved_in_symbol != order_id) {
+        orders_.find(moved_in_symbol)->second.symbol_position = entry.symbol_position;
+    }
+
+    orders_.erase(it);
+    return true;
+}
+
+const std::pmr::vector<uint64_t>& OrderStore::strategy_orders(const std::string& strategy_id) const {
+    auto it = strategy_orders_.find(strategy_id);
+    return it != strategy_orders_.end() ? it->second : empty_;
+}
+
+const std::pmr::vector<uint64_t>& OrderStore::symbol_orders(uint64_t symbol_id) const {
+    auto it = symbol_orders_.find(symbol_id);
+    return it != symbol_orders_.end() ? it->second : empty_;
+}
+
+} // namespace goldearn::trading
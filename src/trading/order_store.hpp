@@ -0,0 +1,121 @@
+#pragma once
+
+#include "trading_engine.hpp"
+#include "kill_switch.hpp"
+#include "../core/memory_pool.hpp"
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+
+namespace goldearn::trading {
+
+// Order state tracking
+enum class OrderState {
+    CREATED,          // Order object created but not submitted
+    PRE_TRADE_CHECK,  // Undergoing risk checks
+    PENDING_SUBMIT,   // Queued for submission
+    SUBMITTED,        // Sent to venue
+    ACKNOWLEDGED,     // Confirmed by venue
+    PARTIALLY_FILLED, // Partial execution
+    FILLED,          // Fully executed
+    PENDING_CANCEL,  // Cancel request sent
+    CANCELLED,       // Successfully cancelled
+    REJECTED,        // Rejected by venue or risk system
+    EXPIRED,         // Order expired
+    ERROR            // Error state
+};
+
+// Enhanced order structure with full lifecycle tracking
+struct ManagedOrder : public Order {
+    OrderState state;
+    std::string venue_name;
+    uint64_t venue_order_id;
+    KillSwitch::Handle kill_switch_handle; // Live-order node while at the venue
+    std::pmr::vector<ExecutionReport> executions; // Backed by the order store's pool resource
+    std::string rejection_reason;
+    market_data::Timestamp last_state_change;
+    uint32_t retry_count;
+
+    // Performance metrics
+    market_data::Timestamp pre_trade_check_start;
+    market_data::Timestamp submission_start;
+    market_data::Timestamp acknowledgment_time;
+    market_data::Timestamp first_fill_time;
+
+    // Risk attributes
+    double max_slippage_bps;
+    uint64_t max_execution_time_ms;
+    bool allow_partial_fills;
+
+    ManagedOrder(const Order& base_order,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Order(base_order), executions(resource) {
+        state = OrderState::CREATED;
+        venue_order_id = 0;
+        kill_switch_handle = KillSwitch::INVALID_HANDLE;
+        retry_count = 0;
+        max_slippage_bps = 10.0; // Default 10 bps max slippage
+        max_execution_time_ms = 5000; // Default 5 second timeout
+        allow_partial_fills = true;
+        last_state_change = std::chrono::duration_cast<market_data::Timestamp>(
+            std::chrono::high_resolution_clock::now().time_since_epoch()
+        );
+    }
+};
+
+// OrderManager's order storage. ManagedOrder objects come from a fixed-size
+// pool; the id index, the per-strategy and per-symbol id lists and every
+// order's executions draw from a pooled pmr resource. Once the pools have
+// grown to the working set, adding, filling and retiring orders never
+// reaches malloc (strategy ids longer than the SSO buffer aside).
+// Not synchronized: the owner serializes access.
+class OrderStore {
+public:
+    static constexpr size_t EXECUTIONS_RESERVED = 4; // Per order, before a vector grows
+
+    explicit OrderStore(size_t initial_capacity = 65536);
+
+    OrderStore(const OrderStore&) = delete;
+    OrderStore& operator=(const OrderStore&) = delete;
+
+    // nullptr if an order with this order_id is already stored
+    ManagedOrder* add(const Order& order);
+    ManagedOrder* find(uint64_t order_id);
+    const ManagedOrder* find(uint64_t order_id) const;
+    // Appends to the order's executions; false for an unknown order
+    bool add_execution(const ExecutionReport& execution);
+    // Retires an order and returns its memory to the pools
+    bool remove(uint64_t order_id);
+
+    // Ids of stored orders; empty for an unknown strategy or symbol.
+    // Removal swaps the last id into the hole, so order is not kept.
+    const std::pmr::vector<uint64_t>& strategy_orders(const std::string& strategy_id) const;
+    const std::pmr::vector<uint64_t>& symbol_orders(uint64_t symbol_id) const;
+
+    size_t size() const { return orders_.size(); }
+    const core::PoolMemoryResource& memory() const { return memory_; }
+
+    template<typename Fn>
+    void for_each(Fn&& fn) {
+        for (auto& [id, entry] : orders_) fn(*entry.order);
+    }
+
+private:
+    // Where the order's id sits in its strategy and symbol lists
+    struct Entry {
+        core::PoolPtr<ManagedOrder> order;
+        uint32_t strategy_position;
+        uint32_t symbol_position;
+    };
+
+    // Declared before the containers that use them
+    core::ObjectPool<ManagedOrder> pool_;
+    core::PoolMemoryResource memory_;
+
+    std::pmr::unordered_map<uint64_t, Entry> orders_{&memory_};
+    std::pmr::unordered_map<std::string, std::pmr::vector<uint64_t>> strategy_orders_{&memory_};
+    std::pmr::unordered_map<uint64_t, std::pmr::vector<uint64_t>> symbol_orders_{&memory_};
+    const std::pmr::vector<uint64_t> empty_{&memory_};
+};
+
+} // namespace goldearn::trading
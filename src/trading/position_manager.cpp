@@ -0,0 +1,32 @@
+#include "position_manager.hpp"
+
+namespace goldearn::trading {
+
+// Only the position segment hooks live here so far; the rest of
+// PositionManager has no translation unit in this tree yet.
+
+void PositionManager::set_position_segment(std::shared_ptr<PositionSegment> segment) {
+    position_segment_ = std::move(segment);
+}
+
+void PositionManager::publish_position(Position& position, double market_price) {
+    if (!position_segment_) {
+        return;
+    }
+    if (position.segment_slot == position_layout::INVALID_SLOT) {
+        // Stays invalid while the segment is full; publish() ignores it
+        position.segment_slot = position_segment_->add_position(position.strategy_id, position.symbol_id);
+    }
+
+    position_layout::PositionValues values;
+    values.quantity = position.quantity;
+    values.avg_entry_price = position.avg_entry_price;
+    values.market_price = market_price;
+    values.realized_pnl = position.realized_pnl;
+    values.unrealized_pnl = position.unrealized_pnl;
+    values.exposure = position.quantity * market_price;
+    values.trades = position.total_trades;
+    position_segment_->publish(position.segment_slot, values);
+}
+
+} // namespace goldearn::trading
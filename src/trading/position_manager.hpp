@@ -1,54 +1,19 @@
 #pragma once
 
 #include "trading_engine.hpp"
+#include "position_segment.hpp"
+#include "position_store.hpp"
 #include "../market_data/message_types.hpp"
+#include "../market_data/market_statistics.hpp"
+#include "../risk/stress_engine.hpp"
 #include <unordered_map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
 
 namespace goldearn::trading {
 
-// Position information for a single symbol
-struct Position {
-    uint64_t symbol_id;
-    std::string strategy_id;
-    double quantity;           // Positive for long, negative for short
-    double avg_entry_price;    // Volume-weighted average entry price
-    double realized_pnl;       // Realized profit/loss from closed trades
-    double unrealized_pnl;     // Mark-to-market profit/loss
-    double total_pnl;          // Realized + unrealized
-    
-    // Risk metrics
-    double max_position_size;  // Maximum allowed position
-    double var_1d;            // 1-day Value at Risk
-    double exposure_value;     // Position value in base currency
-    
-    // Trade statistics
-    uint64_t total_trades;
-    uint64_t winning_trades;
-    double largest_win;
-    double largest_loss;
-    double avg_trade_pnl;
-    
-    // Timestamps
-    market_data::Timestamp first_trade_time;
-    market_data::Timestamp last_trade_time;
-    market_data::Timestamp last_update_time;
-    
-    Position() : symbol_id(0), quantity(0.0), avg_entry_price(0.0), 
-                 realized_pnl(0.0), unrealized_pnl(0.0), total_pnl(0.0),
-                 max_position_size(0.0), var_1d(0.0), exposure_value(0.0),
-                 total_trades(0), winning_trades(0), largest_win(0.0),
-                 largest_loss(0.0), avg_trade_pnl(0.0) {}
-    
-    bool is_long() const { return quantity > 0.0; }
-    bool is_short() const { return quantity < 0.0; }
-    bool is_flat() const { return std::abs(quantity) < 1e-8; }
-    double get_notional_value(double current_price) const { return std::abs(quantity) * current_price; }
-    double get_win_rate() const { return total_trades > 0 ? (double)winning_trades / total_trades : 0.0; }
-};
-
 // Aggregated portfolio position across all strategies
 struct PortfolioPosition {
     uint64_t symbol_id;
@@ -151,6 +116,11 @@ public:
     
     // Real-time position monitoring
     void set_position_change_callback(std::function<void(const Position&)> callback);
+    // Out-of-process monitoring: every fill and mark rewrites the position's
+    // record in the segment (a seqlock write and a journal entry, on the
+    // thread that already holds the position), and goldearn_risk_monitor
+    // reads them from there. Set before trading starts.
+    void set_position_segment(std::shared_ptr<PositionSegment> segment);
     void set_pnl_threshold_callback(double threshold, std::function<void(double)> callback);
     
     // Position reconciliation
@@ -158,8 +128,9 @@ public:
     std::vector<std::pair<std::string, uint64_t>> get_position_discrepancies() const;
     
 private:
-    // Position storage - nested maps: strategy_id -> symbol_id -> Position
-    std::unordered_map<std::string, std::unordered_map<uint64_t, std::unique_ptr<Position>>> positions_;
+    // Position storage: strategy_id -> symbol_id -> Position, pooled so that
+    // opening a new position on a fill does not malloc
+    PositionStore positions_;
     mutable std::shared_mutex positions_mutex_;
     
     // Market prices cache for P&L calculation
@@ -177,6 +148,7 @@ private:
     
     // Callbacks and monitoring
     std::function<void(const Position&)> position_change_callback_;
+    std::shared_ptr<PositionSegment> position_segment_;
     std::function<void(double)> pnl_threshold_callback_;
     double pnl_threshold_;
     
@@ -189,6 +161,8 @@ private:
     void update_position_pnl(Position& position, double market_price);
     void update_position_statistics(Position& position, const ExecutionReport& execution);
     void calculate_avg_entry_price(Position& position, double trade_price, double trade_quantity);
+    // Claims the record on the first call, then rewrites it
+    void publish_position(Position& position, double market_price);
     
     // P&L calculation helpers
     double calculate_unrealized_pnl(const Position& position, double market_price) const;
@@ -211,7 +185,8 @@ private:
 // Advanced position analytics
 class PositionAnalytics {
 public:
-    PositionAnalytics(const PositionManager* position_manager);
+    PositionAnalytics(const PositionManager* position_manager,
+                      std::shared_ptr<const market_data::MarketStatistics> statistics = nullptr);
     
     // Performance attribution
     struct AttributionReport {
@@ -254,24 +229,27 @@ public:
     // Stress testing
     struct StressScenario {
         std::string scenario_name;
-        std::unordered_map<uint64_t, double> price_shocks; // Symbol -> % change
+        std::unordered_map<uint64_t, double> price_shocks; // Symbol -> relative change (-0.1 = down 10%)
         double portfolio_pnl_impact;
         double worst_position_impact;
         std::vector<std::pair<uint64_t, double>> position_impacts;
     };
     
+    // Scenario grid; run_stress_tests() feeds it the portfolio exposures
+    // and evaluates it (incrementally when only positions moved)
+    void set_stress_engine(std::shared_ptr<risk::StressEngine> engine) { stress_engine_ = std::move(engine); }
     std::vector<StressScenario> run_stress_tests() const;
     
-    // Correlation analysis
-    std::unordered_map<std::pair<uint64_t, uint64_t>, double, 
-                      std::hash<std::pair<uint64_t, uint64_t>>> calculate_position_correlations() const;
+    // Correlation analysis: pairs of open positions, read from one statistics snapshot
+    market_data::CorrelationMap calculate_position_correlations() const;
     
 private:
     const PositionManager* position_manager_;
+    std::shared_ptr<const market_data::MarketStatistics> statistics_;
+    std::shared_ptr<risk::StressEngine> stress_engine_;
     
     // Helper methods for analytics
     std::vector<double> get_historical_returns(uint64_t symbol_id, uint32_t days) const;
-    double calculate_correlation(const std::vector<double>& returns1, const std::vector<double>& returns2) const;
     double calculate_volatility(const std::vector<double>& returns) const;
     double calculate_var(const std::vector<double>& returns, double confidence_level = 0.05) const;
 };
@@ -0,0 +1,350 @@
+#include "position_segment.hpp"
+#include "../utils/simple_logger.hpp"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace goldearn::trading {
+
+using namespace position_layout;
+
+namespace {
+
+constexpr uint64_t POSITION_MASK = (uint64_t{1} << (64 - SLOT_BITS)) - 1;
+// A writer that died mid-write leaves its record odd for good
+constexpr uint32_t MAX_READ_ATTEMPTS = 1u << 16;
+// A writer preempted mid-write (more threads than cores) is not helped by
+// spinning; after this many attempts the reader yields to it
+constexpr uint32_t SPIN_ATTEMPTS = 64;
+
+size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::string segment_path(const std::string& name) {
+    return name.find('/') != std::string::npos ? name : "/dev/shm/" + name;
+}
+
+int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t journal_entry(uint64_t position, uint32_t slot) {
+    return (((position + 1) & POSITION_MASK) << SLOT_BITS) | slot;
+}
+
+} // namespace
+
+PositionSegment::PositionSegment(const Config& config) : path_(segment_path(config.name)) {
+    if (config.capacity == 0 || config.capacity > MAX_RECORDS || config.journal_capacity == 0) {
+        throw std::invalid_argument("PositionSegment: capacity out of range");
+    }
+    capacity_ = config.capacity;
+    const uint64_t journal_capacity = std::bit_ceil(uint64_t{config.journal_capacity});
+    journal_mask_ = journal_capacity - 1;
+
+    const size_t records_offset = round_up(sizeof(Header), 4096);
+    const size_t journal_offset = round_up(records_offset + capacity_ * sizeof(Record), 4096);
+    mapping_size_ = journal_offset + journal_capacity * sizeof(uint64_t);
+
+    // Replace, never reuse: readers must not see a half-initialised old layout
+    remove_stale_segment(config.stale_after);
+    int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("PositionSegment: cannot create " + path_ + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0) {
+        device_ = st.st_dev;
+        inode_ = st.st_ino;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+        int error = errno;
+        ::close(fd);
+        ::unlink(path_.c_str());
+        throw std::runtime_error("PositionSegment: cannot size " + path_ + ": " + std::strerror(error));
+    }
+    void* mapping = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::unlink(path_.c_str());
+        throw std::runtime_error("PositionSegment: mmap failed for " + path_ + ": " + std::strerror(errno));
+    }
+    mapping_ = static_cast<std::byte*>(mapping);
+    records_ = reinterpret_cast<Record*>(mapping_ + records_offset);
+    journal_ = reinterpret_cast<uint64_t*>(mapping_ + journal_offset);
+
+    header_ = new (mapping_) Header{};
+    header_->version = VERSION;
+    header_->header_size = sizeof(Header);
+    header_->record_capacity = capacity_;
+    header_->journal_capacity = static_cast<uint32_t>(journal_capacity);
+    header_->records_offset = records_offset;
+    header_->journal_offset = journal_offset;
+    header_->pid = ::getpid();
+    header_->created_wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header_->heartbeat_ns.store(monotonic_ns(), std::memory_order_relaxed);
+    // Magic last: a reader that sees it sees a complete header
+    std::atomic_ref<uint64_t>(header_->magic).store(MAGIC, std::memory_order_release);
+
+    if (config.heartbeat_interval.count() > 0) {
+        heartbeat_task_id_ = core::Runtime::instance().background().schedule_periodic(
+            config.heartbeat_interval, [this]() { heartbeat(); }, "position_segment_heartbeat");
+    }
+    LOG_INFO("PositionSegment: Publishing up to {} positions in {}", capacity_, path_);
+}
+
+PositionSegment::~PositionSegment() {
+    if (heartbeat_task_id_ != 0) {
+        core::Runtime::instance().cancel(heartbeat_task_id_);
+    }
+    ::munmap(mapping_, mapping_size_);
+    struct stat st;
+    if (::stat(path_.c_str(), &st) == 0 && st.st_dev == device_ && st.st_ino == inode_) {
+        ::unlink(path_.c_str());
+    }
+}
+
+void PositionSegment::remove_stale_segment(std::chrono::milliseconds stale_after) {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    // Anything too small or without a complete header is not a live segment
+    int64_t pid = 0;
+    int64_t heartbeat_age_ns = 0;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Header)) {
+        void* mapping = ::mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            const Header* header = static_cast<const Header*>(mapping);
+            if (std::atomic_ref<const uint64_t>(header->magic).load(std::memory_order_acquire) == MAGIC) {
+                pid = header->pid;
+                heartbeat_age_ns = monotonic_ns() - header->heartbeat_ns.load(std::memory_order_relaxed);
+            }
+            ::munmap(mapping, sizeof(Header));
+        }
+    }
+    ::close(fd);
+
+    const bool alive = pid > 0 && (::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+    if (alive && heartbeat_age_ns <= std::chrono::duration_cast<std::chrono::nanoseconds>(stale_after).count()) {
+        throw std::runtime_error("PositionSegment: " + path_ + " is in use by pid " + std::to_string(pid));
+    }
+    if (pid > 0) {
+        LOG_WARN("PositionSegment: Replacing {} left by pid {} ({}, heartbeat {}ms old)", path_, pid,
+                 alive ? "hung" : "exited", heartbeat_age_ns / 1000000);
+    }
+    ::unlink(path_.c_str());
+}
+
+uint32_t PositionSegment::add_position(const std::string& strategy_id, uint64_t symbol_id) {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    auto& symbols = slots_[strategy_id];
+    auto it = symbols.find(symbol_id);
+    if (it != symbols.end()) {
+        return it->second;
+    }
+    const uint32_t slot = header_->record_count.load(std::memory_order_relaxed);
+    if (slot == capacity_) {
+        LOG_WARN("PositionSegment: Full at {} positions; {} {} is not published", capacity_, strategy_id,
+                 symbol_id);
+        return INVALID_SLOT;
+    }
+
+    Record& record = records_[slot];
+    record.symbol_id = symbol_id;
+    const size_t length = std::min(strategy_id.size(), STRATEGY_SIZE - 1);
+    std::memcpy(record.strategy_id, strategy_id.data(), length);
+    record.strategy_id[length] = '\0';
+    symbols.emplace(symbol_id, slot);
+    header_->record_count.store(slot + 1, std::memory_order_release);
+    return slot;
+}
+
+void PositionSegment::publish(uint32_t slot, const PositionValues& values) {
+    if (slot >= capacity_) {
+        return;
+    }
+    Record& record = records_[slot];
+    {
+        core::Seqlock::WriteGuard write(record.sequence);
+        record.values.store(values);
+        record.update_ns.store(monotonic_ns());
+    }
+
+    const uint64_t position = header_->journal_head.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_ref<uint64_t>(journal_[position & journal_mask_])
+        .store(journal_entry(position, slot), std::memory_order_release);
+}
+
+void PositionSegment::heartbeat() {
+    header_->heartbeat_ns.store(monotonic_ns(), std::memory_order_release);
+}
+
+// PositionFeedReader implementation
+PositionFeedReader::PositionFeedReader(const std::string& name) : path_(segment_path(name)) {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path_ + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error(path_ + " is too small to be a position segment");
+    }
+    mapping_size_ = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for " + path_ + ": " + std::strerror(errno));
+    }
+    mapping_ = static_cast<const std::byte*>(mapping);
+    header_ = reinterpret_cast<const Header*>(mapping_);
+
+    uint64_t magic = std::atomic_ref<const uint64_t>(header_->magic).load(std::memory_order_acquire);
+    bool valid = magic == MAGIC && header_->version == VERSION &&
+                 header_->record_capacity <= MAX_RECORDS &&
+                 std::has_single_bit(uint64_t{header_->journal_capacity}) &&
+                 header_->records_offset + header_->record_capacity * sizeof(Record) <= mapping_size_ &&
+                 header_->journal_offset + header_->journal_capacity * sizeof(uint64_t) <= mapping_size_;
+    if (!valid) {
+        ::munmap(const_cast<std::byte*>(mapping_), mapping_size_);
+        throw std::runtime_error(path_ + " is not a position segment (bad header)");
+    }
+    records_ = reinterpret_cast<const Record*>(mapping_ + header_->records_offset);
+    journal_ = reinterpret_cast<const uint64_t*>(mapping_ + header_->journal_offset);
+    journal_mask_ = header_->journal_capacity - 1;
+    positions_.reserve(header_->record_capacity);
+    seen_.reserve(header_->record_capacity);
+
+    // Start from a full read, not counted as staleness; the journal covers
+    // only what follows
+    cursor_ = header_->journal_head.load(std::memory_order_acquire);
+    load_identities();
+    for (uint32_t slot = 0; slot < positions_.size(); ++slot) {
+        read_record(slot, 0);
+    }
+    changed_.clear();
+    staleness_.records_read = 0;
+    drained_ns_ = monotonic_ns();
+}
+
+PositionFeedReader::~PositionFeedReader() {
+    ::munmap(const_cast<std::byte*>(mapping_), mapping_size_);
+}
+
+bool PositionFeedReader::writer_alive() const {
+    return ::kill(writer_pid(), 0) == 0 || errno == EPERM;
+}
+
+void PositionFeedReader::load_identities() {
+    const uint32_t count = std::min(header_->record_count.load(std::memory_order_acquire), header_->record_capacity);
+    for (uint32_t slot = static_cast<uint32_t>(positions_.size()); slot < count; ++slot) {
+        const Record& record = records_[slot];
+        Position position;
+        position.symbol_id = record.symbol_id;
+        position.strategy_id.assign(record.strategy_id, strnlen(record.strategy_id, STRATEGY_SIZE));
+        positions_.push_back(std::move(position));
+        seen_.push_back(0);
+    }
+}
+
+// now_ns zero: not counted towards staleness
+void PositionFeedReader::read_record(uint32_t slot, int64_t now_ns) {
+    const Record& record = records_[slot];
+    PositionValues values;
+    int64_t update_ns = 0;
+    uint32_t attempts = 0;
+    const bool consistent = record.sequence.try_read([&]() {
+        values = record.values.load();
+        update_ns = record.update_ns.load();
+    }, MAX_READ_ATTEMPTS, SPIN_ATTEMPTS, attempts);
+    staleness_.seqlock_retries += attempts > 1;
+    if (!consistent) {
+        return; // Keeps the last copy
+    }
+
+    Position& position = positions_[slot];
+    position.values = values;
+    position.update_ns = update_ns;
+    changed_.push_back(slot);
+    ++staleness_.records_read;
+    if (now_ns > 0 && update_ns > 0) {
+        const int64_t age = std::max<int64_t>(now_ns - update_ns, 0);
+        staleness_.last_record_age_ns = std::max(staleness_.last_record_age_ns, age);
+        staleness_.max_record_age_ns = std::max(staleness_.max_record_age_ns, age);
+        record_age_sum_ += static_cast<double>(age);
+    }
+}
+
+size_t PositionFeedReader::poll() {
+    changed_.clear();
+    staleness_.last_record_age_ns = 0;
+    const uint64_t generation = ++staleness_.polls;
+    const int64_t now = monotonic_ns();
+    const uint64_t capacity = journal_mask_ + 1;
+    const uint64_t head = header_->journal_head.load(std::memory_order_acquire);
+    load_identities();
+
+    bool overrun = head - cursor_ > capacity;
+    while (!overrun && cursor_ < head) {
+        const uint64_t entry =
+            std::atomic_ref<const uint64_t>(journal_[cursor_ & journal_mask_]).load(std::memory_order_acquire);
+        const uint64_t expected = (cursor_ + 1) & POSITION_MASK;
+        const uint64_t found = entry >> SLOT_BITS;
+        if (found != expected) {
+            // Claimed but not yet written: the next poll picks it up. Anything
+            // newer means the writer lapped us.
+            overrun = found > expected;
+            break;
+        }
+        const uint32_t slot = static_cast<uint32_t>(entry & (MAX_RECORDS - 1));
+        if (slot >= positions_.size()) {
+            load_identities();
+        }
+        if (slot < positions_.size() && seen_[slot] != generation) {
+            seen_[slot] = generation;
+            read_record(slot, now);
+        }
+        ++cursor_;
+    }
+
+    if (overrun) {
+        ++staleness_.overruns;
+        LOG_WARN("PositionFeedReader: {} entries behind a {}-entry journal; rereading {} positions",
+                 head - cursor_, capacity, positions_.size());
+        changed_.clear();
+        cursor_ = head;
+        for (uint32_t slot = 0; slot < positions_.size(); ++slot) {
+            seen_[slot] = generation;
+            read_record(slot, now);
+        }
+    }
+    if (cursor_ == head) {
+        drained_ns_ = now;
+    }
+    return changed_.size();
+}
+
+PositionFeedReader::Staleness PositionFeedReader::staleness() const {
+    Staleness staleness = staleness_;
+    const int64_t now = monotonic_ns();
+    staleness.heartbeat_age_ns = now - header_->heartbeat_ns.load(std::memory_order_acquire);
+    staleness.view_age_ns = now - drained_ns_;
+    staleness.journal_lag = header_->journal_head.load(std::memory_order_acquire) - cursor_;
+    staleness.mean_record_age_ns =
+        staleness.records_read > 0 ? record_age_sum_ / static_cast<double>(staleness.records_read) : 0.0;
+    return staleness;
+}
+
+} // namespace goldearn::trading
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "../core/seqlock.hpp"
+#include "../core/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+namespace goldearn::trading {
+
+// Shared-memory position feed (/dev/shm) for goldearn_risk_monitor.
+//
+// One record per (strategy, symbol) position. The thread that updates a
+// position rewrites its record under a seqlock and appends the record's slot
+// to a change journal: a few plain stores and one fetch_add, with no locks,
+// syscalls or allocation, and no collector thread. The monitor maps the
+// segment read-only, follows the journal so a poll costs only the records
+// that changed, and rereads everything if it falls a full journal behind.
+// A housekeeping task stamps a heartbeat so a quiet book can be told from a
+// hung writer. Timestamps are CLOCK_MONOTONIC, shared by every process on
+// the host, so the reader measures publish-to-observe staleness directly.
+namespace position_layout {
+
+constexpr uint64_t MAGIC = 0x31534e534f504547ULL; // "GEPOSNS1"
+constexpr uint32_t VERSION = 2;
+constexpr size_t STRATEGY_SIZE = 32;
+constexpr uint32_t SLOT_BITS = 24;                // Journal entry: (position + 1) << SLOT_BITS | slot
+constexpr uint32_t MAX_RECORDS = 1u << SLOT_BITS;
+constexpr uint32_t INVALID_SLOT = std::numeric_limits<uint32_t>::max();
+
+// What the monitor sees of one position
+struct PositionValues {
+    double quantity = 0.0;          // Positive long, negative short
+    double avg_entry_price = 0.0;
+    double market_price = 0.0;
+    double realized_pnl = 0.0;
+    double unrealized_pnl = 0.0;
+    double exposure = 0.0;          // Signed, quantity x market price
+    uint64_t trades = 0;
+};
+
+struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_capacity;
+    uint32_t journal_capacity;          // Power of two
+    uint64_t records_offset;
+    uint64_t journal_offset;
+    int64_t pid;                        // Writer process, for liveness checks
+    int64_t created_wall_ns;
+    std::atomic<uint32_t> record_count; // Records [0, record_count) carry their identity
+    alignas(64) std::atomic<int64_t> heartbeat_ns;
+    alignas(64) std::atomic<uint64_t> journal_head; // Entries ever appended
+};
+
+// Two cache lines. Identity is written once, before record_count covers the
+// slot; values and update_ns change under the seqlock. Seqlock and cells are
+// plain atomic words, so the zero-filled mapping is a valid initial record.
+struct alignas(64) Record {
+    core::Seqlock sequence;
+    uint64_t symbol_id;
+    char strategy_id[STRATEGY_SIZE];
+    core::SeqlockCell<PositionValues> values;
+    core::SeqlockCell<int64_t> update_ns;
+};
+static_assert(sizeof(Record) == 128, "record layout is shared with readers");
+
+} // namespace position_layout
+
+// Writer side: owned by the trading process, records claimed as positions open
+class PositionSegment {
+public:
+    struct Config {
+        std::string name = "goldearn_positions";      // /dev/shm name or absolute path
+        uint32_t capacity = 16384;                     // Positions
+        uint32_t journal_capacity = 65536;             // Rounded up to a power of two
+        std::chrono::milliseconds heartbeat_interval{1}; // Zero: heartbeat() is called by the owner
+        // An existing segment is replaced only once its writer has exited or
+        // its heartbeat is older than this
+        std::chrono::milliseconds stale_after{5000};
+    };
+
+    // Creates the segment, replacing a stale one. Throws std::invalid_argument
+    // on a bad capacity and std::runtime_error if it cannot be created or
+    // another live writer holds the name.
+    explicit PositionSegment(const Config& config);
+    ~PositionSegment(); // Unlinks the segment unless it has been replaced since
+
+    PositionSegment(const PositionSegment&) = delete;
+    PositionSegment& operator=(const PositionSegment&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    // Cold path, when a position first opens: the slot for (strategy,
+    // symbol), existing or new; INVALID_SLOT once the segment is full
+    uint32_t add_position(const std::string& strategy_id, uint64_t symbol_id);
+
+    // Hot path. Updates to one position are already serialized by its owner,
+    // so each record has one writer at a time.
+    void publish(uint32_t slot, const position_layout::PositionValues& values);
+
+    void heartbeat();
+    uint64_t published() const { return header_->journal_head.load(std::memory_order_relaxed); }
+
+private:
+    // Throws if `path_` holds a segment whose writer is still live
+    void remove_stale_segment(std::chrono::milliseconds stale_after);
+
+    std::string path_;
+    dev_t device_ = 0;                  // Of the file we created, so the
+    ino_t inode_ = 0;                   // destructor leaves a successor alone
+    std::byte* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    position_layout::Header* header_ = nullptr;
+    position_layout::Record* records_ = nullptr;
+    uint64_t* journal_ = nullptr;
+    uint64_t journal_mask_ = 0;
+    uint32_t capacity_ = 0;
+
+    std::mutex slots_mutex_;
+    std::unordered_map<std::string, std::unordered_map<uint64_t, uint32_t>> slots_;
+
+    core::TaskId heartbeat_task_id_ = 0;
+};
+
+// Reader side: maps a segment read-only (goldearn_risk_monitor, or tests)
+// and keeps a local copy of every position, refreshed by poll()
+class PositionFeedReader {
+public:
+    // Throws std::runtime_error if the file is missing or not a position segment
+    explicit PositionFeedReader(const std::string& name);
+    ~PositionFeedReader();
+
+    PositionFeedReader(const PositionFeedReader&) = delete;
+    PositionFeedReader& operator=(const PositionFeedReader&) = delete;
+
+    struct Position {
+        uint64_t symbol_id = 0;
+        std::string strategy_id;
+        position_layout::PositionValues values;
+        int64_t update_ns = 0;          // Writer's clock at the last write seen
+    };
+
+    struct Staleness {
+        int64_t heartbeat_age_ns = 0;   // Since the writer's last heartbeat
+        int64_t view_age_ns = 0;        // Since a poll last drained the journal
+        uint64_t journal_lag = 0;       // Entries appended but not yet applied
+        int64_t last_record_age_ns = 0; // Publish to observe, last poll's worst
+        int64_t max_record_age_ns = 0;  // Publish to observe, since open
+        double mean_record_age_ns = 0.0;
+        uint64_t polls = 0;
+        uint64_t records_read = 0;
+        uint64_t seqlock_retries = 0;   // Record reads that raced a write
+        uint64_t overruns = 0;          // Full rereads after falling a journal behind
+    };
+
+    // Applies every change since the last poll; returns the positions refreshed
+    size_t poll();
+    // By slot; changed() lists the slots the last poll refreshed
+    const std::vector<Position>& positions() const { return positions_; }
+    const std::vector<uint32_t>& changed() const { return changed_; }
+
+    Staleness staleness() const;
+    pid_t writer_pid() const { return static_cast<pid_t>(header_->pid); }
+    bool writer_alive() const;
+
+private:
+    std::string path_;
+    const std::byte* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    const position_layout::Header* header_ = nullptr;
+    const position_layout::Record* records_ = nullptr;
+    const uint64_t* journal_ = nullptr;
+    uint64_t journal_mask_ = 0;
+
+    uint64_t cursor_ = 0;               // Next journal position to apply
+    std::vector<Position> positions_;
+    std::vector<uint32_t> changed_;
+    std::vector<uint64_t> seen_;        // Per slot: poll that last read it
+    Staleness staleness_;
+    double record_age_sum_ = 0.0;
+    int64_t drained_ns_ = 0;
+
+    void load_identities();
+    void read_record(uint32_t slot, int64_t now_ns);
+};
+
+} // namespace goldearn::trading
@@ -0,0 +1,49 @@
+#include "position_store.hpp"
+
+namespace goldearn::trading {
+
+PositionStore::PositionStore(size_t initial_capacity) : pool_(initial_capacity) {
+    // One symbol node per position; strategy nodes and bucket arrays are few
+    // and grow their classes on demand
+    memory_.reserve_nodes<SymbolPositions>(initial_capacity);
+}
+
+Position& PositionStore::open(const std::string& strategy_id, uint64_t symbol_id) {
+    auto strategy = positions_.find(strategy_id);
+    if (strategy == positions_.end()) {
+        strategy = positions_.try_emplace(strategy_id).first;
+    }
+    auto [it, inserted] = strategy->second.try_emplace(symbol_id);
+    if (inserted) {
+        it->second = pool_.make();
+        it->second->symbol_id = symbol_id;
+        it->second->strategy_id = strategy_id;
+        ++count_;
+    }
+    return *it->second;
+}
+
+Position* PositionStore::find(const std::string& strategy_id, uint64_t symbol_id) {
+    auto strategy = positions_.find(strategy_id);
+    if (strategy == positions_.end()) return nullptr;
+    auto it = strategy->second.find(symbol_id);
+    return it != strategy->second.end() ? it->second.get() : nullptr;
+}
+
+const Position* PositionStore::find(const std::string& strategy_id, uint64_t symbol_id) const {
+    auto strategy = positions_.find(strategy_id);
+    if (strategy == positions_.end()) return nullptr;
+    auto it = strategy->second.find(symbol_id);
+    return it != strategy->second.end() ? it->second.get() : nullptr;
+}
+
+bool PositionStore::remove(const std::string& strategy_id, uint64_t symbol_id) {
+    auto strategy = positions_.find(strategy_id);
+    if (strategy == positions_.end() || strategy->second.erase(symbol_id) == 0) {
+        return false;
+    }
+    --count_;
+    return true;
+}
+
+} // namespace goldearn::trading
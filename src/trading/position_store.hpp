@@ -0,0 +1,101 @@
+#pragma once
+
+#include "trading_engine.hpp"
+#include "position_segment.hpp"
+#include "../core/memory_pool.hpp"
+#include <cmath>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+
+namespace goldearn::trading {
+
+// Position information for a single symbol
+struct Position {
+    uint64_t symbol_id;
+    std::string strategy_id;
+    double quantity;           // Positive for long, negative for short
+    double avg_entry_price;    // Volume-weighted average entry price
+    double realized_pnl;       // Realized profit/loss from closed trades
+    double unrealized_pnl;     // Mark-to-market profit/loss
+    double total_pnl;          // Realized + unrealized
+    
+    // Risk metrics
+    double max_position_size;  // Maximum allowed position
+    double var_1d;            // 1-day Value at Risk
+    double exposure_value;     // Position value in base currency
+    
+    // Trade statistics
+    uint64_t total_trades;
+    uint64_t winning_trades;
+    double largest_win;
+    double largest_loss;
+    double avg_trade_pnl;
+    
+    // Timestamps
+    market_data::Timestamp first_trade_time;
+    market_data::Timestamp last_trade_time;
+    market_data::Timestamp last_update_time;
+    
+    // Record in the position segment, if one is set
+    uint32_t segment_slot;
+    
+    Position() : symbol_id(0), quantity(0.0), avg_entry_price(0.0), 
+                 realized_pnl(0.0), unrealized_pnl(0.0), total_pnl(0.0),
+                 max_position_size(0.0), var_1d(0.0), exposure_value(0.0),
+                 total_trades(0), winning_trades(0), largest_win(0.0),
+                 largest_loss(0.0), avg_trade_pnl(0.0),
+                 segment_slot(position_layout::INVALID_SLOT) {}
+    
+    bool is_long() const { return quantity > 0.0; }
+    bool is_short() const { return quantity < 0.0; }
+    bool is_flat() const { return std::abs(quantity) < 1e-8; }
+    double get_notional_value(double current_price) const { return std::abs(quantity) * current_price; }
+    double get_win_rate() const { return total_trades > 0 ? (double)winning_trades / total_trades : 0.0; }
+};
+
+// PositionManager's position storage: strategy_id -> symbol_id -> Position.
+// Position objects come from a fixed-size pool and both map levels draw from
+// a pooled pmr resource, so opening, updating and closing positions on fills
+// never reaches malloc once the pools cover the working set.
+// Not synchronized: the owner serializes access.
+class PositionStore {
+public:
+    explicit PositionStore(size_t initial_capacity = 8192);
+
+    PositionStore(const PositionStore&) = delete;
+    PositionStore& operator=(const PositionStore&) = delete;
+
+    // The position, opened flat if (strategy, symbol) has none yet
+    Position& open(const std::string& strategy_id, uint64_t symbol_id);
+    Position* find(const std::string& strategy_id, uint64_t symbol_id);
+    const Position* find(const std::string& strategy_id, uint64_t symbol_id) const;
+    bool remove(const std::string& strategy_id, uint64_t symbol_id);
+
+    size_t size() const { return count_; }
+    const core::PoolMemoryResource& memory() const { return memory_; }
+
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const auto& [strategy_id, symbols] : positions_) {
+            for (const auto& [symbol_id, position] : symbols) fn(*position);
+        }
+    }
+    template<typename Fn>
+    void for_each_in_strategy(const std::string& strategy_id, Fn&& fn) const {
+        auto it = positions_.find(strategy_id);
+        if (it == positions_.end()) return;
+        for (const auto& [symbol_id, position] : it->second) fn(*position);
+    }
+
+private:
+    using SymbolPositions = std::pmr::unordered_map<uint64_t, core::PoolPtr<Position>>;
+
+    // Declared before the maps that use them
+    core::ObjectPool<Position> pool_;
+    core::PoolMemoryResource memory_;
+    std::pmr::unordered_map<std::string, SymbolPositions> positions_{&memory_};
+    size_t count_ = 0;
+};
+
+} // namespace goldearn::trading
@@ -2,10 +2,14 @@
 
 #include "trading_engine.hpp"
 #include "../market_data/order_book.hpp"
+#include "../market_data/market_statistics.hpp"
 #include "../core/latency_tracker.hpp"
+#include "../core/memory_pool.hpp"
 #include <string>
 #include <map>
+#include <memory_resource>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
 
 namespace goldearn::trading {
@@ -97,8 +101,9 @@ protected:
     double realized_pnl_;
     mutable std::shared_mutex position_mutex_;
     
-    // Order tracking
-    std::map<uint64_t, Order> pending_orders_;
+    // Order tracking (map nodes recycled through a pooled resource)
+    core::PoolMemoryResource order_memory_;
+    std::pmr::map<uint64_t, Order> pending_orders_{&order_memory_};
     std::atomic<uint64_t> next_client_order_id_;
     mutable std::shared_mutex orders_mutex_;
     
@@ -211,6 +216,10 @@ public:
     void set_entry_threshold(double threshold) { entry_threshold_ = threshold; }
     void set_exit_threshold(double threshold) { exit_threshold_ = threshold; }
     void set_max_holding_period_ms(uint64_t period_ms) { max_holding_period_ms_ = period_ms; }
+    // Shared EWMA statistics; the strategy's symbols should be in its universe
+    void set_market_statistics(std::shared_ptr<const market_data::MarketStatistics> statistics) {
+        market_statistics_ = std::move(statistics);
+    }
     
     // Strategy interface implementation
     void on_trade(const market_data::TradeMessage& trade) override;
@@ -228,8 +237,9 @@ protected:
     double exit_threshold_;
     uint64_t max_holding_period_ms_;
     
-    // Price history for statistical analysis
+    // Price history for the spread signals; correlations come from market_statistics_
     std::map<uint64_t, std::vector<double>> price_history_;
+    std::shared_ptr<const market_data::MarketStatistics> market_statistics_;
     std::map<uint64_t, std::chrono::high_resolution_clock::time_point> last_update_times_;
     
     // Virtual methods for derived stat arb strategies
@@ -239,7 +249,9 @@ protected:
     virtual bool should_exit_position() const;
     
     // Statistical calculations
-    double calculate_correlation(uint64_t symbol1, uint64_t symbol2) const;
+    double calculate_correlation(uint64_t symbol1, uint64_t symbol2) const {
+        return market_statistics_ ? market_statistics_->correlation(symbol1, symbol2) : 0.0;
+    }
     double calculate_cointegration_signal(uint64_t symbol1, uint64_t symbol2) const;
     double calculate_zscore(const std::vector<double>& values) const;
     
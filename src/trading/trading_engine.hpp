@@ -15,6 +15,7 @@ class Strategy;
 class OrderManager;
 class PositionManager;
 class RiskEngine;
+class KillSwitch;
 
 // Order types supported by the trading engine
 enum class OrderType : uint8_t {
@@ -151,7 +152,10 @@ public:
     // Engine control
     void start_trading();
     void stop_trading();
+    // Trips the kill switch: the gateway closes and every live order is
+    // cancelled, by mass cancel where the venue has one
     void emergency_stop();
+    void set_kill_switch(std::shared_ptr<KillSwitch> kill_switch);
     
     // Statistics and monitoring
     struct EngineStats {
@@ -186,6 +190,7 @@ private:
     std::atomic<bool> initialized_;
     std::atomic<bool> trading_active_;
     std::atomic<bool> emergency_stop_;
+    std::shared_ptr<KillSwitch> kill_switch_;
     
     // Performance tracking
     std::unique_ptr<core::LatencyTracker> order_latency_tracker_;
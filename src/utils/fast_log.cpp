@@ -0,0 +1,277 @@
+#include "fast_log.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace goldearn::utils {
+
+namespace fast_log {
+
+namespace {
+
+constexpr size_t STRINGS_CAPACITY = 1024 * 1024;
+constexpr size_t PAGE_ALIGN = 4096;
+
+std::atomic<uint64_t> next_generation{1};
+
+int64_t wall_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+void format_message(std::string& out, const char* format, const Record& record) {
+    // Runtime twin of the compile-time layout; only the decoder uses it
+    size_t arg = 0;
+    const char* p = format;
+    while (*p) {
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            out.push_back(*p);
+            p += 2;
+            continue;
+        }
+        if (p[0] != '{') {
+            out.push_back(*p++);
+            continue;
+        }
+        const char* close = std::strchr(p, '}');
+        if (!close || arg >= record.arg_count) {
+            out.append(p);
+            return;
+        }
+        log_detail::FormatSpec spec;
+        const char* s = p + 1;
+        if (*s == ':') {
+            ++s;
+            if (*s == '.') {
+                spec.precision = 0;
+                for (++s; *s >= '0' && *s <= '9'; ++s) {
+                    spec.precision = static_cast<int16_t>(spec.precision * 10 + (*s - '0'));
+                }
+            }
+            if (s < close) spec.type = *s;
+        }
+
+        uint64_t bits = record.args[arg];
+        switch ((record.arg_types >> (arg * 2)) & 3) {
+            case ARG_INT:
+                log_detail::append_value(out, static_cast<long long>(bits), spec);
+                break;
+            case ARG_UINT:
+                log_detail::append_value(out, static_cast<unsigned long long>(bits), spec);
+                break;
+            case ARG_DOUBLE: {
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                log_detail::append_value(out, value, spec);
+                break;
+            }
+            default:
+                log_detail::append_value(out, bits != 0, spec);
+                break;
+        }
+        ++arg;
+        p = close + 1;
+    }
+}
+
+std::vector<DecodedRecord> decode_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+    }
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        throw std::runtime_error(path + " is too small to be a fast log");
+    }
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap failed for " + path + ": " + std::strerror(errno));
+    }
+    const std::byte* base = static_cast<const std::byte*>(mapping);
+    const auto* header = reinterpret_cast<const FileHeader*>(base);
+
+    std::vector<DecodedRecord> decoded;
+    bool valid = header->magic == FILE_MAGIC && header->version == FILE_VERSION &&
+                 header->record_size == sizeof(Record) &&
+                 header->records_offset + header->record_capacity * sizeof(Record) <= static_cast<uint64_t>(size) &&
+                 header->strings_offset + header->strings_capacity <= static_cast<uint64_t>(size);
+    if (!valid) {
+        ::munmap(mapping, static_cast<size_t>(size));
+        throw std::runtime_error(path + " is not a fast log (bad header)");
+    }
+
+    // String table: address at record time -> text
+    std::unordered_map<uint64_t, std::string> strings;
+    const std::byte* table = base + header->strings_offset;
+    uint64_t used = std::min(header->strings_used.load(), header->strings_capacity);
+    for (uint64_t offset = 0; offset + sizeof(uint64_t) + sizeof(uint32_t) <= used;) {
+        uint64_t address;
+        uint32_t length;
+        std::memcpy(&address, table + offset, sizeof(address));
+        std::memcpy(&length, table + offset + sizeof(address), sizeof(length));
+        size_t text = offset + sizeof(address) + sizeof(length);
+        if (text + length > used) break;
+        strings.emplace(address, std::string(reinterpret_cast<const char*>(table + text), length));
+        offset = (text + length + 7) & ~uint64_t{7};
+    }
+
+    double ns_per_tick = 0.0;
+    uint64_t latest_tsc = header->latest_tsc.load();
+    int64_t latest_wall = header->latest_wall_ns.load();
+    if (latest_tsc > header->start_tsc && latest_wall - header->start_wall_ns > 1000000) {
+        ns_per_tick = static_cast<double>(latest_wall - header->start_wall_ns) /
+                      static_cast<double>(latest_tsc - header->start_tsc);
+    }
+
+    const auto* records = reinterpret_cast<const Record*>(base + header->records_offset);
+    uint64_t mask = header->record_capacity - 1;
+    for (uint64_t slot = 0; slot < header->record_capacity; ++slot) {
+        const Record& record = records[slot];
+        // Unwritten, torn (sequence still 0) or foreign slots are skipped
+        if (record.sequence == 0 || ((record.sequence - 1) & mask) != slot ||
+            record.arg_count > MAX_ARGS) {
+            continue;
+        }
+        DecodedRecord out;
+        out.tsc = record.tsc;
+        out.wall_ns = header->start_wall_ns +
+            static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(record.tsc - header->start_tsc)) * ns_per_tick);
+        out.thread_id = record.thread_id;
+        out.level = record.level;
+        auto it = strings.find(record.message);
+        if (it != strings.end()) {
+            format_message(out.message, it->second.c_str(), record);
+        } else {
+            out.message = "<unknown format string>";
+        }
+        decoded.push_back(std::move(out));
+    }
+    ::munmap(mapping, static_cast<size_t>(size));
+
+    std::stable_sort(decoded.begin(), decoded.end(),
+                     [](const DecodedRecord& a, const DecodedRecord& b) { return a.tsc < b.tsc; });
+    return decoded;
+}
+
+} // namespace fast_log
+
+FastLogFile::FastLogFile(const std::string& path, size_t size_bytes)
+    : path_(path)
+    , generation_(fast_log::next_generation.fetch_add(1)) {
+    using namespace fast_log;
+
+    size_t records_offset = (sizeof(FileHeader) + PAGE_ALIGN - 1) & ~(PAGE_ALIGN - 1);
+    size_t record_bytes = size_bytes > records_offset + STRINGS_CAPACITY
+        ? size_bytes - records_offset - STRINGS_CAPACITY : 0;
+    uint64_t capacity = std::bit_floor(std::max<uint64_t>(record_bytes / sizeof(Record), CHUNK_RECORDS * 4));
+    size_t strings_offset = records_offset + capacity * sizeof(Record);
+    mapping_size_ = strings_offset + STRINGS_CAPACITY;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("FastLogFile: cannot open " + path + ": " + std::strerror(errno));
+    }
+    // Reserve the blocks now so the hot path never extends the file
+    int rc = ::posix_fallocate(fd_, 0, static_cast<off_t>(mapping_size_));
+    if (rc != 0 && ::ftruncate(fd_, static_cast<off_t>(mapping_size_)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("FastLogFile: cannot size " + path + ": " + std::strerror(rc));
+    }
+
+    void* mapping = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd_);
+        throw std::runtime_error("FastLogFile: mmap failed for " + path + ": " + std::strerror(errno));
+    }
+    mapping_ = static_cast<std::byte*>(mapping);
+    // Touch every page so the first write to it does not fault
+    std::memset(mapping_, 0, mapping_size_);
+
+    header_ = new (mapping_) FileHeader{};
+    header_->magic = FILE_MAGIC;
+    header_->version = FILE_VERSION;
+    header_->record_size = sizeof(Record);
+    header_->record_capacity = capacity;
+    header_->records_offset = records_offset;
+    header_->strings_offset = strings_offset;
+    header_->strings_capacity = STRINGS_CAPACITY;
+    header_->start_tsc = log_detail::read_tsc();
+    header_->start_wall_ns = wall_clock_ns();
+    header_->latest_tsc.store(header_->start_tsc);
+    header_->latest_wall_ns.store(header_->start_wall_ns);
+
+    records_ = reinterpret_cast<Record*>(mapping_ + records_offset);
+    mask_ = capacity - 1;
+}
+
+FastLogFile::~FastLogFile() {
+    if (mapping_) {
+        update_clock();
+        ::msync(mapping_, mapping_size_, MS_SYNC);
+        ::munmap(mapping_, mapping_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void FastLogFile::intern(const char* message) {
+    std::lock_guard<std::mutex> lock(strings_mutex_);
+    if (!interned_.insert(message).second) {
+        return;
+    }
+
+    uint32_t length = static_cast<uint32_t>(std::strlen(message));
+    size_t entry_size = (sizeof(uint64_t) + sizeof(uint32_t) + length + 7) & ~size_t{7};
+    uint64_t used = header_->strings_used.load(std::memory_order_relaxed);
+    if (used + entry_size > header_->strings_capacity) {
+        // Table full: records for this string decode as unknown
+        return;
+    }
+
+    std::byte* entry = mapping_ + header_->strings_offset + used;
+    uint64_t address = reinterpret_cast<uint64_t>(message);
+    std::memcpy(entry, &address, sizeof(address));
+    std::memcpy(entry + sizeof(address), &length, sizeof(length));
+    std::memcpy(entry + sizeof(address) + sizeof(length), message, length);
+    header_->strings_used.store(used + entry_size, std::memory_order_release);
+}
+
+void FastLogFile::update_clock() {
+    header_->latest_tsc.store(log_detail::read_tsc(), std::memory_order_relaxed);
+    header_->latest_wall_ns.store(fast_log::wall_clock_ns(), std::memory_order_relaxed);
+}
+
+void FastLogFile::sync() {
+    ::msync(mapping_, mapping_size_, MS_ASYNC);
+}
+
+void FastLogFile::claim(fast_log::ThreadCursor& cursor) {
+    if (cursor.thread_id == 0) {
+        cursor.thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+    }
+    uint64_t start = next_slot_.fetch_add(fast_log::CHUNK_RECORDS, std::memory_order_relaxed);
+    // Chunks never straddle a wrap: the capacity is a multiple of the chunk size
+    uint64_t lap = start / capacity();
+    uint64_t seen = lap_.load(std::memory_order_relaxed);
+    while (seen < lap && !lap_.compare_exchange_weak(seen, lap, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+    }
+    cursor.generation = generation_;
+    cursor.lap = lap;
+    cursor.next = start;
+    cursor.end = start + fast_log::CHUNK_RECORDS;
+}
+
+} // namespace goldearn::utils
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace goldearn::utils {
+
+// Binary log for the hot path (Logger::log_fast). Records are fixed-size,
+// one cache line each, and are written with plain stores into a preallocated
+// memory-mapped file that wraps around when full. Only the address of the
+// static format string is recorded; each distinct string is copied once into
+// the file's string table so the offline decoder can turn records into text.
+namespace fast_log {
+
+constexpr uint64_t FILE_MAGIC = 0x31474f4c54534146ULL; // "FASTLOG1"
+constexpr uint32_t FILE_VERSION = 1;
+constexpr size_t MAX_ARGS = 4;
+constexpr size_t CHUNK_RECORDS = 64; // Slots a thread claims per atomic op
+
+enum ArgType : uint8_t {
+    ARG_INT = 0,
+    ARG_UINT = 1,
+    ARG_DOUBLE = 2,
+    ARG_BOOL = 3
+};
+
+struct alignas(64) Record {
+    uint64_t sequence;      // Slot index + 1, stored last; 0 while being written
+    uint64_t tsc;
+    uint64_t message;       // Address of the static format string
+    uint32_t thread_id;
+    uint8_t level;
+    uint8_t arg_count;
+    uint8_t arg_types;      // 2 bits per argument
+    uint8_t reserved;
+    uint64_t args[MAX_ARGS];
+};
+static_assert(sizeof(Record) == 64, "fast log records are one cache line");
+
+// Start of the file. Records follow at records_offset, the string table at
+// strings_offset; each string entry is {uint64 address, uint32 length, text}
+// padded to 8 bytes.
+struct FileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_capacity;   // Power of two
+    uint64_t records_offset;
+    uint64_t strings_offset;
+    uint64_t strings_capacity;
+    std::atomic<uint64_t> strings_used;
+    // TSC -> wall clock: fixed start anchor plus the latest sample
+    uint64_t start_tsc;
+    int64_t start_wall_ns;
+    std::atomic<uint64_t> latest_tsc;
+    std::atomic<int64_t> latest_wall_ns;
+};
+
+template<typename T>
+inline uint64_t encode_arg(T value, uint8_t& type) {
+    uint64_t bits = 0;
+    if constexpr (std::is_same_v<T, bool>) {
+        type = ARG_BOOL;
+        bits = value ? 1 : 0;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        type = ARG_DOUBLE;
+        double d = static_cast<double>(value);
+        std::memcpy(&bits, &d, sizeof(bits));
+    } else if constexpr (std::is_signed_v<T>) {
+        type = ARG_INT;
+        bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+    } else {
+        type = ARG_UINT;
+        bits = static_cast<uint64_t>(value);
+    }
+    return bits;
+}
+
+// Render one record's message (format string resolved from the table)
+void format_message(std::string& out, const char* format, const Record& record);
+
+struct DecodedRecord {
+    uint64_t tsc;
+    int64_t wall_ns;
+    uint32_t thread_id;
+    uint8_t level;
+    std::string message;
+};
+
+// Offline decoding: every complete record still in the file, oldest first.
+// Throws std::runtime_error if the file is not a fast log.
+std::vector<DecodedRecord> decode_file(const std::string& path);
+
+// Per-thread write position; trivially constructible so TLS access is free.
+// `lap` is how many times the file had wrapped when the chunk was claimed.
+struct ThreadCursor {
+    uint64_t generation;
+    uint64_t lap;
+    uint64_t next;
+    uint64_t end;
+    uint32_t thread_id;
+};
+inline thread_local ThreadCursor tl_cursor{};
+
+} // namespace fast_log
+
+class FastLogFile {
+public:
+    // Creates (truncating) and preallocates `path`; size is rounded down to a
+    // power-of-two number of records. Throws std::runtime_error on failure.
+    FastLogFile(const std::string& path, size_t size_bytes);
+    ~FastLogFile();
+
+    FastLogFile(const FastLogFile&) = delete;
+    FastLogFile& operator=(const FastLogFile&) = delete;
+
+    // Changes whenever a new file is opened; per-site interning is keyed on it
+    uint64_t generation() const { return generation_; }
+
+    // Copy `message` into the string table once per file (slow path)
+    void intern(const char* message);
+
+    template<typename... A>
+    void write(uint8_t level, uint64_t tsc, const char* message, const A&... args) {
+        static_assert(sizeof...(A) <= fast_log::MAX_ARGS, "log_fast takes at most MAX_ARGS numeric arguments");
+        fast_log::ThreadCursor& cursor = fast_log::tl_cursor;
+        // A chunk left half-used while other threads wrapped the file may now
+        // overlap theirs; drop it once anyone has started a newer lap
+        if (cursor.generation != generation_ || cursor.next == cursor.end ||
+            cursor.lap != lap_.load(std::memory_order_acquire)) {
+            claim(cursor);
+        }
+        uint64_t slot = cursor.next++;
+        fast_log::Record& record = records_[slot & mask_];
+
+        std::atomic_ref<uint64_t> sequence(record.sequence);
+        sequence.store(0, std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_seq_cst); // x86 keeps the store order
+        record.tsc = tsc;
+        record.message = reinterpret_cast<uint64_t>(message);
+        record.thread_id = cursor.thread_id;
+        record.level = level;
+        record.arg_count = static_cast<uint8_t>(sizeof...(A));
+        uint8_t types = 0;
+        [[maybe_unused]] size_t i = 0;
+        ((record.args[i] = encode_one(args, types, i), ++i), ...);
+        record.arg_types = types;
+        sequence.store(slot + 1, std::memory_order_release);
+    }
+
+    // Record a fresh TSC/wall clock sample for the decoder (logger thread)
+    void update_clock();
+
+    // Push dirty pages to disk (not needed for crash safety, only power loss)
+    void sync();
+
+    const std::string& path() const { return path_; }
+    uint64_t capacity() const { return mask_ + 1; }
+    uint64_t slots_claimed() const { return next_slot_.load(std::memory_order_relaxed); }
+
+private:
+    template<typename T>
+    static uint64_t encode_one(const T& value, uint8_t& types, size_t index) {
+        uint8_t type;
+        uint64_t bits = fast_log::encode_arg(value, type);
+        types |= static_cast<uint8_t>(type << (index * 2));
+        return bits;
+    }
+
+    void claim(fast_log::ThreadCursor& cursor);
+
+    std::string path_;
+    int fd_ = -1;
+    std::byte* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    fast_log::FileHeader* header_ = nullptr;
+    fast_log::Record* records_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t generation_ = 0;
+    std::atomic<uint64_t> lap_{0}; // Newest lap any chunk was claimed in; changes once per wrap
+
+    alignas(64) std::atomic<uint64_t> next_slot_{0};
+
+    alignas(64) std::mutex strings_mutex_;
+    std::unordered_set<const char*> interned_;
+};
+
+} // namespace goldearn::utils
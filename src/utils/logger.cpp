@@ -1,102 +1,130 @@
 #include "logger.hpp"
-#include <iostream>
-#include <iomanip>
-#include <thread>
-#include <cstring>
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 namespace goldearn::utils {
 
-Logger::Logger() = default;
+namespace log_detail {
 
-Logger::~Logger() {
-    flush();
+// LogRing implementation
+LogRing::LogRing(size_t capacity)
+    : buffer_(std::make_unique<std::byte[]>(std::bit_ceil(std::max<size_t>(capacity, 4096))))
+    , capacity_(std::bit_ceil(std::max<size_t>(capacity, 4096)))
+    , mask_(capacity_ - 1)
+    , os_thread_id_(static_cast<uint32_t>(::syscall(SYS_gettid))) {
 }
 
-void Logger::set_file_output(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(file_mutex_);
-    
-    if (file_stream_) {
-        file_stream_->close();
+std::byte* LogRing::reserve(size_t bytes) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    size_t offset = head & mask_;
+    size_t contiguous = capacity_ - offset;
+    size_t needed = bytes <= contiguous ? bytes : contiguous + bytes;
+
+    if (head + needed - cached_tail_ > capacity_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head + needed - cached_tail_ > capacity_) {
+            return nullptr;
+        }
     }
-    
-    file_stream_ = std::make_unique<std::ofstream>(filename, std::ios::app);
-    if (!file_stream_->is_open()) {
-        std::cerr << "Failed to open log file: " << filename << std::endl;
-        file_stream_.reset();
+
+    if (bytes > contiguous) {
+        // Records never straddle the end of the buffer
+        EntryPrefix padding{static_cast<uint32_t>(contiguous), ENTRY_PADDING};
+        std::memcpy(buffer_.get() + offset, &padding, sizeof(padding));
+        head += contiguous;
+        offset = 0;
     }
+
+    pending_head_ = head + bytes;
+    return buffer_.get() + offset;
 }
 
-void Logger::log(LogLevel level, const std::string& message, const char* file, int line, const char* function) {
-    if (level < log_level_.load()) {
-        messages_dropped_.fetch_add(1);
+void LogRing::commit() {
+    head_.store(pending_head_, std::memory_order_release);
+}
+
+// Formatting helpers
+void append_value(std::string& out, std::string_view value, FormatSpec) {
+    out.append(value);
+}
+
+void append_value(std::string& out, bool value, FormatSpec) {
+    out.append(value ? "true" : "false");
+}
+
+void append_value(std::string& out, char value, FormatSpec) {
+    out.push_back(value);
+}
+
+void append_value(std::string& out, long long value, FormatSpec spec) {
+    if (spec.type == 'f' || spec.type == 'e' || spec.type == 'g' || spec.type == '%') {
+        append_value(out, static_cast<double>(value), spec);
         return;
     }
-    
-    try {
-        std::ostringstream oss;
-        oss << "[" << get_timestamp() << "] "
-            << "[" << level_to_string(level) << "] "
-            << "[" << std::this_thread::get_id() << "] ";
-        
-        // Extract just filename from full path
-        const char* filename = strrchr(file, '/');
-        filename = filename ? filename + 1 : file;
-        
-        oss << "[" << filename << ":" << line << " " << function << "] "
-            << message;
-        
-        write_to_outputs(oss.str());
-        messages_logged_.fetch_add(1);
-        
-    } catch (const std::exception& e) {
-        messages_dropped_.fetch_add(1);
-        // Last resort - try to log to stderr
-        std::cerr << "Logger error: " << e.what() << " - Original message: " << message << std::endl;
-    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, spec.type == 'x' ? 16 : 10);
+    out.append(buffer, result.ptr);
 }
 
-void Logger::log_fast(LogLevel level, const char* message) {
-    if (level < log_level_.load()) {
-        messages_dropped_.fetch_add(1);
+void append_value(std::string& out, unsigned long long value, FormatSpec spec) {
+    if (spec.type == 'f' || spec.type == 'e' || spec.type == 'g' || spec.type == '%') {
+        append_value(out, static_cast<double>(value), spec);
         return;
     }
-    
-    // Ultra-fast logging without formatting for HFT critical paths
-    if (console_output_) {
-        std::cout << message << std::endl;
-    }
-    
-    // Skip file logging for maximum speed
-    messages_logged_.fetch_add(1);
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, spec.type == 'x' ? 16 : 10);
+    out.append(buffer, result.ptr);
 }
 
-void Logger::flush() {
-    std::lock_guard<std::mutex> lock(file_mutex_);
-    
-    if (console_output_) {
-        std::cout.flush();
-    }
-    
-    if (file_stream_ && file_stream_->is_open()) {
-        file_stream_->flush();
+void append_value(std::string& out, double value, FormatSpec spec) {
+    char buffer[64];
+    int precision = spec.precision < 0 ? 6 : spec.precision;
+    int length;
+    switch (spec.type) {
+        case 'f':
+            length = std::snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+            break;
+        case 'e':
+            length = std::snprintf(buffer, sizeof(buffer), "%.*e", precision, value);
+            break;
+        case '%':
+            length = std::snprintf(buffer, sizeof(buffer), "%.*f%%", precision, value * 100.0);
+            break;
+        default:
+            // Same as ostream's default (6 significant digits) unless a precision is given
+            length = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+            break;
     }
+    out.append(buffer, std::min<size_t>(std::max(length, 0), sizeof(buffer) - 1));
 }
 
-std::string Logger::get_timestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::ostringstream oss;
-    oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    
-    return oss.str();
+void append_value(std::string& out, const void* value, FormatSpec spec) {
+    char buffer[32];
+    int length = spec.type == 'x'
+        ? std::snprintf(buffer, sizeof(buffer), "%lx", static_cast<unsigned long>(reinterpret_cast<uintptr_t>(value)))
+        : std::snprintf(buffer, sizeof(buffer), "%p", value);
+    out.append(buffer, std::max(length, 0));
 }
 
-std::string Logger::level_to_string(LogLevel level) {
-    switch (level) {
+} // namespace log_detail
+
+namespace {
+
+// Marks the calling thread's ring as abandoned when the thread exits; the
+// logger thread frees it once drained
+struct RingHandle {
+    log_detail::LogRing* ring = nullptr;
+    ~RingHandle() {
+        if (ring) ring->abandoned.store(true, std::memory_order_release);
+    }
+};
+
+const char* level_to_string(uint8_t level) {
+    switch (static_cast<LogLevel>(level)) {
         case LogLevel::TRACE:    return "TRACE";
         case LogLevel::DEBUG:    return "DEBUG";
         case LogLevel::INFO:     return "INFO";
@@ -107,19 +135,283 @@ std::string Logger::level_to_string(LogLevel level) {
     }
 }
 
-void Logger::write_to_outputs(const std::string& formatted_message) {
+int64_t wall_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+Logger::Logger() {
+    anchor_tsc_ = log_detail::read_tsc();
+    anchor_wall_ns_ = wall_clock_ns();
+    running_ = true;
+    writer_thread_ = std::thread(&Logger::writer_loop, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    wake_cv_.notify_all();
+    flushed_cv_.notify_all();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fast_files_mutex_);
+        fast_file_.store(nullptr);
+        fast_files_.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void Logger::set_file_output(const std::string& filename) {
+    // Records queued before the switch belong to the old sink
+    flush();
+    std::lock_guard<std::mutex> lock(file_mutex_);
+
+    if (file_) {
+        std::fclose(file_);
+    }
+
+    file_ = std::fopen(filename.c_str(), "a");
+    if (!file_) {
+        std::fprintf(stderr, "Failed to open log file: %s\n", filename.c_str());
+    }
+}
+
+void Logger::log(LogLevel level, const std::string& message, const char* file, int line, const char* function) {
+    log_checked<"{}">(level, file, line, function, message);
+}
+
+bool Logger::set_fast_log_file(const std::string& path, size_t size_bytes) {
+    if (path.empty()) {
+        // Back to the regular log; the old mapping stays valid for racing writers
+        fast_file_.store(nullptr, std::memory_order_release);
+        return true;
+    }
+
+    std::unique_ptr<FastLogFile> file;
+    try {
+        file = std::make_unique<FastLogFile>(path, size_bytes);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Logger: fast log disabled: {}", e.what());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(fast_files_mutex_);
+    fast_file_.store(file.get(), std::memory_order_release);
+    fast_files_.push_back(std::move(file));
+    return true;
+}
+
+uint64_t Logger::get_messages_dropped() const {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    uint64_t total = abandoned_drops_;
+    for (const auto& ring : rings_) {
+        total += ring->dropped();
+    }
+    return total;
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    if (!running_) return;
+    uint64_t ticket = ++flush_requested_;
+    wake_cv_.notify_all();
+    flushed_cv_.wait(lock, [&]() { return flush_completed_ >= ticket || !running_; });
+}
+
+log_detail::LogRing& Logger::thread_ring() {
+    thread_local RingHandle handle;
+    if (!handle.ring) {
+        // First log call on this thread: the only allocation it will ever make here
+        auto ring = std::make_unique<log_detail::LogRing>(ring_capacity_.load());
+        handle.ring = ring.get();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::move(ring));
+    }
+    return *handle.ring;
+}
+
+void Logger::writer_loop() {
+    while (true) {
+        uint64_t flush_target;
+        bool running;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            flush_target = flush_requested_;
+            running = running_;
+        }
+
+        size_t written = drain();
+        if (FastLogFile* fast_file = fast_file_.load(std::memory_order_acquire)) {
+            fast_file->update_clock();
+        }
+
+        if (flush_target > flush_completed_ || !running) {
+            {
+                std::lock_guard<std::mutex> lock(file_mutex_);
+                if (file_) std::fflush(file_);
+            }
+            std::fflush(stderr);
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                flush_completed_ = flush_target;
+            }
+            flushed_cv_.notify_all();
+        }
+
+        if (!running) break;
+
+        if (written == 0) {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+                return !running_ || flush_requested_ > flush_completed_;
+            });
+        }
+    }
+}
+
+size_t Logger::drain() {
+    std::vector<log_detail::LogRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings.reserve(rings_.size());
+        for (const auto& ring : rings_) rings.push_back(ring.get());
+    }
+
+    calibrate_clock();
+
+    struct Line {
+        uint64_t tsc;
+        std::string text;
+    };
+    std::vector<Line> batch;
+    std::vector<log_detail::LogRing*> finished;
+
+    for (log_detail::LogRing* ring : rings) {
+        // Read before consuming so nothing committed before exit is missed
+        bool abandoned = ring->abandoned.load(std::memory_order_acquire);
+        uint32_t tid = ring->os_thread_id();
+
+        ring->consume([&](const std::byte* record, size_t) {
+            log_detail::RecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+
+            Line line{header.tsc, {}};
+            line.text.reserve(160);
+            append_prefix(line.text, header, tid);
+            header.format_fn(line.text, header.format, record + sizeof(header));
+            line.text.push_back('\n');
+            batch.push_back(std::move(line));
+        });
+
+        if (abandoned) finished.push_back(ring);
+    }
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (log_detail::LogRing* ring : finished) {
+            abandoned_drops_ += ring->dropped();
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                [ring](const auto& owned) { return owned.get() == ring; }), rings_.end());
+        }
+    }
+
+    uint64_t dropped = get_messages_dropped();
+    if (dropped > reported_drops_) {
+        Line line{log_detail::read_tsc(), {}};
+        log_detail::RecordHeader header{line.tsc, nullptr, "", "", nullptr, 0,
+                                        static_cast<uint8_t>(LogLevel::WARNING)};
+        append_prefix(line.text, header, static_cast<uint32_t>(::syscall(SYS_gettid)));
+        line.text += "Logger: dropped " + std::to_string(dropped - reported_drops_) +
+                     " messages (ring full)\n";
+        batch.push_back(std::move(line));
+        reported_drops_ = dropped;
+    }
+
+    if (batch.empty()) return 0;
+
+    // Interleave threads in timestamp order
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Line& a, const Line& b) { return a.tsc < b.tsc; });
+
+    std::string text;
+    size_t total = 0;
+    for (const auto& line : batch) total += line.text.size();
+    text.reserve(total);
+    for (const auto& line : batch) text += line.text;
+
+    write_to_outputs(text);
+    messages_logged_.fetch_add(batch.size(), std::memory_order_relaxed);
+    return batch.size();
+}
+
+void Logger::calibrate_clock() {
+    // Fixed anchor, slope re-estimated on every pass; accuracy improves as the
+    // process runs
+    uint64_t tsc = log_detail::read_tsc();
+    int64_t wall = wall_clock_ns();
+    if (tsc > anchor_tsc_ && wall - anchor_wall_ns_ > 1000000) {
+        ns_per_tick_ = static_cast<double>(wall - anchor_wall_ns_) / static_cast<double>(tsc - anchor_tsc_);
+    }
+}
+
+int64_t Logger::tsc_to_wall_ns(uint64_t tsc) const {
+    if (ns_per_tick_ <= 0.0) {
+        return wall_clock_ns();
+    }
+    int64_t ticks = static_cast<int64_t>(tsc - anchor_tsc_);
+    return anchor_wall_ns_ + static_cast<int64_t>(static_cast<double>(ticks) * ns_per_tick_);
+}
+
+void Logger::append_prefix(std::string& out, const log_detail::RecordHeader& header, uint32_t tid) const {
+    int64_t wall_ns = tsc_to_wall_ns(header.tsc);
+    std::time_t seconds = static_cast<std::time_t>(wall_ns / 1000000000);
+    std::tm local;
+    localtime_r(&seconds, &local);
+
+    char buffer[96];
+    size_t length = std::strftime(buffer, sizeof(buffer), "[%Y-%m-%d %H:%M:%S", &local);
+    length += std::snprintf(buffer + length, sizeof(buffer) - length, ".%06lld] [%s] [%u] ",
+                            static_cast<long long>((wall_ns / 1000) % 1000000),
+                            level_to_string(header.level), tid);
+    out.append(buffer, std::min(length, sizeof(buffer) - 1));
+
+    if (header.line > 0) {
+        // Extract just filename from full path
+        const char* filename = std::strrchr(header.file, '/');
+        filename = filename ? filename + 1 : header.file;
+        out += '[';
+        out += filename;
+        out += ':';
+        out += std::to_string(header.line);
+        out += ' ';
+        out += header.function;
+        out += "] ";
+    }
+}
+
+void Logger::write_to_outputs(const std::string& text) {
     // Console output
     if (console_output_) {
-        std::cout << formatted_message << std::endl;
+        std::fwrite(text.data(), 1, text.size(), stderr);
     }
-    
+
     // File output
-    {
-        std::lock_guard<std::mutex> lock(file_mutex_);
-        if (file_stream_ && file_stream_->is_open()) {
-            *file_stream_ << formatted_message << std::endl;
-        }
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (file_) {
+        std::fwrite(text.data(), 1, text.size(), file_);
     }
 }
 
-} // namespace goldearn::utils
\ No newline at end of file
+} // namespace goldearn::utils
@@ -1,13 +1,27 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
-#include <fstream>
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
 #include <sstream>
+#include <thread>
 #include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "fast_log.hpp"
 
 namespace goldearn::utils {
 
@@ -20,125 +34,538 @@ enum class LogLevel {
     CRITICAL = 5
 };
 
+// Asynchronous deferred-formatting logger.
+//
+// The calling thread only captures a TSC timestamp, the (static) format string
+// pointer and the raw bytes of each argument into its own lock-free SPSC ring.
+// A background thread decodes the records, formats them, converts timestamps
+// and performs all I/O. When a ring is full the record is dropped and counted;
+// the hot path never blocks.
+namespace log_detail {
+
+inline uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// Formats one record: writes the message for `format` into `out`, reading the
+// serialized arguments from `args`
+using FormatFn = void (*)(std::string& out, const char* format, const std::byte* args);
+
+// Every ring entry starts with this prefix; size includes the prefix and is
+// a multiple of 8. PADDING entries fill the gap before the ring wraps.
+struct EntryPrefix {
+    uint32_t size;
+    uint32_t kind;
+};
+enum EntryKind : uint32_t { ENTRY_RECORD = 1, ENTRY_PADDING = 2 };
+
+struct RecordHeader {
+    uint64_t tsc;
+    const char* format;
+    const char* file;
+    const char* function;
+    FormatFn format_fn;
+    uint32_t line;
+    uint8_t level;
+};
+
+// Single-producer (owning thread) / single-consumer (logger thread) byte ring
+class alignas(64) LogRing {
+public:
+    explicit LogRing(size_t capacity);
+
+    // Producer side
+    std::byte* reserve(size_t bytes); // nullptr if full
+    void commit();
+    void record_drop() { dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    // Consumer side: call `fn(record_bytes, size)` for every committed record
+    template<typename Fn>
+    size_t consume(Fn&& fn);
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint32_t os_thread_id() const { return os_thread_id_; }
+    size_t max_record_size() const { return capacity_ / 4; }
+
+    std::atomic<bool> abandoned{false}; // Owning thread exited
+
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    const size_t capacity_;
+    const size_t mask_;
+    uint32_t os_thread_id_;
+
+    alignas(64) std::atomic<uint64_t> head_{0}; // Written by producer
+    uint64_t cached_tail_ = 0;
+    uint64_t pending_head_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+
+    alignas(64) std::atomic<uint64_t> tail_{0}; // Written by consumer
+};
+
+template<typename Fn>
+size_t LogRing::consume(Fn&& fn) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    size_t records = 0;
+    while (tail != head) {
+        std::byte* entry = buffer_.get() + (tail & mask_);
+        EntryPrefix prefix;
+        std::memcpy(&prefix, entry, sizeof(prefix));
+        if (prefix.kind == ENTRY_RECORD) {
+            fn(entry + sizeof(EntryPrefix), prefix.size - sizeof(EntryPrefix));
+            records++;
+        }
+        tail += prefix.size;
+    }
+    tail_.store(tail, std::memory_order_release);
+    return records;
+}
+
+// Argument codecs. Arithmetic, enum and pointer values are copied as raw bytes;
+// strings are copied (length + bytes) because their lifetime is unknown. Any
+// other streamable type is rendered to a string on the calling thread.
+template<typename T> struct is_atomic : std::false_type {};
+template<typename T> struct is_atomic<std::atomic<T>> : std::true_type {};
+
+template<typename T>
+struct ArgCodec {
+    using Raw = std::remove_cv_t<std::remove_reference_t<T>>;
+
+    static constexpr bool is_string =
+        std::is_same_v<std::decay_t<Raw>, const char*> || std::is_same_v<std::decay_t<Raw>, char*> ||
+        std::is_same_v<Raw, std::string> || std::is_same_v<Raw, std::string_view>;
+};
+
+template<typename T>
+auto normalize(const T& value) {
+    using Raw = std::remove_cv_t<T>;
+    if constexpr (is_atomic<Raw>::value) {
+        return normalize(value.load(std::memory_order_relaxed));
+    } else if constexpr (ArgCodec<T>::is_string) {
+        if constexpr (std::is_array_v<Raw>) {
+            return std::string_view(value);
+        } else if constexpr (std::is_pointer_v<Raw>) {
+            return std::string_view(value ? value : "(null)");
+        } else {
+            return std::string_view(value);
+        }
+    } else if constexpr (std::is_enum_v<Raw>) {
+        return static_cast<std::underlying_type_t<Raw>>(value);
+    } else if constexpr (std::is_pointer_v<std::decay_t<Raw>>) {
+        return static_cast<const void*>(value);
+    } else if constexpr (std::is_arithmetic_v<Raw>) {
+        return value;
+    } else {
+        std::ostringstream oss;
+        oss << value;
+        return oss.str();
+    }
+}
+
+// Stored representation: strings (including eagerly rendered values) become
+// string_view on the wire
+template<typename N>
+using wire_t = std::conditional_t<std::is_same_v<N, std::string>, std::string_view, N>;
+
+template<typename N>
+size_t encoded_size(const N& value) {
+    if constexpr (std::is_same_v<N, std::string_view> || std::is_same_v<N, std::string>) {
+        return sizeof(uint32_t) + value.size();
+    } else {
+        return sizeof(N);
+    }
+}
+
+template<typename N>
+void encode(std::byte*& out, const N& value) {
+    if constexpr (std::is_same_v<N, std::string_view> || std::is_same_v<N, std::string>) {
+        uint32_t length = static_cast<uint32_t>(value.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), value.data(), length);
+        out += sizeof(length) + length;
+    } else {
+        std::memcpy(out, &value, sizeof(N));
+        out += sizeof(N);
+    }
+}
+
+template<typename W>
+W decode(const std::byte*& in) {
+    if constexpr (std::is_same_v<W, std::string_view>) {
+        uint32_t length;
+        std::memcpy(&length, in, sizeof(length));
+        W value(reinterpret_cast<const char*>(in + sizeof(length)), length);
+        in += sizeof(length) + length;
+        return value;
+    } else {
+        W value;
+        std::memcpy(&value, in, sizeof(W));
+        in += sizeof(W);
+        return value;
+    }
+}
+
+// Compile-time format strings. The format literal becomes a template
+// argument, is parsed once at compile time into a FormatLayout (literal
+// pieces plus a pre-parsed spec per placeholder) and checked against the
+// argument types: a wrong placeholder count or a spec that does not fit its
+// argument is a compile error. Placeholders are {} or {:spec} with
+// spec = [.precision][f|e|g|%|d|x]; {{ and }} are literal braces.
+template<size_t N>
+struct FixedString {
+    char data[N]{};
+    consteval FixedString(const char (&str)[N]) {
+        for (size_t i = 0; i < N; ++i) data[i] = str[i];
+    }
+    static constexpr size_t length = N - 1;
+};
+
+struct FormatSpec {
+    int16_t precision = -1;
+    char type = 0;
+};
+
+template<size_t MaxPlaceholders, size_t TextSize>
+struct FormatLayout {
+    bool well_formed = true;
+    size_t placeholders = 0;
+    char text[TextSize]{};                          // Literal text, escapes resolved
+    uint16_t piece_end[MaxPlaceholders + 1]{};      // End of literal piece i in text
+    FormatSpec specs[MaxPlaceholders + 1]{};
+};
+
+template<FixedString Fmt>
+consteval auto parse_format() {
+    FormatLayout<Fmt.length / 2 + 1, Fmt.length + 1> layout;
+    const char* f = Fmt.data;
+    size_t out = 0;
+    size_t i = 0;
+    while (i < Fmt.length) {
+        char c = f[i];
+        if (c == '{' && f[i + 1] == '{') {
+            layout.text[out++] = '{';
+            i += 2;
+        } else if (c == '}' && f[i + 1] == '}') {
+            layout.text[out++] = '}';
+            i += 2;
+        } else if (c == '}') {
+            layout.well_formed = false; // Stray closing brace
+            return layout;
+        } else if (c == '{') {
+            FormatSpec spec;
+            ++i;
+            if (f[i] == ':') {
+                ++i;
+                if (f[i] == '.') {
+                    ++i;
+                    if (f[i] < '0' || f[i] > '9') {
+                        layout.well_formed = false;
+                        return layout;
+                    }
+                    spec.precision = 0;
+                    while (f[i] >= '0' && f[i] <= '9') {
+                        spec.precision = static_cast<int16_t>(spec.precision * 10 + (f[i] - '0'));
+                        ++i;
+                    }
+                }
+                if (f[i] != '}') {
+                    spec.type = f[i++];
+                }
+            }
+            if (f[i] != '}') {
+                layout.well_formed = false; // Unterminated or unsupported placeholder
+                return layout;
+            }
+            ++i;
+            layout.piece_end[layout.placeholders] = static_cast<uint16_t>(out);
+            layout.specs[layout.placeholders] = spec;
+            layout.placeholders++;
+        } else {
+            layout.text[out++] = c;
+            ++i;
+        }
+    }
+    layout.piece_end[layout.placeholders] = static_cast<uint16_t>(out);
+    return layout;
+}
+
+template<FixedString Fmt>
+inline constexpr auto format_layout = parse_format<Fmt>();
+
+template<typename W>
+consteval bool spec_fits(FormatSpec spec) {
+    constexpr bool is_float = std::is_floating_point_v<W>;
+    constexpr bool is_integer = std::is_integral_v<W> && !std::is_same_v<W, bool> && !std::is_same_v<W, char>;
+    constexpr bool is_pointer = std::is_same_v<W, const void*>;
+    switch (spec.type) {
+        case 0:
+            return spec.precision < 0 || is_float;
+        case 'f': case 'e': case 'g': case '%':
+            return is_float || is_integer;
+        case 'd':
+            return is_integer && spec.precision < 0;
+        case 'x':
+            return (is_integer || is_pointer) && spec.precision < 0;
+        default:
+            return false;
+    }
+}
+
+template<FixedString Fmt, typename... Wire>
+consteval bool specs_fit() {
+    constexpr auto& layout = format_layout<Fmt>;
+    if (layout.placeholders != sizeof...(Wire)) return true; // Reported by the count check
+    size_t i = 0;
+    bool ok = true;
+    ((ok = ok && spec_fits<Wire>(layout.specs[i++])), ...);
+    return ok;
+}
+
+template<typename T>
+using normalized_t = decltype(normalize(std::declval<const T&>()));
+
+// True if LOG_*(Fmt, Args...) compiles
+template<FixedString Fmt, typename... Args>
+consteval bool is_valid_format() {
+    constexpr auto& layout = format_layout<Fmt>;
+    if constexpr (!layout.well_formed || layout.placeholders != sizeof...(Args)) {
+        return false;
+    } else {
+        return specs_fit<Fmt, wire_t<normalized_t<Args>>...>();
+    }
+}
+
+// Formatting helpers used on the logger thread
+void append_value(std::string& out, std::string_view value, FormatSpec spec);
+void append_value(std::string& out, bool value, FormatSpec spec);
+void append_value(std::string& out, char value, FormatSpec spec);
+void append_value(std::string& out, long long value, FormatSpec spec);
+void append_value(std::string& out, unsigned long long value, FormatSpec spec);
+void append_value(std::string& out, double value, FormatSpec spec);
+void append_value(std::string& out, const void* value, FormatSpec spec);
+
+template<typename W>
+void append_arg(std::string& out, const W& value, FormatSpec spec) {
+    if constexpr (std::is_same_v<W, std::string_view> || std::is_same_v<W, bool> ||
+                  std::is_same_v<W, char> || std::is_same_v<W, const void*>) {
+        append_value(out, value, spec);
+    } else if constexpr (std::is_floating_point_v<W>) {
+        append_value(out, static_cast<double>(value), spec);
+    } else if constexpr (std::is_signed_v<W>) {
+        append_value(out, static_cast<long long>(value), spec);
+    } else {
+        append_value(out, static_cast<unsigned long long>(value), spec);
+    }
+}
+
+// Decoder for one call-site signature: walks the precomputed layout, no parsing
+template<FixedString Fmt, typename... Wire>
+void format_record(std::string& out, const char*, [[maybe_unused]] const std::byte* args) {
+    constexpr auto& layout = format_layout<Fmt>;
+    size_t piece = 0;
+    size_t offset = 0;
+    [[maybe_unused]] auto one = [&](auto value) {
+        out.append(layout.text + offset, layout.piece_end[piece] - offset);
+        offset = layout.piece_end[piece];
+        append_arg(out, value, layout.specs[piece]);
+        piece++;
+    };
+    // Braced init list guarantees left-to-right decoding
+    (void)std::initializer_list<int>{(one(decode<Wire>(args)), 0)...};
+    out.append(layout.text + offset, layout.piece_end[piece] - offset);
+}
+
+} // namespace log_detail
+
 class Logger {
 public:
     static Logger& instance() {
         static Logger instance;
         return instance;
     }
-    
+
     void set_level(LogLevel level) { log_level_.store(level); }
     LogLevel get_level() const { return log_level_.load(); }
-    
+    bool should_log(LogLevel level) const { return level >= log_level_.load(std::memory_order_relaxed); }
+
+    // Writes out what is already queued to the current sink, then switches
     void set_file_output(const std::string& filename);
     void set_console_output(bool enabled) { console_output_ = enabled; }
-    
-    void log(LogLevel level, const std::string& message, 
-             const char* file = __builtin_FILE(), 
+
+    // Per-thread ring size for threads that have not logged yet
+    void set_ring_capacity(size_t bytes) { ring_capacity_.store(bytes); }
+
+    // Deferred logging with a compile-time checked format (used by LOG_*)
+    template<log_detail::FixedString Fmt, typename... Args>
+    void log_checked(LogLevel level, const char* file, int line, const char* function,
+                     const Args&... args) {
+        using namespace log_detail;
+        static_assert(format_layout<Fmt>.well_formed,
+                      "LOG_*: malformed format string (unbalanced brace or unsupported spec)");
+        static_assert(format_layout<Fmt>.placeholders == sizeof...(Args),
+                      "LOG_*: number of {} placeholders does not match the number of arguments");
+        static_assert(specs_fit<Fmt, wire_t<normalized_t<Args>>...>(),
+                      "LOG_*: format spec does not fit the argument type");
+        if (!should_log(level)) return;
+        enqueue(level, file, line, function, Fmt.data,
+                &format_record<Fmt, wire_t<normalized_t<Args>>...>, normalize(args)...);
+    }
+
+    // Pre-formatted message (copied into the ring)
+    void log(LogLevel level, const std::string& message,
+             const char* file = __builtin_FILE(),
              int line = __builtin_LINE(),
              const char* function = __builtin_FUNCTION());
-    
-    // Overload for when no arguments are provided
-    void log_formatted(LogLevel level, const std::string& format,
-                      const char* file = __builtin_FILE(),
-                      int line = __builtin_LINE(), 
-                      const char* function = __builtin_FUNCTION()) {
-        if (level < log_level_.load()) return;
-        log(level, format, file, line, function);
-    }
-    
-    template<typename... Args>
-    typename std::enable_if<sizeof...(Args) != 0, void>::type
-    log_formatted(LogLevel level, const std::string& format, Args&&... args,
-                  const char* file = __builtin_FILE(),
-                  int line = __builtin_LINE(), 
-                  const char* function = __builtin_FUNCTION()) {
-        if (level < log_level_.load()) return;
-        
-        try {
-            std::string message = format_string(format, std::forward<Args>(args)...);
-            log(level, message, file, line, function);
-        } catch (const std::exception& e) {
-            // Fallback to basic logging if formatting fails
-            log(LogLevel::ERROR, "Log formatting error: " + std::string(e.what()), file, line, function);
-            log(level, format, file, line, function);
+
+    // Hot-path logging: a fixed-size binary record with up to
+    // fast_log::MAX_ARGS numeric arguments, written into the memory-mapped
+    // file set by set_fast_log_file (no formatting, no syscalls). Decode the
+    // file with goldearn_fast_log_decode. Without a file the record goes
+    // through the regular deferred path.
+    template<log_detail::FixedString Fmt, typename... Args>
+    void log_fast(LogLevel level, const Args&... args) {
+        using namespace log_detail;
+        static_assert(sizeof...(Args) <= fast_log::MAX_ARGS, "LOG_FAST: too many arguments");
+        static_assert((std::is_arithmetic_v<wire_t<normalized_t<Args>>> && ...),
+                      "LOG_FAST: arguments must be numeric");
+        static_assert(format_layout<Fmt>.well_formed, "LOG_FAST: malformed format string");
+        static_assert(format_layout<Fmt>.placeholders == sizeof...(Args),
+                      "LOG_FAST: number of {} placeholders does not match the number of arguments");
+        static_assert(specs_fit<Fmt, wire_t<normalized_t<Args>>...>(),
+                      "LOG_FAST: format spec does not fit the argument type");
+        if (!should_log(level)) return;
+
+        FastLogFile* file = fast_file_.load(std::memory_order_acquire);
+        if (!file) {
+            enqueue(level, "", 0, "", Fmt.data,
+                    &format_record<Fmt, wire_t<normalized_t<Args>>...>, normalize(args)...);
+            return;
+        }
+        // The string table entry is written once per call site and file
+        static std::atomic<uint64_t> interned_generation{0};
+        if (interned_generation.load(std::memory_order_relaxed) != file->generation()) {
+            file->intern(Fmt.data);
+            interned_generation.store(file->generation(), std::memory_order_relaxed);
         }
+        file->write(static_cast<uint8_t>(level), read_tsc(), Fmt.data, normalize(args)...);
     }
-    
-    // Performance-critical logging for HFT
-    void log_fast(LogLevel level, const char* message);
-    
+
+    // Route log_fast into a preallocated, memory-mapped rolling file (an
+    // empty path switches back). Files stay mapped until shutdown so
+    // concurrent writers remain valid.
+    bool set_fast_log_file(const std::string& path, size_t size_bytes = 64 * 1024 * 1024);
+    FastLogFile* get_fast_log_file() const { return fast_file_.load(std::memory_order_acquire); }
+
     // Statistics
     uint64_t get_messages_logged() const { return messages_logged_.load(); }
-    uint64_t get_messages_dropped() const { return messages_dropped_.load(); }
-    
+    uint64_t get_messages_dropped() const;
+
+    // Block until every record enqueued before the call has been written
     void flush();
-    
+
 private:
     Logger();
     ~Logger();
-    
+
     std::atomic<LogLevel> log_level_{LogLevel::INFO};
     std::atomic<bool> console_output_{true};
-    std::unique_ptr<std::ofstream> file_stream_;
+    std::atomic<size_t> ring_capacity_{256 * 1024};
+
+    // Output is owned by the background thread
+    std::FILE* file_ = nullptr;
     std::mutex file_mutex_;
-    
+
+    // Registered per-thread rings
+    std::vector<std::unique_ptr<log_detail::LogRing>> rings_;
+    mutable std::mutex rings_mutex_;
+    uint64_t abandoned_drops_ = 0;
+    uint64_t reported_drops_ = 0; // Writer thread only
+
+    std::thread writer_thread_;
+    std::atomic<bool> running_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
+
     std::atomic<uint64_t> messages_logged_{0};
-    std::atomic<uint64_t> messages_dropped_{0};
-    
-    // Base case for no arguments
-    std::string format_string(const std::string& format) {
-        return format;
-    }
-    
-    template<typename T>
-    std::string format_string(const std::string& format, T&& value) {
-        // Simple format replacement for {}
-        std::string result = format;
-        size_t pos = result.find("{}");
-        if (pos != std::string::npos) {
-            std::ostringstream oss;
-            oss << std::forward<T>(value);
-            result.replace(pos, 2, oss.str());
-        }
-        return result;
-    }
-    
-    template<typename T, typename... Args>
-    std::string format_string(const std::string& format, T&& first, Args&&... rest) {
-        std::string partial = format_string(format, std::forward<T>(first));
-        return format_string(partial, std::forward<Args>(rest)...);
-    }
-    
-    std::string get_timestamp();
-    std::string level_to_string(LogLevel level);
-    void write_to_outputs(const std::string& formatted_message);
-};
 
-// Convenience macros for logging
-#define LOG_TRACE(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::TRACE, msg, ##__VA_ARGS__)
+    // log_fast target; replaced files stay mapped until destruction
+    std::atomic<FastLogFile*> fast_file_{nullptr};
+    std::vector<std::unique_ptr<FastLogFile>> fast_files_;
+    std::mutex fast_files_mutex_;
+
+    // TSC -> wall clock calibration, maintained by the writer thread
+    uint64_t anchor_tsc_ = 0;
+    int64_t anchor_wall_ns_ = 0;
+    double ns_per_tick_ = 0.0;
 
-#define LOG_DEBUG(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::DEBUG, msg, ##__VA_ARGS__)
+    log_detail::LogRing& thread_ring();
 
-#define LOG_INFO(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::INFO, msg, ##__VA_ARGS__)
+    template<typename... N>
+    void enqueue(LogLevel level, const char* file, int line, const char* function,
+                 const char* format, log_detail::FormatFn format_fn, const N&... args);
 
-#define LOG_WARNING(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::WARNING, msg, ##__VA_ARGS__)
+    void writer_loop();
+    size_t drain();
+    void calibrate_clock();
+    int64_t tsc_to_wall_ns(uint64_t tsc) const;
+    void append_prefix(std::string& out, const log_detail::RecordHeader& header, uint32_t tid) const;
+    void write_to_outputs(const std::string& text);
+};
+
+template<typename... N>
+void Logger::enqueue(LogLevel level, const char* file, int line, const char* function,
+                     const char* format, log_detail::FormatFn format_fn, const N&... args) {
+    using namespace log_detail;
+
+    // Fixed-size part of the record is a compile-time constant; only string
+    // arguments add a runtime length
+    constexpr size_t fixed_size = sizeof(EntryPrefix) + sizeof(RecordHeader) +
+        (size_t{0} + ... + (std::is_same_v<wire_t<N>, std::string_view> ? sizeof(uint32_t) : sizeof(N)));
+    size_t size = fixed_size;
+    ((size += std::is_same_v<wire_t<N>, std::string_view> ? encoded_size(args) - sizeof(uint32_t) : 0), ...);
+    size = (size + 7) & ~size_t{7};
+
+    LogRing& ring = thread_ring();
+    std::byte* entry = size <= ring.max_record_size() ? ring.reserve(size) : nullptr;
+    if (!entry) {
+        ring.record_drop();
+        return;
+    }
 
-#define LOG_WARN(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::WARNING, msg, ##__VA_ARGS__)
+    EntryPrefix prefix{static_cast<uint32_t>(size), ENTRY_RECORD};
+    RecordHeader header{read_tsc(), format, file, function, format_fn,
+                        static_cast<uint32_t>(line), static_cast<uint8_t>(level)};
+    std::memcpy(entry, &prefix, sizeof(prefix));
+    std::memcpy(entry + sizeof(prefix), &header, sizeof(header));
+    [[maybe_unused]] std::byte* out = entry + sizeof(prefix) + sizeof(header);
+    (encode(out, args), ...);
+    ring.commit();
+}
 
-#define LOG_ERROR(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::ERROR, msg, ##__VA_ARGS__)
+// Convenience macros for logging. The format must be a string literal and is
+// checked against the arguments at compile time; arguments are captured by
+// value and formatted later on the logger thread.
+#define GOLDEARN_LOG(level, fmt, ...) \
+    goldearn::utils::Logger::instance().log_checked<fmt>(level, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
 
-#define LOG_CRITICAL(msg, ...) \
-    goldearn::utils::Logger::instance().log_formatted(goldearn::utils::LogLevel::CRITICAL, msg, ##__VA_ARGS__)
+#define LOG_TRACE(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::TRACE, msg, ##__VA_ARGS__)
+#define LOG_DEBUG(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::DEBUG, msg, ##__VA_ARGS__)
+#define LOG_INFO(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::INFO, msg, ##__VA_ARGS__)
+#define LOG_WARNING(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::WARNING, msg, ##__VA_ARGS__)
+#define LOG_WARN(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::WARNING, msg, ##__VA_ARGS__)
+#define LOG_ERROR(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::ERROR, msg, ##__VA_ARGS__)
+#define LOG_CRITICAL(msg, ...) GOLDEARN_LOG(goldearn::utils::LogLevel::CRITICAL, msg, ##__VA_ARGS__)
 
-// High-performance logging for critical paths
-#define LOG_FAST(level, msg) \
-    goldearn::utils::Logger::instance().log_fast(level, msg)
+// High-performance logging for critical paths: numeric arguments only
+#define LOG_FAST(level, fmt, ...) \
+    goldearn::utils::Logger::instance().log_fast<fmt>(level, ##__VA_ARGS__)
 
-} // namespace goldearn::utils
\ No newline at end of file
+} // namespace goldearn::utils
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::utils {
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random
+// Numbers: As Easy as 1, 2, 3", SC'11). The output is a pure function of
+// (key, counter), so any position of any stream can be produced directly:
+// work split across threads draws exactly the numbers a single thread would.
+namespace philox {
+
+constexpr uint32_t M0 = 0xD2511F53;
+constexpr uint32_t M1 = 0xCD9E8D57;
+constexpr uint32_t W0 = 0x9E3779B9;
+constexpr uint32_t W1 = 0xBB67AE85;
+constexpr int ROUNDS = 10;
+
+struct Block {
+    uint32_t v[4];
+};
+
+inline Block generate(Block counter, uint32_t key0, uint32_t key1) {
+    for (int round = 0; round < ROUNDS; ++round) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * counter.v[0];
+        uint64_t p1 = static_cast<uint64_t>(M1) * counter.v[2];
+        counter = Block{{static_cast<uint32_t>(p1 >> 32) ^ counter.v[1] ^ key0, static_cast<uint32_t>(p1),
+                         static_cast<uint32_t>(p0 >> 32) ^ counter.v[3] ^ key1, static_cast<uint32_t>(p0)}};
+        key0 += W0;
+        key1 += W1;
+    }
+    return counter;
+}
+
+#ifdef __AVX2__
+// Eight counters at once, word w of every counter in c[w]
+inline void generate_x8(__m256i c[4], uint32_t key0, uint32_t key1) {
+    const __m256i m0 = _mm256_set1_epi64x(M0);
+    const __m256i m1 = _mm256_set1_epi64x(M1);
+    for (int round = 0; round < ROUNDS; ++round) {
+        // 32x32 -> 64 products of the even lanes, then of the odd ones
+        __m256i even0 = _mm256_mul_epu32(c[0], m0);
+        __m256i odd0 = _mm256_mul_epu32(_mm256_srli_epi64(c[0], 32), m0);
+        __m256i even1 = _mm256_mul_epu32(c[2], m1);
+        __m256i odd1 = _mm256_mul_epu32(_mm256_srli_epi64(c[2], 32), m1);
+        __m256i lo0 = _mm256_blend_epi32(even0, _mm256_slli_epi64(odd0, 32), 0xAA);
+        __m256i hi0 = _mm256_blend_epi32(_mm256_srli_epi64(even0, 32), odd0, 0xAA);
+        __m256i lo1 = _mm256_blend_epi32(even1, _mm256_slli_epi64(odd1, 32), 0xAA);
+        __m256i hi1 = _mm256_blend_epi32(_mm256_srli_epi64(even1, 32), odd1, 0xAA);
+
+        c[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, c[1]), _mm256_set1_epi32(static_cast<int>(key0)));
+        c[1] = lo1;
+        c[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, c[3]), _mm256_set1_epi32(static_cast<int>(key1)));
+        c[3] = lo0;
+        key0 += W0;
+        key1 += W1;
+    }
+}
+#endif
+
+} // namespace philox
+
+} // namespace goldearn::utils
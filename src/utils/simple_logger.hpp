@@ -1,5 +1,6 @@
 #pragma once
 
+#include "logger.hpp"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -55,13 +56,7 @@ private:
     }
 };
 
-// Simplified macros
-#define LOG_ERROR(fmt, ...) goldearn::utils::SimpleLogger::log("ERROR", fmt, ##__VA_ARGS__)
-#define LOG_WARNING(fmt, ...) goldearn::utils::SimpleLogger::log("WARNING", fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...) goldearn::utils::SimpleLogger::log("WARNING", fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...) goldearn::utils::SimpleLogger::log("INFO", fmt, ##__VA_ARGS__)
-#define LOG_DEBUG(fmt, ...) goldearn::utils::SimpleLogger::log("DEBUG", fmt, ##__VA_ARGS__)
-#define LOG_TRACE(fmt, ...) goldearn::utils::SimpleLogger::log("TRACE", fmt, ##__VA_ARGS__)
-#define LOG_CRITICAL(fmt, ...) goldearn::utils::SimpleLogger::log("CRITICAL", fmt, ##__VA_ARGS__)
+// LOG_* macros come from logger.hpp: every call site goes through the
+// asynchronous deferred-formatting Logger
 
 } // namespace goldearn::utils
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace goldearn::utils {
+
+// Elementwise math on four doubles for the risk engines' inner loops.
+// Accurate to a few ulp over the ranges the callers use; no errno, no
+// special handling of NaN or infinities.
+namespace vmath {
+
+constexpr double TWO_POW_M32 = 1.0 / 4294967296.0;
+constexpr double LN2 = 0.693147180559945309417;
+constexpr double PI_2 = 1.57079632679489661923;
+constexpr double LOG2E = 1.44269504088896340736;
+constexpr double INV_SQRT_2PI = 0.39894228040143267794;
+// LN2 split so that k * LN2_HI is exact for |k| < 2^11
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+
+// u32 random word -> uniform in (0, 1), never 0 or 1
+inline double to_unit(uint32_t bits) {
+    return (static_cast<double>(bits) + 0.5) * TWO_POW_M32;
+}
+
+#ifdef __AVX2__
+
+inline __m256d fmadd(__m256d a, __m256d b, __m256d c) {
+#ifdef __FMA__
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+// Four u32 words -> uniforms in (0, 1)
+inline __m256d to_unit(__m128i bits) {
+    // cvtepi32 is signed: flip the top bit and add it back as 2^31
+    __m256d value = _mm256_cvtepi32_pd(_mm_xor_si128(bits, _mm_set1_epi32(INT32_MIN)));
+    return _mm256_mul_pd(_mm256_add_pd(value, _mm256_set1_pd(2147483648.5)), _mm256_set1_pd(TWO_POW_M32));
+}
+
+// Natural log of positive, normal x
+inline __m256d log(__m256d x) {
+    const __m256i bits = _mm256_castpd_si256(x);
+    // Exponent as a double: put the biased exponent under 2^52 and subtract it
+    __m256i biased = _mm256_srli_epi64(bits, 52);
+    __m256d exponent = _mm256_sub_pd(
+        _mm256_castsi256_pd(_mm256_or_si256(biased, _mm256_set1_epi64x(0x4330000000000000LL))),
+        _mm256_set1_pd(4503599627370496.0 + 1023.0));
+    // Mantissa in [1, 2), folded to [sqrt(1/2), sqrt(2))
+    __m256d mantissa = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)), _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    __m256d high = _mm256_cmp_pd(mantissa, _mm256_set1_pd(1.41421356237309504880), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), high);
+    exponent = _mm256_add_pd(exponent, _mm256_and_pd(high, _mm256_set1_pd(1.0)));
+
+    // log(m) = 2 atanh(f), f = (m - 1) / (m + 1), |f| < 0.172
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d f = _mm256_div_pd(_mm256_sub_pd(mantissa, one), _mm256_add_pd(mantissa, one));
+    __m256d s = _mm256_mul_pd(f, f);
+    __m256d series = _mm256_set1_pd(1.0 / 19);
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 17));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 15));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 13));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 11));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 9));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 7));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 5));
+    series = fmadd(series, s, _mm256_set1_pd(1.0 / 3));
+    series = _mm256_mul_pd(series, s);
+    __m256d two_f = _mm256_add_pd(f, f);
+    __m256d log_mantissa = fmadd(two_f, series, two_f);
+    return fmadd(exponent, _mm256_set1_pd(LN2), log_mantissa);
+}
+
+// e^x for x in [-708, 708]; clamped outside, so the result stays normal
+inline __m256d exp(__m256d x) {
+    x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(708.0)), _mm256_set1_pd(-708.0));
+    // x = k ln2 + r, |r| <= ln2 / 2
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = fmadd(k, _mm256_set1_pd(-LN2_HI), x);
+    r = fmadd(k, _mm256_set1_pd(-LN2_LO), r);
+
+    // Taylor to r^12: the first term dropped is below 2e-16 relative
+    __m256d poly = _mm256_set1_pd(1.0 / 479001600.0);
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 39916800.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 3628800.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 362880.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 40320.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 5040.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 720.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 120.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 24.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0 / 6.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(0.5));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0));
+    poly = fmadd(poly, r, _mm256_set1_pd(1.0));
+
+    // 2^k: k + 1023 into the exponent field
+    __m256i biased = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k)), _mm256_set1_epi64x(1023));
+    return _mm256_mul_pd(poly, _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52)));
+}
+
+// Standard normal CDF (Hart's approximation as given by West, "Better
+// approximations to cumulative normal functions"): a rational function times
+// e^(-x^2/2) below |x| = 7.07, a continued fraction above, 0 or 1 past 37.
+// Absolute error within a few ulp of 1; relative 1e-8 deep in the lower tail.
+inline __m256d norm_cdf(__m256d x) {
+    const __m256d sign_bit = _mm256_set1_pd(-0.0);
+    __m256d a = _mm256_andnot_pd(sign_bit, x);
+    __m256d gauss = exp(_mm256_mul_pd(_mm256_mul_pd(a, a), _mm256_set1_pd(-0.5)));
+
+    __m256d num = _mm256_set1_pd(3.52624965998911e-02);
+    num = fmadd(num, a, _mm256_set1_pd(0.700383064443688));
+    num = fmadd(num, a, _mm256_set1_pd(6.37396220353165));
+    num = fmadd(num, a, _mm256_set1_pd(33.912866078383));
+    num = fmadd(num, a, _mm256_set1_pd(112.079291497871));
+    num = fmadd(num, a, _mm256_set1_pd(221.213596169931));
+    num = fmadd(num, a, _mm256_set1_pd(220.206867912376));
+    __m256d den = _mm256_set1_pd(8.83883476483184e-02);
+    den = fmadd(den, a, _mm256_set1_pd(1.75566716318264));
+    den = fmadd(den, a, _mm256_set1_pd(16.064177579207));
+    den = fmadd(den, a, _mm256_set1_pd(86.7807322029461));
+    den = fmadd(den, a, _mm256_set1_pd(296.564248779674));
+    den = fmadd(den, a, _mm256_set1_pd(637.333633378831));
+    den = fmadd(den, a, _mm256_set1_pd(793.826512519948));
+    den = fmadd(den, a, _mm256_set1_pd(440.413735824752));
+    __m256d inner = _mm256_div_pd(_mm256_mul_pd(gauss, num), den);
+
+    __m256d fraction = _mm256_add_pd(a, _mm256_set1_pd(0.65));
+    fraction = _mm256_add_pd(a, _mm256_div_pd(_mm256_set1_pd(4.0), fraction));
+    fraction = _mm256_add_pd(a, _mm256_div_pd(_mm256_set1_pd(3.0), fraction));
+    fraction = _mm256_add_pd(a, _mm256_div_pd(_mm256_set1_pd(2.0), fraction));
+    fraction = _mm256_add_pd(a, _mm256_div_pd(_mm256_set1_pd(1.0), fraction));
+    __m256d outer = _mm256_div_pd(_mm256_mul_pd(gauss, _mm256_set1_pd(INV_SQRT_2PI)), fraction);
+
+    // Lower tail at -|x|, reflected for positive x
+    __m256d tail = _mm256_blendv_pd(outer, inner, _mm256_cmp_pd(a, _mm256_set1_pd(7.07106781186547), _CMP_LT_OQ));
+    tail = _mm256_and_pd(tail, _mm256_cmp_pd(a, _mm256_set1_pd(37.0), _CMP_LE_OQ));
+    return _mm256_blendv_pd(tail, _mm256_sub_pd(_mm256_set1_pd(1.0), tail),
+                            _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_GT_OQ));
+}
+
+// sin and cos of 2*pi*u for u in [0, 1). The quadrant comes off 4u exactly,
+// leaving |a| <= pi/4 for the Taylor polynomials.
+inline void sincos_2pi(__m256d u, __m256d& sin_out, __m256d& cos_out) {
+    __m256d t = _mm256_mul_pd(u, _mm256_set1_pd(4.0));
+    __m256d quadrant = _mm256_round_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d a = _mm256_mul_pd(_mm256_sub_pd(t, quadrant), _mm256_set1_pd(PI_2));
+    __m256d a2 = _mm256_mul_pd(a, a);
+
+    __m256d sin_poly = _mm256_set1_pd(-1.0 / 1307674368000.0);
+    sin_poly = fmadd(sin_poly, a2, _mm256_set1_pd(1.0 / 6227020800.0));
+    sin_poly = fmadd(sin_poly, a2, _mm256_set1_pd(-1.0 / 39916800.0));
+    sin_poly = fmadd(sin_poly, a2, _mm256_set1_pd(1.0 / 362880.0));
+    sin_poly = fmadd(sin_poly, a2, _mm256_set1_pd(-1.0 / 5040.0));
+    sin_poly = fmadd(sin_poly, a2, _mm256_set1_pd(1.0 / 120.0));
+    sin_poly = fmadd(sin_poly, a2, _mm256_set1_pd(-1.0 / 6.0));
+    __m256d sin_a = fmadd(_mm256_mul_pd(sin_poly, a2), a, a);
+
+    __m256d cos_poly = _mm256_set1_pd(1.0 / 20922789888000.0);
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(-1.0 / 87178291200.0));
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(1.0 / 479001600.0));
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(-1.0 / 3628800.0));
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(1.0 / 40320.0));
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(-1.0 / 720.0));
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(1.0 / 24.0));
+    cos_poly = fmadd(cos_poly, a2, _mm256_set1_pd(-0.5));
+    __m256d cos_a = fmadd(cos_poly, a2, _mm256_set1_pd(1.0));
+
+    // Quadrant q: swap on odd q, negate sin for q = 2, 3 and cos for q = 1, 2
+    __m256i q = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(quadrant));
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i two = _mm256_set1_epi64x(2);
+    __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(q, one), one));
+    __m256i sin_sign = _mm256_slli_epi64(_mm256_and_si256(q, two), 62);
+    __m256i cos_sign = _mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(q, one), two), 62);
+    sin_out = _mm256_xor_pd(_mm256_blendv_pd(sin_a, cos_a, swap), _mm256_castsi256_pd(sin_sign));
+    cos_out = _mm256_xor_pd(_mm256_blendv_pd(cos_a, sin_a, swap), _mm256_castsi256_pd(cos_sign));
+}
+
+// Box-Muller: two independent standard normals per pair of u32 words
+inline void box_muller(__m128i radius_bits, __m128i angle_bits, __m256d& z0, __m256d& z1) {
+    __m256d radius = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_set1_pd(-2.0), log(to_unit(radius_bits))));
+    __m256d sin_angle, cos_angle;
+    sincos_2pi(to_unit(angle_bits), sin_angle, cos_angle);
+    z0 = _mm256_mul_pd(radius, cos_angle);
+    z1 = _mm256_mul_pd(radius, sin_angle);
+}
+
+#endif
+
+inline double norm_cdf(double x) {
+    return 0.5 * std::erfc(-x * 0.70710678118654752440);
+}
+
+inline void box_muller(uint32_t radius_bits, uint32_t angle_bits, double& z0, double& z1) {
+    double radius = std::sqrt(-2.0 * std::log(to_unit(radius_bits)));
+    double angle = 2.0 * M_PI * to_unit(angle_bits);
+    z0 = radius * std::cos(angle);
+    z1 = radius * std::sin(angle);
+}
+
+} // namespace vmath
+
+} // namespace goldearn::utils
@@ -0,0 +1,49 @@
+#include "allocation_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local bool g_count_allocations = false;
+std::atomic<uint64_t> g_allocation_count{0};
+
+void* counted_malloc(size_t size) {
+    if (g_count_allocations) g_allocation_count.fetch_add(1);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* counted_aligned_malloc(size_t size, size_t alignment) {
+    if (g_count_allocations) g_allocation_count.fetch_add(1);
+    void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+} // namespace
+
+AllocationCounter::AllocationCounter() {
+    g_allocation_count = 0;
+    g_count_allocations = true;
+}
+
+AllocationCounter::~AllocationCounter() {
+    g_count_allocations = false;
+}
+
+uint64_t AllocationCounter::count() const {
+    return g_allocation_count.load();
+}
+
+void* operator new(size_t size) { return counted_malloc(size); }
+void* operator new[](size_t size) { return counted_malloc(size); }
+void* operator new(size_t size, std::align_val_t al) { return counted_aligned_malloc(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al) { return counted_aligned_malloc(size, static_cast<size_t>(al)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts global operator new calls made on the calling thread while an
+// instance lives, so gtest's own bookkeeping on other threads is ignored.
+// allocation_counter.cpp replaces the global operator new/delete and is
+// linked only into test_allocations.
+class AllocationCounter {
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    uint64_t count() const;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Shared by the option pricing tests: a fixed valuation instant, the
+// instrument ids the fixtures use and textbook reference prices to check
+// the engines against.
+namespace option_test {
+
+inline constexpr int64_t kDay = 86400000000000LL;
+inline constexpr int64_t kNow = 1750000000LL * 1000000000LL;
+inline constexpr uint64_t kNifty = 26000;
+inline constexpr uint64_t kNiftyFuture = 35001;
+
+inline double cdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+// Undiscounted Black price on the forward
+inline double black(double forward, double strike, double tau, double vol, bool put) {
+    const double sd = vol * std::sqrt(tau);
+    const double d1 = (std::log(forward / strike) + 0.5 * sd * sd) / sd;
+    const double d2 = d1 - sd;
+    return put ? strike * cdf(-d2) - forward * cdf(-d1) : forward * cdf(d1) - strike * cdf(d2);
+}
+
+// Black-Scholes price of an option on a spot paying no yield
+inline double black_scholes(bool call, double spot, double strike, double tau, double vol, double rate) {
+    return std::exp(-rate * tau) * black(spot * std::exp(rate * tau), strike, tau, vol, !call);
+}
+
+} // namespace option_test
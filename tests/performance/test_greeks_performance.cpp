@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "../../src/risk/greeks_engine.hpp"
+#include "../option_test_utils.hpp"
+
+using namespace goldearn::risk;
+using namespace option_test;
+
+// A full F&O book: NIFTY and BANKNIFTY weeklies and monthlies plus stock
+// options, 50k contracts. Full-chain recompute (the valuation time rolls)
+// against the usual tick: one underlying moves.
+TEST(GreeksPerformanceTest, FullChainRecompute) {
+    constexpr size_t kContracts = 50000;
+    // A few ms; the budget leaves room for slow CI machines
+    constexpr double kBudgetMs = 20.0;
+
+    std::vector<GreeksEngine::Contract> contracts;
+    contracts.reserve(kContracts);
+    uint64_t id = 1000000;
+    for (uint64_t underlying = 1; contracts.size() < kContracts; ++underlying) {
+        const double spot = underlying <= 2 ? 24000.0 * underlying : 500.0 + 37.0 * underlying;
+        const auto model = underlying % 3 == 0 ? GreeksEngine::Model::BLACK_76 : GreeksEngine::Model::BLACK_SCHOLES;
+        const int strikes = underlying <= 2 ? 200 : 40;
+        for (int64_t days : {2, 9, 16, 30, 58, 86}) {
+            for (int k = -strikes / 2; k < strikes / 2 && contracts.size() < kContracts; ++k) {
+                for (auto type : {GreeksEngine::OptionType::CALL, GreeksEngine::OptionType::PUT}) {
+                    GreeksEngine::Contract c;
+                    c.contract_id = id++;
+                    c.underlying_id = underlying;
+                    c.type = type;
+                    c.model = model;
+                    c.strike = spot * (1.0 + 0.005 * k);
+                    c.expiry_ns = kNow + days * kDay;
+                    c.multiplier = underlying <= 2 ? 75 : 500;
+                    contracts.push_back(c);
+                }
+            }
+        }
+    }
+    contracts.resize(kContracts);
+
+    GreeksEngine engine;
+    engine.add_contracts(contracts);
+    std::vector<uint64_t> underlyings;
+    for (const auto& c : contracts) {
+        if (underlyings.empty() || underlyings.back() != c.underlying_id) {
+            underlyings.push_back(c.underlying_id);
+            engine.set_underlying_price(c.underlying_id, c.underlying_id <= 2 ? 24000.0 * c.underlying_id
+                                                                               : 500.0 + 37.0 * c.underlying_id);
+            engine.set_underlying_volatility(c.underlying_id, 0.12 + 0.001 * (c.underlying_id % 100));
+        }
+        engine.set_position(c.contract_id, static_cast<double>(c.contract_id % 7) - 3.0);
+    }
+    engine.set_valuation_time(kNow);
+    engine.recompute(); // Warm up
+
+    constexpr int kRounds = 50;
+    std::vector<double> full_us;
+    for (int round = 0; round < kRounds; ++round) {
+        engine.set_valuation_time(kNow + round * 1000000000LL);
+        ASSERT_GE(engine.recompute(), kContracts);
+        full_us.push_back(engine.get_stats().last_elapsed_us);
+    }
+    std::sort(full_us.begin(), full_us.end());
+    const double full_ms = full_us[kRounds / 2] / 1000.0;
+
+    // NIFTY ticks: one chain of 2400
+    std::vector<double> tick_us;
+    for (int round = 0; round < kRounds; ++round) {
+        engine.set_underlying_price(1, 24000.0 + round);
+        const size_t repriced = engine.recompute();
+        ASSERT_LT(repriced, kContracts / 10);
+        tick_us.push_back(engine.get_stats().last_elapsed_us);
+    }
+    std::sort(tick_us.begin(), tick_us.end());
+
+    const auto nifty = engine.sensitivities(1);
+    std::cout << "Greeks full recompute, " << kContracts << " contracts on " << underlyings.size()
+              << " underlyings: " << full_ms << "ms median (" << full_ms * 1e6 / kContracts << "ns per contract)"
+              << std::endl;
+    std::cout << "Greeks NIFTY tick: " << tick_us[kRounds / 2] << "us median; NIFTY delta notional "
+              << nifty.delta_notional() << ", vega " << nifty.vega << std::endl;
+    EXPECT_LT(full_ms, kBudgetMs);
+    EXPECT_LT(tick_us[kRounds / 2] * 5.0, full_us[kRounds / 2]);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../../src/trading/kill_switch.hpp"
+
+using namespace goldearn::trading;
+
+namespace {
+
+// Stands in for a session's socket: the write is a copy into its send buffer
+struct SinkSession {
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(4 << 20);
+    size_t used = 0;
+    size_t writes = 0;
+
+    size_t write(const uint8_t* data, size_t length) {
+        if (used + length > buffer.size()) used = 0;
+        std::memcpy(buffer.data() + used, data, length);
+        used += length;
+        ++writes;
+        return length;
+    }
+};
+
+} // namespace
+
+// Trigger to last cancel with 30k orders live over three venues, after a
+// day's churn of orders going live and completing in random order; batched
+// writes against one write per cancel. The gateway bracket and the live-order
+// upkeep are what every order pays, and are timed too.
+TEST(KillSwitchPerformanceTest, TriggerToLastCancel) {
+    constexpr size_t kVenues = 3;
+    constexpr size_t kLivePerVenue = 10000;
+    constexpr size_t kChurn = 200000;
+    constexpr int kRounds = 21;
+    // About 150us on one core, bound by the sessions' copies; the budget
+    // leaves room for slow CI machines
+    constexpr double kBudgetUs = 2000.0;
+    constexpr double kBudgetUpkeepNs = 500.0;
+
+    auto run = [&](size_t burst_bytes, double& upkeep_ns) {
+        KillSwitch::Config config;
+        config.burst_bytes = burst_bytes;
+        KillSwitch kill_switch(config);
+        std::vector<SinkSession> sessions(kVenues);
+        for (size_t v = 0; v < kVenues; ++v) {
+            kill_switch.add_venue({"venue" + std::to_string(v),
+                                   [&sessions, v](const uint8_t* d, size_t n) { return sessions[v].write(d, n); },
+                                   nullptr});
+        }
+
+        // Churn: orders go live and complete in random order
+        std::mt19937_64 rng(5);
+        std::vector<KillSwitch::Handle> live;
+        live.reserve(kVenues * kLivePerVenue);
+        Order order{};
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kChurn; ++i) {
+            order.client_order_id = i;
+            order.symbol_id = i % 500;
+            if (live.size() == kVenues * kLivePerVenue) {
+                const size_t victim = rng() % live.size();
+                kill_switch.on_order_done(live[victim]);
+                live[victim] = live.back();
+                live.pop_back();
+            }
+            if (kill_switch.begin_submit()) {
+                live.push_back(kill_switch.on_order_live(static_cast<uint32_t>(i % kVenues), order));
+                kill_switch.end_submit();
+            }
+        }
+        upkeep_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    kChurn;
+
+        std::vector<double> us;
+        size_t cancels = 0;
+        for (int round = 0; round < kRounds; ++round) {
+            const auto result = kill_switch.trip("benchmark");
+            cancels = result.cancels_sent;
+            us.push_back(result.trigger_to_last_cancel_ns / 1000.0);
+            kill_switch.reset();
+        }
+        std::sort(us.begin(), us.end());
+        EXPECT_EQ(cancels, kVenues * kLivePerVenue);
+        return us[kRounds / 2];
+    };
+
+    double upkeep_ns = 0.0;
+    double unused = 0.0;
+    const double batched_us = run(KillSwitch::Config{}.burst_bytes, upkeep_ns);
+    const double single_us = run(sizeof(CancelMessage), unused);
+
+    std::cout << "Kill switch, " << kVenues * kLivePerVenue << " live orders on " << kVenues
+              << " venues: trigger to last cancel " << batched_us << "us batched, " << single_us
+              << "us one write per cancel; gateway and live-order upkeep " << upkeep_ns << "ns per order" << std::endl;
+    EXPECT_LT(batched_us, kBudgetUs);
+    EXPECT_LT(upkeep_ns, kBudgetUpkeepNs);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../../src/utils/logger.hpp"
+
+using namespace goldearn::utils;
+
+// Per-call cost of LOG_* on the calling thread. Formats are checked and laid
+// out at compile time, so the hot path is a level check, a ring reservation
+// and a memcpy of the arguments; formatting happens on the logger thread.
+// Figures are reported rather than held to nanosecond budgets, which shared
+// CI machines cannot honour; only relative costs and drops are checked.
+class LoggingPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr int kBatch = 10000;
+    static constexpr int kBatches = 20;
+
+    void SetUp() override {
+        Logger::instance().set_console_output(false);
+        Logger::instance().set_file_output("/dev/null");
+        Logger::instance().set_level(LogLevel::INFO);
+        Logger::instance().set_ring_capacity(8 * 1024 * 1024);
+    }
+
+    void TearDown() override {
+        Logger::instance().flush();
+        Logger::instance().set_ring_capacity(256 * 1024);
+        Logger::instance().set_console_output(true);
+    }
+
+    // Average nanoseconds per call; the ring is drained between batches so
+    // the measurement never hits the drop path. Runs on a new thread: a
+    // thread's ring is sized on its first log call, so the test thread's may
+    // predate set_ring_capacity().
+    template<typename F>
+    double measure_per_call_ns(F&& log_call) {
+        double total_ns = 0;
+        std::thread([&]() {
+            for (int batch = 0; batch < kBatches; ++batch) {
+                Logger::instance().flush();
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < kBatch; ++i) {
+                    log_call(i);
+                }
+                auto end = std::chrono::steady_clock::now();
+                total_ns += std::chrono::duration<double, std::nano>(end - start).count();
+            }
+        }).join();
+        return total_ns / (kBatch * kBatches);
+    }
+};
+
+TEST_F(LoggingPerformanceTest, PerCallCostByArgumentCount) {
+    uint64_t dropped_before = Logger::instance().get_messages_dropped();
+    std::string symbol = "RELIANCE";
+
+    double zero = measure_per_call_ns([](int) { LOG_INFO("Heartbeat"); });
+    double one = measure_per_call_ns([](int i) { LOG_INFO("Order {} acknowledged", i); });
+    double two = measure_per_call_ns([](int i) { LOG_INFO("Order {} filled at {:.2f}", i, 2450.5); });
+    double four = measure_per_call_ns([&](int i) {
+        LOG_INFO("Order {} {} qty {} px {:.2f}", i, symbol, 100u, 2450.5);
+    });
+    double disabled = measure_per_call_ns([](int i) { LOG_DEBUG("Filtered {} {}", i, 1.0); });
+
+    std::cout << "LOG_INFO per-call cost: 0 args " << zero << "ns, 1 arg " << one << "ns, 2 args " << two
+              << "ns, 4 args " << four << "ns, filtered " << disabled << "ns" << std::endl;
+
+    EXPECT_EQ(Logger::instance().get_messages_dropped(), dropped_before);
+    EXPECT_LT(disabled, four);
+}
+
+TEST_F(LoggingPerformanceTest, FastLogPerCallCost) {
+    std::string path = "/tmp/goldearn_fast_log_bench_" + std::to_string(::getpid()) + ".bin";
+    ASSERT_TRUE(Logger::instance().set_fast_log_file(path, 64 * 1024 * 1024));
+
+    // No flushing needed: the mapped file wraps instead of dropping
+    double zero = measure_per_call_ns([](int) { LOG_FAST(LogLevel::INFO, "Heartbeat"); });
+    double four = measure_per_call_ns([](int i) {
+        LOG_FAST(LogLevel::INFO, "Order {} qty {} px {:.2f} side {}", i, 100u, 2450.5, 1);
+    });
+
+    Logger::instance().set_fast_log_file("");
+    std::remove(path.c_str());
+
+    std::cout << "LOG_FAST per-call cost: 0 args " << zero << "ns, 4 args " << four << "ns" << std::endl;
+}
+
+TEST_F(LoggingPerformanceTest, DeferredIsCheaperThanEagerFormatting) {
+    std::string symbol = "RELIANCE";
+
+    double deferred = measure_per_call_ns([&](int i) {
+        LOG_INFO("Order {} {} qty {} px {:.2f}", i, symbol, 100u, 2450.5);
+    });
+
+    // Reference: what a formatting logger pays on the calling thread
+    std::vector<std::string> sink;
+    sink.reserve(kBatch);
+    double eager = measure_per_call_ns([&](int i) {
+        if (sink.size() == kBatch) sink.clear();
+        std::ostringstream oss;
+        oss.precision(2);
+        oss << "Order " << i << " " << symbol << " qty " << 100u << " px " << std::fixed << 2450.5;
+        sink.push_back(oss.str());
+    });
+
+    std::cout << "Deferred LOG_INFO " << deferred << "ns vs eager ostringstream " << eager << "ns per call"
+              << std::endl;
+    EXPECT_LT(deferred, eager);
+}
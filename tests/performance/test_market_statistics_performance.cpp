@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "../../src/market_data/market_statistics.hpp"
+
+using namespace goldearn::market_data;
+
+// One sample (returns, rank-1 update, publish) against the sampling interval,
+// on a single core, at the target universe size and beyond
+TEST(MarketStatisticsPerformanceTest, SampleFitsTheInterval) {
+    for (size_t symbols : {500, 2000}) {
+        std::vector<uint64_t> universe(symbols);
+        for (size_t i = 0; i < symbols; ++i) {
+            universe[i] = 100000 + i;
+        }
+        MarketStatistics statistics(MarketStatistics::Config{universe, std::chrono::milliseconds(100), 0.97});
+
+        std::vector<double> prices(symbols, 100.0);
+        constexpr int kSamples = 200;
+        uint32_t x = 7;
+        double total_ns = 0.0;
+        double max_ns = 0.0;
+        for (int sample = 0; sample <= kSamples; ++sample) {
+            for (size_t i = 0; i < symbols; ++i) {
+                x = x * 1664525 + 1013904223;
+                prices[i] *= 1.0 + ((x >> 8) % 2001 - 1000.0) * 1e-6;
+                statistics.on_price(universe[i], prices[i]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            statistics.sample();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (sample > 0) { // The first only records prices
+                total_ns += ns;
+                max_ns = std::max(max_ns, ns);
+            }
+        }
+
+        const double mean_us = total_ns / kSamples / 1000.0;
+        std::cout << "EWMA covariance " << symbols << " symbols: sample mean " << mean_us << "us, max "
+                  << max_ns / 1000.0 << "us (" << 100000.0 / mean_us << "x headroom in 100ms)" << std::endl;
+        EXPECT_EQ(statistics.snapshot().samples(), static_cast<uint64_t>(kSamples));
+        if (symbols == 500) {
+            EXPECT_LT(max_ns, 100e6);
+            EXPECT_LT(mean_us, 10000.0);
+        }
+    }
+}
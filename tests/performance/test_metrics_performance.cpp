@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../src/monitoring/prometheus_metrics.hpp"
+#include "../../src/utils/logger.hpp"
+
+using namespace goldearn::monitoring;
+
+// Contention benchmark: 8 writer threads observing into one metric, as the
+// feed and order threads do on every event
+class MetricsPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr int kWriters = 8;
+    static constexpr int kObservationsPerWriter = 200000;
+
+    // Mutex + linear scan: the previous Histogram::observe
+    struct LockedHistogram {
+        std::mutex mutex;
+        std::vector<double> buckets{1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+        std::vector<uint64_t> counts = std::vector<uint64_t>(12, 0);
+        uint64_t count = 0;
+        double sum = 0;
+
+        void observe(double value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+            sum += value;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                if (value <= buckets[i]) counts[i]++;
+            }
+        }
+    };
+
+    // Mutex + bounded sample vector: the previous Summary::observe
+    struct LockedSummary {
+        std::mutex mutex;
+        std::vector<double> samples;
+        uint64_t count = 0;
+        double sum = 0;
+
+        void observe(double value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+            sum += value;
+            samples.push_back(value);
+            if (samples.size() > 1000) samples.erase(samples.begin());
+        }
+    };
+
+    // Average nanoseconds per observation across all writers (wall time)
+    template<typename Observe>
+    double run_writers(Observe&& observe) {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> writers;
+        for (int t = 0; t < kWriters; ++t) {
+            writers.emplace_back([&, t]() {
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                double value = 1.0 + t;
+                for (int i = 0; i < kObservationsPerWriter; ++i) {
+                    observe(value);
+                    value = value < 8000.0 ? value * 1.37 : 1.0 + t;
+                }
+            });
+        }
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& writer : writers) writer.join();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() /
+               (static_cast<double>(kWriters) * kObservationsPerWriter);
+    }
+};
+
+TEST_F(MetricsPerformanceTest, ShardedHistogramUnderContention) {
+    Histogram sharded("bench_histogram", "bench", {1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000});
+    LockedHistogram locked;
+
+    double sharded_ns = run_writers([&](double v) { sharded.observe(v); });
+    double locked_ns = run_writers([&](double v) { locked.observe(v); });
+
+    LOG_INFO("Histogram observe with {} writers: sharded {:.1f}ns, mutex {:.1f}ns per observation",
+             kWriters, sharded_ns, locked_ns);
+
+    EXPECT_EQ(sharded.snapshot().count, static_cast<uint64_t>(kWriters) * kObservationsPerWriter);
+    EXPECT_LT(sharded_ns, locked_ns);
+}
+
+TEST_F(MetricsPerformanceTest, StreamingSummaryUnderContention) {
+    Summary streaming("bench_summary", "bench");
+    LockedSummary locked;
+
+    double streaming_ns = run_writers([&](double v) { streaming.observe(v); });
+    double locked_ns = run_writers([&](double v) { locked.observe(v); });
+
+    auto start = std::chrono::steady_clock::now();
+    double p99 = streaming.quantile(0.99);
+    auto scrape_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    LOG_INFO("Summary observe with {} writers: streaming {:.1f}ns, mutex {:.1f}ns per observation; "
+             "quantile scrape {:.1f}us (p99={:.1f})", kWriters, streaming_ns, locked_ns, scrape_us, p99);
+
+    EXPECT_EQ(streaming.count(), static_cast<uint64_t>(kWriters) * kObservationsPerWriter);
+    EXPECT_LT(streaming_ns, locked_ns);
+}
+
+TEST_F(MetricsPerformanceTest, ScrapeTenThousandSeries) {
+    // 100 families x 100 symbols; a typical scrape interval touches a few
+    auto& registry = MetricsRegistry::instance();
+    constexpr int kFamilies = 100;
+    constexpr int kSymbols = 100;
+    std::vector<std::shared_ptr<MetricFamily<Counter>>> families;
+    std::vector<std::shared_ptr<Counter>> series;
+    for (int f = 0; f < kFamilies; ++f) {
+        auto family = registry.create_counter_family("bench_scrape_" + std::to_string(f) + "_total",
+                                                     "Scrape benchmark", {"symbol"});
+        for (int s = 0; s < kSymbols; ++s) {
+            series.push_back(family->with_labels({"SYM" + std::to_string(s)}));
+            series.back()->increment(s);
+        }
+        families.push_back(family);
+    }
+
+    std::string buffer;
+    auto time_scrape_us = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        registry.serialize_all(buffer);
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double first_us = time_scrape_us();   // Every family dirty
+    double clean_us = time_scrape_us();   // Nothing changed
+    double partial_us = 0;
+    constexpr int kRounds = 20;
+    for (int round = 0; round < kRounds; ++round) {
+        for (int f = 0; f < 5; ++f) {
+            series[((round * 5 + f) % kFamilies) * kSymbols + round % kSymbols]->increment();
+        }
+        partial_us += time_scrape_us();
+    }
+    partial_us /= kRounds;
+
+    LOG_INFO("Scrape of {} series ({} bytes): all dirty {:.1f}us, clean {:.1f}us, 5% dirty {:.1f}us",
+             kFamilies * kSymbols, buffer.size(), first_us, clean_us, partial_us);
+
+    EXPECT_NE(buffer.find("bench_scrape_99_total{symbol=\"SYM99\"} 99\n"), std::string::npos);
+    EXPECT_LT(clean_us, first_us);
+    EXPECT_LT(partial_us, first_us);
+
+    for (int f = 0; f < kFamilies; ++f) {
+        registry.remove_metric("bench_scrape_" + std::to_string(f) + "_total");
+    }
+}
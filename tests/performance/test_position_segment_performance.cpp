@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../../src/trading/position_segment.hpp"
+
+using namespace goldearn::trading;
+
+namespace {
+
+PositionSegment::Config perf_config() {
+    PositionSegment::Config config;
+    config.name = "goldearn_positions_perf_" + std::to_string(::getpid());
+    config.capacity = 4096;
+    config.heartbeat_interval = std::chrono::milliseconds(0);
+    return config;
+}
+
+} // namespace
+
+// What a position update pays to publish, alone and with the monitor polling
+// on another thread; and how far behind the monitor's view runs
+TEST(PositionSegmentPerformanceTest, PublishCostAndStaleness) {
+    constexpr uint32_t kPositions = 2000;
+    constexpr uint64_t kUpdates = 1000000;
+    // About 70ns on one core; the budget leaves room for slow CI machines.
+    // With a single core the poller's time lands in the writer's wall clock,
+    // so the polled figure is only held to the budget with a core to spare.
+    constexpr double kBudgetPublishNs = 250.0;
+    constexpr double kBudgetMeanAgeUs = 5000.0;
+
+    PositionSegment segment(perf_config());
+    std::vector<uint32_t> slots;
+    for (uint32_t i = 0; i < kPositions; ++i) {
+        slots.push_back(segment.add_position("strategy" + std::to_string(i % 8), i));
+    }
+    position_layout::PositionValues values;
+
+    auto publish_all = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t n = 0; n < kUpdates; ++n) {
+            values.quantity = static_cast<double>(n);
+            values.trades = n;
+            segment.publish(slots[n % kPositions], values);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+               kUpdates;
+    };
+
+    const double alone_ns = publish_all();
+
+    PositionFeedReader reader(perf_config().name);
+    std::atomic<bool> stop{false};
+    std::thread monitor([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (reader.poll() == 0) std::this_thread::yield();
+        }
+        reader.poll();
+    });
+    const double polled_ns = publish_all();
+    stop = true;
+    monitor.join();
+
+    const auto staleness = reader.staleness();
+    std::cout << "Position segment, " << kPositions << " positions: publish " << alone_ns << "ns alone, "
+              << polled_ns << "ns with the monitor polling; monitor read " << staleness.records_read
+              << " records in " << staleness.polls << " polls (" << staleness.overruns << " overruns, "
+              << staleness.seqlock_retries << " retries), publish to observe "
+              << staleness.mean_record_age_ns / 1000.0 << "us mean, "
+              << staleness.max_record_age_ns / 1000.0 << "us max" << std::endl;
+
+    EXPECT_EQ(staleness.journal_lag, 0u);
+    EXPECT_LT(alone_ns, kBudgetPublishNs);
+    if (std::thread::hardware_concurrency() > 1) {
+        EXPECT_LT(polled_ns, kBudgetPublishNs);
+    }
+    EXPECT_LT(staleness.mean_record_age_ns / 1000.0, kBudgetMeanAgeUs);
+}
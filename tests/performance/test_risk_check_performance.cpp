@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../../src/risk/greeks_engine.hpp"
+#include "../../src/risk/incremental_var.hpp"
+#include "../../src/risk/risk_engine.hpp"
+#include "../../src/risk/risk_state_table.hpp"
+#include "../../src/risk/span_margin.hpp"
+#include "../../src/utils/logger.hpp"
+
+using namespace goldearn::risk;
+using goldearn::trading::OrderSide;
+
+// Per-check latency of the flat risk-state table against the sequential
+// RiskEngine checks, over a book of strategies and symbols larger than L1
+class RiskCheckPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr uint32_t kStrategies = 8;
+    static constexpr uint32_t kSymbols = 1024;
+    static constexpr int kChecks = 200000;
+
+    void SetUp() override {
+        RiskLimits limits;
+        limits.max_orders_per_second = 1000;
+        limits.max_orders_per_minute = 1000;
+        table.apply_limits(limits);
+        for (uint32_t s = 0; s < kStrategies; ++s) {
+            table.add_strategy("strategy_" + std::to_string(s));
+        }
+        for (uint32_t i = 0; i < kSymbols; ++i) {
+            uint32_t symbol = table.add_symbol(1000 + i);
+            table.set_price_band(symbol, 50.0, 150.0);
+        }
+
+        // Calibrate the TSC against steady_clock
+        auto wall_start = std::chrono::steady_clock::now();
+        uint64_t tsc_start = goldearn::utils::log_detail::read_tsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t ticks = goldearn::utils::log_detail::read_tsc() - tsc_start;
+        ns_per_tick_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start).count() /
+                       static_cast<double>(ticks);
+    }
+
+    template<typename Check>
+    std::vector<double> measure(Check&& check, int checks = kChecks) {
+        std::vector<double> samples;
+        samples.reserve(checks);
+        uint32_t x = 12345;
+        for (int i = 0; i < checks; ++i) {
+            x = x * 1664525 + 1013904223; // Scattered strategy/symbol pairs
+            uint64_t start = goldearn::utils::log_detail::read_tsc();
+            check(x % kStrategies, (x >> 8) % kSymbols, i);
+            samples.push_back(static_cast<double>(goldearn::utils::log_detail::read_tsc() - start) * ns_per_tick_);
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples;
+    }
+
+    static double percentile(const std::vector<double>& sorted, double p) {
+        return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+    }
+
+    RiskStateTable table{kStrategies, kSymbols};
+    double ns_per_tick_ = 1.0;
+};
+
+TEST_F(RiskCheckPerformanceTest, CombinedCheckUnderOneMicrosecondAtP99) {
+    uint64_t approved = 0;
+    auto samples = measure([&](uint32_t strategy, uint32_t symbol, int i) {
+        // Sixty seconds between checks of a strategy keeps the rate windows open
+        uint64_t now = 1000000000000ULL + static_cast<uint64_t>(i) * 60000000000ULL;
+        approved += table.check_order(strategy, symbol, i & 1 ? OrderSide::BUY : OrderSide::SELL, 100.0, 10, now) ==
+                    RiskCheckResult::APPROVED;
+    });
+    EXPECT_EQ(approved, static_cast<uint64_t>(kChecks));
+
+    double p50 = percentile(samples, 0.50);
+    double p99 = percentile(samples, 0.99);
+    std::cout << "Risk-state table check: p50 " << p50 << "ns, p99 " << p99 << "ns, p99.9 "
+              << percentile(samples, 0.999) << "ns" << std::endl;
+    EXPECT_LT(p99, 1000.0);
+}
+
+TEST_F(RiskCheckPerformanceTest, SequentialChecksForComparison) {
+    RiskEngine engine;
+    goldearn::trading::Order order{};
+    order.side = OrderSide::BUY;
+    order.price = 100.0;
+    order.quantity = 10;
+    PreTradeContext context;
+    context.order = &order;
+
+    auto samples = measure([&](uint32_t strategy, uint32_t symbol, int) {
+        order.symbol_id = 1000 + symbol;
+        engine.check_pre_trade_risk(context);
+    });
+    std::cout << "Sequential RiskEngine checks: p50 " << percentile(samples, 0.50) << "ns, p99 "
+              << percentile(samples, 0.99) << "ns" << std::endl;
+}
+
+// The whole RiskEngine::check_pre_trade_risk on registered strategies and
+// symbols with every add-on limit live: a VaR model over the book, option
+// Greeks and SPAN margin. Futures and options are a slice of the symbols.
+// The engine checks on the real clock, so the run stays inside what the
+// rate windows admit.
+TEST_F(RiskCheckPerformanceTest, EndToEndCheckOnRegisteredSymbols) {
+    constexpr uint32_t kContracts = 64;
+    constexpr int kEngineChecks = kStrategies * RiskStateTable::RATE_WINDOW * 3 / 4;
+    const int64_t now = 1750000000LL * 1000000000LL;
+    RiskEngine engine;
+    RiskLimits limits;
+    limits.max_orders_per_second = RiskStateTable::RATE_WINDOW;
+    limits.max_orders_per_minute = RiskStateTable::RATE_WINDOW;
+    engine.set_risk_limits(limits);
+    for (uint32_t s = 0; s < kStrategies; ++s) {
+        engine.register_strategy("strategy_" + std::to_string(s));
+    }
+
+    std::vector<uint64_t> universe;
+    std::vector<double> volatilities;
+    for (uint32_t i = 0; i < kSymbols; ++i) {
+        engine.register_symbol(1000 + i);
+        universe.push_back(1000 + i);
+        volatilities.push_back(0.01 + 0.00001 * i);
+    }
+    std::vector<double> correlation(static_cast<size_t>(kSymbols) * kSymbols, 0.3);
+    for (uint32_t i = 0; i < kSymbols; ++i) {
+        correlation[static_cast<size_t>(i) * kSymbols + i] = 1.0;
+    }
+    engine.portfolio_var().set_model(universe, volatilities, correlation);
+
+    // Calls and futures on one index among the last symbols
+    GreeksEngine& greeks = engine.greeks();
+    SpanMargin& span = engine.margin();
+    for (uint32_t i = 0; i < kContracts; ++i) {
+        GreeksEngine::Contract call;
+        call.contract_id = 1000 + kSymbols - 2 * kContracts + i;
+        call.underlying_id = 26000;
+        call.strike = 95.0 + i % 10;
+        call.expiry_ns = now + 7 * 86400000000000LL;
+        call.multiplier = 75;
+        greeks.add_contract(call);
+
+        SpanMargin::Contract future;
+        future.contract_id = 1000 + kSymbols - kContracts + i;
+        future.underlying_id = 26000;
+        future.expiry_ns = now + 30 * 86400000000000LL;
+        future.multiplier = 75;
+        span.add_contract(future);
+    }
+    greeks.set_valuation_time(now);
+    greeks.set_underlying_price(26000, 100.0);
+    greeks.set_underlying_volatility(26000, 0.14);
+    greeks.recompute();
+    span.load_risk_parameters({{26000, 100.0, 0.06, 0.04, 0.14, 0.0, 0.0}}, now);
+
+    goldearn::trading::Order order{};
+    order.price = 100.0;
+    order.quantity = 10;
+    PreTradeContext context;
+    context.order = &order;
+    std::vector<std::string> strategy_ids;
+    for (uint32_t s = 0; s < kStrategies; ++s) {
+        strategy_ids.push_back("strategy_" + std::to_string(s));
+    }
+
+    uint64_t approved = 0;
+    auto samples = measure([&](uint32_t strategy, uint32_t symbol, int i) {
+        order.strategy_id = strategy_ids[strategy];
+        order.symbol_id = 1000 + symbol;
+        order.side = i & 1 ? OrderSide::BUY : OrderSide::SELL;
+        approved += engine.check_pre_trade_risk(context) == RiskCheckResult::APPROVED;
+    }, kEngineChecks);
+    EXPECT_EQ(approved, static_cast<uint64_t>(kEngineChecks));
+    std::cout << "End-to-end RiskEngine check, registered: p50 " << percentile(samples, 0.50) << "ns, p99 "
+              << percentile(samples, 0.99) << "ns, p99.9 " << percentile(samples, 0.999) << "ns" << std::endl;
+    EXPECT_LT(percentile(samples, 0.50), 20000.0);
+}
+
+// A 200-order basket: one SoA batch check against the per-order quick checks
+TEST_F(RiskCheckPerformanceTest, BatchCheckAgainstPerOrderChecks) {
+    constexpr size_t kOrders = 200;
+    constexpr int kRounds = 20000;
+    RiskLimits limits;
+    FastPreTradeChecker checker(limits);
+
+    OrderBatch batch;
+    std::vector<uint64_t> symbols;
+    std::vector<double> quantities, prices, positions;
+    for (size_t i = 0; i < kOrders; ++i) {
+        symbols.push_back(1000 + i);
+        quantities.push_back(static_cast<double>(100 + i));
+        prices.push_back(100.0 + static_cast<double>(i % 50));
+        positions.push_back(static_cast<double>(i * 10));
+    }
+    std::vector<uint8_t> approved(kOrders);
+
+    size_t batch_approved = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        batch.clear();
+        for (size_t i = 0; i < kOrders; ++i) {
+            batch.add(symbols[i], OrderSide::BUY, prices[i], quantities[i], positions[i]);
+        }
+        batch_approved += checker.check_batch(batch, 1000000.0, approved.data());
+    }
+    double batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                      (static_cast<double>(kRounds) * kOrders);
+
+    // The kernel alone, on an already built batch
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        batch_approved += checker.check_batch(batch, 1000000.0, approved.data());
+    }
+    double kernel_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                       (static_cast<double>(kRounds) * kOrders);
+
+    size_t single_approved = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        double exposure = 1000000.0;
+        for (size_t i = 0; i < kOrders; ++i) {
+            double value = quantities[i] * prices[i];
+            bool ok = checker.quick_order_size_check(value) &&
+                      checker.quick_position_check(symbols[i], quantities[i], positions[i]) &&
+                      checker.quick_exposure_check(value, exposure) && checker.quick_blacklist_check(symbols[i], "basket");
+            exposure += ok ? value : 0.0;
+            single_approved += ok;
+        }
+    }
+    double single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                       (static_cast<double>(kRounds) * kOrders);
+
+    EXPECT_EQ(batch_approved, 2 * single_approved);
+    std::cout << "Batch of " << kOrders << ": " << batch_ns << "ns/order including building it, " << kernel_ns
+              << "ns/order checking; per-order checks: " << single_ns << "ns/order" << std::endl;
+    EXPECT_LT(batch_ns, single_ns);
+}
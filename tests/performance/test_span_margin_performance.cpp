@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../../src/risk/span_margin.hpp"
+#include "../option_test_utils.hpp"
+
+using namespace goldearn::risk;
+using namespace option_test;
+
+// Per-order margin cost on a large F&O book: 50k contracts over 50
+// underlyings, one strategy holding 5000 of them. The pre-trade impact and
+// the fill update are one scenario vector add and a max each; a reload of
+// one underlying's parameters, which rebuilds the holdings, is timed for scale.
+TEST(SpanMarginPerformanceTest, IncrementalOrderMargin) {
+    constexpr size_t kContracts = 50000;
+    constexpr size_t kHoldings = 5000;
+    constexpr size_t kOrders = 200000;
+    // A few hundred ns, mostly cache misses on the contract and holding; the
+    // budget leaves room for slow CI machines
+    constexpr double kBudgetNs = 1000.0;
+
+    std::vector<SpanMargin::Contract> contracts;
+    std::vector<SpanMargin::RiskParameters> parameters;
+    contracts.reserve(kContracts);
+    uint64_t id = 1000000;
+    for (uint64_t underlying = 1; contracts.size() < kContracts; ++underlying) {
+        const double spot = underlying <= 2 ? 24000.0 * underlying : 500.0 + 37.0 * underlying;
+        parameters.push_back({underlying, spot, 0.06 + 0.0005 * (underlying % 40), 0.04, 0.2, 0.0, 0.01 * spot});
+        for (int64_t days : {2, 9, 30, 58, 86}) {
+            SpanMargin::Contract future;
+            future.contract_id = id++;
+            future.underlying_id = underlying;
+            future.expiry_ns = kNow + days * kDay;
+            future.multiplier = underlying <= 2 ? 75 : 500;
+            contracts.push_back(future);
+            for (int k = -50; k < 50; ++k) {
+                for (auto kind : {SpanMargin::Kind::CALL, SpanMargin::Kind::PUT}) {
+                    SpanMargin::Contract option = future;
+                    option.contract_id = id++;
+                    option.kind = kind;
+                    option.strike = spot * (1.0 + 0.005 * k);
+                    contracts.push_back(option);
+                }
+            }
+        }
+    }
+    contracts.resize(kContracts);
+
+    SpanMargin span;
+    span.add_contracts(contracts);
+    auto load_start = std::chrono::steady_clock::now();
+    span.load_risk_parameters(parameters, kNow);
+    const double load_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<size_t> pick(0, kContracts - 1);
+    std::uniform_int_distribution<int> lots(-10, 10);
+    for (size_t i = 0; i < kHoldings; ++i) {
+        span.on_fill("fno_book", contracts[pick(rng)].contract_id, lots(rng));
+    }
+
+    std::vector<uint64_t> order_ids(kOrders);
+    std::vector<double> order_quantity(kOrders);
+    for (size_t i = 0; i < kOrders; ++i) {
+        order_ids[i] = contracts[pick(rng)].contract_id;
+        order_quantity[i] = lots(rng);
+    }
+
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kOrders; ++i) {
+        sink += span.order_impact("fno_book", order_ids[i], order_quantity[i]).projected;
+    }
+    const double impact_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kOrders;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kOrders; ++i) {
+        span.add_order("fno_book", order_ids[i], order_quantity[i]);
+        span.remove_order("fno_book", order_ids[i], order_quantity[i]);
+    }
+    const double update_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (2 * kOrders);
+
+    // For scale: a new risk-parameter file rebuilds every holding's vectors
+    start = std::chrono::steady_clock::now();
+    span.load_risk_parameters({parameters[0]}, kNow);
+    const double rebuild_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    const auto margin = span.margin("fno_book");
+    std::cout << "SPAN margin, " << kContracts << " contracts on " << parameters.size() << " underlyings ("
+              << load_ms << "ms to load the risk parameters): order impact " << impact_ns << "ns, order add/remove "
+              << update_ns << "ns, one-underlying reload " << rebuild_us << "us; book margin " << margin.total
+              << " (checksum " << sink << ")" << std::endl;
+    EXPECT_GT(margin.total, 0.0);
+    EXPECT_LT(impact_ns, kBudgetNs);
+    EXPECT_LT(update_ns, kBudgetNs);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/risk/stress_engine.hpp"
+
+using namespace goldearn::risk;
+
+// The desk's grid: 10k scenarios (historical replays and factor shocks)
+// against 2k live positions, full product over thread counts and the
+// incremental path after a handful of fills
+TEST(StressPerformanceTest, ScenarioGridAgainstLivePositions) {
+    constexpr size_t kScenarios = 10000;
+    constexpr size_t kPositions = 2000;
+    // Re-evaluated every few seconds
+    constexpr double kBudgetMs = 1000.0;
+
+    std::vector<uint64_t> symbols(kPositions);
+    std::unordered_map<uint64_t, double> exposures;
+    for (size_t i = 0; i < kPositions; ++i) {
+        symbols[i] = 100000 + i;
+        exposures[symbols[i]] = (i % 4 == 0 ? -1.0 : 1.0) * (2e5 + 100.0 * i);
+    }
+    std::vector<std::string> names(kScenarios);
+    std::vector<double> shocks(kScenarios * kPositions);
+    uint32_t x = 1;
+    for (size_t s = 0; s < kScenarios; ++s) {
+        names[s] = "scenario_" + std::to_string(s);
+        // One market factor plus a sector and a name-specific move
+        x = x * 1664525 + 1013904223;
+        const double market = ((x >> 8) % 2001 - 1000.0) * 1e-4;
+        for (size_t i = 0; i < kPositions; ++i) {
+            x = x * 1664525 + 1013904223;
+            shocks[s * kPositions + i] = market * (0.5 + (i % 50) * 0.02) + ((x >> 8) % 2001 - 1000.0) * 2e-5;
+        }
+    }
+
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    double single_ms = 0.0;
+    std::vector<double> reference;
+    for (size_t threads : {1, 2, 4, 8}) {
+        if (threads > 1 && threads > cores) {
+            break;
+        }
+        StressEngine engine(StressEngine::Config{threads, {}, 512});
+        engine.set_scenarios(symbols, names, shocks);
+        engine.set_exposures(exposures);
+        engine.evaluate(); // Warm up the pages
+        engine.set_exposures({});
+        engine.set_exposures(exposures);
+        const auto& result = engine.evaluate();
+        ASSERT_FALSE(result.incremental);
+        if (threads == 1) {
+            single_ms = result.elapsed_ms;
+            reference = result.pnl;
+            EXPECT_LT(single_ms, kBudgetMs);
+        } else {
+            EXPECT_EQ(result.pnl, reference);
+        }
+        auto worst = std::min_element(result.pnl.begin(), result.pnl.end());
+        std::cout << "Stress grid " << kScenarios << " x " << kPositions << ", " << threads << " thread(s): "
+                  << result.elapsed_ms << "ms (" << single_ms / result.elapsed_ms << "x), worst scenario "
+                  << *worst << std::endl;
+
+        if (threads == 1) {
+            // A few fills between evaluations
+            constexpr int kRounds = 50;
+            double incremental_ms = 0.0;
+            for (int round = 0; round < kRounds; ++round) {
+                for (int fill = 0; fill < 5; ++fill) {
+                    x = x * 1664525 + 1013904223;
+                    const uint64_t symbol = symbols[(x >> 8) % kPositions];
+                    engine.set_exposure(symbol, engine.exposure(symbol) + ((x >> 4) % 2 ? 5e4 : -5e4));
+                }
+                const auto& updated = engine.evaluate();
+                ASSERT_TRUE(updated.incremental);
+                incremental_ms += updated.elapsed_ms;
+            }
+            incremental_ms /= kRounds;
+            std::cout << "Stress grid after 5 fills: " << incremental_ms * 1000.0 << "us ("
+                      << single_ms / incremental_ms << "x faster than the full product), "
+                      << engine.get_stats().rescanned_scenarios << " worst positions rescanned" << std::endl;
+            EXPECT_LT(incremental_ms * 10.0, single_ms);
+        }
+    }
+}
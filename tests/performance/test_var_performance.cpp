@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../../src/risk/incremental_var.hpp"
+#include "../../src/risk/var_engine.hpp"
+
+using namespace goldearn::risk;
+
+// Monte Carlo VaR at intraday-refresh size: 2000 instruments x 100k paths,
+// scaled over thread counts. Scaling only shows on hosts with the cores.
+class VaRPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t kInstruments = 2000;
+    static constexpr uint32_t kPaths = 100000;
+    // Intraday refresh budget for the full run on one thread
+    static constexpr double kBudgetMs = 10000.0;
+
+    void SetUp() override {
+        // Sector blocks of 50 names: 0.5 inside a sector, 0.2 across
+        correlation.assign(kInstruments * kInstruments, 0.2);
+        for (size_t i = 0; i < kInstruments; ++i) {
+            for (size_t j = 0; j < kInstruments; ++j) {
+                if (i == j) {
+                    correlation[i * kInstruments + j] = 1.0;
+                } else if (i / 50 == j / 50) {
+                    correlation[i * kInstruments + j] = 0.5;
+                }
+            }
+            exposures.delta.push_back((i % 4 == 0 ? -1.0 : 1.0) * (2e5 + 100.0 * i));
+            exposures.volatility.push_back(0.01 + 0.00001 * i);
+        }
+    }
+
+    std::vector<double> correlation;
+    MonteCarloVaREngine::Exposures exposures;
+};
+
+TEST_F(VaRPerformanceTest, LinearBookScalesAcrossThreads) {
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    double single_ms = 0.0;
+    MonteCarloVaREngine::Result reference;
+    for (size_t threads : {1, 2, 4, 8}) {
+        if (threads > 1 && threads > cores) {
+            break;
+        }
+        MonteCarloVaREngine engine(MonteCarloVaREngine::Config{threads, {}, 2024, 1024});
+        engine.set_correlation(correlation.data(), kInstruments);
+        if (threads == 1) {
+            std::cout << "Cholesky " << kInstruments << "x" << kInstruments << ": "
+                      << engine.last_factorization_ms() << "ms" << std::endl;
+        }
+        auto result = engine.run(exposures, 1, 0.01, kPaths);
+        if (threads == 1) {
+            single_ms = result.elapsed_ms;
+            reference = result;
+            EXPECT_LT(single_ms, kBudgetMs);
+        } else {
+            EXPECT_EQ(result.var, reference.var); // Same seed, same answer
+        }
+        std::cout << "MC VaR " << kInstruments << " x " << kPaths << " paths, " << threads << " thread(s): "
+                  << result.elapsed_ms << "ms (" << single_ms / result.elapsed_ms << "x), 99% VaR "
+                  << result.var << ", ES " << result.expected_shortfall << std::endl;
+    }
+
+    // Parametric cross-check of the sample
+    double variance = 0.0;
+    for (size_t i = 0; i < kInstruments; ++i) {
+        double row = 0.0;
+        for (size_t j = 0; j < kInstruments; ++j) {
+            row += correlation[i * kInstruments + j] * exposures.delta[j] * exposures.volatility[j];
+        }
+        variance += exposures.delta[i] * exposures.volatility[i] * row;
+    }
+    EXPECT_NEAR(reference.var / (2.3263478740408408 * std::sqrt(variance)), 1.0, 0.03);
+}
+
+TEST_F(VaRPerformanceTest, DeltaGammaBookFullRevaluation) {
+    // Every path needs the full triangular L*e: a quarter of the instruments
+    constexpr size_t kSubset = 500;
+    constexpr uint32_t kGammaPaths = 20000;
+    std::vector<double> subset(kSubset * kSubset);
+    MonteCarloVaREngine::Exposures book;
+    for (size_t i = 0; i < kSubset; ++i) {
+        std::copy_n(&correlation[i * kInstruments], kSubset, &subset[i * kSubset]);
+        book.delta.push_back(exposures.delta[i]);
+        book.gamma.push_back(-5.0 * exposures.delta[i]);
+        book.volatility.push_back(exposures.volatility[i]);
+    }
+
+    MonteCarloVaREngine engine(MonteCarloVaREngine::Config{1, {}, 2024, 256});
+    engine.set_correlation(subset.data(), kSubset);
+    auto result = engine.run(book, 1, 0.01, kGammaPaths);
+    double per_path_us = result.elapsed_ms * 1000.0 / kGammaPaths;
+    std::cout << "Delta-gamma MC " << kSubset << " x " << kGammaPaths << " paths: " << result.elapsed_ms
+              << "ms (" << per_path_us << "us/path), 99% VaR " << result.var << std::endl;
+    EXPECT_GT(result.var, 0.0);
+}
+
+// Reacting to a fill: O(n) update of S w against the O(n^2) rebuild, and the
+// O(1) pre-trade projection, over the same 2000-instrument book
+TEST_F(VaRPerformanceTest, IncrementalUpdateAgainstFullRecompute) {
+    std::vector<uint64_t> symbols(kInstruments);
+    for (size_t i = 0; i < kInstruments; ++i) {
+        symbols[i] = 100000 + i;
+    }
+    IncrementalVaR incremental;
+    incremental.set_model(symbols, exposures.volatility, correlation);
+    for (size_t i = 0; i < kInstruments; ++i) {
+        incremental.set_position(symbols[i], exposures.delta[i] / 100.0, 100.0);
+    }
+
+    constexpr int kFills = 20000;
+    uint32_t x = 99;
+    auto start = std::chrono::steady_clock::now();
+    for (int fill = 0; fill < kFills; ++fill) {
+        x = x * 1664525 + 1013904223;
+        incremental.on_fill(symbols[(x >> 8) % kInstruments], (x & 1) ? 10.0 : -10.0, 100.0);
+    }
+    double fill_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kFills;
+
+    double sink = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int check = 0; check < kFills; ++check) {
+        x = x * 1664525 + 1013904223;
+        sink += incremental.order_impact(symbols[(x >> 8) % kInstruments], 10.0, 100.0).projected;
+    }
+    double check_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kFills;
+
+    constexpr int kRecomputes = 20;
+    double drift = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRecomputes; ++i) {
+        drift = std::max(drift, incremental.recompute());
+    }
+    double recompute_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kRecomputes;
+
+    std::cout << "Incremental VaR, " << kInstruments << " instruments: fill " << fill_ns << "ns, pre-trade impact "
+              << check_ns << "ns, full recompute " << recompute_ns / 1000.0 << "us (" << recompute_ns / fill_ns
+              << "x a fill), drift after " << kFills << " fills " << drift << std::endl;
+    EXPECT_GT(sink, 0.0);
+    EXPECT_LT(fill_ns * 50.0, recompute_ns);
+    EXPECT_LT(check_ns, 1000.0);
+    EXPECT_LT(drift, 1e-9);
+}
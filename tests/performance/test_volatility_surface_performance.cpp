@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "../../src/market_data/volatility_surface.hpp"
+#include "../option_test_utils.hpp"
+
+using namespace goldearn::market_data;
+using namespace option_test;
+
+namespace {
+
+double skew(double k, double tau) {
+    const double u = k - 0.02;
+    return std::sqrt((0.01 + 0.1 * (-0.4 * u + std::sqrt(u * u + 0.0225))));
+}
+
+} // namespace
+
+// Raw solver throughput: a full chain's worth of options from cold starts
+// and from the previous solution, the way each refresh runs
+TEST(VolatilitySurfacePerformanceTest, ImpliedVolatilitySolves) {
+    constexpr size_t kOptions = 50000;
+    constexpr int kRounds = 20;
+    // A few million per second; the floor leaves room for slow CI machines
+    constexpr double kMinColdPerSecond = 0.5e6;
+
+    std::vector<double> forward(kOptions), strike(kOptions), tau(kOptions), sign(kOptions), price(kOptions);
+    for (size_t i = 0; i < kOptions; ++i) {
+        const double k = -0.3 + 0.6 * static_cast<double>(i % 200) / 200.0;
+        tau[i] = (2.0 + static_cast<double>(i % 6) * 15.0) / 365.0;
+        forward[i] = 24000.0;
+        strike[i] = 24000.0 * std::exp(k);
+        sign[i] = k >= 0.0 ? 1.0 : -1.0;
+        price[i] = black(forward[i], strike[i], tau[i], skew(k, tau[i]), k < 0.0);
+    }
+    std::vector<double> vol(kOptions), vega(kOptions);
+
+    auto run = [&](const double* guess) {
+        std::vector<double> ns;
+        size_t iterations = 0;
+        for (int round = 0; round < kRounds; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            iterations = implied_volatilities(forward.data(), strike.data(), tau.data(), sign.data(), price.data(),
+                                              guess, vol.data(), vega.data(), kOptions);
+            ns.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+        }
+        std::sort(ns.begin(), ns.end());
+        return std::make_pair(kOptions / (ns[kRounds / 2] * 1e-9), iterations);
+    };
+    const auto cold = run(nullptr);
+    std::vector<double> previous = vol;
+    const auto warm = run(previous.data());
+
+    size_t solved = 0;
+    for (double v : vol) solved += v > 0.0;
+    std::cout << "Implied volatility, " << kOptions << " options: " << cold.first / 1e6 << "M/s cold ("
+              << static_cast<double>(cold.second) / (kOptions / 4) << " iterations per block of four), "
+              << warm.first / 1e6 << "M/s warm (" << static_cast<double>(warm.second) / (kOptions / 4) << ")"
+              << std::endl;
+    EXPECT_EQ(solved, kOptions);
+    EXPECT_GT(cold.first, kMinColdPerSecond);
+    EXPECT_GT(warm.first, cold.first);
+}
+
+// Refresh latency per expiry: NIFTY weekly and monthly chains of 200
+// strikes a side; one underlying tick re-solves and refits every expiry
+TEST(VolatilitySurfacePerformanceTest, RefitPerExpiry) {
+    constexpr int kStrikes = 200;
+    constexpr int kRounds = 50;
+    constexpr double kBudgetUsPerExpiry = 500.0;
+    const std::vector<int64_t> expiries = {2, 9, 16, 30, 58, 86};
+
+    VolatilitySurfaceService::Config config;
+    uint64_t id = 1000000;
+    for (int64_t days : expiries) {
+        for (int i = 0; i < kStrikes; ++i) {
+            for (bool put : {false, true}) {
+                OptionContract option;
+                option.contract_id = id++;
+                option.underlying_id = 1;
+                option.expiry_ns = kNow + days * kDay;
+                option.strike = 24000.0 * (0.75 + 0.5 * i / kStrikes);
+                option.put = put;
+                config.options.push_back(option);
+            }
+        }
+    }
+    VolatilitySurfaceService service(config);
+
+    auto quote_chain = [&](double spot) {
+        service.on_price(1, spot);
+        for (const auto& option : config.options) {
+            const double tau = static_cast<double>(option.expiry_ns - kNow) / kDay / 365.0;
+            const double f = spot * std::exp(config.rate * tau);
+            const double premium = black(f, option.strike, tau, skew(std::log(option.strike / f), tau), option.put) *
+                                   std::exp(-config.rate * tau);
+            if (premium < 0.3) continue;
+            QuoteMessage quote{};
+            quote.symbol_id = option.contract_id;
+            quote.bid_price = premium - 0.05;
+            quote.ask_price = premium + 0.05;
+            if (quote.bid_price > 0.0) service.on_quote(quote);
+        }
+    };
+    quote_chain(24000.0);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(service.refresh(kNow), expiries.size());
+    const double cold_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> tick_us;
+    for (int round = 0; round < kRounds; ++round) {
+        quote_chain(24000.0 + 2.0 * (round % 10));
+        const auto before = service.get_stats();
+        ASSERT_EQ(service.refresh(kNow + (round + 1) * 1000000000LL), expiries.size());
+        const auto after = service.get_stats();
+        tick_us.push_back(static_cast<double>(after.solve_ns + after.refit_ns - before.solve_ns - before.refit_ns) /
+                          1000.0 / expiries.size());
+    }
+    std::sort(tick_us.begin(), tick_us.end());
+    const auto stats = service.get_stats();
+
+    goldearn::core::RcuReadGuard guard;
+    double worst_error = 0.0;
+    for (const auto& smile : service.surface()->smiles) {
+        ASSERT_TRUE(smile.valid);
+        worst_error = std::max(worst_error, smile.rms_error);
+    }
+    std::cout << "Volatility surface, " << expiries.size() << " expiries x " << 2 * kStrikes
+              << " options: cold refresh " << cold_us << "us, warm " << tick_us[kRounds / 2]
+              << "us per expiry median (solve " << stats.solve_ns / 1000.0 / stats.refits << "us, refit "
+              << stats.refit_ns / 1000.0 / stats.refits << "us mean); worst fit error " << worst_error
+              << " vol points" << std::endl;
+    EXPECT_LT(tick_us[kRounds / 2], kBudgetUsPerExpiry);
+    EXPECT_LT(worst_error, 0.1);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "../src/core/flight_recorder.hpp"
+#include <chrono>
+#include <filesystem>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace goldearn::core;
+namespace fs = std::filesystem;
+
+class FlightRecorderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / ("goldearn_flight_" + std::to_string(::getpid()));
+        fs::create_directories(dir_);
+        FlightRecorder::instance().configure(dir_.string(), 256);
+        // Threads named alike in earlier tests (or --gtest_repeat runs)
+        // would otherwise continue their rings
+        FlightRecorder::instance().clear_exited_rings();
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    fs::path dir_;
+};
+
+TEST_F(FlightRecorderTest, DumpMergesThreadsIntoOneTimeline) {
+    auto& recorder = FlightRecorder::instance();
+    std::thread feed([]() {
+        ASSERT_TRUE(FlightRecorder::instance().attach_thread("test_feed"));
+        for (uint64_t i = 0; i < 10; ++i) {
+            flight::tick(7, 100.0 + static_cast<double>(i), i + 1);
+        }
+    });
+    feed.join();
+    std::thread risk([]() {
+        ASSERT_TRUE(FlightRecorder::instance().attach_thread("test_risk"));
+        flight::risk_result(7, 3, 850, 10);
+        flight::order_send(42, 1, 2, 109.5, 10);
+    });
+    risk.join();
+
+    ASSERT_TRUE(recorder.dump("unit test"));
+    auto dump = flight_recorder::decode_file(recorder.last_dump_path());
+    EXPECT_EQ(dump.reason, "unit test");
+    EXPECT_EQ(dump.pid, ::getpid());
+
+    std::vector<flight_recorder::DecodedEvent> ours;
+    for (const auto& event : dump.events) {
+        if (event.thread == "test_feed" || event.thread == "test_risk") ours.push_back(event);
+    }
+    ASSERT_EQ(ours.size(), 12u);
+    for (size_t i = 1; i < ours.size(); ++i) {
+        EXPECT_LE(ours[i - 1].event.tsc, ours[i].event.tsc);
+        EXPECT_LE(ours[i - 1].wall_ns, ours[i].wall_ns);
+    }
+    // The feed thread ran first, so its ticks precede the risk events
+    EXPECT_EQ(ours[0].event.type, flight_recorder::EVENT_TICK);
+    EXPECT_EQ(ours[9].event.b, 10u);
+    EXPECT_EQ(ours[10].event.type, flight_recorder::EVENT_RISK_RESULT);
+    EXPECT_EQ(flight_recorder::describe(ours[11].event), "SEND order=42 side=1 venue=2 price=109.5000 qty=10");
+    EXPECT_NEAR(static_cast<double>(ours[0].wall_ns), static_cast<double>(dump.dump_wall_ns), 5e9);
+}
+
+TEST_F(FlightRecorderTest, RingKeepsTheNewestEvents) {
+    std::thread worker([]() {
+        ASSERT_TRUE(FlightRecorder::instance().attach_thread("test_wrap"));
+        for (uint64_t i = 0; i < 1000; ++i) {
+            flight::record(flight_recorder::EVENT_MARKER, 1, i, 0, 0);
+        }
+    });
+    worker.join();
+
+    ASSERT_TRUE(FlightRecorder::instance().dump("wrap"));
+    auto dump = flight_recorder::decode_file(FlightRecorder::instance().last_dump_path());
+    std::vector<uint64_t> ids;
+    for (const auto& event : dump.events) {
+        if (event.thread == "test_wrap") ids.push_back(event.event.id);
+    }
+    // 256-event ring of an exited thread: exactly the last 256, in order
+    ASSERT_EQ(ids.size(), 256u);
+    EXPECT_EQ(ids.front(), 744u);
+    EXPECT_EQ(ids.back(), 999u);
+}
+
+TEST_F(FlightRecorderTest, RestartedThreadContinuesItsRing) {
+    for (int run = 0; run < 2; ++run) {
+        std::thread([run]() {
+            FlightRecorder::instance().attach_thread("test_restart");
+            flight::record(flight_recorder::EVENT_MARKER, 2, static_cast<uint64_t>(run), 0, 0);
+        }).join();
+    }
+    ASSERT_TRUE(FlightRecorder::instance().dump("restart"));
+    auto dump = flight_recorder::decode_file(FlightRecorder::instance().last_dump_path());
+    int seen = 0;
+    for (const auto& event : dump.events) {
+        if (event.thread == "test_restart") {
+            EXPECT_EQ(event.event.id, static_cast<uint64_t>(seen++));
+        }
+    }
+    EXPECT_EQ(seen, 2);
+}
+
+TEST_F(FlightRecorderTest, FatalSignalDumpsBeforeDying) {
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        auto& recorder = FlightRecorder::instance();
+        recorder.install_signal_handlers();
+        recorder.attach_thread("test_crash");
+        flight::order_ack(5, 1, 9001);
+        ::raise(SIGABRT);
+        ::_exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGABRT);
+
+    fs::path dump_path;
+    std::string prefix = "flight-" + std::to_string(child) + "-";
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        if (entry.path().filename().string().rfind(prefix, 0) == 0) dump_path = entry.path();
+    }
+    ASSERT_FALSE(dump_path.empty());
+    auto dump = flight_recorder::decode_file(dump_path.string());
+    EXPECT_EQ(dump.reason, "SIGABRT");
+    ASSERT_FALSE(dump.events.empty());
+    EXPECT_EQ(dump.events.back().event.type, flight_recorder::EVENT_ORDER_ACK);
+    EXPECT_EQ(dump.events.back().event.a, 9001u);
+}
+
+TEST_F(FlightRecorderTest, RecordingCostsAFewStores) {
+    constexpr int kEvents = 1000000;
+    std::thread([]() {
+        FlightRecorder::instance().attach_thread("test_cost");
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kEvents; ++i) {
+            flight::tick(1, 100.25, static_cast<uint64_t>(i));
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    kEvents;
+        EXPECT_LT(ns, 50.0);
+    }).join();
+}
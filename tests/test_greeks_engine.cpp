@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "../src/risk/greeks_engine.hpp"
+#include "option_test_utils.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace goldearn::risk;
+using namespace option_test;
+
+namespace {
+
+// Closed form, straight from the textbook
+GreeksEngine::Greeks reference(const GreeksEngine::Contract& c, double spot, double vol, double rate, double yield,
+                               double tau) {
+    const double carry = c.model == GreeksEngine::Model::BLACK_SCHOLES ? rate - yield : 0.0;
+    const double w = c.type == GreeksEngine::OptionType::CALL ? 1.0 : -1.0;
+    const double forward = spot * std::exp(carry * tau);
+    const double discount = std::exp(-rate * tau);
+    const double sd = vol * std::sqrt(tau);
+    const double d1 = (std::log(forward / c.strike) + 0.5 * sd * sd) / sd;
+    const double d2 = d1 - sd;
+    const double pdf = std::exp(-0.5 * d1 * d1) / std::sqrt(2.0 * M_PI);
+    GreeksEngine::Greeks g;
+    g.price = w * discount * (forward * cdf(w * d1) - c.strike * cdf(w * d2));
+    g.delta = w * discount * std::exp(carry * tau) * cdf(w * d1);
+    g.gamma = discount * std::exp(carry * tau) * pdf / (spot * sd);
+    g.vega = discount * forward * pdf * std::sqrt(tau) * 0.01;
+    return g;
+}
+
+} // namespace
+
+class GreeksEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        engine.set_valuation_time(kNow);
+        // NIFTY index options (Black-Scholes) over three expiries and BANKNIFTY-style
+        // options on a future (Black-76); 3 x 7 x 2 = 42 contracts per underlying
+        uint64_t id = 100;
+        for (uint64_t underlying : {kNifty, kNiftyFuture}) {
+            for (int64_t days : {3, 31, 94}) {
+                for (double strike = 22500; strike <= 25500; strike += 500) {
+                    for (auto type : {GreeksEngine::OptionType::CALL, GreeksEngine::OptionType::PUT}) {
+                        GreeksEngine::Contract c;
+                        c.contract_id = id++;
+                        c.underlying_id = underlying;
+                        c.type = type;
+                        c.model = underlying == kNifty ? GreeksEngine::Model::BLACK_SCHOLES
+                                                       : GreeksEngine::Model::BLACK_76;
+                        c.strike = strike;
+                        c.expiry_ns = kNow + days * kDay;
+                        c.multiplier = 75;
+                        contracts.push_back(c);
+                    }
+                }
+            }
+        }
+        engine.add_contracts(contracts);
+        engine.set_underlying_price(kNifty, 24000.0);
+        engine.set_dividend_yield(kNifty, 0.012);
+        engine.set_underlying_price(kNiftyFuture, 24150.0);
+        for (const auto& c : contracts) {
+            // A smile
+            const double moneyness = std::log(c.strike / 24000.0);
+            engine.set_volatility(c.contract_id, 0.13 + 0.4 * moneyness * moneyness - 0.05 * moneyness);
+        }
+    }
+
+    double volatility(const GreeksEngine::Contract& c) const {
+        const double moneyness = std::log(c.strike / 24000.0);
+        return 0.13 + 0.4 * moneyness * moneyness - 0.05 * moneyness;
+    }
+
+    GreeksEngine engine;
+    std::vector<GreeksEngine::Contract> contracts;
+};
+
+TEST_F(GreeksEngineTest, KernelMatchesClosedForm) {
+    EXPECT_EQ(engine.recompute(), 88u); // 42 per chain, padded to 44
+    const double rate = GreeksEngine::Config{}.rate;
+    for (const auto& c : contracts) {
+        const bool spot = c.underlying_id == kNifty;
+        const double tau = static_cast<double>(c.expiry_ns - kNow) / kDay / 365.0;
+        auto expected = reference(c, spot ? 24000.0 : 24150.0, volatility(c), rate, spot ? 0.012 : 0.0, tau);
+        auto g = engine.greeks(c.contract_id);
+        EXPECT_NEAR(g.price, expected.price, 1e-9 * c.strike) << c.contract_id;
+        EXPECT_NEAR(g.delta, expected.delta, 1e-12) << c.contract_id;
+        EXPECT_NEAR(g.gamma, expected.gamma, 1e-14) << c.contract_id;
+        EXPECT_NEAR(g.vega, expected.vega, 1e-9) << c.contract_id;
+    }
+
+    // Put-call parity and theta against a one-day bump
+    const auto& call = contracts[0];
+    const auto& put = contracts[1];
+    const double tau = 3.0 / 365.0;
+    EXPECT_NEAR(engine.greeks(call.contract_id).price - engine.greeks(put.contract_id).price,
+                24000.0 * std::exp(-0.012 * tau) - call.strike * std::exp(-rate * tau), 1e-7);
+    for (const auto& c : {contracts[30], contracts[70]}) {
+        const double tau_now = static_cast<double>(c.expiry_ns - kNow) / kDay / 365.0;
+        const bool spot = c.underlying_id == kNifty;
+        const double u = spot ? 24000.0 : 24150.0;
+        const double q = spot ? 0.012 : 0.0;
+        const double bumped = reference(c, u, volatility(c), rate, q, tau_now - 1e-4 / 365.0).price -
+                              reference(c, u, volatility(c), rate, q, tau_now + 1e-4 / 365.0).price;
+        EXPECT_NEAR(engine.greeks(c.contract_id).theta, bumped / 2e-4, 1e-4 * std::abs(bumped / 2e-4) + 1e-6);
+    }
+}
+
+TEST_F(GreeksEngineTest, OnlyWhatMovedIsRepriced) {
+    engine.recompute();
+    EXPECT_EQ(engine.recompute(), 0u);
+
+    engine.set_underlying_price(kNiftyFuture, 24200.0);
+    EXPECT_EQ(engine.recompute(), 44u);
+    engine.set_volatility(contracts[5].contract_id, 0.2);
+    engine.set_volatility(contracts[6].contract_id, 0.2); // Same block of four
+    EXPECT_EQ(engine.recompute(), 4u);
+    engine.set_volatility(contracts[5].contract_id, 0.2); // Unchanged
+    engine.set_underlying_price(kNifty, 24000.0);
+    EXPECT_EQ(engine.recompute(), 0u);
+
+    // A new valuation time reprices everything, and rolls the time decay in
+    auto before = engine.greeks(contracts[0].contract_id);
+    engine.set_valuation_time(kNow + kDay);
+    EXPECT_EQ(engine.recompute(), 88u);
+    auto after = engine.greeks(contracts[0].contract_id);
+    EXPECT_NEAR(after.price - before.price, before.theta, 0.25 * std::abs(before.theta));
+
+    // Underlyings without a price wait for one
+    GreeksEngine fresh;
+    fresh.add_contracts(contracts);
+    EXPECT_EQ(fresh.recompute(), 0u);
+    fresh.set_underlying_price(kNifty, 24000.0);
+    EXPECT_EQ(fresh.recompute(), 44u);
+    fresh.set_underlying_price(kNiftyFuture, 24000.0);
+    EXPECT_EQ(fresh.recompute(), 44u);
+}
+
+TEST_F(GreeksEngineTest, FillsMoveTheUnderlyingSums) {
+    engine.recompute();
+    // Short straddle plus a long wing, on both underlyings
+    ASSERT_TRUE(engine.on_fill(contracts[14].contract_id, -10));
+    ASSERT_TRUE(engine.on_fill(contracts[15].contract_id, -10));
+    ASSERT_TRUE(engine.on_fill(contracts[20].contract_id, 4));
+    ASSERT_TRUE(engine.set_position(contracts[60].contract_id, 7));
+    EXPECT_FALSE(engine.on_fill(999999, 1));
+    EXPECT_EQ(engine.position(contracts[14].contract_id), -10.0);
+
+    auto expect_sums = [&](uint64_t underlying) {
+        GreeksEngine::Sensitivities sums;
+        for (const auto& c : contracts) {
+            if (c.underlying_id != underlying) continue;
+            auto g = engine.greeks(c.contract_id);
+            const double q = engine.position(c.contract_id) * c.multiplier;
+            sums.value += q * g.price;
+            sums.delta += q * g.delta;
+            sums.gamma += q * g.gamma;
+            sums.vega += q * g.vega;
+        }
+        auto actual = engine.sensitivities(underlying);
+        EXPECT_NEAR(actual.value, sums.value, 1e-6);
+        EXPECT_NEAR(actual.delta, sums.delta, 1e-9);
+        EXPECT_NEAR(actual.gamma, sums.gamma, 1e-12);
+        EXPECT_NEAR(actual.vega, sums.vega, 1e-9);
+    };
+    expect_sums(kNifty);
+    expect_sums(kNiftyFuture);
+    EXPECT_LT(engine.sensitivities(kNifty).gamma, 0.0); // Short gamma
+
+    // A move reprices the chain and the sums follow
+    engine.set_underlying_price(kNifty, 24600.0);
+    engine.recompute();
+    EXPECT_EQ(engine.sensitivities(kNifty).underlying_price, 24600.0);
+    expect_sums(kNifty);
+
+    // Order impact: current sums plus the order at today's Greeks
+    auto impact = engine.order_impact(contracts[15].contract_id, 10);
+    ASSERT_TRUE(impact.option);
+    EXPECT_EQ(impact.underlying_id, kNifty);
+    EXPECT_NEAR(impact.projected.delta - impact.current.delta,
+                750 * engine.greeks(contracts[15].contract_id).delta, 1e-9);
+    EXPECT_FALSE(engine.order_impact(999999, 1).option);
+
+    // Redefining the contract master keeps positions
+    GreeksEngine::Contract weekly = contracts[0];
+    weekly.contract_id = 5000;
+    weekly.strike = 24000;
+    engine.add_contract(weekly);
+    EXPECT_EQ(engine.num_contracts(), contracts.size() + 1);
+    EXPECT_EQ(engine.position(contracts[14].contract_id), -10.0);
+    engine.recompute();
+    expect_sums(kNifty);
+    EXPECT_THROW(engine.add_contract(GreeksEngine::Contract{}), std::invalid_argument);
+}
@@ -1,5 +1,14 @@
 #include <gtest/gtest.h>
 #include "../src/monitoring/health_check.hpp"
+#include "../src/monitoring/prometheus_metrics.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
 
 class HealthCheckTest : public ::testing::Test {
 protected:
@@ -20,4 +29,299 @@ TEST_F(HealthCheckTest, StartStop) {
     EXPECT_TRUE(health_server->is_running());
     health_server->stop();
     EXPECT_FALSE(health_server->is_running());
-}
\ No newline at end of file
+}
+
+namespace {
+
+using namespace goldearn::monitoring;
+
+// Counts how often the server runs it; requests must never do so
+class CountingChecker : public HealthChecker {
+public:
+    ComponentHealth check_health() override {
+        checks++;
+        ComponentHealth health;
+        health.component_name = get_component_name();
+        health.status = HealthStatus::HEALTHY;
+        health.message = "ok";
+        health.last_check = std::chrono::system_clock::now();
+        health.response_time_ms = 0.0;
+        return health;
+    }
+    std::string get_component_name() const override { return "Counting"; }
+
+    std::atomic<int> checks{0};
+};
+
+// Minimal blocking keep-alive client
+class TestClient {
+public:
+    explicit TestClient(uint16_t port) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected_ = connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
+    ~TestClient() { close(fd_); }
+
+    bool connected() const { return connected_; }
+
+    bool send_raw(const std::string& data) {
+        return send(fd_, data.data(), data.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(data.size());
+    }
+
+    bool get(const std::string& path) {
+        return send_raw("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    }
+
+    // Reads one response; returns the status code (0 on EOF/error)
+    int read_response(std::string& body) {
+        size_t header_end;
+        while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) return 0;
+        }
+        std::string head = buffer_.substr(0, header_end);
+        size_t length_pos = head.find("Content-Length: ");
+        size_t length = length_pos == std::string::npos ? 0 : std::stoul(head.substr(length_pos + 16));
+        while (buffer_.size() < header_end + 4 + length) {
+            if (!fill()) return 0;
+        }
+        body = buffer_.substr(header_end + 4, length);
+        buffer_.erase(0, header_end + 4 + length);
+        return std::stoi(head.substr(9, 3));
+    }
+
+    // True once the server has closed its side
+    bool closed_by_peer() {
+        char byte;
+        return buffer_.empty() && recv(fd_, &byte, 1, 0) == 0;
+    }
+
+private:
+    bool fill() {
+        char chunk[4096];
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd_ = -1;
+    bool connected_ = false;
+    std::string buffer_;
+};
+
+} // namespace
+
+class HealthCheckServingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        server = std::make_unique<HealthCheckServer>(0);
+        checker = std::make_shared<CountingChecker>();
+        server->register_checker(checker);
+        server->set_check_interval(std::chrono::seconds(3600));
+        server->set_metrics_refresh_interval(std::chrono::milliseconds(20));
+        ASSERT_TRUE(server->start());
+        ASSERT_NE(server->port(), 0);
+
+        // Wait for the initial check pass to publish
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (server->get_system_health().overall_status != HealthStatus::HEALTHY &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void TearDown() override {
+        server->stop();
+    }
+
+    std::unique_ptr<HealthCheckServer> server;
+    std::shared_ptr<CountingChecker> checker;
+};
+
+TEST_F(HealthCheckServingTest, ServesCachedSnapshotsOverKeepAlive) {
+    int checks_before = checker->checks.load();
+    TestClient client(server->port());
+    ASSERT_TRUE(client.connected());
+
+    std::string body;
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_TRUE(client.get("/health"));
+        ASSERT_EQ(client.read_response(body), 200);
+        EXPECT_NE(body.find("Counting"), std::string::npos);
+
+        ASSERT_TRUE(client.get("/metrics"));
+        ASSERT_EQ(client.read_response(body), 200);
+        EXPECT_NE(body.find("goldearn_component_health_status{component=\"Counting\"} 0"), std::string::npos);
+    }
+    ASSERT_TRUE(client.get("/health/live"));
+    EXPECT_EQ(client.read_response(body), 200);
+    EXPECT_EQ(body, "Alive");
+    ASSERT_TRUE(client.get("/health/ready"));
+    EXPECT_EQ(client.read_response(body), 200);
+    ASSERT_TRUE(client.get("/nope"));
+    EXPECT_EQ(client.read_response(body), 404);
+    ASSERT_TRUE(client.send_raw("POST /health HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.read_response(body), 405);
+
+    // One connection for everything, and no checker ran on behalf of a request
+    EXPECT_EQ(server->get_connections_accepted(), 1u);
+    EXPECT_EQ(server->get_requests_served(), 104u);
+    EXPECT_EQ(checker->checks.load(), checks_before);
+}
+
+TEST_F(HealthCheckServingTest, AnswersPipelinedRequestsInOrder) {
+    TestClient client(server->port());
+    ASSERT_TRUE(client.connected());
+    ASSERT_TRUE(client.send_raw("GET /health/live HTTP/1.1\r\n\r\n"
+                                "GET /missing HTTP/1.1\r\n\r\n"
+                                "GET /health/ready?verbose=1 HTTP/1.1\r\n\r\n"));
+    std::string body;
+    EXPECT_EQ(client.read_response(body), 200);
+    EXPECT_EQ(body, "Alive");
+    EXPECT_EQ(client.read_response(body), 404);
+    EXPECT_EQ(client.read_response(body), 200);
+    EXPECT_EQ(body, "Ready");
+}
+
+TEST_F(HealthCheckServingTest, HonoursConnectionClose) {
+    std::string body;
+    {
+        TestClient client(server->port());
+        ASSERT_TRUE(client.send_raw("GET /health/live HTTP/1.1\r\nConnection: close\r\n\r\n"));
+        EXPECT_EQ(client.read_response(body), 200);
+        EXPECT_TRUE(client.closed_by_peer());
+    }
+    {
+        TestClient client(server->port());
+        ASSERT_TRUE(client.send_raw("GET /health/live HTTP/1.0\r\n\r\n"));
+        EXPECT_EQ(client.read_response(body), 200);
+        EXPECT_TRUE(client.closed_by_peer());
+    }
+}
+
+TEST_F(HealthCheckServingTest, MetricsSnapshotIncludesRegistry) {
+    auto counter = MetricsRegistry::instance().create_counter("health_server_test_total", "Test counter");
+    counter->increment(7);
+
+    TestClient client(server->port());
+    std::string body;
+    bool found = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!found && std::chrono::steady_clock::now() < deadline) {
+        ASSERT_TRUE(client.get("/metrics"));
+        ASSERT_EQ(client.read_response(body), 200);
+        found = body.find("health_server_test_total 7") != std::string::npos;
+        if (!found) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_TRUE(found);
+    MetricsRegistry::instance().remove_metric("health_server_test_total");
+}
+
+TEST_F(HealthCheckServingTest, StreamsLargeResponsesAcrossPartialWrites) {
+    // A few hundred KB of exposition overflows the socket buffer, so the
+    // loop has to park the response and resume on EPOLLOUT
+    auto family = MetricsRegistry::instance().create_counter_family(
+        "health_server_large_total", "Large exposition", {"series"});
+    for (int i = 0; i < 5000; ++i) {
+        family->with_labels({"series_with_a_reasonably_long_name_" + std::to_string(i)})->increment(i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    TestClient client(server->port());
+    ASSERT_TRUE(client.send_raw("GET /metrics HTTP/1.1\r\n\r\nGET /metrics HTTP/1.1\r\n\r\n"
+                                "GET /health/live HTTP/1.1\r\n\r\n"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::string first, second, live;
+    EXPECT_EQ(client.read_response(first), 200);
+    EXPECT_EQ(client.read_response(second), 200);
+    EXPECT_EQ(client.read_response(live), 200);
+    EXPECT_GT(first.size(), 256u * 1024);
+    EXPECT_NE(first.find("series_with_a_reasonably_long_name_4999\"} 4999"), std::string::npos);
+    EXPECT_EQ(live, "Alive");
+    MetricsRegistry::instance().remove_metric("health_server_large_total");
+}
+
+// Scrape storm: many concurrent keep-alive clients against the one event loop
+TEST_F(HealthCheckServingTest, LoopbackLoadWithConcurrentClients) {
+    constexpr int kClients = 32;
+    constexpr int kRequestsPerClient = 200;
+    int checks_before = checker->checks.load();
+
+    std::atomic<int> ok{0};
+    std::atomic<int> failed{0};
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < kClients; ++c) {
+        clients.emplace_back([&, c]() {
+            TestClient client(server->port());
+            if (!client.connected()) {
+                failed += kRequestsPerClient;
+                return;
+            }
+            std::string body;
+            for (int i = 0; i < kRequestsPerClient; ++i) {
+                const char* path = (i + c) % 2 ? "/metrics" : "/health";
+                if (client.get(path) && client.read_response(body) == 200) {
+                    ok++;
+                } else {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto& client : clients) client.join();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "HealthCheckServer: " << kClients * kRequestsPerClient << " requests from "
+              << kClients << " keep-alive clients in " << elapsed_ms << "ms" << std::endl;
+
+    EXPECT_EQ(ok.load(), kClients * kRequestsPerClient);
+    EXPECT_EQ(failed.load(), 0);
+    EXPECT_EQ(server->get_connections_accepted(), static_cast<uint64_t>(kClients));
+    EXPECT_EQ(checker->checks.load(), checks_before);
+}
+
+TEST(HealthCheckAdminTest, LimitUpdatesAreServedOnTheAdminListenerOnly) {
+    std::vector<std::pair<std::string, double>> received;
+    HealthCheckServer server(0);
+    server.set_check_interval(std::chrono::seconds(3600));
+    server.set_limit_update_handler(0, [&](const std::vector<std::pair<std::string, double>>& updates) {
+        received = updates;
+        return updates.front().first != "unknown";
+    });
+    ASSERT_TRUE(server.start());
+    ASSERT_NE(server.admin_port(), 0);
+    ASSERT_NE(server.admin_port(), server.port());
+
+    TestClient client(server.admin_port());
+    ASSERT_TRUE(client.connected());
+    std::string body;
+    ASSERT_TRUE(client.send_raw("POST /admin/risk_limits?max_order_value=250000&strategy.arb.max_order_size=50 "
+                                "HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.read_response(body), 200);
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0].first, "max_order_value");
+    EXPECT_DOUBLE_EQ(received[0].second, 250000);
+    EXPECT_EQ(received[1].first, "strategy.arb.max_order_size");
+    EXPECT_DOUBLE_EQ(received[1].second, 50);
+
+    ASSERT_TRUE(client.send_raw("POST /admin/risk_limits?unknown=1 HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.read_response(body), 400);
+    received.clear();
+    ASSERT_TRUE(client.send_raw("POST /admin/risk_limits?max_order_value=lots HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.read_response(body), 400);
+    EXPECT_TRUE(received.empty());
+    ASSERT_TRUE(client.send_raw("GET /admin/risk_limits HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.read_response(body), 404);
+
+    // The public port never serves the route, handler or not
+    TestClient outside(server.port());
+    ASSERT_TRUE(outside.send_raw("POST /admin/risk_limits?max_order_value=1 HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(outside.read_response(body), 405);
+    EXPECT_TRUE(received.empty());
+    server.stop();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "../src/core/jitter_monitor.hpp"
+#include "../src/core/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace goldearn::core;
+
+namespace {
+
+const JitterMonitor::ProbeReport* find_probe(const JitterMonitor::Report& report, const std::string& name) {
+    for (const auto& probe : report.probes) {
+        if (probe.name == name) return &probe;
+    }
+    return nullptr;
+}
+
+void busy_wait(std::chrono::microseconds duration) {
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+} // namespace
+
+TEST(JitterMonitorTest, ParsesPerCpuInterruptCounts) {
+    const std::string text =
+        "           CPU0       CPU1       CPU3\n"
+        "  0:         45          0          0   IO-APIC   2-edge      timer\n"
+        " 24:       1200        310          7   PCI-MSI 524288-edge      eth0-TxRx-0\n"
+        "NMI:          3          4          5   Non-maskable interrupts\n"
+        "LOC:     987654     123456      65432   Local timer interrupts\n"
+        "ERR:          0\n";
+
+    auto cpu3 = parse_proc_interrupts(text, 3);
+    ASSERT_EQ(cpu3.size(), 4u);
+    EXPECT_EQ(cpu3[0].name, "0 (IO-APIC 2-edge timer)");
+    EXPECT_EQ(cpu3[1].name, "24 (PCI-MSI 524288-edge eth0-TxRx-0)");
+    EXPECT_EQ(cpu3[1].count, 7u);
+    EXPECT_EQ(cpu3[3].name, "LOC (Local timer interrupts)");
+    EXPECT_EQ(cpu3[3].count, 65432u);
+
+    EXPECT_EQ(parse_proc_interrupts(text, 1)[3].count, 123456u);
+    EXPECT_TRUE(parse_proc_interrupts(text, 2).empty()); // Offline CPU
+}
+
+TEST(JitterMonitorTest, ProbeHistogramsGapsAboveThreshold) {
+    JitterProbe* probe = JitterMonitor::instance().create_probe("jitter_test_probe");
+    std::thread([probe]() {
+        probe->start();
+        for (int i = 0; i < 1000; ++i) probe->sample();
+        busy_wait(std::chrono::microseconds(300)); // A 300us "hiccup"
+        probe->sample();
+        for (int i = 0; i < 1000; ++i) probe->sample();
+        busy_wait(std::chrono::microseconds(300)); // Real work, not jitter
+        probe->restart();
+        probe->sample();
+        probe->stop();
+    }).join();
+
+    // A loaded machine may add real gaps; the injected one must be there
+    EXPECT_GE(probe->gaps(), 1u);
+    EXPECT_GE(probe->max_gap_ns(), 300000u);
+    EXPECT_LT(probe->max_gap_ns(), 100000000u);
+    EXPECT_GE(probe->bucket(18), 1u); // [262us, 524us)
+
+    auto report = JitterMonitor::instance().report();
+    const auto* entry = find_probe(report, "jitter_test_probe");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_FALSE(entry->dedicated);
+    EXPECT_EQ(entry->gaps, probe->gaps());
+    ASSERT_FALSE(entry->histogram.empty());
+    EXPECT_GT(entry->measured_seconds, 0.0);
+}
+
+TEST(JitterMonitorTest, SpinThreadProbesOnlyIdleIterations) {
+    JitterProbe* probe = JitterMonitor::instance().create_probe("jitter_test_spin");
+    std::atomic<int> polls{0};
+    SpinThread spin("jitter_test_spin", -1, [&]() {
+        int n = polls.fetch_add(1);
+        if (n == 500) {
+            busy_wait(std::chrono::microseconds(500)); // Busy poll: work, not a hiccup
+            return true;
+        }
+        if (n == 1000) {
+            busy_wait(std::chrono::microseconds(200)); // Stalled idle poll: a hiccup
+        }
+        return false;
+    });
+    spin.set_jitter_probe(probe);
+    spin.start();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (polls.load() < 2000 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    spin.stop();
+
+    EXPECT_FALSE(probe->active());
+    EXPECT_GE(probe->max_gap_ns(), 200000u);
+    EXPECT_GE(probe->bucket(17), 1u); // [131us, 262us): the stalled idle poll
+}
+
+TEST(JitterMonitorTest, DedicatedCoreProbeAndCorrelation) {
+    auto& monitor = JitterMonitor::instance();
+    JitterMonitor::Config config;
+    config.threshold_ns = 5000;
+    config.cores = {0};
+    config.sample_interval_ms = 20;
+    monitor.start(config);
+    EXPECT_TRUE(monitor.is_running());
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    monitor.sample_system();
+    monitor.stop();
+    EXPECT_FALSE(monitor.is_running());
+
+    auto report = monitor.report();
+    EXPECT_EQ(report.threshold_ns, 5000u);
+    EXPECT_GT(report.tsc_ghz, 0.1);
+    const auto* probe = find_probe(report, "jitter_cpu0");
+    ASSERT_NE(probe, nullptr);
+    EXPECT_TRUE(probe->dedicated);
+    EXPECT_GT(probe->measured_seconds, 0.05);
+    // Every interval with gaps is classified at most once per cause
+    EXPECT_LE(probe->gap_intervals_with_interrupts, probe->gap_intervals);
+    EXPECT_LE(probe->gap_intervals_with_context_switches, probe->gap_intervals);
+    monitor.log_report();
+}
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include "../src/trading/kill_switch.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace goldearn::trading;
+
+namespace {
+
+// A session that keeps what it was given, one entry per write
+struct RecordingSession {
+    std::mutex mutex;
+    std::vector<std::vector<CancelMessage>> writes;
+    size_t accept_limit = SIZE_MAX;   // Bytes accepted per write
+
+    size_t write(const uint8_t* data, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t accepted = std::min(length, accept_limit);
+        std::vector<CancelMessage> messages(accepted / sizeof(CancelMessage));
+        std::memcpy(messages.data(), data, messages.size() * sizeof(CancelMessage));
+        writes.push_back(std::move(messages));
+        return accepted;
+    }
+
+    std::set<uint64_t> cancelled() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::set<uint64_t> ids;
+        for (const auto& write : writes) {
+            for (const auto& message : write) ids.insert(message.client_order_id);
+        }
+        return ids;
+    }
+};
+
+Order make_order(uint64_t client_order_id, uint64_t symbol_id, OrderSide side) {
+    Order order{};
+    order.order_id = client_order_id + 1000000;
+    order.client_order_id = client_order_id;
+    order.symbol_id = symbol_id;
+    order.side = side;
+    order.quantity = 100;
+    return order;
+}
+
+} // namespace
+
+TEST(KillSwitchTest, TripBurstsPreEncodedCancelsPerVenue) {
+    KillSwitch::Config config;
+    config.burst_bytes = 10 * sizeof(CancelMessage) + 7; // Rounded down to ten cancels a write
+    KillSwitch kill_switch(config);
+    RecordingSession nse, bse;
+    const uint32_t nse_index = kill_switch.add_venue(
+        {"NSE", [&](const uint8_t* d, size_t n) { return nse.write(d, n); }, nullptr});
+    const uint32_t bse_index = kill_switch.add_venue(
+        {"BSE", [&](const uint8_t* d, size_t n) { return bse.write(d, n); }, nullptr});
+    EXPECT_EQ(kill_switch.venue_index("BSE"), bse_index);
+    EXPECT_EQ(kill_switch.venue_index("MCX"), KillSwitch::INVALID_VENUE);
+
+    // 25 orders live on NSE, 3 on BSE; every other NSE order done before the trip
+    std::vector<KillSwitch::Handle> handles;
+    for (uint64_t id = 1; id <= 50; ++id) {
+        ASSERT_TRUE(kill_switch.begin_submit());
+        handles.push_back(kill_switch.on_order_live(nse_index, make_order(id, 2885, OrderSide::BUY)));
+        kill_switch.end_submit();
+        ASSERT_NE(handles.back(), KillSwitch::INVALID_HANDLE);
+    }
+    for (size_t i = 0; i < handles.size(); i += 2) {
+        EXPECT_TRUE(kill_switch.on_order_done(handles[i]));
+    }
+    EXPECT_FALSE(kill_switch.on_order_done(handles[0]));
+    for (uint64_t id = 101; id <= 103; ++id) {
+        const auto handle = kill_switch.on_order_live(bse_index, make_order(id, 500325, OrderSide::SELL));
+        kill_switch.on_order_acknowledged(handle, 900000 + id);
+    }
+    EXPECT_EQ(kill_switch.live_orders(nse_index), 25u);
+    EXPECT_EQ(kill_switch.live_orders(bse_index), 3u);
+
+    const CancelMessage* encoded = kill_switch.cancel_message(handles[1]);
+    ASSERT_NE(encoded, nullptr);
+    EXPECT_EQ(encoded->length, sizeof(CancelMessage));
+    EXPECT_EQ(encoded->message_type, CancelMessage::TYPE);
+    EXPECT_EQ(encoded->client_order_id, 2u);
+    EXPECT_EQ(encoded->symbol_id, 2885u);
+    EXPECT_EQ(encoded->side, static_cast<uint8_t>(OrderSide::BUY));
+    EXPECT_EQ(encoded->venue_order_id, 0u);
+    EXPECT_EQ(kill_switch.cancel_message(handles[0]), nullptr);
+
+    const auto result = kill_switch.trip("test");
+    EXPECT_TRUE(kill_switch.is_blocked());
+    EXPECT_EQ(result.venues, 2u);
+    EXPECT_EQ(result.mass_cancels, 0u);
+    EXPECT_EQ(result.cancels_sent, 28u);
+    EXPECT_EQ(result.writes, 4u); // 10 + 10 + 5 on NSE, 3 on BSE
+    EXPECT_EQ(result.failed_venues, 0u);
+    EXPECT_GT(result.trigger_to_last_cancel_ns, 0u);
+
+    ASSERT_EQ(nse.writes.size(), 3u);
+    EXPECT_EQ(nse.writes[0].size(), 10u);
+    EXPECT_EQ(nse.writes[2].size(), 5u);
+    std::set<uint64_t> expected;
+    for (uint64_t id = 2; id <= 50; id += 2) expected.insert(id);
+    EXPECT_EQ(nse.cancelled(), expected);
+    ASSERT_EQ(bse.writes.size(), 1u);
+    for (const auto& message : bse.writes[0]) {
+        EXPECT_EQ(message.venue_order_id, 900000 + message.client_order_id);
+        EXPECT_EQ(message.side, static_cast<uint8_t>(OrderSide::SELL));
+    }
+
+    // Closed until reset; the orders stay tracked until their acknowledgements
+    EXPECT_FALSE(kill_switch.begin_submit());
+    auto stats = kill_switch.get_stats();
+    EXPECT_TRUE(stats.blocked);
+    EXPECT_EQ(stats.trips, 1u);
+    EXPECT_EQ(stats.rejected_submissions, 1u);
+    EXPECT_EQ(stats.cancels_sent, 28u);
+    EXPECT_EQ(stats.live_orders, 28u);
+    EXPECT_EQ(stats.last_trigger_to_last_cancel_ns, result.trigger_to_last_cancel_ns);
+    kill_switch.reset();
+    EXPECT_TRUE(kill_switch.begin_submit());
+    kill_switch.end_submit();
+}
+
+TEST(KillSwitchTest, MassCancelFallbackAndShortWrites) {
+    KillSwitch kill_switch;
+    RecordingSession mass_session, fallback_session, short_session;
+    short_session.accept_limit = 3 * sizeof(CancelMessage);
+    int mass_cancels = 0;
+    const uint32_t mass = kill_switch.add_venue(
+        {"NSE", [&](const uint8_t* d, size_t n) { return mass_session.write(d, n); },
+         [&]() { ++mass_cancels; return true; }});
+    const uint32_t fallback = kill_switch.add_venue(
+        {"BSE", [&](const uint8_t* d, size_t n) { return fallback_session.write(d, n); },
+         []() { return false; }});
+    const uint32_t partial = kill_switch.add_venue(
+        {"MCX", [&](const uint8_t* d, size_t n) { return short_session.write(d, n); }, nullptr});
+    for (uint64_t id = 1; id <= 5; ++id) {
+        kill_switch.on_order_live(mass, make_order(id, 1, OrderSide::BUY));
+        kill_switch.on_order_live(fallback, make_order(100 + id, 2, OrderSide::BUY));
+        kill_switch.on_order_live(partial, make_order(200 + id, 3, OrderSide::SELL));
+    }
+
+    const auto result = kill_switch.trip("test");
+    EXPECT_EQ(mass_cancels, 1);
+    EXPECT_EQ(result.mass_cancels, 1u);
+    EXPECT_TRUE(mass_session.writes.empty());
+    EXPECT_EQ(fallback_session.cancelled().size(), 5u);
+    EXPECT_EQ(short_session.cancelled().size(), 3u);
+    EXPECT_EQ(result.cancels_sent, 8u);
+    EXPECT_EQ(result.failed_venues, 1u);
+
+    EXPECT_THROW(kill_switch.add_venue({"NSE", [](const uint8_t*, size_t n) { return n; }, nullptr}),
+                 std::invalid_argument);
+    EXPECT_THROW(kill_switch.add_venue({"", [](const uint8_t*, size_t n) { return n; }, nullptr}),
+                 std::invalid_argument);
+    EXPECT_THROW(kill_switch.add_venue({"NCDEX", nullptr, nullptr}), std::invalid_argument);
+    KillSwitch::Config bad;
+    bad.burst_bytes = 8;
+    EXPECT_THROW(KillSwitch{bad}, std::invalid_argument);
+
+    // A full pool leaves the order untracked and counts it
+    KillSwitch::Config tiny;
+    tiny.max_live_orders = 2;
+    KillSwitch small(tiny);
+    const uint32_t venue = small.add_venue({"NSE", [](const uint8_t*, size_t n) { return n; }, nullptr});
+    EXPECT_NE(small.on_order_live(venue, make_order(1, 1, OrderSide::BUY)), KillSwitch::INVALID_HANDLE);
+    const auto second = small.on_order_live(venue, make_order(2, 1, OrderSide::BUY));
+    EXPECT_EQ(small.on_order_live(venue, make_order(3, 1, OrderSide::BUY)), KillSwitch::INVALID_HANDLE);
+    EXPECT_EQ(small.get_stats().pool_exhausted, 1u);
+    EXPECT_TRUE(small.on_order_done(second));
+    EXPECT_NE(small.on_order_live(venue, make_order(3, 1, OrderSide::BUY)), KillSwitch::INVALID_HANDLE);
+}
+
+// A handle kept past its order's completion must not reach the order that
+// reuses its slot, on the same venue or another
+TEST(KillSwitchTest, StaleHandlesAreIgnoredAfterSlotReuse) {
+    KillSwitch kill_switch;
+    const auto sink = [](const uint8_t*, size_t n) { return n; };
+    const uint32_t nse = kill_switch.add_venue({"NSE", sink, nullptr});
+    const uint32_t bse = kill_switch.add_venue({"BSE", sink, nullptr});
+
+    const auto stale = kill_switch.on_order_live(nse, make_order(1, 2885, OrderSide::BUY));
+    ASSERT_TRUE(kill_switch.on_order_done(stale));
+    const auto reused = kill_switch.on_order_live(bse, make_order(2, 500325, OrderSide::SELL));
+    EXPECT_EQ(reused & 0xffffffffu, stale & 0xffffffffu); // Same slot, new generation
+    EXPECT_NE(reused, stale);
+
+    kill_switch.on_order_acknowledged(stale, 777);
+    EXPECT_FALSE(kill_switch.on_order_done(stale));
+    EXPECT_EQ(kill_switch.cancel_message(stale), nullptr);
+    ASSERT_NE(kill_switch.cancel_message(reused), nullptr);
+    EXPECT_EQ(kill_switch.cancel_message(reused)->venue_order_id, 0u);
+    EXPECT_EQ(kill_switch.live_orders(bse), 1u);
+
+    // Reused on the same venue
+    ASSERT_TRUE(kill_switch.on_order_done(reused));
+    const auto again = kill_switch.on_order_live(bse, make_order(3, 500325, OrderSide::BUY));
+    kill_switch.on_order_acknowledged(reused, 778);
+    EXPECT_EQ(kill_switch.cancel_message(again)->venue_order_id, 0u);
+    kill_switch.on_order_acknowledged(again, 779);
+    EXPECT_EQ(kill_switch.cancel_message(again)->venue_order_id, 779u);
+}
+
+// Acks on one thread racing completions and reuse across venues on another
+// leave every venue's array consistent
+TEST(KillSwitchTest, AcksRacingCompletionAndReuse) {
+    KillSwitch::Config config;
+    config.max_live_orders = 4;
+    KillSwitch kill_switch(config);
+    const auto sink = [](const uint8_t*, size_t n) { return n; };
+    const uint32_t venues[] = {kill_switch.add_venue({"NSE", sink, nullptr}),
+                               kill_switch.add_venue({"BSE", sink, nullptr})};
+
+    constexpr uint64_t kOrders = 200000;
+    std::atomic<KillSwitch::Handle> current{KillSwitch::INVALID_HANDLE};
+    std::atomic<bool> done{false};
+    std::thread acker([&]() {
+        uint64_t n = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            kill_switch.on_order_acknowledged(current.load(std::memory_order_relaxed), ++n);
+        }
+    });
+    const auto keep = kill_switch.on_order_live(venues[0], make_order(0, 1, OrderSide::BUY));
+    for (uint64_t id = 1; id <= kOrders; ++id) {
+        const auto handle = kill_switch.on_order_live(venues[id % 2], make_order(id, 1, OrderSide::BUY));
+        current.store(handle, std::memory_order_relaxed);
+        ASSERT_TRUE(kill_switch.on_order_done(handle));
+    }
+    done = true;
+    acker.join();
+
+    EXPECT_EQ(kill_switch.live_orders(venues[0]), 1u);
+    EXPECT_EQ(kill_switch.live_orders(venues[1]), 0u);
+    ASSERT_NE(kill_switch.cancel_message(keep), nullptr);
+    EXPECT_EQ(kill_switch.cancel_message(keep)->client_order_id, 0u);
+    EXPECT_EQ(kill_switch.cancel_message(keep)->venue_order_id, 0u);
+}
+
+// Submitters race the trip: whatever got through the gateway is cancelled,
+// and nothing gets through after it
+TEST(KillSwitchTest, NoSubmissionSlipsPastATrip) {
+    KillSwitch kill_switch;
+    RecordingSession session;
+    const uint32_t venue = kill_switch.add_venue(
+        {"NSE", [&](const uint8_t* d, size_t n) { return session.write(d, n); }, nullptr});
+
+    constexpr int kThreads = 4;
+    constexpr uint64_t kPerThread = 10000; // Then keep going through the gateway without orders
+    std::atomic<bool> go{false};
+    std::atomic<bool> tripped{false};
+    std::atomic<uint64_t> late{0};
+    std::vector<std::vector<uint64_t>> submitted(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            while (!go.load()) {}
+            for (uint64_t n = 0;; ++n) {
+                const bool was_tripped = tripped.load();
+                if (!kill_switch.begin_submit()) break;
+                if (was_tripped) late.fetch_add(1);
+                if (n < kPerThread) {
+                    const uint64_t id = (static_cast<uint64_t>(t) << 32) | n;
+                    kill_switch.on_order_live(venue, make_order(id, 1, OrderSide::BUY));
+                    submitted[t].push_back(id);
+                }
+                kill_switch.end_submit();
+            }
+        });
+    }
+    go = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    const auto result = kill_switch.trip("race");
+    tripped = true;
+    for (auto& thread : threads) thread.join();
+
+    size_t total = 0;
+    const auto cancelled = session.cancelled();
+    for (const auto& ids : submitted) {
+        total += ids.size();
+        for (uint64_t id : ids) ASSERT_TRUE(cancelled.count(id)) << id;
+    }
+    EXPECT_EQ(result.cancels_sent, total);
+    EXPECT_EQ(late.load(), 0u);
+    EXPECT_EQ(kill_switch.get_stats().rejected_submissions, static_cast<uint64_t>(kThreads));
+}
@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+#include "../src/utils/logger.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace goldearn::utils;
+
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = "/tmp/goldearn_logger_test_" + std::to_string(::getpid()) + ".log";
+        std::remove(path_.c_str());
+        Logger::instance().set_console_output(false);
+        Logger::instance().set_level(LogLevel::TRACE);
+        Logger::instance().set_file_output(path_);
+    }
+
+    void TearDown() override {
+        Logger::instance().set_fast_log_file("");
+        Logger::instance().flush();
+        Logger::instance().set_level(LogLevel::INFO);
+        Logger::instance().set_console_output(true);
+        std::remove(path_.c_str());
+    }
+
+    // The file is the process-wide sink, and threads other tests left running
+    // may log into it: only this file's records and the logger's own count
+    std::vector<std::string> read_lines() {
+        Logger::instance().flush();
+        std::ifstream in(path_);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.find(".cpp:") == std::string::npos || line.find("test_logger.cpp:") != std::string::npos) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    }
+
+    static std::string message_of(const std::string& line) {
+        // Message follows the "[file:line function] " location block
+        size_t pos = line.find("] ", line.find("test_logger.cpp"));
+        return pos == std::string::npos ? line : line.substr(pos + 2);
+    }
+
+    std::string path_;
+};
+
+enum class Side { BUY = 1, SELL = 2 };
+
+TEST_F(LoggerTest, FormatsDeferredArguments) {
+    std::string venue = "NSE";
+    std::atomic<uint64_t> sequence{42};
+    const char* reason = "price band";
+
+    LOG_INFO("Order {} on {} rejected: {}", 1001, venue, reason);
+    LOG_INFO("Price {:.2f} qty {} pnl {:.1%}", 2450.456, 100u, 0.0123);
+    LOG_INFO("seq={} side={} flag={} ch={}", sequence, Side::SELL, true, 'x');
+    LOG_INFO("Plain message");
+    LOG_INFO("Escaped {{}} and {:x}", 255);
+
+    auto lines = read_lines();
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(message_of(lines[0]), "Order 1001 on NSE rejected: price band");
+    EXPECT_EQ(message_of(lines[1]), "Price 2450.46 qty 100 pnl 1.2%");
+    EXPECT_EQ(message_of(lines[2]), "seq=42 side=2 flag=true ch=x");
+    EXPECT_EQ(message_of(lines[3]), "Plain message");
+    EXPECT_EQ(message_of(lines[4]), "Escaped {} and ff");
+
+    EXPECT_NE(lines[0].find("[INFO]"), std::string::npos);
+    EXPECT_NE(lines[0].find("test_logger.cpp:"), std::string::npos);
+}
+
+// Mismatches are rejected at compile time; these mirror the static_asserts in log_checked
+namespace log_detail = goldearn::utils::log_detail;
+static_assert(log_detail::is_valid_format<"a {} b {:.2f}", int, double>());
+static_assert(log_detail::is_valid_format<"{:.1%} {:x} {:d}", float, uint64_t, int>());
+static_assert(log_detail::is_valid_format<"{{literal}}">());
+static_assert(!log_detail::is_valid_format<"{} {}", int>());
+static_assert(!log_detail::is_valid_format<"{}", int, int>());
+static_assert(!log_detail::is_valid_format<"{:.2f}", std::string>());
+static_assert(!log_detail::is_valid_format<"{:.2}", int>());
+static_assert(!log_detail::is_valid_format<"{:q}", int>());
+static_assert(!log_detail::is_valid_format<"unterminated {", int>());
+static_assert(!log_detail::is_valid_format<"stray }">());
+
+TEST_F(LoggerTest, FormatLayoutIsPrecomputed) {
+    constexpr auto& layout = log_detail::format_layout<"px={:.2f} {{q}}={}">;
+    static_assert(layout.placeholders == 2);
+    static_assert(layout.specs[0].precision == 2 && layout.specs[0].type == 'f');
+    static_assert(layout.specs[1].precision == -1 && layout.specs[1].type == 0);
+    EXPECT_EQ(std::string_view(layout.text, layout.piece_end[2]), "px= {q}=");
+    EXPECT_EQ(layout.piece_end[0], 3u);
+}
+
+TEST_F(LoggerTest, ArgumentsAreCapturedAtCallTime) {
+    std::string value = "before";
+    LOG_WARN("value={}", value);
+    value = "after"; // Formatting happens later on the logger thread
+
+    auto lines = read_lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(message_of(lines[0]), "value=before");
+    EXPECT_NE(lines[0].find("[WARN]"), std::string::npos);
+}
+
+TEST_F(LoggerTest, LevelFilteringSkipsCapture) {
+    Logger::instance().set_level(LogLevel::WARNING);
+    uint64_t logged_before = Logger::instance().get_messages_logged();
+    LOG_DEBUG("suppressed {}", 1);
+    LOG_INFO("suppressed {}", 2);
+    LOG_ERROR("kept {}", 3);
+
+    auto lines = read_lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(message_of(lines[0]), "kept 3");
+    EXPECT_EQ(Logger::instance().get_messages_logged(), logged_before + 1);
+}
+
+TEST_F(LoggerTest, MergesThreadsInTimestampOrder) {
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+    uint64_t dropped_before = Logger::instance().get_messages_dropped();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                LOG_INFO("thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    auto lines = read_lines();
+    EXPECT_EQ(lines.size() + (Logger::instance().get_messages_dropped() - dropped_before),
+              static_cast<size_t>(kThreads * kPerThread));
+
+    // Per-thread order is preserved
+    std::vector<int> last(kThreads, -1);
+    for (const auto& line : lines) {
+        int t, i;
+        if (std::sscanf(message_of(line).c_str(), "thread %d message %d", &t, &i) == 2) {
+            EXPECT_GT(i, last[t]);
+            last[t] = i;
+        }
+    }
+}
+
+TEST_F(LoggerTest, FullRingDropsAndCounts) {
+    uint64_t dropped_before = Logger::instance().get_messages_dropped();
+    Logger::instance().set_ring_capacity(4096);
+
+    std::thread producer([]() {
+        std::string payload(200, 'x');
+        for (int i = 0; i < 20000; ++i) {
+            LOG_INFO("burst {} {}", i, payload);
+        }
+    });
+    producer.join();
+    Logger::instance().set_ring_capacity(256 * 1024);
+
+    auto lines = read_lines();
+    uint64_t dropped = Logger::instance().get_messages_dropped() - dropped_before;
+    EXPECT_GT(dropped, 0u);
+
+    bool reported = false;
+    for (const auto& line : lines) {
+        if (line.find("Logger: dropped") != std::string::npos) reported = true;
+    }
+    EXPECT_TRUE(reported);
+}
+
+TEST_F(LoggerTest, FastLogRoundTripsThroughMappedFile) {
+    std::string fast_path = path_ + ".fast";
+    ASSERT_TRUE(Logger::instance().set_fast_log_file(fast_path, 4 * 1024 * 1024));
+
+    LOG_FAST(LogLevel::INFO, "Order {} filled {} @ {:.2f}", 1001u, -25, 2450.5);
+    LOG_FAST(LogLevel::WARNING, "Queue depth {} above {} ({})", 70000, 65536, true);
+    LOG_FAST(LogLevel::DEBUG, "no args");
+    std::thread([]() { LOG_FAST(LogLevel::ERROR, "from thread {:x}", 255); }).join();
+
+    auto records = fast_log::decode_file(fast_path);
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].message, "Order 1001 filled -25 @ 2450.50");
+    EXPECT_EQ(records[0].level, static_cast<uint8_t>(LogLevel::INFO));
+    EXPECT_EQ(records[1].message, "Queue depth 70000 above 65536 (true)");
+    EXPECT_EQ(records[2].message, "no args");
+    EXPECT_EQ(records[3].message, "from thread ff");
+    EXPECT_NE(records[3].thread_id, records[0].thread_id);
+    EXPECT_LE(records[0].tsc, records[3].tsc);
+
+    // Nothing went through the text log
+    EXPECT_TRUE(read_lines().empty());
+    std::remove(fast_path.c_str());
+}
+
+TEST_F(LoggerTest, FastLogKeepsNewestRecordsWhenWrapping) {
+    std::string fast_path = path_ + ".fast";
+    ASSERT_TRUE(Logger::instance().set_fast_log_file(fast_path, 2 * 1024 * 1024));
+    uint64_t capacity = Logger::instance().get_fast_log_file()->capacity();
+
+    uint64_t total = capacity * 3 + 17;
+    for (uint64_t i = 0; i < total; ++i) {
+        LOG_FAST(LogLevel::INFO, "seq {}", i);
+    }
+
+    auto records = fast_log::decode_file(fast_path);
+    ASSERT_EQ(records.size(), capacity);
+    EXPECT_EQ(records.back().message, "seq " + std::to_string(total - 1));
+    EXPECT_EQ(records.front().message, "seq " + std::to_string(total - capacity));
+    std::remove(fast_path.c_str());
+}
+
+// Writers that pause mid-chunk while others lap the file must not share
+// slots with them: every surviving record is one writer's, whole
+TEST_F(LoggerTest, FastLogConcurrentWritersWrapWithoutMixingRecords) {
+    constexpr uint64_t kWriters = 4;
+    constexpr uint64_t kRecords = 20000;
+    std::string fast_path = path_ + ".fast";
+    ASSERT_TRUE(Logger::instance().set_fast_log_file(fast_path, 64 * 1024)); // Smallest file
+    uint64_t capacity = Logger::instance().get_fast_log_file()->capacity();
+
+    std::vector<uint32_t> thread_ids(kWriters);
+    std::vector<std::thread> writers;
+    for (uint64_t w = 0; w < kWriters; ++w) {
+        writers.emplace_back([&, w]() {
+            thread_ids[w] = static_cast<uint32_t>(::syscall(SYS_gettid));
+            for (uint64_t n = 0; n < kRecords; ++n) {
+                LOG_FAST(LogLevel::INFO, "writer {} n {} check {}", w, n, w * 1000003 + n);
+                if (n % (37 + w) == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& writer : writers) writer.join();
+
+    auto records = fast_log::decode_file(fast_path);
+    ASSERT_FALSE(records.empty());
+    EXPECT_LE(records.size(), capacity);
+    size_t mixed = 0;
+    for (const auto& record : records) {
+        unsigned long long w = 0, n = 0, check = 0;
+        bool whole = std::sscanf(record.message.c_str(), "writer %llu n %llu check %llu", &w, &n, &check) == 3 &&
+                     w < kWriters && check == w * 1000003 + n && record.thread_id == thread_ids[w];
+        mixed += !whole;
+    }
+    EXPECT_EQ(mixed, 0u);
+    std::remove(fast_path.c_str());
+}
+
+// A writer idle through two wraps re-claims rather than finishing its old
+// chunk over newer records
+TEST_F(LoggerTest, FastLogIdleWriterReclaimsAfterWrap) {
+    std::string fast_path = path_ + ".fast";
+    ASSERT_TRUE(Logger::instance().set_fast_log_file(fast_path, 64 * 1024));
+    uint64_t capacity = Logger::instance().get_fast_log_file()->capacity();
+    const uint64_t chunk = fast_log::CHUNK_RECORDS;
+
+    std::atomic<int> phase{0};
+    std::thread idle([&]() {
+        LOG_FAST(LogLevel::INFO, "idle {}", uint64_t{0}); // Claims the first chunk
+        phase = 1;
+        while (phase.load() != 2) std::this_thread::yield();
+        for (uint64_t n = 1; n < chunk; ++n) {
+            LOG_FAST(LogLevel::INFO, "idle {}", n);
+        }
+    });
+    while (phase.load() != 1) std::this_thread::yield();
+    std::thread busy([&]() {
+        for (uint64_t n = 0; n < 2 * capacity; ++n) {
+            LOG_FAST(LogLevel::INFO, "busy {}", n);
+        }
+    });
+    busy.join();
+    phase = 2;
+    idle.join();
+
+    auto records = fast_log::decode_file(fast_path);
+    std::vector<bool> busy_seen(2 * capacity), idle_seen(chunk);
+    for (const auto& record : records) {
+        unsigned long long n = 0;
+        if (std::sscanf(record.message.c_str(), "busy %llu", &n) == 1 && n < busy_seen.size()) {
+            busy_seen[n] = true;
+        } else if (std::sscanf(record.message.c_str(), "idle %llu", &n) == 1 && n < idle_seen.size()) {
+            idle_seen[n] = true;
+        }
+    }
+    // The idle writer's new chunk displaces only the oldest busy records
+    for (uint64_t n = capacity + chunk; n < 2 * capacity; ++n) {
+        EXPECT_TRUE(busy_seen[n]) << "busy record " << n << " overwritten";
+    }
+    for (uint64_t n = 1; n < chunk; ++n) {
+        EXPECT_TRUE(idle_seen[n]) << "idle record " << n << " lost";
+    }
+    std::remove(fast_path.c_str());
+}
+
+TEST_F(LoggerTest, FastLogRejectsForeignFiles) {
+    EXPECT_THROW(fast_log::decode_file(path_ + ".missing"), std::runtime_error);
+    LOG_INFO("text");
+    Logger::instance().flush();
+    EXPECT_THROW(fast_log::decode_file(path_), std::runtime_error);
+}
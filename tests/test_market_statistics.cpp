@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "../src/market_data/market_statistics.hpp"
+
+using namespace goldearn::market_data;
+
+namespace {
+
+// Straight EWMA over the same returns, debiased the same way
+struct ReferenceEwma {
+    explicit ReferenceEwma(size_t n, double lambda) : n(n), lambda(lambda), matrix(n * n, 0.0) {}
+
+    void add(const std::vector<double>& returns) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                matrix[i * n + j] = lambda * matrix[i * n + j] + (1.0 - lambda) * returns[i] * returns[j];
+            }
+        }
+        weight = 1.0 - (1.0 - weight) * lambda;
+    }
+    double covariance(size_t i, size_t j) const { return matrix[i * n + j] / weight; }
+
+    size_t n;
+    double lambda;
+    std::vector<double> matrix;
+    double weight = 0.0;
+};
+
+std::vector<uint64_t> make_universe(size_t n) {
+    std::vector<uint64_t> universe(n);
+    for (size_t i = 0; i < n; ++i) {
+        universe[i] = 1000 + 7 * i;
+    }
+    return universe;
+}
+
+} // namespace
+
+TEST(MarketStatisticsTest, MatchesAStraightEwmaAcrossTiles) {
+    // Not a multiple of the tile size, so the padding is exercised too
+    constexpr size_t kSymbols = 70;
+    auto universe = make_universe(kSymbols);
+    MarketStatistics statistics(MarketStatistics::Config{universe, std::chrono::milliseconds(100), 0.97});
+    ReferenceEwma reference(kSymbols, 0.97);
+
+    std::vector<double> prices(kSymbols), returns(kSymbols);
+    for (size_t i = 0; i < kSymbols; ++i) {
+        prices[i] = 100.0 + i;
+        statistics.on_price(universe[i], prices[i]);
+    }
+    statistics.sample(); // First prices only
+    EXPECT_EQ(statistics.snapshot().samples(), 0u);
+
+    uint32_t x = 12345;
+    for (int step = 0; step < 200; ++step) {
+        x = x * 1664525 + 1013904223;
+        const double market = ((x >> 8) % 2001 - 1000.0) * 1e-6;
+        for (size_t i = 0; i < kSymbols; ++i) {
+            x = x * 1664525 + 1013904223;
+            const double own = ((x >> 8) % 2001 - 1000.0) * 1e-6;
+            const double next = prices[i] * std::exp((i % 3 == 0 ? -market : market) + own);
+            returns[i] = std::log(next / prices[i]);
+            prices[i] = next;
+            statistics.on_price(universe[i], next);
+        }
+        statistics.sample();
+        reference.add(returns);
+    }
+
+    auto snapshot = statistics.snapshot();
+    EXPECT_EQ(snapshot.samples(), 200u);
+    std::vector<double> dense;
+    snapshot.covariance_matrix(dense);
+    for (uint32_t i = 0; i < kSymbols; ++i) {
+        EXPECT_NEAR(snapshot.volatility(i), std::sqrt(reference.covariance(i, i)), 1e-12);
+        for (uint32_t j = 0; j < kSymbols; ++j) {
+            const double expected = reference.covariance(i, j);
+            ASSERT_NEAR(snapshot.covariance(i, j), expected, 1e-15 + 1e-10 * std::fabs(expected));
+            ASSERT_DOUBLE_EQ(dense[i * kSymbols + j], snapshot.covariance(i, j));
+            const double correlation = expected / std::sqrt(reference.covariance(i, i) * reference.covariance(j, j));
+            ASSERT_NEAR(snapshot.correlation(i, j), correlation, 1e-9);
+        }
+    }
+    // Names sharing the market factor's sign move together, the others against
+    EXPECT_GT(snapshot.correlation(universe[1], universe[2]), 0.3);
+    EXPECT_LT(snapshot.correlation(universe[0], universe[1]), -0.3);
+}
+
+TEST(MarketStatisticsTest, CorrelationsBySymbol) {
+    auto universe = make_universe(3);
+    MarketStatistics statistics(MarketStatistics::Config{universe, std::chrono::milliseconds(100), 0.94});
+    EXPECT_EQ(statistics.correlation(universe[0], universe[1]), 0.0); // No samples yet
+
+    double a = 100.0;
+    for (int step = 0; step < 50; ++step) {
+        a *= (step % 2 == 0) ? 1.01 : 0.995;
+        statistics.on_price(universe[0], a);
+        statistics.on_price(universe[1], 2.0 * a);
+        statistics.on_price(universe[2], 10000.0 / a);
+        statistics.sample();
+    }
+
+    EXPECT_NEAR(statistics.correlation(universe[0], universe[1]), 1.0, 1e-9);
+    EXPECT_NEAR(statistics.correlation(universe[0], universe[2]), -1.0, 1e-9);
+    EXPECT_EQ(statistics.correlation(universe[0], universe[0]), 1.0);
+    EXPECT_EQ(statistics.correlation(universe[0], 42), 0.0); // Outside the universe
+
+    auto correlations = statistics.snapshot().correlations({universe[2], universe[0], 42, universe[1]});
+    ASSERT_EQ(correlations.size(), 3u);
+    EXPECT_NEAR((correlations[{universe[2], universe[0]}]), -1.0, 1e-9);
+    EXPECT_NEAR((correlations[{universe[0], universe[1]}]), 1.0, 1e-9);
+}
+
+TEST(MarketStatisticsTest, QuotesAreMarkedAtTheMid) {
+    auto universe = make_universe(2);
+    MarketStatistics statistics(MarketStatistics::Config{universe, std::chrono::milliseconds(100), 0.94});
+    QuoteMessage quote{};
+    quote.symbol_id = universe[0];
+    quote.bid_price = 99.0;
+    quote.ask_price = 101.0;
+    statistics.on_quote(quote);
+    statistics.sample();
+
+    quote.bid_price = 109.0;
+    quote.ask_price = 111.0;
+    statistics.on_quote(quote);
+    statistics.sample();
+    EXPECT_NEAR(statistics.snapshot().volatility(0), std::log(1.1), 1e-12);
+    EXPECT_EQ(statistics.snapshot().volatility(1), 0.0); // Never ticked
+}
+
+TEST(MarketStatisticsTest, SnapshotsStayConsistentWhileSampling) {
+    auto universe = make_universe(2);
+    MarketStatistics statistics(MarketStatistics::Config{universe, std::chrono::milliseconds(100), 0.94});
+    double price = 100.0;
+    auto step = [&]() {
+        price *= 1.01;
+        statistics.on_price(universe[0], price);
+        statistics.sample();
+    };
+    step();
+    step();
+
+    auto pinned = statistics.snapshot();
+    const double volatility = pinned.volatility(0);
+    step(); // Writes the other copy
+    EXPECT_EQ(pinned.samples(), 1u);
+    EXPECT_EQ(pinned.volatility(0), volatility);
+    EXPECT_EQ(statistics.snapshot().samples(), 2u);
+
+    // The next sample needs the pinned copy back and waits for it
+    std::atomic<bool> done{false};
+    std::thread sampler([&]() {
+        statistics.on_price(universe[0], price * 1.01);
+        statistics.sample();
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(done.load());
+    EXPECT_EQ(pinned.samples(), 1u);
+    { auto released = std::move(pinned); }
+    sampler.join();
+    EXPECT_TRUE(done.load());
+    EXPECT_EQ(statistics.snapshot().samples(), 3u);
+    EXPECT_EQ(statistics.get_stats().samples, 3u);
+}
+
+TEST(MarketStatisticsTest, RejectsBadConfiguration) {
+    EXPECT_THROW(MarketStatistics(MarketStatistics::Config{{1, 2}, std::chrono::milliseconds(100), 1.0}),
+                 std::invalid_argument);
+    EXPECT_THROW(MarketStatistics(MarketStatistics::Config{{1, 1}, std::chrono::milliseconds(100), 0.94}),
+                 std::invalid_argument);
+    EXPECT_THROW(MarketStatistics(MarketStatistics::Config{{1, 2}, std::chrono::milliseconds(0), 0.94}),
+                 std::invalid_argument);
+}
@@ -1,12 +1,312 @@
 #include <gtest/gtest.h>
+#include "../src/core/memory_pool.hpp"
+#include "../src/trading/order_store.hpp"
+#include "../src/trading/position_store.hpp"
+#include "allocation_counter.hpp"
+#include <atomic>
+#include <bit>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace goldearn;
+using namespace goldearn::core;
 
-// Placeholder memory pool test
 class MemoryPoolTest : public ::testing::Test {
 protected:
-    void SetUp() override {}
+    static trading::Order make_order(uint64_t id) {
+        trading::Order order{};
+        order.order_id = id;
+        order.client_order_id = id;
+        order.symbol_id = 1000 + (id % 50);
+        order.type = trading::OrderType::LIMIT;
+        order.side = (id % 2) ? trading::OrderSide::BUY : trading::OrderSide::SELL;
+        order.price = 2450.5;
+        order.quantity = 100;
+        order.status = trading::OrderStatus::PENDING;
+        order.strategy_id = "mm_nifty";
+        return order;
+    }
+
+    static trading::ExecutionReport make_fill(uint64_t order_id, uint64_t exec_id) {
+        trading::ExecutionReport fill{};
+        fill.order_id = order_id;
+        fill.execution_id = exec_id;
+        fill.executed_price = 2450.5;
+        fill.executed_quantity = 25;
+        fill.execution_venue = "NSE";
+        return fill;
+    }
+};
+
+TEST_F(MemoryPoolTest, FixedBlockPoolReusesBlocks) {
+    FixedBlockPool pool(48, 16, 8, 8, 4);
+    EXPECT_EQ(pool.block_size() % 16, 0u);
+    EXPECT_GE(pool.block_size(), 48u);
+
+    void* a = pool.allocate();
+    pool.deallocate(a);
+    void* b = pool.allocate();
+    EXPECT_EQ(a, b); // LIFO thread cache hands back the hottest block
+    pool.deallocate(b);
+    EXPECT_EQ(pool.slab_count(), 1u);
+}
+
+TEST_F(MemoryPoolTest, FixedBlockPoolGrowsAndRespectsGrowthLimit) {
+    FixedBlockPool pool(64, 64, 4, 4, 4);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 20; ++i) {
+        void* p = pool.allocate();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0u);
+        blocks.push_back(p);
+    }
+    EXPECT_GT(pool.slab_count(), 1u);
+    EXPECT_GE(pool.capacity(), 20u);
+
+    // All blocks are distinct
+    std::set<void*> unique(blocks.begin(), blocks.end());
+    EXPECT_EQ(unique.size(), blocks.size());
+
+    for (void* p : blocks) pool.deallocate(p);
+
+    FixedBlockPool bounded(32, 8, 2, 2, 2);
+    bounded.set_growth_enabled(false);
+    void* x = bounded.allocate();
+    void* y = bounded.allocate();
+    EXPECT_THROW(bounded.allocate(), std::bad_alloc);
+    bounded.deallocate(x);
+    bounded.deallocate(y);
+}
+
+namespace {
+struct Tracked {
+    static inline int live = 0;
+    int value;
+    explicit Tracked(int v) : value(v) { live++; }
+    ~Tracked() { live--; }
 };
+} // namespace
+
+TEST_F(MemoryPoolTest, ObjectPoolConstructsAndDestroys) {
+    Tracked::live = 0;
+
+    ObjectPool<Tracked> pool(16);
+    {
+        auto a = pool.make(1);
+        auto b = pool.make(2);
+        EXPECT_EQ(a->value, 1);
+        EXPECT_EQ(b->value, 2);
+        EXPECT_EQ(Tracked::live, 2);
+    }
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST_F(MemoryPoolTest, ObjectPoolIsThreadSafe) {
+    ObjectPool<trading::Order> pool(256, 256, 32);
+    constexpr int kThreads = 4;
+    constexpr int kIterations = 20000;
+    std::atomic<int> errors{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<trading::Order*> held;
+            for (int i = 0; i < kIterations; ++i) {
+                auto* order = pool.construct(make_order(t * kIterations + i));
+                held.push_back(order);
+                if (held.size() > 16) {
+                    // Free out of order, sometimes on a different thread's cache
+                    for (auto* o : held) {
+                        if (o->client_order_id != o->order_id) errors++;
+                        pool.destroy(o);
+                    }
+                    held.clear();
+                }
+            }
+            for (auto* o : held) pool.destroy(o);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(errors.load(), 0);
+}
+
+TEST_F(MemoryPoolTest, MonotonicArenaResetReusesMemory) {
+    MonotonicArena arena(1024, 1);
+    void* first = arena.allocate(100, 8);
+    for (int i = 0; i < 50; ++i) {
+        void* p = arena.allocate(100, 64);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0u);
+    }
+    size_t reserved = arena.bytes_reserved();
+    EXPECT_GT(reserved, 1024u);
+    EXPECT_GE(arena.bytes_used(), 5100u);
+
+    arena.reset();
+    EXPECT_EQ(arena.bytes_used(), 0u);
+    EXPECT_EQ(arena.allocate(100, 8), first);
+
+    // A second session of the same shape needs no new blocks
+    for (int i = 0; i < 50; ++i) arena.allocate(100, 64);
+    EXPECT_EQ(arena.bytes_reserved(), reserved);
+}
+
+TEST_F(MemoryPoolTest, MonotonicArenaCountsOversizedBlocks) {
+    MonotonicArena arena(1024, 1);
+    void* large = arena.allocate(8192, 8);
+    EXPECT_NE(large, nullptr);
+    EXPECT_GE(arena.bytes_reserved(), 1024u + 8192u);
+
+    // The oversized block is retained and reused after a reset
+    size_t reserved = arena.bytes_reserved();
+    arena.reset();
+    arena.allocate(100, 8);
+    arena.allocate(8192, 8);
+    EXPECT_EQ(arena.bytes_reserved(), reserved);
+}
+
+TEST_F(MemoryPoolTest, MonotonicArenaHonorsWideAlignment) {
+    MonotonicArena arena(4096, 1);
+    arena.allocate(8, 8);
+    for (int i = 0; i < 100; ++i) {
+        void* p = arena.allocate(72, 128);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 128, 0u);
+    }
+    void* page = arena.allocate(100, 4096);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(page) % 4096, 0u);
+}
+
+TEST_F(MemoryPoolTest, ArenaResourceBacksPmrContainers) {
+    MonotonicArena arena(64 * 1024);
+    ArenaResource resource(arena);
+    std::pmr::vector<int> values(&resource);
+    for (int i = 0; i < 1000; ++i) values.push_back(i);
+    EXPECT_EQ(values[999], 999);
+    EXPECT_GT(arena.bytes_used(), 0u);
+}
+
+TEST_F(MemoryPoolTest, PoolMemoryResourceSizeClasses) {
+    PoolMemoryResource resource(4);
+    void* small = resource.allocate(24, 8);
+    void* aligned = resource.allocate(40, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0u);
+    resource.deallocate(small, 24, 8);
+    resource.deallocate(aligned, 40, 64);
+    EXPECT_EQ(resource.upstream_allocations(), 0u);
+
+    void* large = resource.allocate(16384, 8);
+    EXPECT_EQ(resource.upstream_allocations(), 1u);
+    resource.deallocate(large, 16384, 8);
+
+    std::pmr::map<uint64_t, trading::Order> orders(&resource);
+    for (uint64_t i = 0; i < 100; ++i) orders.emplace(i, make_order(i));
+    EXPECT_EQ(orders.size(), 100u);
+    EXPECT_EQ(resource.upstream_allocations(), 1u);
+}
+
+// Stores reserve the classes their containers use for the capacity and
+// nothing else; an unused resource holds no slabs at all
+TEST_F(MemoryPoolTest, StoreResourcesReserveOnlyWhatTheirContainersUse) {
+    PoolMemoryResource idle;
+    EXPECT_EQ(idle.reserved_bytes(), 0u);
+    EXPECT_EQ(idle.slab_count(), 0u);
+
+    constexpr size_t kOrders = 65536;
+    constexpr size_t kExecutionBytes = trading::OrderStore::EXECUTIONS_RESERVED * sizeof(trading::ExecutionReport);
+    trading::OrderStore orders(kOrders);
+    EXPECT_GE(orders.memory().reserved_bytes(), kOrders * kExecutionBytes);
+    EXPECT_LE(orders.memory().reserved_bytes(), kOrders * (std::bit_ceil(kExecutionBytes) + 128));
+    EXPECT_EQ(orders.memory().slab_count(), 2u);
+
+    constexpr size_t kPositions = 8192;
+    trading::PositionStore positions(kPositions);
+    EXPECT_GT(positions.memory().reserved_bytes(), 0u);
+    EXPECT_LE(positions.memory().reserved_bytes(), kPositions * 64);
+    EXPECT_EQ(positions.memory().slab_count(), 1u);
+
+    // Filling to capacity draws on the reserved classes only
+    const size_t reserved = orders.memory().reserved_bytes();
+    for (uint64_t id = 1; id <= 1024; ++id) ASSERT_NE(orders.add(make_order(id)), nullptr);
+    EXPECT_LT(orders.memory().reserved_bytes(), reserved + reserved / 16);
+}
+
+// Steady-state order lifecycle through the stores OrderManager and
+// PositionManager keep their orders and positions in: adding, filling and
+// retiring orders and moving positions must not call the global allocator.
+TEST_F(MemoryPoolTest, SteadyStateOrderPathDoesNotMalloc) {
+    constexpr size_t kLiveOrders = 512;
+    constexpr size_t kFillsPerOrder = 4;
+
+    trading::OrderStore orders(kLiveOrders * 2);
+    trading::PositionStore positions(64);
+
+    auto run_cycle = [&](uint64_t base) {
+        for (uint64_t i = 0; i < kLiveOrders; ++i) {
+            ASSERT_NE(orders.add(make_order(base + i)), nullptr);
+        }
+        for (uint64_t i = 0; i < kLiveOrders; ++i) {
+            const uint64_t id = base + i;
+            for (size_t f = 0; f < kFillsPerOrder; ++f) {
+                ASSERT_TRUE(orders.add_execution(make_fill(id, id * 10 + f)));
+            }
+            const trading::ManagedOrder* order = orders.find(id);
+            positions.open(order->strategy_id, order->symbol_id).quantity += 100.0;
+        }
+        // Retire in a different order than added, so the index lists swap
+        for (uint64_t i = kLiveOrders; i > 0; i -= 2) {
+            ASSERT_TRUE(orders.remove(base + i - 1));
+        }
+        for (uint64_t i = 0; i < kLiveOrders; i += 2) {
+            ASSERT_TRUE(orders.remove(base + i));
+        }
+    };
+
+    // Warm-up grows the pools and thread caches to their working-set size
+    run_cycle(0);
+    run_cycle(1000000);
+    size_t slabs_after_warmup = orders.memory().slab_count();
+    uint64_t upstream_after_warmup = orders.memory().upstream_allocations();
+    size_t position_slabs_after_warmup = positions.memory().slab_count();
+
+    AllocationCounter counter;
+    for (uint64_t cycle = 2; cycle < 10; ++cycle) {
+        run_cycle(cycle * 1000000);
+    }
+    uint64_t mallocs = counter.count();
+
+    EXPECT_EQ(mallocs, 0u) << "Steady-state order path reached the global allocator";
+    EXPECT_EQ(orders.size(), 0u);
+    EXPECT_EQ(positions.size(), 50u);
+    EXPECT_EQ(orders.memory().slab_count(), slabs_after_warmup);
+    EXPECT_EQ(orders.memory().upstream_allocations(), upstream_after_warmup);
+    EXPECT_EQ(positions.memory().slab_count(), position_slabs_after_warmup);
+}
+
+TEST_F(MemoryPoolTest, OrderStoreIndexesByStrategyAndSymbol) {
+    trading::OrderStore orders(64);
+    for (uint64_t id = 1; id <= 6; ++id) {
+        trading::Order order = make_order(id);
+        order.strategy_id = id % 2 ? "odd" : "even";
+        order.symbol_id = 100 + id % 3;
+        ASSERT_NE(orders.add(order), nullptr);
+    }
+    EXPECT_EQ(orders.add(make_order(1)), nullptr) << "Duplicate order id";
+
+    ASSERT_TRUE(orders.remove(1));
+    EXPECT_FALSE(orders.remove(1));
+    EXPECT_EQ(orders.find(1), nullptr);
+    EXPECT_FALSE(orders.add_execution(make_fill(1, 1)));
+
+    std::set<uint64_t> odd(orders.strategy_orders("odd").begin(), orders.strategy_orders("odd").end());
+    EXPECT_EQ(odd, (std::set<uint64_t>{3, 5}));
+    std::set<uint64_t> symbol(orders.symbol_orders(101).begin(), orders.symbol_orders(101).end());
+    EXPECT_EQ(symbol, (std::set<uint64_t>{4}));
+    EXPECT_TRUE(orders.strategy_orders("missing").empty());
 
-TEST_F(MemoryPoolTest, BasicFunctionality) {
-    // Placeholder test - memory pool not implemented yet
-    EXPECT_TRUE(true);
-}
\ No newline at end of file
+    // The swapped-in ids still remove cleanly
+    for (uint64_t id = 2; id <= 6; ++id) ASSERT_TRUE(orders.remove(id));
+    EXPECT_TRUE(orders.strategy_orders("odd").empty());
+    EXPECT_TRUE(orders.symbol_orders(100).empty());
+    EXPECT_EQ(orders.size(), 0u);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "../src/core/perf_counters.hpp"
+#include "../src/core/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace goldearn::core;
+
+namespace {
+
+// Enough work per region for the counters to register something
+uint64_t busy_work(uint64_t seed) {
+    uint64_t x = seed;
+    for (int i = 0; i < 2000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return x;
+}
+
+const PerfCounters::ThreadReport* find_thread(const PerfCounters::Report& report, const std::string& name) {
+    auto it = std::find_if(report.threads.begin(), report.threads.end(),
+                           [&](const auto& thread) { return thread.thread == name; });
+    return it != report.threads.end() ? &*it : nullptr;
+}
+
+} // namespace
+
+TEST(PerfCountersTest, BuiltInRegionIdsAreStable) {
+    auto& counters = PerfCounters::instance();
+    EXPECT_EQ(counters.region_id("book_update"), perf_region::BOOK_UPDATE);
+    EXPECT_EQ(counters.region_id("risk_check"), perf_region::RISK_CHECK);
+    EXPECT_EQ(counters.region_id("strategy_callback"), perf_region::STRATEGY_CALLBACK);
+
+    uint32_t custom = counters.region_id("perf_test_custom");
+    EXPECT_GE(custom, 3u);
+    EXPECT_LT(custom, perf_region::MAX_REGIONS);
+    EXPECT_EQ(counters.region_id("perf_test_custom"), custom);
+}
+
+TEST(PerfCountersTest, RegistrationReportsOrDegrades) {
+    constexpr int kSamples = 200;
+    bool available = false;
+    std::atomic<uint64_t> sink{0};
+
+    std::thread hot([&]() {
+        available = PerfCounters::instance().register_thread("perf_test_hot");
+        EXPECT_EQ(PerfCounters::current() != nullptr, available);
+        for (int i = 0; i < kSamples; ++i) {
+            PERF_REGION(perf_region::BOOK_UPDATE);
+            sink += busy_work(i);
+        }
+        // Left registered: the thread-exit hook must release the counters
+    });
+    hot.join();
+
+    auto report = PerfCounters::instance().report();
+    const auto* thread = find_thread(report, "perf_test_hot");
+    ASSERT_NE(thread, nullptr);
+    EXPECT_EQ(thread->available, available);
+
+    auto region = std::find_if(report.regions.begin(), report.regions.end(), [](const auto& r) {
+        return r.thread == "perf_test_hot" && r.region == "book_update";
+    });
+    if (available) {
+        ASSERT_NE(region, report.regions.end());
+        EXPECT_EQ(region->samples, static_cast<uint64_t>(kSamples));
+        EXPECT_GT(region->instructions_per_sample, 2000.0);
+        EXPECT_GT(region->ipc, 0.0);
+    } else {
+        // No PMU or not permitted: a reason, and nothing measured
+        EXPECT_FALSE(thread->unavailable_reason.empty());
+        EXPECT_EQ(region, report.regions.end());
+    }
+}
+
+TEST(PerfCountersTest, UnregisteredRegionsAreNearlyFree) {
+    // Threads that never registered (or could not) pay a TLS load and a branch
+    constexpr int kIterations = 1000000;
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        PERF_REGION(perf_region::RISK_CHECK);
+        sink += static_cast<uint64_t>(i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                kIterations;
+    EXPECT_GT(sink, 0u);
+    EXPECT_LT(ns, 20.0);
+}
+
+TEST(PerfCountersTest, SpinThreadRegistersWhenEnabled) {
+    std::atomic<int> polls{0};
+    SpinThread spin("perf_test_spin", -1, [&]() {
+        PERF_REGION(perf_region::STRATEGY_CALLBACK);
+        polls++;
+        return true;
+    });
+    spin.set_perf_counters(true);
+    spin.start();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (polls.load() < 1000 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    spin.stop();
+
+    auto report = PerfCounters::instance().report();
+    EXPECT_NE(find_thread(report, "perf_test_spin"), nullptr);
+}
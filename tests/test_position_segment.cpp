@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+#include "../src/trading/position_segment.hpp"
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace goldearn::trading;
+using position_layout::PositionValues;
+
+namespace {
+
+PositionSegment::Config test_config(uint32_t capacity = 64, uint32_t journal_capacity = 256) {
+    PositionSegment::Config config;
+    config.name = "goldearn_positions_test_" + std::to_string(::getpid());
+    config.capacity = capacity;
+    config.journal_capacity = journal_capacity;
+    config.heartbeat_interval = std::chrono::milliseconds(0);
+    return config;
+}
+
+// Every field derived from one number, so a torn read shows as a mismatch
+PositionValues values_for(uint64_t n) {
+    PositionValues values;
+    values.quantity = static_cast<double>(n);
+    values.avg_entry_price = 2.0 * n;
+    values.market_price = 3.0 * n;
+    values.realized_pnl = 4.0 * n;
+    values.unrealized_pnl = 5.0 * n;
+    values.exposure = 6.0 * n;
+    values.trades = n;
+    return values;
+}
+
+bool consistent(const PositionValues& values) {
+    const uint64_t n = values.trades;
+    if (n == 0) {
+        // Never published (an overrun rereads those too): still all zero
+        const PositionValues untouched;
+        return std::memcmp(&values, &untouched, sizeof(values)) == 0;
+    }
+    return values.quantity == static_cast<double>(n) && values.avg_entry_price == 2.0 * n &&
+           values.market_price == 3.0 * n && values.realized_pnl == 4.0 * n &&
+           values.unrealized_pnl == 5.0 * n && values.exposure == 6.0 * n;
+}
+
+} // namespace
+
+TEST(PositionSegmentTest, ReaderSeesPublishedPositions) {
+    PositionSegment segment(test_config());
+    const uint32_t slot = segment.add_position("momentum", 101);
+    ASSERT_EQ(slot, 0u);
+    EXPECT_EQ(segment.add_position("momentum", 101), slot);
+    EXPECT_EQ(segment.add_position("pairs", 101), 1u);
+    segment.publish(slot, values_for(7));
+
+    // Opening reads everything already there
+    PositionFeedReader reader(test_config().name);
+    ASSERT_EQ(reader.positions().size(), 2u);
+    EXPECT_EQ(reader.positions()[0].strategy_id, "momentum");
+    EXPECT_EQ(reader.positions()[0].symbol_id, 101u);
+    EXPECT_EQ(reader.positions()[0].values.trades, 7u);
+    EXPECT_EQ(reader.writer_pid(), ::getpid());
+    EXPECT_TRUE(reader.writer_alive());
+    EXPECT_EQ(reader.poll(), 0u);
+
+    // A third position opens after the reader attached
+    const uint32_t third = segment.add_position("pairs", 202);
+    segment.publish(third, values_for(9));
+    EXPECT_EQ(reader.poll(), 1u);
+    ASSERT_EQ(reader.positions().size(), 3u);
+    EXPECT_EQ(reader.changed(), std::vector<uint32_t>{third});
+    EXPECT_EQ(reader.positions()[third].symbol_id, 202u);
+    EXPECT_TRUE(consistent(reader.positions()[third].values));
+    EXPECT_EQ(reader.positions()[third].values.trades, 9u);
+    EXPECT_GT(reader.positions()[third].update_ns, 0);
+}
+
+TEST(PositionSegmentTest, PollReadsEachChangedPositionOnce) {
+    PositionSegment segment(test_config());
+    const uint32_t a = segment.add_position("momentum", 1);
+    const uint32_t b = segment.add_position("momentum", 2);
+    segment.add_position("momentum", 3);
+    PositionFeedReader reader(test_config().name);
+
+    for (uint64_t n = 1; n <= 10; ++n) {
+        segment.publish(a, values_for(n));
+    }
+    segment.publish(b, values_for(20));
+
+    EXPECT_EQ(reader.poll(), 2u);
+    EXPECT_EQ(reader.positions()[a].values.trades, 10u);
+    EXPECT_EQ(reader.positions()[b].values.trades, 20u);
+    const auto staleness = reader.staleness();
+    EXPECT_EQ(staleness.records_read, 2u);
+    EXPECT_EQ(staleness.journal_lag, 0u);
+    EXPECT_EQ(staleness.overruns, 0u);
+    EXPECT_GE(staleness.max_record_age_ns, staleness.last_record_age_ns);
+
+    EXPECT_EQ(reader.poll(), 0u);
+    EXPECT_TRUE(reader.changed().empty());
+}
+
+TEST(PositionSegmentTest, FallingAJournalBehindRereadsEverything) {
+    PositionSegment segment(test_config(8, 16));
+    for (uint64_t symbol = 0; symbol < 4; ++symbol) {
+        segment.add_position("momentum", symbol);
+    }
+    PositionFeedReader reader(test_config().name);
+
+    for (uint64_t n = 1; n <= 100; ++n) {
+        segment.publish(static_cast<uint32_t>(n % 4), values_for(n));
+    }
+    EXPECT_EQ(reader.staleness().journal_lag, 100u);
+
+    EXPECT_EQ(reader.poll(), 4u);
+    EXPECT_EQ(reader.staleness().overruns, 1u);
+    EXPECT_EQ(reader.staleness().journal_lag, 0u);
+    for (uint32_t slot = 0; slot < 4; ++slot) {
+        EXPECT_EQ(reader.positions()[slot].values.trades, 96u + (slot == 0 ? 4u : slot));
+    }
+
+    // Back on the journal afterwards
+    segment.publish(2, values_for(200));
+    EXPECT_EQ(reader.poll(), 1u);
+    EXPECT_EQ(reader.staleness().overruns, 1u);
+}
+
+TEST(PositionSegmentTest, FullSegmentRejectsNewPositions) {
+    PositionSegment segment(test_config(2));
+    EXPECT_EQ(segment.add_position("momentum", 1), 0u);
+    EXPECT_EQ(segment.add_position("momentum", 2), 1u);
+    EXPECT_EQ(segment.add_position("momentum", 3), position_layout::INVALID_SLOT);
+    segment.publish(position_layout::INVALID_SLOT, values_for(1));
+    EXPECT_EQ(segment.published(), 0u);
+
+    PositionSegment::Config bad = test_config(0);
+    EXPECT_THROW(PositionSegment{bad}, std::invalid_argument);
+}
+
+TEST(PositionSegmentTest, HeartbeatAgeTracksTheWriter) {
+    PositionSegment segment(test_config());
+    PositionFeedReader reader(test_config().name);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_GE(reader.staleness().heartbeat_age_ns, 20000000);
+    segment.heartbeat();
+    EXPECT_LT(reader.staleness().heartbeat_age_ns, 20000000);
+}
+
+TEST(PositionSegmentTest, LiveSegmentIsNotReplaced) {
+    auto original = std::make_unique<PositionSegment>(test_config());
+    original->heartbeat();
+    const uint32_t slot = original->add_position("momentum", 101);
+    EXPECT_THROW(PositionSegment{test_config()}, std::runtime_error);
+    original->publish(slot, values_for(3));
+    EXPECT_EQ(PositionFeedReader(test_config().name).positions().size(), 1u);
+
+    // A writer whose heartbeat has gone quiet counts as hung
+    PositionSegment::Config config = test_config();
+    config.stale_after = std::chrono::milliseconds(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    PositionSegment successor(config);
+    EXPECT_TRUE(PositionFeedReader(test_config().name).positions().empty());
+
+    // The old writer going away leaves its successor's segment in place
+    original.reset();
+    EXPECT_NO_THROW(PositionFeedReader{test_config().name});
+}
+
+TEST(PositionSegmentTest, SegmentOfAnExitedWriterIsReplaced) {
+    const PositionSegment::Config config = test_config(); // Named after this process
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        PositionSegment abandoned(config);
+        abandoned.add_position("momentum", 101);
+        ::_exit(0); // Without the destructor: the segment stays behind
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_EQ(PositionFeedReader(config.name).writer_pid(), child);
+
+    PositionSegment segment(config);
+    PositionFeedReader reader(config.name);
+    EXPECT_EQ(reader.writer_pid(), ::getpid());
+    EXPECT_TRUE(reader.positions().empty());
+}
+
+TEST(PositionSegmentTest, ReaderRejectsOtherFiles) {
+    EXPECT_THROW(PositionFeedReader("goldearn_positions_missing_" + std::to_string(::getpid())),
+                 std::runtime_error);
+
+    const std::string path = "/dev/shm/goldearn_positions_junk_" + std::to_string(::getpid());
+    FILE* file = std::fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    std::vector<char> junk(8192, 'x');
+    std::fwrite(junk.data(), 1, junk.size(), file);
+    std::fclose(file);
+    EXPECT_THROW(PositionFeedReader{path}, std::runtime_error);
+    ::unlink(path.c_str());
+}
+
+// A record left mid-write (its writer died there) is given up on rather than
+// waited for; the reader keeps its last copy until the record is whole again
+TEST(PositionSegmentTest, RecordStuckMidWriteKeepsTheLastCopy) {
+    PositionSegment segment(test_config());
+    const uint32_t slot = segment.add_position("momentum", 101);
+    segment.publish(slot, values_for(1));
+    PositionFeedReader reader(test_config().name);
+
+    int fd = ::open(segment.path().c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    struct stat st;
+    ASSERT_EQ(::fstat(fd, &st), 0);
+    void* mapping = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(mapping, MAP_FAILED);
+    const auto* header = static_cast<const position_layout::Header*>(mapping);
+    auto* records = reinterpret_cast<position_layout::Record*>(static_cast<std::byte*>(mapping) +
+                                                                header->records_offset);
+    {
+        goldearn::core::Seqlock::WriteGuard stuck(records[slot].sequence);
+        segment.publish(slot, values_for(2));
+        EXPECT_EQ(reader.poll(), 0u);
+        EXPECT_EQ(reader.positions()[slot].values.trades, 1u);
+        EXPECT_EQ(reader.staleness().seqlock_retries, 1u);
+    }
+    ::munmap(mapping, st.st_size);
+
+    segment.publish(slot, values_for(3));
+    EXPECT_EQ(reader.poll(), 1u);
+    EXPECT_TRUE(consistent(reader.positions()[slot].values));
+    EXPECT_EQ(reader.positions()[slot].values.trades, 3u);
+}
+
+// Writers on several threads, each owning its positions, against a polling
+// reader: every record read is whole and the last values all arrive
+TEST(PositionSegmentTest, ConcurrentWritersNeverTearRecords) {
+    constexpr uint32_t kWriters = 4;
+    constexpr uint32_t kPositionsPerWriter = 8;
+    constexpr uint64_t kUpdates = 50000;
+
+    PositionSegment segment(test_config(kWriters * kPositionsPerWriter, 1024));
+    std::vector<uint32_t> slots;
+    for (uint32_t i = 0; i < kWriters * kPositionsPerWriter; ++i) {
+        slots.push_back(segment.add_position("writer" + std::to_string(i / kPositionsPerWriter), i));
+    }
+    PositionFeedReader reader(test_config().name);
+
+    std::atomic<uint32_t> done{0};
+    std::vector<std::thread> writers;
+    for (uint32_t w = 0; w < kWriters; ++w) {
+        writers.emplace_back([&, w]() {
+            for (uint64_t n = 1; n <= kUpdates; ++n) {
+                segment.publish(slots[w * kPositionsPerWriter + n % kPositionsPerWriter], values_for(n));
+            }
+            done.fetch_add(1);
+        });
+    }
+
+    size_t torn = 0;
+    auto check = [&]() {
+        for (uint32_t slot : reader.changed()) {
+            torn += !consistent(reader.positions()[slot].values);
+        }
+    };
+    while (done.load() < kWriters) {
+        reader.poll();
+        check();
+    }
+    for (auto& writer : writers) writer.join();
+    reader.poll();
+    check();
+
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(reader.staleness().journal_lag, 0u);
+    EXPECT_EQ(segment.published(), kWriters * kUpdates);
+    for (uint32_t w = 0; w < kWriters; ++w) {
+        for (uint32_t p = 0; p < kPositionsPerWriter; ++p) {
+            const uint64_t last = kUpdates - (kUpdates - p) % kPositionsPerWriter;
+            EXPECT_EQ(reader.positions()[slots[w * kPositionsPerWriter + p]].values.trades, last);
+        }
+    }
+}
@@ -1,12 +1,949 @@
 #include <gtest/gtest.h>
+#include "../src/risk/risk_state_table.hpp"
+#include "../src/risk/greeks_engine.hpp"
+#include "../src/risk/span_margin.hpp"
+#include "../src/risk/incremental_var.hpp"
+#include "../src/market_data/market_statistics.hpp"
+#include "../src/config/config_manager.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+using namespace goldearn::risk;
+using goldearn::trading::OrderSide;
 
-// Placeholder pre-trade checks test
 class PreTradeChecksTest : public ::testing::Test {
 protected:
-    void SetUp() override {}
+    static constexpr uint64_t kSecond = 1000000000ULL;
+
+    void SetUp() override {
+        RiskLimits limits;
+        limits.max_position_size = 1000;
+        limits.max_order_size = 500;
+        limits.max_order_value = 50000;
+        limits.max_strategy_exposure = 150000;
+        limits.max_portfolio_exposure = 250000;
+        limits.max_orders_per_second = 5;
+        limits.max_orders_per_minute = 20;
+        table.apply_limits(limits);
+        strategy = table.add_strategy("mm_reliance");
+        symbol = table.add_symbol(2885);
+    }
+
+    RiskStateTable table{4, 16};
+    uint32_t strategy = 0;
+    uint32_t symbol = 0;
+    uint64_t now = 100 * kSecond;
 };
 
 TEST_F(PreTradeChecksTest, BasicFunctionality) {
-    // Placeholder test - pre-trade checks not implemented yet
-    EXPECT_TRUE(true);
-}
\ No newline at end of file
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 10, now), RiskCheckResult::APPROVED);
+}
+
+TEST_F(PreTradeChecksTest, RegistrationIsIdempotentAndBounded) {
+    EXPECT_EQ(table.add_strategy("mm_reliance"), strategy);
+    EXPECT_EQ(table.strategy_index("mm_reliance"), strategy);
+    EXPECT_EQ(table.strategy_index("unknown"), RiskStateTable::INVALID_INDEX);
+    EXPECT_EQ(table.add_symbol(2885), symbol);
+    EXPECT_EQ(table.symbol_index(2885), symbol);
+    EXPECT_EQ(table.symbol_index(1), RiskStateTable::INVALID_INDEX);
+
+    for (uint64_t id = 1; id < 16; ++id) {
+        EXPECT_NE(table.add_symbol(id), RiskStateTable::INVALID_INDEX);
+    }
+    EXPECT_EQ(table.add_symbol(99), RiskStateTable::INVALID_INDEX);
+    EXPECT_EQ(table.symbol_count(), 16u);
+    for (uint64_t id = 1; id < 16; ++id) {
+        EXPECT_EQ(table.symbol_index(id), id);
+    }
+}
+
+TEST_F(PreTradeChecksTest, OrderSizeAndValue) {
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 501, now), RiskCheckResult::REJECTED_ORDER_SIZE);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 200.0, 300, now), RiskCheckResult::REJECTED_ORDER_SIZE);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 500, now), RiskCheckResult::APPROVED);
+}
+
+TEST_F(PreTradeChecksTest, PositionHeadroomAllowsReducing) {
+    table.set_position(strategy, symbol, 900, 10.0);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 101, now), RiskCheckResult::REJECTED_POSITION_LIMIT);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 100, now), RiskCheckResult::APPROVED);
+
+    // Tightened below the current position: only reducing orders pass
+    RiskLimits tight;
+    tight.max_position_size = 500;
+    table.apply_limits(tight);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 1, now + kSecond), RiskCheckResult::REJECTED_POSITION_LIMIT);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::SELL, 10.0, 400, now + kSecond), RiskCheckResult::APPROVED);
+}
+
+TEST_F(PreTradeChecksTest, PriceBandFromSymbolUpdate) {
+    goldearn::market_data::SymbolUpdateMessage message;
+    std::memset(&message, 0, sizeof(message));
+    message.symbol_id = 2885;
+    message.lower_circuit = 90.0;
+    message.upper_circuit = 110.0;
+    table.on_symbol_update(message);
+
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 110.5, 1, now), RiskCheckResult::REJECTED_PRICE_LIMIT);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::SELL, 89.0, 1, now), RiskCheckResult::REJECTED_PRICE_LIMIT);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 110.0, 1, now), RiskCheckResult::APPROVED);
+
+    // A strategy registered later sees the band too
+    uint32_t late = table.add_strategy("late");
+    EXPECT_EQ(table.check_order(late, symbol, OrderSide::BUY, 120.0, 1, now), RiskCheckResult::REJECTED_PRICE_LIMIT);
+
+    // A symbol update for an unknown symbol registers it
+    message.symbol_id = 1594;
+    table.on_symbol_update(message);
+    EXPECT_NE(table.symbol_index(1594), RiskStateTable::INVALID_INDEX);
+}
+
+TEST_F(PreTradeChecksTest, ExposureTracksFills) {
+    uint32_t other = table.add_strategy("stat_arb");
+    uint32_t infy = table.add_symbol(1594);
+
+    table.on_fill(strategy, symbol, OrderSide::BUY, 100.0, 500);
+    table.on_fill(strategy, symbol, OrderSide::BUY, 100.0, 500);
+    EXPECT_DOUBLE_EQ(table.position(strategy, symbol), 1000);
+    EXPECT_DOUBLE_EQ(table.strategy_exposure(strategy), 100000);
+
+    // Strategy limit 150k: another 600 x 100 would reach 160k
+    EXPECT_EQ(table.check_order(strategy, infy, OrderSide::SELL, 100.0, 499, now), RiskCheckResult::APPROVED);
+    table.on_fill(strategy, infy, OrderSide::SELL, 100.0, 450);
+    EXPECT_EQ(table.check_order(strategy, infy, OrderSide::SELL, 100.0, 100, now), RiskCheckResult::REJECTED_EXPOSURE_LIMIT);
+    // Reducing never adds exposure
+    EXPECT_EQ(table.check_order(strategy, infy, OrderSide::BUY, 100.0, 450, now), RiskCheckResult::APPROVED);
+
+    // Portfolio limit 250k: the other strategy only has 105k left
+    EXPECT_DOUBLE_EQ(table.portfolio_exposure(), 145000);
+    table.on_fill(other, symbol, OrderSide::BUY, 100.0, 500);
+    table.on_fill(other, symbol, OrderSide::BUY, 100.0, 500);
+    EXPECT_EQ(table.check_order(other, infy, OrderSide::BUY, 100.0, 100, now), RiskCheckResult::REJECTED_EXPOSURE_LIMIT);
+
+    // Flattening releases it
+    table.on_fill(strategy, symbol, OrderSide::SELL, 100.0, 500);
+    table.on_fill(strategy, symbol, OrderSide::SELL, 100.0, 500);
+    EXPECT_DOUBLE_EQ(table.strategy_exposure(strategy), 45000);
+    EXPECT_EQ(table.check_order(other, infy, OrderSide::BUY, 100.0, 100, now), RiskCheckResult::APPROVED);
+}
+
+TEST_F(PreTradeChecksTest, RateWindowsCountApprovedOrders) {
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now + i), RiskCheckResult::APPROVED);
+    }
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now + 10), RiskCheckResult::REJECTED_RATE_LIMIT);
+    // Rejections are not counted: one second after the first order, one slot frees up
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now + kSecond), RiskCheckResult::APPROVED);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now + kSecond), RiskCheckResult::REJECTED_RATE_LIMIT);
+
+    // 20 per minute: 6 so far, 14 more over the next seconds, then blocked
+    uint64_t t = now + 2 * kSecond;
+    for (int i = 0; i < 14; ++i, t += kSecond) {
+        EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, t), RiskCheckResult::APPROVED);
+    }
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, t), RiskCheckResult::REJECTED_RATE_LIMIT);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now + 60 * kSecond), RiskCheckResult::APPROVED);
+}
+
+TEST_F(PreTradeChecksTest, BlacklistAndHaltTakePrecedenceOrder) {
+    table.set_symbol_blocked(symbol, true);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now), RiskCheckResult::REJECTED_BLACKLIST);
+    // An order size breach is reported first, like the sequential checks
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 501, now), RiskCheckResult::REJECTED_ORDER_SIZE);
+    table.set_symbol_blocked(symbol, false);
+
+    table.set_strategy_blocked(strategy, true);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 100.0, 1, now), RiskCheckResult::REJECTED_BLACKLIST);
+    table.set_strategy_blocked(strategy, false);
+
+    table.set_halted(true);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::SELL, 100.0, 1, now), RiskCheckResult::REJECTED_CIRCUIT_BREAKER);
+    table.set_halted(false);
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::SELL, 100.0, 1, now), RiskCheckResult::APPROVED);
+}
+
+TEST_F(PreTradeChecksTest, KeysRegisteredBlockedArePublishedBlocked) {
+    uint32_t halted = table.add_symbol(77, true);
+    EXPECT_EQ(table.check_order(strategy, halted, OrderSide::BUY, 100.0, 1, now), RiskCheckResult::REJECTED_BLACKLIST);
+    uint32_t late = table.add_strategy("late");
+    EXPECT_EQ(table.check_order(late, halted, OrderSide::BUY, 100.0, 1, now), RiskCheckResult::REJECTED_BLACKLIST);
+    uint32_t barred = table.add_strategy("barred", true);
+    EXPECT_EQ(table.check_order(barred, symbol, OrderSide::BUY, 100.0, 1, now), RiskCheckResult::REJECTED_BLACKLIST);
+    // A known key keeps its flag
+    EXPECT_EQ(table.add_symbol(77), halted);
+    EXPECT_EQ(table.check_order(strategy, halted, OrderSide::BUY, 100.0, 1, now), RiskCheckResult::REJECTED_BLACKLIST);
+}
+
+// Symbols blacklisted while they are being registered end up blocked
+// whichever side runs first
+TEST_F(PreTradeChecksTest, BlacklistRacingRegistrationStillBlocks) {
+    constexpr uint64_t kSymbols = 500;
+    RiskEngine engine;
+    engine.register_strategy("momentum");
+    std::thread registrar([&]() {
+        for (uint64_t id = 1; id <= kSymbols; ++id) engine.register_symbol(id);
+    });
+    for (uint64_t id = 1; id <= kSymbols; ++id) engine.add_symbol_to_blacklist(id, "suspended");
+    registrar.join();
+
+    goldearn::trading::Order order{};
+    order.side = OrderSide::BUY;
+    order.price = 100.0;
+    order.quantity = 1;
+    order.strategy_id = "momentum";
+    size_t unblocked = 0;
+    for (uint64_t id = 1; id <= kSymbols; ++id) {
+        order.symbol_id = id;
+        unblocked += engine.quick_pre_trade_check(order) != RiskCheckResult::REJECTED_BLACKLIST;
+    }
+    EXPECT_EQ(unblocked, 0u);
+}
+
+TEST_F(PreTradeChecksTest, RiskEngineRoutesRegisteredOrdersThroughTable) {
+    RiskEngine engine;
+    RiskLimits limits;
+    limits.max_orders_per_second = 2;
+    engine.set_risk_limits(limits);
+    engine.add_symbol_to_blacklist(13, "suspended");
+    uint32_t s = engine.register_strategy("momentum");
+    engine.register_symbol(2885);
+    engine.register_symbol(13);
+    ASSERT_NE(s, RiskStateTable::INVALID_INDEX);
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 2885;
+    order.side = OrderSide::BUY;
+    order.price = 100.0;
+    order.quantity = 10;
+    order.strategy_id = "momentum";
+    PreTradeContext context;
+    context.order = &order;
+
+    order.symbol_id = 13;
+    EXPECT_EQ(engine.quick_pre_trade_check(order), RiskCheckResult::REJECTED_BLACKLIST);
+    engine.remove_symbol_from_blacklist(13);
+    EXPECT_EQ(engine.quick_pre_trade_check(order), RiskCheckResult::APPROVED);
+
+    order.symbol_id = 2885;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_RATE_LIMIT);
+
+    // Unregistered strategies keep the sequential checks
+    order.strategy_id = "unregistered";
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 2885;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 100.0;
+    fill.executed_quantity = 10;
+    engine.on_fill("momentum", fill);
+    EXPECT_DOUBLE_EQ(engine.risk_state().position(s, engine.risk_state().symbol_index(2885)), 10);
+}
+
+// Market orders carry no price: they are checked at the expected fill for
+// their unfilled quantity, like the limit order at that price
+TEST_F(PreTradeChecksTest, MarketOrdersAreCheckedAtTheReferencePrice) {
+    RiskEngine engine;
+    RiskLimits limits;
+    limits.max_order_size = 1e6;
+    limits.max_order_value = 1e6;
+    limits.max_orders_per_second = 1000;
+    limits.max_orders_per_minute = 1000;
+    engine.set_risk_limits(limits);
+    engine.register_strategy("momentum");
+    engine.register_symbol(2885);
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 2885;
+    order.side = OrderSide::BUY;
+    order.type = goldearn::trading::OrderType::MARKET;
+    order.quantity = 9000; // 9M at 1000
+    order.strategy_id = "momentum";
+    PreTradeContext context;
+    context.order = &order;
+    context.current_market_price = 1000.0;
+
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_ORDER_SIZE);
+    EXPECT_EQ(engine.quick_pre_trade_check(order, 1000.0), RiskCheckResult::REJECTED_ORDER_SIZE);
+    // Nothing to value it at
+    EXPECT_EQ(engine.quick_pre_trade_check(order), RiskCheckResult::REJECTED_PRICE_LIMIT);
+
+    // Only the unfilled part counts
+    order.filled_quantity = 8500;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    EXPECT_EQ(engine.quick_pre_trade_check(order, 1000.0), RiskCheckResult::APPROVED);
+
+    // Inside the circuit band at the expected fill
+    goldearn::market_data::SymbolUpdateMessage message;
+    std::memset(&message, 0, sizeof(message));
+    message.symbol_id = 2885;
+    message.lower_circuit = 900.0;
+    message.upper_circuit = 1100.0;
+    engine.on_symbol_update(message);
+    context.estimated_fill_price = 1001.0;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    EXPECT_EQ(engine.quick_pre_trade_check(order, 1001.0), RiskCheckResult::APPROVED);
+    context.estimated_fill_price = 1150.0;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_PRICE_LIMIT);
+    EXPECT_EQ(engine.quick_pre_trade_check(order, 1150.0), RiskCheckResult::REJECTED_PRICE_LIMIT);
+}
+
+TEST(LimitSnapshotTest, NamedUpdatesResolveSymbolThenStrategyThenGlobal) {
+    LimitSnapshot base;
+    auto next = base.next_version();
+    EXPECT_TRUE(next->set("max_order_size", 500));
+    EXPECT_TRUE(next->set("strategy.momentum.max_order_size", 200));
+    EXPECT_TRUE(next->set("strategy.momentum.max_orders_per_second", 3));
+    EXPECT_TRUE(next->set("symbol.2885.max_order_size", 1000));
+    EXPECT_FALSE(next->set("max_order_sizes", 1));
+    EXPECT_FALSE(next->set("symbol.abc.max_order_size", 1));
+    EXPECT_FALSE(next->set("max_order_value", -1));
+    EXPECT_FALSE(next->set("max_order_value", std::nan("")));
+    EXPECT_FALSE(next->set("max_order_value", std::numeric_limits<double>::infinity()));
+
+    // Integer fields take whole numbers within their type's range
+    EXPECT_FALSE(next->set("max_orders_per_second", 2.5));
+    EXPECT_FALSE(next->set("max_orders_per_minute", 4294967296.0));
+    EXPECT_FALSE(next->set("strategy.momentum.max_consecutive_losses", 1e300));
+    EXPECT_FALSE(next->set("order_lifetime_limit_ms", 18446744073709551616.0));
+    EXPECT_TRUE(next->set("max_orders_per_minute", 4294967295.0));
+    EXPECT_EQ(next->global().max_orders_per_minute, UINT32_MAX);
+    EXPECT_TRUE(next->set("order_lifetime_limit_ms", 1e15));
+    EXPECT_EQ(next->global().order_lifetime_limit_ms, 1000000000000000u);
+    EXPECT_EQ(next->get("strategy.momentum.max_consecutive_losses"), std::nullopt);
+
+    EXPECT_EQ(base.version(), 1u);
+    EXPECT_EQ(next->version(), 2u);
+    EXPECT_DOUBLE_EQ(base.global().max_order_size, RiskLimits().max_order_size);
+    EXPECT_DOUBLE_EQ(next->resolve("other", 13).max_order_size, 500);
+    EXPECT_DOUBLE_EQ(next->resolve("momentum", 13).max_order_size, 200);
+    EXPECT_DOUBLE_EQ(next->resolve("momentum", 2885).max_order_size, 1000);
+    EXPECT_EQ(next->resolve("momentum", 2885).max_orders_per_second, 3u);
+    EXPECT_EQ(next->get("strategy.momentum.max_order_size"), 200);
+    EXPECT_EQ(next->get("strategy.momentum.max_order_value"), std::nullopt);
+    EXPECT_EQ(next->get("max_order_value"), RiskLimits().max_order_value);
+}
+
+TEST_F(PreTradeChecksTest, DecisionsReportTheLimitsVersionTheyUsed) {
+    uint64_t first = table.limits_version();
+    uint64_t used = 0;
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 400, now, used), RiskCheckResult::APPROVED);
+    EXPECT_EQ(used, first);
+
+    // Overrides for a strategy registered later and for this symbol
+    auto limits = LimitSnapshot(RiskLimits(), first).next_version();
+    limits->set("max_order_size", 500);
+    limits->set("max_orders_per_second", 100);
+    limits->set("strategy.arb.max_order_size", 50);
+    limits->set("symbol.2885.max_order_size", 800);
+    table.apply_limits(*limits);
+    uint32_t arb = table.add_strategy("arb");
+    uint32_t other = table.add_symbol(13);
+
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 700, now, used), RiskCheckResult::APPROVED);
+    EXPECT_EQ(used, first + 1);
+    EXPECT_EQ(table.check_order(strategy, other, OrderSide::BUY, 10.0, 700, now), RiskCheckResult::REJECTED_ORDER_SIZE);
+    EXPECT_EQ(table.check_order(arb, other, OrderSide::BUY, 10.0, 60, now), RiskCheckResult::REJECTED_ORDER_SIZE);
+    EXPECT_EQ(table.check_order(arb, symbol, OrderSide::BUY, 10.0, 60, now), RiskCheckResult::APPROVED);
+}
+
+// The rate ring remembers RATE_WINDOW orders: a larger limit would be
+// enforced as RATE_WINDOW, so it is refused and the last limits stay
+TEST_F(PreTradeChecksTest, RateLimitsAboveTheWindowAreRefused) {
+    uint64_t version = table.limits_version();
+    RiskLimits limits;
+    limits.max_orders_per_minute = RiskStateTable::RATE_WINDOW + 1;
+    EXPECT_FALSE(table.apply_limits(limits));
+    EXPECT_EQ(table.limits_version(), version);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 1, now), RiskCheckResult::APPROVED);
+    }
+    EXPECT_EQ(table.check_order(strategy, symbol, OrderSide::BUY, 10.0, 1, now), RiskCheckResult::REJECTED_RATE_LIMIT);
+
+    RiskEngine engine;
+    version = engine.get_limits_version();
+    EXPECT_FALSE(engine.update_risk_limit("strategy.momentum.max_orders_per_minute", 5000));
+    EXPECT_FALSE(engine.update_risk_limit("max_orders_per_second", 2000));
+    EXPECT_EQ(engine.get_limits_version(), version);
+    EXPECT_EQ(engine.get_limit_snapshot().get("strategy.momentum.max_orders_per_minute"), std::nullopt);
+    EXPECT_TRUE(engine.update_risk_limit("max_orders_per_minute", RiskStateTable::RATE_WINDOW));
+    EXPECT_EQ(engine.risk_state().limits_version(), version + 1);
+}
+
+TEST(RiskEngineLimitsTest, UpdatesByNameAndFromConfigPublishNewVersions) {
+    RiskEngine engine;
+    engine.register_strategy("momentum");
+    engine.register_symbol(2885);
+    goldearn::trading::Order order{};
+    order.symbol_id = 2885;
+    order.side = OrderSide::BUY;
+    order.price = 100.0;
+    order.quantity = 10;
+    order.strategy_id = "momentum";
+
+    uint64_t version = engine.get_limits_version();
+    EXPECT_EQ(engine.quick_pre_trade_check(order), RiskCheckResult::APPROVED);
+    EXPECT_TRUE(engine.update_risk_limit("strategy.momentum.max_order_value", 500));
+    EXPECT_EQ(engine.get_limits_version(), version + 1);
+    EXPECT_EQ(engine.risk_state().limits_version(), version + 1);
+    EXPECT_EQ(engine.quick_pre_trade_check(order), RiskCheckResult::REJECTED_ORDER_SIZE);
+
+    // A bad name publishes nothing
+    EXPECT_FALSE(engine.update_risk_limits({{"max_order_value", 1e6}, {"no_such_limit", 1}}));
+    EXPECT_EQ(engine.get_limits_version(), version + 1);
+
+    // Global limits replace the global set and keep overrides
+    RiskLimits limits;
+    limits.max_order_size = 5;
+    engine.set_risk_limits(limits);
+    EXPECT_EQ(engine.get_risk_limits().max_order_size, 5);
+    EXPECT_EQ(engine.get_limit_snapshot().get("strategy.momentum.max_order_value"), 500);
+
+    goldearn::config::ConfigManager config;
+    config.set_string("risk_limits", "strategy.momentum.max_order_value", "1000000");
+    config.set_string("risk_limits", "max_order_size", "100");
+    EXPECT_EQ(engine.load_risk_limits(config), 2u);
+    EXPECT_EQ(engine.get_limits_version(), version + 3);
+    EXPECT_EQ(engine.quick_pre_trade_check(order), RiskCheckResult::APPROVED);
+}
+
+TEST(RiskEngineVaRTest, OrdersArePricedAgainstTheIncrementalVaR) {
+    RiskEngine engine;
+    engine.portfolio_var().set_model({7, 8}, {0.05, 0.05}, {1.0, 0.5, 0.5, 1.0});
+
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 7;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 1000.0;
+    fill.executed_quantity = 4000;
+    engine.on_fill("momentum", fill);
+    const double z = 1.6448536269514722;
+    EXPECT_NEAR(engine.calculate_portfolio_var(1), z * 0.05 * 4e6, 1e-6);
+    EXPECT_NEAR(engine.calculate_portfolio_var(10), z * 0.05 * 4e6 * std::sqrt(10.0), 1e-6);
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 7;
+    order.side = OrderSide::BUY;
+    order.price = 1000.0;
+    order.quantity = 900;
+    order.strategy_id = "momentum";
+    PreTradeContext context;
+    context.order = &order;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    // 1-day VaR would reach z * 0.05 * 4.9e6 = 403k
+    EXPECT_TRUE(engine.update_risk_limit("max_var_1d", 350000));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_VAR_LIMIT);
+    // Orders that lower VaR go through above the limit
+    order.side = OrderSide::SELL;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    order.symbol_id = 8;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    order.side = OrderSide::BUY;
+    order.quantity = 300;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED); // 329k -> 342k
+
+    // The 10-day limit applies through sqrt(10)
+    EXPECT_TRUE(engine.update_risk_limit("max_var_10d", 1000000));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_VAR_LIMIT);
+
+    // Past the limit after a fill: post-trade monitoring records it
+    EXPECT_TRUE(engine.update_risk_limit("max_var_1d", 300000));
+    PostTradeContext post_trade;
+    post_trade.execution = &fill;
+    uint32_t violations = engine.get_violation_count(ViolationSeverity::WARNING);
+    engine.monitor_post_trade(post_trade);
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::WARNING), violations + 1);
+}
+
+// The engine builds its VaR model from the market statistics once they have
+// enough samples; registered orders are then checked against it
+TEST(RiskEngineVaRTest, ModelIsBuiltFromMarketStatistics) {
+    using goldearn::market_data::MarketStatistics;
+    auto statistics = std::make_shared<MarketStatistics>(
+        MarketStatistics::Config{{7, 8}, std::chrono::milliseconds(100), 0.94});
+    double a = 1000.0, b = 500.0;
+    auto sample = [&](int steps) {
+        for (int i = 0; i < steps; ++i) {
+            a *= i % 2 ? 0.99 : 1.01;
+            b *= i % 3 ? 1.005 : 0.99;
+            statistics->on_price(7, a);
+            statistics->on_price(8, b);
+            statistics->sample();
+        }
+    };
+
+    RiskEngine engine;
+    RiskLimits limits;
+    limits.max_orders_per_second = 1000;
+    limits.max_orders_per_minute = 1000;
+    engine.set_risk_limits(limits);
+    engine.register_strategy("momentum");
+    engine.register_symbol(7);
+
+    // Too few samples: no model, VaR reads zero
+    sample(50);
+    engine.set_market_statistics(statistics);
+    EXPECT_EQ(engine.portfolio_var().dimension(), 0u);
+
+    sample(RiskEngine::MIN_VAR_MODEL_SAMPLES);
+    engine.set_market_statistics(statistics);
+    ASSERT_EQ(engine.portfolio_var().dimension(), 2u);
+
+    // Daily volatility from per-sample figures: 22500 trading seconds / 0.1s
+    double daily_volatility;
+    {
+        auto snapshot = statistics->snapshot();
+        daily_volatility = snapshot.volatility(0) * std::sqrt(225000.0);
+    }
+    const double z = 1.6448536269514722;
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 7;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 1000.0;
+    fill.executed_quantity = 10;
+    engine.on_fill("momentum", fill);
+    EXPECT_NEAR(engine.calculate_portfolio_var(1), z * daily_volatility * 1e4, 1e-6 * z * daily_volatility * 1e4);
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 7;
+    order.side = OrderSide::BUY;
+    order.price = 1000.0;
+    order.quantity = 10;
+    order.strategy_id = "momentum";
+    PreTradeContext context;
+    context.order = &order;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    order.quantity = static_cast<uint64_t>(2.0 * limits.max_var_1d / (z * daily_volatility * 1000.0)) + 10;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_VAR_LIMIT);
+    order.side = OrderSide::SELL;
+    order.quantity = 10;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+}
+
+// Registered strategies and symbols take the combined check; the Greeks and
+// margin limits reach it through the strategy's index
+TEST(RiskEngineRegisteredTest, AddOnLimitsApplyToRegisteredOrders) {
+    RiskEngine engine;
+    RiskLimits limits;
+    limits.max_orders_per_second = 1000;
+    limits.max_orders_per_minute = 1000;
+    engine.set_risk_limits(limits);
+    const int64_t now = 1750000000LL * 1000000000LL;
+
+    GreeksEngine::Contract call;
+    call.contract_id = 40001;
+    call.underlying_id = 26000;
+    call.strike = 24000;
+    call.expiry_ns = now + 7 * 86400000000000LL;
+    call.multiplier = 75;
+    GreeksEngine& greeks = engine.greeks();
+    greeks.add_contract(call);
+    greeks.set_valuation_time(now);
+    greeks.set_underlying_price(26000, 24000.0);
+    greeks.set_underlying_volatility(26000, 0.14);
+    greeks.recompute();
+    const double delta_notional = 10 * 75 * greeks.greeks(40001).delta * 24000.0;
+
+    SpanMargin::Contract future;
+    future.contract_id = 35001;
+    future.underlying_id = 26000;
+    future.expiry_ns = now + 30 * 86400000000000LL;
+    future.multiplier = 75;
+    SpanMargin& span = engine.margin();
+    span.add_contract(future);
+    span.load_risk_parameters({{26000, 24000.0, 0.06, 0.04, 0.14, 0.0, 0.0}}, now);
+    const double per_lot = span.risk_array(35001)[12];
+
+    ASSERT_NE(engine.register_strategy("fno_arb"), RiskStateTable::INVALID_INDEX);
+    ASSERT_NE(engine.register_symbol(40001), RiskStateTable::INVALID_INDEX);
+    ASSERT_NE(engine.register_symbol(35001), RiskStateTable::INVALID_INDEX);
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 40001;
+    order.side = OrderSide::BUY;
+    order.price = 300.0;
+    order.quantity = 10;
+    order.strategy_id = "fno_arb";
+    PreTradeContext context;
+    context.order = &order;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    // A strategy override of the underlying limit, then a tighter symbol one
+    EXPECT_TRUE(engine.update_risk_limit("strategy.fno_arb.max_underlying_delta", 0.5 * delta_notional));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_GREEKS_LIMIT);
+    EXPECT_TRUE(engine.update_risk_limits({{"strategy.fno_arb.max_underlying_delta", 1e12},
+                                           {"symbol.26000.max_underlying_delta", 0.5 * delta_notional}}));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_GREEKS_LIMIT);
+    EXPECT_TRUE(engine.update_risk_limit("symbol.26000.max_underlying_delta", 2.0 * delta_notional));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    // Margin of the strategy's own portfolio, created at registration
+    order.symbol_id = 35001;
+    order.price = 24100.0;
+    order.quantity = 4;
+    EXPECT_TRUE(engine.update_risk_limit("strategy.fno_arb.max_portfolio_margin", 3.5 * per_lot));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_MARGIN_LIMIT);
+    order.quantity = 3;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 35001;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 24100.0;
+    fill.executed_quantity = 5;
+    engine.on_fill("fno_arb", fill);
+    order.quantity = 1;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_MARGIN_LIMIT);
+    order.side = OrderSide::SELL;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+}
+
+// Only orders every check approves use up the rate window: a registered
+// order rejected by the VaR check is never sent
+TEST(RiskEngineRegisteredTest, OrdersRejectedByAddOnChecksDoNotUseTheRateWindow) {
+    RiskEngine engine;
+    RiskLimits limits;
+    limits.max_orders_per_second = 2;
+    limits.max_orders_per_minute = 100;
+    limits.max_var_1d = 1000;
+    engine.set_risk_limits(limits);
+    engine.portfolio_var().set_model({7}, {0.05}, {1.0});
+    ASSERT_NE(engine.register_strategy("momentum"), RiskStateTable::INVALID_INDEX);
+    ASSERT_NE(engine.register_symbol(7), RiskStateTable::INVALID_INDEX);
+    ASSERT_NE(engine.register_symbol(9), RiskStateTable::INVALID_INDEX);
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 7;
+    order.side = OrderSide::BUY;
+    order.price = 1000.0;
+    order.quantity = 100;
+    order.strategy_id = "momentum";
+    PreTradeContext context;
+    context.order = &order;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_VAR_LIMIT);
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_VAR_LIMIT);
+
+    // Symbol 9 is outside the VaR model: within every limit
+    order.symbol_id = 9;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_RATE_LIMIT);
+}
+
+// A breach that lasts many monitoring passes is recorded once when it starts
+// and once when it clears
+TEST(RiskEngineMonitoringTest, GreeksBreachesAreRecordedOnTransitions) {
+    RiskEngine engine;
+    const int64_t now = 1750000000LL * 1000000000LL;
+    GreeksEngine::Contract call;
+    call.contract_id = 40001;
+    call.underlying_id = 26000;
+    call.strike = 24000;
+    call.expiry_ns = now + 7 * 86400000000000LL;
+    call.multiplier = 75;
+    GreeksEngine& greeks = engine.greeks();
+    greeks.add_contract(call);
+    greeks.set_valuation_time(now);
+    greeks.set_underlying_price(26000, 24000.0);
+    greeks.set_underlying_volatility(26000, 0.14);
+
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 40001;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 300.0;
+    fill.executed_quantity = 10;
+    engine.on_fill("fno_arb", fill);
+    greeks.recompute();
+    const double delta_notional = 10 * 75 * greeks.greeks(40001).delta * 24000.0;
+
+    const uint32_t warnings = engine.get_violation_count(ViolationSeverity::WARNING);
+    const uint32_t all = engine.get_violation_count(ViolationSeverity::INFO);
+    EXPECT_TRUE(engine.update_risk_limit("symbol.26000.max_underlying_delta", 0.5 * delta_notional));
+    for (int pass = 0; pass < 5; ++pass) {
+        engine.run_monitoring_pass();
+    }
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::WARNING), warnings + 1);
+
+    EXPECT_TRUE(engine.update_risk_limit("symbol.26000.max_underlying_delta", 2.0 * delta_notional));
+    engine.run_monitoring_pass();
+    engine.run_monitoring_pass();
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::WARNING), warnings + 1);
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::INFO), all + 2);
+
+    // Breached again: a new episode
+    EXPECT_TRUE(engine.update_risk_limit("symbol.26000.max_underlying_delta", 0.5 * delta_notional));
+    engine.run_monitoring_pass();
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::WARNING), warnings + 2);
+}
+
+TEST(RiskEngineMonitoringTest, MarginBreachesAreRecordedOncePerStrategy) {
+    RiskEngine engine;
+    const int64_t now = 1750000000LL * 1000000000LL;
+    SpanMargin::Contract future;
+    future.contract_id = 35001;
+    future.underlying_id = 26000;
+    future.expiry_ns = now + 30 * 86400000000000LL;
+    future.multiplier = 75;
+    SpanMargin& span = engine.margin();
+    span.add_contract(future);
+    span.load_risk_parameters({{26000, 24000.0, 0.06, 0.04, 0.14, 0.0, 0.0}}, now);
+    const double per_lot = span.risk_array(35001)[12];
+    engine.register_strategy("fno_arb");
+    engine.register_strategy("hedger");
+
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 35001;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 24100.0;
+    fill.executed_quantity = 5;
+    engine.on_fill("fno_arb", fill);
+    engine.on_fill("hedger", fill);
+
+    const uint32_t warnings = engine.get_violation_count(ViolationSeverity::WARNING);
+    EXPECT_TRUE(engine.update_risk_limit("strategy.fno_arb.max_portfolio_margin", 3.5 * per_lot));
+    for (int pass = 0; pass < 5; ++pass) {
+        engine.run_monitoring_pass();
+    }
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::WARNING), warnings + 1);
+    auto recorded = engine.get_recent_violations(1);
+    ASSERT_FALSE(recorded.empty());
+    EXPECT_EQ(recorded.back().violation_type, RiskCheckResult::REJECTED_MARGIN_LIMIT);
+    EXPECT_EQ(recorded.back().strategy_id, "fno_arb");
+
+    const uint32_t all = engine.get_violation_count(ViolationSeverity::INFO);
+    EXPECT_TRUE(engine.update_risk_limit("strategy.fno_arb.max_portfolio_margin", 10.0 * per_lot));
+    engine.run_monitoring_pass();
+    engine.run_monitoring_pass();
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::WARNING), warnings + 1);
+    EXPECT_EQ(engine.get_violation_count(ViolationSeverity::INFO), all + 1);
+    recorded = engine.get_recent_violations(1);
+    EXPECT_EQ(recorded.back().severity, ViolationSeverity::INFO);
+    EXPECT_EQ(recorded.back().strategy_id, "fno_arb");
+}
+
+namespace {
+
+// Orders checked one at a time, in order, with the quick checks
+std::vector<uint8_t> check_one_by_one(const FastPreTradeChecker& checker, const std::vector<uint64_t>& symbols,
+                                      const std::vector<double>& signed_quantities, const std::vector<double>& prices,
+                                      std::unordered_map<uint64_t, double> positions, double exposure,
+                                      const RiskLimits& limits) {
+    std::vector<uint8_t> approved;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        double position = positions[symbols[i]];
+        double quantity = signed_quantities[i];
+        double added = std::max(std::fabs(position + quantity) - std::fabs(position), 0.0) * prices[i];
+        bool ok = std::fabs(quantity) <= limits.max_order_size &&
+                  checker.quick_order_size_check(std::fabs(quantity) * prices[i]) &&
+                  checker.quick_position_check(symbols[i], quantity, position) &&
+                  checker.quick_exposure_check(added, exposure) && checker.quick_blacklist_check(symbols[i], "basket");
+        if (ok) {
+            positions[symbols[i]] += quantity;
+            exposure += added;
+        }
+        approved.push_back(ok);
+    }
+    return approved;
+}
+
+} // namespace
+
+TEST(FastPreTradeCheckerTest, BatchMatchesOrderByOrderChecks) {
+    RiskLimits limits;
+    limits.max_position_size = 5000;
+    limits.max_order_size = 2000;
+    limits.max_order_value = 150000;
+    limits.max_portfolio_exposure = 2000000;
+    FastPreTradeChecker checker(limits);
+    checker.add_symbol_to_blacklist(7);
+
+    std::mt19937_64 rng(42);
+    OrderBatch batch;
+    std::vector<uint8_t> approved;
+    size_t exposure_rejections = 0;
+    for (int round = 0; round < 500; ++round) {
+        size_t n = rng() % 204;
+        // Every fourth round reuses a few symbols, so repeats take the sequential path
+        uint64_t universe = round % 4 == 0 ? 8 : 100000;
+        double exposure = static_cast<double>(rng() % 2000000);
+        std::vector<uint64_t> symbols;
+        std::vector<double> quantities, prices;
+        std::unordered_map<uint64_t, double> positions;
+        batch.clear();
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t symbol = rng() % universe;
+            if (!positions.count(symbol)) positions[symbol] = static_cast<double>(rng() % 10000) - 5000.0;
+            double quantity = static_cast<double>(rng() % 2500 + 1);
+            double price = 10.0 + static_cast<double>(rng() % 900);
+            auto side = rng() % 2 ? goldearn::trading::OrderSide::BUY : goldearn::trading::OrderSide::SELL;
+            batch.add(symbol, side, price, quantity, positions[symbol]);
+            symbols.push_back(symbol);
+            quantities.push_back(side == goldearn::trading::OrderSide::BUY ? quantity : -quantity);
+            prices.push_back(price);
+        }
+        EXPECT_EQ(batch.has_repeated_symbols(), std::set<uint64_t>(symbols.begin(), symbols.end()).size() < n);
+
+        approved.assign(n, 0);
+        size_t count = checker.check_batch(batch, exposure, approved.data());
+        auto expected = check_one_by_one(checker, symbols, quantities, prices, positions, exposure, limits);
+        ASSERT_EQ(approved, expected) << "round " << round << ", " << n << " orders";
+        EXPECT_EQ(count, static_cast<size_t>(std::count(expected.begin(), expected.end(), 1)));
+
+        // Orders that passed everything else but the cumulative exposure
+        for (size_t i = 0; i < n; ++i) {
+            bool alone = checker.quick_exposure_check(std::fabs(quantities[i]) * prices[i], exposure);
+            exposure_rejections += alone && !approved[i] && symbols[i] != 7;
+        }
+    }
+    EXPECT_GT(exposure_rejections, 0u);
+}
+
+TEST(FastPreTradeCheckerTest, BatchCheckOrdersUsesPositionsAndBlacklists) {
+    RiskLimits limits;
+    limits.max_position_size = 1000;
+    limits.max_portfolio_exposure = 100000;
+    FastPreTradeChecker checker(limits);
+    checker.set_position(1, 950);
+    checker.set_current_exposure(60000);
+    checker.add_strategy_to_blacklist("halted");
+
+    std::vector<goldearn::trading::Order> orders(5);
+    for (auto& order : orders) {
+        order.symbol_id = 2;
+        order.side = goldearn::trading::OrderSide::BUY;
+        order.price = 100.0;
+        order.quantity = 100;
+        order.strategy_id = "basket";
+    }
+    orders[0].symbol_id = 1;         // 950 + 100 > 1000
+    orders[1].strategy_id = "halted"; // Rejected, takes no exposure
+    // Orders 2..4 add 10k each on top of 60k; the limit allows all three
+    orders[4].quantity = 300;        // ...but not this one at 30k
+
+    auto result = checker.batch_check_orders(orders);
+    EXPECT_EQ(result, (std::vector<bool>{false, false, true, true, false}));
+
+    limits.max_portfolio_exposure = 200000;
+    checker.update_limits(limits);
+    EXPECT_EQ(checker.limits_version(), 2u);
+    result = checker.batch_check_orders(orders);
+    EXPECT_EQ(result, (std::vector<bool>{false, false, true, true, true}));
+}
+
+TEST(RiskEngineGreeksTest, OptionOrdersAreCheckedAgainstUnderlyingLimits) {
+    RiskEngine engine;
+    const int64_t now = 1750000000LL * 1000000000LL;
+    GreeksEngine::Contract call;
+    call.contract_id = 40001;
+    call.underlying_id = 26000;
+    call.strike = 24000;
+    call.expiry_ns = now + 7 * 86400000000000LL;
+    call.multiplier = 75;
+    GreeksEngine& greeks = engine.greeks();
+    greeks.add_contract(call);
+    greeks.set_valuation_time(now);
+    greeks.set_underlying_price(26000, 24000.0);
+    greeks.set_underlying_volatility(26000, 0.14);
+    greeks.recompute();
+    const double delta = greeks.greeks(40001).delta; // About 0.5
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 40001;
+    order.side = OrderSide::BUY;
+    order.price = 300.0;
+    order.quantity = 10;
+    order.strategy_id = "options_mm";
+    PreTradeContext context;
+    context.order = &order;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    // 10 x 75 x delta x 24000 of delta notional against a tighter per-underlying limit
+    const double notional = 10 * 75 * delta * 24000.0;
+    EXPECT_TRUE(engine.update_risk_limit("symbol.26000.max_underlying_delta", 0.5 * notional));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_GREEKS_LIMIT);
+
+    // A short position already over the limit: buying back reduces it and passes
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 40001;
+    fill.side = OrderSide::SELL;
+    fill.executed_price = 300.0;
+    fill.executed_quantity = 20;
+    engine.on_fill("options_mm", fill);
+    EXPECT_NEAR(greeks.sensitivities(26000).delta_notional(), -2 * notional, 1e-6 * notional);
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    order.side = OrderSide::SELL;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_GREEKS_LIMIT);
+
+    // Vega on its own; non-option symbols are untouched by these limits
+    order.side = OrderSide::BUY;
+    EXPECT_TRUE(engine.update_risk_limits({{"symbol.26000.max_underlying_delta", 1e12},
+                                           {"max_underlying_gamma", 1e12},
+                                           {"max_underlying_vega", 1.0}}));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED); // Buying back lowers |vega|
+    order.quantity = 100;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_GREEKS_LIMIT);
+    order.symbol_id = 26000;
+    order.quantity = 10;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+}
+
+TEST(RiskEngineMarginTest, DerivativeOrdersAreCheckedAgainstStrategyMargin) {
+    RiskEngine engine;
+    const int64_t now = 1750000000LL * 1000000000LL;
+    SpanMargin::Contract future;
+    future.contract_id = 35001;
+    future.underlying_id = 26000;
+    future.expiry_ns = now + 30 * 86400000000000LL;
+    future.multiplier = 75;
+    SpanMargin& span = engine.margin();
+    span.add_contract(future);
+    span.load_risk_parameters({{26000, 24000.0, 0.06, 0.04, 0.14, 0.0, 0.0}}, now);
+    const double per_lot = span.risk_array(35001)[12]; // About 24000 x 6% x 75
+
+    goldearn::trading::Order order{};
+    order.symbol_id = 35001;
+    order.side = OrderSide::BUY;
+    order.price = 24100.0;
+    order.quantity = 4;
+    order.strategy_id = "fno_arb";
+    PreTradeContext context;
+    context.order = &order;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    const double capital = engine.get_risk_limits().max_portfolio_margin;
+    EXPECT_DOUBLE_EQ(engine.get_available_buying_power(), capital);
+
+    // Three lots of room for this strategy
+    EXPECT_TRUE(engine.update_risk_limit("strategy.fno_arb.max_portfolio_margin", 3.5 * per_lot));
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_MARGIN_LIMIT);
+    order.quantity = 3;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    // Fills block margin; an order that unwinds passes even past the limit
+    goldearn::trading::ExecutionReport fill{};
+    fill.symbol_id = 35001;
+    fill.side = OrderSide::BUY;
+    fill.executed_price = 24100.0;
+    fill.executed_quantity = 5;
+    engine.on_fill("fno_arb", fill);
+    EXPECT_NEAR(span.margin("fno_arb").total, 5 * per_lot, 1e-6 * per_lot);
+    EXPECT_NEAR(engine.get_available_buying_power(), capital - 5 * per_lot, 1e-6 * per_lot);
+    order.quantity = 1;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::REJECTED_MARGIN_LIMIT);
+    order.side = OrderSide::SELL;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+
+    // Other strategies and cash symbols are not affected
+    order.side = OrderSide::BUY;
+    order.strategy_id = "other";
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+    order.strategy_id = "fno_arb";
+    order.symbol_id = 26000;
+    EXPECT_EQ(engine.check_pre_trade_risk(context), RiskCheckResult::APPROVED);
+}
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 #include "../src/monitoring/prometheus_metrics.hpp"
+#include "../src/core/rcu.hpp"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
 
 class PrometheusMetricsTest : public ::testing::Test {
 protected:
@@ -21,4 +27,236 @@ TEST_F(PrometheusMetricsTest, MetricsRecording) {
     
     std::string snapshot = metrics_collector->get_metrics_snapshot();
     EXPECT_FALSE(snapshot.empty());
-}
\ No newline at end of file
+}
+
+using goldearn::monitoring::Histogram;
+using goldearn::monitoring::Summary;
+
+TEST_F(PrometheusMetricsTest, HistogramBucketLookupMatchesLinearScan) {
+    Histogram histogram("test_lookup", "lookup", {5, 1, 10, 2.5, 1});
+    const auto& bounds = histogram.buckets();
+    ASSERT_EQ(bounds, (std::vector<double>{1, 2.5, 5, 10}));
+
+    for (double value : {-1.0, 0.0, 1.0, 1.5, 2.5, 2.6, 5.0, 9.99, 10.0, 10.01, 1e9}) {
+        size_t expected = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+        EXPECT_EQ(histogram.bucket_index(value), expected) << value;
+    }
+    EXPECT_EQ(histogram.bucket_index(std::numeric_limits<double>::quiet_NaN()), bounds.size());
+}
+
+TEST_F(PrometheusMetricsTest, HistogramMergesShardsFromManyThreads) {
+    Histogram histogram("test_sharded", "sharded", {1, 10, 100});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&histogram]() {
+            for (int i = 0; i < 10000; ++i) {
+                histogram.observe(static_cast<double>(i % 200));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    auto snap = histogram.snapshot();
+    EXPECT_EQ(snap.count, 80000u);
+    // Per thread: 0,1 -> le 1 (100 each of 2 values); 2..10 -> le 10; 11..100; 101..199 -> +Inf
+    EXPECT_EQ(snap.cumulative_counts[0], 8u * 100);
+    EXPECT_EQ(snap.cumulative_counts[1], 8u * 550);
+    EXPECT_EQ(snap.cumulative_counts[2], 8u * 5050);
+    EXPECT_EQ(snap.cumulative_counts[3], 80000u);
+    EXPECT_DOUBLE_EQ(snap.sum, 8.0 * 50 * (199.0 * 200 / 2));
+
+    std::string text = histogram.serialize();
+    EXPECT_NE(text.find("test_sharded_bucket{le=\"+Inf\"} 80000"), std::string::npos);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.snapshot().count, 0u);
+}
+
+TEST_F(PrometheusMetricsTest, HistogramCountsAreExactBeyondShardCount) {
+    // More live threads than exclusive shards: the rest share the atomic one
+    Histogram histogram("test_overflow", "overflow", {1});
+    constexpr int kThreads = static_cast<int>(goldearn::monitoring::metrics_detail::SHARDS) + 8;
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            histogram.observe(0.5);
+            ready++;
+            while (ready.load() < kThreads) std::this_thread::yield();
+            for (int i = 0; i < 5000; ++i) histogram.observe(0.5);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(histogram.snapshot().count, static_cast<uint64_t>(kThreads) * 5001);
+}
+
+TEST_F(PrometheusMetricsTest, SummaryStreamingQuantilesAreAccurate) {
+    Summary summary("test_summary", "summary");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&summary, t]() {
+            for (int i = 1 + t; i <= 100000; i += 4) {
+                summary.observe(static_cast<double>(i));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(summary.count(), 100000u);
+    EXPECT_DOUBLE_EQ(summary.sum(), 100000.0 * 100001 / 2);
+    for (double q : {0.5, 0.9, 0.99}) {
+        double exact = q * 100000;
+        EXPECT_NEAR(summary.quantile(q), exact, exact * 0.02) << q;
+    }
+
+    EXPECT_NE(summary.serialize().find("test_summary{quantile=\"0.99\"}"), std::string::npos);
+}
+
+TEST_F(PrometheusMetricsTest, SummaryWindowExpiresOldObservations) {
+    Summary summary("test_window", "window", std::chrono::seconds(1));
+    for (int i = 0; i < 100; ++i) summary.observe(1000.0);
+    EXPECT_NEAR(summary.quantile(0.5), 1000.0, 20.0);
+
+    // Each scrape at least max_age / 2 apart rotates one half-window out
+    std::this_thread::sleep_for(std::chrono::milliseconds(550));
+    EXPECT_NEAR(summary.quantile(0.5), 1000.0, 20.0);
+    summary.observe(2.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(550));
+    EXPECT_NEAR(summary.quantile(0.5), 2.0, 0.05);
+    EXPECT_EQ(summary.count(), 101u); // Count and sum stay cumulative
+}
+
+// Sketches are allocated by the first observation on a shard: a summary
+// scraped, rotated and reset before that reads zeros
+TEST_F(PrometheusMetricsTest, SummaryBeforeFirstObservation) {
+    Summary summary("test_idle", "idle", std::chrono::seconds(0));
+    EXPECT_EQ(summary.quantile(0.5), 0.0);
+    EXPECT_EQ(summary.quantile(0.99), 0.0);
+    summary.reset();
+    EXPECT_NE(summary.serialize().find("test_idle{quantile=\"0.5\"} 0"), std::string::npos);
+
+    summary.observe(7.0);
+    EXPECT_NEAR(summary.quantile(0.5), 7.0, 0.15);
+    EXPECT_EQ(summary.count(), 1u);
+}
+
+// Scrapes rotating on every call while observers run: the windows they read
+// hold only real observations and no observation is lost from the count
+TEST_F(PrometheusMetricsTest, SummaryRotatesUnderConcurrentObservers) {
+    Summary summary("test_rotation", "rotation", std::chrono::seconds(0));
+    constexpr int kThreads = 4;
+    constexpr int kObservations = 50000;
+    std::atomic<int> running{kThreads};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kObservations; ++i) summary.observe(5.0);
+            running.fetch_sub(1);
+        });
+    }
+    int bad = 0;
+    while (running.load() > 0) {
+        double median = summary.quantile(0.5);
+        bad += median != 0.0 && std::abs(median - 5.0) > 0.1;
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(bad, 0);
+    EXPECT_EQ(summary.count(), static_cast<uint64_t>(kThreads) * kObservations);
+    summary.reset();
+    EXPECT_EQ(summary.quantile(0.5), 0.0);
+}
+
+using goldearn::monitoring::Counter;
+using goldearn::monitoring::MetricsRegistry;
+
+TEST_F(PrometheusMetricsTest, LabeledFamilyRendersEachSeries) {
+    auto& registry = MetricsRegistry::instance();
+    auto orders = registry.create_counter_family("test_orders_total", "Orders by symbol", {"symbol", "side"});
+    auto latency = registry.create_histogram_family("test_fill_latency_us", "Fill latency", {"symbol"}, {10, 100});
+
+    auto reliance_buy = orders->with_labels({"RELIANCE", "buy"});
+    reliance_buy->increment(3);
+    orders->with_labels({"TCS", "sell"})->increment();
+    EXPECT_EQ(orders->with_labels({"RELIANCE", "buy"}), reliance_buy); // Same child on lookup
+    latency->with_labels({"TCS"})->observe(42);
+
+    std::string text = registry.serialize_all();
+    EXPECT_NE(text.find("# TYPE test_orders_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("test_orders_total{symbol=\"RELIANCE\",side=\"buy\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_orders_total{symbol=\"TCS\",side=\"sell\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_fill_latency_us_bucket{symbol=\"TCS\",le=\"10\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_fill_latency_us_bucket{symbol=\"TCS\",le=\"100\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_fill_latency_us_sum{symbol=\"TCS\"} 42\n"), std::string::npos);
+
+    EXPECT_THROW(orders->with_labels({"RELIANCE"}), std::invalid_argument);
+    registry.remove_metric("test_orders_total");
+    registry.remove_metric("test_fill_latency_us");
+    EXPECT_EQ(registry.serialize_all().find("test_orders_total"), std::string::npos);
+}
+
+TEST_F(PrometheusMetricsTest, LabelSetsAreInternedAndEscaped) {
+    auto& registry = MetricsRegistry::instance();
+    auto a = registry.create_gauge_family("test_gauge_a", "a", {"symbol"});
+    auto b = registry.create_gauge_family("test_gauge_b", "b", {"symbol"});
+    a->with_labels({"INFY"});
+    b->with_labels({"INFY"});
+    a->with_labels({"we\"ird\\name"})->set(1.5);
+
+    const std::string* label_a = nullptr;
+    const std::string* label_b = nullptr;
+    a->for_each([&](const auto&, const std::string& labels) { if (!label_a) label_a = &labels; });
+    b->for_each([&](const auto&, const std::string& labels) { if (!label_b) label_b = &labels; });
+    EXPECT_EQ(label_a, label_b);
+    EXPECT_NE(a->render().find("test_gauge_a{symbol=\"we\\\"ird\\\\name\"} 1.5\n"), std::string::npos);
+
+    registry.remove_metric("test_gauge_a");
+    registry.remove_metric("test_gauge_b");
+}
+
+TEST_F(PrometheusMetricsTest, OnlyChangedFamiliesAreRerendered) {
+    auto& registry = MetricsRegistry::instance();
+    auto family = registry.create_counter_family("test_cached_total", "cached", {"symbol"});
+    auto counter = family->with_labels({"SBIN"});
+
+    const std::string& first = family->render();
+    const char* data = first.data();
+    std::string copy = first;
+
+    // Clean: cached text returned untouched
+    EXPECT_EQ(family->render(), copy);
+    EXPECT_EQ(family->render().data(), data);
+
+    counter->increment();
+    EXPECT_NE(family->render().find("test_cached_total{symbol=\"SBIN\"} 1\n"), std::string::npos);
+
+    family->with_labels({"HDFC"});
+    EXPECT_NE(family->render().find("test_cached_total{symbol=\"HDFC\"} 0\n"), std::string::npos);
+    registry.remove_metric("test_cached_total");
+}
+
+// Removed and replaced families are unlinked and freed, so churn does not
+// grow the scrape list
+TEST_F(PrometheusMetricsTest, RemovedFamiliesDoNotAccumulate) {
+    auto& registry = MetricsRegistry::instance();
+    const size_t families = registry.family_count();
+    std::atomic<bool> done{false};
+    std::thread scraper([&]() {
+        while (!done.load()) registry.serialize_all();
+    });
+    for (int i = 0; i < 1000; ++i) {
+        registry.create_counter("test_churn_total", "churn")->increment();
+        registry.create_gauge("test_churn_total", "churn replaced")->set(i);
+        registry.create_gauge_family("test_churn_gauge", "churn", {"symbol"})->with_labels({"TCS"});
+        registry.remove_metric("test_churn_gauge");
+        EXPECT_LE(registry.family_count(), families + 1);
+    }
+    done = true;
+    scraper.join();
+
+    EXPECT_NE(registry.serialize_all().find("test_churn_total 999\n"), std::string::npos);
+    registry.remove_metric("test_churn_total");
+    EXPECT_EQ(registry.family_count(), families);
+    goldearn::core::Rcu::instance().reclaim();
+    EXPECT_EQ(goldearn::core::Rcu::instance().pending(), 0u);
+}
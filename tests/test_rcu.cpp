@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "../src/core/rcu.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace goldearn::core;
+
+namespace {
+
+constexpr uint32_t kMaxObjects = 1 << 16;
+std::atomic<bool> g_freed[kMaxObjects];
+
+struct Versioned {
+    uint32_t id;
+    explicit Versioned(uint32_t object_id) : id(object_id) { g_freed[id].store(false); }
+    ~Versioned() { g_freed[id].store(true); }
+};
+
+} // namespace
+
+TEST(RcuTest, RetiredObjectOutlivesReadersThatCanSeeIt) {
+    RcuPointer<Versioned> pointer(std::make_unique<Versioned>(1));
+    std::atomic<int> stage{0};
+
+    std::thread reader([&]() {
+        RcuReadGuard guard;
+        const Versioned* seen = pointer.load();
+        stage.store(1);
+        while (stage.load() != 2) {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(seen->id, 1u);
+        EXPECT_FALSE(g_freed[1].load());
+    });
+    while (stage.load() != 1) {
+        std::this_thread::yield();
+    }
+
+    pointer.publish(std::make_unique<Versioned>(2));
+    EXPECT_EQ(pointer.load()->id, 2u);
+    Rcu::instance().reclaim();
+    EXPECT_FALSE(g_freed[1].load()); // The reader is still inside its guard
+    EXPECT_GE(Rcu::instance().pending(), 1u);
+
+    stage.store(2);
+    reader.join();
+    Rcu::instance().reclaim();
+    EXPECT_TRUE(g_freed[1].load());
+    EXPECT_FALSE(g_freed[2].load());
+}
+
+TEST(RcuTest, NestedGuardsAndReadersOnOtherThreads) {
+    RcuPointer<Versioned> pointer(std::make_unique<Versioned>(10));
+    {
+        RcuReadGuard outer;
+        {
+            RcuReadGuard inner;
+            EXPECT_EQ(pointer.load()->id, 10u);
+        }
+        // Still inside the outer guard: the old version must stay
+        pointer.publish(std::make_unique<Versioned>(11));
+        EXPECT_FALSE(g_freed[10].load());
+    }
+    Rcu::instance().reclaim();
+    EXPECT_TRUE(g_freed[10].load());
+
+    // A reader on another thread keeps the version that was current when it entered
+    std::atomic<bool> release{false};
+    std::atomic<bool> reading{false};
+    std::thread reader([&]() {
+        RcuReadGuard guard;
+        reading.store(true);
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!reading.load()) {
+        std::this_thread::yield();
+    }
+    pointer.publish(std::make_unique<Versioned>(12));
+    EXPECT_FALSE(g_freed[11].load());
+    release.store(true);
+    reader.join();
+    Rcu::instance().reclaim();
+    EXPECT_TRUE(g_freed[11].load());
+}
+
+TEST(RcuTest, ConcurrentReadersNeverSeeAFreedVersion) {
+    RcuPointer<Versioned> pointer(std::make_unique<Versioned>(100));
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> violations{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                RcuReadGuard guard;
+                const Versioned* current = pointer.load();
+                uint32_t id = current->id;
+                if (g_freed[id].load()) {
+                    violations.fetch_add(1);
+                }
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    uint32_t published = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    for (uint32_t id = 101; id < kMaxObjects && std::chrono::steady_clock::now() < deadline; ++id) {
+        pointer.publish(std::make_unique<Versioned>(id));
+        ++published;
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    Rcu::instance().reclaim();
+
+    EXPECT_GT(published, 100u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_EQ(violations.load(), 0u);
+    EXPECT_EQ(Rcu::instance().pending(), 0u);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../src/risk/risk_engine.hpp"
+#include "../src/trading/kill_switch.hpp"
 
 class RiskEngineTest : public ::testing::Test {
 protected:
@@ -12,4 +13,29 @@ protected:
 
 TEST_F(RiskEngineTest, BasicFunctionality) {
     EXPECT_NE(risk_engine, nullptr);
-}
\ No newline at end of file
+}
+
+TEST_F(RiskEngineTest, CircuitBreakerTripsTheKillSwitch) {
+    auto kill_switch = std::make_shared<goldearn::trading::KillSwitch>();
+    size_t cancelled = 0;
+    const uint32_t venue = kill_switch->add_venue(
+        {"NSE", [&](const uint8_t*, size_t length) {
+             cancelled += length / sizeof(goldearn::trading::CancelMessage);
+             return length;
+         }, nullptr});
+    goldearn::trading::Order order{};
+    for (uint64_t id = 1; id <= 3; ++id) {
+        order.client_order_id = id;
+        kill_switch->on_order_live(venue, order);
+    }
+    risk_engine->set_kill_switch(kill_switch);
+
+    risk_engine->trigger_circuit_breaker("daily loss");
+    EXPECT_TRUE(risk_engine->is_circuit_breaker_active());
+    EXPECT_TRUE(kill_switch->is_blocked());
+    EXPECT_EQ(cancelled, 3u);
+    EXPECT_FALSE(kill_switch->begin_submit());
+
+    risk_engine->reset_circuit_breaker();
+    EXPECT_FALSE(kill_switch->is_blocked());
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "../src/risk/span_margin.hpp"
+#include "option_test_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace goldearn::risk;
+using namespace option_test;
+
+namespace {
+
+constexpr uint64_t kBankNifty = 26009;
+
+} // namespace
+
+class SpanMarginTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uint64_t id = 50000;
+        for (uint64_t underlying : {kNifty, kBankNifty}) {
+            const double spot = underlying == kNifty ? 24000.0 : 52000.0;
+            SpanMargin::Contract future;
+            future.contract_id = id++;
+            future.underlying_id = underlying;
+            future.expiry_ns = kNow + 30 * kDay;
+            future.multiplier = underlying == kNifty ? 75 : 30;
+            contracts.push_back(future);
+            for (double k = 0.9; k <= 1.1001; k += 0.025) {
+                for (auto kind : {SpanMargin::Kind::CALL, SpanMargin::Kind::PUT}) {
+                    SpanMargin::Contract option = future;
+                    option.contract_id = id++;
+                    option.kind = kind;
+                    option.strike = std::round(spot * k);
+                    contracts.push_back(option);
+                }
+            }
+        }
+        span.add_contracts(contracts);
+        parameters = {{kNifty, 24000.0, 0.06, 0.04, 0.14, 0.0, 2.0},
+                      {kBankNifty, 52000.0, 0.08, 0.05, 0.18, 0.0, 4.0}};
+        EXPECT_EQ(span.load_risk_parameters(parameters, kNow), contracts.size());
+    }
+
+    // Straight from the definition: per underlying, the worst scenario of
+    // the summed arrays against the short option minimum
+    double full_margin(const std::string& portfolio) const {
+        double total = 0.0;
+        for (size_t p = 0; p < parameters.size(); ++p) {
+            SpanMargin::RiskArray losses{};
+            double short_units = 0.0;
+            for (const auto& c : contracts) {
+                if (c.underlying_id != parameters[p].underlying_id) continue;
+                const double q = span.quantity(portfolio, c.contract_id);
+                const auto array = span.risk_array(c.contract_id);
+                for (size_t s = 0; s < SpanMargin::SCENARIOS; ++s) losses[s] += q * array[s];
+                if (c.kind != SpanMargin::Kind::FUTURE) short_units += std::max(-q, 0.0) * c.multiplier;
+            }
+            const double scan = std::max(*std::max_element(losses.begin(), losses.end()), 0.0);
+            total += std::max(scan, short_units * parameters[p].short_option_minimum);
+        }
+        return total;
+    }
+
+    SpanMargin span;
+    std::vector<SpanMargin::Contract> contracts;
+    std::vector<SpanMargin::RiskParameters> parameters;
+};
+
+TEST_F(SpanMarginTest, RiskArraysFollowTheScenarios) {
+    const double rate = SpanMargin::Config{}.rate;
+    const double tau = 30.0 / 365.0;
+    const double forward = 24000.0 * std::exp(rate * tau);
+
+    // Futures: linear in the move, vol moves do nothing, extremes at 2x and 35%
+    const auto future = span.risk_array(contracts[0].contract_id);
+    EXPECT_NEAR(future[0], 0.0, 1e-9);
+    EXPECT_NEAR(future[1], 0.0, 1e-9);
+    EXPECT_NEAR(future[10], -forward * 0.06 * 75, 1e-6);
+    EXPECT_NEAR(future[12], forward * 0.06 * 75, 1e-6);
+    EXPECT_NEAR(future[4], forward * 0.02 * 75, 1e-6);
+    EXPECT_NEAR(future[15], forward * 0.12 * 75 * 0.35, 1e-6);
+
+    // An option against the closed form, scenario by scenario
+    const auto& call = contracts[9]; // At the money
+    ASSERT_EQ(call.kind, SpanMargin::Kind::CALL);
+    ASSERT_EQ(call.strike, 24000.0);
+    const auto array = span.risk_array(call.contract_id);
+    const double base = black_scholes(true, 24000.0, call.strike, tau, 0.14, rate);
+    const double moves[] = {0.0, 0.0, 0.02, 0.02, -0.02, -0.02, 0.04, 0.04, -0.04, -0.04, 0.06, 0.06, -0.06, -0.06};
+    for (size_t s = 0; s < 14; ++s) {
+        const double vol = 0.14 + (s % 2 == 0 ? 0.04 : -0.04);
+        const double expected = (base - black_scholes(true, 24000.0 * (1 + moves[s]), call.strike, tau, vol, rate)) * 75;
+        EXPECT_NEAR(array[s], expected, 1e-6) << s;
+    }
+    EXPECT_LT(array[0], 0.0); // Long options gain when vol rises
+    EXPECT_NEAR(array[15], (base - black_scholes(true, 24000.0 * 0.88, call.strike, tau, 0.14, rate)) * 75 * 0.35,
+                1e-6);
+    EXPECT_EQ(span.risk_array(999999), SpanMargin::RiskArray{});
+}
+
+TEST_F(SpanMarginTest, IncrementalMarginMatchesFullRecompute) {
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<size_t> pick(0, contracts.size() - 1);
+    std::uniform_int_distribution<int> lots(-20, 20);
+    const std::vector<std::string> portfolios = {"fno_mm", "dispersion", "index_arb"};
+    for (int i = 0; i < 600; ++i) {
+        const std::string& portfolio = portfolios[i % portfolios.size()];
+        const auto& contract = contracts[pick(rng)];
+        const double quantity = lots(rng);
+
+        // The pre-trade figure is exactly what the fill then produces
+        const auto impact = span.order_impact(portfolio, contract.contract_id, quantity);
+        ASSERT_TRUE(impact.derivative);
+        EXPECT_NEAR(impact.current, span.margin(portfolio).total, 1e-6);
+        ASSERT_TRUE(span.on_fill(portfolio, contract.contract_id, quantity));
+        EXPECT_NEAR(span.margin(portfolio).total, impact.projected, 1e-6 * std::max(1.0, impact.projected));
+    }
+    double total = 0.0;
+    for (const auto& portfolio : portfolios) {
+        const auto margin = span.margin(portfolio);
+        EXPECT_NEAR(margin.total, full_margin(portfolio), 1e-6 * margin.total);
+        EXPECT_GE(margin.total, margin.scanning_risk);
+        total += margin.total;
+    }
+    EXPECT_NEAR(span.total_margin(), total, 1e-6 * total);
+    EXPECT_EQ(span.all_margins().size(), portfolios.size());
+    EXPECT_FALSE(span.on_fill("fno_mm", 999999, 1));
+    EXPECT_FALSE(span.order_impact("fno_mm", 999999, 1).derivative);
+
+    // A new file revalues every holding
+    parameters[0].price = 24600.0;
+    parameters[0].price_scan_range = 0.09;
+    span.load_risk_parameters(parameters, kNow + kDay);
+    for (const auto& portfolio : portfolios) {
+        EXPECT_NEAR(span.margin(portfolio).total, full_margin(portfolio), 1e-6 * span.margin(portfolio).total);
+    }
+}
+
+TEST_F(SpanMarginTest, HedgesOffsetAndOrdersReserve) {
+    const auto& future = contracts[0];
+    const auto& atm_call = contracts[9];
+    const auto& atm_put = contracts[10];
+
+    // Long future alone against long future plus protective put
+    span.on_fill("hedged", future.contract_id, 1);
+    const double naked = span.margin("hedged").total;
+    EXPECT_NEAR(naked, span.risk_array(future.contract_id)[12], 1e-6); // Full move down
+    const auto hedge = span.order_impact("hedged", atm_put.contract_id, 1);
+    EXPECT_LT(hedge.projected, 0.6 * naked);
+
+    // Working orders count until removed; an unknown portfolio counts as empty
+    span.add_order("hedged", atm_put.contract_id, 1);
+    EXPECT_NEAR(span.margin("hedged").total, hedge.projected, 1e-6);
+    span.remove_order("hedged", atm_put.contract_id, 1);
+    EXPECT_NEAR(span.margin("hedged").total, naked, 1e-6);
+    EXPECT_FALSE(span.remove_order("unknown", atm_put.contract_id, 1));
+    EXPECT_NEAR(span.order_impact("unknown", future.contract_id, 1).projected, naked, 1e-6);
+    EXPECT_EQ(span.order_impact("unknown", future.contract_id, 1).current, 0.0);
+
+    // Far out-of-the-money short puts: once the short option minimum is
+    // above the scanning risk, it is the charge
+    const auto& wing_put = contracts[2]; // 21600
+    ASSERT_EQ(wing_put.kind, SpanMargin::Kind::PUT);
+    span.on_fill("wings", wing_put.contract_id, -10);
+    const double scanning = span.margin("wings").scanning_risk;
+    EXPECT_NEAR(span.margin("wings").total, scanning, 1e-6);
+    parameters[0].short_option_minimum = 2.0 * scanning / (10 * 75);
+    span.load_risk_parameters(parameters, kNow);
+    EXPECT_NEAR(span.margin("wings").total, 2.0 * scanning, 1e-6);
+    EXPECT_NEAR(span.margin("wings").short_option_minimum, scanning, 1e-6);
+    EXPECT_NEAR(span.order_impact("wings", wing_put.contract_id, 10).projected, 0.0, 1e-6);
+
+    // Short straddle: scanning risk well above either leg's premium
+    span.on_fill("straddle", atm_call.contract_id, -1);
+    span.on_fill("straddle", atm_put.contract_id, -1);
+    EXPECT_GT(span.margin("straddle").scanning_risk, 0.0);
+    EXPECT_NEAR(span.margin("straddle").total, full_margin("straddle"), 1e-6);
+
+    // The exchange's own array replaces the computed one, and holdings follow
+    SpanMargin::RiskArray published{};
+    published.fill(-10.0);
+    published[12] = 200000.0;
+    ASSERT_TRUE(span.load_risk_array(future.contract_id, published));
+    EXPECT_NEAR(span.margin("hedged").total, 200000.0, 1e-6);
+    EXPECT_FALSE(span.load_risk_array(999999, published));
+
+    EXPECT_THROW(span.add_contract(SpanMargin::Contract{}), std::invalid_argument);
+    EXPECT_THROW(span.load_risk_parameters({{kNifty, 0.0, 0.06, 0.04, 0.14, 0.0, 0.0}}, kNow),
+                 std::invalid_argument);
+    EXPECT_EQ(span.get_stats().portfolios, 3u); // Reads and removals create none
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include "../src/core/stats_segment.hpp"
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
+
+using namespace goldearn::core;
+
+namespace {
+
+std::string test_segment_name() {
+    return "goldearn_stats_test_" + std::to_string(::getpid());
+}
+
+const StatsReader::Metric* find_metric(const std::vector<StatsReader::Metric>& metrics, const std::string& name) {
+    auto it = std::find_if(metrics.begin(), metrics.end(), [&](const auto& m) { return m.name == name; });
+    return it != metrics.end() ? &*it : nullptr;
+}
+
+double thread_value(const StatsReader::Metric& metric, const std::string& thread) {
+    for (const auto& [name, value] : metric.threads) {
+        if (name == thread) return value;
+    }
+    return -1.0;
+}
+
+} // namespace
+
+class StatsSegmentTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(StatsSegment::open(test_segment_name()));
+    }
+
+    void TearDown() override {
+        StatsSegment::close();
+    }
+};
+
+TEST_F(StatsSegmentTest, ReaderAggregatesPerThreadCounters) {
+    uint32_t events = StatsSegment::counter("test_events_total", "Events seen");
+    EXPECT_EQ(StatsSegment::counter("test_events_total", "Events seen"), events);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t, events]() {
+            ASSERT_TRUE(StatsSegment::attach_thread("worker" + std::to_string(t)));
+            for (int i = 0; i < 1000 * (t + 1); ++i) {
+                stats::add(events);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    StatsReader reader(test_segment_name());
+    EXPECT_EQ(reader.writer_pid(), ::getpid());
+    EXPECT_TRUE(reader.writer_alive());
+
+    auto metrics = reader.read();
+    const auto* metric = find_metric(metrics, "test_events_total");
+    ASSERT_NE(metric, nullptr);
+    EXPECT_EQ(metric->help, "Events seen");
+    EXPECT_EQ(metric->kind, stats_layout::COUNTER);
+    EXPECT_DOUBLE_EQ(metric->total, 10000.0);
+    EXPECT_DOUBLE_EQ(thread_value(*metric, "worker3"), 4000.0);
+}
+
+TEST_F(StatsSegmentTest, GaugesAggregateByMaxAndMin) {
+    uint32_t worst = StatsSegment::gauge("test_worst_latency_ns", "Slowest", stats_layout::MAX);
+    uint32_t best = StatsSegment::gauge("test_best_latency_ns", "Fastest", stats_layout::MIN);
+    uint32_t unset = StatsSegment::gauge("test_unset_ns", "Never written", stats_layout::MIN);
+
+    auto run = [&](const char* name, double low, double high) {
+        std::thread([&, name, low, high]() {
+            StatsSegment::attach_thread(name);
+            stats::set_max(worst, low);
+            stats::set_max(worst, high);
+            stats::set_min(best, high);
+            stats::set_min(best, low);
+        }).join();
+    };
+    run("gauge_a", 100.0, 900.0);
+    run("gauge_b", 50.0, 400.0);
+
+    auto metrics = StatsReader(test_segment_name()).read();
+    EXPECT_DOUBLE_EQ(find_metric(metrics, "test_worst_latency_ns")->total, 900.0);
+    EXPECT_DOUBLE_EQ(find_metric(metrics, "test_best_latency_ns")->total, 50.0);
+    // Untouched MIN/MAX gauges are not reported as +-inf
+    EXPECT_DOUBLE_EQ(find_metric(metrics, "test_unset_ns")->total, 0.0);
+    EXPECT_TRUE(find_metric(metrics, "test_unset_ns")->threads.empty());
+    (void)unset;
+}
+
+TEST_F(StatsSegmentTest, ThreadOfSameNameContinuesItsCounters) {
+    uint32_t restarts = StatsSegment::counter("test_restart_total", "Restart counter");
+    for (int i = 0; i < 3; ++i) {
+        std::thread([restarts]() {
+            StatsSegment::attach_thread("restarting");
+            stats::add(restarts, 5);
+        }).join();
+    }
+
+    auto metrics = StatsReader(test_segment_name()).read();
+    const auto* metric = find_metric(metrics, "test_restart_total");
+    ASSERT_NE(metric, nullptr);
+    EXPECT_DOUBLE_EQ(thread_value(*metric, "restarting"), 15.0);
+    EXPECT_EQ(std::count_if(metric->threads.begin(), metric->threads.end(),
+                            [](const auto& t) { return t.first == "restarting"; }), 1);
+}
+
+TEST_F(StatsSegmentTest, PrometheusExposition) {
+    uint32_t orders = StatsSegment::counter("test_orders_total", "Orders sent");
+    std::thread([orders]() {
+        StatsSegment::attach_thread("gateway");
+        stats::add(orders, 42);
+    }).join();
+
+    auto metrics = StatsReader(test_segment_name()).read();
+    std::string text = StatsReader::to_prometheus(metrics);
+    EXPECT_NE(text.find("# HELP test_orders_total Orders sent\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_orders_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("test_orders_total 42\n"), std::string::npos);
+
+    std::string per_thread = StatsReader::to_prometheus(metrics, true);
+    EXPECT_NE(per_thread.find("test_orders_total{thread=\"gateway\"} 42\n"), std::string::npos);
+}
+
+TEST(StatsSegmentStandaloneTest, WritesWithoutSegmentAreDropped) {
+    uint32_t id = StatsSegment::counter("test_detached_total", "No segment");
+    std::thread([id]() {
+        EXPECT_FALSE(StatsSegment::attach_thread("detached"));
+        stats::add(id);
+        stats::set_max(id, 1.0);
+    }).join();
+    EXPECT_EQ(StatsSegment::current(), nullptr);
+    EXPECT_THROW(StatsReader("goldearn_stats_missing_segment"), std::runtime_error);
+}
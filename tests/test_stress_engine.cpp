@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../src/risk/stress_engine.hpp"
+
+using namespace goldearn::risk;
+
+class StressEngineTest : public ::testing::Test {
+protected:
+    static constexpr size_t kScenarios = 37; // Not a multiple of the block or of 4
+    static constexpr size_t kSymbols = 23;
+
+    void SetUp() override {
+        uint32_t x = 2024;
+        for (size_t i = 0; i < kSymbols; ++i) {
+            symbols.push_back(500 + 3 * i);
+        }
+        for (size_t s = 0; s < kScenarios; ++s) {
+            names.push_back("scenario_" + std::to_string(s));
+            for (size_t i = 0; i < kSymbols; ++i) {
+                x = x * 1664525 + 1013904223;
+                shocks.push_back(((x >> 8) % 4001 - 2000.0) * 1e-4); // -20% .. +20%
+            }
+        }
+        for (size_t i = 0; i < kSymbols; ++i) {
+            exposures[symbols[i]] = (i % 5 == 0) ? 0.0 : (i % 2 ? 1.0 : -1.0) * (1e5 + 1e3 * i);
+        }
+    }
+
+    // Straight row-by-row product against the engine's result
+    void expect_matches(const StressEngine& engine, const StressEngine::Result& result) const {
+        ASSERT_EQ(result.pnl.size(), kScenarios);
+        for (size_t s = 0; s < kScenarios; ++s) {
+            double pnl = 0.0;
+            double worst = 0.0;
+            uint32_t position = StressEngine::NO_POSITION;
+            for (uint32_t i = 0; i < kSymbols; ++i) {
+                const double e = engine.exposure(symbols[i]);
+                if (e == 0.0) {
+                    continue;
+                }
+                const double c = e * shocks[s * kSymbols + i];
+                pnl += c;
+                if (position == StressEngine::NO_POSITION || c < worst) {
+                    worst = c;
+                    position = i;
+                }
+            }
+            EXPECT_NEAR(result.pnl[s], pnl, 1e-6) << "scenario " << s;
+            EXPECT_EQ(result.worst_position[s], position) << "scenario " << s;
+            EXPECT_DOUBLE_EQ(result.worst_position_pnl[s], worst) << "scenario " << s;
+        }
+    }
+
+    std::vector<uint64_t> symbols;
+    std::vector<std::string> names;
+    std::vector<double> shocks;
+    std::unordered_map<uint64_t, double> exposures;
+};
+
+TEST_F(StressEngineTest, FullProductMatchesAcrossThreadsAndBlocks) {
+    StressEngine single(StressEngine::Config{1, {}, 8});
+    StressEngine threaded(StressEngine::Config{3, {}, 12});
+    for (StressEngine* engine : {&single, &threaded}) {
+        engine->set_scenarios(symbols, names, shocks);
+        engine->set_exposures(exposures);
+        const auto& result = engine->evaluate();
+        EXPECT_FALSE(result.incremental);
+        expect_matches(*engine, result);
+    }
+    EXPECT_EQ(single.evaluate().pnl, threaded.evaluate().pnl); // Same columns in the same order per scenario
+}
+
+TEST_F(StressEngineTest, PositionChangesAreAppliedIncrementally) {
+    StressEngine engine(StressEngine::Config{1, {}, 8, 0.25});
+    engine.set_scenarios(symbols, names, shocks);
+    engine.set_exposures(exposures);
+    engine.evaluate();
+
+    // Fills on a few names at a time, including flattening and re-opening
+    uint32_t x = 7;
+    for (int round = 0; round < 40; ++round) {
+        for (int fill = 0; fill < 3; ++fill) {
+            x = x * 1664525 + 1013904223;
+            const uint64_t symbol = symbols[(x >> 8) % kSymbols];
+            const double exposure = (x >> 20) % 4 == 0 ? 0.0 : ((x >> 12) % 2001 - 1000.0) * 500.0;
+            engine.set_exposure(symbol, exposure);
+        }
+        const auto& result = engine.evaluate();
+        ASSERT_TRUE(result.incremental);
+        expect_matches(engine, result);
+    }
+    EXPECT_EQ(engine.get_stats().full_runs, 1u);
+    EXPECT_EQ(engine.get_stats().incremental_runs, 40u);
+    EXPECT_GT(engine.get_stats().rescanned_scenarios, 0u);
+
+    // A reshuffle of the whole book goes back to the full product
+    std::unordered_map<uint64_t, double> reversed;
+    for (const auto& [symbol, exposure] : exposures) {
+        reversed[symbol] = -exposure;
+    }
+    engine.set_exposures(reversed);
+    EXPECT_FALSE(engine.evaluate().incremental);
+    expect_matches(engine, engine.evaluate());
+}
+
+TEST_F(StressEngineTest, PositionsFollowTheirSymbolsIntoNewScenarios) {
+    StressEngine engine(StressEngine::Config{});
+    engine.set_scenarios(symbols, names, shocks);
+    engine.set_exposures(exposures);
+    engine.set_exposure(9999, 1e6); // Outside the universe
+    EXPECT_EQ(engine.exposure(9999), 0.0);
+
+    // Same universe in reverse order, one crash scenario
+    std::vector<uint64_t> reversed(symbols.rbegin(), symbols.rend());
+    engine.set_scenarios(reversed, {"crash"}, std::vector<double>(kSymbols, -0.1));
+    double total = 0.0;
+    for (const auto& [symbol, exposure] : exposures) {
+        total += exposure;
+        EXPECT_EQ(engine.exposure(symbol), exposure);
+    }
+    const auto& result = engine.evaluate();
+    EXPECT_NEAR(result.pnl[0], -0.1 * total, 1e-6);
+
+    auto impacts = engine.position_impacts(0);
+    ASSERT_FALSE(impacts.empty());
+    EXPECT_EQ(impacts.front().first, engine.symbol(result.worst_position[0]));
+    EXPECT_DOUBLE_EQ(impacts.front().second, result.worst_position_pnl[0]);
+    for (size_t k = 1; k < impacts.size(); ++k) {
+        EXPECT_LE(impacts[k - 1].second, impacts[k].second);
+    }
+
+    EXPECT_THROW(engine.set_scenarios(symbols, {"short"}, {0.1}), std::invalid_argument);
+}
+
+TEST_F(StressEngineTest, FlatBookHasNoWorstPosition) {
+    StressEngine engine(StressEngine::Config{});
+    engine.set_scenarios(symbols, names, shocks);
+    const auto& result = engine.evaluate();
+    for (size_t s = 0; s < kScenarios; ++s) {
+        EXPECT_EQ(result.pnl[s], 0.0);
+        EXPECT_EQ(result.worst_position_pnl[s], 0.0);
+        EXPECT_EQ(result.worst_position[s], StressEngine::NO_POSITION);
+    }
+}
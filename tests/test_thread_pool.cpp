@@ -1,12 +1,279 @@
 #include <gtest/gtest.h>
+#include "../src/core/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace goldearn::core;
+using namespace std::chrono_literals;
 
-// Placeholder thread pool test
 class ThreadPoolTest : public ::testing::Test {
 protected:
-    void SetUp() override {}
+    static bool wait_for(const std::function<bool()>& condition,
+                         std::chrono::milliseconds timeout = 2000ms) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
 };
 
-TEST_F(ThreadPoolTest, BasicFunctionality) {
-    // Placeholder test - thread pool not implemented yet
-    EXPECT_TRUE(true);
-}
\ No newline at end of file
+TEST_F(ThreadPoolTest, ParseCoreList) {
+    EXPECT_EQ(parse_core_list("0-2,5"), (std::vector<int>{0, 1, 2, 5}));
+    EXPECT_EQ(parse_core_list(" 3 , 1,1 "), (std::vector<int>{1, 3}));
+    EXPECT_TRUE(parse_core_list("").empty());
+    EXPECT_EQ(parse_core_list("x,4"), (std::vector<int>{4}));
+
+    auto critical = Runtime::Config::parse_critical_cores("feed_handler:2, order_gateway : 3,bad");
+    EXPECT_EQ(critical.size(), 2u);
+    EXPECT_EQ(critical["feed_handler"], 2);
+    EXPECT_EQ(critical["order_gateway"], 3);
+}
+
+TEST_F(ThreadPoolTest, PinningDegradesGracefully) {
+    // A core that cannot exist must not pin (or crash)
+    std::thread t([]() { EXPECT_FALSE(pin_current_thread(100000)); });
+    t.join();
+}
+
+TEST_F(ThreadPoolTest, ExecutesSubmittedTasks) {
+    WorkStealingPool pool({"test", 3, {}});
+    pool.start();
+
+    std::atomic<int> executed{0};
+    for (int i = 0; i < 1000; ++i) {
+        pool.submit([&]() { executed++; });
+    }
+    EXPECT_TRUE(wait_for([&]() { return executed.load() == 1000; }));
+    EXPECT_EQ(pool.get_statistics().tasks_executed, 1000u);
+    pool.stop();
+}
+
+TEST_F(ThreadPoolTest, IdleWorkersStealNestedTasks) {
+    WorkStealingPool pool({"test", 4, {}});
+    pool.start();
+
+    // Fan-out from inside a worker lands on that worker's deque; the rest of
+    // the pool can only get at it by stealing
+    std::atomic<int> executed{0};
+    pool.submit([&]() {
+        for (int i = 0; i < 200; ++i) {
+            pool.submit([&]() {
+                std::this_thread::sleep_for(100us);
+                executed++;
+            });
+        }
+    });
+    EXPECT_TRUE(wait_for([&]() { return executed.load() == 200; }));
+    EXPECT_GT(pool.get_statistics().tasks_stolen, 0u);
+    pool.stop();
+}
+
+TEST_F(ThreadPoolTest, PeriodicTaskRunsAndCancels) {
+    WorkStealingPool pool({"test", 2, {}});
+    pool.start();
+
+    std::atomic<int> runs{0};
+    TaskId id = pool.schedule_periodic(5ms, [&]() { runs++; }, "counter");
+    EXPECT_TRUE(wait_for([&]() { return runs.load() >= 5; }));
+
+    pool.cancel(id);
+    int after_cancel = runs.load();
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(runs.load(), after_cancel);
+    pool.stop();
+}
+
+TEST_F(ThreadPoolTest, SlowPeriodicTaskDoesNotOverlap) {
+    WorkStealingPool pool({"test", 4, {}});
+    pool.start();
+
+    std::atomic<int> concurrent{0};
+    std::atomic<int> max_concurrent{0};
+    std::atomic<int> runs{0};
+    TaskId id = pool.schedule_periodic(1ms, [&]() {
+        int now = ++concurrent;
+        int prev = max_concurrent.load();
+        while (now > prev && !max_concurrent.compare_exchange_weak(prev, now)) {}
+        std::this_thread::sleep_for(10ms);
+        concurrent--;
+        runs++;
+    });
+    EXPECT_TRUE(wait_for([&]() { return runs.load() >= 3; }));
+    pool.cancel(id);
+
+    EXPECT_EQ(max_concurrent.load(), 1);
+    EXPECT_GT(pool.get_statistics().periodic_skipped, 0u);
+    pool.stop();
+}
+
+TEST_F(ThreadPoolTest, PeriodicTaskCanCancelItself) {
+    WorkStealingPool pool({"test", 2, {}});
+    pool.start();
+
+    std::atomic<int> runs{0};
+    std::atomic<TaskId> id{0};
+    id = pool.schedule_periodic(2ms, [&]() {
+        if (++runs == 3) pool.cancel(id.load());
+    });
+    EXPECT_TRUE(wait_for([&]() { return runs.load() >= 3; }));
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(runs.load(), 3);
+    pool.stop();
+}
+
+TEST_F(ThreadPoolTest, SpinThreadPollsUntilStopped) {
+    std::atomic<int> work{100};
+    std::atomic<int> idle_calls{0};
+
+    SpinThread spin("test_spin", -1, [&]() {
+        if (work.load() > 0) {
+            work--;
+            return true;
+        }
+        return false;
+    });
+    spin.set_idle_hook([&]() { idle_calls++; });
+    spin.start();
+
+    EXPECT_TRUE(wait_for([&]() { return work.load() == 0 && idle_calls.load() > 0; }));
+    spin.stop();
+    EXPECT_FALSE(spin.is_running());
+    EXPECT_FALSE(spin.is_pinned());
+    EXPECT_EQ(spin.get_busy_iterations(), 100u);
+    EXPECT_GT(spin.get_iterations(), 100u);
+}
+
+TEST_F(ThreadPoolTest, RuntimeAssignsCriticalCores) {
+    Runtime runtime;
+    Runtime::Config config;
+    config.housekeeping_cores = {0, 1};
+    config.housekeeping_threads = 2;
+    config.critical_cores = {{"order_gateway", 0}};
+    runtime.configure(config);
+
+    EXPECT_EQ(runtime.get_critical_core("order_gateway"), 0);
+    EXPECT_EQ(runtime.get_critical_core("unknown"), -1);
+
+    auto spin = runtime.create_critical_thread("order_gateway", []() { return false; });
+    EXPECT_EQ(spin->core(), 0);
+    spin->start();
+    EXPECT_TRUE(wait_for([&]() { return spin->get_iterations() > 0 || spin->is_pinned(); }));
+    spin->stop();
+
+    std::atomic<bool> ran{false};
+    runtime.background().submit([&]() { ran = true; });
+    EXPECT_TRUE(wait_for([&]() { return ran.load(); }));
+    runtime.shutdown();
+}
+
+TEST_F(ThreadPoolTest, StopRunsQueuedTasksAndRejectsNewOnes) {
+    WorkStealingPool pool({"test", 2, {}});
+    pool.start();
+
+    // Both workers busy, so the rest of the tasks are still queued at stop()
+    std::atomic<bool> release{false};
+    std::atomic<int> started{0};
+    std::atomic<int> executed{0};
+    std::atomic<int> rejected_inside{0};
+    for (int i = 0; i < 2; ++i) {
+        pool.submit([&]() {
+            started++;
+            while (!release.load()) std::this_thread::sleep_for(1ms);
+            executed++;
+        });
+    }
+    ASSERT_TRUE(wait_for([&]() { return started.load() == 2; }));
+    for (int i = 0; i < 100; ++i) {
+        pool.submit([&]() {
+            executed++;
+            if (!pool.submit([&]() { executed += 1000; })) rejected_inside++;
+        });
+    }
+
+    std::thread stopper([&]() { pool.stop(); });
+    std::this_thread::sleep_for(20ms);
+    release = true;
+    stopper.join();
+
+    EXPECT_EQ(executed.load(), 102);
+    EXPECT_EQ(rejected_inside.load(), 100);
+    EXPECT_FALSE(pool.submit([&]() { executed++; }));
+    EXPECT_EQ(pool.get_statistics().tasks_rejected, 101u);
+    EXPECT_EQ(executed.load(), 102);
+}
+
+// Every task submit() accepts while stop() runs is executed before stop() returns
+TEST_F(ThreadPoolTest, TasksAcceptedDuringStopAreNotLost) {
+    for (int round = 0; round < 50; ++round) {
+        WorkStealingPool pool({"test", 2, {}});
+        pool.start();
+        std::atomic<int> accepted{0};
+        std::atomic<int> executed{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 4; ++t) {
+            submitters.emplace_back([&]() {
+                while (!go.load()) std::this_thread::yield();
+                for (int i = 0; i < 200; ++i) {
+                    if (pool.submit([&]() { executed++; })) accepted++;
+                }
+            });
+        }
+        go = true;
+        pool.stop();
+        for (auto& submitter : submitters) submitter.join();
+        EXPECT_EQ(executed.load(), accepted.load());
+    }
+}
+
+TEST_F(ThreadPoolTest, StopFromInsideATaskIsIgnored) {
+    WorkStealingPool pool({"test", 2, {}});
+    pool.start();
+    std::atomic<bool> stopped_inside{false};
+    std::atomic<bool> on_worker{false};
+    pool.submit([&]() {
+        on_worker = pool.on_worker_thread();
+        pool.stop();
+        stopped_inside = true;
+    });
+    ASSERT_TRUE(wait_for([&]() { return stopped_inside.load(); }));
+    EXPECT_TRUE(on_worker.load());
+    EXPECT_FALSE(pool.on_worker_thread());
+
+    std::atomic<bool> ran{false};
+    EXPECT_TRUE(pool.submit([&]() { ran = true; }));
+    EXPECT_TRUE(wait_for([&]() { return ran.load(); }));
+
+    Runtime runtime;
+    std::atomic<bool> shutdown_inside{false};
+    runtime.background().submit([&]() {
+        runtime.shutdown();
+        shutdown_inside = true;
+    });
+    ASSERT_TRUE(wait_for([&]() { return shutdown_inside.load(); }));
+    EXPECT_FALSE(runtime.is_shut_down());
+    runtime.shutdown();
+    EXPECT_TRUE(runtime.is_shut_down());
+    pool.stop();
+}
+
+TEST_F(ThreadPoolTest, RuntimeDoesNotRecreateThePoolAfterShutdown) {
+    Runtime runtime;
+    std::atomic<bool> ran{false};
+    runtime.background().submit([&]() {
+        std::this_thread::sleep_for(10ms);
+        ran = true;
+    });
+    runtime.shutdown();
+    EXPECT_TRUE(ran.load()) << "Queued task must run before shutdown() returns";
+
+    EXPECT_TRUE(runtime.is_shut_down());
+    EXPECT_THROW(runtime.background(), std::logic_error);
+    runtime.cancel(1); // Still a no-op
+    runtime.shutdown();
+}
@@ -1,12 +1,477 @@
 #include <gtest/gtest.h>
+#include "../src/risk/risk_engine.hpp"
+#include "../src/risk/incremental_var.hpp"
+#include "../src/risk/var_engine.hpp"
+#include "../src/utils/philox.hpp"
+#include "../src/utils/vector_math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace goldearn::risk;
+using namespace goldearn::utils;
+
+namespace {
+
+// Equicorrelated matrix, positive definite for rho in (-1/(n-1), 1)
+std::vector<double> equicorrelation(size_t n, double rho) {
+    std::vector<double> matrix(n * n, rho);
+    for (size_t i = 0; i < n; ++i) {
+        matrix[i * n + i] = 1.0;
+    }
+    return matrix;
+}
+
+} // namespace
 
-// Placeholder VaR calculator test
 class VaRCalculatorTest : public ::testing::Test {
 protected:
-    void SetUp() override {}
+    void SetUp() override {
+        positions_ = {{1, 1000000.0}, {2, 2000000.0}};
+        volatilities_ = {{1, 0.02}, {2, 0.01}};
+        correlations_ = {{{1, 2}, 0.5}};
+    }
+
+    std::unordered_map<uint64_t, double> positions_;
+    std::unordered_map<uint64_t, double> volatilities_;
+    CorrelationMap correlations_;
 };
 
-TEST_F(VaRCalculatorTest, BasicFunctionality) {
-    // Placeholder test - VaR calculator not implemented yet
-    EXPECT_TRUE(true);
-}
\ No newline at end of file
+TEST_F(VaRCalculatorTest, InverseNormalCdf) {
+    EXPECT_NEAR(VaRCalculator::inverse_normal_cdf(0.05), -1.6448536269514722, 1e-12);
+    EXPECT_NEAR(VaRCalculator::inverse_normal_cdf(0.975), 1.959963984540054, 1e-12);
+    EXPECT_NEAR(VaRCalculator::inverse_normal_cdf(0.5), 0.0, 1e-15);
+    EXPECT_NEAR(VaRCalculator::inverse_normal_cdf(1e-6), -4.753424308822899, 1e-10);
+}
+
+TEST_F(VaRCalculatorTest, ParametricMatchesClosedForm) {
+    VaRCalculator calculator;
+    // Both legs have 20,000 of daily volatility: variance 2 * 20000^2 * (1 + 0.5)
+    const double portfolio_volatility = std::sqrt(1.2e9);
+    EXPECT_NEAR(calculator.calculate_parametric_var(positions_, volatilities_, correlations_),
+                1.6448536269514722 * portfolio_volatility, 1e-6);
+    EXPECT_NEAR(calculator.calculate_parametric_var(positions_, volatilities_, correlations_, 0.01, 10),
+                2.3263478740408408 * std::sqrt(10.0) * portfolio_volatility, 1e-6);
+
+    // A pair may be stored either way round; a missing pair is uncorrelated
+    CorrelationMap reversed = {{{2, 1}, 0.5}};
+    EXPECT_DOUBLE_EQ(calculator.calculate_parametric_var(positions_, volatilities_, reversed),
+                     calculator.calculate_parametric_var(positions_, volatilities_, correlations_));
+    EXPECT_NEAR(calculator.calculate_parametric_var(positions_, volatilities_, {}),
+                1.6448536269514722 * std::sqrt(8e8), 1e-6);
+
+    EXPECT_THROW(calculator.calculate_parametric_var(positions_, volatilities_, correlations_, 0.0),
+                 std::invalid_argument);
+}
+
+TEST_F(VaRCalculatorTest, HistoricalTakesTheQuantileOfRecentPnl) {
+    VaRCalculator calculator;
+    std::unordered_map<uint64_t, std::vector<double>> history;
+    for (int day = 0; day < 100; ++day) {
+        history[1].push_back((day - 50) / 1000.0); // Oldest first, worst first
+        history[2].push_back(0.0);
+    }
+    history[2].push_back(0.0); // Longer history: aligned on the most recent day
+
+    // Fifth worst of 100 days: 1e6 * -0.046
+    EXPECT_NEAR(calculator.calculate_historical_var(positions_, history, 0.05, 252), 46000.0, 1e-6);
+    // Last 50 days only: third worst is day 52, a gain
+    EXPECT_NEAR(calculator.calculate_historical_var(positions_, history, 0.05, 50), -2000.0, 1e-6);
+    EXPECT_EQ(calculator.calculate_historical_var(positions_, {}, 0.05, 252), 0.0);
+}
+
+TEST_F(VaRCalculatorTest, MonteCarloConvergesToParametric) {
+    constexpr size_t N = 50;
+    std::unordered_map<uint64_t, double> positions, volatilities;
+    CorrelationMap correlations;
+    for (uint64_t i = 0; i < N; ++i) {
+        positions[100 + i] = (i % 3 == 0 ? -1.0 : 1.0) * (1e5 + 1e4 * i);
+        volatilities[100 + i] = 0.01 + 0.0005 * i;
+        for (uint64_t j = 0; j < i; ++j) {
+            correlations[{100 + i, 100 + j}] = 0.3;
+        }
+    }
+
+    VaRCalculator calculator(MonteCarloVaREngine::Config{2, {}, 42, 1024});
+    double parametric = calculator.calculate_parametric_var(positions, volatilities, correlations);
+    double monte_carlo = calculator.calculate_monte_carlo_var(positions, {}, volatilities, correlations, 0.05, 1, 50000);
+    EXPECT_NEAR(monte_carlo / parametric, 1.0, 0.03);
+
+    auto result = calculator.get_last_monte_carlo_result();
+    EXPECT_EQ(result.paths, 50000u);
+    EXPECT_DOUBLE_EQ(result.var, monte_carlo);
+    // Normal ES / VaR at 5%: phi(z) / (0.05 * z)
+    EXPECT_NEAR(result.expected_shortfall / result.var, 1.2540, 0.03);
+    EXPECT_NEAR(result.mean_pnl, 0.0, parametric * 0.02);
+
+    // Drift shifts the distribution by the expected P&L
+    std::unordered_map<uint64_t, double> drift;
+    double expected_pnl = 0.0;
+    for (const auto& [symbol_id, position] : positions) {
+        drift[symbol_id] = 0.001;
+        expected_pnl += position * 0.001;
+    }
+    double drifted = calculator.calculate_monte_carlo_var(positions, drift, volatilities, correlations, 0.05, 1, 50000);
+    EXPECT_NEAR(drifted, monte_carlo - expected_pnl, 1e-6 * parametric);
+}
+
+TEST(MonteCarloVaREngineTest, ResultsDependOnTheSeedOnly) {
+    constexpr size_t N = 70;
+    std::vector<double> matrix = equicorrelation(N, 0.2);
+    MonteCarloVaREngine::Exposures exposures;
+    for (size_t i = 0; i < N; ++i) {
+        exposures.delta.push_back(1e5 * (1.0 + i % 7));
+        exposures.volatility.push_back(0.015);
+    }
+
+    auto run = [&](size_t threads, uint64_t seed, uint32_t chunk) {
+        MonteCarloVaREngine engine(MonteCarloVaREngine::Config{threads, {}, seed, chunk});
+        engine.set_correlation(matrix.data(), N);
+        return engine.run(exposures, 1, 0.01, 20000);
+    };
+    auto single = run(1, 7, 1024);
+    auto threaded = run(3, 7, 1024);
+    EXPECT_EQ(single.var, threaded.var);
+    EXPECT_EQ(single.expected_shortfall, threaded.expected_shortfall);
+    EXPECT_EQ(single.mean_pnl, threaded.mean_pnl);
+    // The tail does not depend on the chunking either
+    auto rechunked = run(2, 7, 256);
+    EXPECT_EQ(single.var, rechunked.var);
+    EXPECT_EQ(single.expected_shortfall, rechunked.expected_shortfall);
+
+    EXPECT_NE(single.var, run(1, 8, 1024).var);
+}
+
+TEST(MonteCarloVaREngineTest, FactorIsCachedAndReconstructsTheMatrix) {
+    constexpr size_t N = 37; // Not a multiple of the vector or block width
+    std::vector<double> matrix(N * N);
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+            matrix[i * N + j] = i == j ? 1.0 : 0.6 * std::exp(-0.1 * std::abs(static_cast<double>(i) - j));
+        }
+    }
+
+    MonteCarloVaREngine engine(MonteCarloVaREngine::Config{});
+    EXPECT_TRUE(engine.set_correlation(matrix.data(), N));
+    EXPECT_TRUE(engine.factor_is_exact());
+    EXPECT_EQ(engine.factorizations(), 1u);
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j <= i; ++j) {
+            double sum = 0.0;
+            for (size_t k = 0; k <= j; ++k) {
+                sum += engine.factor_row(i)[k] * engine.factor_row(j)[k];
+            }
+            EXPECT_NEAR(sum, matrix[i * N + j], 1e-12) << i << "," << j;
+        }
+    }
+
+    engine.set_correlation(matrix.data(), N);
+    EXPECT_EQ(engine.factorizations(), 1u);
+    matrix[1] = matrix[N] = 0.5;
+    engine.set_correlation(matrix.data(), N);
+    EXPECT_EQ(engine.factorizations(), 2u);
+}
+
+TEST(MonteCarloVaREngineTest, NonPositiveDefiniteMatrixIsClamped) {
+    // Inconsistent: 1 and 2 move with 3, but against each other
+    std::vector<double> matrix = {1.0, -0.9, 0.9, -0.9, 1.0, 0.9, 0.9, 0.9, 1.0};
+    MonteCarloVaREngine engine(MonteCarloVaREngine::Config{});
+    EXPECT_FALSE(engine.set_correlation(matrix.data(), 3));
+    EXPECT_FALSE(engine.factor_is_exact());
+    auto result = engine.run({{1e6, 1e6, 1e6}, {}, {}, {0.01, 0.01, 0.01}}, 1, 0.05, 5000);
+    EXPECT_TRUE(std::isfinite(result.var));
+    EXPECT_GT(result.var, 0.0);
+
+    // Perfectly correlated legs are singular but consistent: same as one position
+    std::vector<double> twins = {1.0, 1.0, 1.0, 1.0};
+    engine.set_correlation(twins.data(), 2);
+    auto pair = engine.run({{1e6, 1e6}, {}, {}, {0.01, 0.01}}, 1, 0.05, 50000);
+    EXPECT_NEAR(pair.var / (1.6448536269514722 * 2e4), 1.0, 0.03);
+
+    EXPECT_THROW(engine.run({{1e6}, {}, {}, {0.01}}, 1, 0.05, 100), std::invalid_argument);
+}
+
+TEST(MonteCarloVaREngineTest, GammaPathAgreesWithFullRevaluation) {
+    constexpr size_t N = 5;
+    constexpr uint32_t PATHS = 203;
+    constexpr uint64_t SEED = 99;
+    std::vector<double> matrix = equicorrelation(N, 0.4);
+    MonteCarloVaREngine::Exposures exposures{{1e6, -5e5, 2e5, 8e5, -3e5},
+                                             {4e7, -2e7, 0.0, 1e7, 5e7},
+                                             {0.001, 0.0, -0.002, 0.0005, 0.0},
+                                             {0.02, 0.01, 0.03, 0.015, 0.025}};
+    MonteCarloVaREngine engine(MonteCarloVaREngine::Config{2, {}, SEED, 16});
+    engine.set_correlation(matrix.data(), N);
+    auto result = engine.run(exposures, 2, 0.05, PATHS);
+
+    // Scenario by scenario: correlated returns, then delta-gamma P&L
+    std::vector<double> pnl;
+    std::vector<double> normals(NORMALS_PER_BLOCK);
+    for (uint32_t path = 0; path < PATHS; ++path) {
+        generate_normals(SEED, path, NORMALS_PER_BLOCK, normals.data());
+        double total = 0.0;
+        for (size_t i = 0; i < N; ++i) {
+            double y = 0.0;
+            for (size_t k = 0; k <= i; ++k) {
+                y += engine.factor_row(i)[k] * normals[k];
+            }
+            double r = exposures.drift[i] * 2 + exposures.volatility[i] * std::sqrt(2.0) * y;
+            total += exposures.delta[i] * r + 0.5 * exposures.gamma[i] * r * r;
+        }
+        pnl.push_back(total);
+    }
+    std::sort(pnl.begin(), pnl.end());
+    const size_t k = static_cast<size_t>(std::ceil(0.05 * PATHS));
+    EXPECT_NEAR(result.var, -pnl[k - 1], 1e-6);
+    double tail = 0.0;
+    for (size_t i = 0; i < k; ++i) {
+        tail += pnl[i];
+    }
+    EXPECT_NEAR(result.expected_shortfall, -tail / k, 1e-6);
+
+    // Zero gamma through the quadratic kernel equals the projected linear one
+    auto linear = exposures;
+    linear.gamma.clear();
+    auto zero_gamma = exposures;
+    std::fill(zero_gamma.gamma.begin(), zero_gamma.gamma.end(), 0.0);
+    auto a = engine.run(linear, 1, 0.05, 1000);
+    auto b = engine.run(zero_gamma, 1, 0.05, 1000);
+    EXPECT_NEAR(a.var, b.var, 1e-9 * a.var);
+    EXPECT_NEAR(a.mean_pnl, b.mean_pnl, 1e-6);
+}
+
+TEST(PhiloxTest, KnownAnswers) {
+    // Random123 kat_vectors for philox4x32_10
+    struct Case {
+        philox::Block counter;
+        uint32_t key0, key1;
+        philox::Block expected;
+    } cases[] = {
+        {{{0, 0, 0, 0}}, 0, 0, {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}},
+        {{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}}, 0xffffffff, 0xffffffff,
+         {{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}},
+        {{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}}, 0xa4093822, 0x299f31d0,
+         {{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}},
+    };
+    for (const auto& test : cases) {
+        auto output = philox::generate(test.counter, test.key0, test.key1);
+        for (int w = 0; w < 4; ++w) {
+            EXPECT_EQ(output.v[w], test.expected.v[w]);
+        }
+    }
+
+#ifdef __AVX2__
+    // Eight lanes agree with the scalar generator
+    __m256i words[4];
+    words[0] = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 0x7fffffff);
+    words[1] = _mm256_set1_epi32(12345);
+    words[2] = _mm256_set1_epi32(-1);
+    words[3] = _mm256_setr_epi32(9, 8, 7, 6, 5, 4, 3, 2);
+    alignas(32) uint32_t input[4][8];
+    for (int w = 0; w < 4; ++w) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(input[w]), words[w]);
+    }
+    philox::generate_x8(words, 0xdeadbeef, 0x01234567);
+    alignas(32) uint32_t output[4][8];
+    for (int w = 0; w < 4; ++w) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(output[w]), words[w]);
+    }
+    for (int lane = 0; lane < 8; ++lane) {
+        auto expected = philox::generate({{input[0][lane], input[1][lane], input[2][lane], input[3][lane]}},
+                                         0xdeadbeef, 0x01234567);
+        for (int w = 0; w < 4; ++w) {
+            EXPECT_EQ(output[w][lane], expected.v[w]) << lane;
+        }
+    }
+#endif
+}
+
+TEST(VectorMathTest, NormalsMatchScalarBoxMuller) {
+    std::vector<double> normals(4 * NORMALS_PER_BLOCK);
+    generate_normals(0xABCDEF0123ULL, 17, normals.size(), normals.data());
+    for (uint32_t block = 0; block < 4; ++block) {
+        for (uint32_t lane = 0; lane < 8; ++lane) {
+            auto words = philox::generate({{block * 8 + lane, 17, 0, 0}}, 0xCDEF0123, 0xAB);
+            double expected[4];
+            vmath::box_muller(words.v[0], words.v[1], expected[0], expected[1]);
+            vmath::box_muller(words.v[2], words.v[3], expected[2], expected[3]);
+            for (int pair = 0; pair < 4; ++pair) {
+                EXPECT_NEAR(normals[block * NORMALS_PER_BLOCK + pair * 8 + lane], expected[pair], 1e-13);
+            }
+        }
+    }
+
+    // Moments over many paths
+    std::vector<double> sample(NORMALS_PER_BLOCK);
+    double sum = 0.0, sum_squares = 0.0;
+    constexpr uint32_t PATHS = 20000;
+    for (uint32_t path = 0; path < PATHS; ++path) {
+        generate_normals(1, path, sample.size(), sample.data());
+        for (double z : sample) {
+            sum += z;
+            sum_squares += z * z;
+        }
+    }
+    const double count = PATHS * static_cast<double>(NORMALS_PER_BLOCK);
+    EXPECT_NEAR(sum / count, 0.0, 0.005);
+    EXPECT_NEAR(sum_squares / count, 1.0, 0.005);
+}
+
+#ifdef __AVX2__
+TEST(VectorMathTest, LogAndSinCosAccuracy) {
+    alignas(32) double input[4], output[4], sines[4], cosines[4];
+    double worst_log = 0.0, worst_trig = 0.0;
+    for (int i = 0; i < 100000; ++i) {
+        for (int lane = 0; lane < 4; ++lane) {
+            input[lane] = vmath::to_unit(static_cast<uint32_t>(i * 42949u + lane * 1073741824u));
+        }
+        _mm256_store_pd(output, vmath::log(_mm256_load_pd(input)));
+        __m256d s, c;
+        vmath::sincos_2pi(_mm256_load_pd(input), s, c);
+        _mm256_store_pd(sines, s);
+        _mm256_store_pd(cosines, c);
+        for (int lane = 0; lane < 4; ++lane) {
+            double expected = std::log(input[lane]);
+            worst_log = std::max(worst_log, std::abs(output[lane] - expected) / std::max(std::abs(expected), 1e-300));
+            double angle = 2.0 * M_PI * input[lane];
+            worst_trig = std::max(worst_trig, std::abs(sines[lane] - std::sin(angle)));
+            worst_trig = std::max(worst_trig, std::abs(cosines[lane] - std::cos(angle)));
+        }
+    }
+    EXPECT_LT(worst_log, 1e-14);
+    EXPECT_LT(worst_trig, 1e-14);
+}
+#endif
+
+TEST_F(VaRCalculatorTest, ComponentMarginalAndIncrementalVaR) {
+    VaRCalculator calculator;
+    double var = calculator.calculate_parametric_var(positions_, volatilities_, correlations_);
+    auto components = calculator.calculate_component_var(positions_, volatilities_, correlations_);
+    ASSERT_EQ(components.size(), 2u);
+    EXPECT_NEAR(components[1] + components[2], var, 1e-6);
+
+    // Marginal is the derivative of VaR in the exposure
+    const double step = 1.0;
+    for (uint64_t symbol_id : {1, 2}) {
+        auto bumped = positions_;
+        bumped[symbol_id] += step;
+        double difference = calculator.calculate_parametric_var(bumped, volatilities_, correlations_) - var;
+        EXPECT_NEAR(calculator.calculate_marginal_var(symbol_id, positions_, volatilities_, correlations_),
+                    difference / step, 1e-6);
+        EXPECT_NEAR(calculator.calculate_incremental_var(symbol_id, step, positions_, volatilities_, correlations_),
+                    difference, 1e-6);
+    }
+
+    // A symbol not held: its covariance with the book
+    std::unordered_map<uint64_t, double> volatilities = volatilities_;
+    volatilities[3] = 0.03;
+    CorrelationMap correlations = correlations_;
+    correlations[{3, 1}] = -0.4;
+    double sigma = std::sqrt(1.2e9);
+    EXPECT_NEAR(calculator.calculate_marginal_var(3, positions_, volatilities, correlations),
+                1.6448536269514722 * 0.03 * (-0.4 * 0.02 * 1e6) / sigma, 1e-12);
+
+    auto decomposition = calculator.decompose_portfolio_risk(positions_, volatilities_, correlations_);
+    for (uint64_t symbol_id : {1, 2}) {
+        const auto& risk = decomposition[symbol_id];
+        EXPECT_NEAR(risk.individual_var, 1.6448536269514722 * 20000.0, 1e-6);
+        EXPECT_NEAR(risk.total_contribution, components[symbol_id], 1e-6);
+        EXPECT_NEAR(risk.individual_var - risk.diversification_benefit + risk.correlation_penalty,
+                    risk.total_contribution, 1e-6);
+    }
+}
+
+TEST(IncrementalVaRTest, FillByFillMatchesFullRecompute) {
+    constexpr size_t N = 120;
+    std::vector<uint64_t> symbols;
+    std::vector<double> volatilities;
+    std::unordered_map<uint64_t, double> volatility_map;
+    CorrelationMap correlations;
+    std::vector<double> matrix(N * N);
+    for (size_t i = 0; i < N; ++i) {
+        symbols.push_back(5000 + i);
+        volatilities.push_back(0.01 + 0.0002 * i);
+        volatility_map[5000 + i] = volatilities.back();
+        for (size_t j = 0; j < N; ++j) {
+            double rho = i == j ? 1.0 : (i / 10 == j / 10 ? 0.6 : 0.15);
+            matrix[i * N + j] = rho;
+            if (j < i) {
+                correlations[{5000 + i, 5000 + j}] = rho;
+            }
+        }
+    }
+
+    IncrementalVaR incremental;
+    incremental.set_model(symbols, volatilities, matrix);
+    std::unordered_map<uint64_t, double> quantities, prices;
+    uint32_t x = 777;
+    for (int fill = 0; fill < 5000; ++fill) {
+        x = x * 1664525 + 1013904223;
+        uint64_t symbol_id = 5000 + (x >> 8) % N;
+        double quantity = static_cast<double>(static_cast<int>((x >> 16) % 201) - 100);
+        double price = 50.0 + (x >> 24) % 50;
+        if (fill % 7 == 0) {
+            incremental.mark_price(symbol_id, price);
+            if (quantities.count(symbol_id)) {
+                prices[symbol_id] = price;
+            }
+            continue;
+        }
+        // The order's projected VaR is the VaR after its fill (at the mark;
+        // a fill at another price also re-marks the position)
+        if (prices.count(symbol_id)) {
+            price = prices[symbol_id];
+        }
+        auto impact = incremental.order_impact(symbol_id, quantity, price);
+        incremental.on_fill(symbol_id, quantity, price);
+        EXPECT_NEAR(impact.projected, incremental.var(), 1e-6 * impact.projected);
+        quantities[symbol_id] += quantity;
+        prices[symbol_id] = price;
+    }
+
+    std::unordered_map<uint64_t, double> exposures;
+    for (const auto& [symbol_id, quantity] : quantities) {
+        exposures[symbol_id] = quantity * prices[symbol_id];
+        EXPECT_NEAR(incremental.exposure(symbol_id), exposures[symbol_id], 1e-6);
+    }
+    VaRCalculator calculator;
+    double full = calculator.calculate_parametric_var(exposures, volatility_map, correlations);
+    EXPECT_NEAR(incremental.var(), full, 1e-9 * full);
+    EXPECT_NEAR(incremental.var(10), full * std::sqrt(10.0), 1e-8 * full);
+
+    auto components = incremental.component_var();
+    auto expected = calculator.calculate_component_var(exposures, volatility_map, correlations);
+    double sum = 0.0;
+    for (const auto& [symbol_id, component] : components) {
+        EXPECT_NEAR(component, expected[symbol_id], 1e-6 * full);
+        sum += component;
+    }
+    EXPECT_NEAR(sum, full, 1e-9 * full);
+    EXPECT_NEAR(incremental.marginal_var(5003),
+                calculator.calculate_marginal_var(5003, exposures, volatility_map, correlations), 1e-9);
+
+    double drift = incremental.recompute();
+    EXPECT_LT(drift, 1e-10);
+    EXPECT_NEAR(incremental.var(), full, 1e-9 * full);
+    auto stats = incremental.get_stats();
+    EXPECT_EQ(stats.recomputes, 1u);
+    EXPECT_GT(stats.updates, 4000u);
+}
+
+TEST(IncrementalVaRTest, PositionsSurviveAModelChange) {
+    IncrementalVaR incremental;
+    incremental.on_fill(1, 100.0, 10.0); // Before any model: no risk yet
+    EXPECT_EQ(incremental.var(), 0.0);
+    EXPECT_EQ(incremental.order_impact(1, 100.0, 10.0).projected, 0.0);
+
+    incremental.set_model({1, 2}, {0.02, 0.01}, {1.0, 0.0, 0.0, 1.0});
+    EXPECT_NEAR(incremental.var(), 1.6448536269514722 * 0.02 * 1000.0, 1e-9);
+    incremental.set_position(2, -300.0, 10.0);
+    EXPECT_NEAR(incremental.var(), 1.6448536269514722 * std::sqrt(400.0 + 900.0), 1e-9);
+    incremental.set_model({2}, {0.01}, {1.0});
+    EXPECT_NEAR(incremental.var(), 1.6448536269514722 * 30.0, 1e-9);
+    EXPECT_EQ(incremental.index(1), IncrementalVaR::INVALID_INDEX);
+    EXPECT_THROW(incremental.set_model({1, 2}, {0.01}, {1.0}), std::invalid_argument);
+}
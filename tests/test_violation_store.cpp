@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "../src/risk/violation_store.hpp"
+#include "allocation_counter.hpp"
+#include <string>
+#include <vector>
+
+using namespace goldearn::risk;
+
+namespace {
+constexpr int64_t kSecond = 1000000000LL;
+} // namespace
+
+class ViolationStoreTest : public ::testing::Test {
+protected:
+    struct Expected {
+        int64_t timestamp_ns;
+        ViolationSeverity severity;
+        uint64_t symbol_id;
+    };
+
+    // The records a linear scan over everything still retained would return
+    static std::vector<Expected> scan(const std::vector<Expected>& all, size_t retained, int64_t since_ns) {
+        std::vector<Expected> matches;
+        for (size_t i = all.size() - retained; i < all.size(); ++i) {
+            if (all[i].timestamp_ns >= since_ns) {
+                matches.push_back(all[i]);
+            }
+        }
+        return matches;
+    }
+
+    static std::vector<ViolationRecord> query(const ViolationStore& store, int64_t since_ns) {
+        std::vector<ViolationRecord> records;
+        store.for_each_since(since_ns, [&records](const ViolationRecord& record) { records.push_back(record); });
+        return records;
+    }
+};
+
+TEST_F(ViolationStoreTest, WindowQueriesMatchALinearScan) {
+    // 10s buckets, a ring small enough to wrap
+    ViolationStore store(ViolationStore::Config{256, std::chrono::milliseconds(10000), 64, 16});
+    const uint16_t reason = store.intern("Position limit exceeded");
+    std::vector<Expected> all;
+    uint32_t x = 3;
+    int64_t now = 1000 * kSecond;
+    for (int i = 0; i < 1000; ++i) {
+        x = x * 1664525 + 1013904223;
+        now += static_cast<int64_t>((x >> 8) % 3000) * 1000000LL; // 0-3s apart, bursts included
+        auto severity = static_cast<ViolationSeverity>((x >> 4) % 4);
+        store.record(RiskCheckResult::REJECTED_POSITION_LIMIT, severity, reason, ViolationStore::NO_TEXT, i, 1.0, 2.0,
+                     now);
+        all.push_back({now, severity, static_cast<uint64_t>(i)});
+    }
+    ASSERT_EQ(store.size(), 256u);
+    EXPECT_EQ(store.get_stats().overwritten, 744u);
+
+    for (int64_t back : {0LL, 1LL, 5LL, 37LL, 100LL, 299LL, 10000LL}) {
+        const int64_t since = now - back * kSecond;
+        auto expected = scan(all, 256, since);
+        auto records = query(store, since);
+        ASSERT_EQ(records.size(), expected.size()) << back << "s back";
+        for (size_t k = 0; k < records.size(); ++k) {
+            EXPECT_EQ(records[k].timestamp_ns, expected[k].timestamp_ns);
+            EXPECT_EQ(records[k].symbol_id, expected[k].symbol_id);
+            EXPECT_EQ(records[k].violation_severity(), expected[k].severity);
+        }
+    }
+
+    auto count_at_least = [&](ViolationSeverity min, size_t retained) {
+        uint64_t count = 0;
+        for (size_t i = all.size() - retained; i < all.size(); ++i) {
+            count += all[i].severity >= min;
+        }
+        return count;
+    };
+    for (auto min : {ViolationSeverity::INFO, ViolationSeverity::WARNING, ViolationSeverity::EMERGENCY}) {
+        EXPECT_EQ(store.count(min), count_at_least(min, 256));
+    }
+
+    // Expiry drops the oldest and keeps the counts exact
+    const int64_t cutoff = now - 100 * kSecond;
+    store.expire_before(cutoff);
+    const size_t retained = scan(all, 256, cutoff).size();
+    EXPECT_EQ(store.size(), retained);
+    EXPECT_EQ(store.count(ViolationSeverity::WARNING), count_at_least(ViolationSeverity::WARNING, retained));
+    EXPECT_EQ(query(store, 0).size(), retained);
+}
+
+TEST_F(ViolationStoreTest, TimeIndexIsBoundedToo) {
+    // Four one-second buckets: a fifth second pushes out the first one's records
+    ViolationStore store(ViolationStore::Config{1024, std::chrono::milliseconds(1000), 4, 16});
+    for (int64_t second = 0; second < 5; ++second) {
+        for (int i = 0; i < 3; ++i) {
+            store.record(RiskCheckResult::REJECTED_RATE_LIMIT, ViolationSeverity::INFO, ViolationStore::NO_TEXT,
+                         ViolationStore::NO_TEXT, 0, 0.0, 0.0, second * kSecond + i);
+        }
+    }
+    EXPECT_EQ(store.size(), 12u);
+    EXPECT_EQ(query(store, 0).front().timestamp_ns, kSecond);
+    EXPECT_EQ(query(store, 3 * kSecond + 1).size(), 5u);
+
+    // Timestamps going backwards are held at the latest
+    store.record(RiskCheckResult::REJECTED_RATE_LIMIT, ViolationSeverity::INFO, ViolationStore::NO_TEXT,
+                 ViolationStore::NO_TEXT, 0, 0.0, 0.0, 0);
+    EXPECT_EQ(store.last_timestamp_ns(), 4 * kSecond + 2);
+    EXPECT_EQ(query(store, 4 * kSecond + 2).size(), 2u);
+}
+
+TEST_F(ViolationStoreTest, TextsAreInternedOnce) {
+    ViolationStore store(ViolationStore::Config{64, std::chrono::milliseconds(1000), 8, 4});
+    const uint16_t reason = store.intern("Daily loss limit exceeded");
+    EXPECT_EQ(store.intern(std::string("Daily loss") + " limit exceeded"), reason);
+    EXPECT_EQ(store.text(reason), "Daily loss limit exceeded");
+    const uint16_t strategy = store.intern("momentum_1");
+    EXPECT_EQ(store.intern("one too many"), ViolationStore::TEXT_OVERFLOW);
+    EXPECT_EQ(store.get_stats().texts, 4u);
+
+    RiskViolation violation(RiskCheckResult::REJECTED_VAR_LIMIT, ViolationSeverity::CRITICAL,
+                            "Daily loss limit exceeded");
+    violation.strategy_id = "momentum_1";
+    violation.symbol_id = 42;
+    violation.current_value = -2e6;
+    violation.limit_value = -1e6;
+    store.record(violation);
+
+    auto recent = store.since(0);
+    ASSERT_EQ(recent.size(), 1u);
+    EXPECT_EQ(recent[0].violation_type, RiskCheckResult::REJECTED_VAR_LIMIT);
+    EXPECT_EQ(recent[0].severity, ViolationSeverity::CRITICAL);
+    EXPECT_EQ(recent[0].description, violation.description);
+    EXPECT_EQ(recent[0].strategy_id, "momentum_1");
+    EXPECT_EQ(recent[0].symbol_id, 42u);
+    EXPECT_EQ(recent[0].current_value, -2e6);
+    EXPECT_EQ(recent[0].timestamp, violation.timestamp);
+    EXPECT_EQ(query(store, 0)[0].strategy, strategy);
+}
+
+TEST_F(ViolationStoreTest, RecordingDoesNotAllocate) {
+    ViolationStore store(ViolationStore::Config{128, std::chrono::milliseconds(1000), 16, 16});
+    const uint16_t reason = store.intern("Portfolio VaR limit exceeded");
+    RiskViolation violation(RiskCheckResult::REJECTED_VAR_LIMIT, ViolationSeverity::WARNING,
+                            "Portfolio VaR limit exceeded");
+    violation.strategy_id = "pairs";
+    store.record(violation); // Interns the strategy
+
+    AllocationCounter counter;
+    for (int i = 0; i < 1000; ++i) { // Wraps the ring and the bucket index
+        store.record(RiskCheckResult::REJECTED_VAR_LIMIT, ViolationSeverity::WARNING, reason, ViolationStore::NO_TEXT,
+                     i, 1.0, 1.0, i * 100000000LL);
+        store.record(violation);
+    }
+    store.expire_before(90 * kSecond);
+    EXPECT_EQ(counter.count(), 0u);
+}
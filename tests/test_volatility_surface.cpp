@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "../src/market_data/volatility_surface.hpp"
+#include "option_test_utils.hpp"
+
+using namespace goldearn::market_data;
+using namespace option_test;
+
+namespace {
+
+constexpr double kRate = 0.065;
+
+// The skew the quotes below are generated from
+SviSmile market_smile(double tau) {
+    SviSmile svi;
+    svi.a = 0.01 * tau;
+    svi.b = 0.1 * tau;
+    svi.rho = -0.4;
+    svi.m = 0.02;
+    svi.sigma = 0.15;
+    return svi;
+}
+
+} // namespace
+
+TEST(ImpliedVolatilityTest, RecoversVolatilityAcrossTheGrid) {
+    std::vector<double> forward, strike, tau, sign, price, expected;
+    for (double t : {1.0 / 365.0, 7.0 / 365.0, 0.25, 2.0}) {
+        for (double moneyness : {-0.6, -0.2, -0.05, 0.0, 0.03, 0.3, 0.7}) {
+            for (double vol : {0.05, 0.15, 0.4, 1.2}) {
+                // Deep wings at short expiries have no premium left to solve from
+                if (std::abs(moneyness) > 4.0 * vol * std::sqrt(t)) continue;
+                for (bool put : {false, true}) {
+                    const double k = 24000.0 * std::exp(moneyness);
+                    forward.push_back(24000.0);
+                    strike.push_back(k);
+                    tau.push_back(t);
+                    sign.push_back(put ? -1.0 : 1.0);
+                    price.push_back(black(24000.0, k, t, vol, put));
+                    expected.push_back(vol);
+                }
+            }
+        }
+    }
+    const size_t n = forward.size();
+    ASSERT_GT(n, 100u);
+    std::vector<double> vol(n), vega(n);
+    const size_t iterations = implied_volatilities(forward.data(), strike.data(), tau.data(), sign.data(),
+                                                   price.data(), nullptr, vol.data(), vega.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(vol[i], expected[i], 1e-7 * expected[i]) << "strike " << strike[i] << " tau " << tau[i];
+        EXPECT_GT(vega[i], 0.0);
+    }
+
+    // From the previous solution it takes far fewer steps
+    std::vector<double> warm = vol;
+    for (auto& v : warm) v *= 1.001;
+    const size_t warm_iterations = implied_volatilities(forward.data(), strike.data(), tau.data(), sign.data(),
+                                                        price.data(), warm.data(), warm.data(), nullptr, n);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(warm[i], expected[i], 1e-7 * expected[i]);
+    }
+    EXPECT_LT(warm_iterations, iterations);
+}
+
+TEST(ImpliedVolatilityTest, PricesOutsideTheBoundsHaveNoVolatility) {
+    // Below intrinsic, above the forward, zero, and a bad forward; one lane is fine
+    const double forward[] = {100.0, 100.0, 100.0, 0.0, 100.0};
+    const double strike[] = {90.0, 100.0, 100.0, 100.0, 100.0};
+    const double tau[] = {0.5, 0.5, 0.5, 0.5, 0.5};
+    const double sign[] = {1.0, 1.0, -1.0, 1.0, -1.0};
+    const double price[] = {9.5, 100.5, 0.0, 5.0, black(100.0, 100.0, 0.5, 0.2, true)};
+    double vol[5];
+    double vega[5];
+    implied_volatilities(forward, strike, tau, sign, price, nullptr, vol, vega, 5);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(vol[i], 0.0) << i;
+        EXPECT_EQ(vega[i], 0.0) << i;
+    }
+    EXPECT_NEAR(vol[4], 0.2, 1e-9);
+}
+
+class VolatilitySurfaceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // NIFTY index options (with a dividend yield) on two expiries and
+        // options on the future on one; 21 strikes x call and put
+        uint64_t id = 100;
+        for (uint64_t underlying : {kNifty, kNiftyFuture}) {
+            for (int64_t days : {7, 35}) {
+                if (underlying == kNiftyFuture && days == 7) continue;
+                for (double strike = 21000; strike <= 27000; strike += 300) {
+                    for (bool put : {false, true}) {
+                        OptionContract option;
+                        option.contract_id = id++;
+                        option.underlying_id = underlying;
+                        option.expiry_ns = kNow + days * kDay;
+                        option.strike = strike;
+                        option.put = put;
+                        option.on_future = underlying == kNiftyFuture;
+                        config.options.push_back(option);
+                    }
+                }
+            }
+        }
+        config.dividend_yields[kNifty] = 0.012;
+        config.rate = kRate;
+    }
+
+    double forward(const OptionContract& option, double spot) const {
+        const double tau = static_cast<double>(option.expiry_ns - kNow) / kDay / 365.0;
+        return option.on_future ? spot : spot * std::exp((kRate - 0.012) * tau);
+    }
+
+    // Quotes every option off the market smile, half a point wide
+    void quote_all(VolatilitySurfaceService& service, uint64_t underlying, double spot) {
+        for (const auto& option : config.options) {
+            if (option.underlying_id != underlying) continue;
+            const double tau = static_cast<double>(option.expiry_ns - kNow) / kDay / 365.0;
+            const double f = forward(option, spot);
+            const double vol = std::sqrt(market_smile(tau).total_variance(std::log(option.strike / f)) / tau);
+            const double premium = black(f, option.strike, tau, vol, option.put) * std::exp(-kRate * tau);
+            if (premium < 0.3) continue; // Not quoted
+            QuoteMessage quote{};
+            quote.symbol_id = option.contract_id;
+            quote.bid_price = premium - 0.25;
+            quote.ask_price = premium + 0.25;
+            if (quote.bid_price <= 0.0) continue;
+            service.on_quote(quote);
+        }
+    }
+
+    VolatilitySurfaceService::Config config;
+};
+
+TEST_F(VolatilitySurfaceTest, FitsTheSmileFromQuotes) {
+    VolatilitySurfaceService service(config);
+    EXPECT_EQ(service.num_options(), 126u);
+    EXPECT_EQ(service.num_expiries(), 3u);
+
+    // Quotes without an underlying price wait for it
+    quote_all(service, kNifty, 24000.0);
+    EXPECT_EQ(service.refresh(kNow), 0u);
+    service.on_price(kNifty, 24000.0);
+    EXPECT_EQ(service.refresh(kNow), 2u);
+
+    goldearn::core::RcuReadGuard guard;
+    const VolatilitySurface* surface = service.surface();
+    EXPECT_EQ(surface->version, 1u);
+    for (int64_t days : {7, 35}) {
+        const Smile* smile = surface->smile(kNifty, kNow + days * kDay);
+        ASSERT_NE(smile, nullptr);
+        ASSERT_TRUE(smile->valid);
+        EXPECT_GE(smile->points, 8u);
+        EXPECT_LT(smile->rms_error, 0.25); // Vol points, against half-point wide quotes
+        const double tau = days / 365.0;
+        for (double strike : {22500.0, 24000.0, 25500.0}) {
+            const double k = std::log(strike / smile->forward);
+            const double expected = std::sqrt(market_smile(tau).total_variance(k) / tau);
+            EXPECT_NEAR(smile->volatility(strike), expected, 0.005) << days << " " << strike;
+        }
+    }
+    EXPECT_FALSE(surface->smile(kNiftyFuture, kNow + 35 * kDay)->valid);
+
+    // Each option's own solve
+    const auto& atm = config.options[20]; // 7 days, 24000 call
+    ASSERT_EQ(atm.strike, 24000.0);
+    const double tau = 7.0 / 365.0;
+    const double atm_vol = std::sqrt(market_smile(tau).total_variance(std::log(24000.0 / forward(atm, 24000.0))) / tau);
+    EXPECT_NEAR(service.implied_volatility(atm.contract_id), atm_vol, 1e-9);
+    EXPECT_EQ(service.implied_volatility(999999), 0.0);
+    EXPECT_GT(service.get_stats().solves, 40u);
+}
+
+TEST_F(VolatilitySurfaceTest, OnlyTouchedExpiriesAreRefit) {
+    VolatilitySurfaceService service(config);
+    QuoteMessage future{};
+    future.symbol_id = kNiftyFuture;
+    future.bid_price = 24149.0;
+    future.ask_price = 24151.0;
+    service.on_quote(future);
+    service.on_price(kNifty, 24000.0);
+    quote_all(service, kNifty, 24000.0);
+    quote_all(service, kNiftyFuture, 24150.0);
+    EXPECT_EQ(service.refresh(kNow), 3u);
+    EXPECT_EQ(service.refresh(kNow), 0u); // Nothing new
+
+    // One option quote: its expiry only
+    QuoteMessage quote{};
+    quote.symbol_id = config.options[0].contract_id;
+    quote.bid_price = 3030.0;
+    quote.ask_price = 3031.0;
+    service.on_quote(quote);
+    EXPECT_EQ(service.refresh(kNow + 1000), 1u);
+    // A one-sided quote is ignored
+    quote.ask_price = 0.0;
+    service.on_quote(quote);
+    EXPECT_EQ(service.refresh(kNow + 2000), 0u);
+
+    // An underlying move: all of its expiries, warm-started
+    const auto refits = service.get_stats().refits;
+    service.on_price(kNifty, 24050.0);
+    EXPECT_EQ(service.refresh(kNow + 3000), 2u);
+    EXPECT_EQ(service.get_stats().refits, refits + 2);
+
+    goldearn::core::RcuReadGuard guard;
+    EXPECT_EQ(service.surface()->version, 3u);
+    EXPECT_TRUE(service.surface()->smile(kNiftyFuture, kNow + 35 * kDay)->valid);
+}
+
+TEST_F(VolatilitySurfaceTest, InterpolatesBetweenExpiries) {
+    VolatilitySurfaceService service(config);
+    service.on_price(kNifty, 24000.0);
+    quote_all(service, kNifty, 24000.0);
+    service.refresh(kNow);
+
+    const int64_t near = kNow + 7 * kDay;
+    const int64_t far = kNow + 35 * kDay;
+    const double v_near = service.volatility(kNifty, near, 24000.0);
+    const double v_far = service.volatility(kNifty, far, 24000.0);
+    const double v_mid = service.volatility(kNifty, kNow + 21 * kDay, 24000.0);
+    EXPECT_GT(v_near, 0.0);
+    EXPECT_GT(v_far, 0.0);
+    // Total variance is linear in time between them
+    const double w_mid = v_mid * v_mid * 21.0;
+    const double w_near = v_near * v_near * 7.0;
+    const double w_far = v_far * v_far * 35.0;
+    EXPECT_GT(w_mid, std::min(w_near, w_far));
+    EXPECT_LT(w_mid, std::max(w_near, w_far));
+    // Flat beyond the fitted expiries; nothing for an unknown underlying
+    EXPECT_EQ(service.volatility(kNifty, kNow + 2 * kDay, 24000.0), v_near);
+    EXPECT_EQ(service.volatility(kNifty, kNow + 90 * kDay, 24000.0), v_far);
+    EXPECT_EQ(service.volatility(kNiftyFuture, far, 24000.0), 0.0);
+
+    // Once expired a smile is dropped
+    service.on_price(kNifty, 24010.0);
+    service.refresh(near + 1);
+    EXPECT_EQ(service.volatility(kNifty, kNow + 2 * kDay, 24000.0), service.volatility(kNifty, far, 24000.0));
+
+    VolatilitySurfaceService::Config duplicate = config;
+    duplicate.options.push_back(config.options[0]);
+    EXPECT_THROW(VolatilitySurfaceService{duplicate}, std::invalid_argument);
+}
@@ -23,7 +23,7 @@ done
 
 echo ""
 echo "🧪 Checking test executables:"
-tests=("test_config" "test_core" "test_market_data" "test_trading" "test_risk" "test_auth" "test_monitoring" "test_security" "test_integration" "test_performance")
+tests=("test_config" "test_core" "test_allocations" "test_market_data" "test_trading" "test_risk" "test_auth" "test_monitoring" "test_security" "test_integration" "test_performance")
 for test in "${tests[@]}"; do
     if [ -f "build/tests/$test" ]; then
         echo "  ✅ $test - Found"